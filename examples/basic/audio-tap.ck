@@ -0,0 +1,82 @@
+//-----------------------------------------------------------------------------
+// name: audio-tap.ck
+// desc: visualizing audio with AudioTap, which streams samples (or an FFT
+//       spectrum) straight into a texture every frame, no chuck-side copying
+//
+// author: Andrew Zhu Aday (https://ccrma.stanford.edu/~azaday/)
+//   date: Fall 2024
+//-----------------------------------------------------------------------------
+
+// audio: mic input through a tap
+adc => AudioTap tap => blackhole;
+1024 => tap.window;
+
+// tap target texture: single channel float, one row, no mips
+TextureDesc tap_texture_desc;
+tap.window() => tap_texture_desc.width;
+1 => tap_texture_desc.height;
+Texture.FORMAT_R32FLOAT => tap_texture_desc.format;
+false => tap_texture_desc.mips;
+Texture tap_texture(tap_texture_desc);
+tap.texture(tap_texture);
+
+// shader that draws the tap texture as a line
+"
+#include FRAME_UNIFORMS
+#include DRAW_UNIFORMS
+#include STANDARD_VERTEX_INPUT
+#include STANDARD_VERTEX_OUTPUT
+#include STANDARD_VERTEX_SHADER
+
+@group(1) @binding(0) var u_tap : texture_2d<f32>;
+@group(1) @binding(1) var<uniform> u_size : i32;
+@group(1) @binding(2) var<uniform> u_scale : f32;
+
+@fragment
+fn fs_main(in : VertexOutput) -> @location(0) vec4f
+{
+    let i = clamp(i32(in.v_uv.x * f32(u_size)), 0, u_size - 1);
+    let value = textureLoad(u_tap, vec2i(i, 0), 0).r * u_scale;
+    let y = in.v_uv.y * 2.0 - 1.0;
+    let d = abs(y - value);
+    let c = 1.0 - smoothstep(0.0, 0.02, d);
+    return vec4f(vec3f(c), 1.0);
+}
+" @=> string tap_shader_code;
+
+ShaderDesc shader_desc;
+tap_shader_code => shader_desc.vertexCode;
+tap_shader_code => shader_desc.fragmentCode;
+Shader tap_shader(shader_desc);
+
+Material tap_material;
+tap_shader => tap_material.shader;
+tap_material.texture(0, tap_texture);
+tap_material.uniformInt(1, tap.size());
+tap_material.uniformFloat(2, 1.0);
+
+PlaneGeometry plane_geo(4, 2, 1, 1);
+GMesh plane(plane_geo, tap_material) --> GG.scene();
+
+// UI
+UI_Int mode;
+UI_Float scale(1.0);
+["Waveform", "Spectrum"] @=> string mode_names[];
+
+while (true)
+{
+    GG.nextFrame() => now;
+
+    if (UI.begin("AudioTap"))
+    {
+        if (UI.listBox("Mode", mode, mode_names))
+        {
+            mode.val() => tap.mode;
+            tap_material.uniformInt(1, tap.size());
+        }
+        if (UI.slider("Scale", scale, 0.1, 10.0))
+            tap_material.uniformFloat(2, scale.val());
+        UI.text("RMS: " + tap.rms());
+    }
+    UI.end();
+}
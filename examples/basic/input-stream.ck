@@ -0,0 +1,50 @@
+//-----------------------------------------------------------------------------
+// name: input-stream.ck
+// desc: audio-precise input. Every key press and mouse click plays a note
+//       as soon as ChuGL receives it, through GG.input(), instead of waiting
+//       for the next GG.nextFrame(). Fast double clicks and key rolls play
+//       every note, and each one is timed to when it actually happened.
+// requires: ChuGL + chuck-1.5.3.0 or higher
+//-----------------------------------------------------------------------------
+
+// poll input while ChucK runs the frame, for the lowest latency
+GG.pipelined(true);
+UI.disabled(true);
+// a constant delay from input to sound, so notes don't jitter with polling
+10::ms => GG.inputLatency;
+
+ModalBar bar => NRev rev => dac;
+.05 => rev.mix;
+
+GCircle circle --> GG.scene();
+circle.sca(0);
+
+fun void play(dur offset, float pitch)
+{
+    offset => now;
+    Std.mtof(pitch) => bar.freq;
+    1 => bar.noteOn;
+}
+
+fun void listen()
+{
+    InputMsg msg;
+    while (true) {
+        GG.input() => now;
+        while (GG.input().recv(msg)) {
+            if (msg.type == InputMsg.KEY_DOWN) {
+                spork ~ play(msg.offset, 48 + msg.code % 36);
+            } else if (msg.type == InputMsg.MOUSE_DOWN) {
+                spork ~ play(msg.offset, 60 + 12 * msg.code);
+            } else continue;
+            circle.sca(1);
+            circle.color(Color.random());
+        }
+    }
+}
+spork ~ listen();
+
+while (true) {
+    GG.nextFrame() => now;
+    circle.sca(circle.sca() * (1 - 4 * GG.dt()));
+}
@@ -0,0 +1,47 @@
+//-----------------------------------------------------------------------------
+// name: lod.ck
+// desc: level of detail. A field of dense spheres, each drawn with a
+//       simplified copy of its geometry as it gets further from the camera.
+//       Far away spheres are culled entirely.
+//       Toggle wireframe to see the levels switch.
+// requires: ChuGL + chuck-1.5.3.0 or higher
+//-----------------------------------------------------------------------------
+
+GOrbitCamera camera --> GG.scene();
+GG.scene().camera(camera);
+@(0, 2, 12) => camera.pos;
+
+// full detail, then generated levels with fewer and fewer triangles
+SphereGeometry geo(1.0, 64, 32, 0, Math.two_pi, 0, Math.pi);
+geo.simplify(.25, .01) @=> Geometry lod1;
+geo.simplify(.05, .05) @=> Geometry lod2;
+geo.simplify(.01, .2) @=> Geometry lod3;
+
+// drawn with lod1 once a sphere covers less than 20% of the screen height, etc.
+geo.lod(lod1, .2);
+geo.lod(lod2, .08);
+geo.lod(lod3, .03);
+geo.lodCull(.005);
+
+PhongMaterial material;
+for (int x; x < 40; x++) {
+    for (int z; z < 40; z++) {
+        GMesh sphere(geo, material) --> GG.scene();
+        @(2.5 * (x - 20), 0, -2.5 * z) => sphere.pos;
+    }
+}
+
+UI_Bool wireframe;
+while (true) {
+    GG.nextFrame() => now;
+    if (UI.begin("LOD")) {
+        UI.text("triangles per level:");
+        UI.text("  0: " + geo.indices().size() / 3);
+        for (int i; i < geo.lodCount(); i++) {
+            UI.text("  " + (i + 1) + ": " + geo.lod(i).indices().size() / 3
+                    + " below screen size " + geo.lodScreenSize(i));
+        }
+        if (UI.checkbox("wireframe", wireframe)) material.wireframe(wireframe.val());
+    }
+    UI.end();
+}
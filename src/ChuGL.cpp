@@ -47,6 +47,7 @@
 #include "ulib_light.cpp"
 
 #include "ulib_video.cpp"
+#include "ulib_audiotap.cpp"
 
 #ifndef CHUGL_FAST_COMPILE
 #include "ulib_assloader.cpp"
@@ -73,6 +74,9 @@ t_CKBOOL chugl_main_loop_hook(void* bindle)
     App::init(&chugl_app, g_chuglVM, g_chuglAPI);
     App::start(&chugl_app); // blocking
 
+    // no more frames, don't hold chuck at the frame boundary (GG.offline())
+    Sync_ReleaseSwapWait();
+
     { // cleanup (after exiting main loop)
         // remove all shreds (should trigger shutdown, unless running in --loop
         // mode)
@@ -168,10 +172,10 @@ static void autoUpdateScenegraph(Arena* arena, SG_Scene* scene, Chuck_VM* VM,
         xform = SG_GetTransform(sg_id);
 
         // add children to stack
-        if (xform) {
-            size_t numChildren  = SG_Transform::numChildren(xform);
-            SG_ID* children_ptr = ARENA_PUSH_COUNT(arena, SG_ID, numChildren);
-            memcpy(children_ptr, xform->childrenIDs.base, sizeof(SG_ID) * numChildren);
+        SG_ID child_id = xform ? xform->first_child_id : 0;
+        while (child_id) {
+            *ARENA_PUSH_TYPE(arena, SG_ID) = child_id;
+            child_id                       = SG_GetTransform(child_id)->next_sibling_id;
         }
     }
 }
@@ -302,6 +306,21 @@ static void FlushGraphicsToAudioCQ()
                     memset(gp, 0, sizeof(*gp));
                 }
             } break;
+            case SG_COMMAND_G2A_TEXTURE_LOADED: {
+                SG_Command_G2A_TextureLoaded* cmd
+                  = (SG_Command_G2A_TextureLoaded*)command;
+                SG_Texture* texture = SG_GetTexture(cmd->texture_id);
+
+                // if texture was already GC'd, skip
+                if (!texture) break;
+
+                // on failure the texture keeps whatever was uploaded, the graphics
+                // thread has already logged why
+                texture->loading       = false;
+                texture->desc.format   = cmd->format;
+                texture->desc.gen_mips = cmd->gen_mips;
+                if (texture->load_event) Event_Broadcast(texture->load_event);
+            } break;
             default: ASSERT(false)
         }
     }
@@ -345,6 +364,11 @@ static void chugl_GraphicsShredPerformNextFrameUpdate(Chuck_VM_Shred* SHRED)
     if (allShredsWaiting && first_of_last_shreds_waited) {
         // if #waiting == #registered, all chugl shreds have finished work, and
         // we are safe to wakeup the renderer
+        CHUGL_Offline offline = CHUGL_Offline_Get();
+
+        // GG.profile(): an audio frame runs from one frame boundary to the next
+        Profiler_EndFrame(ProfileThread_Audio);
+        u64 profile_begin = Profiler_Enabled() ? Profiler_Now() : 0;
         // TODO: bug. If a shred does NOT call GG.nextFrame in an infinite loop,
         // i.e. does nextFrame() once and then goes on to say process audio,
         // this code will stay be expecting that shred to call nextFrame() again
@@ -366,9 +390,18 @@ static void chugl_GraphicsShredPerformNextFrameUpdate(Chuck_VM_Shred* SHRED)
             system_dt_sec       = stm_sec(system_dt_ticks);
 
             // update render thread dt
-            g_last_dt = CHUGL_Window_dt();
+            g_last_dt = offline.fps > 0 ? 1.0 / offline.fps : CHUGL_Window_dt();
             g_frame_count++;
 
+            // offline frames are only in step with chuck time if time passes
+            static bool warned_no_time = false;
+            if (offline.fps > 0 && chuckTimeDiff == 0 && g_frame_count > 1
+                && !warned_no_time) {
+                warned_no_time = true;
+                log_warn("GG.offline(): no time passed since the last frame");
+                log_warn(" |- (hint: advance time by GG.dt()::second every frame)");
+            }
+
 #ifdef CHUGL_DEBUG
             spinlock::lock(&waitingShredsLock);
             ASSERT(g_frame_count - 1 == waiting_shreds_frame_count);
@@ -376,6 +409,9 @@ static void chugl_GraphicsShredPerformNextFrameUpdate(Chuck_VM_Shred* SHRED)
 #endif
         }
 
+        // GG.input(): keeps the input clock fresh even while no input arrives
+        if (CHUGL_Input_Listening()) ulib_window_input_update(API, VM);
+
         // traverse rendegraph chuck-defined update() on all render passes
         if (gg_config.auto_update_scenegraph) {
             SG_Pass* pass = SG_GetPass(gg_config.root_pass_id);
@@ -408,6 +444,14 @@ static void chugl_GraphicsShredPerformNextFrameUpdate(Chuck_VM_Shred* SHRED)
 
         // clear audio frame arena
         Arena::clear(&audio_frame_arena);
+
+        if (profile_begin) {
+            Profiler_Record(ProfileZone_AudioUpdate, profile_begin, Profiler_Now());
+        }
+
+        // offline, hold chuck here until the renderer takes this frame, so a slow
+        // frame slows chuck down instead of being skipped
+        if (offline.fps > 0) Sync_WaitOnSwapDone();
     }
 }
 
@@ -523,6 +567,213 @@ CK_DLL_SFUN(chugl_set_fps)
     CQ_PushCommand_SetFixedTimestep(gg_config.fixed_timestep_fps);
 }
 
+CK_DLL_SFUN(chugl_get_fallback_material)
+{
+    SG_Material* material = SG_GetMaterial(gg_config.fallback_material_id);
+    RETURN->v_object      = material ? material->ckobj : NULL;
+}
+
+CK_DLL_SFUN(chugl_set_fallback_material)
+{
+    Chuck_Object* ckobj = GET_NEXT_OBJECT(ARGS);
+    SG_Material* material
+      = ckobj ? SG_GetMaterial(OBJ_MEMBER_UINT(ckobj, component_offset_id)) : NULL;
+
+    SG_ID prev_material_id = gg_config.fallback_material_id;
+    SG_AddRef(material);
+    gg_config.fallback_material_id = material ? material->id : 0;
+    SG_DecrementRef(prev_material_id);
+
+    CQ_PushCommand_SetFallbackMaterial(material);
+}
+
+CK_DLL_SFUN(chugl_set_gc_budget)
+{
+    f64 budget_ms = MAX(0.0, GET_NEXT_FLOAT(ARGS));
+    SG_GCBudget(budget_ms);
+    CQ_PushCommand_SetDestroyBudget(budget_ms);
+}
+
+CK_DLL_SFUN(chugl_get_gc_budget)
+{
+    RETURN->v_float = SG_GCBudget();
+}
+
+CK_DLL_SFUN(chugl_set_texture_upload_budget)
+{
+    t_CKINT budget_bytes            = GET_NEXT_INT(ARGS);
+    gg_config.texture_upload_budget = MAX(budget_bytes, 0);
+    CQ_PushCommand_SetTextureUploadBudget(gg_config.texture_upload_budget);
+}
+
+CK_DLL_SFUN(chugl_get_texture_upload_budget)
+{
+    RETURN->v_int = gg_config.texture_upload_budget;
+}
+
+CK_DLL_SFUN(chugl_get_gc_queue_depth)
+{
+    RETURN->v_int = SG_GCQueueDepth() + CHUGL_RenderDestroyQueueDepth();
+}
+
+CK_DLL_SFUN(chugl_set_pipelined)
+{
+    gg_config.pipelined = GET_NEXT_INT(ARGS) ? true : false;
+    CQ_PushCommand_SetPipelined(gg_config.pipelined);
+}
+
+CK_DLL_SFUN(chugl_get_pipelined)
+{
+    RETURN->v_int = gg_config.pipelined ? 1 : 0;
+}
+
+static void chugl_set_offline_impl(f64 fps, t_CKINT width, t_CKINT height)
+{
+    if (g_chugl_window_initialized) {
+        log_warn("GG.offline() must be called before the first GG.nextFrame()");
+        return;
+    }
+    if (width <= 0 || height <= 0) {
+        log_warn("GG.offline(): invalid size %dx%d", (int)width, (int)height);
+        return;
+    }
+    CHUGL_Offline_Set(MAX(fps, 0.0), (int)width, (int)height);
+}
+
+CK_DLL_SFUN(chugl_set_offline)
+{
+    t_CKFLOAT fps = GET_NEXT_FLOAT(ARGS);
+    t_CKVEC2 size = CHUGL_Window_WindowSize();
+    chugl_set_offline_impl(fps, (t_CKINT)size.x, (t_CKINT)size.y);
+}
+
+CK_DLL_SFUN(chugl_set_offline_size)
+{
+    t_CKFLOAT fps  = GET_NEXT_FLOAT(ARGS);
+    t_CKINT width  = GET_NEXT_INT(ARGS);
+    t_CKINT height = GET_NEXT_INT(ARGS);
+    chugl_set_offline_impl(fps, width, height);
+}
+
+CK_DLL_SFUN(chugl_get_offline)
+{
+    RETURN->v_float = CHUGL_Offline_Get().fps;
+}
+
+CK_DLL_SFUN(chugl_capture)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    if (ck_str == NULL) return;
+    if (g_chugl_window_initialized) {
+        log_warn("GG.capture() must be called before the first GG.nextFrame()");
+        return;
+    }
+    CHUGL_CommandStream_Set(API->object->str(ck_str), NULL);
+}
+
+CK_DLL_SFUN(chugl_replay)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    if (ck_str == NULL) return;
+    if (g_chugl_window_initialized) {
+        log_warn("GG.replay() must be called before the first GG.nextFrame()");
+        return;
+    }
+    CHUGL_CommandStream_Set(NULL, API->object->str(ck_str));
+}
+
+CK_DLL_SFUN(chugl_record)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    if (ck_str == NULL) return;
+    CQ_PushCommand_RecordStart(API->object->str(ck_str), 0);
+}
+
+CK_DLL_SFUN(chugl_record_texture)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    Chuck_Object* ckobj  = GET_NEXT_OBJECT(ARGS);
+    if (ck_str == NULL || ckobj == NULL) return;
+    CQ_PushCommand_RecordStart(API->object->str(ck_str), GET_TEXTURE(ckobj)->id);
+}
+
+CK_DLL_SFUN(chugl_record_stop)
+{
+    CQ_PushCommand_RecordStop();
+}
+
+CK_DLL_SFUN(chugl_get_recording)
+{
+    FrameCaptureStats stats;
+    RETURN->v_int = CHUGL_RenderRecordStats(&stats) ? 1 : 0;
+}
+
+CK_DLL_SFUN(chugl_get_record_written)
+{
+    FrameCaptureStats stats;
+    CHUGL_RenderRecordStats(&stats);
+    RETURN->v_int = stats.written;
+}
+
+CK_DLL_SFUN(chugl_get_record_dropped)
+{
+    FrameCaptureStats stats;
+    CHUGL_RenderRecordStats(&stats);
+    RETURN->v_int = stats.dropped;
+}
+
+CK_DLL_SFUN(chugl_set_profile)
+{
+    Profiler_Enable(GET_NEXT_INT(ARGS) != 0);
+}
+
+CK_DLL_SFUN(chugl_get_profile)
+{
+    RETURN->v_int = Profiler_Enabled() ? 1 : 0;
+}
+
+CK_DLL_SFUN(chugl_get_stats)
+{
+    static char report[8192];
+    ProfileStats stats;
+    Profiler_Stats(&stats);
+    Profiler_FormatStats(&stats, report, sizeof(report));
+    RETURN->v_string = chugin_createCkString(report, false);
+}
+
+CK_DLL_SFUN(chugl_get_stats_ms)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    ProfileStats stats;
+    Profiler_Stats(&stats);
+    RETURN->v_float = ck_str ? Profiler_AvgMs(&stats, API->object->str(ck_str)) : -1;
+}
+
+CK_DLL_SFUN(chugl_get_stats_count)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    ProfileStats stats;
+    Profiler_Stats(&stats);
+    RETURN->v_int = ck_str ? Profiler_Count(&stats, API->object->str(ck_str)) : -1;
+}
+
+CK_DLL_SFUN(chugl_trace)
+{
+    Chuck_String* ck_str = GET_NEXT_STRING(ARGS);
+    if (ck_str == NULL) return;
+    CQ_PushCommand_TraceStart(API->object->str(ck_str));
+}
+
+CK_DLL_SFUN(chugl_trace_stop)
+{
+    CQ_PushCommand_TraceStop();
+}
+
+CK_DLL_SFUN(chugl_get_geometry_bytes)
+{
+    RETURN->v_int = SG_GeometryBlock::liveBytes();
+}
+
 CK_DLL_SFUN(chugl_get_fps)
 {
     RETURN->v_float = CHUGL_Window_fps();
@@ -917,6 +1168,9 @@ CK_DLL_QUERY(ChuGL)
 #ifdef CHUGL_RELEASE
     log_set_level(LOG_WARN); // only log errors and fatal in release mode
 #endif
+    // audio and render threads hand log records to a background writer
+    // instead of blocking on stderr
+    log_set_async(true);
 
     // remember
     g_chuglVM  = QUERY->ck_vm(QUERY);
@@ -1037,6 +1291,7 @@ CK_DLL_QUERY(ChuGL)
     ulib_text_query(QUERY);
 
     ulib_video_query(QUERY);
+    ulib_audiotap_query(QUERY);
 
 #ifndef CHUGL_FAST_COMPILE
     ulib_assloader_query(QUERY);
@@ -1114,6 +1369,224 @@ CK_DLL_QUERY(ChuGL)
         SFUN(chugl_get_fps, "float", "fps");
         DOC_FUNC("FPS of current window, updated every second");
 
+        SFUN(chugl_set_fallback_material, "void", "fallbackMaterial");
+        ARG("Material", "material");
+        DOC_FUNC(
+          "Set a material to draw meshes with while their own material's render "
+          "pipelines are being compiled in the background. By default (null) those "
+          "meshes are not drawn until their pipelines are ready. Choose a material "
+          "with a simple shader, e.g. FlatMaterial, and Material.prewarm() it");
+
+        SFUN(chugl_get_fallback_material, "Material", "fallbackMaterial");
+        DOC_FUNC("Get the fallback material, see GG.fallbackMaterial(Material)");
+
+        SFUN(chugl_set_gc_budget, "void", "gcBudget");
+        ARG("float", "ms");
+        DOC_FUNC(
+          "Set the time in milliseconds the audio and graphics threads each spend "
+          "per frame destroying objects that are no longer referenced. Freeing a "
+          "large scene is spread across several frames instead of stalling one. At "
+          "least one object is destroyed per frame. 0 means unlimited. Default 1ms on "
+          "the audio thread, 2ms on the graphics thread");
+
+        SFUN(chugl_get_gc_budget, "float", "gcBudget");
+        DOC_FUNC("Get the per-frame destruction budget in milliseconds, see "
+                 "GG.gcBudget(float)");
+
+        SFUN(chugl_get_gc_queue_depth, "int", "gcQueueDepth");
+        DOC_FUNC("Number of unreferenced objects waiting to be destroyed, across the "
+                 "audio and graphics threads");
+
+        SFUN(chugl_set_texture_upload_budget, "void", "textureUploadBudget");
+        ARG("int", "bytes");
+        DOC_FUNC(
+          "Set how many bytes of decoded image data the graphics thread uploads per "
+          "frame to textures loaded with Texture.load(...). Loading large images is "
+          "spread across several frames instead of stalling one. At least one row of "
+          "pixels is uploaded per frame. 0 means unlimited. Default 16MB");
+
+        SFUN(chugl_get_texture_upload_budget, "int", "textureUploadBudget");
+        DOC_FUNC("Get the per-frame texture upload budget in bytes, see "
+                 "GG.textureUploadBudget(int)");
+
+        SFUN(chugl_set_pipelined, "void", "pipelined");
+        ARG("int", "pipelined");
+        DOC_FUNC(
+          "Poll window input in parallel with ChucK instead of at the frame boundary. "
+          "The graphics thread already draws frame N while your shreds build frame "
+          "N+1; only the boundary between them is serial. In pipelined mode that "
+          "boundary is just the command queue swap and the physics step, and "
+          "GG.nextFrame() is released right after it. GWindow mouse and keyboard state "
+          "is read from a snapshot taken at the frame boundary, so input reaches ChucK "
+          "one frame later than usual and never changes in the middle of a frame. "
+          "GG.dt() is unchanged. Has no effect while the UI is enabled (see "
+          "UI.disabled()) or while waiting for input. Default false");
+
+        SFUN(chugl_get_pipelined, "int", "pipelined");
+        DOC_FUNC("True if pipelined mode is on, see GG.pipelined(int)");
+
+        SFUN(gg_input, "InputStreamEvent", "input");
+        DOC_FUNC(
+          "Event broadcast as soon as keyboard, mouse or gamepad input arrives, "
+          "independent of GG.nextFrame(). Wake on it and read every event, each "
+          "with its own timestamp, with GG.input().recv(msg) into an InputMsg. "
+          "Input is polled once per frame; in pipelined mode (GG.pipelined()) "
+          "with the UI disabled it is also polled every millisecond while the "
+          "graphics thread waits on ChucK, for the lowest latency. Nothing is "
+          "recorded until the first call");
+        ADD_EX("basic/input-stream.ck");
+
+        SFUN(gg_set_input_latency, "void", "inputLatency");
+        ARG("dur", "latency");
+        DOC_FUNC(
+          "Constant delay added to the `when` of every InputMsg. Input events are "
+          "timed to the sample ChucK had computed when they happened, so waiting on "
+          "`msg.offset` before making sound gives the same input-to-sound time for "
+          "every event, as long as the latency covers the polling interval and "
+          "one audio buffer. Larger is steadier, 0 is fastest. Default 0::samp");
+
+        SFUN(gg_get_input_latency, "dur", "inputLatency");
+        DOC_FUNC("Get the input latency, see GG.inputLatency(dur)");
+
+        SFUN(gg_input_dropped, "int", "inputDropped");
+        DOC_FUNC(
+          "Input events dropped because ChucK did not read them fast enough. "
+          "Events are queued until a shred calls recv()");
+
+        SFUN(chugl_set_offline, "void", "offline");
+        ARG("float", "fps");
+        DOC_FUNC(
+          "Render offline instead of to a window: every frame is drawn to an "
+          "offscreen texture the size of the window, as fast as the machine allows "
+          "and never skipped, and GG.dt() is exactly 1/fps. Meant for rendering a "
+          "piece to video with GG.record(), e.g. under chuck --silent. Each "
+          "GG.nextFrame() holds ChucK until the graphics thread has caught up, "
+          "without letting ChucK time pass, so advance time by one frame yourself to "
+          "keep frames in step with now: `while (true) { GG.nextFrame() => now; "
+          "GG.dt()::second => now; }`. Works without a display or GPU (with a "
+          "software WebGPU adapter); there is no window input or UI. Must be called "
+          "before the first GG.nextFrame(). 0 renders to the window (default)");
+
+        SFUN(chugl_set_offline_size, "void", "offline");
+        ARG("float", "fps");
+        ARG("int", "width");
+        ARG("int", "height");
+        DOC_FUNC("Render offline at the given resolution in pixels, see "
+                 "GG.offline(float)");
+
+        SFUN(chugl_get_offline, "float", "offline");
+        DOC_FUNC("Frame rate of offline rendering, 0 when rendering to a window. See "
+                 "GG.offline(float)");
+
+        SFUN(chugl_capture, "void", "capture");
+        ARG("string", "path");
+        DOC_FUNC(
+          "Write everything this program does to graphics, frame by frame, to a "
+          "binary file until it exits. The file can be played back without the "
+          "program with GG.replay(), e.g. to benchmark the renderer on a real piece "
+          "or check it renders the same after a change. Files, e.g. textures and "
+          "videos, are loaded by path again on replay. Must be called before the "
+          "first GG.nextFrame()");
+
+        SFUN(chugl_replay, "void", "replay");
+        ARG("string", "path");
+        DOC_FUNC(
+          "Play back a file written by GG.capture() instead of running graphics "
+          "shreds: every captured frame is rendered offline (see GG.offline()) at "
+          "the captured size, as fast as possible, then ChucK exits and the frame "
+          "rate is printed, broken down by GG.profile() if it's on. Webcams, audio "
+          "taps and Texture.save() are left out, and physics is not simulated again "
+          "(meshes move as captured). Only plays captures from the same version of "
+          "ChuGL. Call it before the first GG.nextFrame(), e.g. "
+          "`GG.replay(\"piece.cglc\"); GG.nextFrame() => now;`");
+
+        SFUN(chugl_record, "void", "record");
+        ARG("string", "path");
+        DOC_FUNC(
+          "Record every frame of the window, without the UI, until GG.recordStop(). "
+          "The path picks the output: \"frames/%05d.png\" or \"frame.qoi\" write an "
+          "image sequence (the frame number replaces %05d, or goes before the "
+          "extension), \"loop.gif\" writes an animated GIF, and a path starting with "
+          "'|' pipes raw RGBA frames to a command, e.g. \"|ffmpeg -f rawvideo "
+          "-pix_fmt rgba -s 1920x1080 -r 60 -i - out.mp4\". Frames are read back and "
+          "encoded on worker threads; if they fall behind, frames are dropped instead "
+          "of slowing down rendering, see GG.recordDropped(), unless rendering "
+          "offline (see GG.offline()). QOI and raw frames "
+          "keep up with 1080p60, PNG compresses better but is slower. Recording "
+          "keeps the window size it started with. Not supported on the web");
+
+        SFUN(chugl_record_texture, "void", "record");
+        ARG("string", "path");
+        ARG("Texture", "texture");
+        DOC_FUNC("Record every frame of a texture, e.g. a render pass target, instead "
+                 "of the window. The texture needs Texture.Usage_CopySrc and an 8 bit "
+                 "RGBA or BGRA format. See GG.record(string)");
+
+        SFUN(chugl_record_stop, "void", "recordStop");
+        DOC_FUNC("Stop recording. Frames still being encoded are written first");
+
+        SFUN(chugl_get_recording, "int", "recording");
+        DOC_FUNC("True while recording, from the frame after GG.record() until "
+                 "GG.recordStop() or a failure to open the output");
+
+        SFUN(chugl_get_record_written, "int", "recordWritten");
+        DOC_FUNC("Number of frames written by the current or last recording");
+
+        SFUN(chugl_get_record_dropped, "int", "recordDropped");
+        DOC_FUNC("Number of frames the current or last recording skipped because "
+                 "the encoders fell behind");
+
+        SFUN(chugl_set_profile, "void", "profile");
+        ARG("int", "on");
+        DOC_FUNC(
+          "Time where each frame goes: command pushes and GG.nextFrame() on the audio "
+          "thread; waiting on audio, command queue drain, ImGui, physics, video "
+          "decode, scene and matrix updates, draw building, rendergraph execution "
+          "and present on the graphics thread; and, if the GPU supports timestamp "
+          "queries, every render and compute pass on the GPU. See GG.stats(). "
+          "Costs next to nothing while off. Turning it on resets the stats. Default "
+          "false");
+
+        SFUN(chugl_get_profile, "int", "profile");
+        DOC_FUNC("True if the profiler is on, see GG.profile(int)");
+
+        SFUN(chugl_get_stats, "string", "stats");
+        DOC_FUNC(
+          "Profiler report: last, moving average and max milliseconds (and calls) "
+          "per frame of each stage, per thread, and of each GPU pass. GPU times "
+          "arrive a few frames late. Then render counts, e.g. shadow casters "
+          "culled, for the last frame and in total. See GG.profile(int)");
+
+        SFUN(chugl_get_stats_ms, "float", "statsMs");
+        ARG("string", "name");
+        DOC_FUNC(
+          "Moving average milliseconds per frame of a profiler stage as named in "
+          "GG.stats(), e.g. \"scene_update\", \"render_frame\", \"gpu\", or a GPU "
+          "pass. -1 if there is no such stage");
+
+        SFUN(chugl_get_stats_count, "int", "statsCount");
+        ARG("string", "name");
+        DOC_FUNC(
+          "Last frame value of a profiler count as named in GG.stats(), e.g. "
+          "\"shadow_casters_culled\". Add \"_total\" to the name for the total "
+          "since startup. -1 if there is no such count");
+
+        SFUN(chugl_trace, "void", "trace");
+        ARG("string", "path");
+        DOC_FUNC(
+          "Record every profiler stage from the next frame until GG.traceStop() and "
+          "write them to path as a Chrome trace, to open in chrome://tracing or "
+          "https://ui.perfetto.dev. Turns the profiler on. Keeps the first million "
+          "events. A trace not stopped is written when the window closes");
+
+        SFUN(chugl_trace_stop, "void", "traceStop");
+        DOC_FUNC("Stop tracing and write the trace, see GG.trace(string)");
+
+        SFUN(chugl_get_geometry_bytes, "int", "geometryBytes");
+        DOC_FUNC(
+          "Bytes of host memory held by geometry vertex and index data, including "
+          "data on its way to the GPU. See Geometry.markStatic()");
+
         SFUN(chugl_set_fps, "void", "fps");
         ARG("int", "fps");
         DOC_FUNC(
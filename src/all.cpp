@@ -33,6 +33,19 @@
 #include "chugl_defines.h"
 #include "graphics.cpp"
 #include "geometry.cpp"
+#include "command_stream.cpp"
+#include "destroy_queue.cpp"
+#include "draw_jobs.cpp"
+#include "frame_capture.cpp"
+#include "input_stream.cpp"
+#include "instance_cull.cpp"
+#include "light_cluster.cpp"
+#include "mesh_lod.cpp"
+#include "profiler.cpp"
+#include "render_graph.cpp"
+#include "shader_reflect.cpp"
+#include "texture_stream.cpp"
+#include "texture_transcode.cpp"
 #include "sync.cpp"
 #include "sg_component.cpp" // chugl scenegraph API
 #include "sg_command.cpp"
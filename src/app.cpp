@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <thread>
+
 #include <box2d/box2d.h>
 // necessary for copying from command
 static_assert(sizeof(u32) == sizeof(b2WorldId), "b2WorldId != u32");
@@ -55,7 +57,9 @@ static_assert(sizeof(u32) == sizeof(b2WorldId), "b2WorldId != u32");
 #endif
 
 // #include "camera.cpp"
+#include "command_stream.h"
 #include "graphics.h"
+#include "profiler.h"
 #include "r_component.h"
 #include "sg_command.h"
 #include "sg_component.h"
@@ -173,33 +177,6 @@ static WGPUTextureView ImGui_ImplWGPU_GetTextureId(ImTextureID id, void* user)
     return cache->textureView(desc);
 }
 
-struct TickStats {
-    u64 fc    = 0;
-    u64 min   = UINT64_MAX;
-    u64 max   = 0;
-    u64 total = 0;
-
-    void update(u64 ticks)
-    {
-        min = ticks < min ? ticks : min;
-        max = ticks > max ? ticks : max;
-        total += ticks;
-        if (++fc % 60 == 0) {
-            print("");
-            // fc    = 0;
-            // total = 0;
-        }
-    }
-
-    void print(const char* name)
-    {
-        printf("%s: min: %f, max: %f, avg: %f\n", name, stm_ms(min), stm_ms(max),
-               stm_ms(total / fc));
-    }
-};
-
-TickStats critical_section_stats = {};
-
 static int mini(int x, int y)
 {
     return x < y ? x : y;
@@ -252,6 +229,26 @@ static void _R_HandleCommand(App* app, SG_Command* command);
 static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* camera,
                            G_DrawCallListID dc_list);
 
+static void _R_PrewarmMaterials(App* app, G_DrawCallListID dc_list);
+
+static void _R_RecordCopy(App* app);
+static void _R_RecordMap();
+static G_GraphTimestamps* _R_GpuTimerBegin(App* app);
+static void _R_GpuTimerResolve(App* app);
+static void _R_GpuTimerMap();
+static void _R_GpuTimerRelease();
+static void _R_ProfileCounters(App* app);
+static void _R_RecordStop(App* app);
+static void _R_CaptureBegin(const char* path, int width, int height);
+static void _R_CaptureFrame(App* app);
+static void _R_CaptureEnd();
+static bool _R_Replaying();
+static bool _R_ReplayBegin(const char* path, int* width, int* height);
+static bool _R_ReplayNextFrame(f64* time);
+static void _R_ReplayLoadFrame();
+static bool _R_ReplaySkips(SG_CommandType type);
+static void _R_ReplayEnd();
+
 static void _R_glfwErrorCallback(int error, const char* description)
 {
     log_trace("GLFW Error[%i]: %s\n", error, description);
@@ -308,8 +305,37 @@ struct App {
     SG_ID root_pass_id;
     G_Graph rendergraph;
 
+    // records scene pass draws in parallel. Chunk 0 records into rendergraph, so
+    // draw_recorders[0] is unused. see draw_jobs.h
+    JobPool draw_jobs;
+    G_DrawRecorder draw_recorders[CHUGL_DRAW_JOBS_MAX_THREADS];
+
+    // drawn in place of materials whose pipelines are still compiling
+    SG_ID fallback_material_id;
+
+    // GScene.gpuCulling() kernel, created on first use. see instance_cull.h
+    WGPUShaderModule instance_cull_module;
+    // materials whose pipelines are compiled against the next frame's scene passes
+    Arena prewarm_material_list; // SG_ID
+
+    // per-frame time spent destroying components freed in chuck
+    f64 destroy_budget_ms = CHUGL_DESTROY_BUDGET_MS;
+
+    // per-frame bytes of decoded images uploaded to streamed textures
+    u64 texture_upload_budget = CHUGL_TEXTURE_UPLOAD_BUDGET_BYTES;
+
+    // poll input outside the critical section, see GG.pipelined()
+    bool pipelined;
+
+    // GG.offline(): no window, every frame is rendered offscreen and advances
+    // time by exactly 1 / offline_fps. 0 renders to the window in realtime
+    f64 offline_fps;
+    bool offline_closed; // the last graphics shred exited
+
     // gamepad state
     b8 gamepads_connected[GLFW_JOYSTICK_LAST + 1];
+    // last polled, to find button presses and releases for GG.input()
+    u8 gamepad_buttons[GLFW_JOYSTICK_LAST + 1][GLFW_GAMEPAD_BUTTON_LAST + 1];
 
     // ============================================================================
     // App API
@@ -328,6 +354,14 @@ struct App {
         // init rendergraph
         app->rendergraph.init();
 
+#ifdef __EMSCRIPTEN__
+        int draw_workers = 0;
+#else
+        int draw_workers = (int)std::thread::hardware_concurrency() - 1;
+#endif
+        JobPool_Init(&app->draw_jobs,
+                     CLAMP(draw_workers, 0, CHUGL_DRAW_JOBS_MAX_THREADS - 1));
+
         // b2 sim defaults
         ASSERT(app->b2_sim_desc.substeps == 4);
     }
@@ -345,7 +379,20 @@ struct App {
         // seed random number generator ===========================
         srand((unsigned int)time(0));
 
-        { // Initialize window
+        CHUGL_Offline offline = CHUGL_Offline_Get();
+        app->offline_fps      = offline.fps;
+
+        // GG.replay() renders offline at the size of the capture
+        std::string capture_path, replay_path;
+        CHUGL_CommandStream_Get(&capture_path, &replay_path);
+        if (!replay_path.empty()
+            && _R_ReplayBegin(replay_path.c_str(), &offline.width, &offline.height)) {
+            log_info("Replaying \"%s\" at %dx%d", replay_path.c_str(), offline.width,
+                     offline.height);
+            if (app->offline_fps == 0) app->offline_fps = 60; // only paces GG.record()
+        }
+
+        if (app->offline_fps == 0) { // Initialize window
             glfwSetErrorCallback(_R_glfwErrorCallback);
             if (!glfwInit()) {
                 log_fatal("Failed to initialize GLFW\n");
@@ -377,7 +424,7 @@ struct App {
             }
         }
 
-        // init graphics context
+        // init graphics context, offscreen without a window
         if (!GraphicsContext::init(&app->gctx, app->window)) {
             log_fatal("Failed to initialize graphics context\n");
             return;
@@ -412,7 +459,8 @@ struct App {
             io.ConfigFlags
               |= ImGuiConfigFlags_NavEnableGamepad;           // Enable Gamepad Controls
             io.ConfigFlags |= ImGuiConfigFlags_DockingEnable; // Enable Docking
-            io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable; // Enable Multi-Viewport
+            if (app->window)
+                io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable; // Multi-Viewport
 
             // load builtin fonts
             io.Fonts->AddFontDefault();
@@ -431,7 +479,7 @@ struct App {
             // ImGui::StyleColorsLight();
         }
 
-        { // set window callbacks
+        if (app->window) { // set window callbacks
             glfwSetWindowUserPointer(app->window, app);
             glfwSetMouseButtonCallback(app->window, _mouseButtonCallback);
             glfwSetScrollCallback(app->window, _scrollCallback);
@@ -453,7 +501,7 @@ struct App {
 
         // Setup ImGui Platform/Renderer backends
         {
-            ImGui_ImplGlfw_InitForOther(app->window, true);
+            if (app->window) ImGui_ImplGlfw_InitForOther(app->window, true);
 #ifdef __EMSCRIPTEN__
             ImGui_ImplGlfw_InstallEmscriptenCanvasResizeCallback("#canvas");
 #endif
@@ -466,14 +514,21 @@ struct App {
         }
 
         // trigger window resize callback to set up imgui
-        int width, height;
-        glfwGetFramebufferSize(app->window, &width, &height);
-        _onFramebufferResize(app->window, width, height);
+        int width = offline.width, height = offline.height;
+        if (app->window) glfwGetFramebufferSize(app->window, &width, &height);
+        _onFramebufferResize(app, width, height);
+
+        if (!capture_path.empty()) _R_CaptureBegin(capture_path.c_str(), width, height);
 
         // initialize imgui frame (should be threadsafe as long as graphics
         // shreds start with GG.nextFrame() => now)
         ImGui_ImplWGPU_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
+        if (app->window) {
+            ImGui_ImplGlfw_NewFrame();
+        } else {
+            // never drawn offline, but UI calls from chuck still need a frame
+            ImGui::GetIO().DisplaySize = ImVec2((f32)width, (f32)height);
+        }
         ImGui::NewFrame();
 
         // main loop
@@ -500,13 +555,26 @@ struct App {
         nanotime_step_init(&app->stepper,
                            (u64)(NANOTIME_NSEC_PER_SEC / app->stepper_fps),
                            nanotime_now_max(), nanotime_now, nanotime_sleep);
-        while (!glfwWindowShouldClose(app->window)) {
+        if (app->offline_fps > 0 && !_R_Replaying()) {
+            log_info("Rendering offline at %.2f fps, %dx%d", app->offline_fps, width,
+                     height);
+        }
+        while (app->window ? !glfwWindowShouldClose(app->window) :
+                             !app->offline_closed) {
+            // replayed frames are as far apart as when they were captured
+            f64 replay_time = 0;
+            if (_R_Replaying() && !_R_ReplayNextFrame(&replay_time)) break;
+
             // frame metrics ----------------------------
             {
                 _calculateFPS(app->window, app->show_fps_title);
 
                 ++app->fc;
-                f64 currentTime = glfwGetTime();
+                // offline frames are 1 / fps apart no matter how long they take
+                f64 currentTime = app->offline_fps > 0 ?
+                                    (app->fc - 1) / app->offline_fps :
+                                    glfwGetTime();
+                if (_R_Replaying()) currentTime = replay_time;
 
                 // first frame prevent huge dt
                 if (app->lastTime == 0) app->lastTime = currentTime;
@@ -520,11 +588,12 @@ struct App {
             Arena::clear(&app->frameArena);
 
             // fixed timestep (this might be helpful for finishing box2d
-            // integration later)
-            if (app->stepper_fps > 0) {
+            // integration later). Offline renders as fast as it can
+            if (app->stepper_fps > 0 && app->offline_fps == 0) {
                 nanotime_step(&app->stepper);
             }
         }
+        _R_ReplayEnd();
 #endif
 
         log_trace("Exiting main loop");
@@ -532,6 +601,19 @@ struct App {
 
     static void end(App* app)
     {
+        // before the shader modules and device go away
+        G_PipelineCompiler_Shutdown();
+        JobPool_Free(&app->draw_jobs);
+        WGPU_RELEASE_RESOURCE(ShaderModule, app->instance_cull_module);
+
+        // writes out the frames still being encoded
+        _R_RecordStop(app);
+        _R_CaptureEnd();
+
+        // a GG.trace() never stopped is written on exit
+        Profiler_TraceEnd();
+        _R_GpuTimerRelease();
+
         // free R_Components
         Component_Free();
 
@@ -544,32 +626,159 @@ struct App {
         // ImGui_ImplWGPU_Shutdown(); ImGui_ImplGlfw_Shutdown();
         // ImGui::DestroyContext();
 
-        // destroy window
-        glfwDestroyWindow(app->window);
+        if (app->window) {
+            // destroy window
+            glfwDestroyWindow(app->window);
 
-        // terminate GLFW
-        glfwTerminate();
+            // terminate GLFW
+            glfwTerminate();
+        }
 
         // free memory
         Arena::free(&app->frameArena);
+        Arena::free(&app->prewarm_material_list);
+        for (int i = 0; i < ARRAY_LENGTH(app->draw_recorders); i++) {
+            G_DrawRecorder* rec = app->draw_recorders + i;
+            Arena::free(&rec->drawcall_pool);
+            for (int g = 0; g < CHUGL_MAX_BINDGROUPS; g++)
+                Arena::free(rec->bind_group_entry_list + g);
+        }
     }
 
     // ============================================================================
     // App Internal Functions
     // ============================================================================
 
+    // GG.input() events for the gamepad buttons that changed since the last poll
+    static void _gamepadInputEvents(App* app, int gamepad_idx,
+                                    const GLFWgamepadstate* gp_state)
+    {
+        u8* buttons = app->gamepad_buttons[gamepad_idx];
+        for (int b = 0; b <= GLFW_GAMEPAD_BUTTON_LAST; b++) {
+            if (gp_state->buttons[b] == buttons[b]) continue;
+            buttons[b] = gp_state->buttons[b];
+            CHUGL_Input_Push(buttons[b] == GLFW_PRESS ? InputEvent_GamepadDown :
+                                                        InputEvent_GamepadUp,
+                             b, 0, gamepad_idx, 0, 0);
+        }
+    }
+
+    // process glfw input events and gamepads. Feeds the mouse/keyboard state in
+    // sync.cpp, ImGui, G2A gamepad commands and GG.input()
+    static void _pollInput(App* app)
+    {
+        if (!app->window) return; // offline, no input
+
+        // process glfw input event queue
+        if (app->should_wait_for_input) {
+            if (app->wait_for_input_timeout > 0)
+                glfwWaitEventsTimeout(app->wait_for_input_timeout);
+            else
+                glfwWaitEvents();
+        } else {
+            glfwPollEvents();
+        }
+
+        { // gamepad
+            for (int gamepad_idx = 0; gamepad_idx <= GLFW_JOYSTICK_LAST;
+                 gamepad_idx++) {
+                GLFWgamepadstate gp_state = {};
+                bool was_connected        = app->gamepads_connected[gamepad_idx];
+                if (glfwGetGamepadState(gamepad_idx, &gp_state)) {
+
+                    // connected!
+                    if (!was_connected) {
+                        const char* name = glfwGetGamepadName(gamepad_idx);
+                        ASSERT(name);
+                        CQ_PushCommand_G2A_GamepadConnect(gamepad_idx, true, name);
+                        app->gamepads_connected[gamepad_idx] = 1;
+                    }
+
+                    CQ_PushCommand_G2A_GamepadState(gamepad_idx, &gp_state);
+                    _gamepadInputEvents(app, gamepad_idx, &gp_state);
+
+                    { // debug print
+                      // printf("Gamepad detected: %s\n",
+                      //        glfwGetGamepadName(gamepad_idx));
+                      // printf("Buttons state\n");
+                      // int num_buttons = ARRAY_LENGTH(gp_state.buttons);
+                      // for (int button_idx = 0; button_idx < num_buttons;
+                      //      ++button_idx) {
+                      //     printf("%d: %d\n", button_idx,
+                      //            gp_state.buttons[button_idx]);
+                      // }
+                      // printf("Axes state\n");
+                      // int num_axes = ARRAY_LENGTH(gp_state.axes);
+                      // for (int axes_idx = 0; axes_idx < num_axes; ++axes_idx) {
+                      //     printf("%d: %f\n", axes_idx,
+                      //     gp_state.axes[axes_idx]);
+                      // }
+                    }
+                } else {
+                    // disconnected
+                    if (was_connected) {
+                        CQ_PushCommand_G2A_GamepadConnect(gamepad_idx, false, NULL);
+                        app->gamepads_connected[gamepad_idx] = 0;
+                        memset(app->gamepad_buttons[gamepad_idx], 0,
+                               sizeof(app->gamepad_buttons[gamepad_idx]));
+                    }
+                }
+            }
+        }
+
+        CHUGL_Input_Broadcast();
+    }
+
+    // GG.input() while the render thread waits on chuck: input events (but not the
+    // per-frame gamepad state) reach listening shreds within
+    // CHUGL_INPUT_POLL_INTERVAL_MS instead of at the next frame
+    static void _pollInputEvents(App* app)
+    {
+        glfwPollEvents();
+        for (int gamepad_idx = 0; gamepad_idx <= GLFW_JOYSTICK_LAST; gamepad_idx++) {
+            GLFWgamepadstate gp_state = {};
+            if (app->gamepads_connected[gamepad_idx]
+                && glfwGetGamepadState(gamepad_idx, &gp_state))
+                _gamepadInputEvents(app, gamepad_idx, &gp_state);
+        }
+        CHUGL_Input_Broadcast();
+    }
+
     static void _mainLoop(App* app)
     {
         // Render Loop ===========================================
         static u64 prev_lap_time{ stm_now() };
 
+        // GG.profile(): a render frame runs from here to here, so frames that
+        // return early (e.g. minimized) are still counted
+        Profiler_EndFrame(ProfileThread_Render);
+
+        // GG.replay(): commands come from the capture, chuck is left waiting
+        bool replaying = _R_Replaying();
+
         // ======================
         // enter critical section
         // ======================
         // waiting for audio synchronization (see cgl_update_event_waiting_on)
         // (i.e., when all registered GG.nextFrame() are called on their
         // respective shreds)
-        Sync_WaitOnUpdateDone();
+        {
+            PROFILE_ZONE(ProfileZone_WaitAudio);
+            // GG.input() in pipelined mode: keep polling while chuck runs the
+            // frame, as input polled outside the critical section already is
+            bool poll_while_waiting = app->window && app->pipelined
+                                      && app->imgui_disabled
+                                      && !app->should_wait_for_input
+                                      && CHUGL_Input_Listening();
+            if (replaying) {
+                // nothing to wait for
+            } else if (poll_while_waiting) {
+                while (!Sync_WaitOnUpdateDoneFor(CHUGL_INPUT_POLL_INTERVAL_MS))
+                    _pollInputEvents(app);
+            } else {
+                Sync_WaitOnUpdateDone();
+            }
+        }
 
         // question: why does putting this AFTER time calculation cause
         // everything to be so choppy at high FPS? hypothesis: puts time
@@ -580,6 +789,8 @@ struct App {
         // calculate dt
         u64 dt_ticks = stm_laptime(&prev_lap_time);
         f64 dt_sec   = stm_sec(dt_ticks);
+        if (app->offline_fps > 0) dt_sec = 1.0 / app->offline_fps; // fixed offline
+        if (replaying) dt_sec = app->dt;
         CHUGL_Window_dt(dt_sec);
 
         /* two locks here:
@@ -593,14 +804,23 @@ struct App {
             - exposes a gameloop to chuck, gauranteed to be executed once per
         frame deadlock shouldn't happen because both locks are never held at the
         same time */
-        bool do_ui = !app->imgui_disabled;
+        bool do_ui = !app->imgui_disabled && app->window;
+
+        // GG.pipelined(): wake chuck right after the swap and poll input while it
+        // runs the next frame. Not while the UI is on (glfw events feed ImGui, which
+        // chuck calls into) or when waiting for input (which should hold chuck back)
+        bool pipelined = app->pipelined && !do_ui && !app->should_wait_for_input;
 
         {
-            CQ_SwapQueues(); // ~ .0001ms
+            if (replaying) {
+                _R_ReplayLoadFrame();
+            } else {
+                CQ_SwapQueues(); // ~ .0001ms
+            }
 
-            // u64 critical_start = stm_now();
             // Rendering
             if (do_ui) {
+                PROFILE_ZONE(ProfileZone_ImGui);
                 ImGui::Render();
 
                 // copy imgui draw data for rendering later
@@ -608,64 +828,13 @@ struct App {
             }
 
             // imgui and window callbacks
-            CHUGL_Zero_MouseDeltasAndClickState();
-            CHUGL_Kb_ZeroPressedReleased();
-
-            // process glfw input event queue
-            if (app->should_wait_for_input) {
-                if (app->wait_for_input_timeout > 0)
-                    glfwWaitEventsTimeout(app->wait_for_input_timeout);
-                else
-                    glfwWaitEvents();
-            } else {
-                glfwPollEvents();
-            }
-
-            { // gamepad
-                for (int gamepad_idx = 0; gamepad_idx <= GLFW_JOYSTICK_LAST;
-                     gamepad_idx++) {
-                    GLFWgamepadstate gp_state = {};
-                    bool was_connected        = app->gamepads_connected[gamepad_idx];
-                    if (glfwGetGamepadState(gamepad_idx, &gp_state)) {
-
-                        // connected!
-                        if (!was_connected) {
-                            const char* name = glfwGetGamepadName(gamepad_idx);
-                            ASSERT(name);
-                            CQ_PushCommand_G2A_GamepadConnect(gamepad_idx, true, name);
-                            app->gamepads_connected[gamepad_idx] = 1;
-                        }
-
-                        CQ_PushCommand_G2A_GamepadState(gamepad_idx, &gp_state);
-
-                        { // debug print
-                          // printf("Gamepad detected: %s\n",
-                          //        glfwGetGamepadName(gamepad_idx));
-                          // printf("Buttons state\n");
-                          // int num_buttons = ARRAY_LENGTH(gp_state.buttons);
-                          // for (int button_idx = 0; button_idx < num_buttons;
-                          //      ++button_idx) {
-                          //     printf("%d: %d\n", button_idx,
-                          //            gp_state.buttons[button_idx]);
-                          // }
-                          // printf("Axes state\n");
-                          // int num_axes = ARRAY_LENGTH(gp_state.axes);
-                          // for (int axes_idx = 0; axes_idx < num_axes; ++axes_idx) {
-                          //     printf("%d: %f\n", axes_idx,
-                          //     gp_state.axes[axes_idx]);
-                          // }
-                        }
-                    } else {
-                        // disconnected
-                        if (was_connected) {
-                            CQ_PushCommand_G2A_GamepadConnect(gamepad_idx, false, NULL);
-                            app->gamepads_connected[gamepad_idx] = 0;
-                        }
-                    }
-                }
-            }
+            CHUGL_Input_BeginFrame(pipelined);
+            if (!pipelined) _pollInput(app);
+            // dt and input for the frame chuck is about to run
+            CHUGL_FrameState_Publish();
 
             if (do_ui) {
+                PROFILE_ZONE(ProfileZone_ImGui);
                 // reset imgui
                 ImGui_ImplWGPU_NewFrame();
                 ImGui_ImplGlfw_NewFrame();
@@ -675,8 +844,6 @@ struct App {
                 ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(),
                                              ImGuiDockNodeFlags_PassthruCentralNode);
             }
-            // ~2.15ms (15%) In DEBUG mode!
-            // critical_section_stats.update(stm_since(critical_start));
 
             // physics
             // we intentionally are NOT having a fixed timestep for the sake of
@@ -685,6 +852,7 @@ struct App {
             // https://gafferongames.com/post/fix_your_timestep/
             b2WorldId b2_world_id = *(b2WorldId*)&app->b2_sim_desc.world_id;
             if (b2World_IsValid(b2_world_id)) {
+                PROFILE_ZONE(ProfileZone_Physics);
                 b2World_Step(b2_world_id, app->b2_sim_desc.rate * app->dt,
                              app->b2_sim_desc.substeps);
                 // log_trace("simulating b2 substeps: %d rate: %f",
@@ -700,13 +868,22 @@ struct App {
         // pushing commands this wakes all shreds currently waiting on
         // GG.nextFrame()
 
-        // grabs waitingShredsLock
-        Event_Broadcast(CHUGL_EventType::NEXT_FRAME, app->ckapi, app->ckvm);
+        if (!replaying) {
+            // grabs waitingShredsLock
+            Event_Broadcast(CHUGL_EventType::NEXT_FRAME, app->ckapi, app->ckvm);
+
+            // offline, chuck is held at the frame boundary until now. Only after
+            // the broadcast, so its shreds wake without chuck time moving on
+            Sync_SignalSwapDone();
+        }
 
         // ====================
         // end critical section
         // ====================
 
+        // input polled now is snapshotted for chuck at the next frame boundary
+        if (pipelined) _pollInput(app);
+
         // handle window resize (special case b/c needs to happen before
         // GraphicsContext::prepareFrame, unlike the rest of glfwPollEvents())
         // Doing window resize AFTER surface is already prepared causes crash.
@@ -714,7 +891,7 @@ struct App {
         // dearImGUI hooks into glfwPollEvents, and modifies imgui state, so
         // glfwPollEvents() must happen in the critial region, after
         // GraphicsContext::prepareFrame
-        {
+        if (app->window) {
             resized_this_frame = false;
             int width, height;
             glfwGetFramebufferSize(app->window, &width, &height);
@@ -723,7 +900,7 @@ struct App {
                 frame_buffer_height = height;
                 resized_this_frame  = true;
 
-                _onFramebufferResize(app->window, width, height);
+                _onFramebufferResize(app, width, height);
             }
         }
 
@@ -732,6 +909,8 @@ struct App {
         // from CK code essentially applying a diff to bring graphics state up
         // to date with what is done in CK code
         { // flush command queue
+            PROFILE_ZONE(ProfileZone_QueueDrain);
+            _R_CaptureFrame(app);
             SG_Command* cmd = NULL;
             while (CQ_ReadCommandQueueIter(&cmd)) _R_HandleCommand(app, cmd);
             CQ_ReadCommandQueueClear();
@@ -739,14 +918,20 @@ struct App {
 
         // garbage collection! delete GPU-side data for any scenegraph objects
         // that were deleted in chuck
-        // renderer.ProcessDeletionQueue(
-        //   &scene); // IMPORTANT: should happen after flushing command queue
+        // IMPORTANT: should happen after flushing command queue
+        CHUGL_RenderDestroyQueueDepth(
+          Component_ProcessDestroyQueue(app->destroy_budget_ms));
+
+        // images decoded since last frame, a budgeted number of rows at a time
+        // IMPORTANT: after flushing the command queue, which submits the loads
+        Component_UploadStreamedTextures(&app->gctx, app->texture_upload_budget);
 
         // now renderer can work on drawing the copied scenegraph
         // renderer.RenderScene(&scene, scene.GetMainCamera());
 
         // if window minimized, don't render
-        bool minimized = glfwGetWindowAttrib(app->window, GLFW_ICONIFIED);
+        bool minimized
+          = app->window && glfwGetWindowAttrib(app->window, GLFW_ICONIFIED);
         if (minimized || !GraphicsContext::prepareFrame(&app->gctx)) {
             return;
         }
@@ -759,8 +944,17 @@ struct App {
             }
         }
 
+        { // upload latest audio tap windows
+            size_t tap_idx  = 0;
+            R_AudioTap* tap = NULL;
+            while (Component_AudioTapIter(&tap_idx, &tap)) {
+                R_AudioTap::upload(&app->gctx, tap);
+            }
+        }
+
         { // decode all current video textures
             // ==optimize== threadpool for decoding
+            PROFILE_ZONE(ProfileZone_VideoDecode);
             size_t video_idx = 0;
             R_Video* video   = NULL;
             while (Component_VideoIter(&video_idx, &video)) {
@@ -848,9 +1042,26 @@ struct App {
                              "ScenePass[%d:%s] for Scene[%d:%s]", pass->id,
                              pass->sg_pass.name, scene->id, scene->name);
                     app->rendergraph.addRenderPass(string_buff);
+
+                    u32 color_height = wgpuTextureGetHeight(color_target);
+                    u32 color_width  = wgpuTextureGetWidth(color_target);
+                    u32 sample_count = pass->sg_pass.scene_pass_msaa ? 4 : 1;
+
+                    // msaa samples are resolved and never read again, unless the
+                    // next frame loads them
+                    bool transient_msaa
+                      = pass->sg_pass.scene_pass_msaa && !pass->msaa_color_target;
                     if (pass->sg_pass.scene_pass_msaa) {
-                        app->rendergraph.renderPassColorTarget(pass->msaa_color_target,
-                                                               0);
+                        if (transient_msaa) {
+                            app->rendergraph.renderPassColorTargetTransient(
+                              app->rendergraph.transientTexture(
+                                wgpuTextureGetFormat(color_target), color_width,
+                                color_height, sample_count,
+                                WGPUTextureUsage_RenderAttachment));
+                        } else {
+                            app->rendergraph.renderPassColorTarget(
+                              pass->msaa_color_target, 0);
+                        }
                         if (r_tex) {
                             app->rendergraph.renderPassResolveTarget(color_target, 0);
                         } else {
@@ -876,14 +1087,14 @@ struct App {
                       clear_color,
                       pass->sg_pass.color_target_clear_on_load ? WGPULoadOp_Clear :
                                                                  WGPULoadOp_Load,
-                      WGPUStoreOp_Store);
+                      transient_msaa ? WGPUStoreOp_Discard : WGPUStoreOp_Store);
 
-                    // TODO store depth texture somewhere else...
-                    app->rendergraph.renderPassDepthTarget(pass->depth_texture);
+                    app->rendergraph.renderPassDepthTargetTransient(
+                      app->rendergraph.transientTexture(
+                        WGPUTextureFormat_Depth32Float, color_width, color_height,
+                        sample_count, WGPUTextureUsage_RenderAttachment));
 
                     // viewport and scissor
-                    u32 color_height = wgpuTextureGetHeight(color_target);
-                    u32 color_width  = wgpuTextureGetWidth(color_target);
                     if (pass->sg_pass.viewport_normalized) {
                         aspect = app->rendergraph.viewport(
                           pass->sg_pass.viewport_x * color_width,
@@ -909,9 +1120,20 @@ struct App {
                                                  pass->sg_pass.scissor_h, color_target);
                     }
 
+                    // bin lights into view-space clusters. Must happen before
+                    // drawcalls are created, which bind the cluster buffer
+                    R_Pass::updateLightClusters(
+                      pass, &app->gctx, scene, camera,
+                      R_Camera::projectionMatrix(camera,
+                                                 camera->params.auto_update_aspect ?
+                                                   aspect :
+                                                   camera->params.aspect),
+                      app->rendergraph.currentViewport(), &frameUniforms);
+
                     G_DrawCallListID dc_list
                       = app->rendergraph.renderPassAddDrawCallList();
                     _R_RenderScene(app, scene, pass, camera, dc_list);
+                    _R_PrewarmMaterials(app, dc_list);
                 } break;
                 case SG_PassType_Screen: {
                     R_Material* material
@@ -987,8 +1209,10 @@ struct App {
                     // create draw call
                     if (material) {
                         G_DrawCall* d = app->rendergraph.addDraw(dc_list);
-                        R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
-                                            &app->rendergraph, screen_shader, NULL);
+                        R_BindFrameUniforms(pass->frame_uniform_buffer,
+                                            &pass->frame_bg_slots, &app->gctx, d,
+                                            &app->rendergraph, screen_shader, NULL,
+                                            NULL);
                         d->sort_key = G_SortKey::create(false, G_RenderingLayer_World,
                                                         material->id, 0, 1);
                         d->vertex_count   = 3;
@@ -1218,12 +1442,26 @@ struct App {
             pass = Component_GetPass(pass->sg_pass.next_pass_id);
         }
 
+        // upload material uniforms written this frame
+        R_Material::flushUniforms(&app->gctx);
+
         // TODO: consolidate with GraphicsContext::present/prepareFrame
         // and with imgui pass
-        app->rendergraph.executeAndReset(app->gctx.device, app->gctx.commandEncoder);
+        {
+            PROFILE_ZONE(ProfileZone_Execute);
+            app->rendergraph.executeAndReset(app->gctx.device, app->gctx.commandEncoder,
+                                             _R_GpuTimerBegin(app));
+            _R_GpuTimerResolve(app);
+        }
+        _R_ProfileCounters(app);
+        Arena::clear(&app->prewarm_material_list);
+
+        // before the UI is drawn over the window
+        _R_RecordCopy(app);
 
         // imgui render pass
         if (do_ui && !resized_this_frame) {
+            PROFILE_ZONE(ProfileZone_ImGui);
             WGPURenderPassColorAttachment imgui_color_attachment = {};
             imgui_color_attachment.view       = app->gctx.backbufferView;
             imgui_color_attachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
@@ -1248,30 +1486,34 @@ struct App {
             wgpuRenderPassEncoderRelease(render_pass);
         }
 
-        GraphicsContext::presentFrame(&app->gctx);
+        {
+            PROFILE_ZONE(ProfileZone_Present);
+            GraphicsContext::presentFrame(&app->gctx);
+        }
+        _R_RecordMap();
+        _R_GpuTimerMap();
     }
 
     static void _calculateFPS(GLFWwindow* window, bool print_to_title)
     {
-        static f64 lastTime{ glfwGetTime() };
+        static u64 lastTime{ stm_now() };
         static u64 frameCount{};
         static char title[256]{};
 
-        // Measure speed
-        f64 currentTime = glfwGetTime();
-        f64 delta       = currentTime - lastTime;
+        // Measure speed (wall clock, also offline)
+        f64 delta = stm_sec(stm_since(lastTime));
         frameCount++;
         if (delta >= 1.0) { // If last cout was more than 1 sec ago
             f64 fps = frameCount / delta;
             CHUGL_Window_fps(fps);
-            if (print_to_title) {
+            if (print_to_title && window) {
                 snprintf(title, sizeof(title),
                          "ChuGL " CHUGL_VERSION_STRING " FPS: %.2f", fps);
                 glfwSetWindowTitle(window, title);
             }
 
             frameCount = 0;
-            lastTime   = currentTime;
+            lastTime   = stm_now();
         }
     }
 
@@ -1311,8 +1553,12 @@ struct App {
 
         if (action == GLFW_PRESS) {
             CHUGL_Kb_action(key, true);
+            CHUGL_Input_Push(InputEvent_KeyDown, key, mods, 0, 0, 0);
         } else if (action == GLFW_RELEASE) {
             CHUGL_Kb_action(key, false);
+            CHUGL_Input_Push(InputEvent_KeyUp, key, mods, 0, 0, 0);
+        } else if (action == GLFW_REPEAT) {
+            CHUGL_Input_Push(InputEvent_KeyRepeat, key, mods, 0, 0, 0);
         }
     }
 
@@ -1330,11 +1576,10 @@ struct App {
     // happens AFTER GraphicsContext::PrepareFrame(), after render surface has
     // already been set window resize needs to be handled before the frame is
     // prepared
-    static void _onFramebufferResize(GLFWwindow* window, int width, int height)
+    static void _onFramebufferResize(App* app, int width, int height)
     {
         log_trace("window resized: %d, %d", width, height);
 
-        App* app              = (App*)glfwGetWindowUserPointer(window);
         app->window_fb_width  = width;
         app->window_fb_height = height;
 
@@ -1344,7 +1589,10 @@ struct App {
         GraphicsContext::resize(&app->gctx, width, height);
 
         // update size stats
-        glfwGetWindowSize(window, &app->window_width, &app->window_height);
+        app->window_width  = width;
+        app->window_height = height;
+        if (app->window)
+            glfwGetWindowSize(app->window, &app->window_width, &app->window_height);
         CHUGL_Window_Size(app->window_width, app->window_height, width, height);
         // broadcast to chuck
         Event_Broadcast(CHUGL_EventType::WINDOW_RESIZE, app->ckapi, app->ckvm);
@@ -1372,6 +1620,9 @@ struct App {
                 CHUGL_Mouse_RightButton(action == GLFW_PRESS);
                 break;
         }
+        CHUGL_Input_Push(action == GLFW_PRESS ? InputEvent_MouseDown :
+                                                InputEvent_MouseUp,
+                         button, mods, 0, app->mouse_x, app->mouse_y);
     }
 
     static void _scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
@@ -1383,6 +1634,7 @@ struct App {
         UNUSED_VAR(app);
 
         CHUGL_scroll_delta(xoffset, yoffset);
+        CHUGL_Input_Push(InputEvent_Scroll, 0, 0, 0, xoffset, yoffset);
     }
 
     static void _cursorPositionCallback(GLFWwindow* window, double xpos, double ypos)
@@ -1396,6 +1648,7 @@ struct App {
         app->mouse_y = ypos;
 
         CHUGL_Mouse_Position(xpos, ypos);
+        CHUGL_Input_Push(InputEvent_MouseMove, 0, 0, 0, xpos, ypos);
     }
 };
 
@@ -1405,24 +1658,273 @@ struct SceneDrawCall {
     SG_ID geo_id;
 };
 
+// a primitive of a scene pass, ready to be recorded. Resolved on the render thread,
+// after anything that touches the GPU. A primitive with LODs has one of these per
+// level in use, each drawing its range of the primitive's instances
+struct R_ScenePrimitive {
+    GeometryToXforms* primitive;
+    R_Material* material;
+    R_Shader* shader;
+    R_Geometry* geo;
+    int first_instance;
+    int instance_count;
+    b32 gpu_culled; // drawn indirectly from what the culling pass left visible
+};
+
+struct R_SceneRecord {
+    App* app;
+    R_Scene* scene;
+    R_Pass* pass;
+    R_Camera* camera;
+    R_ScenePrimitive* primitives;
+};
+
+// records the draws of one primitive into rec. Only reads components and writes
+// to rec, so different primitives can be recorded on different threads
+static void _R_RecordScenePrimitive(R_SceneRecord* record, G_DrawRecorder* rec,
+                                    R_ScenePrimitive* p)
+{
+    App* app                    = record->app;
+    R_Pass* pass                = record->pass;
+    R_Camera* camera            = record->camera;
+    GeometryToXforms* primitive = p->primitive;
+    R_Material* material        = p->material;
+    R_Shader* shader            = p->shader;
+    R_Geometry* geo             = p->geo;
+    bool is_transparent         = material->pso.transparent;
+
+    // add to draw call list
+    G_DrawCall* d = is_transparent ? rec->templateDraw() : rec->pushDraw();
+
+    // populate index buffer
+    bool indexed_draw               = (R_Geometry::indexCount(geo) > 0);
+    bool user_provided_index_count  = (geo->indices_count >= 0);
+    bool user_provided_vertex_count = (geo->vertex_count >= 0);
+    if (material->pso.wireframe) {
+        // wireframe is always an indexed draw
+        if (indexed_draw) {
+            d->index_count = user_provided_index_count ?
+                               MIN(R_Geometry::wireframeIndicesCount(geo),
+                                   geo->indices_count * 2) :
+                               R_Geometry::wireframeIndicesCount(geo);
+        } else {
+            d->index_count = user_provided_vertex_count ?
+                               MIN(R_Geometry::wireframeIndicesCount(geo),
+                                   geo->vertex_count * 2) :
+                               R_Geometry::wireframeIndicesCount(geo);
+        }
+        d->index_buffer        = geo->gpu_wireframe_index_buffer.buf;
+        d->index_buffer_offset = 0;
+        d->index_buffer_size   = geo->gpu_wireframe_index_buffer.size;
+    } else {
+        if (indexed_draw) {
+            d->index_count = user_provided_index_count ?
+                               MIN(R_Geometry::indexCount(geo), geo->indices_count) :
+                               R_Geometry::indexCount(geo);
+            d->index_buffer        = geo->gpu_index_buffer.buf;
+            d->index_buffer_offset = 0;
+            d->index_buffer_size   = geo->gpu_index_buffer.size;
+        } else {
+            // TODO come up with a better way to set a custom number of vertices to
+            // draw having -1 actually mean ALL is confusing 2 different states.
+            d->vertex_count = user_provided_vertex_count ? geo->vertex_count :
+                                                           R_Geometry::vertexCount(geo);
+        }
+    }
+
+    // set pso
+    d->pipelineDesc(shader->id, material->pso.cull_mode,
+                    material->pso.wireframe ? WGPUPrimitiveTopology_LineList :
+                                              material->pso.primitive_topology,
+                    &material->pso.blend_state, is_transparent);
+
+    { // set bindgroups
+        // set frame uniforms
+        R_BindFrameUniforms(pass->frame_uniform_buffer, &pass->frame_bg_slots,
+                            &app->gctx, d, rec, shader, record->scene,
+                            &pass->light_cluster_buffer);
+
+        // set material uniforms
+        // ==optimize== can sort/cache material bindgroupentries per frame
+        // so we don't need to recreate multiple times for a single material
+        R_Material::createBindGroupEntries(material, PER_MATERIAL_GROUP,
+                                           &app->rendergraph, d, &app->gctx, rec);
+
+        // set @group(4) pulled-vertex attribs
+        R_Geometry::addPullBindGroupEntries(geo, rec, d);
+    }
+
+    // set vertex attributes
+    for (int vertex_slot = 0; vertex_slot < ARRAY_LENGTH(geo->gpu_vertex_buffers);
+         ++vertex_slot) {
+        GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[vertex_slot];
+        if (gpu_buffer->buf && gpu_buffer->size > 0)
+            rec->vertexBuffer(d, vertex_slot, gpu_buffer->buf, 0, gpu_buffer->size);
+    }
+
+    // drawcall fields that are different between opaque and transparent materials
+    if (is_transparent) {
+        // NOTE: draw transparent materials individually, no instancing
+        d->instance_count = 1;
+
+        ASSERT(camera->_stale == R_Transform_STALE_NONE);
+        glm::vec3 cam_pos     = glm::vec3(camera->world[3]);
+        glm::vec3 cam_forward = camera->world * glm::vec4(0, 0, -1, 0);
+        cam_forward           = glm::normalize(cam_forward);
+
+        int instance_end = p->first_instance + p->instance_count;
+        for (int instance_idx = p->first_instance; instance_idx < instance_end;
+             ++instance_idx) {
+            G_DrawCall* td     = rec->pushTemplatedDraw();
+            td->instance_count = 1;
+
+            DrawUniforms* draw_uniforms
+              = GeometryToXforms::drawUniform(primitive, instance_idx);
+            glm::vec3 world_pos    = glm::vec3(draw_uniforms->model[3]);
+            float dist_from_camera = 0.0;
+            switch (camera->params.camera_type) {
+                case SG_CameraType_PERPSECTIVE: {
+                    dist_from_camera = glm::distance(
+                      cam_pos,
+                      world_pos); // needs to be distance, not distance^2 so we can
+                                  // normalize against camera far plane
+                } break;
+                case SG_CameraType_ORTHOGRAPHIC: {
+                    dist_from_camera = glm::dot(cam_forward, world_pos - cam_pos);
+                } break;
+                default: UNREACHABLE;
+            }
+
+            td->sort_key
+              = G_SortKey::create(true, G_RenderingLayer_World, material->id,
+                                  dist_from_camera, camera->params.far_plane);
+
+            // set @group(2) per-draw bindings (xform matrices)
+            // note: must modify the template here because each draw requires a
+            // different storage buffer offset
+            td->bg_list[2].start
+              = ARENA_LENGTH(rec->bind_group_entry_list + 2, G_CacheBindGroupEntry);
+            rec->bindBuffer(td, PER_DRAW_GROUP, 0, primitive->xform_storage_buffer.buf,
+                            instance_idx * primitive->push_size, sizeof(DrawUniforms));
+        }
+    } else {
+        d->instance_count = p->instance_count;
+        d->first_instance = p->first_instance;
+        float dist_from_camera
+          = 0.0; // ==optimize== sort opaque geometry front-to-back
+        d->sort_key = G_SortKey::create(false, G_RenderingLayer_World, material->id,
+                                        dist_from_camera, camera->params.far_plane);
+
+        // set @group(3) per-draw bindings (xform matrices)
+        // bound at full capacity so that instance count changes don't
+        // invalidate the persistent bindgroup
+        if (p->gpu_culled) {
+            // only the visible instances, counted in the indirect args
+            d->indirect_buffer = primitive->cull_args_buffer.buf;
+            rec->bindBuffer(d, PER_DRAW_GROUP, 0, primitive->cull_instance_buffer.buf,
+                            0, GPU_Buffer::capacity(primitive->cull_instance_buffer));
+            rec->persistentBindGroup(d, PER_DRAW_GROUP, &primitive->cull_bg_slots, 0);
+        } else {
+            rec->bindBuffer(d, PER_DRAW_GROUP, 0, primitive->xform_storage_buffer.buf,
+                            0, GPU_Buffer::capacity(primitive->xform_storage_buffer));
+            rec->persistentBindGroup(d, PER_DRAW_GROUP, &primitive->draw_bg_slots, 0);
+        }
+    }
+}
+
+// what _R_RecordScenePrimitive draws of geo with a non-wireframe material: its
+// index count if indexed, else its vertex count
+static u32 _R_GeometryDrawCount(R_Geometry* geo)
+{
+    if (R_Geometry::indexCount(geo) > 0) {
+        u32 index_count = geo->indices_count >= 0 ?
+                            MIN(R_Geometry::indexCount(geo), (u32)geo->indices_count) :
+                            R_Geometry::indexCount(geo);
+        return (u32)MIN(index_count, geo->gpu_index_buffer.size / 4);
+    }
+    return geo->vertex_count >= 0 ? geo->vertex_count : R_Geometry::vertexCount(geo);
+}
+
+// adds a dispatch culling primitive's instances for this pass, to a compute pass
+// run right before it (added on the first call, see instance_cull.h). false if
+// there's no room for that pass, then the primitive is drawn as usual
+static bool _R_CullPrimitive(App* app, R_Pass* pass, GeometryToXforms* primitive,
+                             R_Geometry* geo, bool* cull_pass_added)
+{
+    G_Graph* graph = &app->rendergraph;
+    if (!app->instance_cull_module) {
+        app->instance_cull_module = G_createShaderModule(
+          &app->gctx, instance_cull_shader_string, "instance cull compute shader");
+    }
+
+    if (!*cull_pass_added) {
+        char name[64];
+        snprintf(name, sizeof(name), "CullPass[%d:%s]", pass->id, pass->sg_pass.name);
+        if (!graph->insertComputePass(name, app->instance_cull_module)) return false;
+        *cull_pass_added = true;
+    }
+
+    GeometryToXforms::updateCullBuffers(&app->gctx, primitive, geo,
+                                        _R_GeometryDrawCount(geo));
+
+    // one workgroup walks every instance, see instance_cull_shader_string
+    graph->computePassDispatch(1, 1, 1);
+    graph->computePassBindBuffer(0, pass->frame_uniform_buffer, 0,
+                                 sizeof(FrameUniforms));
+    graph->computePassBindBuffer(1, primitive->cull_params_buffer.buf, 0,
+                                 sizeof(InstanceCullParams));
+    graph->computePassBindBuffer(
+      2, primitive->xform_storage_buffer.buf, 0,
+      (u32)GPU_Buffer::capacity(primitive->xform_storage_buffer));
+    graph->computePassBindBuffer(
+      3, primitive->cull_instance_buffer.buf, 0,
+      (u32)GPU_Buffer::capacity(primitive->cull_instance_buffer));
+    graph->computePassBindBuffer(4, primitive->cull_args_buffer.buf, 0,
+                                 INSTANCE_CULL_ARGS_COUNT * sizeof(u32));
+    return true;
+}
+
+// chunk 0 records straight into the rendergraph, the rest into their own recorder
+static void _R_RecordSceneChunk(int chunk, int begin, int end, void* udata)
+{
+    R_SceneRecord* record = (R_SceneRecord*)udata;
+    G_DrawRecorder* rec
+      = chunk == 0 ? &record->app->rendergraph : &record->app->draw_recorders[chunk];
+    for (int i = begin; i < end; i++) {
+        _R_RecordScenePrimitive(record, rec, record->primitives + i);
+    }
+}
+
 // move this into R_Scene, call build drawcall struct?
 static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* camera,
                            G_DrawCallListID dc_list)
 {
-    // form draw call list and sort
+    PROFILE_ZONE(ProfileZone_DrawBuild);
+    R_Material* fallback_material = Component_GetMaterial(app->fallback_material_id);
+    R_Shader* fallback_shader
+      = fallback_material ? Component_GetShader(fallback_material->pso.sg_shader_id) :
+                            NULL;
+
+    // resolve every primitive and do their GPU work (storage buffer and wireframe
+    // uploads, sampler creation) here, so recording them can be split across threads
+    int max_primitives
+      = hashmap_count(scene->geo_to_xform) * (CHUGL_GEOMETRY_MAX_LODS + 1);
+    R_ScenePrimitive* primitives
+      = ARENA_PUSH_COUNT(&app->frameArena, R_ScenePrimitive, max_primitives);
+    int primitive_count = 0;
+    bool cull_pass_added = false;
+
     size_t hashmap_idx_DONT_USE = 0;
     GeometryToXforms* primitive = NULL;
     while (
       hashmap_iter(scene->geo_to_xform, &hashmap_idx_DONT_USE, (void**)&primitive)) {
-        int instance_count = GeometryToXforms::count(primitive);
-        ASSERT(instance_count > 0);
+        ASSERT(GeometryToXforms::count(primitive) > 0);
 
         // Get shader id from material
         R_Material* material = Component_GetMaterial(primitive->key.mat_id);
         ASSERT(material);
-        bool is_transparent = material->pso.transparent;
-        SG_ID shader_id     = material->pso.sg_shader_id;
-        R_Shader* shader    = Component_GetShader(shader_id);
+        SG_ID shader_id  = material->pso.sg_shader_id;
+        R_Shader* shader = Component_GetShader(shader_id);
 
         if (shader == NULL) {
             log_warn(
@@ -1434,141 +1936,84 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
 
         R_Geometry* geo = Component_GetGeometry(primitive->key.geo_id);
 
-        // add to draw call list
-        G_DrawCall* d = is_transparent ? app->rendergraph.templateDraw() :
-                                         app->rendergraph.addDraw(dc_list);
-
-        // populate index buffer
-        bool indexed_draw               = (R_Geometry::indexCount(geo) > 0);
-        bool user_provided_index_count  = (geo->indices_count >= 0);
-        bool user_provided_vertex_count = (geo->vertex_count >= 0);
-        if (material->pso.wireframe) {
-            R_Geometry::rebuildWireframe(geo, &app->gctx);
-            // wireframe is always an indexed draw
-            if (indexed_draw) {
-                d->index_count = user_provided_index_count ?
-                                   MIN(R_Geometry::wireframeIndicesCount(geo),
-                                       geo->indices_count * 2) :
-                                   R_Geometry::wireframeIndicesCount(geo);
-            } else {
-                d->index_count = user_provided_vertex_count ?
-                                   MIN(R_Geometry::wireframeIndicesCount(geo),
-                                       geo->vertex_count * 2) :
-                                   R_Geometry::wireframeIndicesCount(geo);
-            }
-            d->index_buffer        = geo->gpu_wireframe_index_buffer.buf;
-            d->index_buffer_offset = 0;
-            d->index_buffer_size   = geo->gpu_wireframe_index_buffer.size;
-        } else {
-            if (indexed_draw) {
-                d->index_count
-                  = user_provided_index_count ?
-                      MIN(R_Geometry::indexCount(geo), geo->indices_count) :
-                      R_Geometry::indexCount(geo);
-                d->index_buffer        = geo->gpu_index_buffer.buf;
-                d->index_buffer_offset = 0;
-                d->index_buffer_size   = geo->gpu_index_buffer.size;
-            } else {
-                // TODO come up with a better way to set a custom number of vertices to
-                // draw having -1 actually mean ALL is confusing 2 different states.
-                d->vertex_count = user_provided_vertex_count ?
-                                    geo->vertex_count :
-                                    R_Geometry::vertexCount(geo);
-            }
+        if (primitive->validated_shader_id != shader_id
+            || primitive->validated_geo_generation != geo->generation) {
+            bool log = !primitive->geo_mismatch_logged
+                       || primitive->validated_shader_id != shader_id;
+            bool ok  = R_Shader::validateGeometry(shader, geo, log);
+            primitive->geo_mismatch_logged      = !ok;
+            primitive->validated_shader_id      = shader_id;
+            primitive->validated_geo_generation = geo->generation;
         }
 
-        // set pso
-        d->pipelineDesc(shader_id, material->pso.cull_mode,
-                        material->pso.wireframe ? WGPUPrimitiveTopology_LineList :
-                                                  material->pso.primitive_topology,
-                        &material->pso.blend_state, is_transparent);
-
-        { // set bindgroups
-            // set frame uniforms
-            R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
-                                &app->rendergraph, shader, scene);
-
-            // set material uniforms
-            // ==optimize== can sort/cache material bindgroupentries per frame
-            // so we don't need to recreate multiple times for a single material
-            R_Material::createBindGroupEntries(material, PER_MATERIAL_GROUP,
-                                               &app->rendergraph, d, &app->gctx);
-
-            // @group(3) bindings are set below, and are different for transparent vs
-            // opaque
-            GeometryToXforms::updateStorageBuffer(&app->gctx, scene, primitive,
-                                                  &app->gctx.limits);
-
-            // set @group(4) pulled-vertex attribs
-            R_Geometry::addPullBindGroupEntries(geo, &app->rendergraph, d);
-        }
-
-        // set vertex attributes
-        for (int vertex_slot = 0; vertex_slot < ARRAY_LENGTH(geo->gpu_vertex_buffers);
-             ++vertex_slot) {
-            GPU_Buffer* gpu_buffer = &geo->gpu_vertex_buffers[vertex_slot];
-            if (gpu_buffer->buf && gpu_buffer->size > 0)
-                app->rendergraph.vertexBuffer(d, vertex_slot, gpu_buffer->buf, 0,
-                                              gpu_buffer->size);
-        }
-
-        // drawcall fields that are different between opaque and transparent materials
-        if (material->pso.transparent) {
-            // NOTE: draw transparent materials individually, no instancing
-            d->instance_count = 1;
-
-            ASSERT(camera->_stale == R_Transform_STALE_NONE);
-            glm::vec3 cam_pos     = glm::vec3(camera->world[3]);
-            glm::vec3 cam_forward = camera->world * glm::vec4(0, 0, -1, 0);
-            cam_forward           = glm::normalize(cam_forward);
-
-            for (int instance_idx = 0; instance_idx < instance_count; ++instance_idx) {
-                G_DrawCall* td     = app->rendergraph.addTemplatedDraw(dc_list);
-                td->instance_count = 1;
-
-                DrawUniforms* draw_uniforms
-                  = GeometryToXforms::drawUniform(primitive, instance_idx);
-                glm::vec3 world_pos    = glm::vec3(draw_uniforms->model[3]);
-                float dist_from_camera = 0.0;
-                switch (camera->params.camera_type) {
-                    case SG_CameraType_PERPSECTIVE: {
-                        dist_from_camera = glm::distance(
-                          cam_pos,
-                          world_pos); // needs to be distance, not distance^2 so we can
-                                      // normalize against camera far plane
-                    } break;
-                    case SG_CameraType_ORTHOGRAPHIC: {
-                        dist_from_camera = glm::dot(cam_forward, world_pos - cam_pos);
-                    } break;
-                    default: UNREACHABLE;
-                }
+        // draw with the fallback material until this shader's pipelines are
+        // compiled. Otherwise the draw is skipped (see G_DrawCallList::execute)
+        if (shader->pipelines_pending > 0 && fallback_shader
+            && fallback_shader != shader && fallback_shader->pipelines_pending == 0) {
+            material = fallback_material;
+            shader   = fallback_shader;
+        }
 
-                td->sort_key
-                  = G_SortKey::create(true, G_RenderingLayer_World, material->id,
-                                      dist_from_camera, camera->params.far_plane);
-
-                // set @group(2) per-draw bindings (xform matrices)
-                // note: must modify the template here because each draw requires a
-                // different storage buffer offset
-                td->bg_list[2].start = ARENA_LENGTH(
-                  app->rendergraph.bind_group_entry_list + 2, G_CacheBindGroupEntry);
-                app->rendergraph.bindBuffer(
-                  td, PER_DRAW_GROUP, 0, primitive->xform_storage_buffer.buf,
-                  instance_idx * primitive->push_size, sizeof(DrawUniforms));
-            }
-        } else {
-            d->instance_count = instance_count;
-            float dist_from_camera
-              = 0.0; // ==optimize== sort opaque geometry front-to-back
-            d->sort_key = G_SortKey::create(false, G_RenderingLayer_World, material->id,
-                                            dist_from_camera, camera->params.far_plane);
+        // @group(3) bindings are set when recording, and are different for
+        // transparent vs opaque. Also picks each instance's LOD level
+        GeometryToXforms::updateStorageBuffer(&app->gctx, scene, primitive,
+                                              &app->gctx.limits, camera);
 
-            // set @group(3) per-draw bindings (xform matrices)
-            app->rendergraph.bindBuffer(d, PER_DRAW_GROUP, 0,
-                                        primitive->xform_storage_buffer.buf, 0,
-                                        primitive->xform_storage_buffer.size);
+        // samplers are created on first use
+        for (int i = 0; i < CHUGL_MATERIAL_MAX_BINDINGS; ++i) {
+            R_Binding* binding = &material->bindings[i];
+            if (binding->type == R_BIND_SAMPLER)
+                Graphics_GetSampler(&app->gctx, binding->as.samplerConfig);
+        }
+
+        // GScene.gpuCulling(): needs every instance in the storage buffer, so
+        // transparent materials (drawn one at a time) and LOD chains stay on the CPU
+        int count       = GeometryToXforms::count(primitive);
+        bool gpu_culled = scene->sg_scene_desc.gpu_culling
+                          && count >= CHUGL_GPU_CULL_MIN_INSTANCES
+                          && !material->pso.transparent && !material->pso.wireframe
+                          && !primitive->lod_active && geo->has_bounds;
+        if (gpu_culled
+            && _R_CullPrimitive(app, pass, primitive, geo, &cull_pass_added)) {
+            primitives[primitive_count++]
+              = { primitive, material, shader, geo, 0, count, true };
+            continue;
         }
+
+        // one instanced draw per LOD level in use. Instances are grouped by level in
+        // the storage buffer, culled ones left out
+        int first_instance = 0;
+        for (int level = 0; level < ARRAY_LENGTH(primitive->lod_instance_counts);
+             ++level) {
+            int instance_count = primitive->lod_instance_counts[level];
+            if (instance_count > 0) {
+                R_Geometry* level_geo = geo;
+                if (level > 0 && Component_GetGeometry(geo->lod_geo_ids[level - 1]))
+                    level_geo = Component_GetGeometry(geo->lod_geo_ids[level - 1]);
+
+                if (material->pso.wireframe)
+                    R_Geometry::rebuildWireframe(level_geo, &app->gctx);
+
+                primitives[primitive_count++]
+                  = { primitive,      material,       shader, level_geo,
+                      first_instance, instance_count, false };
+            }
+            first_instance += instance_count;
+        }
+    }
+
+    // form draw call list. Chunks are merged in order, so the draws and their
+    // bindgroup entries are exactly what recording on one thread would produce
+    R_SceneRecord record = { app, scene, pass, camera, primitives };
+    int chunk_count
+      = JobPool_ChunkCount(&app->draw_jobs, primitive_count, CHUGL_DRAW_JOBS_MIN_CHUNK);
+    JobPool_ParallelFor(&app->draw_jobs, primitive_count, chunk_count,
+                        _R_RecordSceneChunk, &record);
+    for (int chunk = 1; chunk < chunk_count; chunk++) {
+        app->rendergraph.append(&app->draw_recorders[chunk]);
+        app->draw_recorders[chunk].clear();
     }
+    app->rendergraph.countRecordedDraws(dc_list);
 
     { // skybox pass
         R_Material* skybox_material
@@ -1589,13 +2034,31 @@ static void _R_RenderScene(App* app, R_Scene* scene, R_Pass* pass, R_Camera* cam
 
         R_Shader* skybox_shader
           = Component_GetShader(skybox_material->pso.sg_shader_id);
-        R_BindFrameUniforms(pass->frame_uniform_buffer, &app->gctx, d,
-                            &app->rendergraph, skybox_shader, scene);
+        R_BindFrameUniforms(pass->frame_uniform_buffer, &pass->frame_bg_slots,
+                            &app->gctx, d, &app->rendergraph, skybox_shader, scene,
+                            &pass->light_cluster_buffer);
         R_Material::createBindGroupEntries(skybox_material, PER_MATERIAL_GROUP,
                                            &app->rendergraph, d, &app->gctx);
     }
 }
 
+// requests the pipelines of GG.prewarm()'d materials for the scene pass that owns
+// dc_list, without drawing them
+static void _R_PrewarmMaterials(App* app, G_DrawCallListID dc_list)
+{
+    for (int i = 0; i < ARENA_LENGTH(&app->prewarm_material_list, SG_ID); i++) {
+        R_Material* material = Component_GetMaterial(
+          *ARENA_GET_TYPE(&app->prewarm_material_list, SG_ID, i));
+        if (!material || !Component_GetShader(material->pso.sg_shader_id)) continue;
+
+        app->rendergraph.prewarmPipeline(
+          dc_list, material->pso.sg_shader_id, material->pso.cull_mode,
+          material->pso.wireframe ? WGPUPrimitiveTopology_LineList :
+                                    material->pso.primitive_topology,
+          &material->pso.blend_state, material->pso.transparent);
+    }
+}
+
 // pool of pending mapped buffers
 // currently only used for reading texture data back to CPU
 // simple, assuming there won't be many outstanding requests
@@ -1685,9 +2148,628 @@ static void TextureSaveOnBufferMap(WGPUBufferMapAsyncStatus status,
     CQ_PushCommand_G2A_TextureSave(p->texture_save_event, error);
 }
 
+// GG.record() ----------------------------------------------------------------
+// Frames are copied into a ring of readback buffers and handed, once mapped, to
+// a FrameCapture that encodes and writes them on worker threads. The render
+// thread never waits on a readback: when every slot is busy the frame is
+// dropped. Except offline (GG.offline()), where it waits instead so every frame
+// is recorded. see frame_capture.h
+
+enum R_RecordSlotState : u8 {
+    R_RecordSlot_Free = 0,
+    R_RecordSlot_Copied,   // copy recorded this frame, mapped after submit
+    R_RecordSlot_Mapping,  // waiting on the GPU
+    R_RecordSlot_Encoding, // mapped, read by the FrameCapture workers
+};
+
+struct R_Recorder {
+    FrameCapture capture;
+    SG_ID texture_id; // 0 records the window
+    u32 width, height;
+    u32 bytes_per_row; // padded to the 256 byte copy alignment
+    u32 every;         // record every nth frame
+    u64 frame;
+    WGPUBuffer slots[CHUGL_RECORD_READBACK_SLOTS];
+    R_RecordSlotState slot_state[CHUGL_RECORD_READBACK_SLOTS];
+};
+
+static R_Recorder _r_recorder = {};
+
+static void _R_RecordOnBufferMap(WGPUBufferMapAsyncStatus status, void* udata)
+{
+    R_Recorder* rec = &_r_recorder;
+    int slot        = (int)(intptr_t)udata;
+    if (status != WGPUBufferMapAsyncStatus_Success) {
+        rec->slot_state[slot] = R_RecordSlot_Free;
+        FrameCapture_Drop(&rec->capture);
+        return;
+    }
+
+    const u8* pixels = (const u8*)wgpuBufferGetConstMappedRange(
+      rec->slots[slot], 0, (size_t)rec->bytes_per_row * rec->height);
+    rec->slot_state[slot] = R_RecordSlot_Encoding;
+    FrameCapture_Submit(&rec->capture, pixels, rec->bytes_per_row, slot);
+}
+
+static void _R_RecordStop(App* app)
+{
+    R_Recorder* rec = &_r_recorder;
+    if (!FrameCapture_Active(&rec->capture)) return;
+
+    // frames still being read back are recorded too
+    bool mapping = true;
+    while (mapping) {
+        mapping = false;
+        for (int i = 0; i < CHUGL_RECORD_READBACK_SLOTS; i++) {
+            if (rec->slot_state[i] == R_RecordSlot_Mapping) mapping = true;
+        }
+#if defined(WEBGPU_BACKEND_WGPU)
+        if (mapping) wgpuDevicePoll(app->gctx.device, true, NULL);
+#endif
+    }
+
+    FrameCaptureStats stats = FrameCapture_End(&rec->capture);
+    CHUGL_RenderRecordStats(false, &stats);
+
+    for (int i = 0; i < CHUGL_RECORD_READBACK_SLOTS; i++) {
+        if (rec->slot_state[i] == R_RecordSlot_Encoding) wgpuBufferUnmap(rec->slots[i]);
+        WGPU_RELEASE_RESOURCE(Buffer, rec->slots[i]);
+    }
+    *rec = {};
+}
+
+static void _R_RecordStart(App* app, const char* path, SG_ID texture_id)
+{
+    _R_RecordStop(app);
+
+#ifdef __EMSCRIPTEN__
+    log_error("GG.record() is not supported on the web");
+#else
+    R_Recorder* rec = &_r_recorder;
+    WGPUTextureFormat format;
+    u32 width, height;
+    if (texture_id) {
+        R_Texture* tex = Component_GetTexture(texture_id);
+        bool copy_src
+          = tex && (wgpuTextureGetUsage(tex->gpu_texture) & WGPUTextureUsage_CopySrc);
+        if (!copy_src) {
+            log_error("GG.record(): texture needs Texture.Usage_CopySrc");
+            return;
+        }
+        format = wgpuTextureGetFormat(tex->gpu_texture);
+        width  = wgpuTextureGetWidth(tex->gpu_texture);
+        height = wgpuTextureGetHeight(tex->gpu_texture);
+    } else {
+        if (!(app->gctx.surface_usage & WGPUTextureUsage_CopySrc)) {
+            log_error("GG.record(): the window surface can't be copied from on this "
+                      "device, record a Texture instead");
+            return;
+        }
+        format = app->gctx.surface_format;
+        width  = app->window_fb_width;
+        height = app->window_fb_height;
+    }
+    bool bgra = format == WGPUTextureFormat_BGRA8Unorm
+                || format == WGPUTextureFormat_BGRA8UnormSrgb;
+    bool rgba = format == WGPUTextureFormat_RGBA8Unorm
+                || format == WGPUTextureFormat_RGBA8UnormSrgb;
+    if (!bgra && !rgba) {
+        log_error("GG.record(): can't record %s textures, only 8 bit RGBA or BGRA",
+                  G_Util::textureFormatToString(format));
+        return;
+    }
+
+    // frames are presented at the monitor refresh rate or the fixed timestep
+    f64 fps = app->offline_fps;
+    if (app->window) {
+        GLFWmonitor* monitor    = getCurrentMonitor(app->window);
+        const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+        fps = (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+        if (app->stepper_fps > 0 && app->stepper_fps < fps) fps = app->stepper_fps;
+    }
+
+    FrameCaptureDesc desc = {};
+    FrameCapture_DescFromPath(&desc, path);
+    rec->every = 1;
+    if (desc.format == FrameCaptureFormat_GIF) {
+        // GIF delays are in centiseconds, and players slow frames under 2cs down
+        rec->every = (u32)ceil(fps / 50.0);
+        fps /= rec->every;
+    }
+    desc.width        = width;
+    desc.height       = height;
+    desc.fps          = fps;
+    desc.bgra         = bgra;
+    desc.opaque       = texture_id == 0;
+    desc.worker_count = CHUGL_RECORD_THREADS;
+    if (!FrameCapture_Begin(&rec->capture, &desc)) return;
+
+    rec->texture_id    = texture_id;
+    rec->width         = width;
+    rec->height        = height;
+    rec->bytes_per_row = NEXT_MULT(width * 4, 256);
+    for (int i = 0; i < CHUGL_RECORD_READBACK_SLOTS; i++) {
+        WGPUBufferDescriptor buffer_desc = {};
+        buffer_desc.label                = "GG.record() readback";
+        buffer_desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
+        buffer_desc.size  = (u64)rec->bytes_per_row * height;
+        rec->slots[i]     = wgpuDeviceCreateBuffer(app->gctx.device, &buffer_desc);
+    }
+    log_info("Recording %ux%u at %.2f fps to \"%s\"", width, height, fps, path);
+#endif
+}
+
+// unmaps the slots the encoders are done with, returns a free slot or -1
+static int _R_RecordFreeSlot(R_Recorder* rec)
+{
+    int released[CHUGL_RECORD_READBACK_SLOTS];
+    int released_count
+      = FrameCapture_Released(&rec->capture, released, ARRAY_LENGTH(released));
+    for (int i = 0; i < released_count; i++) {
+        wgpuBufferUnmap(rec->slots[released[i]]);
+        rec->slot_state[released[i]] = R_RecordSlot_Free;
+    }
+
+    for (int i = 0; i < CHUGL_RECORD_READBACK_SLOTS; i++) {
+        if (rec->slot_state[i] == R_RecordSlot_Free) return i;
+    }
+    return -1;
+}
+
+static void _R_RecordCopy(App* app)
+{
+    R_Recorder* rec = &_r_recorder;
+    if (!FrameCapture_Active(&rec->capture)) return;
+
+    int slot = _R_RecordFreeSlot(rec);
+
+    if (rec->frame++ % rec->every) return;
+
+    WGPUTexture src = app->gctx.surface_texture.texture;
+    if (rec->texture_id) {
+        R_Texture* tex = Component_GetTexture(rec->texture_id);
+        src            = tex ? tex->gpu_texture : NULL;
+    }
+    // the output keeps the size recording started with
+    if (!src || wgpuTextureGetWidth(src) != rec->width
+        || wgpuTextureGetHeight(src) != rec->height) {
+        FrameCapture_Drop(&rec->capture);
+        return;
+    }
+
+    // offline, wait for the readbacks and encoders to catch up
+    while (app->offline_fps > 0 && (slot < 0 || FrameCapture_Full(&rec->capture))) {
+#if defined(WEBGPU_BACKEND_WGPU)
+        wgpuDevicePoll(app->gctx.device, true, NULL); // finishes mapping slots
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        slot = _R_RecordFreeSlot(rec);
+    }
+    // encoders are behind, drop the frame rather than stall this one
+    if (slot < 0 || FrameCapture_Full(&rec->capture)) {
+        FrameCapture_Drop(&rec->capture);
+        return;
+    }
+
+    WGPUImageCopyTexture copy_location = {};
+    copy_location.texture              = src;
+    WGPUImageCopyBuffer copy_buffer    = {};
+    copy_buffer.buffer                 = rec->slots[slot];
+    copy_buffer.layout.bytesPerRow     = rec->bytes_per_row;
+    copy_buffer.layout.rowsPerImage    = rec->height;
+    WGPUExtent3D copy_size             = { rec->width, rec->height, 1 };
+    wgpuCommandEncoderCopyTextureToBuffer(app->gctx.commandEncoder, &copy_location,
+                                          &copy_buffer, &copy_size);
+    rec->slot_state[slot] = R_RecordSlot_Copied;
+}
+
+// after the frame is submitted
+static void _R_RecordMap()
+{
+    R_Recorder* rec = &_r_recorder;
+    if (!FrameCapture_Active(&rec->capture)) return;
+
+    for (int i = 0; i < CHUGL_RECORD_READBACK_SLOTS; i++) {
+        if (rec->slot_state[i] != R_RecordSlot_Copied) continue;
+        rec->slot_state[i] = R_RecordSlot_Mapping;
+        wgpuBufferMapAsync(rec->slots[i], WGPUMapMode_Read, 0,
+                           wgpuBufferGetSize(rec->slots[i]), _R_RecordOnBufferMap,
+                           (void*)(intptr_t)i);
+    }
+
+    FrameCaptureStats stats = FrameCapture_Stats(&rec->capture);
+    CHUGL_RenderRecordStats(true, &stats);
+}
+
+// GG.capture() and GG.replay() ------------------------------------------------
+// Capture writes each frame's command queue to a file just before it's handled.
+// Replay reads a capture back in place of chuck: every frame's commands are
+// loaded into the read queue instead of swapping, and drained and rendered as
+// usual, offline and as fast as possible. Chuck's graphics shreds are never
+// woken. see command_stream.h
+
+// captures from a build with a different set of commands or pointer size don't
+// load
+#define R_COMMAND_STREAM_TAG (((u32)SG_COMMAND_COUNT << 8) | (u32)sizeof(void*))
+
+struct R_CommandStream {
+    CommandStreamWriter capture;
+    CommandStreamReader replay;
+    CommandStreamFrame frame; // next to replay
+    u64 replay_start;         // stm ticks
+};
+
+static R_CommandStream _r_command_stream = {};
+
+static void _R_CaptureBegin(const char* path, int width, int height)
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (!CommandStream_Open(&cs->capture, path, R_COMMAND_STREAM_TAG, width, height)) {
+        log_error("GG.capture(): unable to open \"%s\"", path);
+        return;
+    }
+    log_info("Capturing commands to \"%s\"", path);
+}
+
+// geometry data is passed by pointer, and written out as attachments
+static void _R_CaptureFrame(App* app)
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (!cs->capture.file) return;
+
+    u64 size       = 0;
+    u8* commands   = (u8*)CQ_ReadCommandQueueData(&size);
+    u64 list_start = app->frameArena.curr;
+    u32 count      = 0;
+
+    SG_Command* command = NULL;
+    while (CQ_ReadCommandQueueIter(&command)) {
+        SG_GeometryBlock** block = NULL;
+        if (command->type == SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE) {
+            block = &((SG_Command_GeoSetVertexAttribute*)command)->data;
+        } else if (command->type == SG_COMMAND_GEO_SET_INDICES) {
+            block = &((SG_Command_GeoSetIndices*)command)->indices;
+        }
+        if (!block || !*block) continue;
+
+        CommandStreamAttachment* att
+          = ARENA_PUSH_TYPE(&app->frameArena, CommandStreamAttachment);
+        att->patch_offset = (u8*)block - commands;
+        att->size         = (*block)->size;
+        att->data         = (*block)->data;
+        ++count;
+    }
+
+    CommandStreamAttachment* list
+      = (CommandStreamAttachment*)Arena::get(&app->frameArena, list_start);
+    if (!CommandStream_WriteFrame(&cs->capture, app->lastTime, commands, size, list,
+                                  count)) {
+        log_error("GG.capture(): write failed, stopped after %llu frames",
+                  (unsigned long long)cs->capture.frame_count);
+    }
+}
+
+static void _R_CaptureEnd()
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (!cs->capture.file) return;
+    log_info("Captured %llu frames, %.2f MB",
+             (unsigned long long)cs->capture.frame_count,
+             cs->capture.bytes_written / (f64)MEGABYTE);
+    CommandStream_Close(&cs->capture);
+}
+
+static bool _R_Replaying()
+{
+    return _r_command_stream.replay.data != NULL;
+}
+
+// sets the offscreen size to the captured one
+static bool _R_ReplayBegin(const char* path, int* width, int* height)
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (!CommandStream_Load(&cs->replay, path)) {
+        log_error("GG.replay(): \"%s\" is not a command capture", path);
+        return false;
+    }
+    if (cs->replay.header.tag != R_COMMAND_STREAM_TAG) {
+        log_error("GG.replay(): \"%s\" was captured by another version of ChuGL",
+                  path);
+        CommandStream_Free(&cs->replay);
+        return false;
+    }
+    *width  = cs->replay.header.width;
+    *height = cs->replay.header.height;
+    return true;
+}
+
+// false at the end of the capture
+static bool _R_ReplayNextFrame(f64* time)
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (cs->replay_start == 0) cs->replay_start = stm_now();
+    if (!CommandStream_NextFrame(&cs->replay, &cs->frame)) {
+        if (cs->replay.corrupt) {
+            log_error("GG.replay(): capture is cut off after %llu frames",
+                      (unsigned long long)cs->replay.frame_count);
+        }
+        return false;
+    }
+    *time = cs->frame.time;
+    return true;
+}
+
+// in place of CQ_SwapQueues()
+static void _R_ReplayLoadFrame()
+{
+    R_CommandStream* cs = &_r_command_stream;
+    u8* commands
+      = (u8*)CQ_ReadCommandQueueLoad(cs->frame.commands, cs->frame.command_bytes);
+
+    // each geometry block gets a fresh copy, released by the command as usual
+    CommandStreamAttachment att;
+    while (CommandStream_NextAttachment(&cs->frame, &att)) {
+        Arena data = {};
+        memcpy(Arena::push(&data, att.size), att.data, att.size);
+        SG_GeometryBlock* block = SG_GeometryBlock::fromArena(&data);
+        memcpy(commands + att.patch_offset, &block, sizeof(block));
+    }
+
+    // nothing reads results back while replaying, free what would leak
+    CQ_SwapQueues(true);
+    SG_Command* command = NULL;
+    while (CQ_ReadCommandQueueIter(&command, true)) {
+        if (command->type == SG_COMMAND_G2A_TEXTURE_READ)
+            free(((SG_Command_G2A_TextureRead*)command)->data_OWNED);
+    }
+    CQ_ReadCommandQueueClear(true);
+}
+
+// commands that hand results back to chuck, or point at devices and audio
+// buffers of the process that captured them
+static bool _R_ReplaySkips(SG_CommandType type)
+{
+    switch (type) {
+        case SG_COMMAND_b2_WORLD_SET:
+        case SG_COMMAND_SAVE_TEXTURE:
+        case SG_COMMAND_WEBCAM_CREATE:
+        case SG_COMMAND_WEBCAM_UPDATE:
+        case SG_COMMAND_AUDIO_TAP_UPDATE: return true;
+        default: return false;
+    }
+}
+
+static void _R_ReplayEnd()
+{
+    R_CommandStream* cs = &_r_command_stream;
+    if (!_R_Replaying()) return;
+
+    // on stdout whatever the log level, for scripts comparing runs
+    u64 frames = cs->replay.frame_count;
+    f64 secs   = cs->replay_start ? stm_sec(stm_since(cs->replay_start)) : 0;
+    printf("[ChuGL] replayed %llu frames in %.3fs: %.3f ms/frame, %.1f fps\n",
+           (unsigned long long)frames, secs, frames ? 1000.0 * secs / frames : 0.0,
+           secs > 0 ? frames / secs : 0.0);
+
+    // GG.profile(true) before GG.replay() breaks the frames down
+    if (Profiler_Enabled()) {
+        ProfileStats stats;
+        Profiler_Stats(&stats);
+        static char report[8192];
+        Profiler_FormatStats(&stats, report, sizeof(report));
+        printf("%s\n", report);
+    }
+    fflush(stdout);
+    CommandStream_Free(&cs->replay);
+    cs->frame        = {};
+    cs->replay_start = 0;
+}
+
+// GG.profile() GPU pass times ------------------------------------------------
+// Every rendergraph pass writes a timestamp at its beginning and end. They are
+// resolved and copied into a ring of readback buffers, so reading them never
+// waits on the GPU, and reach the profiler a few frames late. Frames are not
+// timed while every slot is still being read back. see profiler.h
+
+#define R_GPU_TIMER_QUERY_COUNT (2 * CHUGL_RENDERGRAPH_MAX_PASSES)
+
+enum R_GpuTimerSlotState : u8 {
+    R_GpuTimerSlot_Free = 0,
+    R_GpuTimerSlot_Copied, // resolved this frame, mapped after submit
+    R_GpuTimerSlot_Mapping,
+};
+
+struct R_GpuTimer {
+    WGPUQuerySet query_set;
+    WGPUBuffer resolve; // QueryResolve, shared by every slot
+    WGPUBuffer slots[CHUGL_PROFILER_GPU_READBACK_SLOTS];
+    R_GpuTimerSlotState slot_state[CHUGL_PROFILER_GPU_READBACK_SLOTS];
+    G_GraphTimestamps timestamps[CHUGL_PROFILER_GPU_READBACK_SLOTS];
+    int slot; // timed this frame, -1 if none
+};
+
+static R_GpuTimer _r_gpu_timer = {};
+
+static void _R_GpuTimerOnBufferMap(WGPUBufferMapAsyncStatus status, void* udata)
+{
+    R_GpuTimer* timer     = &_r_gpu_timer;
+    int slot              = (int)(intptr_t)udata;
+    G_GraphTimestamps* ts = timer->timestamps + slot;
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        const u64* ticks = (const u64*)wgpuBufferGetConstMappedRange(
+          timer->slots[slot], 0, 2 * ts->pass_count * sizeof(u64));
+        // timestamps are in nanoseconds. A pass can end "before" it began when the
+        // GPU changes clocks mid frame
+        f64 ms[CHUGL_RENDERGRAPH_MAX_PASSES];
+        for (int i = 0; i < ts->pass_count; i++) {
+            u64 begin = ticks[2 * i], end = ticks[2 * i + 1];
+            ms[i]     = end > begin ? (f64)(end - begin) / 1e6 : 0.0;
+        }
+        Profiler_GpuPasses(ts->pass_names, ms, ts->pass_count);
+        wgpuBufferUnmap(timer->slots[slot]);
+    }
+    timer->slot_state[slot] = R_GpuTimerSlot_Free;
+}
+
+// the timestamps to write this frame, NULL if not timing
+static G_GraphTimestamps* _R_GpuTimerBegin(App* app)
+{
+    R_GpuTimer* timer = &_r_gpu_timer;
+    timer->slot       = -1;
+    if (!Profiler_Enabled() || !app->gctx.timestamp_queries) return NULL;
+
+    if (!timer->query_set) {
+        WGPUQuerySetDescriptor query_set_desc = {};
+        query_set_desc.label                  = "GG.profile() timestamps";
+        query_set_desc.type                   = WGPUQueryType_Timestamp;
+        query_set_desc.count                  = R_GPU_TIMER_QUERY_COUNT;
+        timer->query_set = wgpuDeviceCreateQuerySet(app->gctx.device, &query_set_desc);
+
+        WGPUBufferDescriptor buffer_desc = {};
+        buffer_desc.label                = "GG.profile() timestamp resolve";
+        buffer_desc.usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc;
+        buffer_desc.size  = R_GPU_TIMER_QUERY_COUNT * sizeof(u64);
+        timer->resolve    = wgpuDeviceCreateBuffer(app->gctx.device, &buffer_desc);
+
+        buffer_desc.label = "GG.profile() timestamp readback";
+        buffer_desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
+        for (int i = 0; i < CHUGL_PROFILER_GPU_READBACK_SLOTS; i++) {
+            timer->slots[i] = wgpuDeviceCreateBuffer(app->gctx.device, &buffer_desc);
+        }
+    }
+
+    for (int i = 0; i < CHUGL_PROFILER_GPU_READBACK_SLOTS; i++) {
+        if (timer->slot_state[i] != R_GpuTimerSlot_Free) continue;
+        timer->slot                    = i;
+        timer->timestamps[i].query_set = timer->query_set;
+        return timer->timestamps + i;
+    }
+    return NULL;
+}
+
+// after the rendergraph is executed
+static void _R_GpuTimerResolve(App* app)
+{
+    R_GpuTimer* timer = &_r_gpu_timer;
+    if (timer->slot < 0 || timer->timestamps[timer->slot].pass_count == 0) return;
+
+    u32 query_count = 2 * timer->timestamps[timer->slot].pass_count;
+    wgpuCommandEncoderResolveQuerySet(app->gctx.commandEncoder, timer->query_set, 0,
+                                      query_count, timer->resolve, 0);
+    wgpuCommandEncoderCopyBufferToBuffer(app->gctx.commandEncoder, timer->resolve, 0,
+                                         timer->slots[timer->slot], 0,
+                                         query_count * sizeof(u64));
+    timer->slot_state[timer->slot] = R_GpuTimerSlot_Copied;
+}
+
+// after the frame is submitted
+static void _R_GpuTimerMap()
+{
+    R_GpuTimer* timer = &_r_gpu_timer;
+    for (int i = 0; i < CHUGL_PROFILER_GPU_READBACK_SLOTS; i++) {
+        if (timer->slot_state[i] != R_GpuTimerSlot_Copied) continue;
+        timer->slot_state[i] = R_GpuTimerSlot_Mapping;
+        wgpuBufferMapAsync(timer->slots[i], WGPUMapMode_Read, 0,
+                           2 * timer->timestamps[i].pass_count * sizeof(u64),
+                           _R_GpuTimerOnBufferMap, (void*)(intptr_t)i);
+    }
+}
+
+static void _R_GpuTimerRelease()
+{
+    R_GpuTimer* timer = &_r_gpu_timer;
+    for (int i = 0; i < CHUGL_PROFILER_GPU_READBACK_SLOTS; i++) {
+        WGPU_RELEASE_RESOURCE(Buffer, timer->slots[i]);
+    }
+    WGPU_RELEASE_RESOURCE(Buffer, timer->resolve);
+    WGPU_RELEASE_RESOURCE(QuerySet, timer->query_set);
+    *timer = {};
+}
+
+// GG.profile() counters -------------------------------------------------------
+// render stats that aren't times, listed under "count" in GG.stats()
+
+static void _R_ProfileCounter(ProfileCounter* counters, int* count, const char* name,
+                              u64 frame, u64 total)
+{
+    if (*count >= PROFILER_MAX_COUNTERS) return;
+    ProfileCounter* counter = counters + (*count)++;
+    snprintf(counter->name, sizeof(counter->name), "%s", name);
+    counter->frame = frame;
+    counter->total = total;
+}
+
+// after the rendergraph is executed
+static void _R_ProfileCounters(App* app)
+{
+    if (!Profiler_Enabled()) return;
+    ProfileCounter counters[PROFILER_MAX_COUNTERS];
+    int count = 0;
+
+    // shadows of every scene rendered this frame
+    R_ShadowStats shadow_frame = {}, shadow_total = {};
+    size_t scene_idx = 0;
+    R_Scene* scene   = NULL;
+    while (Component_SceneIter(&scene_idx, &scene)) {
+        shadow_total.casters += scene->shadow_lifetime_stats.casters;
+        shadow_total.casters_culled += scene->shadow_lifetime_stats.casters_culled;
+        shadow_total.layers_rendered += scene->shadow_lifetime_stats.layers_rendered;
+        shadow_total.layers_skipped += scene->shadow_lifetime_stats.layers_skipped;
+        if (scene->last_fc_updated != app->fc) continue;
+        shadow_frame.casters += scene->shadow_frame_stats.casters;
+        shadow_frame.casters_culled += scene->shadow_frame_stats.casters_culled;
+        shadow_frame.layers_rendered += scene->shadow_frame_stats.layers_rendered;
+        shadow_frame.layers_skipped += scene->shadow_frame_stats.layers_skipped;
+    }
+    _R_ProfileCounter(counters, &count, "shadow_casters", shadow_frame.casters,
+                      shadow_total.casters);
+    _R_ProfileCounter(counters, &count, "shadow_casters_culled",
+                      shadow_frame.casters_culled, shadow_total.casters_culled);
+    _R_ProfileCounter(counters, &count, "shadow_layers_rendered",
+                      shadow_frame.layers_rendered, shadow_total.layers_rendered);
+    _R_ProfileCounter(counters, &count, "shadow_layers_skipped",
+                      shadow_frame.layers_skipped, shadow_total.layers_skipped);
+
+    // render pipelines, compiled off the render thread unless pre-warmed. Pending
+    // is the current count, not summed
+    G_Cache* cache = &app->rendergraph.cache;
+    _R_ProfileCounter(counters, &count, "pipeline_misses",
+                      cache->last_frame_stats.render_pipeline_misses,
+                      cache->lifetime_stats.render_pipeline_misses);
+    _R_ProfileCounter(counters, &count, "pipelines_compiled",
+                      cache->last_frame_stats.render_pipelines_compiled,
+                      cache->lifetime_stats.render_pipelines_compiled);
+    _R_ProfileCounter(counters, &count, "pipelines_pending",
+                      cache->last_frame_stats.render_pipelines_pending,
+                      cache->lifetime_stats.render_pipelines_pending);
+
+    // material uniform pool. Buffers and blocks are current counts, not summed
+    G_UniformPoolStats uniform_frame, uniform_total;
+    R_Material::uniformStats(&uniform_frame, &uniform_total);
+    _R_ProfileCounter(counters, &count, "uniform_buffers", uniform_frame.gpu_buffers,
+                      uniform_total.gpu_buffers);
+    _R_ProfileCounter(counters, &count, "uniform_blocks", uniform_frame.blocks_used,
+                      uniform_total.blocks_used);
+    _R_ProfileCounter(counters, &count, "uniform_uploads", uniform_frame.uploads,
+                      uniform_total.uploads);
+    _R_ProfileCounter(counters, &count, "uniform_upload_bytes",
+                      uniform_frame.upload_bytes, uniform_total.upload_bytes);
+
+    Profiler_Counters(counters, count);
+}
+
 // TODO make sure switch statement is in correct order?
 static void _R_HandleCommand(App* app, SG_Command* command)
 {
+    // offline there is no window. Closing it ends rendering, the rest does nothing
+    if (!app->window && command->type >= SG_COMMAND_WINDOW_CLOSE
+        && command->type <= SG_COMMAND_MOUSE_CURSOR_NORMAL) {
+        if (command->type == SG_COMMAND_WINDOW_CLOSE) app->offline_closed = true;
+        return;
+    }
+
+    if (_R_Replaying() && _R_ReplaySkips(command->type)) return;
+
     switch (command->type) {
         case SG_COMMAND_SET_FIXED_TIMESTEP: {
             SG_Command_SetFixedTimestep* cmd = (SG_Command_SetFixedTimestep*)command;
@@ -1708,6 +2790,41 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_SetChuckVMInfo* cmd = (SG_Command_SetChuckVMInfo*)command;
             app->ck_srate                  = cmd->srate;
         } break;
+        case SG_COMMAND_SET_FALLBACK_MATERIAL: {
+            SG_Command_SetFallbackMaterial* cmd
+              = (SG_Command_SetFallbackMaterial*)command;
+            app->fallback_material_id = cmd->material_id;
+        } break;
+        case SG_COMMAND_SET_DESTROY_BUDGET: {
+            SG_Command_SetDestroyBudget* cmd = (SG_Command_SetDestroyBudget*)command;
+            app->destroy_budget_ms           = cmd->budget_ms;
+        } break;
+        case SG_COMMAND_SET_TEXTURE_UPLOAD_BUDGET: {
+            SG_Command_SetTextureUploadBudget* cmd
+              = (SG_Command_SetTextureUploadBudget*)command;
+            app->texture_upload_budget = cmd->budget_bytes;
+        } break;
+        case SG_COMMAND_SET_PIPELINED: {
+            SG_Command_SetPipelined* cmd = (SG_Command_SetPipelined*)command;
+            app->pipelined               = cmd->pipelined;
+        } break;
+        case SG_COMMAND_RECORD_START: {
+            SG_Command_RecordStart* cmd = (SG_Command_RecordStart*)command;
+            _R_RecordStart(app, (char*)CQ_ReadCommandGetOffset(cmd->path_offset),
+                           cmd->texture_id);
+        } break;
+        case SG_COMMAND_RECORD_STOP: {
+            _R_RecordStop(app);
+        } break;
+        case SG_COMMAND_TRACE_START: {
+            SG_Command_TraceStart* cmd = (SG_Command_TraceStart*)command;
+            Profiler_TraceBegin((char*)CQ_ReadCommandGetOffset(cmd->path_offset),
+                                CHUGL_PROFILER_TRACE_MAX_EVENTS);
+            if (!Profiler_Enabled()) Profiler_Enable(true);
+        } break;
+        case SG_COMMAND_TRACE_STOP: {
+            Profiler_TraceEnd();
+        } break;
         case SG_COMMAND_WINDOW_CLOSE: {
             glfwSetWindowShouldClose(app->window, GLFW_TRUE);
             break;
@@ -2039,6 +3156,8 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             R_Scene* scene              = Component_GetScene(cmd->sg_id);
             if (!scene)
                 scene = Component_CreateScene(&app->gctx, cmd->sg_id, &cmd->desc);
+            if (scene->sg_scene_desc.env_map_id != cmd->desc.env_map_id)
+                ++scene->bindgroup_version;
             scene->sg_scene_desc = cmd->desc;
         } break;
         // shaders ----------------------
@@ -2053,20 +3172,22 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_MATERIAL_UPDATE_PSO: {
             SG_Command_MaterialUpdatePSO* cmd = (SG_Command_MaterialUpdatePSO*)command;
             R_Material* material              = Component_GetMaterial(cmd->sg_id);
-            material->pso                     = cmd->pso;
+            if (material->pso.sg_shader_id != cmd->pso.sg_shader_id)
+                material->binding_warned = 0;
+            material->pso = cmd->pso;
         } break;
         case SG_COMMAND_MATERIAL_SET_UNIFORM: {
             SG_Command_MaterialSetUniform* cmd
               = (SG_Command_MaterialSetUniform*)command;
             R_Material* material = Component_GetMaterial(cmd->sg_id);
+            R_Material::validateBinding(material, cmd->location, cmd->uniform.type);
 
             switch (cmd->uniform.type) {
                 // NONE uniform, assume this means removing a binding
                 // assumes garbage collection refcounting is tracked on
                 // chuck/audio-thread side
                 case SG_MATERIAL_UNIFORM_NONE: {
-                    material->bindings[cmd->location].type = R_BIND_EMPTY;
-                    material->bindings[cmd->location].size = 0;
+                    R_Material::removeBinding(material, cmd->location);
                 } break;
                 // basic uniform
                 case SG_MATERIAL_UNIFORM_FLOAT:
@@ -2119,9 +3240,15 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               = (SG_Command_MaterialSetStorageBuffer*)command;
             R_Material* material = Component_GetMaterial(cmd->sg_id);
             void* data           = CQ_ReadCommandGetOffset(cmd->data_offset);
+            R_Material::validateBinding(material, cmd->location,
+                                        SG_MATERIAL_UNIFORM_STORAGE_BUFFER);
             R_Material::setBinding(&app->gctx, material, cmd->location, R_BIND_STORAGE,
                                    data, cmd->data_size_bytes);
         } break;
+        case SG_COMMAND_MATERIAL_PREWARM: {
+            SG_Command_MaterialPrewarm* cmd = (SG_Command_MaterialPrewarm*)command;
+            *ARENA_PUSH_TYPE(&app->prewarm_material_list, SG_ID) = cmd->sg_id;
+        } break;
         // mesh -------------------------
         case SG_COMMAND_MESH_UPDATE: {
             SG_Command_MeshUpdate* cmd = (SG_Command_MeshUpdate*)command;
@@ -2187,8 +3314,9 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               = (SG_Command_GeoSetVertexAttribute*)command;
             R_Geometry::setVertexAttribute(
               &app->gctx, Component_GetGeometry(cmd->sg_id), cmd->location,
-              cmd->num_components, CQ_ReadCommandGetOffset(cmd->data_offset),
-              cmd->data_size_bytes);
+              cmd->num_components, cmd->data->data, cmd->data->size);
+            // uploaded, drop the command's ref
+            SG_GeometryBlock::release(cmd->data);
         } break;
         case SG_COMMAND_GEO_SET_PULLED_VERTEX_ATTRIBUTE: {
             SG_Command_GeometrySetPulledVertexAttribute* cmd
@@ -2215,10 +3343,16 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_GEO_SET_INDICES: {
             SG_Command_GeoSetIndices* cmd = (SG_Command_GeoSetIndices*)command;
             R_Geometry* geo               = Component_GetGeometry(cmd->sg_id);
-
-            u32* indices = (u32*)CQ_ReadCommandGetOffset(cmd->indices_offset);
-
-            R_Geometry::setIndices(&app->gctx, geo, indices, cmd->index_count);
+            R_Geometry::setIndices(&app->gctx, geo, cmd->indices);
+        } break;
+        case SG_COMMAND_GEO_SET_LODS: {
+            SG_Command_GeoSetLODs* cmd = (SG_Command_GeoSetLODs*)command;
+            R_Geometry* geo            = Component_GetGeometry(cmd->sg_id);
+            geo->lod_count             = cmd->lod_count;
+            geo->lod_cull_size         = cmd->lod_cull_size;
+            memcpy(geo->lod_geo_ids, cmd->lod_geo_ids, sizeof(geo->lod_geo_ids));
+            memcpy(geo->lod_screen_sizes, cmd->lod_screen_sizes,
+                   sizeof(geo->lod_screen_sizes));
         } break;
 
         // textures ---------------------
@@ -2239,16 +3373,15 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             R_Texture* texture              = Component_GetTexture(cmd->sg_id);
             const char* path
               = (const char*)CQ_ReadCommandGetOffset(cmd->filepath_offset);
-            R_Texture::load(&app->gctx, texture, path, cmd->flip_vertically,
-                            cmd->gen_mips);
+            R_Texture::load(texture, path, cmd->flip_vertically, cmd->gen_mips);
         } break;
         case SG_COMMAND_TEXTURE_FROM_RAW_DATA: {
             SG_Command_TextureFromRawData* cmd
               = (SG_Command_TextureFromRawData*)command;
             R_Texture* texture = Component_GetTexture(cmd->sg_id);
             u8* buffer         = (u8*)CQ_ReadCommandGetOffset(cmd->buffer_offset);
-            R_Texture::load(&app->gctx, texture, buffer, cmd->buffer_len,
-                            cmd->flip_vertically, cmd->gen_mips);
+            R_Texture::load(texture, buffer, cmd->buffer_len, cmd->flip_vertically,
+                            cmd->gen_mips);
         } break;
         case SG_COMMAND_CUBEMAP_TEXTURE_FROM_FILE: {
             SG_Command_CubemapTextureFromFile* cmd
@@ -2266,7 +3399,7 @@ static void _R_HandleCommand(App* app, SG_Command* command)
               = (const char*)CQ_ReadCommandGetOffset(cmd->back_face_offset);
             const char* front_path
               = (const char*)CQ_ReadCommandGetOffset(cmd->front_face_offset);
-            R_Texture::loadCubemap(&app->gctx, texture, right_path, left_path, top_path,
+            R_Texture::loadCubemap(texture, right_path, left_path, top_path,
                                    bottom_path, back_path, front_path,
                                    cmd->flip_vertically);
         } break;
@@ -2302,7 +3435,14 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_COPY_TEXTURE_TO_CPU: {
             SG_Command_CopyTextureToCPU* cmd = (SG_Command_CopyTextureToCPU*)command;
             R_Texture* tex                   = Component_GetTexture(cmd->id);
-            WGPUBuffer mapped_buffer         = R_Texture::read(&app->gctx, tex);
+            if (G_isCompressedFormat(tex->desc.format)) {
+                log_warn("Texture[%d|%s] is compressed and can't be read back",
+                         tex->id, tex->name);
+                CQ_PushCommand_G2A_TextureRead(tex->id, NULL, 0,
+                                               WGPUBufferMapAsyncStatus_ValidationError);
+                break;
+            }
+            WGPUBuffer mapped_buffer = R_Texture::read(&app->gctx, tex);
 
             { // map buffer
                 auto onBufferMapped = [](WGPUBufferMapAsyncStatus status, void* udata) {
@@ -2357,7 +3497,13 @@ static void _R_HandleCommand(App* app, SG_Command* command)
         case SG_COMMAND_SAVE_TEXTURE: {
             SG_Command_SaveTexture* cmd = (SG_Command_SaveTexture*)command;
             R_Texture* tex              = Component_GetTexture(cmd->id);
-            WGPUBuffer mapped_buffer    = R_Texture::read(&app->gctx, tex);
+            if (G_isCompressedFormat(tex->desc.format)) {
+                log_error("Unable to save Texture %s: compressed textures can't be "
+                          "read back",
+                          tex->name);
+                break;
+            }
+            WGPUBuffer mapped_buffer = R_Texture::read(&app->gctx, tex);
 
             { // map buffer
                 int index                = 0;
@@ -2460,6 +3606,10 @@ static void _R_HandleCommand(App* app, SG_Command* command)
             SG_Command_WebcamUpdate* cmd = (SG_Command_WebcamUpdate*)command;
             R_Webcam::update(cmd);
         } break;
+        // audio tap ----------------------
+        case SG_COMMAND_AUDIO_TAP_UPDATE: {
+            R_AudioTap::update((SG_Command_AudioTapUpdate*)command);
+        } break;
         default: {
             log_error("unhandled command type: %d", command->type);
             ASSERT(false);
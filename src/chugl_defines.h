@@ -7,15 +7,64 @@
 #define CHUGL_MATERIAL_MAX_BINDINGS 32 // @group(1) @binding(0 - 31)
 #define CHUGL_MAX_BINDGROUPS 4
 
+// material uniforms are bound with dynamic offsets into the shared uniform pool.
+// Matches WebGPU's default maxDynamicUniformBuffersPerPipelineLayout, shaders with
+// more @group(1) uniforms than this bind them with static offsets instead
+#define CHUGL_MAX_DYNAMIC_UNIFORM_BUFFERS 8
+
 // how many frames does a bindgroup need to be unused before we evict it from our
 // rendergraph cache
 #define CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED 30
 #define CHUGL_CACHE_TEXTURE_VIEW_FRAMES_TILL_EXPIRED 30
 
+// materials, passes and geometry keep their bindgroups across frames, one per
+// pipeline layout they are drawn with. see G_BindGroupSlots
+#define CHUGL_BINDGROUP_SLOT_WAYS 8
+
+// rendergraph transient textures (e.g. scenepass depth buffers) are pooled and
+// reused across frames. Pooled textures unused for this many frames are released
+#define CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES 64 // color + depth per pass
+#define CHUGL_RENDERGRAPH_TRANSIENT_FRAMES_TILL_EXPIRED 8
+
 #define CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS 4 // @group(4) storage buffers
+#define CHUGL_GEOMETRY_MAX_LODS 4 // detail levels below a geometry, see mesh_lod.h
 
 #define CHUGL_COMPUTE_ENTRY_POINT "main"
 
+// with GScene.gpuCulling(), primitives with at least this many instances are culled
+// by a compute pass and drawn indirectly. see instance_cull.h
+#define CHUGL_GPU_CULL_MIN_INSTANCES 64
+
+// scene pass draws are recorded on up to this many threads (the render thread
+// included), in chunks of at least CHUGL_DRAW_JOBS_MIN_CHUNK primitives. Fewer
+// primitives than that are recorded on the render thread. see draw_jobs.h
+#define CHUGL_DRAW_JOBS_MAX_THREADS 8
+#define CHUGL_DRAW_JOBS_MIN_CHUNK 256
+
+// per-frame time budgets for destroying components, so dropping a large scene is
+// spread across frames instead of stalling one. see destroy_queue.h
+#define CHUGL_GC_BUDGET_MS 1.0      // audio thread, releasing ChucK objects
+#define CHUGL_DESTROY_BUDGET_MS 2.0 // render thread, freeing R_ components
+
+// image files are decoded on this many worker threads and uploaded to the GPU at
+// most CHUGL_TEXTURE_UPLOAD_BUDGET_BYTES per frame. see texture_stream.h
+#define CHUGL_TEXTURE_STREAM_THREADS 2
+#define CHUGL_TEXTURE_UPLOAD_BUDGET_BYTES (16 * 1024 * 1024)
+
+// GG.record() copies frames into a ring of this many readback buffers, encoded
+// on CHUGL_RECORD_THREADS workers. see frame_capture.h
+#define CHUGL_RECORD_READBACK_SLOTS 6
+#define CHUGL_RECORD_THREADS 4
+
+// GG.profile() reads GPU pass times back through a ring of this many buffers, and
+// GG.trace() records at most CHUGL_PROFILER_TRACE_MAX_EVENTS zones. see profiler.h
+#define CHUGL_PROFILER_GPU_READBACK_SLOTS 3
+#define CHUGL_PROFILER_TRACE_MAX_EVENTS (1 << 20)
+
+// with GG.input() listened to in pipelined mode, the render thread polls input
+// this often while waiting on chuck. see input_stream.h
+#define CHUGL_INPUT_POLL_INTERVAL_MS 1.0
+
 // shadow stuff
 #define CHUGL_SPOT_SHADOWMAP_DEFAULT_DIM 512
 #define CHUGL_DIR_SHADOWMAP_DEFAULT_DIM 1024
@@ -0,0 +1,232 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "command_stream.h"
+
+#include "core/memory.h"
+
+#include <string.h>
+
+static_assert(sizeof(CommandStreamHeader) % 8 == 0, "command stream header");
+static_assert(sizeof(CommandStreamFrameHeader) % 8 == 0, "command stream frame");
+
+#define COMMAND_STREAM_PAD8(n) (((n) + 7) & ~(u64)7)
+
+static const u8 _command_stream_zeros[8] = {};
+
+static bool _CommandStream_Write(CommandStreamWriter* writer, const void* data,
+                                 u64 size)
+{
+    if (size == 0) return true;
+    if (fwrite(data, 1, size, writer->file) != size) return false;
+    writer->bytes_written += size;
+    return true;
+}
+
+// writes `size` bytes, then zeros up to the next multiple of 8
+static bool _CommandStream_WritePadded(CommandStreamWriter* writer, const void* data,
+                                       u64 size)
+{
+    return _CommandStream_Write(writer, data, size)
+           && _CommandStream_Write(writer, _command_stream_zeros,
+                                   COMMAND_STREAM_PAD8(size) - size);
+}
+
+bool CommandStream_Open(CommandStreamWriter* writer, const char* path, u32 tag,
+                        int width, int height)
+{
+    *writer      = {};
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+
+    CommandStreamHeader header = {};
+    memcpy(header.magic, COMMAND_STREAM_MAGIC, sizeof(header.magic));
+    header.version = COMMAND_STREAM_VERSION;
+    header.tag     = tag;
+    header.width   = width;
+    header.height  = height;
+    if (!_CommandStream_Write(writer, &header, sizeof(header))) {
+        CommandStream_Close(writer);
+        writer->failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool CommandStream_WriteFrame(CommandStreamWriter* writer, f64 time,
+                              const void* commands, u64 command_bytes,
+                              const CommandStreamAttachment* attachments,
+                              u32 attachment_count)
+{
+    if (!writer->file) return false;
+
+    CommandStreamFrameHeader frame = {};
+    frame.magic                    = COMMAND_STREAM_FRAME_MAGIC;
+    frame.attachment_count         = attachment_count;
+    frame.time                     = time;
+    frame.command_bytes            = command_bytes;
+    for (u32 i = 0; i < attachment_count; i++) {
+        ASSERT(attachments[i].patch_offset + sizeof(void*) <= command_bytes);
+        frame.attachment_bytes
+          += 2 * sizeof(u64) + COMMAND_STREAM_PAD8(attachments[i].size);
+    }
+
+    bool ok = _CommandStream_Write(writer, &frame, sizeof(frame))
+              && _CommandStream_WritePadded(writer, commands, command_bytes);
+    for (u32 i = 0; ok && i < attachment_count; i++) {
+        u64 record[2] = { attachments[i].patch_offset, attachments[i].size };
+        ok            = _CommandStream_Write(writer, record, sizeof(record))
+             && _CommandStream_WritePadded(writer, attachments[i].data,
+                                           attachments[i].size);
+    }
+
+    if (!ok) {
+        CommandStream_Close(writer);
+        writer->failed = true;
+        return false;
+    }
+    ++writer->frame_count;
+    return true;
+}
+
+void CommandStream_Close(CommandStreamWriter* writer)
+{
+    if (writer->file) fclose(writer->file);
+    writer->file = NULL;
+}
+
+bool CommandStream_Load(CommandStreamReader* reader, const char* path)
+{
+    *reader    = {};
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    bool ok   = fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? ftell(file) : -1;
+    ok = size >= (long)sizeof(CommandStreamHeader) && fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        reader->size = (u64)size;
+        reader->data = ALLOCATE_BYTES(u8, reader->size);
+        ok           = fread(reader->data, 1, reader->size, file) == reader->size;
+    }
+    fclose(file);
+
+    if (ok) {
+        memcpy(&reader->header, reader->data, sizeof(reader->header));
+        ok = memcmp(reader->header.magic, COMMAND_STREAM_MAGIC, 8) == 0
+             && reader->header.version == COMMAND_STREAM_VERSION;
+    }
+    if (!ok) {
+        CommandStream_Free(reader);
+        return false;
+    }
+    reader->cursor = sizeof(CommandStreamHeader);
+    return true;
+}
+
+bool CommandStream_NextFrame(CommandStreamReader* reader, CommandStreamFrame* frame)
+{
+    *frame = {};
+    if (reader->corrupt || reader->cursor >= reader->size) return false;
+
+    // every length is checked against what's left, so nothing below reads past
+    // the end of the file
+    u64 left = reader->size - reader->cursor;
+    CommandStreamFrameHeader header;
+    if (left < sizeof(header)) {
+        reader->corrupt = true;
+        return false;
+    }
+    memcpy(&header, reader->data + reader->cursor, sizeof(header));
+    left -= sizeof(header);
+
+    // sizes are checked before padding, which could overflow
+    if (header.magic != COMMAND_STREAM_FRAME_MAGIC || header.command_bytes > left
+        || COMMAND_STREAM_PAD8(header.command_bytes) > left
+        || header.attachment_bytes > left - COMMAND_STREAM_PAD8(header.command_bytes)) {
+        reader->corrupt = true;
+        return false;
+    }
+
+    u64 commands_padded = COMMAND_STREAM_PAD8(header.command_bytes);
+    u8* commands        = reader->data + reader->cursor + sizeof(header);
+    u8* attachment = commands + commands_padded;
+    u64 att_left   = header.attachment_bytes;
+    for (u32 i = 0; i < header.attachment_count; i++) {
+        u64 record[2];
+        if (att_left < sizeof(record)) {
+            reader->corrupt = true;
+            return false;
+        }
+        memcpy(record, attachment, sizeof(record));
+        att_left -= sizeof(record);
+        if (header.command_bytes < sizeof(void*)
+            || record[0] > header.command_bytes - sizeof(void*)
+            || record[1] > att_left || COMMAND_STREAM_PAD8(record[1]) > att_left) {
+            reader->corrupt = true;
+            return false;
+        }
+        att_left -= COMMAND_STREAM_PAD8(record[1]);
+        attachment += sizeof(record) + COMMAND_STREAM_PAD8(record[1]);
+    }
+    if (att_left != 0) {
+        reader->corrupt = true;
+        return false;
+    }
+
+    frame->time             = header.time;
+    frame->commands         = commands;
+    frame->command_bytes    = header.command_bytes;
+    frame->attachment_count = header.attachment_count;
+    frame->_attachment      = commands + commands_padded;
+
+    reader->cursor += sizeof(header) + commands_padded + header.attachment_bytes;
+    ++reader->frame_count;
+    return true;
+}
+
+bool CommandStream_NextAttachment(CommandStreamFrame* frame,
+                                  CommandStreamAttachment* attachment)
+{
+    if (frame->_attachment_idx >= frame->attachment_count) return false;
+
+    u64 record[2];
+    memcpy(record, frame->_attachment, sizeof(record));
+    attachment->patch_offset = record[0];
+    attachment->size         = record[1];
+    attachment->data         = frame->_attachment + sizeof(record);
+
+    frame->_attachment += sizeof(record) + COMMAND_STREAM_PAD8(record[1]);
+    ++frame->_attachment_idx;
+    return true;
+}
+
+void CommandStream_Free(CommandStreamReader* reader)
+{
+    FREE(reader->data);
+    *reader = {};
+}
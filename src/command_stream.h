@@ -0,0 +1,144 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+#include <stdio.h>
+
+/*
+Command stream capture
+
+Everything chuck does to graphics reaches the render thread as SG_Commands in
+the audio to graphics command queue (see sg_command.h). Every frame the render
+thread drains one buffer of it: commands packed back to back, each pointing at
+the next by byte offset, with variable sized payloads (strings, texels, buffer
+data) stored inline and referenced by offset too. A frame's buffer is position
+independent, so it can be written out as is and handed back to the same command
+handler later, without chuck.
+
+The exception is data passed by pointer, like the refcounted geometry blocks.
+Each such pointer is captured as an attachment: the bytes it points to and the
+offset of the pointer within the frame, for whoever reads it back to allocate a
+copy and patch the pointer.
+
+File layout, in the byte order of the machine that wrote it:
+
+    CommandStreamHeader
+    per frame:
+        CommandStreamFrameHeader
+        commands, padded to 8 bytes
+        per attachment: patch offset (u64), size (u64), bytes padded to 8
+
+Commands are stored as the queue holds them, so a capture is only readable by a
+build with the same command layout. `tag` is the writer's to check that.
+
+Knows nothing about SG_Command, so it can be tested on the CPU.
+*/
+
+#define COMMAND_STREAM_MAGIC "CHUGLCMD"
+#define COMMAND_STREAM_VERSION 1
+#define COMMAND_STREAM_FRAME_MAGIC 0x4d415246 // "FRAM"
+
+struct CommandStreamHeader {
+    char magic[8]; // COMMAND_STREAM_MAGIC, not null terminated
+    u32 version;
+    u32 tag;           // caller defined, e.g. the command layout
+    i32 width, height; // framebuffer size when captured
+};
+
+struct CommandStreamFrameHeader {
+    u32 magic; // COMMAND_STREAM_FRAME_MAGIC, catches a corrupt file early
+    u32 attachment_count;
+    f64 time;             // seconds, of the frame being captured
+    u64 command_bytes;    // unpadded
+    u64 attachment_bytes; // all attachment records, padded
+};
+
+struct CommandStreamAttachment {
+    u64 patch_offset; // of the pointer, from the start of the frame's commands
+    u64 size;
+    const void* data;
+};
+
+struct CommandStreamWriter {
+    FILE* file;
+    u64 frame_count;
+    u64 bytes_written;
+    bool failed; // a write failed, the file is closed and frames are ignored
+};
+
+struct CommandStreamFrame {
+    f64 time;
+    u8* commands; // 8 byte aligned, inside the reader's buffer
+    u64 command_bytes;
+    u32 attachment_count;
+
+    // next attachment record, see CommandStream_NextAttachment
+    u8* _attachment;
+    u32 _attachment_idx;
+};
+
+struct CommandStreamReader {
+    CommandStreamHeader header;
+    u8* data; // the whole file
+    u64 size;
+    u64 cursor;      // start of the next frame
+    u64 frame_count; // frames read so far
+    bool corrupt;    // stopped at a frame that doesn't fit the file
+};
+
+// writer ---------------------------------------------------------------------
+
+bool CommandStream_Open(CommandStreamWriter* writer, const char* path, u32 tag,
+                        int width, int height);
+
+// one frame's commands, and the data behind the pointers among them
+bool CommandStream_WriteFrame(CommandStreamWriter* writer, f64 time,
+                              const void* commands, u64 command_bytes,
+                              const CommandStreamAttachment* attachments,
+                              u32 attachment_count);
+
+void CommandStream_Close(CommandStreamWriter* writer);
+
+// reader ---------------------------------------------------------------------
+
+// reads the whole file. False if it can't be read or isn't a command stream of
+// this version. Tags are not checked
+bool CommandStream_Load(CommandStreamReader* reader, const char* path);
+
+// the next frame, false at the end of the file or at a frame that runs past it
+// (sets `corrupt`). Frames stay valid until CommandStream_Free
+bool CommandStream_NextFrame(CommandStreamReader* reader, CommandStreamFrame* frame);
+
+// the frame's attachments in the order they were written. Patch offsets have
+// been checked to fit a pointer within the commands
+bool CommandStream_NextAttachment(CommandStreamFrame* frame,
+                                  CommandStreamAttachment* attachment);
+
+void CommandStream_Free(CommandStreamReader* reader);
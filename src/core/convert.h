@@ -0,0 +1,70 @@
+#pragma once
+
+#include "core/macros.h"
+
+#include <simde/x86/sse2.h>
+
+/*
+Bulk format conversion from chuck's native f64 to GPU-ready formats.
+
+ChucK floats are 64-bit, but vertex buffers and textures want f32 or unorm8.
+These run over contiguous staging buffers (e.g. gathered from a Chuck_ArrayFloat)
+and are SIMD'd with simde so the same code path vectorizes on both x86_64 (SSE2)
+and arm64 (NEON) slices of the universal binary.
+
+unorm8 conversion matches the original scalar texture write path:
+    (u8)(255 * CLAMP(x, 0, 1))
+i.e. truncation, NOT round-to-nearest, so output is bit-identical to before.
+*/
+
+// f64 --> f32
+inline void CV_F64ToF32(const f64* src, f32* dst, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        simde__m128 lo = simde_mm_cvtpd_ps(simde_mm_loadu_pd(src + i));
+        simde__m128 hi = simde_mm_cvtpd_ps(simde_mm_loadu_pd(src + i + 2));
+        simde_mm_storeu_ps(dst + i, simde_mm_movelh_ps(lo, hi));
+    }
+
+    // remainder
+    for (; i < count; i++) dst[i] = (f32)src[i];
+}
+
+// f64 in [0, 1] --> u8 in [0, 255]. Out of range values are clamped.
+inline void CV_F64ToUnorm8(const f64* src, u8* dst, int count)
+{
+    const simde__m128d zero  = simde_mm_setzero_pd();
+    const simde__m128d one   = simde_mm_set1_pd(1.0);
+    const simde__m128d scale = simde_mm_set1_pd(255.0);
+
+// 4 x f64 --> 4 x i32
+#define CV_UNORM8_CVT4(offset)                                                         \
+    simde_mm_unpacklo_epi64(                                                           \
+      simde_mm_cvttpd_epi32(simde_mm_mul_pd(                                           \
+        simde_mm_min_pd(simde_mm_max_pd(simde_mm_loadu_pd(src + i + (offset)), zero),  \
+                        one),                                                          \
+        scale)),                                                                       \
+      simde_mm_cvttpd_epi32(simde_mm_mul_pd(                                           \
+        simde_mm_min_pd(                                                               \
+          simde_mm_max_pd(simde_mm_loadu_pd(src + i + (offset) + 2), zero), one),      \
+        scale)))
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        simde__m128i a = CV_UNORM8_CVT4(0);
+        simde__m128i b = CV_UNORM8_CVT4(4);
+        simde__m128i c = CV_UNORM8_CVT4(8);
+        simde__m128i d = CV_UNORM8_CVT4(12);
+
+        // i32 --> i16 --> u8 (values already in [0, 255], saturation is a no-op)
+        simde__m128i ab   = simde_mm_packs_epi32(a, b);
+        simde__m128i cd   = simde_mm_packs_epi32(c, d);
+        simde__m128i abcd = simde_mm_packus_epi16(ab, cd);
+        simde_mm_storeu_si128((simde__m128i*)(dst + i), abcd);
+    }
+#undef CV_UNORM8_CVT4
+
+    // remainder
+    for (; i < count; i++) dst[i] = (u8)(UINT8_MAX * CLAMP(src[i], 0.0, 1.0));
+}
@@ -0,0 +1,787 @@
+/*
+ * Copyright (c) 2020 rxi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#define MAX_CALLBACKS 32
+
+/*
+Asynchronous logging
+
+With log_set_async(true), log_log never formats or writes on the calling thread.
+It copies the format pointer, the arguments (and the characters of %s strings,
+which may not outlive the call) and a timestamp into a record in a single
+producer ring owned by the calling thread, and returns. A background thread
+merges the rings in timestamp order, formats each record and writes it.
+
+A full ring drops the record and counts it; the background thread reports the
+count. Formats it can't capture (%n, %*, long double, too many arguments) are
+formatted into the record on the calling thread instead, still without I/O.
+LOG_FATAL is written synchronously, after everything before it.
+
+Format strings must outlive the log call, as string literals from the log_*
+macros do.
+*/
+
+#define LOG_RING_CAPACITY 256 // records per thread
+#define LOG_MAX_THREADS 32    // threads logging at once, more log synchronously
+#define LOG_MAX_ARGS 12
+#define LOG_RECORD_TEXT 384 // bytes of copied strings per record
+#define LOG_MESSAGE_MAX 1024
+#define LOG_FLUSH_INTERVAL_MS 2
+
+typedef struct {
+    log_LogFn fn;
+    void* udata;
+    int level;
+} Callback;
+
+static struct {
+    void* udata;
+    log_LockFn lock;
+    int level;
+    bool quiet;
+    Callback callbacks[MAX_CALLBACKS];
+} L;
+
+static const char* level_strings[]
+  = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
+
+#ifdef LOG_USE_COLOR
+static const char* level_colors[]
+  = { "\x1b[94m", "\x1b[36m", "\x1b[32m", "\x1b[33m", "\x1b[31m", "\x1b[35m" };
+#endif
+
+static void stdout_callback(log_Event* ev)
+{
+    FILE* fp = (FILE*)ev->udata;
+    char buf[16];
+    buf[strftime(buf, sizeof(buf), "%H:%M:%S", ev->time)] = '\0';
+#ifdef LOG_USE_COLOR
+#ifdef CHUGL_RELEASE
+    // remove file, time, and line number from logs in release mode
+    fprintf(fp, "[ChuGL]: %s%-5s\x1b[0m", level_colors[ev->level],
+            level_strings[ev->level]);
+#else  // CHUGL_RELEASE
+    fprintf(fp, "[ChuGL]: %s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m", buf,
+            level_colors[ev->level], level_strings[ev->level], ev->file, ev->line);
+#endif // CHUGL_RELEASE
+#else
+    fprintf(fp, "[ChuGL]: %s %-5s %s:%d: ", buf, level_strings[ev->level], ev->file,
+            ev->line);
+#endif
+    vfprintf(fp, ev->fmt, ev->ap);
+    fprintf(fp, "\n");
+    fflush(fp);
+}
+
+static void file_callback(log_Event* ev)
+{
+    FILE* fp = (FILE*)ev->udata;
+    char buf[64];
+    buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", ev->time)] = '\0';
+    fprintf(fp, "%s %-5s %s:%d: ", buf, level_strings[ev->level], ev->file,
+            ev->line);
+    vfprintf(fp, ev->fmt, ev->ap);
+    fprintf(fp, "\n");
+    fflush(fp);
+}
+
+static void lock(void)
+{
+    if (L.lock) {
+        L.lock(true, L.udata);
+    }
+}
+
+static void unlock(void)
+{
+    if (L.lock) {
+        L.lock(false, L.udata);
+    }
+}
+
+const char* log_level_string(int level)
+{
+    return level_strings[level];
+}
+
+void log_set_lock(log_LockFn fn, void* udata)
+{
+    L.lock  = fn;
+    L.udata = udata;
+}
+
+void log_set_level(int level)
+{
+    L.level = level;
+}
+
+void log_set_quiet(bool enable)
+{
+    L.quiet = enable;
+}
+
+int log_add_callback(log_LogFn fn, void* udata, int level)
+{
+    for (int i = 0; i < MAX_CALLBACKS; i++) {
+        if (!L.callbacks[i].fn) {
+            L.callbacks[i] = { fn, udata, level };
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int log_add_fp(FILE* fp, int level)
+{
+    return log_add_callback(file_callback, fp, level);
+}
+
+static void init_event(log_Event* ev, void* udata, time_t t)
+{
+    if (!ev->time) ev->time = localtime(&t);
+    ev->udata = udata;
+}
+
+// true if stderr or a callback would take a message of this level
+static bool accepts(int level)
+{
+    if (!L.quiet && level >= L.level) return true;
+    for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+        if (level >= L.callbacks[i].level) return true;
+    }
+    return false;
+}
+
+static void emit(log_Event* ev, time_t t, const char* fmt, va_list ap)
+{
+    ev->fmt = fmt;
+    lock();
+
+    if (!L.quiet && ev->level >= L.level) {
+        init_event(ev, stderr, t);
+        va_copy(ev->ap, ap);
+        stdout_callback(ev);
+        va_end(ev->ap);
+    }
+
+    for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+        Callback* cb = &L.callbacks[i];
+        if (ev->level >= cb->level) {
+            init_event(ev, cb->udata, t);
+            va_copy(ev->ap, ap);
+            cb->fn(ev);
+            va_end(ev->ap);
+        }
+    }
+
+    unlock();
+}
+
+static void emit_message(log_Event* ev, time_t t, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    emit(ev, t, fmt, ap);
+    va_end(ap);
+}
+
+// ============================================================================
+// Argument capture
+// ============================================================================
+
+enum LogArgType {
+    LOG_ARG_NONE = 0, // %%
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+    LOG_ARG_UNSUPPORTED,
+};
+
+typedef struct {
+    const char* begin; // the '%'
+    const char* end;   // past the conversion
+    const char* length_begin;
+    const char* length_end;
+    char length[3]; // "", "hh", "l", "ll", "z", ...
+    char conversion;
+    LogArgType type;
+} LogSpec;
+
+// parses the conversion starting at the '%' at `p`
+static void parse_spec(const char* p, LogSpec* spec)
+{
+    *spec       = {};
+    spec->begin = p++;
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') spec->type = LOG_ARG_UNSUPPORTED;
+    while ((*p >= '0' && *p <= '9') || *p == '*') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') spec->type = LOG_ARG_UNSUPPORTED;
+        while ((*p >= '0' && *p <= '9') || *p == '*') p++;
+    }
+    spec->length_begin = p;
+    while (*p && strchr("hlLqjzt", *p) && p - spec->length_begin < 2) p++;
+    spec->length_end = p;
+    memcpy(spec->length, spec->length_begin, spec->length_end - spec->length_begin);
+    spec->conversion = *p;
+    spec->end        = *p ? p + 1 : p;
+    if (spec->type == LOG_ARG_UNSUPPORTED) return;
+
+    switch (spec->conversion) {
+        case '%': spec->type = LOG_ARG_NONE; break;
+        case 'd':
+        case 'i': spec->type = LOG_ARG_INT; break;
+        case 'c':
+            spec->type = spec->length[0] ? LOG_ARG_UNSUPPORTED : LOG_ARG_INT;
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': spec->type = LOG_ARG_UINT; break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec->type = spec->length[0] == 'L' ? LOG_ARG_UNSUPPORTED : LOG_ARG_DOUBLE;
+            break;
+        case 'p': spec->type = LOG_ARG_PTR; break;
+        case 's':
+            spec->type = spec->length[0] ? LOG_ARG_UNSUPPORTED : LOG_ARG_STR;
+            break;
+        default: spec->type = LOG_ARG_UNSUPPORTED; break; // %n, wide chars, ...
+    }
+}
+
+static long long read_int(const char* length, va_list* ap)
+{
+    if (strcmp(length, "l") == 0) return va_arg(*ap, long);
+    if (strcmp(length, "ll") == 0 || strcmp(length, "q") == 0)
+        return va_arg(*ap, long long);
+    if (strcmp(length, "z") == 0) return (long long)va_arg(*ap, size_t);
+    if (strcmp(length, "j") == 0) return va_arg(*ap, intmax_t);
+    if (strcmp(length, "t") == 0) return va_arg(*ap, ptrdiff_t);
+    return va_arg(*ap, int); // hh and h are promoted
+}
+
+static unsigned long long read_uint(const char* length, va_list* ap)
+{
+    if (strcmp(length, "l") == 0) return va_arg(*ap, unsigned long);
+    if (strcmp(length, "ll") == 0 || strcmp(length, "q") == 0)
+        return va_arg(*ap, unsigned long long);
+    if (strcmp(length, "z") == 0) return va_arg(*ap, size_t);
+    if (strcmp(length, "j") == 0) return va_arg(*ap, uintmax_t);
+    if (strcmp(length, "t") == 0) return (unsigned long long)va_arg(*ap, ptrdiff_t);
+    unsigned int v = va_arg(*ap, unsigned int);
+    if (strcmp(length, "hh") == 0) return (unsigned char)v;
+    if (strcmp(length, "h") == 0) return (unsigned short)v;
+    return v;
+}
+
+typedef union {
+    long long i;
+    unsigned long long u;
+    double f;
+    const void* p;
+    const char* s; // into LogRecord.text, or malloc'd when it doesn't fit
+} LogArg;
+
+typedef struct {
+    unsigned long long time_ns; // system clock
+    const char* fmt;
+    const char* file;
+    int line;
+    int level;
+    int arg_count;
+    unsigned int heap_args; // bit per malloc'd string, freed once written
+    char* formatted;        // the finished message instead of args, malloc'd
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_RECORD_TEXT];
+} LogRecord;
+
+// copies the arguments of `fmt` into `record`. false if it can't
+static bool capture_args(LogRecord* record, const char* fmt, va_list ap)
+{
+    va_list args;
+    va_copy(args, ap);
+    size_t text_used = 0;
+    bool ok          = true;
+    for (const char* p = strchr(fmt, '%'); p && ok; p = strchr(p, '%')) {
+        LogSpec spec;
+        parse_spec(p, &spec);
+        p = spec.end;
+        if (spec.type == LOG_ARG_NONE) continue;
+        if (spec.type == LOG_ARG_UNSUPPORTED || record->arg_count == LOG_MAX_ARGS) {
+            ok = false;
+            break;
+        }
+
+        LogArg* arg = record->args + record->arg_count++;
+        switch (spec.type) {
+            case LOG_ARG_INT: arg->i = read_int(spec.length, &args); break;
+            case LOG_ARG_UINT: arg->u = read_uint(spec.length, &args); break;
+            case LOG_ARG_DOUBLE: arg->f = va_arg(args, double); break;
+            case LOG_ARG_PTR: arg->p = va_arg(args, void*); break;
+            case LOG_ARG_STR: {
+                const char* str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                size_t size = strlen(str) + 1;
+                char* copy  = record->text + text_used;
+                if (text_used + size <= LOG_RECORD_TEXT) {
+                    text_used += size;
+                } else { // e.g. a shader compile error
+                    copy = (char*)malloc(size);
+                    if (!copy) {
+                        ok = false;
+                        break;
+                    }
+                    record->heap_args |= 1u << (record->arg_count - 1);
+                }
+                memcpy(copy, str, size);
+                arg->s = copy;
+            } break;
+            default: ok = false; break;
+        }
+    }
+    va_end(args);
+    return ok;
+}
+
+static void free_record(LogRecord* record)
+{
+    for (int i = 0; i < record->arg_count; i++) {
+        if (record->heap_args & (1u << i)) free((void*)record->args[i].s);
+    }
+    free(record->formatted);
+    record->heap_args = 0;
+    record->formatted = NULL;
+}
+
+static void capture(LogRecord* record, const char* fmt, va_list ap)
+{
+    record->arg_count = 0;
+    record->heap_args = 0;
+    record->formatted = NULL;
+    if (capture_args(record, fmt, ap)) return;
+
+    free_record(record);
+    va_list args;
+    va_copy(args, ap);
+    int size = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    record->formatted = (char*)malloc(size > 0 ? size + 1 : 1);
+    if (record->formatted) vsnprintf(record->formatted, size + 1, fmt, ap);
+}
+
+// growable message, only touched by the consumer
+typedef struct {
+    char* buf;
+    size_t cap;
+    size_t len;
+} LogMessage;
+
+static void message_reserve(LogMessage* m, size_t size)
+{
+    if (m->len + size + 1 <= m->cap) return;
+    size_t cap = m->cap ? m->cap : LOG_MESSAGE_MAX;
+    while (cap < m->len + size + 1) cap *= 2;
+    char* buf = (char*)realloc(m->buf, cap);
+    if (!buf) return;
+    m->buf = buf;
+    m->cap = cap;
+}
+
+#define message_append(m, conv, value)                                               \
+    do {                                                                               \
+        int n = snprintf(NULL, 0, conv, value);                                        \
+        if (n <= 0) break;                                                             \
+        message_reserve(m, n);                                                         \
+        if ((m)->len + n + 1 > (m)->cap) break;                                        \
+        snprintf((m)->buf + (m)->len, n + 1, conv, value);                             \
+        (m)->len += n;                                                                 \
+    } while (0)
+
+// formats the record the way vsnprintf would have, one conversion at a time
+static const char* format_record(const LogRecord* record, LogMessage* m)
+{
+    m->len = 0;
+    message_reserve(m, 0);
+    if (!m->buf) return "";
+    if (record->formatted) return record->formatted;
+
+    int arg = 0;
+    for (const char* p = record->fmt; *p;) {
+        if (*p != '%') {
+            message_reserve(m, 1);
+            if (m->len + 2 <= m->cap) m->buf[m->len++] = *p;
+            p++;
+            continue;
+        }
+
+        LogSpec spec;
+        parse_spec(p, &spec);
+        p = spec.end;
+        if (spec.type == LOG_ARG_NONE) {
+            message_append(m, "%s", "%");
+            continue;
+        }
+
+        // same flags, width and precision, with the value's captured width
+        char conv[32];
+        size_t head = spec.length_begin - spec.begin;
+        if (head > sizeof(conv) - 4) head = sizeof(conv) - 4;
+        memcpy(conv, spec.begin, head);
+        size_t c = head;
+        if (spec.type == LOG_ARG_INT || spec.type == LOG_ARG_UINT) {
+            if (spec.conversion != 'c') conv[c++] = 'l', conv[c++] = 'l';
+        }
+        conv[c++] = spec.conversion;
+        conv[c]   = '\0';
+
+        const LogArg* a = record->args + arg++;
+        switch (spec.type) {
+            case LOG_ARG_INT:
+                if (spec.conversion == 'c') message_append(m, conv, (int)a->i);
+                else message_append(m, conv, a->i);
+                break;
+            case LOG_ARG_UINT: message_append(m, conv, a->u); break;
+            case LOG_ARG_DOUBLE: message_append(m, conv, a->f); break;
+            case LOG_ARG_PTR: message_append(m, conv, a->p); break;
+            case LOG_ARG_STR: message_append(m, conv, a->s); break;
+            default: break;
+        }
+    }
+    m->buf[m->len] = '\0';
+    return m->buf;
+}
+
+// ============================================================================
+// Per thread rings
+// ============================================================================
+
+typedef struct {
+    LogRecord records[LOG_RING_CAPACITY];
+    std::atomic<unsigned long long> head; // written by the owning thread
+    std::atomic<unsigned long long> tail; // written by the consumer
+    std::atomic<unsigned long long> dropped;
+    unsigned long long dropped_reported; // consumer only
+    std::atomic<bool> owned;             // by a live thread
+} LogRing;
+
+static struct {
+    std::atomic<bool> enabled;
+    std::atomic<bool> stop;
+    std::atomic<LogRing*> rings[LOG_MAX_THREADS];
+    std::mutex consumer_lock; // draining, by the background thread or log_flush
+    std::atomic<bool> thread_running;
+} A;
+
+// releases the calling thread's ring when it exits, for a new thread to take
+struct LogThreadRing {
+    LogRing* ring;
+    bool claimed;
+
+    ~LogThreadRing()
+    {
+        if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local LogThreadRing log_thread_ring = {};
+
+static LogRing* thread_ring()
+{
+    LogThreadRing* tr = &log_thread_ring;
+    if (tr->claimed) return tr->ring;
+    tr->claimed = true; // once, a thread that finds no ring logs synchronously
+
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        LogRing* ring = A.rings[i].load(std::memory_order_acquire);
+        if (!ring) {
+            LogRing* fresh = new (std::nothrow) LogRing();
+            if (!fresh) return NULL;
+            fresh->owned.store(true, std::memory_order_relaxed);
+            if (A.rings[i].compare_exchange_strong(ring, fresh)) {
+                tr->ring = fresh;
+                return fresh;
+            }
+            delete fresh; // another thread took the slot, `ring` is now theirs
+        }
+        bool owned = false;
+        if (ring->owned.compare_exchange_strong(owned, true)) {
+            tr->ring = ring;
+            return ring;
+        }
+    }
+    return NULL;
+}
+
+// oldest record across every ring, NULL if all are empty
+static LogRing* oldest_ring()
+{
+    LogRing* oldest              = NULL;
+    unsigned long long oldest_ns = 0;
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        LogRing* ring = A.rings[i].load(std::memory_order_acquire);
+        if (!ring) break;
+        unsigned long long tail = ring->tail.load(std::memory_order_relaxed);
+        if (tail == ring->head.load(std::memory_order_acquire)) continue;
+        unsigned long long ns = ring->records[tail % LOG_RING_CAPACITY].time_ns;
+        if (!oldest || ns < oldest_ns) {
+            oldest    = ring;
+            oldest_ns = ns;
+        }
+    }
+    return oldest;
+}
+
+static void write_record(LogRecord* record)
+{
+    static LogMessage message = {}; // under consumer_lock
+    log_Event ev              = {};
+    ev.file                   = record->file;
+    ev.line                   = record->line;
+    ev.level                  = record->level;
+    emit_message(&ev, (time_t)(record->time_ns / 1000000000ull), "%s",
+                 format_record(record, &message));
+    free_record(record);
+}
+
+static void drain()
+{
+    std::lock_guard<std::mutex> guard(A.consumer_lock);
+    for (LogRing* ring = oldest_ring(); ring; ring = oldest_ring()) {
+        unsigned long long tail = ring->tail.load(std::memory_order_relaxed);
+        write_record(ring->records + tail % LOG_RING_CAPACITY);
+        ring->tail.store(tail + 1, std::memory_order_release);
+    }
+
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        LogRing* ring = A.rings[i].load(std::memory_order_acquire);
+        if (!ring) break;
+        unsigned long long dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped == ring->dropped_reported) continue;
+        LogRecord record = {};
+        record.time_ns   = (unsigned long long)std::chrono::duration_cast<
+                           std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+        record.fmt       = "%llu log messages dropped, the log ring was full";
+        record.file      = __FILE__;
+        record.line      = __LINE__;
+        record.level     = LOG_WARN;
+        record.arg_count = 1;
+        record.args[0].u = dropped - ring->dropped_reported;
+        ring->dropped_reported = dropped;
+        write_record(&record);
+    }
+}
+
+static void consumer_main()
+{
+    for (;;) {
+        while (!A.stop.load()) {
+            drain();
+            std::this_thread::sleep_for(
+              std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS));
+        }
+        A.thread_running.store(false);
+        // turned back on while stopping, without starting another consumer
+        if (A.stop.load() || A.thread_running.exchange(true)) return;
+    }
+}
+
+static void log_atexit()
+{
+    log_set_async(false);
+    // the consumer runs code in this module, which may be unloaded next
+    for (int i = 0; i < 100 && A.thread_running.load(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void log_set_async(bool enable)
+{
+    if (enable == A.enabled.load()) return;
+
+    if (enable) {
+        // a consumer still finishing from before just keeps going
+        A.stop.store(false);
+        if (!A.thread_running.exchange(true)) {
+            // detached: joining from an atexit handler can deadlock on unload
+            std::thread(consumer_main).detach();
+            static bool registered = false;
+            if (!registered) atexit(log_atexit);
+            registered = true;
+        }
+        A.enabled.store(true);
+    } else {
+        A.enabled.store(false);
+        A.stop.store(true);
+        drain(); // what's left, here and now
+    }
+}
+
+void log_flush(void)
+{
+    drain();
+}
+
+unsigned long long log_dropped(void)
+{
+    unsigned long long dropped = 0;
+    for (int i = 0; i < LOG_MAX_THREADS; i++) {
+        LogRing* ring = A.rings[i].load(std::memory_order_acquire);
+        if (!ring) break;
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+static void log_sync(int level, const char* file, int line, const char* fmt,
+                     va_list ap)
+{
+    log_Event ev = {};
+    ev.file      = file;
+    ev.line      = line;
+    ev.level     = level;
+    emit(&ev, time(NULL), fmt, ap);
+}
+
+void log_log(int level, const char* file, int line, const char* fmt, ...)
+{
+    if (!accepts(level)) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+
+    LogRing* ring = NULL;
+    if (A.enabled.load(std::memory_order_relaxed) && level < LOG_FATAL) {
+        ring = thread_ring();
+    }
+
+    if (!ring) {
+        // fatal errors are written before the caller goes down, after the rest
+        if (A.enabled.load(std::memory_order_relaxed)) drain();
+        log_sync(level, file, line, fmt, ap);
+    } else {
+        unsigned long long head = ring->head.load(std::memory_order_relaxed);
+        unsigned long long tail = ring->tail.load(std::memory_order_acquire);
+        if (head - tail == LOG_RING_CAPACITY) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            LogRecord* record = ring->records + head % LOG_RING_CAPACITY;
+            auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+            record->time_ns  = (unsigned long long)
+              std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+            record->fmt   = fmt;
+            record->file  = file;
+            record->line  = line;
+            record->level = level;
+            capture(record, fmt, ap);
+            ring->head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    va_end(ap);
+}
+
+void hexDump(const char* desc, const void* addr, const int len)
+{
+#define perLine 16
+
+    int i;
+    unsigned char buff[perLine + 1];
+    const unsigned char* pc = (const unsigned char*)addr;
+
+    // Output description if given.
+
+    if (desc != NULL) printf("%s:\n", desc);
+
+    // Length checks.
+
+    if (len == 0) {
+        printf("  ZERO LENGTH\n");
+        return;
+    }
+    if (len < 0) {
+        printf("  NEGATIVE LENGTH: %d\n", len);
+        return;
+    }
+
+    // Process every byte in the data.
+
+    for (i = 0; i < len; i++) {
+        // Multiple of perLine means new or first line (with line offset).
+
+        if ((i % perLine) == 0) {
+            // Only print previous-line ASCII buffer for lines beyond first.
+
+            if (i != 0) printf("  %s\n", buff);
+
+            // Output the offset of current line.
+
+            printf("  %04x ", i);
+        }
+
+        // Now the hex code for the specific character.
+
+        printf(" %02x", pc[i]);
+
+        // And buffer a printable ASCII character for later.
+
+        if ((pc[i] < 0x20) || (pc[i] > 0x7e)) // isprint() may be better.
+            buff[i % perLine] = '.';
+        else
+            buff[i % perLine] = pc[i];
+        buff[(i % perLine) + 1] = '\0';
+    }
+
+    // Pad out last line if not exactly perLine characters.
+
+    while ((i % perLine) != 0) {
+        printf("   ");
+        i++;
+    }
+
+    // And print the final ASCII buffer.
+
+    printf("  %s\n", buff);
+    #undef perLine
+}
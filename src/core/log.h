@@ -2,7 +2,7 @@
  * Copyright (c) 2020 rxi
  *
  * This library is free software; you can redistribute it and/or modify it
- * under the terms of the MIT license. See `log.c` for details.
+ * under the terms of the MIT license. See `log.cpp` for details.
  */
 
 #pragma once
@@ -29,12 +29,23 @@ typedef void (*log_LockFn)(bool lock, void* udata);
 
 enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 
-#define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define log_info(...) log_log(LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...) log_log(LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
-#define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+// calls below this level compile to nothing (their arguments are still type
+// checked). e.g. -DLOG_COMPILE_LEVEL=2 keeps info and up
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+#define LOG_AT(level, ...)                                                             \
+    ((level) >= LOG_COMPILE_LEVEL ?                                                    \
+       log_log(level, __FILE__, __LINE__, __VA_ARGS__) :                               \
+       (void)0)
+
+#define log_trace(...) LOG_AT(LOG_TRACE, __VA_ARGS__)
+#define log_debug(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+#define log_info(...) LOG_AT(LOG_INFO, __VA_ARGS__)
+#define log_warn(...) LOG_AT(LOG_WARN, __VA_ARGS__)
+#define log_error(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+#define log_fatal(...) LOG_AT(LOG_FATAL, __VA_ARGS__)
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +60,15 @@ int log_add_fp(FILE* fp, int level);
 
 void log_log(int level, const char* file, int line, const char* fmt, ...);
 
+// Asynchronous logging: log calls only copy their arguments into a lock free
+// ring of the calling thread, and a background thread formats and writes them,
+// so the audio thread never waits on I/O. Off by default. See log.cpp
+void log_set_async(bool enable);
+// writes every message logged so far, on the calling thread
+void log_flush(void);
+// messages dropped because a thread's ring was full
+unsigned long long log_dropped(void);
+
 // Usage:
 //     hexDump(desc, addr, len, perLine);
 //         desc:    if non-NULL, printed as a description before hex dump.
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+/*
+Double-buffered seqlock for one writer publishing a small struct to any number of
+readers.
+
+The writer never waits. It writes into the slot readers are not being pointed at,
+then flips the version to it. Readers never take a lock and never make the writer
+wait: they copy the latest slot and check its sequence number didn't change while
+copying. A read only retries if the writer published twice in the middle of it,
+which for state published a few times per frame doesn't happen in practice.
+
+Data is held in relaxed atomic words rather than a plain T, so racing copies are
+well defined (and quiet under ThreadSanitizer). T must be trivially copyable.
+
+Reads can copy the whole struct, or a single field with seqlock_read_field, so a
+getter for 2 floats doesn't copy a whole keyboard.
+*/
+
+template <typename T>
+struct seqlock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "seqlock data must be trivially copyable");
+
+    static constexpr size_t WORDS
+      = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct slot {
+        // 2 * version once written, odd while writing
+        std::atomic<uint64_t> seq = { 0 };
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    slot slots[2];
+    // of the latest publish, in slots[version & 1]
+    std::atomic<uint64_t> version = { 0 };
+
+    seqlock()
+    {
+        T empty = {};
+        write(this, &empty);
+    }
+
+    explicit seqlock(const T& init)
+    {
+        write(this, &init);
+    }
+
+    // single writer
+    static void write(seqlock* lock, const T* data) noexcept
+    {
+        uint64_t buf[WORDS] = {};
+        memcpy(buf, data, sizeof(T));
+
+        uint64_t v = lock->version.load(std::memory_order_relaxed) + 1;
+        slot* s    = &lock->slots[v & 1];
+        s->seq.store(2 * v - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            s->words[i].store(buf[i], std::memory_order_relaxed);
+        s->seq.store(2 * v, std::memory_order_release);
+        lock->version.store(v, std::memory_order_release);
+    }
+
+    // copies `count` words starting at `first` of the latest publish. Returns its
+    // version
+    static uint64_t read_words(const seqlock* lock, size_t first, size_t count,
+                               uint64_t* out) noexcept
+    {
+        for (;;) {
+            uint64_t v     = lock->version.load(std::memory_order_acquire);
+            const slot* s  = &lock->slots[v & 1];
+            uint64_t begin = s->seq.load(std::memory_order_acquire);
+            if (begin != 2 * v) continue; // overwritten since, start over
+
+            for (size_t i = 0; i < count; i++)
+                out[i] = s->words[first + i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->seq.load(std::memory_order_relaxed) == begin) return v;
+        }
+    }
+
+    static uint64_t read(const seqlock* lock, T* out) noexcept
+    {
+        uint64_t buf[WORDS];
+        uint64_t v = read_words(lock, 0, WORDS, buf);
+        memcpy(out, buf, sizeof(T));
+        return v;
+    }
+
+    // `size` bytes at `offset` into T. Through seqlock_read_field
+    template <size_t SIZE>
+    static void read_bytes(const seqlock* lock, size_t offset, void* out) noexcept
+    {
+        static_assert(SIZE <= sizeof(T), "read past the end of the data");
+        uint64_t buf[SIZE / sizeof(uint64_t) + 2];
+        size_t first = offset / sizeof(uint64_t);
+        size_t last  = (offset + SIZE - 1) / sizeof(uint64_t);
+        read_words(lock, first, last - first + 1, buf);
+        memcpy(out, (const char*)buf + offset % sizeof(uint64_t), SIZE);
+    }
+
+    // number of publishes so far
+    static uint64_t current_version(const seqlock* lock) noexcept
+    {
+        return lock->version.load(std::memory_order_acquire);
+    }
+};
+
+// reads `field` of the latest T published to `lock` into `*out`
+#define seqlock_read_field(lock, T, field, out)                                        \
+    seqlock<T>::read_bytes<sizeof(((T*)0)->field)>(lock, offsetof(T, field), out)
@@ -0,0 +1,149 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "destroy_queue.h"
+
+#include "core/hashmap.h"
+
+#include <string.h>
+
+static u64 DestroyQueue_HashID(const void* item, uint64_t seed0, uint64_t seed1)
+{
+    return hashmap_xxhash3(item, sizeof(u32), seed0, seed1);
+}
+
+static int DestroyQueue_CompareID(const void* a, const void* b, void* udata)
+{
+    UNUSED_VAR(udata);
+    u32 id_a = *(u32*)a;
+    u32 id_b = *(u32*)b;
+    return id_a < id_b ? -1 : id_a > id_b ? 1 : 0;
+}
+
+void DestroyQueue_Init(DestroyQueue* queue, bool tombstone)
+{
+    *queue = {};
+    Arena::init(&queue->items, sizeof(DestroyQueueItem) * 64);
+    if (tombstone) {
+        queue->tombstones = hashmap_new_simple(sizeof(u32), DestroyQueue_HashID,
+                                               DestroyQueue_CompareID);
+    }
+}
+
+void DestroyQueue_Free(DestroyQueue* queue)
+{
+    Arena::free(&queue->items);
+    if (queue->tombstones) hashmap_free(queue->tombstones);
+    *queue = {};
+}
+
+bool DestroyQueue_Push(DestroyQueue* queue, u32 id, u32 cost)
+{
+    if (queue->tombstones) {
+        if (hashmap_get(queue->tombstones, &id)) return false;
+        hashmap_set(queue->tombstones, &id);
+    }
+
+    DestroyQueueItem* item = ARENA_PUSH_TYPE(&queue->items, DestroyQueueItem);
+    item->id               = id;
+    item->cost             = cost;
+    return true;
+}
+
+bool DestroyQueue_Tombstoned(DestroyQueue* queue, u32 id)
+{
+    return queue->tombstones && hashmap_get(queue->tombstones, &id);
+}
+
+int DestroyQueue_Depth(DestroyQueue* queue)
+{
+    return (int)ARENA_LENGTH(&queue->items, DestroyQueueItem) - queue->head;
+}
+
+// drops the destroyed items from the front once they are at least half the arena
+static void DestroyQueue_Compact(DestroyQueue* queue)
+{
+    int length = (int)ARENA_LENGTH(&queue->items, DestroyQueueItem);
+    if (queue->head == length) {
+        Arena::clear(&queue->items);
+        queue->head = 0;
+    } else if (queue->head > 0 && queue->head >= length / 2) {
+        memmove(queue->items.base,
+                ARENA_GET_TYPE(&queue->items, DestroyQueueItem, queue->head),
+                (length - queue->head) * sizeof(DestroyQueueItem));
+        queue->items.curr = (length - queue->head) * sizeof(DestroyQueueItem);
+        queue->head       = 0;
+    }
+}
+
+int DestroyQueue_Process(DestroyQueue* queue, DestroyQueueBudget budget,
+                         DestroyQueue_DestroyFunc destroy, void* destroy_udata,
+                         DestroyQueue_ClockFunc clock_ms, void* clock_udata)
+{
+    // items pushed by `destroy` are past `end`, and wait for the next call
+    int end       = (int)ARENA_LENGTH(&queue->items, DestroyQueueItem);
+    f64 start_ms  = clock_ms(clock_udata);
+    f64 elapsed   = 0;
+    u64 units     = 0;
+    int destroyed = 0;
+
+    while (queue->head < end) {
+        // copy, `destroy` may grow (and move) the arena
+        DestroyQueueItem item
+          = *ARENA_GET_TYPE(&queue->items, DestroyQueueItem, queue->head);
+
+        if (destroyed > 0) {
+            if (budget.max_units && units + item.cost > budget.max_units) break;
+            if (budget.max_ms && elapsed + queue->avg_destroy_ms > budget.max_ms)
+                break;
+        }
+
+        ++queue->head;
+        destroy(item.id, destroy_udata);
+        if (queue->tombstones) hashmap_delete(queue->tombstones, &item.id);
+
+        f64 now_ms     = clock_ms(clock_udata);
+        f64 destroy_ms = (now_ms - start_ms) - elapsed;
+        elapsed        = now_ms - start_ms;
+        queue->avg_destroy_ms
+          = queue->avg_destroy_ms == 0 ?
+              destroy_ms :
+              queue->avg_destroy_ms + (destroy_ms - queue->avg_destroy_ms) * 0.125;
+
+        units += item.cost;
+        ++destroyed;
+    }
+
+    DestroyQueue_Compact(queue);
+
+    queue->frame_stats.destroyed = destroyed;
+    queue->frame_stats.units     = units;
+    queue->frame_stats.ms        = elapsed;
+    queue->frame_stats.depth     = DestroyQueue_Depth(queue);
+    queue->lifetime_destroyed += destroyed;
+    return destroyed;
+}
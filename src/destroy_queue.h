@@ -0,0 +1,105 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+#include "core/memory.h"
+
+/*
+Budgeted destruction
+
+Dropping a large scene releases every component in it at once: the audio thread
+releases the ChucK objects and the render thread frees the matching R_
+components. Done in one go, that is a single very long frame.
+
+Instead both threads push what they want destroyed onto a DestroyQueue and,
+once per frame, destroy from its front (FIFO) until that frame's budget is
+spent:
+- time: stops before the next destroy is predicted to overrun max_ms, using a
+  moving average of how long recent destroys took
+- units: every item carries a cost given on push (e.g. bytes). Stops before the
+  next item would overrun max_units
+Every call destroys at least one item (if any), so the queue always drains.
+
+A tombstoning queue also remembers which ids are queued. An id is tombstoned
+from its push until its destroy has run, and pushing it again in the meantime
+is ignored (double free). Queues of refcount decrements must not tombstone,
+since the same id can legitimately be pushed more than once.
+
+Knows nothing about components, and takes the clock as a parameter, so it can
+be tested on the CPU.
+*/
+
+struct DestroyQueueItem {
+    u32 id;
+    u32 cost;
+};
+
+// 0 means unlimited
+struct DestroyQueueBudget {
+    f64 max_ms;
+    u64 max_units;
+};
+
+// of the last DestroyQueue_Process
+struct DestroyQueueStats {
+    int destroyed;
+    u64 units;
+    f64 ms;
+    int depth; // items still queued afterwards
+};
+
+struct DestroyQueue {
+    Arena items; // DestroyQueueItem, [head, length) still queued
+    int head;
+    struct hashmap* tombstones; // NULL if not tombstoning
+
+    f64 avg_destroy_ms; // moving average, 0 until the first destroy is timed
+
+    DestroyQueueStats frame_stats;
+    u64 lifetime_destroyed;
+};
+
+typedef void (*DestroyQueue_DestroyFunc)(u32 id, void* udata);
+typedef f64 (*DestroyQueue_ClockFunc)(void* udata); // monotonic, in ms
+
+void DestroyQueue_Init(DestroyQueue* queue, bool tombstone);
+void DestroyQueue_Free(DestroyQueue* queue);
+
+// false if `id` is already tombstoned
+bool DestroyQueue_Push(DestroyQueue* queue, u32 id, u32 cost);
+
+bool DestroyQueue_Tombstoned(DestroyQueue* queue, u32 id);
+
+int DestroyQueue_Depth(DestroyQueue* queue);
+
+// destroys queued items in push order within `budget`. `destroy` may push onto
+// the queue; those items wait for a later call. Returns the number destroyed
+int DestroyQueue_Process(DestroyQueue* queue, DestroyQueueBudget budget,
+                         DestroyQueue_DestroyFunc destroy, void* destroy_udata,
+                         DestroyQueue_ClockFunc clock_ms, void* clock_udata);
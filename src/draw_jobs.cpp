@@ -0,0 +1,200 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "draw_jobs.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// one job (ParallelFor call) at a time. Workers sleep until generation changes,
+// then claim chunks until none are left
+struct JobPoolState {
+    std::thread* threads;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    // current job, written under mutex before generation is bumped
+    JobPool_Func func;
+    void* udata;
+    int count;
+    int chunk_count;
+    u64 generation;
+    bool quit;
+
+    std::atomic<int> next_chunk;
+    int active_workers; // still claiming chunks of the current job
+};
+
+static void JobPool_RunChunks(JobPoolState* state, JobPool_Func func, void* udata,
+                              int count, int chunk_count)
+{
+    int chunk;
+    while ((chunk = state->next_chunk.fetch_add(1)) < chunk_count) {
+        func(chunk, JobPool_ChunkBegin(count, chunk_count, chunk),
+             JobPool_ChunkBegin(count, chunk_count, chunk + 1), udata);
+    }
+}
+
+static void JobPool_WorkerMain(JobPoolState* state)
+{
+    u64 seen_generation = 0;
+    while (true) {
+        JobPool_Func func;
+        void* udata;
+        int count, chunk_count;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->work_cv.wait(
+              lock, [&] { return state->quit || state->generation != seen_generation; });
+            if (state->quit) return;
+
+            seen_generation = state->generation;
+            func            = state->func;
+            udata           = state->udata;
+            count           = state->count;
+            chunk_count     = state->chunk_count;
+            ++state->active_workers;
+        }
+
+        JobPool_RunChunks(state, func, udata, count, chunk_count);
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            --state->active_workers;
+        }
+        state->done_cv.notify_one();
+    }
+}
+
+void JobPool_Init(JobPool* pool, int worker_count)
+{
+    ASSERT(pool->state == NULL);
+    *pool              = {};
+    pool->worker_count = MAX(worker_count, 0);
+    if (pool->worker_count == 0) return;
+
+    pool->state          = new JobPoolState();
+    pool->state->threads = new std::thread[pool->worker_count];
+    for (int i = 0; i < pool->worker_count; i++) {
+        pool->state->threads[i] = std::thread(JobPool_WorkerMain, pool->state);
+    }
+}
+
+void JobPool_Free(JobPool* pool)
+{
+    JobPoolState* state = pool->state;
+    if (state) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->quit = true;
+        }
+        state->work_cv.notify_all();
+        for (int i = 0; i < pool->worker_count; i++) state->threads[i].join();
+
+        delete[] state->threads;
+        delete state;
+    }
+    *pool = {};
+}
+
+int JobPool_ChunkCount(JobPool* pool, int count, int min_chunk_size)
+{
+    int max_chunks = pool->worker_count + 1;
+    int chunks     = count / MAX(min_chunk_size, 1);
+    return CLAMP(chunks, 1, max_chunks);
+}
+
+int JobPool_ChunkBegin(int count, int chunk_count, int chunk)
+{
+    return (int)((i64)count * chunk / chunk_count);
+}
+
+void JobPool_ParallelFor(JobPool* pool, int count, int chunk_count, JobPool_Func func,
+                         void* udata)
+{
+    ASSERT(chunk_count > 0);
+    JobPoolState* state = pool->state;
+
+    if (state == NULL || chunk_count == 1) {
+        for (int chunk = 0; chunk < chunk_count; chunk++) {
+            func(chunk, JobPool_ChunkBegin(count, chunk_count, chunk),
+                 JobPool_ChunkBegin(count, chunk_count, chunk + 1), udata);
+        }
+        return;
+    }
+
+    {
+        // a worker that woke up late for the previous job may still be claiming
+        // (nothing) from it, don't hand it this job's chunks
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done_cv.wait(lock, [&] { return state->active_workers == 0; });
+        state->func        = func;
+        state->udata       = udata;
+        state->count       = count;
+        state->chunk_count = chunk_count;
+        state->next_chunk.store(0);
+        ++state->generation;
+    }
+    state->work_cv.notify_all();
+
+    JobPool_RunChunks(state, func, udata, count, chunk_count);
+
+    // every chunk is claimed, wait for the workers still running one
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done_cv.wait(lock, [&] { return state->active_workers == 0; });
+}
+
+void DrawList_Append(DrawListLayout* layout, Arena* dst_draws, Arena* dst_entries,
+                     Arena* src_draws, Arena* src_entries)
+{
+    u64 draw_count = src_draws->curr / layout->draw_size;
+    if (draw_count > 0) {
+        u8* draws = (u8*)Arena::push(dst_draws, src_draws->curr);
+        memcpy(draws, src_draws->base, src_draws->curr);
+
+        for (u32 g = 0; g < layout->group_count; g++) {
+            u32 base = (u32)(dst_entries[g].curr / layout->entry_size);
+            if (base == 0) continue;
+            for (u64 i = 0; i < draw_count; i++) {
+                u32* start = (u32*)(draws + i * layout->draw_size
+                                    + layout->bg_start_offset + g * layout->bg_stride);
+                *start += base;
+            }
+        }
+    }
+
+    for (u32 g = 0; g < layout->group_count; g++) {
+        if (src_entries[g].curr == 0) continue;
+        void* entries = Arena::push(dst_entries + g, src_entries[g].curr);
+        memcpy(entries, src_entries[g].base, src_entries[g].curr);
+    }
+}
@@ -0,0 +1,94 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+#include "core/memory.h"
+
+/*
+Parallel draw recording
+
+Building a scene pass's draw list is mostly filling in G_DrawCalls and their
+bindgroup entries, one primitive at a time, independent of every other
+primitive. _R_RenderScene does the parts that touch the GPU (buffer writes,
+wireframe rebuilds, sampler creation) serially, then records the draws on a
+JobPool:
+
+1. the primitives are split into contiguous chunks, in order
+2. chunk 0 records straight into the G_Graph, every other chunk into its own
+   draw and bindgroup entry arenas. A draw's bg_list[g].start indexes its
+   chunk's entry arena
+3. chunks are appended to the graph in chunk order, rebasing bg_list starts
+   onto the graph's entry arenas
+
+Since chunks cover the primitives in order and are merged in order, the graph
+ends up with exactly the draws and entries serial recording would have made,
+no matter how the chunks were scheduled.
+
+Knows nothing about G_DrawCall, only where its bg_list lives, so it can be
+tested on the CPU with synthetic draws.
+*/
+
+typedef void (*JobPool_Func)(int chunk, int begin, int end, void* udata);
+
+struct JobPool {
+    struct JobPoolState* state; // NULL until JobPool_Init
+    int worker_count;
+};
+
+// 0 workers runs every job on the calling thread
+void JobPool_Init(JobPool* pool, int worker_count);
+
+// joins the workers
+void JobPool_Free(JobPool* pool);
+
+// how many chunks to split `count` items into, so that every chunk has at least
+// `min_chunk_size` items and there is at most one chunk per thread (workers + caller)
+int JobPool_ChunkCount(JobPool* pool, int count, int min_chunk_size);
+
+// first item of `chunk`. Chunk i covers [begin(i), begin(i + 1))
+int JobPool_ChunkBegin(int count, int chunk_count, int chunk);
+
+// calls func once per chunk of [0, count), on the workers and the calling thread.
+// Returns once every chunk is done
+void JobPool_ParallelFor(JobPool* pool, int count, int chunk_count, JobPool_Func func,
+                         void* udata);
+
+// where a draw keeps its bindgroup entry ranges, see G_DrawCall::bg_list
+struct DrawListLayout {
+    u32 draw_size;
+    u32 entry_size;
+    u32 group_count;
+    u32 bg_start_offset; // byte offset of bg_list[0].start (a u32) in a draw
+    u32 bg_stride;       // bytes from bg_list[g] to bg_list[g + 1]
+};
+
+// appends src's draws and bindgroup entries (one arena per group) to dst, rebasing
+// the bg_list starts of the copied draws onto dst's entry arenas
+void DrawList_Append(DrawListLayout* layout, Arena* dst_draws, Arena* dst_entries,
+                     Arena* src_draws, Arena* src_entries);
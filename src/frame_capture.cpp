@@ -0,0 +1,912 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "frame_capture.h"
+
+#include "core/log.h"
+#include "core/memory.h"
+
+#include <stb/stb_image_write.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <signal.h>
+#endif
+
+#define FRAME_CAPTURE_DEFAULT_QUEUE_DEPTH 8
+#define FRAME_CAPTURE_SEQUENCE_DIGITS 5
+
+// ============================================================================
+// Encoders
+// ============================================================================
+
+static void FrameCapture_PushBytes(Arena* out, const void* data, u64 size)
+{
+    memcpy(Arena::push(out, size), data, size);
+}
+
+static void FrameCapture_PushU8(Arena* out, u8 v)
+{
+    *ARENA_PUSH_TYPE(out, u8) = v;
+}
+
+static void FrameCapture_PushU16LE(Arena* out, u16 v)
+{
+    u8* dst = ARENA_PUSH_COUNT(out, u8, 2);
+    dst[0]  = (u8)(v & 0xFF);
+    dst[1]  = (u8)(v >> 8);
+}
+
+static void FrameCapture_PushU32BE(Arena* out, u32 v)
+{
+    u8* dst = ARENA_PUSH_COUNT(out, u8, 4);
+    dst[0]  = (u8)(v >> 24);
+    dst[1]  = (u8)(v >> 16);
+    dst[2]  = (u8)(v >> 8);
+    dst[3]  = (u8)v;
+}
+
+// https://qoiformat.org/qoi-specification.pdf
+bool FrameCapture_EncodeQOI(Arena* out, const u8* rgba, int width, int height)
+{
+    if (width <= 0 || height <= 0) return false;
+
+    FrameCapture_PushBytes(out, "qoif", 4);
+    FrameCapture_PushU32BE(out, (u32)width);
+    FrameCapture_PushU32BE(out, (u32)height);
+    FrameCapture_PushU8(out, 4); // channels
+    FrameCapture_PushU8(out, 0); // sRGB with linear alpha
+
+    // worst case is 5 bytes per texel, reserve it once instead of per op
+    u64 texel_count = (u64)width * height;
+    u64 start       = out->curr;
+    u8* dst         = (u8*)Arena::push(out, texel_count * 5 + 8);
+    u8* p           = dst;
+
+    u8 index[64][4] = {};
+    u8 prev[4]      = { 0, 0, 0, 255 };
+    int run         = 0;
+    for (u64 i = 0; i < texel_count; i++) {
+        const u8* px = rgba + i * 4;
+        if (memcmp(px, prev, 4) == 0) {
+            if (++run == 62) {
+                *p++ = 0xC0 | (run - 1); // QOI_OP_RUN
+                run  = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = 0xC0 | (run - 1);
+            run  = 0;
+        }
+
+        int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (memcmp(index[hash], px, 4) == 0) {
+            *p++ = (u8)hash; // QOI_OP_INDEX
+        } else {
+            memcpy(index[hash], px, 4);
+            if (px[3] == prev[3]) {
+                int dr = (i8)(px[0] - prev[0]);
+                int dg = (i8)(px[1] - prev[1]);
+                int db = (i8)(px[2] - prev[2]);
+                int dr_dg = dr - dg, db_dg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2); // DIFF
+                } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7
+                           && db_dg >= -8 && db_dg <= 7) {
+                    *p++ = 0x80 | (dg + 32); // QOI_OP_LUMA
+                    *p++ = (u8)(((dr_dg + 8) << 4) | (db_dg + 8));
+                } else {
+                    *p++ = 0xFE; // QOI_OP_RGB
+                    memcpy(p, px, 3);
+                    p += 3;
+                }
+            } else {
+                *p++ = 0xFF; // QOI_OP_RGBA
+                memcpy(p, px, 4);
+                p += 4;
+            }
+        }
+        memcpy(prev, px, 4);
+    }
+    if (run > 0) *p++ = 0xC0 | (run - 1);
+
+    static const u8 end_marker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    memcpy(p, end_marker, sizeof(end_marker));
+    p += sizeof(end_marker);
+
+    // give back the unused part of the reservation
+    out->curr = start + (u64)(p - dst);
+    return true;
+}
+
+static void FrameCapture_PNGWrite(void* context, void* data, int size)
+{
+    FrameCapture_PushBytes((Arena*)context, data, (u64)size);
+}
+
+bool FrameCapture_EncodePNG(Arena* out, const u8* rgba, int width, int height)
+{
+    if (width <= 0 || height <= 0) return false;
+    return stbi_write_png_to_func(FrameCapture_PNGWrite, out, width, height, 4, rgba,
+                                  width * 4)
+           != 0;
+}
+
+// 4x4 Bayer matrix, thresholds in [0, 16)
+static const u8 frame_capture_bayer[4][4] = {
+    { 0, 8, 2, 10 },
+    { 12, 4, 14, 6 },
+    { 3, 11, 1, 9 },
+    { 15, 7, 13, 5 },
+};
+
+// quantized level of every channel value at every dither threshold, for the 3
+// bit (red, green) and 2 bit (blue) channels
+struct FrameCaptureDitherTable {
+    u8 level3[16][256];
+    u8 level2[16][256];
+
+    FrameCaptureDitherTable()
+    {
+        for (int t = 0; t < 16; t++) {
+            // offset in [-0.5, 0.5) of a quantization step
+            f32 offset = (t + 0.5f) / 16.0f - 0.5f;
+            for (int v = 0; v < 256; v++) {
+                f32 l3       = v / 255.0f * 7.0f + offset;
+                f32 l2       = v / 255.0f * 3.0f + offset;
+                level3[t][v] = (u8)CLAMP((int)(l3 + 0.5f), 0, 7);
+                level2[t][v] = (u8)CLAMP((int)(l2 + 0.5f), 0, 3);
+            }
+        }
+    }
+};
+
+static const FrameCaptureDitherTable* FrameCapture_DitherTable()
+{
+    static const FrameCaptureDitherTable table; // thread-safe init
+    return &table;
+}
+
+static u8 FrameCapture_GIFIndexWithTable(const FrameCaptureDitherTable* table,
+                                         const u8* texel, int x, int y)
+{
+    int t = frame_capture_bayer[y & 3][x & 3];
+    return (u8)((table->level3[t][texel[0]] << 5) | (table->level3[t][texel[1]] << 2)
+                | table->level2[t][texel[2]]);
+}
+
+u8 FrameCapture_GIFIndex(const u8* texel, int x, int y)
+{
+    return FrameCapture_GIFIndexWithTable(FrameCapture_DitherTable(), texel, x, y);
+}
+
+void FrameCapture_GIFPaletteColor(u8 index, u8* rgb)
+{
+    rgb[0] = (u8)(((index >> 5) & 7) * 255 / 7);
+    rgb[1] = (u8)(((index >> 2) & 7) * 255 / 7);
+    rgb[2] = (u8)((index & 3) * 255 / 3);
+}
+
+int FrameCapture_GIFDelay(u64 index, f64 fps)
+{
+    if (fps <= 0) fps = 60;
+    // delay between rounded timestamps, so rounding errors don't accumulate
+    u64 begin = (u64)((f64)index * 100.0 / fps + 0.5);
+    u64 end   = (u64)((f64)(index + 1) * 100.0 / fps + 0.5);
+    return (int)MIN(end - begin, (u64)0xFFFF);
+}
+
+void FrameCapture_GIFHeader(Arena* out, int width, int height)
+{
+    FrameCapture_PushBytes(out, "GIF89a", 6);
+    FrameCapture_PushU16LE(out, (u16)width);
+    FrameCapture_PushU16LE(out, (u16)height);
+    FrameCapture_PushU8(out, 0xF7); // global color table of 256 colors
+    FrameCapture_PushU8(out, 0);    // background color
+    FrameCapture_PushU8(out, 0);    // pixel aspect ratio
+
+    u8* palette = ARENA_PUSH_COUNT(out, u8, 256 * 3);
+    for (int i = 0; i < 256; i++) FrameCapture_GIFPaletteColor((u8)i, palette + i * 3);
+
+    // loop forever
+    FrameCapture_PushBytes(out, "\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+}
+
+void FrameCapture_GIFTrailer(Arena* out)
+{
+    FrameCapture_PushU8(out, 0x3B);
+}
+
+#define GIF_LZW_MIN_CODE_SIZE 8
+#define GIF_LZW_CLEAR (1 << GIF_LZW_MIN_CODE_SIZE)
+#define GIF_LZW_EOI (GIF_LZW_CLEAR + 1)
+#define GIF_LZW_MAX_CODES 4096
+#define GIF_LZW_HASH_SIZE 8192 // power of 2, about twice the max codes
+
+// packs variable width codes LSB first into 255 byte data sub-blocks
+struct GIFCodeWriter {
+    Arena* out;
+    u8 block[255];
+    int block_len;
+    u32 bits;
+    int bit_count;
+
+    static void flushBlock(GIFCodeWriter* w)
+    {
+        if (w->block_len == 0) return;
+        FrameCapture_PushU8(w->out, (u8)w->block_len);
+        FrameCapture_PushBytes(w->out, w->block, w->block_len);
+        w->block_len = 0;
+    }
+
+    static void write(GIFCodeWriter* w, int code, int code_size)
+    {
+        w->bits |= (u32)code << w->bit_count;
+        w->bit_count += code_size;
+        while (w->bit_count >= 8) {
+            w->block[w->block_len++] = (u8)(w->bits & 0xFF);
+            w->bits >>= 8;
+            w->bit_count -= 8;
+            if (w->block_len == 255) flushBlock(w);
+        }
+    }
+
+    static void finish(GIFCodeWriter* w)
+    {
+        if (w->bit_count > 0) {
+            w->block[w->block_len++] = (u8)(w->bits & 0xFF);
+            w->bits                  = 0;
+            w->bit_count             = 0;
+            if (w->block_len == 255) flushBlock(w);
+        }
+        flushBlock(w);
+        FrameCapture_PushU8(w->out, 0); // block terminator
+    }
+};
+
+bool FrameCapture_EncodeGIFFrame(Arena* out, const u8* rgba, int width, int height,
+                                 int delay_cs)
+{
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF) return false;
+
+    // graphic control extension: leave the frame in place, no transparency
+    FrameCapture_PushBytes(out, "\x21\xF9\x04\x04", 4);
+    FrameCapture_PushU16LE(out, (u16)CLAMP(delay_cs, 0, 0xFFFF));
+    FrameCapture_PushBytes(out, "\x00\x00", 2);
+
+    // image descriptor, full frame, global palette
+    FrameCapture_PushU8(out, 0x2C);
+    FrameCapture_PushU16LE(out, 0);
+    FrameCapture_PushU16LE(out, 0);
+    FrameCapture_PushU16LE(out, (u16)width);
+    FrameCapture_PushU16LE(out, (u16)height);
+    FrameCapture_PushU8(out, 0);
+
+    FrameCapture_PushU8(out, GIF_LZW_MIN_CODE_SIZE);
+
+    // string table as a hash of (prefix code, next index) -> code
+    u32* keys  = ALLOCATE_COUNT(u32, GIF_LZW_HASH_SIZE);
+    u16* codes = ALLOCATE_COUNT(u16, GIF_LZW_HASH_SIZE);
+    memset(keys, 0xFF, sizeof(u32) * GIF_LZW_HASH_SIZE);
+
+    GIFCodeWriter writer = {};
+    writer.out           = out;
+    int code_size        = GIF_LZW_MIN_CODE_SIZE + 1;
+    int next_code        = GIF_LZW_EOI + 1;
+    GIFCodeWriter::write(&writer, GIF_LZW_CLEAR, code_size);
+
+    const FrameCaptureDitherTable* table = FrameCapture_DitherTable();
+    int prefix = FrameCapture_GIFIndexWithTable(table, rgba, 0, 0);
+    for (int y = 0; y < height; y++) {
+        const u8* row = rgba + (size_t)y * width * 4;
+        for (int x = (y == 0) ? 1 : 0; x < width; x++) {
+            u8 index = FrameCapture_GIFIndexWithTable(table, row + x * 4, x, y);
+            u32 key  = ((u32)prefix << 8) | index;
+            u32 slot = (key * 2654435761u) & (GIF_LZW_HASH_SIZE - 1);
+            while (keys[slot] != key && keys[slot] != 0xFFFFFFFF)
+                slot = (slot + 1) & (GIF_LZW_HASH_SIZE - 1);
+            if (keys[slot] == key) {
+                prefix = codes[slot];
+                continue;
+            }
+
+            GIFCodeWriter::write(&writer, prefix, code_size);
+            if (next_code < GIF_LZW_MAX_CODES) {
+                keys[slot]  = key;
+                codes[slot] = (u16)next_code++;
+                // the decoder adds this code one code later, so it widens after
+                // reading the next one
+                if (next_code > (1 << code_size) && code_size < 12) ++code_size;
+            } else {
+                // table full, start over
+                GIFCodeWriter::write(&writer, GIF_LZW_CLEAR, code_size);
+                memset(keys, 0xFF, sizeof(u32) * GIF_LZW_HASH_SIZE);
+                code_size = GIF_LZW_MIN_CODE_SIZE + 1;
+                next_code = GIF_LZW_EOI + 1;
+            }
+            prefix = index;
+        }
+    }
+    GIFCodeWriter::write(&writer, prefix, code_size);
+    // the decoder adds a code for the last prefix before reading EOI
+    if (next_code < GIF_LZW_MAX_CODES) {
+        ++next_code;
+        if (next_code > (1 << code_size) && code_size < 12) ++code_size;
+    }
+    GIFCodeWriter::write(&writer, GIF_LZW_EOI, code_size);
+    GIFCodeWriter::finish(&writer);
+
+    FREE(keys);
+    FREE(codes);
+    return true;
+}
+
+// ============================================================================
+// Capture
+// ============================================================================
+
+struct FrameCaptureFrame {
+    u64 index; // submission order
+    const u8* pixels;
+    int stride;
+    int slot;
+    Arena encoded;
+    bool ok;
+    FrameCaptureFrame* next;
+};
+
+// intrusive FIFO of frames
+struct FrameCaptureList {
+    FrameCaptureFrame* head;
+    FrameCaptureFrame* tail;
+
+    static void push(FrameCaptureList* list, FrameCaptureFrame* frame)
+    {
+        frame->next = NULL;
+        if (list->tail) {
+            list->tail->next = frame;
+        } else {
+            list->head = frame;
+        }
+        list->tail = frame;
+    }
+
+    // keeps the list sorted by index. Frames finish encoding roughly in order,
+    // so this is usually a push
+    static void insertSorted(FrameCaptureList* list, FrameCaptureFrame* frame)
+    {
+        if (list->tail == NULL || list->tail->index < frame->index) {
+            push(list, frame);
+            return;
+        }
+        FrameCaptureFrame** link = &list->head;
+        while ((*link)->index < frame->index) link = &(*link)->next;
+        frame->next = *link;
+        *link       = frame;
+    }
+
+    static FrameCaptureFrame* pop(FrameCaptureList* list)
+    {
+        FrameCaptureFrame* frame = list->head;
+        if (frame) {
+            list->head = frame->next;
+            if (list->head == NULL) list->tail = NULL;
+            frame->next = NULL;
+        }
+        return frame;
+    }
+
+    static void free(FrameCaptureList* list)
+    {
+        FrameCaptureFrame* frame;
+        while ((frame = pop(list))) {
+            Arena::free(&frame->encoded);
+            FREE(frame);
+        }
+    }
+};
+
+struct FrameCaptureState {
+    std::thread* workers;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable work_cv;  // workers wait on queued frames
+    std::condition_variable write_cv; // writer waits on the next frame in order
+    bool quit;
+
+    // guarded by mutex
+    FrameCaptureList queued;  // waiting on a worker
+    FrameCaptureList encoded; // waiting on the writer, sorted by index
+    FrameCaptureList pool;    // written, reused with their encoded arena
+    Arena released;           // int slots
+    FrameCaptureStats stats;
+    int in_flight; // submitted, not yet written
+
+    // writer only, after Begin
+    FILE* file;
+    bool pipe;
+    char* prefix; // sequence file name around the frame number
+    char* suffix;
+    int digits;
+};
+
+// splits "name%05d.png" into "name", 5 and ".png". Only a single %d with an
+// optional zero padded width is taken as the frame number, otherwise (and for
+// any other %) the number goes before the extension
+static void FrameCapture_ParsePattern(FrameCaptureState* state, const char* path)
+{
+    const char* percent = strchr(path, '%');
+    if (percent) {
+        const char* p = percent + 1;
+        int digits    = 0;
+        if (*p == '0') ++p;
+        while (*p >= '0' && *p <= '9') digits = digits * 10 + (*p++ - '0');
+        if (*p == 'd' && strchr(p, '%') == NULL && digits <= 16) {
+            size_t prefix_len = percent - path;
+            state->prefix     = ALLOCATE_COUNT(char, prefix_len + 1);
+            memcpy(state->prefix, path, prefix_len);
+            state->prefix[prefix_len] = '\0';
+            state->suffix             = ALLOCATE_COUNT(char, strlen(p + 1) + 1);
+            strcpy(state->suffix, p + 1);
+            state->digits = digits;
+            return;
+        }
+    }
+
+    // the extension's dot, not one in a directory name
+    const char* dot = strrchr(path, '.');
+    if (dot && (strchr(dot, '/') || strchr(dot, '\\'))) dot = NULL;
+    if (dot == NULL) dot = path + strlen(path);
+    size_t prefix_len = dot - path;
+    state->prefix     = ALLOCATE_COUNT(char, prefix_len + 2);
+    memcpy(state->prefix, path, prefix_len);
+    strcpy(state->prefix + prefix_len, "_");
+    state->suffix = ALLOCATE_COUNT(char, strlen(dot) + 1);
+    strcpy(state->suffix, dot);
+    state->digits = FRAME_CAPTURE_SEQUENCE_DIGITS;
+}
+
+static bool FrameCapture_HasExtension(const char* path, const char* ext)
+{
+    size_t len = strlen(path), ext_len = strlen(ext);
+    if (len < ext_len) return false;
+    for (size_t i = 0; i < ext_len; i++) {
+        char c = path[len - ext_len + i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != ext[i]) return false;
+    }
+    return true;
+}
+
+void FrameCapture_DescFromPath(FrameCaptureDesc* desc, const char* path)
+{
+    if (path[0] == '|') {
+        desc->format = FrameCaptureFormat_RAW;
+        desc->output = FrameCaptureOutput_Pipe;
+        desc->path   = path + 1;
+        return;
+    }
+
+    desc->path = path;
+    if (FrameCapture_HasExtension(path, ".gif")) {
+        desc->format = FrameCaptureFormat_GIF;
+        desc->output = FrameCaptureOutput_File;
+        return;
+    }
+
+    desc->output = FrameCaptureOutput_Sequence;
+    if (FrameCapture_HasExtension(path, ".qoi")) {
+        desc->format = FrameCaptureFormat_QOI;
+    } else if (FrameCapture_HasExtension(path, ".rgba")
+               || FrameCapture_HasExtension(path, ".raw")) {
+        desc->format = FrameCaptureFormat_RAW;
+    } else {
+        desc->format = FrameCaptureFormat_PNG;
+    }
+}
+
+// tightly packed RGBA from the slot's texels
+static void FrameCapture_Convert(FrameCaptureDesc* desc, FrameCaptureFrame* frame,
+                                 u8* rgba)
+{
+    size_t row_bytes = (size_t)desc->width * 4;
+    for (int y = 0; y < desc->height; y++) {
+        const u8* src = frame->pixels + (size_t)y * frame->stride;
+        u8* dst       = rgba + y * row_bytes;
+        if (!desc->bgra && !desc->opaque) {
+            memcpy(dst, src, row_bytes);
+            continue;
+        }
+        for (int x = 0; x < desc->width; x++, src += 4, dst += 4) {
+            dst[0] = desc->bgra ? src[2] : src[0];
+            dst[1] = src[1];
+            dst[2] = desc->bgra ? src[0] : src[2];
+            dst[3] = desc->opaque ? 255 : src[3];
+        }
+    }
+}
+
+static bool FrameCapture_Encode(FrameCaptureDesc* desc, FrameCaptureFrame* frame,
+                                const u8* rgba)
+{
+    switch (desc->format) {
+        case FrameCaptureFormat_PNG:
+            return FrameCapture_EncodePNG(&frame->encoded, rgba, desc->width,
+                                          desc->height);
+        case FrameCaptureFormat_QOI:
+            return FrameCapture_EncodeQOI(&frame->encoded, rgba, desc->width,
+                                          desc->height);
+        case FrameCaptureFormat_GIF:
+            return FrameCapture_EncodeGIFFrame(
+              &frame->encoded, rgba, desc->width, desc->height,
+              FrameCapture_GIFDelay(frame->index, desc->fps));
+        default: ASSERT(false); return false;
+    }
+}
+
+static void FrameCapture_WorkerMain(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+    FrameCaptureDesc* desc   = &capture->desc;
+    u8* scratch = desc->format == FrameCaptureFormat_RAW ?
+                    NULL :
+                    ALLOCATE_COUNT(u8, (size_t)desc->width * desc->height * 4);
+
+    while (true) {
+        FrameCaptureFrame* frame;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->work_cv.wait(
+              lock, [&] { return state->quit || state->queued.head != NULL; });
+            // finish the queue before quitting, End() flushes every frame
+            if (state->queued.head == NULL) break;
+            frame = FrameCaptureList::pop(&state->queued);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        Arena::clear(&frame->encoded);
+        if (desc->format == FrameCaptureFormat_RAW) {
+            // the converted frame is the encoded frame
+            u8* rgba = ARENA_PUSH_COUNT(&frame->encoded, u8,
+                                        (size_t)desc->width * desc->height * 4);
+            FrameCapture_Convert(desc, frame, rgba);
+        } else {
+            FrameCapture_Convert(desc, frame, scratch);
+        }
+
+        // done with the slot, hand it back before the slow part
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            *ARENA_PUSH_TYPE(&state->released, int) = frame->slot;
+        }
+        frame->pixels = NULL;
+
+        frame->ok = desc->format == FrameCaptureFormat_RAW
+                    || FrameCapture_Encode(desc, frame, scratch);
+        auto end  = std::chrono::steady_clock::now();
+        f64 ms    = std::chrono::duration<f64, std::milli>(end - begin).count();
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            FrameCaptureStats* stats = &state->stats;
+            stats->avg_encode_ms
+              = stats->avg_encode_ms == 0 ? ms : stats->avg_encode_ms * 0.9 + ms * 0.1;
+            FrameCaptureList::insertSorted(&state->encoded, frame);
+        }
+        state->write_cv.notify_one();
+    }
+
+    FREE(scratch);
+}
+
+static bool FrameCapture_Write(FrameCapture* capture, FrameCaptureFrame* frame,
+                               const char** error)
+{
+    FrameCaptureState* state = capture->state;
+    Arena* encoded           = &frame->encoded;
+    if (!frame->ok) {
+        *error = "failed to encode frame";
+        return false;
+    }
+
+    if (capture->desc.output != FrameCaptureOutput_Sequence) {
+        if (state->file == NULL) {
+            *error = "output closed after an earlier write failed";
+            return false;
+        }
+        if (fwrite(encoded->base, 1, encoded->curr, state->file) != encoded->curr) {
+            *error = state->pipe ? "pipe closed" : "failed to write frame";
+            // later frames would fail the same way
+            state->pipe ? pclose(state->file) : fclose(state->file);
+            state->file = NULL;
+            return false;
+        }
+        return true;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%0*llu%s", state->prefix, state->digits,
+             (unsigned long long)frame->index, state->suffix);
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        *error = "failed to open frame file";
+        return false;
+    }
+    bool ok = fwrite(encoded->base, 1, encoded->curr, file) == encoded->curr;
+    ok      = (fclose(file) == 0) && ok;
+    if (!ok) *error = "failed to write frame file";
+    return ok;
+}
+
+static void FrameCapture_WriterMain(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+#ifndef _WIN32
+    // a closed pipe fails the write instead of killing the process
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, NULL);
+#endif
+
+    u64 next_index = 0;
+    while (true) {
+        FrameCaptureFrame* frame;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->write_cv.wait(lock, [&] {
+                return (state->encoded.head && state->encoded.head->index == next_index)
+                       || (state->quit && state->in_flight == 0);
+            });
+            if (state->encoded.head == NULL) break;
+            frame = FrameCaptureList::pop(&state->encoded);
+        }
+
+        const char* error = NULL;
+        bool ok           = FrameCapture_Write(capture, frame, &error);
+        ++next_index;
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            FrameCaptureStats* stats = &state->stats;
+            if (ok) {
+                ++stats->written;
+                stats->bytes_written += frame->encoded.curr;
+            } else {
+                ++stats->failed;
+                stats->error = error;
+            }
+            --state->in_flight;
+            FrameCaptureList::push(&state->pool, frame);
+        }
+    }
+}
+
+static bool FrameCapture_Open(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+    FrameCaptureDesc* desc   = &capture->desc;
+    switch (desc->output) {
+        case FrameCaptureOutput_Sequence:
+            FrameCapture_ParsePattern(state, desc->path);
+            return true;
+        case FrameCaptureOutput_File: state->file = fopen(desc->path, "wb"); break;
+        case FrameCaptureOutput_Pipe: {
+#ifdef _WIN32
+            state->file = popen(desc->path, "wb");
+#else
+            state->file = popen(desc->path, "w");
+#endif
+            state->pipe = true;
+        } break;
+    }
+    if (state->file == NULL) {
+        log_error("Frame capture: could not open \"%s\"", desc->path);
+        return false;
+    }
+
+    if (desc->format == FrameCaptureFormat_GIF) {
+        Arena header = {};
+        FrameCapture_GIFHeader(&header, desc->width, desc->height);
+        fwrite(header.base, 1, header.curr, state->file);
+        Arena::free(&header);
+    }
+    return true;
+}
+
+static void FrameCapture_FreeState(FrameCaptureState* state)
+{
+    FrameCaptureList::free(&state->queued);
+    FrameCaptureList::free(&state->encoded);
+    FrameCaptureList::free(&state->pool);
+    Arena::free(&state->released);
+    FREE(state->prefix);
+    FREE(state->suffix);
+    delete[] state->workers;
+    delete state;
+}
+
+bool FrameCapture_Begin(FrameCapture* capture, FrameCaptureDesc* desc)
+{
+    ASSERT(capture->state == NULL);
+    *capture = {};
+    if (desc->width <= 0 || desc->height <= 0 || desc->path == NULL
+        || desc->format >= FrameCaptureFormat_Count) {
+        log_error("Frame capture: invalid %dx%d capture", desc->width, desc->height);
+        return false;
+    }
+    if (desc->format == FrameCaptureFormat_GIF
+        && (desc->output != FrameCaptureOutput_File || desc->width > 0xFFFF
+            || desc->height > 0xFFFF)) {
+        log_error("Frame capture: GIF must be a single file of at most 65535x65535");
+        return false;
+    }
+
+    capture->desc              = *desc;
+    capture->desc.worker_count = MAX(desc->worker_count, 1);
+    if (capture->desc.max_queue_depth <= 0)
+        capture->desc.max_queue_depth = FRAME_CAPTURE_DEFAULT_QUEUE_DEPTH;
+    capture->state = new FrameCaptureState();
+
+    // own the path, the caller's string may not outlive the capture
+    size_t path_len = strlen(desc->path);
+    char* path      = ALLOCATE_COUNT(char, path_len + 1);
+    memcpy(path, desc->path, path_len + 1);
+    capture->desc.path = path;
+
+    if (!FrameCapture_Open(capture)) {
+        FREE(path);
+        FrameCapture_FreeState(capture->state);
+        *capture = {};
+        return false;
+    }
+
+    FrameCaptureState* state = capture->state;
+    state->writer            = std::thread(FrameCapture_WriterMain, capture);
+    state->workers           = new std::thread[capture->desc.worker_count];
+    for (int i = 0; i < capture->desc.worker_count; i++) {
+        state->workers[i] = std::thread(FrameCapture_WorkerMain, capture);
+    }
+    return true;
+}
+
+FrameCaptureStats FrameCapture_End(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+    if (state == NULL) return {};
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->quit = true;
+    }
+    state->work_cv.notify_all();
+    for (int i = 0; i < capture->desc.worker_count; i++) state->workers[i].join();
+    state->write_cv.notify_all();
+    state->writer.join();
+
+    if (state->file) {
+        if (capture->desc.format == FrameCaptureFormat_GIF) {
+            Arena trailer = {};
+            FrameCapture_GIFTrailer(&trailer);
+            fwrite(trailer.base, 1, trailer.curr, state->file);
+            Arena::free(&trailer);
+        }
+        state->pipe ? pclose(state->file) : fclose(state->file);
+    }
+
+    log_info("Frame capture: wrote %llu frames to \"%s\", dropped %llu, failed %llu",
+             (unsigned long long)state->stats.written, capture->desc.path,
+             (unsigned long long)state->stats.dropped,
+             (unsigned long long)state->stats.failed);
+
+    FrameCaptureStats stats = state->stats;
+    char* path              = (char*)capture->desc.path;
+    FREE(path);
+    FrameCapture_FreeState(state);
+    *capture = {};
+    return stats;
+}
+
+bool FrameCapture_Active(FrameCapture* capture)
+{
+    return capture->state != NULL;
+}
+
+bool FrameCapture_Full(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->in_flight >= capture->desc.max_queue_depth;
+}
+
+void FrameCapture_Submit(FrameCapture* capture, const u8* pixels, int stride, int slot)
+{
+    FrameCaptureState* state = capture->state;
+    ASSERT(stride >= capture->desc.width * 4);
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        FrameCaptureFrame* frame = FrameCaptureList::pop(&state->pool);
+        if (frame == NULL) {
+            frame  = ALLOCATE_TYPE(FrameCaptureFrame);
+            *frame = {};
+        }
+        frame->index  = state->stats.submitted++;
+        frame->pixels = pixels;
+        frame->stride = stride;
+        frame->slot   = slot;
+        frame->ok     = false;
+        FrameCaptureList::push(&state->queued, frame);
+
+        ++state->in_flight;
+        if (state->in_flight > state->stats.max_queue_depth)
+            state->stats.max_queue_depth = state->in_flight;
+    }
+    state->work_cv.notify_one();
+}
+
+void FrameCapture_Drop(FrameCapture* capture)
+{
+    std::lock_guard<std::mutex> lock(capture->state->mutex);
+    ++capture->state->stats.dropped;
+}
+
+int FrameCapture_Released(FrameCapture* capture, int* slots, int max)
+{
+    FrameCaptureState* state = capture->state;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    int available = (int)(state->released.curr / sizeof(int));
+    int count     = MIN(available, max);
+    if (count <= 0) return 0;
+
+    int* released = (int*)state->released.base;
+    int left      = available - count;
+    memcpy(slots, released, sizeof(int) * count);
+    memmove(released, released + count, sizeof(int) * left);
+    state->released.curr = sizeof(int) * left;
+    return count;
+}
+
+FrameCaptureStats FrameCapture_Stats(FrameCapture* capture)
+{
+    FrameCaptureState* state = capture->state;
+    if (state == NULL) return {};
+    std::lock_guard<std::mutex> lock(state->mutex);
+    FrameCaptureStats stats = state->stats;
+    stats.queue_depth       = state->in_flight;
+    return stats;
+}
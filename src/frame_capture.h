@@ -0,0 +1,153 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+struct Arena;
+
+/*
+Frame capture
+
+Recording every frame means reading back and encoding ~8MB per frame at 1080p,
+far too slow to do on the render thread. The render thread only copies each
+frame into one of a ring of readback buffers (slots) and hands the mapped
+memory to a FrameCapture:
+
+1. workers convert the frame to tightly packed RGBA and encode it (PNG, QOI,
+   raw RGBA, or a GIF frame). As soon as a frame is converted its slot is
+   released, and the render thread can reuse it
+2. encoded frames are written in submission order: one file per frame for an
+   image sequence, appended to a single file for GIF, or streamed to the stdin
+   of a process (e.g. ffmpeg) for a pipe
+
+When every slot is still busy, or the writer has fallen max_queue_depth frames
+behind, the render thread skips the frame instead of waiting on the encoders,
+and reports it with FrameCapture_Drop, so capture never stalls frame pacing.
+Dropped frames and how far the encoders fall behind are tracked in
+FrameCaptureStats.
+
+GIF frames share a fixed 256 color palette (3 bits red, 3 green, 2 blue) and
+are ordered dithered, so frames can be quantized and LZW compressed
+independently of each other.
+
+Knows nothing about WebGPU, so it can be tested on the CPU.
+*/
+
+enum FrameCaptureFormat : u8 {
+    FrameCaptureFormat_PNG = 0,
+    FrameCaptureFormat_QOI,
+    FrameCaptureFormat_RAW, // tightly packed RGBA8 rows
+    FrameCaptureFormat_GIF,
+    FrameCaptureFormat_Count,
+};
+
+enum FrameCaptureOutput : u8 {
+    FrameCaptureOutput_Sequence = 0, // path is a pattern with one %d, e.g. "f%05d.png"
+    FrameCaptureOutput_File,         // every frame appended to path (GIF, RAW)
+    FrameCaptureOutput_Pipe,         // path is a shell command, fed through stdin
+};
+
+struct FrameCaptureDesc {
+    FrameCaptureFormat format;
+    FrameCaptureOutput output;
+    const char* path;
+    int width;
+    int height;
+    f64 fps;     // of the captured frames, for GIF frame delays
+    bool bgra;   // source texels are BGRA8 (e.g. the swapchain)
+    bool opaque; // write alpha as 255
+    int worker_count;
+    int max_queue_depth; // frames encoded or written at once, 0 for a default
+};
+
+struct FrameCaptureStats {
+    u64 submitted;
+    u64 written;
+    u64 dropped; // skipped by the render thread, no free slot
+    u64 failed;  // encode or write errors
+    u64 bytes_written;
+    int queue_depth; // submitted, not yet written
+    int max_queue_depth;
+    f64 avg_encode_ms; // moving average
+    const char* error; // last error, NULL if none
+};
+
+struct FrameCapture {
+    struct FrameCaptureState* state; // NULL unless capturing
+    FrameCaptureDesc desc;
+};
+
+// picks format and output from the path: "|cmd" pipes RAW frames to cmd,
+// ".gif" is a single GIF file, ".qoi" / ".rgba" / anything else a QOI, RAW or
+// PNG sequence. A sequence path without a %d gets "_%05d" before its extension
+void FrameCapture_DescFromPath(FrameCaptureDesc* desc, const char* path);
+
+// opens the output and starts the workers. false (and logs why) if the output
+// can't be opened
+bool FrameCapture_Begin(FrameCapture* capture, FrameCaptureDesc* desc);
+
+// blocks until every submitted frame is written, then closes the output.
+// Returns the final stats
+FrameCaptureStats FrameCapture_End(FrameCapture* capture);
+
+bool FrameCapture_Active(FrameCapture* capture);
+
+// true while max_queue_depth frames are in flight. The render thread should
+// drop the frame instead of copying it
+bool FrameCapture_Full(FrameCapture* capture);
+
+// queues one frame for encoding. `pixels` (desc width x height, `stride` bytes
+// per row) must stay valid until `slot` is returned by FrameCapture_Released
+void FrameCapture_Submit(FrameCapture* capture, const u8* pixels, int stride,
+                         int slot);
+
+// a frame was skipped because every slot was busy
+void FrameCapture_Drop(FrameCapture* capture);
+
+// writes up to `max` slots whose frames are encoded, returns how many
+int FrameCapture_Released(FrameCapture* capture, int* slots, int max);
+
+FrameCaptureStats FrameCapture_Stats(FrameCapture* capture);
+
+// encoders, exposed for testing. Append the encoded frame to `out` and return
+// false on failure. `rgba` is tightly packed
+bool FrameCapture_EncodeQOI(Arena* out, const u8* rgba, int width, int height);
+bool FrameCapture_EncodePNG(Arena* out, const u8* rgba, int width, int height);
+void FrameCapture_GIFHeader(Arena* out, int width, int height);
+bool FrameCapture_EncodeGIFFrame(Arena* out, const u8* rgba, int width, int height,
+                                 int delay_cs);
+void FrameCapture_GIFTrailer(Arena* out);
+
+// palette index of a texel at (x, y) after dithering, as the GIF encoder picks it
+u8 FrameCapture_GIFIndex(const u8* texel, int x, int y);
+void FrameCapture_GIFPaletteColor(u8 index, u8* rgb);
+
+// GIF frame delay in centiseconds of frame `index`, rounded so that delays add
+// up to the exact time at `fps`
+int FrameCapture_GIFDelay(u64 index, f64 fps);
@@ -42,6 +42,8 @@
 #include <webgpu/wgpu.h>
 #endif
 
+u64 g_gpu_resource_epoch = 0;
+
 // static void printBackend()
 // {
 // #if defined(WEBGPU_BACKEND_DAWN)
@@ -208,11 +210,27 @@ static void logWGPULimits(WGPULimits const* limits)
 static void GraphicsContext_ConfigureSurface(GraphicsContext* gctx, u32 window_width,
                                              u32 window_height)
 {
+    // offscreen (GG.offline()), the texture rendered to stands in for the surface
+    if (!gctx->surface) {
+        WGPU_DESTROY_RESOURCE(Texture, gctx->offscreen_texture);
+        WGPU_RELEASE_RESOURCE(Texture, gctx->offscreen_texture);
+
+        WGPUTextureDescriptor desc = {};
+        desc.label                 = "Offscreen Surface Texture";
+        desc.size                  = { window_width, window_height, 1 };
+        desc.mipLevelCount         = 1;
+        desc.sampleCount           = 1;
+        desc.dimension             = WGPUTextureDimension_2D;
+        desc.format                = gctx->surface_format;
+        desc.usage                 = gctx->surface_usage;
+        gctx->offscreen_texture    = wgpuDeviceCreateTexture(gctx->device, &desc);
+        return;
+    }
 
     WGPUSurfaceConfiguration surface_config = {};
     surface_config.device                   = gctx->device;
     surface_config.format                   = gctx->surface_format;
-    surface_config.usage                    = WGPUTextureUsage_RenderAttachment;
+    surface_config.usage                    = gctx->surface_usage;
     surface_config.width                    = window_width;
     surface_config.height                   = window_height;
     surface_config.presentMode              = WGPUPresentMode_Fifo; // vsynced
@@ -281,15 +299,24 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
     if (!instance) return false;
     log_trace("WebGPU instance created");
 
-    context->surface = glfwCreateWindowWGPUSurface(instance, window);
-    if (!context->surface) return false;
-    // context->window = window;
-    log_trace("WebGPU surface created");
+    // no window renders offscreen, see GG.offline()
+    if (window) {
+        context->surface = glfwCreateWindowWGPUSurface(instance, window);
+        if (!context->surface) return false;
+        // context->window = window;
+        log_trace("WebGPU surface created");
+    }
 
     WGPURequestAdapterOptions adapterOpts = {};
     adapterOpts.compatibleSurface         = context->surface;
     adapterOpts.powerPreference           = WGPUPowerPreference_HighPerformance;
     WGPUAdapter adapter                   = request_adapter(instance, &adapterOpts);
+    if (!adapter && !window) {
+        // no GPU, offscreen rendering still works on a software adapter
+        log_info("No GPU adapter found, requesting the fallback adapter");
+        adapterOpts.forceFallbackAdapter = true;
+        adapter                          = request_adapter(instance, &adapterOpts);
+    }
     if (!adapter) return false;
     defer(WGPU_RELEASE_RESOURCE(Adapter, adapter));
     log_trace("adapter created");
@@ -328,11 +355,42 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
         // (WGPUFeatureName) WGPUNativeFeature_TextureAdapterSpecificFormatFeatures,  // allows passing 32-bit float textures to texture_2d<f32> in shaders
 
         // enabling this feature still doesn't work
-        WGPUFeatureName_Float32Filterable // needed to sample 32-bit float textures in shaders
+        WGPUFeatureName_Float32Filterable, // needed to sample 32-bit float textures in shaders
+
+        WGPUFeatureName_Undefined, // TimestampQuery when supported, for GG.profile()
+        WGPUFeatureName_Undefined, // TextureCompressionBC when supported
+        WGPUFeatureName_Undefined, // TextureCompressionETC2 when supported
+        WGPUFeatureName_Undefined, // TextureCompressionASTC when supported
     };
     // clang-format on
-    const u32 requiredFeaturesCount = ARRAY_LENGTH(requiredFeatures);
-    log_trace("required features: %d", ARRAY_LENGTH(requiredFeatures));
+    u32 requiredFeaturesCount = ARRAY_LENGTH(requiredFeatures) - 4;
+    context->timestamp_queries
+      = wgpuAdapterHasFeature(adapter, WGPUFeatureName_TimestampQuery);
+    if (context->timestamp_queries) {
+        requiredFeatures[requiredFeaturesCount++] = WGPUFeatureName_TimestampQuery;
+    }
+
+    // compressed KTX2 textures are uploaded as is when the GPU can sample them
+    struct {
+        WGPUFeatureName feature;
+        TextureCompression flag;
+    } compression_features[] = {
+        { WGPUFeatureName_TextureCompressionBC, TextureCompression_BC },
+        { WGPUFeatureName_TextureCompressionETC2, TextureCompression_ETC2 },
+        { WGPUFeatureName_TextureCompressionASTC, TextureCompression_ASTC },
+    };
+    context->texture_compression = 0;
+    for (u32 i = 0; i < ARRAY_LENGTH(compression_features); i++) {
+        if (wgpuAdapterHasFeature(adapter, compression_features[i].feature)) {
+            requiredFeatures[requiredFeaturesCount++] = compression_features[i].feature;
+            context->texture_compression |= compression_features[i].flag;
+        }
+    }
+    log_trace("texture compression: %s%s%s",
+              context->texture_compression & TextureCompression_BC ? "BC " : "",
+              context->texture_compression & TextureCompression_ETC2 ? "ETC2 " : "",
+              context->texture_compression & TextureCompression_ASTC ? "ASTC" : "");
+    log_trace("required features: %d", requiredFeaturesCount);
 #else
     const u32 requiredFeaturesCount   = 0;
     WGPUFeatureName* requiredFeatures = NULL;
@@ -377,7 +435,12 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
 
     // determine swapchain format
     // note: we try to always pick an 8unorm format
-    {
+    if (!context->surface) {
+        // offscreen frames are only ever drawn to and copied out of
+        context->surface_format = WGPUTextureFormat_BGRA8Unorm;
+        context->surface_usage
+          = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc;
+    } else {
         WGPUSurfaceCapabilities surface_capabilities;
         wgpuSurfaceGetCapabilities(context->surface, adapter, &surface_capabilities);
         context->surface_format = WGPUTextureFormat_Undefined;
@@ -395,12 +458,19 @@ bool GraphicsContext::init(GraphicsContext* context, GLFWwindow* window)
             ASSERT(false);
             return false;
         }
+
+        // copying out of the swapchain is how GG.record() captures the window
+        context->surface_usage
+          = WGPUTextureUsage_RenderAttachment
+            | (surface_capabilities.usages & WGPUTextureUsage_CopySrc);
     }
     log_info("Surface texture format: %s",
              G_Util::textureFormatToString(context->surface_format));
 
     int framebuffer_width = 1, framebuffer_height = 1;
-    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    if (window) {
+        glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    }
     GraphicsContext_ConfigureSurface(context, (u32)framebuffer_width,
                                      (u32)framebuffer_height);
 
@@ -447,9 +517,15 @@ static WGPUTextureView GraphicsContext_GetNextSurfaceTextureView(GraphicsContext
 
 {
     // Get the surface texture
-    wgpuSurfaceGetCurrentTexture(gctx->surface, &gctx->surface_texture);
-    if (gctx->surface_texture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
-        return nullptr;
+    if (gctx->surface) {
+        wgpuSurfaceGetCurrentTexture(gctx->surface, &gctx->surface_texture);
+        if (gctx->surface_texture.status
+            != WGPUSurfaceGetCurrentTextureStatus_Success) {
+            return nullptr;
+        }
+    } else {
+        // not owned, stays alive across frames
+        gctx->surface_texture.texture = gctx->offscreen_texture;
     }
 
     // Create a view for this surface texture
@@ -497,14 +573,18 @@ void GraphicsContext::presentFrame(GraphicsContext* ctx)
 
     // present
 #ifndef __EMSCRIPTEN__
-    wgpuSurfacePresent(ctx->surface);
+    if (ctx->surface) wgpuSurfacePresent(ctx->surface);
 #endif
 
     // free surface texture
     // #ifndef WEBGPU_BACKEND_WGPU
     // We no longer need the texture, only its view
     // (NB: with wgpu-native, surface textures must not be manually released)
-    WGPU_RELEASE_RESOURCE(Texture, ctx->surface_texture.texture);
+    if (ctx->surface) {
+        WGPU_RELEASE_RESOURCE(Texture, ctx->surface_texture.texture);
+    } else {
+        ctx->surface_texture.texture = NULL; // the offscreen texture
+    }
     // #endif // WEBGPU_BACKEND_WGPU
 
     WGPU_RELEASE_RESOURCE(CommandBuffer, command);
@@ -535,8 +615,12 @@ void GraphicsContext::release(GraphicsContext* ctx)
     // mip map gen
     MipMapGenerator_release();
 
-    wgpuSurfaceUnconfigure(ctx->surface);
-    wgpuSurfaceRelease(ctx->surface);
+    if (ctx->surface) {
+        wgpuSurfaceUnconfigure(ctx->surface);
+        wgpuSurfaceRelease(ctx->surface);
+    }
+    WGPU_DESTROY_RESOURCE(Texture, ctx->offscreen_texture);
+    WGPU_RELEASE_RESOURCE(Texture, ctx->offscreen_texture);
 
     wgpuQueueRelease(ctx->queue);
     wgpuDeviceRelease(ctx->device);
@@ -792,15 +876,77 @@ int G_bytesPerTexel(WGPUTextureFormat format)
             return 1;
         case WGPUTextureFormat_RGBA8Unorm:
         case WGPUTextureFormat_RGBA8UnormSrgb:
+        case WGPUTextureFormat_BGRA8Unorm:
+        case WGPUTextureFormat_BGRA8UnormSrgb:
             return 4;
         case WGPUTextureFormat_RGBA16Float: return 8;
         case WGPUTextureFormat_RGBA32Float: return 16;
         case WGPUTextureFormat_R32Float: return 4;
+        case WGPUTextureFormat_Depth32Float: return 4;
         default: ASSERT(false);
     }
     return 0;
 }
 
+// clang-format off
+static const struct {
+    WGPUTextureFormat format;
+    TextureBlockFormat block_format;
+    bool srgb;
+} _g_block_formats[] = {
+    { WGPUTextureFormat_RGBA8Unorm,         TextureBlockFormat_RGBA8,      false },
+    { WGPUTextureFormat_RGBA8UnormSrgb,     TextureBlockFormat_RGBA8,      true  },
+    { WGPUTextureFormat_BC1RGBAUnorm,       TextureBlockFormat_BC1,        false },
+    { WGPUTextureFormat_BC1RGBAUnormSrgb,   TextureBlockFormat_BC1,        true  },
+    { WGPUTextureFormat_BC3RGBAUnorm,       TextureBlockFormat_BC3,        false },
+    { WGPUTextureFormat_BC3RGBAUnormSrgb,   TextureBlockFormat_BC3,        true  },
+    { WGPUTextureFormat_BC4RUnorm,          TextureBlockFormat_BC4,        false },
+    { WGPUTextureFormat_BC5RGUnorm,         TextureBlockFormat_BC5,        false },
+    { WGPUTextureFormat_BC7RGBAUnorm,       TextureBlockFormat_BC7,        false },
+    { WGPUTextureFormat_BC7RGBAUnormSrgb,   TextureBlockFormat_BC7,        true  },
+    { WGPUTextureFormat_ETC2RGB8Unorm,      TextureBlockFormat_ETC2_RGB8,  false },
+    { WGPUTextureFormat_ETC2RGB8UnormSrgb,  TextureBlockFormat_ETC2_RGB8,  true  },
+    { WGPUTextureFormat_ETC2RGBA8Unorm,     TextureBlockFormat_ETC2_RGBA8, false },
+    { WGPUTextureFormat_ETC2RGBA8UnormSrgb, TextureBlockFormat_ETC2_RGBA8, true  },
+    { WGPUTextureFormat_ASTC4x4Unorm,       TextureBlockFormat_ASTC_4x4,   false },
+    { WGPUTextureFormat_ASTC4x4UnormSrgb,   TextureBlockFormat_ASTC_4x4,   true  },
+};
+// clang-format on
+
+TextureBlockFormat G_textureBlockFormat(WGPUTextureFormat format)
+{
+    for (u32 i = 0; i < ARRAY_LENGTH(_g_block_formats); i++) {
+        if (_g_block_formats[i].format == format)
+            return _g_block_formats[i].block_format;
+    }
+    return TextureBlockFormat_None;
+}
+
+WGPUTextureFormat G_textureFormat(TextureBlockFormat format, bool srgb)
+{
+    for (u32 i = 0; i < ARRAY_LENGTH(_g_block_formats); i++) {
+        if (_g_block_formats[i].block_format == format
+            && _g_block_formats[i].srgb == srgb)
+            return _g_block_formats[i].format;
+    }
+    return WGPUTextureFormat_Undefined;
+}
+
+bool G_isCompressedFormat(WGPUTextureFormat format)
+{
+    TextureBlockFormat block_format = G_textureBlockFormat(format);
+    return block_format != TextureBlockFormat_None
+           && block_format != TextureBlockFormat_RGBA8;
+}
+
+u64 G_textureLevelBytes(WGPUTextureFormat format, u32 width, u32 height)
+{
+    if (G_isCompressedFormat(format)) {
+        return TextureTranscode_LevelBytes(G_textureBlockFormat(format), width, height);
+    }
+    return (u64)width * height * G_bytesPerTexel(format);
+}
+
 // TODO make part of GraphicsContext and cleanup
 struct {
     WGPUSampler sampler;
@@ -1222,9 +1368,144 @@ bool GPU_Buffer::resizeNoCopy(GraphicsContext* gctx, GPU_Buffer* gpu_buffer,
     // update buffer
     gpu_buffer->buf  = wgpuDeviceCreateBuffer(gctx->device, &desc);
     gpu_buffer->size = new_size;
+    ++g_gpu_resource_epoch;
     return true;
 }
 
+// ============================================================================
+// G_UniformPool
+// ============================================================================
+
+void G_UniformPool::init(G_UniformPool* pool, WGPULimits* limits, u32 data_size)
+{
+    *pool                 = {};
+    pool->data_size       = NEXT_MULT4(data_size);
+    pool->block_size      = ALIGN_NON_POW2(MAX(data_size, 1),
+                                           limits->minUniformBufferOffsetAlignment);
+    pool->blocks_per_page = G_UNIFORM_POOL_PAGE_BYTES / pool->block_size;
+    ASSERT(pool->blocks_per_page > 0);
+    Arena::init(&pool->pages, 8 * sizeof(G_UniformPoolPage));
+    Arena::init(&pool->free_list, 64 * sizeof(u32));
+}
+
+void G_UniformPool::release(G_UniformPool* pool)
+{
+    int page_count = ARENA_LENGTH(&pool->pages, G_UniformPoolPage);
+    for (int i = 0; i < page_count; i++) {
+        G_UniformPoolPage* page = ARENA_GET_TYPE(&pool->pages, G_UniformPoolPage, i);
+        WGPU_RELEASE_RESOURCE(Buffer, page->buf);
+        ::free(page->cpu_MALLOC);
+        ::free(page->dirty_MALLOC);
+    }
+    Arena::free(&pool->pages);
+    Arena::free(&pool->free_list);
+    *pool = {};
+}
+
+u32 G_UniformPool::alloc(G_UniformPool* pool, GraphicsContext* gctx)
+{
+    ASSERT(pool->block_size);
+    ++pool->lifetime_stats.blocks_used;
+
+    // reuse a freed block
+    if (ARENA_LENGTH(&pool->free_list, u32) > 0) {
+        u32 block = *ARENA_GET_LAST_TYPE(&pool->free_list, u32);
+        ARENA_POP_TYPE(&pool->free_list, u32);
+        G_UniformPool::write(pool, block, NULL, pool->data_size);
+        return block;
+    }
+
+    // all pages full, add a page. Existing pages are never resized, so blocks
+    // already handed out (and bindgroups referencing them) stay valid
+    u32 block = pool->block_count++;
+    if (block % pool->blocks_per_page == 0) {
+        G_UniformPoolPage* page = ARENA_PUSH_ZERO_TYPE(&pool->pages, G_UniformPoolPage);
+
+        WGPUBufferDescriptor desc = {};
+        desc.label                = "Material Uniform Pool";
+        desc.size                 = pool->blocks_per_page * pool->block_size;
+        desc.usage                = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+        page->buf                 = wgpuDeviceCreateBuffer(gctx->device, &desc);
+        page->cpu_MALLOC          = (u8*)calloc(desc.size, 1);
+        page->dirty_MALLOC
+          = (u64*)calloc((pool->blocks_per_page + 63) / 64, sizeof(u64));
+
+        ++pool->lifetime_stats.gpu_buffers;
+        log_trace("Uniform pool: creating page %d (%llu bytes)",
+                  ARENA_LENGTH(&pool->pages, G_UniformPoolPage) - 1, desc.size);
+    }
+
+    // new GPU buffers are zero initialized, nothing to upload
+    return block;
+}
+
+void G_UniformPool::free(G_UniformPool* pool, u32 block)
+{
+    ASSERT(block < pool->block_count);
+    --pool->lifetime_stats.blocks_used;
+    *ARENA_PUSH_TYPE(&pool->free_list, u32) = block;
+}
+
+void G_UniformPool::write(G_UniformPool* pool, u32 block, const void* data, u32 size)
+{
+    ASSERT(block < pool->block_count);
+    ASSERT(size <= pool->data_size);
+
+    u32 page_idx            = block / pool->blocks_per_page;
+    u32 idx                 = block % pool->blocks_per_page;
+    G_UniformPoolPage* page = ARENA_GET_TYPE(&pool->pages, G_UniformPoolPage, page_idx);
+    u8* dst                 = page->cpu_MALLOC + idx * pool->block_size;
+    data ? memcpy(dst, data, size) : memset(dst, 0, size);
+
+    u64 bit = 1ULL << (idx % 64);
+    if ((page->dirty_MALLOC[idx / 64] & bit) == 0) {
+        page->dirty_MALLOC[idx / 64] |= bit;
+        ++page->dirty_count;
+    }
+}
+
+void G_UniformPool::flush(G_UniformPool* pool, WGPUQueue queue)
+{
+    pool->frame_stats             = {};
+    pool->frame_stats.gpu_buffers = pool->lifetime_stats.gpu_buffers;
+    pool->frame_stats.blocks_used = pool->lifetime_stats.blocks_used;
+
+    int page_count = ARENA_LENGTH(&pool->pages, G_UniformPoolPage);
+    for (int p = 0; p < page_count; p++) {
+        G_UniformPoolPage* page = ARENA_GET_TYPE(&pool->pages, G_UniformPoolPage, p);
+        if (page->dirty_count == 0) continue;
+
+        // upload each run of consecutive dirty blocks with a single write.
+        // The last block of a run only needs its data, not the alignment padding
+        u32 run_start = 0, run_len = 0;
+        for (u32 i = 0; i <= pool->blocks_per_page; i++) {
+            bool dirty = i < pool->blocks_per_page
+                         && (page->dirty_MALLOC[i / 64] & (1ULL << (i % 64)));
+            if (dirty) {
+                if (run_len == 0) run_start = i;
+                ++run_len;
+                continue;
+            }
+            if (run_len == 0) continue;
+
+            u64 offset = run_start * pool->block_size;
+            u64 size   = (run_len - 1) * pool->block_size + pool->data_size;
+            wgpuQueueWriteBuffer(queue, page->buf, offset, page->cpu_MALLOC + offset,
+                                 size);
+            ++pool->frame_stats.uploads;
+            pool->frame_stats.upload_bytes += size;
+            run_len = 0;
+        }
+
+        memset(page->dirty_MALLOC, 0,
+               ((pool->blocks_per_page + 63) / 64) * sizeof(u64));
+        page->dirty_count = 0;
+    }
+
+    pool->lifetime_stats.uploads += pool->frame_stats.uploads;
+    pool->lifetime_stats.upload_bytes += pool->frame_stats.upload_bytes;
+}
+
 WGPUTextureFormat G_Util::textureFormatSrgbVariant(WGPUTextureFormat format)
 {
     if (format == WGPUTextureFormat_BGRA8Unorm) return WGPUTextureFormat_BGRA8UnormSrgb;
@@ -1270,6 +1551,38 @@ bool G_Util::isDepthTextureFormat(WGPUTextureFormat format)
             || format == WGPUTextureFormat_Depth32FloatStencil8);
 }
 
+WGPUTextureFormat G_Util::textureFormatFromWGSL(const char* texel_format)
+{
+    static const struct {
+        const char* name;
+        WGPUTextureFormat format;
+    } storage_formats[] = {
+        { "rgba8unorm", WGPUTextureFormat_RGBA8Unorm },
+        { "rgba8snorm", WGPUTextureFormat_RGBA8Snorm },
+        { "rgba8uint", WGPUTextureFormat_RGBA8Uint },
+        { "rgba8sint", WGPUTextureFormat_RGBA8Sint },
+        { "rgba16uint", WGPUTextureFormat_RGBA16Uint },
+        { "rgba16sint", WGPUTextureFormat_RGBA16Sint },
+        { "rgba16float", WGPUTextureFormat_RGBA16Float },
+        { "r32uint", WGPUTextureFormat_R32Uint },
+        { "r32sint", WGPUTextureFormat_R32Sint },
+        { "r32float", WGPUTextureFormat_R32Float },
+        { "rg32uint", WGPUTextureFormat_RG32Uint },
+        { "rg32sint", WGPUTextureFormat_RG32Sint },
+        { "rg32float", WGPUTextureFormat_RG32Float },
+        { "rgba32uint", WGPUTextureFormat_RGBA32Uint },
+        { "rgba32sint", WGPUTextureFormat_RGBA32Sint },
+        { "rgba32float", WGPUTextureFormat_RGBA32Float },
+        { "bgra8unorm", WGPUTextureFormat_BGRA8Unorm },
+    };
+
+    for (size_t i = 0; i < ARRAY_LENGTH(storage_formats); i++) {
+        if (strcmp(texel_format, storage_formats[i].name) == 0)
+            return storage_formats[i].format;
+    }
+    return WGPUTextureFormat_Undefined;
+}
+
 const char* G_Util::textureFormatToString(WGPUTextureFormat format)
 {
     switch (format) {
@@ -27,8 +27,10 @@
 -----------------------------------------------------------------------------*/
 #pragma once
 
+#include "core/log.h"
 #include "core/macros.h"
 #include "core/memory.h"
+#include "texture_transcode.h"
 
 #include <glfw3webgpu/glfw3webgpu.h>
 #include <webgpu/webgpu.h>
@@ -71,6 +73,8 @@ struct GraphicsContext {
     WGPUSurface surface;
     WGPUSurfaceTexture surface_texture;
     WGPUTextureFormat surface_format;
+    WGPUTextureUsageFlags surface_usage; // includes CopySrc if frames can be recorded
+    WGPUTexture offscreen_texture;       // replaces the surface without a window
 
     // Per frame resources --------
     WGPUTextureView backbufferView; // still need this for imgui
@@ -82,6 +86,8 @@ struct GraphicsContext {
 
     // Device limits --------
     WGPULimits limits;
+    bool timestamp_queries;  // per pass GPU times for GG.profile()
+    u32 texture_compression; // TextureCompression flags, see texture_transcode.h
 
     // Default resources ---------
     WGPUSampler shadow_comparison_sampler;
@@ -92,6 +98,8 @@ struct GraphicsContext {
     char label[256];
 
     // Methods --------
+    // window NULL renders to an offscreen texture, falling back to a software
+    // adapter if there is no GPU
     static bool init(GraphicsContext* context, GLFWwindow* window);
     static bool prepareFrame(GraphicsContext* ctx);
     static void presentFrame(GraphicsContext* ctx);
@@ -103,6 +111,11 @@ struct GraphicsContext {
 // Buffers
 // =============================================================================
 
+// incremented whenever a buffer or texture that can be bound in a bindgroup is
+// (re)created. The old WGPU handle may be swapped out or even reused, so persistent
+// bindgroups (see G_BindGroupSlots) built before the change are invalid
+extern u64 g_gpu_resource_epoch;
+
 struct G_DynamicGPUBuffer { // for use with dynamic bg offsets
     Arena cpu_buffer;
     WGPUBuffer gpu_buffer;
@@ -158,6 +171,7 @@ struct G_DynamicGPUBuffer { // for use with dynamic bg offsets
             desc.size                 = cpu_buffer.cap;
             desc.usage                = usage | WGPUBufferUsage_CopyDst;
             gpu_buffer                = wgpuDeviceCreateBuffer(device, &desc);
+            ++g_gpu_resource_epoch;
         }
 
         // copy CPU -> GPU
@@ -202,6 +216,7 @@ struct GPU_Buffer {
 
         // update buffer
         gpu_buffer->buf = new_buf;
+        ++g_gpu_resource_epoch;
     }
 
     // returns true if buffer was recreated (because of capacity or usage flags)
@@ -245,6 +260,7 @@ struct GPU_Buffer {
 
             // update buffer
             gpu_buffer->buf = new_buf;
+            ++g_gpu_resource_epoch;
         }
 
         wgpuQueueWriteBuffer(gctx->queue, gpu_buffer->buf, offset, data, size);
@@ -265,6 +281,74 @@ struct GPU_Buffer {
     }
 };
 
+// Persistent pool of fixed-size uniform blocks, packed into a few large GPU buffers
+// (pages). Blocks are aligned to minUniformBufferOffsetAlignment and never move, so
+// a bindgroup pointing at a block stays valid until the block is freed.
+// Writes go to a CPU mirror; dirty blocks are uploaded once per frame by flush(),
+// coalesced into contiguous ranges
+#define G_UNIFORM_POOL_PAGE_BYTES (256 * KILOBYTE)
+
+struct G_UniformPoolPage {
+    WGPUBuffer buf;
+    u8* cpu_MALLOC;    // mirror of buf
+    u64* dirty_MALLOC; // bitset, 1 bit per block
+    u32 dirty_count;
+};
+
+struct G_UniformPoolStats {
+    int gpu_buffers; // pages
+    int blocks_used;
+    int uploads; // wgpuQueueWriteBuffer calls
+    u64 upload_bytes;
+
+    void log()
+    {
+        log_trace(
+          "\n"
+          "Uniform Pool GPU Buffers: %d\n"
+          "Uniform Pool Blocks Used: %d\n"
+          "Uniform Pool Uploads: %d\n"
+          "Uniform Pool Upload Bytes: %llu\n",
+          gpu_buffers, blocks_used, uploads, upload_bytes);
+    }
+};
+
+struct G_UniformPool {
+    u32 block_size; // aligned stride between blocks in bytes
+    u32 data_size;  // bytes actually used per block
+    u32 blocks_per_page;
+    u32 block_count; // blocks handed out so far, including freed ones
+    Arena pages;     // G_UniformPoolPage
+    Arena free_list; // u32 freed block ids
+
+    G_UniformPoolStats frame_stats; // uploads since last flush
+    G_UniformPoolStats lifetime_stats;
+
+    static void init(G_UniformPool* pool, WGPULimits* limits, u32 data_size);
+    static void release(G_UniformPool* pool);
+
+    // returns a zeroed block id
+    static u32 alloc(G_UniformPool* pool, GraphicsContext* gctx);
+    static void free(G_UniformPool* pool, u32 block);
+
+    // marks the block dirty. data == NULL zeroes the first `size` bytes
+    static void write(G_UniformPool* pool, u32 block, const void* data, u32 size);
+
+    // uploads all dirty blocks
+    static void flush(G_UniformPool* pool, WGPUQueue queue);
+
+    static WGPUBuffer buffer(G_UniformPool* pool, u32 block)
+    {
+        u32 page = block / pool->blocks_per_page;
+        return ARENA_GET_TYPE(&pool->pages, G_UniformPoolPage, page)->buf;
+    }
+
+    static u32 offset(G_UniformPool* pool, u32 block)
+    {
+        return (block % pool->blocks_per_page) * pool->block_size;
+    }
+};
+
 // ============================================================================
 // Attributes
 // ============================================================================
@@ -365,6 +449,11 @@ WGPUTextureView G_createTextureViewAtMipLevel(WGPUTexture texture, u32 base_mip_
 
 int G_componentsPerTexel(WGPUTextureFormat format);
 int G_bytesPerTexel(WGPUTextureFormat format);
+// BC / ETC2 / ASTC, which are written and sized in 4x4 blocks
+bool G_isCompressedFormat(WGPUTextureFormat format);
+TextureBlockFormat G_textureBlockFormat(WGPUTextureFormat format);
+WGPUTextureFormat G_textureFormat(TextureBlockFormat format, bool srgb);
+u64 G_textureLevelBytes(WGPUTextureFormat format, u32 width, u32 height);
 
 struct G_Util {
 
@@ -373,6 +462,8 @@ struct G_Util {
     static void printBindGroupEntry(WGPUBindGroupEntry* entry);
     static void printBindGroupEntryList(WGPUBindGroupEntry* entry, int count);
     static bool isDepthTextureFormat(WGPUTextureFormat format);
+    // WGSL texel format (e.g. "rgba16float"), Undefined if not a storage format
+    static WGPUTextureFormat textureFormatFromWGSL(const char* texel_format);
 
     // WGPU Enum --> string
     static const char* textureFormatToString(WGPUTextureFormat format);
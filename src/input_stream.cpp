@@ -0,0 +1,134 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "input_stream.h"
+
+#include <chrono>
+
+static const char* _input_event_type_names[] = {
+    "none",     "key_down",   "key_up", "key_repeat",   "mouse_down",
+    "mouse_up", "mouse_move", "scroll", "gamepad_down", "gamepad_up",
+};
+static_assert(ARRAY_LENGTH(_input_event_type_names) == InputEvent_Count,
+              "input event type names");
+
+u64 InputStream_Now()
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+const char* InputStream_TypeName(InputEventType type)
+{
+    return type < InputEvent_Count ? _input_event_type_names[type] : "unknown";
+}
+
+bool InputQueue_Push(InputQueue* q, const InputEvent* event)
+{
+    u64 head = q->head.load(std::memory_order_relaxed);
+    if (head - q->tail.load(std::memory_order_acquire) == INPUT_QUEUE_CAPACITY) {
+        q->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    q->events[head % INPUT_QUEUE_CAPACITY] = *event;
+    q->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue_Pop(InputQueue* q, InputEvent* event)
+{
+    u64 tail = q->tail.load(std::memory_order_relaxed);
+    if (tail == q->head.load(std::memory_order_acquire)) return false;
+    *event = q->events[tail % INPUT_QUEUE_CAPACITY];
+    q->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void InputHistory_Append(InputHistory* history, InputEvent event)
+{
+    event.seq = ++history->count;
+    history->events[(event.seq - 1) % INPUT_HISTORY_CAPACITY] = event;
+}
+
+int InputHistory_Drain(InputHistory* history, InputQueue* q)
+{
+    int count = 0;
+    InputEvent event;
+    while (InputQueue_Pop(q, &event)) {
+        InputHistory_Append(history, event);
+        count++;
+    }
+    return count;
+}
+
+bool InputHistory_Next(InputHistory* history, u64* cursor, InputEvent* event,
+                       u64* missed)
+{
+    if (*cursor >= history->count) return false;
+
+    u64 oldest = history->count > INPUT_HISTORY_CAPACITY ?
+                   history->count - INPUT_HISTORY_CAPACITY + 1 :
+                   1;
+    u64 seq = *cursor + 1;
+    if (seq < oldest) {
+        if (missed) *missed += oldest - seq;
+        seq = oldest;
+    }
+    *event  = history->events[(seq - 1) % INPUT_HISTORY_CAPACITY];
+    *cursor = seq;
+    return true;
+}
+
+void InputClock_Observe(InputClock* clock, f64 now_samples, f64 srate, u64 wall_ns)
+{
+    if (srate <= 0) return;
+    f64 lag = (f64)wall_ns - now_samples / srate * 1e9;
+
+    if (!clock->valid) {
+        clock->window_min      = lag;
+        clock->prev_min        = lag;
+        clock->window_start_ns = wall_ns;
+        clock->valid           = true;
+    } else if (wall_ns - clock->window_start_ns > INPUT_CLOCK_WINDOW_NS) {
+        // forget old minimums, so the estimate follows drift between the
+        // audio device and the wall clock, and time jumps (e.g. a stalled VM)
+        clock->prev_min        = clock->window_min;
+        clock->window_min      = lag;
+        clock->window_start_ns = wall_ns;
+    } else {
+        clock->window_min = MIN(clock->window_min, lag);
+    }
+    clock->lag_ns = MIN(clock->window_min, clock->prev_min);
+}
+
+f64 InputClock_SampleAt(const InputClock* clock, u64 wall_ns, f64 srate,
+                        f64 now_samples)
+{
+    if (!clock->valid || srate <= 0) return now_samples;
+    return ((f64)wall_ns - clock->lag_ns) * srate / 1e9;
+}
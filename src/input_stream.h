@@ -0,0 +1,134 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+#include <atomic>
+
+/*
+Timestamped input event stream
+
+GLFW callbacks on the render thread push every key, mouse button, cursor, scroll
+and gamepad button event, stamped with the time of the callback, into an
+InputQueue (single producer / single consumer, lock free, a full queue drops and
+counts). They never merge: two clicks in one frame are two events.
+
+The audio thread drains the queue into an InputHistory, which any number of
+readers (InputMsg's in chuck) walk at their own pace, each with the sequence
+number of the last event it received. Readers that fall more than
+INPUT_HISTORY_CAPACITY events behind skip ahead and count what they missed. The
+history holds a full queue, so a reader that drains and reads loses nothing.
+
+InputClock turns a callback time into chuck time. Chuck computes audio in
+blocks, ahead of the wall clock, so each sample's "lag" (wall time it was
+computed at minus its nominal time) jumps around by up to a block. The smallest
+lag seen recently is when chuck was furthest ahead, so mapping event times with
+it puts each event on the last sample computed by then. Adding a constant
+latency to that gives input-to-sound timing without the jitter of when the
+shred happened to wake up.
+
+Knows nothing about GLFW or chuck, so it can be tested on the CPU.
+*/
+
+#define INPUT_QUEUE_CAPACITY 1024
+#define INPUT_HISTORY_CAPACITY INPUT_QUEUE_CAPACITY
+#define INPUT_CLOCK_WINDOW_NS 2000000000ull // lag minimum is taken over 2-4 seconds
+
+enum InputEventType : u8 {
+    InputEvent_None = 0,
+    InputEvent_KeyDown,
+    InputEvent_KeyUp,
+    InputEvent_KeyRepeat,
+    InputEvent_MouseDown,
+    InputEvent_MouseUp,
+    InputEvent_MouseMove,
+    InputEvent_Scroll,
+    InputEvent_GamepadDown,
+    InputEvent_GamepadUp,
+    InputEvent_Count,
+};
+
+struct InputEvent {
+    u64 time_ns; // InputStream_Now() of the callback
+    u64 seq;     // 1 + events before it, assigned by InputHistory_Append
+    u8 type;     // InputEventType
+    i32 code;    // key, mouse button or gamepad button
+    i32 mods;    // GLFW_MOD_* for key and mouse events
+    i32 device;  // gamepad index
+    f64 x, y;    // cursor position, or scroll offset
+};
+
+struct InputQueue {
+    InputEvent events[INPUT_QUEUE_CAPACITY];
+    std::atomic<u64> head; // written by the producer
+    std::atomic<u64> tail; // written by the consumer
+    std::atomic<u64> dropped;
+};
+
+struct InputHistory {
+    InputEvent events[INPUT_HISTORY_CAPACITY];
+    u64 count; // events ever appended, the seq of the newest
+};
+
+struct InputClock {
+    f64 lag_ns;      // min over the current and the previous window
+    f64 window_min;  // current window
+    f64 prev_min;    // previous window
+    u64 window_start_ns;
+    bool valid;
+};
+
+u64 InputStream_Now(); // ns, steady clock
+
+const char* InputStream_TypeName(InputEventType type);
+
+// producer. false if the queue is full, which is counted in `dropped`
+bool InputQueue_Push(InputQueue* q, const InputEvent* event);
+
+// consumer
+bool InputQueue_Pop(InputQueue* q, InputEvent* event);
+
+// moves everything queued into the history. Returns how many
+int InputHistory_Drain(InputHistory* history, InputQueue* q);
+
+void InputHistory_Append(InputHistory* history, InputEvent event);
+
+// the next event after `*cursor` (a seq, 0 for from the start). Advances the
+// cursor. Events that were overwritten before the reader got to them are skipped
+// and added to `missed`, if given
+bool InputHistory_Next(InputHistory* history, u64* cursor, InputEvent* event,
+                       u64* missed);
+
+// records that sample `now_samples` was being computed at `wall_ns`
+void InputClock_Observe(InputClock* clock, f64 now_samples, f64 srate, u64 wall_ns);
+
+// the sample chuck had computed up to at `wall_ns`. Falls back to `now_samples`
+// before the first observation
+f64 InputClock_SampleAt(const InputClock* clock, u64 wall_ns, f64 srate,
+                        f64 now_samples);
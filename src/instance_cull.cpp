@@ -0,0 +1,102 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "instance_cull.h"
+
+#include <math.h>
+#include <string.h>
+
+glm::vec4 InstanceCull_LocalSphere(glm::vec3 bounds_min, glm::vec3 bounds_max)
+{
+    return glm::vec4((bounds_min + bounds_max) * 0.5f,
+                     glm::length(bounds_max - bounds_min) * 0.5f);
+}
+
+glm::vec4 InstanceCull_WorldSphere(glm::mat4 model, glm::vec4 local_sphere)
+{
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(local_sphere), 1.0f));
+    glm::mat3 m      = glm::mat3(model);
+    f32 scale2       = MAX(glm::dot(m[0], m[0]),
+                           MAX(glm::dot(m[1], m[1]), glm::dot(m[2], m[2])));
+    return glm::vec4(center, local_sphere.w * sqrtf(scale2));
+}
+
+void InstanceCull_FrustumPlanes(glm::mat4 projection, glm::mat4 view,
+                                glm::vec4 planes[6])
+{
+    // Gribb & Hartmann: a clip space bound -w <= x is row3 + row0 >= 0, etc.
+    // Depth is 0 <= z <= w, so the near plane is row2 alone
+    glm::mat4 m = projection * view;
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; i++) planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+bool InstanceCull_SphereVisible(const glm::vec4 planes[6], glm::vec4 sphere)
+{
+    for (int i = 0; i < 6; i++) {
+        f32 dist = glm::dot(glm::vec3(planes[i]), glm::vec3(sphere)) + planes[i].w;
+        if (dist < -sphere.w) return false;
+    }
+    return true;
+}
+
+u32 InstanceCull_Run(const InstanceCullParams* params, glm::mat4 projection,
+                     glm::mat4 view, const void* instances, u32 stride,
+                     void* visible, u32 args[INSTANCE_CULL_ARGS_COUNT])
+{
+    glm::vec4 planes[6];
+    InstanceCull_FrustumPlanes(projection, view, planes);
+
+    // the kernel's prefix sum places visible instance i after every visible
+    // instance before it, which is just this loop
+    u32 visible_count = 0;
+    for (u32 i = 0; i < params->instance_count; i++) {
+        const u8* instance = (const u8*)instances + (u64)i * stride;
+        glm::mat4 model;
+        memcpy(&model, instance, sizeof(model));
+
+        glm::vec4 sphere = InstanceCull_WorldSphere(model, params->sphere);
+        if (!InstanceCull_SphereVisible(planes, sphere)) continue;
+
+        memcpy((u8*)visible + (u64)visible_count++ * stride, instance, stride);
+    }
+
+    args[0] = params->element_count;
+    args[1] = visible_count;
+    args[2] = 0;
+    args[3] = 0;
+    args[4] = 0;
+    return visible_count;
+}
@@ -0,0 +1,94 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+#include <glm/glm.hpp>
+
+/*
+GPU instance culling
+
+Instanced draws normally send every instance of a primitive, or the ones the CPU
+picked while rebuilding its storage buffer each frame (see mesh_lod.h). With
+GScene.gpuCulling() the DrawUniforms of large opaque primitives stay in their
+storage buffer untouched, and a compute pass run right before the scene pass
+culls them instead:
+
+- each instance's bounding sphere is tested against the frustum planes of the
+  pass camera, read from its FrameUniforms
+- visible instances are copied, in instance order, into a second storage buffer
+  that the draw binds in place of the full one. Vertex shaders index it with
+  instance_index as before, so materials need no changes
+- the visible count is written into the arguments of an indirect draw
+
+The kernel (instance_cull_shader_string in shaders.h) is a single workgroup of
+INSTANCE_CULL_WORKGROUP_SIZE threads stepping through the instances. Each step is
+compacted with a workgroup prefix sum rather than atomics, so the output order
+never depends on thread scheduling and InstanceCull_Run() below produces exactly
+what the GPU writes. Knows nothing about the renderer, so it can be tested on
+the CPU.
+
+Must stay in sync with instance_cull_shader_string
+*/
+
+#define INSTANCE_CULL_WORKGROUP_SIZE 256
+// indexCount, instanceCount, firstIndex, baseVertex, firstInstance. Also read as
+// vertexCount, instanceCount, firstVertex, firstInstance by non-indexed draws
+#define INSTANCE_CULL_ARGS_COUNT 5
+
+// kernel uniforms, CullParams in the shader
+struct InstanceCullParams {
+    glm::vec4 sphere; // local space bounding sphere, xyz center and w radius
+    u32 instance_count;
+    u32 element_count; // index (or vertex) count of the indirect draw
+    u32 _pad[2];
+};
+
+// bounding sphere of an axis-aligned box, xyz center and w radius
+glm::vec4 InstanceCull_LocalSphere(glm::vec3 bounds_min, glm::vec3 bounds_max);
+
+// local sphere moved by `model`, its radius scaled by the largest axis scale
+glm::vec4 InstanceCull_WorldSphere(glm::mat4 model, glm::vec4 local_sphere);
+
+// frustum planes of projection * view for 0..1 clip depth, in order left, right,
+// bottom, top, near, far. Normals (xyz) point inward and are normalized, so
+// dot(xyz, p) + w is the signed distance of p from the plane
+void InstanceCull_FrustumPlanes(glm::mat4 projection, glm::mat4 view,
+                                glm::vec4 planes[6]);
+
+// false if the sphere is fully outside any of the planes
+bool InstanceCull_SphereVisible(const glm::vec4 planes[6], glm::vec4 sphere);
+
+// CPU reference of the kernel. instances are instance_count elements `stride`
+// bytes apart, each starting with its column-major model matrix. Visible ones are
+// copied to `visible` (same stride) in order, and args gets the indirect draw
+// arguments. Returns the visible count
+u32 InstanceCull_Run(const InstanceCullParams* params, glm::mat4 projection,
+                     glm::mat4 view, const void* instances, u32 stride,
+                     void* visible, u32 args[INSTANCE_CULL_ARGS_COUNT]);
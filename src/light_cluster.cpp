@@ -0,0 +1,209 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "light_cluster.h"
+
+#include <float.h>
+#include <math.h>
+
+void LightCluster_BuildGrid(LightClusterGrid* grid, glm::mat4 projection, f32 z_near,
+                            f32 z_far, bool log_slicing)
+{
+    // exponential slicing is undefined for a near plane at or behind the camera
+    grid->log_slicing = log_slicing && z_near > 0.0f;
+    grid->z_near      = z_near;
+    grid->z_far       = MAX(z_far, z_near + EPSILON);
+
+    glm::mat4 inv_proj = glm::inverse(projection);
+
+    // for each tile corner, the view-space line through that corner.
+    // two points at different NDC depths define it for both perspective
+    // (ray through the eye) and orthographic (parallel to -z) projections
+    glm::vec3 line_p0[LIGHT_CLUSTER_Y + 1][LIGHT_CLUSTER_X + 1];
+    glm::vec3 line_p1[LIGHT_CLUSTER_Y + 1][LIGHT_CLUSTER_X + 1];
+    for (int j = 0; j <= LIGHT_CLUSTER_Y; j++) {
+        f32 ndc_y = 1.0f - 2.0f * j / LIGHT_CLUSTER_Y; // tile row 0 is the top
+        for (int i = 0; i <= LIGHT_CLUSTER_X; i++) {
+            f32 ndc_x    = -1.0f + 2.0f * i / LIGHT_CLUSTER_X;
+            glm::vec4 p0 = inv_proj * glm::vec4(ndc_x, ndc_y, 0.0f, 1.0f);
+            glm::vec4 p1 = inv_proj * glm::vec4(ndc_x, ndc_y, 0.5f, 1.0f);
+            line_p0[j][i] = glm::vec3(p0) / p0.w;
+            line_p1[j][i] = glm::vec3(p1) / p1.w;
+        }
+    }
+
+    for (int k = 0; k < LIGHT_CLUSTER_Z; k++) {
+        f32 slice_depths[2]
+          = { LightCluster_SliceDepth(grid, k), LightCluster_SliceDepth(grid, k + 1) };
+
+        for (int j = 0; j < LIGHT_CLUSTER_Y; j++) {
+            for (int i = 0; i < LIGHT_CLUSTER_X; i++) {
+                LightClusterAABB* aabb
+                  = &grid->aabbs[i + j * LIGHT_CLUSTER_X
+                                 + k * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y];
+                aabb->min = glm::vec3(FLT_MAX);
+                aabb->max = glm::vec3(-FLT_MAX);
+
+                // 4 tile corners x 2 slice depths
+                for (int c = 0; c < 4; c++) {
+                    glm::vec3 p0 = line_p0[j + (c >> 1)][i + (c & 1)];
+                    glm::vec3 p1 = line_p1[j + (c >> 1)][i + (c & 1)];
+                    for (int d = 0; d < 2; d++) {
+                        // view space looks down -z
+                        f32 t       = (-slice_depths[d] - p0.z) / (p1.z - p0.z);
+                        glm::vec3 p = p0 + t * (p1 - p0);
+                        aabb->min   = glm::min(aabb->min, p);
+                        aabb->max   = glm::max(aabb->max, p);
+                    }
+                }
+            }
+        }
+    }
+}
+
+f32 LightCluster_SliceDepth(LightClusterGrid* grid, int slice)
+{
+    f32 t = (f32)slice / LIGHT_CLUSTER_Z;
+    if (grid->log_slicing) return grid->z_near * powf(grid->z_far / grid->z_near, t);
+    return grid->z_near + (grid->z_far - grid->z_near) * t;
+}
+
+f32 LightCluster_SliceScale(LightClusterGrid* grid)
+{
+    if (grid->log_slicing) return LIGHT_CLUSTER_Z / logf(grid->z_far / grid->z_near);
+    return LIGHT_CLUSTER_Z / (grid->z_far - grid->z_near);
+}
+
+int LightCluster_Slice(LightClusterGrid* grid, f32 depth)
+{
+    f32 slice = 0.0f;
+    if (grid->log_slicing) {
+        if (depth <= grid->z_near) return 0;
+        slice = logf(depth / grid->z_near) * LightCluster_SliceScale(grid);
+    } else {
+        slice = (depth - grid->z_near) * LightCluster_SliceScale(grid);
+    }
+    return CLAMP((int)floorf(slice), 0, LIGHT_CLUSTER_Z - 1);
+}
+
+int LightCluster_Index(LightClusterGrid* grid, f32 viewport_x, f32 viewport_y,
+                       f32 depth)
+{
+    int x = CLAMP((int)floorf(viewport_x * LIGHT_CLUSTER_X), 0, LIGHT_CLUSTER_X - 1);
+    int y = CLAMP((int)floorf(viewport_y * LIGHT_CLUSTER_Y), 0, LIGHT_CLUSTER_Y - 1);
+    int z = LightCluster_Slice(grid, depth);
+    return x + y * LIGHT_CLUSTER_X + z * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+}
+
+bool LightCluster_SphereIntersectsAABB(LightClusterSphere* sphere,
+                                       LightClusterAABB* aabb)
+{
+    if (sphere->radius < 0.0f) return true;   // infinite extent
+    if (sphere->radius == 0.0f) return false; // no extent
+
+    glm::vec3 closest = glm::clamp(sphere->center, aabb->min, aabb->max);
+    glm::vec3 d       = closest - sphere->center;
+    return glm::dot(d, d) <= sphere->radius * sphere->radius;
+}
+
+int LightCluster_Bin(LightClusterGrid* grid, LightClusterSphere* lights,
+                     int light_count, Arena* out)
+{
+    // scratch list of lights overlapping the current depth slice
+    static Arena slice_lights_arena{};
+    if (slice_lights_arena.base == NULL)
+        Arena::init(&slice_lights_arena, 256 * sizeof(int));
+
+    u64 base = out->curr;
+    ARENA_PUSH_COUNT(out, u32, LIGHT_CLUSTER_HEADER_COUNT);
+
+    for (int k = 0; k < LIGHT_CLUSTER_Z; k++) {
+        Arena::clear(&slice_lights_arena);
+
+        // gather lights whose depth range touches this slice. Widened by a slice
+        // on each side so that float error in the slice mapping can never drop a
+        // light. The exact sphere/AABB test below decides, so output matches the
+        // brute force reference.
+        for (int l = 0; l < light_count; l++) {
+            LightClusterSphere* light = lights + l;
+            if (light->radius >= 0.0f) {
+                f32 depth = -light->center.z;
+                int lo    = LightCluster_Slice(grid, depth - light->radius) - 1;
+                int hi    = LightCluster_Slice(grid, depth + light->radius) + 1;
+                if (k < lo || k > hi) continue;
+            }
+            *ARENA_PUSH_TYPE(&slice_lights_arena, int) = l;
+        }
+
+        int* slice_lights      = (int*)slice_lights_arena.base;
+        int slice_lights_count = ARENA_LENGTH(&slice_lights_arena, int);
+
+        for (int c = k * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+             c < (k + 1) * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y; c++) {
+            u32 offset = (u32)((out->curr - base) / sizeof(u32));
+            u32 count  = 0;
+            for (int s = 0; s < slice_lights_count; s++) {
+                if (LightCluster_SphereIntersectsAABB(lights + slice_lights[s],
+                                                      grid->aabbs + c)) {
+                    *ARENA_PUSH_TYPE(out, u32) = (u32)slice_lights[s];
+                    ++count;
+                }
+            }
+
+            // out may have grown, re-fetch the header
+            u32* header       = (u32*)Arena::get(out, base);
+            header[2 * c + 0] = offset;
+            header[2 * c + 1] = count;
+        }
+    }
+
+    return (int)((out->curr - base) / sizeof(u32));
+}
+
+int LightCluster_BinBruteForce(LightClusterGrid* grid, LightClusterSphere* lights,
+                               int light_count, Arena* out)
+{
+    u64 base = out->curr;
+    ARENA_PUSH_COUNT(out, u32, LIGHT_CLUSTER_HEADER_COUNT);
+
+    for (int c = 0; c < LIGHT_CLUSTER_COUNT; c++) {
+        u32 offset = (u32)((out->curr - base) / sizeof(u32));
+        u32 count  = 0;
+        for (int l = 0; l < light_count; l++) {
+            if (LightCluster_SphereIntersectsAABB(lights + l, grid->aabbs + c)) {
+                *ARENA_PUSH_TYPE(out, u32) = (u32)l;
+                ++count;
+            }
+        }
+
+        u32* header       = (u32*)Arena::get(out, base);
+        header[2 * c + 0] = offset;
+        header[2 * c + 1] = count;
+    }
+
+    return (int)((out->curr - base) / sizeof(u32));
+}
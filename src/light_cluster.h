@@ -0,0 +1,121 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+#include "core/memory.h"
+
+#include <glm/glm.hpp>
+
+/*
+Clustered forward lighting
+
+The camera view volume is split into a grid of froxels (view-space clusters):
+LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y screen tiles, and LIGHT_CLUSTER_Z depth slices.
+Depth slices are exponentially spaced between near and far for perspective
+cameras, and linearly spaced for orthographic cameras.
+
+Each frame, every ScenePass bins its scene's lights into the clusters on the CPU
+and uploads a single u32 storage buffer laid out as:
+
+    [ offset_0, count_0, offset_1, count_1, ... offset_N-1, count_N-1 ]  // header
+    [ light indices ... ]                                                // list
+
+where offset_i is the index (in u32s from the start of the buffer) of cluster i's
+first light index. Lit shaders look up their fragment's cluster and only iterate
+the lights in that cluster's list, rather than every light in the scene.
+
+Cluster index = x + y * LIGHT_CLUSTER_X + z * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y,
+where tile y = 0 is the TOP row of the viewport (matches @builtin(position)).
+
+Must stay in sync with LIGHT_CLUSTER_UNIFORMS in shaders.h
+*/
+
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+#define LIGHT_CLUSTER_HEADER_COUNT (2 * LIGHT_CLUSTER_COUNT) // u32s in header
+
+struct LightClusterAABB {
+    glm::vec3 min; // view space
+    glm::vec3 max;
+};
+
+// bounding sphere of a light in view space
+// radius < 0 means the light has infinite extent (e.g. directional) and is
+// added to every cluster. radius == 0 lights contribute nothing and are never
+// added to any cluster
+struct LightClusterSphere {
+    glm::vec3 center;
+    f32 radius;
+};
+
+struct LightClusterGrid {
+    f32 z_near; // positive view-space distance of the first slice
+    f32 z_far;  // positive view-space distance of the last slice
+    b32 log_slicing;
+    LightClusterAABB aabbs[LIGHT_CLUSTER_COUNT];
+};
+
+// builds the per-cluster view-space AABBs from a camera projection
+// z_near/z_far are the camera clip planes
+void LightCluster_BuildGrid(LightClusterGrid* grid, glm::mat4 projection, f32 z_near,
+                            f32 z_far, bool log_slicing);
+
+// view-space distance (positive) of the near boundary of slice `slice`
+// slice == LIGHT_CLUSTER_Z returns the far boundary of the last slice
+f32 LightCluster_SliceDepth(LightClusterGrid* grid, int slice);
+
+// depth --> slice scale factor, passed to shaders in FrameUniforms
+// log slicing:    slice = log(depth / z_near) * scale
+// linear slicing: slice = (depth - z_near) * scale
+f32 LightCluster_SliceScale(LightClusterGrid* grid);
+
+// which depth slice a positive view-space distance falls in, clamped to grid
+int LightCluster_Slice(LightClusterGrid* grid, f32 depth);
+
+// cluster index for a point given in normalized viewport coords
+// (x right, y DOWN, both in [0,1]) and positive view-space depth.
+// Same mapping as the shader lookup in LIGHT_CLUSTER_UNIFORMS
+int LightCluster_Index(LightClusterGrid* grid, f32 viewport_x, f32 viewport_y,
+                       f32 depth);
+
+bool LightCluster_SphereIntersectsAABB(LightClusterSphere* sphere,
+                                       LightClusterAABB* aabb);
+
+// bins lights into clusters, appending the u32 buffer described above to `out`.
+// light indices in each cluster list are in ascending order.
+// Returns the number of u32s written.
+int LightCluster_Bin(LightClusterGrid* grid, LightClusterSphere* lights,
+                     int light_count, Arena* out);
+
+// reference implementation: tests every light against every cluster.
+// Output is identical to LightCluster_Bin. Used for testing.
+int LightCluster_BinBruteForce(LightClusterGrid* grid, LightClusterSphere* lights,
+                               int light_count, Arena* out);
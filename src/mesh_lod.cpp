@@ -0,0 +1,540 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "mesh_lod.h"
+
+#include "core/memory.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// collapses along the border are weighted this much more than the surface, so the
+// silhouette of open meshes holds up longer
+#define MESH_LOD_BORDER_WEIGHT 10.0
+
+int MeshLOD_Select(f32 screen_size, const f32* lod_screen_sizes, int lod_count,
+                   f32 cull_size)
+{
+    if (screen_size < cull_size) return -1;
+
+    int level = 0;
+    while (level < lod_count && screen_size < lod_screen_sizes[level]) ++level;
+    return level;
+}
+
+f32 MeshLOD_ScreenSize(f32 radius, f32 dist, bool perspective, f32 fov_radians,
+                       f32 ortho_size)
+{
+    if (perspective) {
+        if (dist <= radius) return 1.0f;
+        return radius / (dist * tanf(fov_radians * 0.5f));
+    }
+    return ortho_size > 0.0f ? 2.0f * radius / ortho_size : 1.0f;
+}
+
+// ============================================================================
+// Quadrics
+// ============================================================================
+
+// sum of weighted squared distances to a set of planes, as the symmetric 4x4 matrix
+// [a2 ab ac ad; . b2 bc bd; . . c2 cd; . . . d2] divided by the total weight w
+struct MeshLOD_Quadric {
+    f64 a2, b2, c2, d2;
+    f64 ab, ac, ad, bc, bd, cd;
+    f64 w;
+};
+
+static void MeshLOD_QuadricAddPlane(MeshLOD_Quadric* q, f64 a, f64 b, f64 c, f64 d,
+                                    f64 w)
+{
+    q->a2 += w * a * a;
+    q->b2 += w * b * b;
+    q->c2 += w * c * c;
+    q->d2 += w * d * d;
+    q->ab += w * a * b;
+    q->ac += w * a * c;
+    q->ad += w * a * d;
+    q->bc += w * b * c;
+    q->bd += w * b * d;
+    q->cd += w * c * d;
+    q->w += w;
+}
+
+static void MeshLOD_QuadricAdd(MeshLOD_Quadric* q, const MeshLOD_Quadric* r)
+{
+    q->a2 += r->a2;
+    q->b2 += r->b2;
+    q->c2 += r->c2;
+    q->d2 += r->d2;
+    q->ab += r->ab;
+    q->ac += r->ac;
+    q->ad += r->ad;
+    q->bc += r->bc;
+    q->bd += r->bd;
+    q->cd += r->cd;
+    q->w += r->w;
+}
+
+// mean squared distance from p to the planes of q
+static f64 MeshLOD_QuadricError(const MeshLOD_Quadric* q, const f64 p[3])
+{
+    f64 x = p[0], y = p[1], z = p[2];
+    f64 e = q->a2 * x * x + q->b2 * y * y + q->c2 * z * z + q->d2
+            + 2.0 * (q->ab * x * y + q->ac * x * z + q->bc * y * z)
+            + 2.0 * (q->ad * x + q->bd * y + q->cd * z);
+    return q->w > 0.0 ? fabs(e) / q->w : 0.0;
+}
+
+// ============================================================================
+// Triangle simplification
+// ============================================================================
+
+enum MeshLOD_VertexKind : u8 {
+    MeshLOD_VertexKind_Manifold = 0, // can collapse onto any neighbor
+    MeshLOD_VertexKind_Border,       // can only collapse along the border
+    MeshLOD_VertexKind_Locked,       // never moves
+};
+
+struct MeshLOD_Collapse {
+    f64 error;
+    u32 v0; // moves onto v1
+    u32 v1;
+};
+
+static int MeshLOD_CompareCollapse(const void* a, const void* b)
+{
+    const MeshLOD_Collapse* ca = (const MeshLOD_Collapse*)a;
+    const MeshLOD_Collapse* cb = (const MeshLOD_Collapse*)b;
+    if (ca->error != cb->error) return ca->error < cb->error ? -1 : 1;
+    if (ca->v0 != cb->v0) return ca->v0 < cb->v0 ? -1 : 1;
+    if (ca->v1 != cb->v1) return ca->v1 < cb->v1 ? -1 : 1;
+    return 0;
+}
+
+// triangles around each vertex, in CSR form: triangles of v are
+// tris[offsets[v] .. offsets[v + 1])
+struct MeshLOD_Adjacency {
+    u32* offsets; // vertex_count + 1
+    u32* tris;    // index_count
+};
+
+static void MeshLOD_BuildAdjacency(MeshLOD_Adjacency* adj, const u32* indices,
+                                   u32 index_count, u32 vertex_count)
+{
+    memset(adj->offsets, 0, (vertex_count + 1) * sizeof(u32));
+    for (u32 i = 0; i < index_count; i++) adj->offsets[indices[i] + 1]++;
+    for (u32 v = 0; v < vertex_count; v++) adj->offsets[v + 1] += adj->offsets[v];
+
+    // offsets[v] is used as a cursor, then shifted back
+    for (u32 i = 0; i < index_count; i++) adj->tris[adj->offsets[indices[i]]++] = i / 3;
+    for (u32 v = vertex_count; v > 0; v--) adj->offsets[v] = adj->offsets[v - 1];
+    adj->offsets[0] = 0;
+}
+
+// true if no triangle has the directed edge b --> a, i.e. a --> b is on the border
+static bool MeshLOD_IsBorderEdge(MeshLOD_Adjacency* adj, const u32* indices, u32 a,
+                                 u32 b)
+{
+    for (u32 k = adj->offsets[b]; k < adj->offsets[b + 1]; k++) {
+        const u32* tri = indices + adj->tris[k] * 3;
+        for (int e = 0; e < 3; e++) {
+            if (tri[e] == b && tri[(e + 1) % 3] == a) return false;
+        }
+    }
+    return true;
+}
+
+struct MeshLOD_SortedPosition {
+    f32 p[3];
+    u32 v;
+};
+
+static int MeshLOD_ComparePosition(const void* a, const void* b)
+{
+    const f32* pa = ((const MeshLOD_SortedPosition*)a)->p;
+    const f32* pb = ((const MeshLOD_SortedPosition*)b)->p;
+    for (int c = 0; c < 3; c++) {
+        if (pa[c] != pb[c]) return pa[c] < pb[c] ? -1 : 1;
+    }
+    return 0;
+}
+
+static void MeshLOD_Position(const f32* positions, u32 stride, f64 scale, u32 v,
+                             f64 out[3])
+{
+    const f32* p = positions + (u64)v * stride;
+    out[0]       = p[0] * scale;
+    out[1]       = p[1] * scale;
+    out[2]       = p[2] * scale;
+}
+
+static void MeshLOD_Normal(const f64 a[3], const f64 b[3], const f64 c[3], f64 n[3])
+{
+    f64 e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    f64 e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    n[0]      = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1]      = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2]      = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// true if moving v0 onto v1 flips or degenerates a triangle around v0 that
+// survives the collapse
+static bool MeshLOD_CollapseFlips(MeshLOD_Adjacency* adj, const u32* indices,
+                                  const f32* positions, u32 stride, f64 scale, u32 v0,
+                                  u32 v1)
+{
+    f64 p1[3];
+    MeshLOD_Position(positions, stride, scale, v1, p1);
+
+    for (u32 k = adj->offsets[v0]; k < adj->offsets[v0 + 1]; k++) {
+        const u32* tri = indices + adj->tris[k] * 3;
+        if (tri[0] == v1 || tri[1] == v1 || tri[2] == v1) continue; // removed
+
+        f64 p[3][3], n_before[3], n_after[3];
+        for (int c = 0; c < 3; c++) {
+            MeshLOD_Position(positions, stride, scale, tri[c], p[c]);
+        }
+        MeshLOD_Normal(p[0], p[1], p[2], n_before);
+        for (int c = 0; c < 3; c++) {
+            if (tri[c] == v0) memcpy(p[c], p1, sizeof(p1));
+        }
+        MeshLOD_Normal(p[0], p[1], p[2], n_after);
+
+        f64 dot = n_before[0] * n_after[0] + n_before[1] * n_after[1]
+                  + n_before[2] * n_after[2];
+        f64 len_before = sqrt(n_before[0] * n_before[0] + n_before[1] * n_before[1]
+                              + n_before[2] * n_before[2]);
+        f64 len_after  = sqrt(n_after[0] * n_after[0] + n_after[1] * n_after[1]
+                              + n_after[2] * n_after[2]);
+        // allow up to ~75 degrees of rotation
+        if (dot <= 0.25 * len_before * len_after) return true;
+    }
+    return false;
+}
+
+u32 MeshLOD_SanitizeTriangles(u32* dst, const u32* indices, u32 index_count,
+                              u32 vertex_count)
+{
+    // never writes ahead of the triangle being read, so dst may alias indices
+    u32 count = 0;
+    for (u32 i = 0; i + 3 <= index_count; i += 3) {
+        u32 a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a >= vertex_count || b >= vertex_count || c >= vertex_count) continue;
+        dst[count++] = a;
+        dst[count++] = b;
+        dst[count++] = c;
+    }
+    return count;
+}
+
+u32 MeshLOD_SimplifyTriangles(u32* dst, const u32* indices, u32 index_count,
+                              const f32* positions, u32 vertex_count,
+                              u32 position_stride, u32 target_index_count,
+                              f32 target_error, f32* out_error)
+{
+    index_count = MeshLOD_SanitizeTriangles(dst, indices, index_count, vertex_count);
+    if (out_error) *out_error = 0.0f;
+    if (index_count <= target_index_count || vertex_count == 0) return index_count;
+
+    // work in units of the mesh extent so target_error is scale independent
+    f32 lo[3] = { INFINITY, INFINITY, INFINITY };
+    f32 hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (u32 v = 0; v < vertex_count; v++) {
+        const f32* p = positions + (u64)v * position_stride;
+        for (int c = 0; c < 3; c++) {
+            lo[c] = MIN(lo[c], p[c]);
+            hi[c] = MAX(hi[c], p[c]);
+        }
+    }
+    f32 extent = MAX(hi[0] - lo[0], MAX(hi[1] - lo[1], hi[2] - lo[2]));
+    f64 scale  = extent > 0.0f ? 1.0 / extent : 1.0;
+
+    MeshLOD_Quadric* quadrics = ALLOCATE_COUNT(MeshLOD_Quadric, vertex_count);
+    u8* kinds                 = ALLOCATE_COUNT(u8, vertex_count);
+    u8* touched               = ALLOCATE_COUNT(u8, vertex_count);
+    u32* collapse_to          = ALLOCATE_COUNT(u32, vertex_count);
+    MeshLOD_Adjacency adj     = { ALLOCATE_COUNT(u32, vertex_count + 1),
+                                  ALLOCATE_COUNT(u32, index_count) };
+    MeshLOD_Collapse* collapses = ALLOCATE_COUNT(MeshLOD_Collapse, index_count);
+
+    MeshLOD_BuildAdjacency(&adj, dst, index_count, vertex_count);
+
+    { // lock vertices that share their position with another vertex (seams)
+        MeshLOD_SortedPosition* sorted
+          = ALLOCATE_COUNT(MeshLOD_SortedPosition, vertex_count);
+        for (u32 v = 0; v < vertex_count; v++) {
+            const f32* p = positions + (u64)v * position_stride;
+            sorted[v]    = { { p[0], p[1], p[2] }, v };
+        }
+        qsort(sorted, vertex_count, sizeof(*sorted), MeshLOD_ComparePosition);
+        for (u32 i = 1; i < vertex_count; i++) {
+            if (MeshLOD_ComparePosition(sorted + i - 1, sorted + i) == 0) {
+                kinds[sorted[i - 1].v] = MeshLOD_VertexKind_Locked;
+                kinds[sorted[i].v]     = MeshLOD_VertexKind_Locked;
+            }
+        }
+        FREE(sorted);
+    }
+
+    // plane quadrics of every triangle, weighted by area, plus planes through the
+    // border edges perpendicular to their triangle
+    for (u32 t = 0; t < index_count / 3; t++) {
+        const u32* tri = dst + t * 3;
+        f64 p[3][3], n[3];
+        for (int c = 0; c < 3; c++) {
+            MeshLOD_Position(positions, position_stride, scale, tri[c], p[c]);
+        }
+        MeshLOD_Normal(p[0], p[1], p[2], n);
+        f64 len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len == 0.0) continue;
+        n[0] /= len, n[1] /= len, n[2] /= len;
+        f64 d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+        for (int c = 0; c < 3; c++)
+            MeshLOD_QuadricAddPlane(quadrics + tri[c], n[0], n[1], n[2], d, len * 0.5);
+
+        for (int e = 0; e < 3; e++) {
+            u32 a = tri[e], b = tri[(e + 1) % 3];
+            if (!MeshLOD_IsBorderEdge(&adj, dst, a, b)) continue;
+            u32 ends[2] = { a, b };
+            for (u32 v : ends) {
+                if (kinds[v] != MeshLOD_VertexKind_Locked)
+                    kinds[v] = MeshLOD_VertexKind_Border;
+            }
+
+            f64* pa    = p[e];
+            f64* pb    = p[(e + 1) % 3];
+            f64 edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+            f64 m[3]    = { edge[1] * n[2] - edge[2] * n[1],
+                            edge[2] * n[0] - edge[0] * n[2],
+                            edge[0] * n[1] - edge[1] * n[0] };
+            f64 mlen    = sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+            if (mlen == 0.0) continue;
+            m[0] /= mlen, m[1] /= mlen, m[2] /= mlen;
+            f64 md = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]);
+            f64 w  = (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2])
+                    * MESH_LOD_BORDER_WEIGHT;
+            MeshLOD_QuadricAddPlane(quadrics + a, m[0], m[1], m[2], md, w);
+            MeshLOD_QuadricAddPlane(quadrics + b, m[0], m[1], m[2], md, w);
+        }
+    }
+
+    f64 error_limit = (f64)target_error * target_error;
+    f64 max_error   = 0.0;
+
+    while (index_count > target_index_count) {
+        MeshLOD_BuildAdjacency(&adj, dst, index_count, vertex_count);
+
+        // candidate collapses, each edge once, in its cheaper valid direction
+        u32 collapse_count = 0;
+        for (u32 i = 0; i < index_count; i++) {
+            u32 a = dst[i], b = dst[i - i % 3 + (i + 1) % 3];
+            bool border = MeshLOD_IsBorderEdge(&adj, dst, a, b);
+            if (a > b && !border) continue; // the other half edge has it
+
+            MeshLOD_Collapse best = { INFINITY, 0, 0 };
+            u32 ends[2]           = { a, b };
+            for (int dir = 0; dir < 2; dir++) {
+                u32 v0 = ends[dir], v1 = ends[1 - dir];
+                if (kinds[v0] == MeshLOD_VertexKind_Locked) continue;
+                if (kinds[v0] == MeshLOD_VertexKind_Border
+                    && (kinds[v1] == MeshLOD_VertexKind_Manifold || !border))
+                    continue;
+
+                MeshLOD_Quadric q = quadrics[v0];
+                MeshLOD_QuadricAdd(&q, quadrics + v1);
+                f64 p1[3];
+                MeshLOD_Position(positions, position_stride, scale, v1, p1);
+                f64 error = MeshLOD_QuadricError(&q, p1);
+                if (error < best.error) best = { error, v0, v1 };
+            }
+            if (best.error <= error_limit) collapses[collapse_count++] = best;
+        }
+        if (collapse_count == 0) break;
+
+        qsort(collapses, collapse_count, sizeof(*collapses), MeshLOD_CompareCollapse);
+
+        // apply the cheapest collapses whose neighborhoods don't overlap, until
+        // enough triangles are gone
+        memset(touched, 0, vertex_count);
+        for (u32 v = 0; v < vertex_count; v++) collapse_to[v] = v;
+        u32 tris_to_remove = (index_count - target_index_count + 2) / 3;
+        u32 tris_removed   = 0;
+        u32 applied        = 0;
+        for (u32 c = 0; c < collapse_count && tris_removed < tris_to_remove; c++) {
+            u32 v0 = collapses[c].v0, v1 = collapses[c].v1;
+            if (touched[v0] || touched[v1]) continue;
+            if (MeshLOD_CollapseFlips(&adj, dst, positions, position_stride, scale, v0,
+                                      v1))
+                continue;
+
+            collapse_to[v0] = v1;
+            MeshLOD_QuadricAdd(quadrics + v1, quadrics + v0);
+            max_error = MAX(max_error, collapses[c].error);
+            ++applied;
+
+            // the triangles around v0 change shape, don't collapse any of their
+            // vertices again this pass
+            for (u32 k = adj.offsets[v0]; k < adj.offsets[v0 + 1]; k++) {
+                const u32* tri = dst + adj.tris[k] * 3;
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                if (tri[0] == v1 || tri[1] == v1 || tri[2] == v1) ++tris_removed;
+            }
+        }
+        if (applied == 0) break;
+
+        // remap, dropping degenerate triangles
+        u32 write = 0;
+        for (u32 i = 0; i < index_count; i += 3) {
+            u32 a = collapse_to[dst[i]], b = collapse_to[dst[i + 1]],
+                c = collapse_to[dst[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            dst[write++] = a;
+            dst[write++] = b;
+            dst[write++] = c;
+        }
+        index_count = write;
+    }
+
+    if (out_error) *out_error = (f32)sqrt(max_error);
+
+    FREE(quadrics);
+    FREE(kinds);
+    FREE(touched);
+    FREE(collapse_to);
+    FREE(adj.offsets);
+    FREE(adj.tris);
+    FREE(collapses);
+    return index_count;
+}
+
+// ============================================================================
+// Point simplification
+// ============================================================================
+
+struct MeshLOD_Cell {
+    u64 key;
+    u32 v;
+};
+
+static int MeshLOD_CompareCell(const void* a, const void* b)
+{
+    const MeshLOD_Cell* ca = (const MeshLOD_Cell*)a;
+    const MeshLOD_Cell* cb = (const MeshLOD_Cell*)b;
+    if (ca->key != cb->key) return ca->key < cb->key ? -1 : 1;
+    return ca->v < cb->v ? -1 : ca->v > cb->v ? 1 : 0;
+}
+
+// sorts the points into cells of a grid with `resolution` cells along the longest
+// axis. Returns how many cells are occupied
+static u32 MeshLOD_GridCells(MeshLOD_Cell* cells, const f32* positions,
+                             u32 vertex_count, u32 stride, const f32 lo[3],
+                             f32 extent, u32 resolution)
+{
+    f32 cell_size = extent / resolution;
+    for (u32 v = 0; v < vertex_count; v++) {
+        const f32* p = positions + (u64)v * stride;
+        u64 key      = 0;
+        for (int c = 0; c < 3; c++) {
+            u64 i = cell_size > 0.0f ? (u64)((p[c] - lo[c]) / cell_size) : 0;
+            key   = (key << 21) | MIN(i, (u64)resolution - 1);
+        }
+        cells[v] = { key, v };
+    }
+    qsort(cells, vertex_count, sizeof(*cells), MeshLOD_CompareCell);
+
+    u32 occupied = vertex_count > 0 ? 1 : 0;
+    for (u32 i = 1; i < vertex_count; i++) {
+        if (cells[i].key != cells[i - 1].key) ++occupied;
+    }
+    return occupied;
+}
+
+u32 MeshLOD_SimplifyPoints(u32* dst, const f32* positions, u32 vertex_count,
+                           u32 position_stride, u32 target_count)
+{
+    if (vertex_count <= target_count) {
+        for (u32 v = 0; v < vertex_count; v++) dst[v] = v;
+        return vertex_count;
+    }
+    if (target_count == 0) return 0;
+
+    f32 lo[3] = { INFINITY, INFINITY, INFINITY };
+    f32 hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (u32 v = 0; v < vertex_count; v++) {
+        const f32* p = positions + (u64)v * position_stride;
+        for (int c = 0; c < 3; c++) {
+            lo[c] = MIN(lo[c], p[c]);
+            hi[c] = MAX(hi[c], p[c]);
+        }
+    }
+    f32 extent = MAX(hi[0] - lo[0], MAX(hi[1] - lo[1], hi[2] - lo[2]));
+
+    // binary search for the finest grid with at most target_count occupied cells.
+    // Occupancy isn't strictly monotonic in resolution, but close enough that the
+    // result is near the finest such grid, and it always fits target_count
+    MeshLOD_Cell* cells = ALLOCATE_COUNT(MeshLOD_Cell, vertex_count);
+    u32 lo_res = 1, hi_res = 1 << 20;
+    while (lo_res < hi_res) {
+        u32 mid = lo_res + (hi_res - lo_res + 1) / 2;
+        if (MeshLOD_GridCells(cells, positions, vertex_count, position_stride, lo,
+                              extent, mid)
+            <= target_count)
+            lo_res = mid;
+        else
+            hi_res = mid - 1;
+    }
+    MeshLOD_GridCells(cells, positions, vertex_count, position_stride, lo, extent,
+                      lo_res);
+
+    // lowest index point of each cell, then back in index order
+    u32 count = 0;
+    for (u32 i = 0; i < vertex_count; i++) {
+        if (i == 0 || cells[i].key != cells[i - 1].key) dst[count++] = cells[i].v;
+    }
+    qsort(dst, count, sizeof(u32), [](const void* a, const void* b) -> int {
+        u32 va = *(const u32*)a, vb = *(const u32*)b;
+        return va < vb ? -1 : va > vb ? 1 : 0;
+    });
+
+    FREE(cells);
+    return count;
+}
+
+u32 MeshLOD_Compact(u32* remap, u32* indices, u32 index_count, u32 vertex_count)
+{
+    for (u32 v = 0; v < vertex_count; v++) remap[v] = UINT32_MAX;
+
+    u32 next = 0;
+    for (u32 i = 0; i < index_count; i++) {
+        u32 v = indices[i];
+        ASSERT(v < vertex_count);
+        if (remap[v] == UINT32_MAX) remap[v] = next++;
+        indices[i] = remap[v];
+    }
+    return next;
+}
@@ -0,0 +1,94 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+/*
+Mesh level of detail
+
+A Geometry can act as a LOD group: besides itself (level 0) it holds up to
+CHUGL_GEOMETRY_MAX_LODS lower detail geometries, each with the screen size below
+which it replaces the previous level. Screen size is the fraction of the viewport
+height covered by a mesh's bounding sphere. Every frame, each instance of a mesh
+picks its level on its own, and instances at the same level are still drawn
+with a single instanced draw (see _R_RenderScene).
+
+Lower levels are usually generated from the base geometry:
+- MeshLOD_SimplifyTriangles() collapses edges by quadric error (Garland &
+  Heckbert 97). Vertices are only ever collapsed onto other existing vertices,
+  so the simplified index buffer is valid against the original vertex
+  attributes. Vertices whose position is shared with another vertex (uv and
+  normal seams) are never moved, and collapses along the mesh border must stay
+  on the border, so seams and holes don't open up
+- MeshLOD_SimplifyPoints() thins point clouds by keeping one point per cell of a
+  uniform grid
+
+Both work on plain arrays and know nothing about the renderer, so they can be
+run offline and tested on the CPU.
+*/
+
+// level to draw at `screen_size`: 0 for the base geometry, i + 1 for lods[i].
+// lod_screen_sizes must be decreasing. -1 if smaller than cull_size (not drawn)
+int MeshLOD_Select(f32 screen_size, const f32* lod_screen_sizes, int lod_count,
+                   f32 cull_size);
+
+// fraction of the viewport height covered by a sphere at distance `dist` from the
+// camera. 1 if the camera is inside the sphere
+f32 MeshLOD_ScreenSize(f32 radius, f32 dist, bool perspective, f32 fov_radians,
+                       f32 ortho_size);
+
+// copies the triangles of indices whose 3 indices are all < vertex_count to dst,
+// dropping the others and any trailing indices that don't form a whole triangle.
+// Returns how many indices were written. dst may alias indices
+u32 MeshLOD_SanitizeTriangles(u32* dst, const u32* indices, u32 index_count,
+                              u32 vertex_count);
+
+// writes a simplified triangle list to dst (room for index_count indices) and
+// returns its length, at most target_index_count unless that would need a collapse
+// with more than target_error error. target_error is relative to the mesh extent,
+// e.g. 0.01 allows moving the surface by 1% of the mesh size. The error actually
+// reached is written to out_error if not NULL. dst may alias indices.
+// positions are position_stride floats apart. Invalid triangles are dropped first,
+// see MeshLOD_SanitizeTriangles
+u32 MeshLOD_SimplifyTriangles(u32* dst, const u32* indices, u32 index_count,
+                              const f32* positions, u32 vertex_count,
+                              u32 position_stride, u32 target_index_count,
+                              f32 target_error, f32* out_error);
+
+// writes the indices of at most target_count points to dst (room for vertex_count),
+// keeping the lowest index point of each cell of the finest grid that leaves no
+// more than target_count cells occupied. Returns how many were written
+u32 MeshLOD_SimplifyPoints(u32* dst, const f32* positions, u32 vertex_count,
+                           u32 position_stride, u32 target_count);
+
+// renumbers the vertices referenced by indices to 0..n-1 in order of first use,
+// rewriting indices in place. remap (room for vertex_count) maps each old vertex
+// to its new index, or UINT32_MAX if unreferenced. Returns n.
+// Every index must be < vertex_count, e.g. the output of MeshLOD_SimplifyTriangles
+u32 MeshLOD_Compact(u32* remap, u32* indices, u32 index_count, u32 vertex_count);
@@ -0,0 +1,479 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "profiler.h"
+
+#include "core/log.h"
+#include "core/memory.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define PROFILER_AVG_ALPHA 0.05 // weight of the newest frame in the moving average
+#define PROFILER_TRACE_WORKER_TID ProfileThread_Count // zones off the two threads
+
+std::atomic<bool> g_profiler_enabled = { false };
+
+struct ProfileZoneTotal {
+    std::atomic<u64> ns;
+    std::atomic<u32> calls;
+};
+
+struct ProfileTraceEvent {
+    u64 begin_ns;
+    u64 dur_ns;
+    u8 zone;     // ProfileZone_Count for a GPU pass counter
+    u8 tid;      // ProfileThread, or PROFILER_TRACE_WORKER_TID
+    u8 gpu_pass; // index into stats.gpu_passes
+};
+
+struct ProfilerState {
+    ProfileZoneTotal totals[ProfileZone_Count];
+
+    std::mutex lock; // everything below except the trace atomics
+    ProfileStats stats;
+    u64 frame_begin_ns[ProfileThread_Count];
+
+    // trace. Writers register in trace_writers *before* checking tracing, so
+    // stopping a trace can wait for every event in flight before touching events
+    std::atomic<bool> tracing;
+    std::atomic<int> trace_writers;
+    std::atomic<u64> event_count; // claimed, can be past event_capacity
+    ProfileTraceEvent* events;
+    u64 event_capacity;
+    u64 trace_begin_ns;
+    char* trace_path;
+};
+
+static ProfilerState _profiler;
+
+static thread_local int _profile_thread = PROFILER_TRACE_WORKER_TID;
+
+static const char* _profile_zone_names[] = {
+    "audio_update", "command_push", "wait_audio",   "imgui",
+    "physics",      "queue_drain",  "video_decode", "scene_update",
+    "matrix_rebuild", "draw_build", "execute",      "present",
+};
+static_assert(ARRAY_LENGTH(_profile_zone_names) == ProfileZone_Count, "zone names");
+
+static const char* _profile_thread_names[ProfileThread_Count] = { "audio", "render" };
+
+const char* Profiler_ZoneName(ProfileZone zone)
+{
+    return zone < ProfileZone_Count ? _profile_zone_names[zone] : "unknown";
+}
+
+ProfileThread Profiler_ZoneThread(ProfileZone zone)
+{
+    return zone <= ProfileZone_CommandPush ? ProfileThread_Audio : ProfileThread_Render;
+}
+
+u64 Profiler_Now()
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+             .count()
+           + 1;
+}
+
+static void _Profiler_Update(ProfileTiming* timing, f64 ms, u32 calls, bool first)
+{
+    timing->last_ms = ms;
+    timing->avg_ms
+      = first ? ms : timing->avg_ms + (ms - timing->avg_ms) * PROFILER_AVG_ALPHA;
+    timing->max_ms  = MAX(timing->max_ms, ms);
+    timing->calls   = calls;
+}
+
+// ============================================================================
+// Trace
+// ============================================================================
+
+static void _Profiler_TraceStop(ProfilerState* p)
+{
+    p->tracing.store(false);
+    while (p->trace_writers.load()) std::this_thread::yield();
+}
+
+static void _Profiler_TraceEvent(ProfileTraceEvent event)
+{
+    ProfilerState* p = &_profiler;
+    p->trace_writers.fetch_add(1);
+    if (p->tracing.load()) {
+        u64 i = p->event_count.fetch_add(1, std::memory_order_relaxed);
+        if (i < p->event_capacity) p->events[i] = event;
+    }
+    p->trace_writers.fetch_sub(1, std::memory_order_release);
+}
+
+void Profiler_TraceBegin(const char* path, int max_events)
+{
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    _Profiler_TraceStop(p);
+
+    if ((u64)max_events > p->event_capacity) {
+        FREE(p->events);
+        p->events         = ALLOCATE_COUNT(ProfileTraceEvent, max_events);
+        p->event_capacity = max_events;
+    }
+    FREE(p->trace_path);
+    p->trace_path = ALLOCATE_COUNT(char, strlen(path) + 1);
+    strcpy(p->trace_path, path);
+    p->event_count.store(0);
+    p->trace_begin_ns = Profiler_Now();
+    p->tracing.store(true);
+}
+
+static void _Profiler_WriteJsonString(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if ((u8)*c < 0x20) {
+            fprintf(file, "\\u%04x", (u8)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+bool Profiler_TraceEnd()
+{
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    if (!p->trace_path) return false;
+    _Profiler_TraceStop(p);
+
+    char* path = p->trace_path;
+    p->trace_path = NULL;
+    FILE* file    = fopen(path, "wb");
+    if (!file) {
+        log_error("GG.traceStop(): could not open \"%s\" for writing", path);
+        FREE(path);
+        return false;
+    }
+
+    u64 count = MIN(p->event_count.load(), p->event_capacity);
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int t = 0; t <= PROFILER_TRACE_WORKER_TID; t++) {
+        fprintf(file,
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}},\n",
+                t, t < ProfileThread_Count ? _profile_thread_names[t] : "worker");
+    }
+    for (u64 i = 0; i < count; i++) {
+        ProfileTraceEvent* e = p->events + i;
+        f64 ts_us = e->begin_ns < p->trace_begin_ns ?
+                      0.0 :
+                      (f64)(e->begin_ns - p->trace_begin_ns) / 1000.0;
+        if (e->zone == ProfileZone_Count) {
+            if (e->gpu_pass >= p->stats.gpu_pass_count) continue;
+            fprintf(file, "{\"name\":");
+            _Profiler_WriteJsonString(file, p->stats.gpu_passes[e->gpu_pass].name);
+            fprintf(file,
+                    ",\"cat\":\"gpu\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,"
+                    "\"args\":{\"ms\":%.4f}},\n",
+                    ts_us, (f64)e->dur_ns / 1e6);
+        } else {
+            fprintf(file,
+                    "{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,"
+                    "\"dur\":%.3f,\"pid\":1,\"tid\":%d},\n",
+                    _profile_zone_names[e->zone], ts_us, (f64)e->dur_ns / 1000.0,
+                    e->tid);
+        }
+    }
+    // the trailing comma is fine for chrome://tracing, but not for strict JSON
+    fprintf(file, "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,"
+                  "\"pid\":1,\"tid\":0}\n]}\n",
+            (f64)(Profiler_Now() - p->trace_begin_ns) / 1000.0);
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    u64 dropped = p->event_count.load() - count;
+    if (ok) {
+        log_info("Wrote %llu trace events to \"%s\" (%llu dropped)",
+                 (unsigned long long)count, path, (unsigned long long)dropped);
+    } else {
+        log_error("GG.traceStop(): error writing \"%s\"", path);
+    }
+    FREE(path);
+    return ok;
+}
+
+// ============================================================================
+// Zones and stats
+// ============================================================================
+
+void Profiler_Enable(bool enable)
+{
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    if (enable && !g_profiler_enabled.load()) {
+        for (int i = 0; i < ProfileZone_Count; i++) {
+            p->totals[i].ns.store(0, std::memory_order_relaxed);
+            p->totals[i].calls.store(0, std::memory_order_relaxed);
+        }
+        ProfileStats* s = &p->stats;
+        memset(s->frames, 0, sizeof(s->frames));
+        memset(s->frame, 0, sizeof(s->frame));
+        memset(s->zones, 0, sizeof(s->zones));
+        memset(&s->gpu_total, 0, sizeof(s->gpu_total));
+        // a trace in progress refers to passes by index, keep their names
+        for (int i = 0; i < s->gpu_pass_count; i++) s->gpu_passes[i].timing = {};
+        if (!p->tracing.load()) s->gpu_pass_count = 0;
+        s->counter_count = 0;
+    }
+    g_profiler_enabled.store(enable);
+}
+
+void Profiler_Record(ProfileZone zone, u64 begin_ns, u64 end_ns)
+{
+    ProfilerState* p = &_profiler;
+    u64 dur_ns       = end_ns > begin_ns ? end_ns - begin_ns : 0;
+    p->totals[zone].ns.fetch_add(dur_ns, std::memory_order_relaxed);
+    p->totals[zone].calls.fetch_add(1, std::memory_order_relaxed);
+
+    if (p->tracing.load(std::memory_order_relaxed)) {
+        _Profiler_TraceEvent({ begin_ns, dur_ns, zone, (u8)_profile_thread, 0 });
+    }
+}
+
+void Profiler_EndFrame(ProfileThread thread)
+{
+    _profile_thread = thread;
+    if (!Profiler_Enabled()) return;
+
+    ProfilerState* p = &_profiler;
+    u64 now          = Profiler_Now();
+    std::lock_guard<std::mutex> guard(p->lock);
+    ProfileStats* s = &p->stats;
+
+    bool first = s->frames[thread] == 0;
+    if (!first) {
+        f64 frame_ms = (f64)(now - p->frame_begin_ns[thread]) / 1e6;
+        _Profiler_Update(&s->frame[thread], frame_ms, 1, s->frames[thread] == 1);
+    }
+    p->frame_begin_ns[thread] = now;
+    s->frames[thread]++;
+
+    for (int i = 0; i < ProfileZone_Count; i++) {
+        if (Profiler_ZoneThread((ProfileZone)i) != thread) continue;
+        u64 ns    = p->totals[i].ns.exchange(0, std::memory_order_relaxed);
+        u32 calls = p->totals[i].calls.exchange(0, std::memory_order_relaxed);
+        _Profiler_Update(&s->zones[i], (f64)ns / 1e6, calls, first);
+    }
+}
+
+void Profiler_GpuPasses(const char (*names)[PROFILER_NAME_SIZE], const f64* ms,
+                        int count)
+{
+    if (!Profiler_Enabled()) return;
+
+    ProfilerState* p = &_profiler;
+    u64 now          = Profiler_Now();
+    std::lock_guard<std::mutex> guard(p->lock);
+    ProfileStats* s = &p->stats;
+
+    bool first = s->gpu_total.max_ms == 0;
+    f64 total  = 0;
+    for (int i = 0; i < count; i++) {
+        total += ms[i];
+
+        int pass = 0;
+        while (pass < s->gpu_pass_count
+               && strncmp(s->gpu_passes[pass].name, names[i], PROFILER_NAME_SIZE) != 0)
+            ++pass;
+        if (pass == PROFILER_MAX_GPU_PASSES) continue;
+        ProfileGpuPass* gpu_pass = s->gpu_passes + pass;
+        if (pass == s->gpu_pass_count) {
+            s->gpu_pass_count++;
+            *gpu_pass = {};
+            strncpy(gpu_pass->name, names[i], PROFILER_NAME_SIZE - 1);
+        }
+        _Profiler_Update(&gpu_pass->timing, ms[i], 1, gpu_pass->timing.max_ms == 0);
+
+        if (p->tracing.load(std::memory_order_relaxed)) {
+            _Profiler_TraceEvent({ now, (u64)(ms[i] * 1e6), ProfileZone_Count, 0,
+                                   (u8)pass });
+        }
+    }
+    _Profiler_Update(&s->gpu_total, total, count, first);
+}
+
+void Profiler_Counters(const ProfileCounter* counters, int count)
+{
+    if (!Profiler_Enabled()) return;
+
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    ProfileStats* s  = &p->stats;
+    s->counter_count = MIN(MAX(count, 0), PROFILER_MAX_COUNTERS);
+    for (int i = 0; i < s->counter_count; i++) {
+        s->counters[i] = counters[i];
+        s->counters[i].name[PROFILER_NAME_SIZE - 1] = '\0';
+    }
+}
+
+void Profiler_Stats(ProfileStats* stats)
+{
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    *stats         = p->stats;
+    stats->enabled = Profiler_Enabled();
+    stats->tracing = p->tracing.load();
+    u64 claimed    = p->event_count.load();
+    stats->trace_events  = MIN(claimed, p->event_capacity);
+    stats->trace_dropped = claimed - stats->trace_events;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+struct ProfileReport {
+    char* buf;
+    int size;
+    int len;
+};
+
+static void _Profiler_Print(ProfileReport* r, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int avail = r->len < r->size ? r->size - r->len : 0;
+    int n     = vsnprintf(avail ? r->buf + r->len : NULL, avail, fmt, args);
+    va_end(args);
+    if (n > 0) r->len += n;
+}
+
+static void _Profiler_PrintTiming(ProfileReport* r, const char* indent,
+                                  const char* name, const ProfileTiming* t)
+{
+    _Profiler_Print(r, "%s%-*s %8.3f %8.3f %8.3f %6u\n", indent,
+                    24 - (int)strlen(indent), name, t->last_ms, t->avg_ms, t->max_ms,
+                    t->calls);
+}
+
+int Profiler_FormatStats(const ProfileStats* stats, char* buf, int size)
+{
+    ProfileReport r = { buf, size, 0 };
+    if (size > 0) buf[0] = '\0';
+    if (!stats->enabled) {
+        _Profiler_Print(&r, "profiler off, turn it on with GG.profile(true)\n");
+        return MIN(r.len, MAX(size - 1, 0));
+    }
+
+    _Profiler_Print(&r, "%-24s %8s %8s %8s %6s\n", "ms", "last", "avg", "max",
+                    "calls");
+    for (int t = 0; t < ProfileThread_Count; t++) {
+        char name[PROFILER_NAME_SIZE];
+        snprintf(name, sizeof(name), "%s_frame", _profile_thread_names[t]);
+        _Profiler_PrintTiming(&r, "", name, &stats->frame[t]);
+        for (int i = 0; i < ProfileZone_Count; i++) {
+            if (Profiler_ZoneThread((ProfileZone)i) != t) continue;
+            _Profiler_PrintTiming(&r, "  ", _profile_zone_names[i], &stats->zones[i]);
+        }
+    }
+    if (stats->gpu_pass_count) {
+        _Profiler_PrintTiming(&r, "", "gpu", &stats->gpu_total);
+        for (int i = 0; i < stats->gpu_pass_count; i++) {
+            _Profiler_PrintTiming(&r, "  ", stats->gpu_passes[i].name,
+                                  &stats->gpu_passes[i].timing);
+        }
+    } else {
+        _Profiler_Print(&r, "gpu: no timestamp queries on this device\n");
+    }
+    if (stats->counter_count) {
+        _Profiler_Print(&r, "%-24s %12s %12s\n", "count", "frame", "total");
+        for (int i = 0; i < stats->counter_count; i++) {
+            const ProfileCounter* c = stats->counters + i;
+            _Profiler_Print(&r, "  %-22s %12llu %12llu\n", c->name,
+                            (unsigned long long)c->frame,
+                            (unsigned long long)c->total);
+        }
+    }
+    if (stats->tracing) {
+        _Profiler_Print(&r, "tracing: %llu events, %llu dropped\n",
+                        (unsigned long long)stats->trace_events,
+                        (unsigned long long)stats->trace_dropped);
+    }
+    return MIN(r.len, MAX(size - 1, 0));
+}
+
+f64 Profiler_AvgMs(const ProfileStats* stats, const char* name)
+{
+    for (int t = 0; t < ProfileThread_Count; t++) {
+        size_t len = strlen(_profile_thread_names[t]);
+        if (strncmp(name, _profile_thread_names[t], len) == 0
+            && strcmp(name + len, "_frame") == 0)
+            return stats->frame[t].avg_ms;
+    }
+    for (int i = 0; i < ProfileZone_Count; i++) {
+        if (strcmp(name, _profile_zone_names[i]) == 0) return stats->zones[i].avg_ms;
+    }
+    if (strcmp(name, "gpu") == 0) return stats->gpu_total.avg_ms;
+    for (int i = 0; i < stats->gpu_pass_count; i++) {
+        if (strcmp(name, stats->gpu_passes[i].name) == 0)
+            return stats->gpu_passes[i].timing.avg_ms;
+    }
+    return -1;
+}
+
+i64 Profiler_Count(const ProfileStats* stats, const char* name)
+{
+    size_t len   = strlen(name);
+    size_t s_len = strlen("_total");
+    bool total   = len > s_len && strcmp(name + len - s_len, "_total") == 0;
+    for (int i = 0; i < stats->counter_count; i++) {
+        const ProfileCounter* c = stats->counters + i;
+        if (strcmp(name, c->name) == 0) return (i64)c->frame;
+        if (total && strlen(c->name) == len - s_len
+            && strncmp(name, c->name, len - s_len) == 0)
+            return (i64)c->total;
+    }
+    return -1;
+}
+
+void Profiler_Shutdown()
+{
+    ProfilerState* p = &_profiler;
+    std::lock_guard<std::mutex> guard(p->lock);
+    _Profiler_TraceStop(p);
+    FREE(p->events);
+    FREE(p->trace_path);
+    p->event_capacity = 0;
+    p->event_count.store(0);
+}
@@ -0,0 +1,199 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+#include <atomic>
+
+/*
+Frame profiler
+
+Scoped CPU zones on the audio (chuck VM) and render threads, plus per pass GPU
+times, so GG.stats() can show where a frame goes without attaching an external
+profiler.
+
+Zones are a fixed enum, each owned by one thread. A PROFILE_ZONE adds its time
+to the zone with two relaxed atomics, and Profiler_EndFrame, called once per
+frame by the owning thread, folds the totals into the last / moving average /
+max per frame stats. Zones nest (scene_update contains matrix_rebuild), and
+their times are inclusive.
+
+While off, a zone costs one relaxed load. Defining CHUGL_PROFILER_DISABLED
+compiles zones out entirely.
+
+Between Profiler_TraceBegin and Profiler_TraceEnd, every zone is also recorded
+as an event into a bounded buffer (lock free, events past the end are counted
+as dropped) and written as Chrome trace JSON, viewable in chrome://tracing or
+https://ui.perfetto.dev. GPU pass times go in as counters: the GPU has its own
+clock, so they can't be placed on the CPU timeline.
+
+GPU pass times are read back a few frames late and reported with
+Profiler_GpuPasses.
+
+Render stats that aren't times (shadow casters culled, pipelines compiled...) are
+reported once per frame with Profiler_Counters and printed as is.
+
+Knows nothing about WebGPU, so it can be tested on the CPU.
+*/
+
+#define PROFILER_MAX_GPU_PASSES 32
+#define PROFILER_NAME_SIZE 64
+#define PROFILER_MAX_COUNTERS 32
+
+enum ProfileThread : u8 {
+    ProfileThread_Audio = 0, // chuck VM
+    ProfileThread_Render,
+    ProfileThread_Count,
+};
+
+enum ProfileZone : u8 {
+    // audio thread
+    ProfileZone_AudioUpdate = 0, // GG.nextFrame() bookkeeping
+    ProfileZone_CommandPush,     // writing commands for the render thread
+    // render thread
+    ProfileZone_WaitAudio, // waiting on chuck to finish the frame
+    ProfileZone_ImGui,
+    ProfileZone_Physics,
+    ProfileZone_QueueDrain, // applying the frame's commands
+    ProfileZone_VideoDecode,
+    ProfileZone_SceneUpdate,
+    ProfileZone_MatrixRebuild,
+    ProfileZone_DrawBuild, // recording scene pass draws
+    ProfileZone_Execute,   // rendergraph execution
+    ProfileZone_Present,
+    ProfileZone_Count,
+};
+
+struct ProfileTiming {
+    f64 last_ms; // last frame
+    f64 avg_ms;  // exponential moving average
+    f64 max_ms;  // since enabled
+    u32 calls;   // last frame
+};
+
+struct ProfileGpuPass {
+    char name[PROFILER_NAME_SIZE];
+    ProfileTiming timing;
+};
+
+struct ProfileCounter {
+    char name[PROFILER_NAME_SIZE];
+    u64 frame; // last frame
+    u64 total; // since startup, or the current value of counts that aren't summed
+};
+
+struct ProfileStats {
+    bool enabled;
+    bool tracing;
+    u64 frames[ProfileThread_Count];
+    ProfileTiming frame[ProfileThread_Count]; // EndFrame to EndFrame
+    ProfileTiming zones[ProfileZone_Count];
+    ProfileTiming gpu_total; // sum of every pass
+    ProfileGpuPass gpu_passes[PROFILER_MAX_GPU_PASSES];
+    int gpu_pass_count;
+    ProfileCounter counters[PROFILER_MAX_COUNTERS];
+    int counter_count;
+    u64 trace_events;
+    u64 trace_dropped;
+};
+
+extern std::atomic<bool> g_profiler_enabled;
+
+inline bool Profiler_Enabled()
+{
+    return g_profiler_enabled.load(std::memory_order_relaxed);
+}
+
+u64 Profiler_Now(); // ns, steady clock. Never 0
+
+// turning the profiler on resets every stat
+void Profiler_Enable(bool enable);
+
+// adds one call of `ns` to a zone. Usually through PROFILE_ZONE
+void Profiler_Record(ProfileZone zone, u64 begin_ns, u64 end_ns);
+
+// folds the thread's zone totals into the per frame stats. Also marks the calling
+// thread as `thread` in traces
+void Profiler_EndFrame(ProfileThread thread);
+
+// GPU time of each pass in the frame, in execution order
+void Profiler_GpuPasses(const char (*names)[PROFILER_NAME_SIZE], const f64* ms,
+                        int count);
+
+// replaces the last frame's counters. Past PROFILER_MAX_COUNTERS are left out
+void Profiler_Counters(const ProfileCounter* counters, int count);
+
+void Profiler_Stats(ProfileStats* stats);
+
+// human readable report of `stats`, truncated to `size`. Returns the length
+int Profiler_FormatStats(const ProfileStats* stats, char* buf, int size);
+
+// average ms of a zone ("scene_update"), thread frame ("render_frame"), or GPU pass
+// by name. -1 if there is none
+f64 Profiler_AvgMs(const ProfileStats* stats, const char* name);
+
+// last frame value of a counter by name ("shadow_casters_culled"), or its total with
+// a "_total" suffix. -1 if there is none
+i64 Profiler_Count(const ProfileStats* stats, const char* name);
+
+const char* Profiler_ZoneName(ProfileZone zone);
+ProfileThread Profiler_ZoneThread(ProfileZone zone);
+
+// starts recording up to `max_events` zones, to be written to `path`. Restarts a
+// trace in progress
+void Profiler_TraceBegin(const char* path, int max_events);
+
+// writes the trace. false (and logs why) if it can't be written
+bool Profiler_TraceEnd();
+
+// frees the trace buffer
+void Profiler_Shutdown();
+
+struct ProfileScope {
+    ProfileZone zone;
+    u64 begin_ns;
+
+    ProfileScope(ProfileZone zone)
+        : zone(zone), begin_ns(Profiler_Enabled() ? Profiler_Now() : 0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (begin_ns) Profiler_Record(zone, begin_ns, Profiler_Now());
+    }
+};
+
+#ifdef CHUGL_PROFILER_DISABLED
+#define PROFILE_ZONE(zone)
+#else
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(zone) ProfileScope PROFILE_CONCAT(_profile_zone_, __LINE__)(zone)
+#endif
@@ -27,9 +27,11 @@
 -----------------------------------------------------------------------------*/
 #include "r_component.h"
 #include "core/hashmap.h"
+#include "destroy_queue.h"
 #include "geometry.h"
 #include "graphics.h"
 #include "shaders.h"
+#include "texture_transcode.h"
 
 #include "compressed_fonts.h"
 
@@ -45,6 +47,10 @@
 
 #include <sokol/sokol_time.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 static int compareSGIDs(const void* a, const void* b, void* udata)
 {
     return *(SG_ID*)a - *(SG_ID*)b;
@@ -142,9 +148,6 @@ static void R_Transform_init(R_Transform* xform, SG_ID id, SG_ComponentType comp
     xform->_stale = R_Transform_STALE_LOCAL;
 
     xform->parentID = 0;
-
-    // initialize children array for 8 children
-    Arena::init(&xform->children, sizeof(SG_ID) * 8);
 }
 
 void R_Transform::init(R_Transform* transform)
@@ -164,8 +167,6 @@ void R_Transform::init(R_Transform* transform)
     transform->_stale = R_Transform_STALE_NONE;
 
     transform->parentID = 0;
-    // initialize children array for 8 children
-    Arena::init(&transform->children, sizeof(SG_ID) * 8);
 }
 
 void R_Transform::initFromSG(R_Transform* r_xform, SG_Command_CreateXform* cmd)
@@ -183,9 +184,6 @@ void R_Transform::initFromSG(R_Transform* r_xform, SG_Command_CreateXform* cmd)
     r_xform->_rot   = cmd->rot;
     r_xform->_sca   = cmd->sca;
     r_xform->_stale = R_Transform_STALE_LOCAL;
-
-    // initialize children array for 8 children
-    Arena::init(&r_xform->children, sizeof(SG_ID) * 8);
 }
 
 void R_Transform::setStale(R_Transform* xform, R_Transform_Staleness stale)
@@ -226,6 +224,49 @@ bool R_Transform::isAncestor(R_Transform* ancestor, R_Transform* descendent)
     return false;
 }
 
+// O(1) unlink from parent's children list. Does not touch scene render state
+static void _R_Transform_Unlink(R_Transform* parent, R_Transform* child)
+{
+    ASSERT(child->parentID == parent->id);
+
+    R_Transform* prev = Component_GetXform(child->prev_sibling_id);
+    R_Transform* next = Component_GetXform(child->next_sibling_id);
+    if (prev) {
+        prev->next_sibling_id = child->next_sibling_id;
+    } else {
+        parent->first_child_id = child->next_sibling_id;
+    }
+    if (next) {
+        next->prev_sibling_id = child->prev_sibling_id;
+    } else {
+        parent->last_child_id = child->prev_sibling_id;
+    }
+
+    child->parentID        = 0;
+    child->prev_sibling_id = 0;
+    child->next_sibling_id = 0;
+    --parent->child_count;
+}
+
+// O(1) append to parent's children list
+static void _R_Transform_Link(R_Transform* parent, R_Transform* child)
+{
+    ASSERT(child->parentID == 0);
+
+    R_Transform* last = Component_GetXform(parent->last_child_id);
+    if (last) {
+        last->next_sibling_id = child->id;
+    } else {
+        parent->first_child_id = child->id;
+    }
+
+    child->parentID        = parent->id;
+    child->prev_sibling_id = parent->last_child_id;
+    child->next_sibling_id = 0;
+    parent->last_child_id  = child->id;
+    ++parent->child_count;
+}
+
 void R_Transform::removeChild(R_Transform* parent, R_Transform* child)
 {
     if (child->parentID != parent->id) {
@@ -233,44 +274,19 @@ void R_Transform::removeChild(R_Transform* parent, R_Transform* child)
         return;
     }
 
-    size_t numChildren = ARENA_LENGTH(&parent->children, SG_ID);
-    SG_ID* children    = (SG_ID*)parent->children.base;
-
-    // remove child's parent reference
-    child->parentID = 0;
-
-    // remove from parent
-    for (size_t i = 0; i < numChildren; ++i) {
-        if (children[i] == child->id) {
-            // swap with last element
-            children[i] = children[numChildren - 1];
-            // pop last element
-            Arena::pop(&parent->children, sizeof(SG_ID));
-            break;
-        }
-    }
+    _R_Transform_Unlink(parent, child);
 
     // remove child subgraph from scene render state
-    R_Scene* scene = R_Transform::getScene(parent);
-    R_Scene::removeSubgraphFromRenderState(scene, child);
+    R_Scene::removeSubgraphFromRenderState(Component_GetScene(child->scene_id), child);
 }
 
 void R_Transform::removeAllChildren(R_Transform* parent)
 {
     if (!parent) return;
 
-    R_Scene* scene     = R_Transform::getScene(parent);
-    size_t numChildren = ARENA_LENGTH(&parent->children, SG_ID);
-    SG_ID* children    = (SG_ID*)parent->children.base;
-
-    for (size_t i = 0; i < numChildren; ++i) {
-        R_Transform* child = Component_GetXform(children[i]);
-        // remove child's parent reference
-        child->parentID = 0;
-        R_Scene::removeSubgraphFromRenderState(scene, child);
+    while (parent->first_child_id) {
+        R_Transform::removeChild(parent, Component_GetXform(parent->first_child_id));
     }
-
-    Arena::clear(&parent->children);
 }
 
 void R_Transform::addChild(R_Transform* parent, R_Transform* child)
@@ -289,23 +305,23 @@ void R_Transform::addChild(R_Transform* parent, R_Transform* child)
     if (child->parentID == parent->id) return;
 
     // remove child from previous parent
+    R_Scene* prev_scene = Component_GetScene(child->scene_id);
     if (child->parentID != 0) {
-        R_Transform* prevParent = Component_GetXform(child->parentID);
-        R_Transform::removeChild(prevParent, child);
+        _R_Transform_Unlink(Component_GetXform(child->parentID), child);
     }
 
-    // set parent of child
-    child->parentID = parent->id;
-
     // add child to parent
-    SG_ID* xformID = ARENA_PUSH_ZERO_TYPE(&parent->children, SG_ID);
-    *xformID       = child->id;
+    _R_Transform_Link(parent, child);
 
     R_Transform::setStale(child, R_Transform_STALE_WORLD);
 
-    // add child subgraph to scene render state
-    R_Scene* scene = R_Transform::getScene(parent);
-    R_Scene::addSubgraphToRenderState(scene, child);
+    // only walk the child subgraph to move its meshes and lights if it changed
+    // scenes. Reparenting within a scene is O(1)
+    R_Scene* scene = Component_GetScene(parent->scene_id);
+    if (scene != prev_scene) {
+        R_Scene::removeSubgraphFromRenderState(prev_scene, child);
+        R_Scene::addSubgraphToRenderState(scene, child);
+    }
 }
 
 glm::mat4 R_Transform::localMatrix(R_Transform* xform)
@@ -393,16 +409,16 @@ static void _Transform_RebuildDescendants(R_Scene* scene, R_Transform* xform,
     // always rebuild world mat
     xform->world  = (*parentWorld) * xform->local;
     xform->normal = glm::transpose(glm::inverse(xform->world));
+    ++xform->world_version;
 
     // set fresh
     xform->_stale = R_Transform_STALE_NONE;
 
     // rebuild all children
-    for (u32 i = 0; i < ARENA_LENGTH(&xform->children, SG_ID); ++i) {
-        R_Transform* child
-          = Component_GetXform(*ARENA_GET_TYPE(&xform->children, SG_ID, i));
-        ASSERT(child != NULL);
+    R_Transform* child = Component_GetXform(xform->first_child_id);
+    while (child) {
         _Transform_RebuildDescendants(scene, child, &xform->world);
+        child = Component_GetXform(child->next_sibling_id);
     }
 }
 
@@ -428,10 +444,11 @@ void R_Transform::rebuildMatrices(R_Scene* root, Arena* arena)
             case R_Transform_STALE_NONE: break;
             case R_Transform_STALE_DESCENDENTS: {
                 // add to stack
-                SG_ID* children = (SG_ID*)xform->children.base;
-                for (u32 i = 0; i < ARENA_LENGTH(&xform->children, SG_ID); ++i) {
-                    SG_ID* childID = ARENA_PUSH_ZERO_TYPE(arena, SG_ID);
-                    *childID       = children[i];
+                SG_ID child_id = xform->first_child_id;
+                while (child_id) {
+                    *ARENA_PUSH_TYPE(arena, SG_ID) = child_id;
+
+                    child_id = Component_GetXform(child_id)->next_sibling_id;
                 }
                 break;
             }
@@ -453,12 +470,7 @@ void R_Transform::rebuildMatrices(R_Scene* root, Arena* arena)
 
 u32 R_Transform::numChildren(R_Transform* xform)
 {
-    return ARENA_LENGTH(&xform->children, SG_ID);
-}
-
-R_Transform* R_Transform::getChild(R_Transform* xform, u32 index)
-{
-    return Component_GetXform(*ARENA_GET_TYPE(&xform->children, SG_ID, index));
+    return xform->child_count;
 }
 
 void R_Transform::rotateOnLocalAxis(R_Transform* xform, glm::vec3 axis, f32 deg)
@@ -504,9 +516,10 @@ void R_Transform::print(R_Transform* xform, u32 depth)
     }
     printf("  pos: %f %f %f\n", xform->_pos.x, xform->_pos.y, xform->_pos.z);
 
-    u32 childrenCount = R_Transform::numChildren(xform);
-    for (u32 i = 0; i < childrenCount; ++i) {
-        print(R_Transform::getChild(xform, i), depth + 1);
+    R_Transform* child = Component_GetXform(xform->first_child_id);
+    while (child) {
+        print(child, depth + 1);
+        child = Component_GetXform(child->next_sibling_id);
     }
 }
 
@@ -559,21 +572,45 @@ void R_Geometry::setVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
     geo->vertex_attribute_num_components[location] = num_components_per_attrib;
     GPU_Buffer::write(gctx, &geo->gpu_vertex_buffers[location],
                       (WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst), data, size);
+    ++geo->generation;
 
     if (location == SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION) {
         geo->gpu_wireframe_index_buffer_stale = 1;
+
+        // recompute bounds
+        geo->has_bounds = false;
+        if (num_components_per_attrib == 0) return;
+        f32* positions   = (f32*)data;
+        size_t num_verts = size / (sizeof(f32) * num_components_per_attrib);
+        u32 dims         = MIN(num_components_per_attrib, 3);
+        if (num_verts == 0) return;
+
+        geo->bounds_min = glm::vec3(FLT_MAX);
+        geo->bounds_max = glm::vec3(-FLT_MAX);
+        for (size_t i = 0; i < num_verts; i++) {
+            f32* p = positions + i * num_components_per_attrib;
+            for (u32 d = 0; d < dims; d++) {
+                geo->bounds_min[d] = MIN(geo->bounds_min[d], p[d]);
+                geo->bounds_max[d] = MAX(geo->bounds_max[d], p[d]);
+            }
+        }
+        // missing components are 0
+        for (u32 d = dims; d < 3; d++) geo->bounds_min[d] = geo->bounds_max[d] = 0.0f;
+        geo->has_bounds = true;
     }
 }
 
-void R_Geometry::setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
-                            u32 indices_count)
+void R_Geometry::setIndices(GraphicsContext* gctx, R_Geometry* geo,
+                            SG_GeometryBlock* indices)
 {
-    int size = indices_count * sizeof(*indices);
     GPU_Buffer::write(gctx, &geo->gpu_index_buffer,
-                      (WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst), indices, size);
-    geo->index_buffer_MALLOC = (u32*)realloc(geo->index_buffer_MALLOC, size);
-    memcpy(geo->index_buffer_MALLOC, indices, size);
+                      (WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst),
+                      indices ? indices->data : NULL, indices ? indices->size : 0);
+    // takes over the command's ref instead of copying
+    SG_GeometryBlock::release(geo->indices_block);
+    geo->indices_block                    = indices;
     geo->gpu_wireframe_index_buffer_stale = true;
+    ++geo->generation;
 }
 
 bool R_Geometry::usesVertexPulling(R_Geometry* geo)
@@ -584,7 +621,8 @@ bool R_Geometry::usesVertexPulling(R_Geometry* geo)
     return false;
 }
 
-void R_Geometry::addPullBindGroupEntries(R_Geometry* geo, G_Graph* graph, G_DrawCall* d)
+void R_Geometry::addPullBindGroupEntries(R_Geometry* geo, G_DrawRecorder* graph,
+                                         G_DrawCall* d)
 {
     for (u32 i = 0; i < ARRAY_LENGTH(geo->pull_buffers); i++) {
         if (geo->pull_buffers[i].buf == NULL) {
@@ -594,6 +632,8 @@ void R_Geometry::addPullBindGroupEntries(R_Geometry* geo, G_Graph* graph, G_Draw
         graph->bindBuffer(d, VERTEX_PULL_GROUP, i, geo->pull_buffers[i].buf, 0,
                           geo->pull_buffers[i].size);
     }
+    graph->persistentBindGroup(d, VERTEX_PULL_GROUP, &geo->pull_bg_slots,
+                               geo->generation);
 }
 
 void R_Geometry::setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
@@ -601,6 +641,7 @@ void R_Geometry::setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo
 {
     GPU_Buffer::write(gctx, &geo->pull_buffers[location], WGPUBufferUsage_Storage, data,
                       size_bytes);
+    ++geo->generation;
 }
 
 void R_Geometry::rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx)
@@ -611,19 +652,20 @@ void R_Geometry::rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx)
     log_trace("rebuilding wireframe");
 
     u32 num_indices        = R_Geometry::indexCount(geo);
+    u32* indices           = geo->indices_block ? (u32*)geo->indices_block->data : NULL;
     int wireframe_i        = 0;
     u64 size_bytes         = 0;
     u32* wireframe_indices = NULL;
-    if (num_indices > 0) {
+    if (num_indices > 0 && indices) {
         wireframe_indices = ARENA_PUSH_COUNT(&gctx->frame_arena, u32, num_indices * 2);
         size_bytes        = sizeof(u32) * num_indices * 2;
         for (int i = 0; i < num_indices; i += 3) {
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 1];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 1];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 2];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i + 2];
-            wireframe_indices[wireframe_i++] = geo->index_buffer_MALLOC[i];
+            wireframe_indices[wireframe_i++] = indices[i];
+            wireframe_indices[wireframe_i++] = indices[i + 1];
+            wireframe_indices[wireframe_i++] = indices[i + 1];
+            wireframe_indices[wireframe_i++] = indices[i + 2];
+            wireframe_indices[wireframe_i++] = indices[i + 2];
+            wireframe_indices[wireframe_i++] = indices[i];
         }
         ASSERT(wireframe_i == num_indices * 2);
     } else {
@@ -649,160 +691,180 @@ void R_Geometry::rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx)
 // R_Texture
 // ============================================================================
 
-struct LoadImageResult {
-    void* pixel_data_OWNED; // free with stbi_image_free
-    size_t pixel_data_size; // byte size of pixel data
-    i32 width;
-    i32 height;
-    i32 components; // 4 for rgba
-};
+// image files are decoded on the texture stream workers and uploaded a few rows
+// per frame by Component_UploadStreamedTextures. see texture_stream.h
+static TextureStream _r_texture_stream;
 
-enum LoadImageType {
-    LoadImageType_File = 0,
-    LoadImageType_Raw,
-};
+// bound in place of textures that are still loading
+static struct {
+    WGPUTexture texture_2d;
+    WGPUTexture cubemap;
+} _r_texture_placeholders;
 
-struct LoadImageParams {
-    LoadImageType type;
+// TextureCompression flags of the device, set once in Component_Init before any
+// worker decodes
+static u32 _r_texture_compression;
 
-    // shared params
-    WGPUTextureFormat format;
-    bool flip_y;
+// KTX2 files hold GPU formats and their own mip chain, which are kept if the GPU
+// can sample them, else decoded to RGBA8. The file's orientation is used as is,
+// flip_y is ignored
+static bool R_Texture_StreamDecodeKTX2(TextureStreamJob* job, const u8* data, u64 len)
+{
+    KTX2Image image;
+    if (!TextureTranscode_ParseKTX2(data, len, false, &image, &job->error)) {
+        return false;
+    }
 
-    // raw params
-    u8* buffer;
-    int buffer_len;
+    TextureTranscodeResult result;
+    if (!TextureTranscode_KTX2(data, len, &image, _r_texture_compression, true, &result,
+                               &job->error))
+        return false;
 
-    // file params
-    const char* filepath;
-};
+    ASSERT(result.level_count <= TEXTURE_STREAM_MAX_LEVELS);
+    job->pixels        = result.pixels;
+    job->format        = G_textureFormat(result.format, result.srgb);
+    job->width         = result.width;
+    job->height        = result.height;
+    job->bytes_per_row = result.levels[0].bytes_per_row;
+    job->level_count   = result.level_count;
+    for (u32 i = 0; i < result.level_count; i++) {
+        TextureTranscodeLevel* src = &result.levels[i];
+        job->levels[i]             = { src->offset, (int)src->width, (int)src->height,
+                                       (int)src->rows, (int)src->bytes_per_row };
+    }
+    return true;
+}
+
+static bool R_Texture_IsKTX2File(const char* filepath)
+{
+    u8 identifier[12] = {};
+    FILE* file        = fopen(filepath, "rb");
+    if (!file) return false;
+    size_t read = fread(identifier, 1, sizeof(identifier), file);
+    fclose(file);
+    return TextureTranscode_IsKTX2(identifier, read);
+}
 
-static LoadImageResult R_Texture_LoadImage(LoadImageParams p)
+static bool R_Texture_StreamDecode(TextureStreamJob* job)
 {
-    LoadImageResult result = {};
+    if (job->filepath && R_Texture_IsKTX2File(job->filepath)) {
+        FileReadResult file = File_read(job->filepath, false);
+        if (!file.data_owned) {
+            job->error = "unable to read file";
+            return false;
+        }
+        bool ok = R_Texture_StreamDecodeKTX2(job, (u8*)file.data_owned, file.size);
+        free(file.data_owned);
+        return ok;
+    }
+    if (!job->filepath && TextureTranscode_IsKTX2(job->data, job->data_len)) {
+        return R_Texture_StreamDecodeKTX2(job, job->data, job->data_len);
+    }
+
     // Force loading 3 channel images to 4 channel by stb becasue Dawn
     // doesn't support 3 channel formats currently. The group is discussing
     // on whether webgpu shoud support 3 channel format.
     // https://github.com/gpuweb/gpuweb/issues/66#issuecomment-410021505
     i32 desired_comps = STBI_rgb_alpha; // force 4 channels
+    i32 components    = 0;
 
-    stbi_set_flip_vertically_on_load(p.flip_y);
+    // runs on a worker, the flip flag and failure reason are thread local
+    stbi_set_flip_vertically_on_load_thread(job->flip_y);
 
     // currently only support ldr (TODO add hdr f16 and f32)
-    ASSERT(p.format
-           & (WGPUTextureFormat_RGBA8Unorm | WGPUTextureFormat_RGBA8UnormSrgb));
-
-    if (p.type == LoadImageType_File) {
-        result.pixel_data_OWNED = stbi_load(p.filepath,         //
-                                            &result.width,      //
-                                            &result.height,     //
-                                            &result.components, //
-                                            desired_comps       //
-        );
-    } else if (p.type == LoadImageType_Raw) {
-        // STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer,
-        // int len   , int *x, int *y, int *channels_in_file, int desired_channels);
-        result.pixel_data_OWNED = stbi_load_from_memory(p.buffer, p.buffer_len,
-                                                        &result.width,      //
-                                                        &result.height,     //
-                                                        &result.components, //
-                                                        desired_comps       //
-        );
+    if (job->filepath) {
+        job->pixels = stbi_load(job->filepath, &job->width, &job->height, &components,
+                                desired_comps);
     } else {
-        UNREACHABLE;
+        job->pixels = stbi_load_from_memory(job->data, job->data_len, &job->width,
+                                            &job->height, &components, desired_comps);
     }
-    bool is_hdr = false;
 
-    // update byte size
-    if (result.pixel_data_OWNED) {
-        result.pixel_data_size = result.width * result.height * desired_comps;
+    if (job->pixels == NULL) {
+        job->error = stbi_failure_reason();
+        return false;
     }
+    job->bytes_per_row = job->width * desired_comps;
+    return true;
+}
 
-    // if (texture->desc.format == WGPUTextureFormat_RGBA32Float) {
-    //     pixelData = stbi_loadf(filepath,     //
-    //                            &width,       //
-    //                            &height,      //
-    //                            &read_comps,  //
-    //                            desired_comps //
-    //     );
+static void R_Texture_StreamFreePixels(u8* pixels)
+{
+    // the transcoder mallocs too, which stbi_image_free matches
+    stbi_image_free(pixels);
+}
 
-    if (result.pixel_data_OWNED == NULL) {
-        log_error("Couldn't load image from raw data\n. Reason: %s",
-                  stbi_failure_reason());
-    } else {
-        log_info("Loaded %s image from raw data (%d, %d, %d / %d)\n",
-                 is_hdr ? "HDR" : "LDR", result.width, result.height, result.components,
-                 desired_comps);
+static WGPUTexture R_Texture_CreatePlaceholder(GraphicsContext* gctx, u32 layers,
+                                               const char* label)
+{
+    WGPUTextureDescriptor desc = {};
+    desc.label                 = label;
+    desc.usage         = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+    desc.dimension     = WGPUTextureDimension_2D;
+    desc.size          = { 1, 1, layers };
+    desc.format        = WGPUTextureFormat_RGBA8Unorm;
+    desc.mipLevelCount = 1;
+    desc.sampleCount   = 1;
+
+    WGPUTexture texture = wgpuDeviceCreateTexture(gctx->device, &desc);
+
+    // white, like the default color map
+    u8 white[4]                      = { 255, 255, 255, 255 };
+    WGPUImageCopyTexture destination = {};
+    destination.texture              = texture;
+    destination.aspect               = WGPUTextureAspect_All;
+    WGPUTextureDataLayout source     = {};
+    source.bytesPerRow               = sizeof(white);
+    source.rowsPerImage              = 1;
+    WGPUExtent3D size                = { 1, 1, 1 };
+    for (u32 i = 0; i < layers; i++) {
+        destination.origin.z = i;
+        wgpuQueueWriteTexture(gctx->queue, &destination, white, sizeof(white),
+                              &source, &size);
     }
-
-    return result;
+    return texture;
 }
 
 int R_Texture::sizeBytes(R_Texture* texture)
 {
-    return wgpuTextureGetWidth(texture->gpu_texture)
-           * wgpuTextureGetHeight(texture->gpu_texture)
-           * wgpuTextureGetDepthOrArrayLayers(texture->gpu_texture)
-           * G_bytesPerTexel(wgpuTextureGetFormat(texture->gpu_texture));
+    return (int)(G_textureLevelBytes(wgpuTextureGetFormat(texture->gpu_texture),
+                                     wgpuTextureGetWidth(texture->gpu_texture),
+                                     wgpuTextureGetHeight(texture->gpu_texture))
+                 * wgpuTextureGetDepthOrArrayLayers(texture->gpu_texture));
 }
 
-void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, const char* filepath,
-                     bool flip_vertically, bool gen_mips)
+static void R_Texture_StreamBegin(R_Texture* texture, u32 layers, bool gen_mips)
 {
-    LoadImageParams params = {};
-    params.type            = LoadImageType_File;
-    params.format          = texture->desc.format;
-    params.flip_y          = flip_vertically;
-    params.filepath        = filepath;
-    LoadImageResult result = R_Texture_LoadImage(params);
-    // free pixel data
-    defer(if (result.pixel_data_OWNED) stbi_image_free(result.pixel_data_OWNED););
+    // currently only support ldr (TODO add hdr f16 and f32)
+    ASSERT(texture->desc.format == WGPUTextureFormat_RGBA8Unorm
+           || texture->desc.format == WGPUTextureFormat_RGBA8UnormSrgb);
 
-    SG_TextureWriteDesc write_desc = {};
-    write_desc.width               = result.width;
-    write_desc.height              = result.height;
-    R_Texture::write(gctx, texture, &write_desc, result.pixel_data_OWNED,
-                     result.width * result.height
-                       * G_bytesPerTexel(texture->desc.format));
-
-    if (gen_mips) {
-        // MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name.c_str());
-        MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name);
-    }
+    // loading again before the last load finished: both complete together
+    texture->stream_pending += layers;
+    texture->stream_gen_mips = gen_mips;
+    ++g_gpu_resource_epoch; // rebind with the placeholder
 }
 
-void R_Texture::load(GraphicsContext* gctx, R_Texture* texture, u8* buffer,
-                     int buffer_len, bool flip_vertically, bool gen_mips)
+void R_Texture::load(R_Texture* texture, const char* filepath, bool flip_vertically,
+                     bool gen_mips)
 {
-    LoadImageParams params = {};
-    params.type            = LoadImageType_Raw;
-    params.format          = texture->desc.format;
-    params.flip_y          = flip_vertically;
-    params.buffer          = buffer;
-    params.buffer_len      = buffer_len;
-    LoadImageResult result = R_Texture_LoadImage(params);
-
-    // free pixel data
-    defer(if (result.pixel_data_OWNED) stbi_image_free(result.pixel_data_OWNED););
+    R_Texture_StreamBegin(texture, 1, gen_mips);
+    TextureStream_SubmitFile(&_r_texture_stream, texture->id, 0, filepath,
+                             flip_vertically);
+}
 
-    SG_TextureWriteDesc write_desc = {};
-    write_desc.width               = result.width;
-    write_desc.height              = result.height;
-    R_Texture::write(gctx, texture, &write_desc, result.pixel_data_OWNED,
-                     result.width * result.height
-                       * G_bytesPerTexel(texture->desc.format));
-
-    if (gen_mips) {
-        // MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name.c_str());
-        MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name);
-    }
+void R_Texture::load(R_Texture* texture, u8* buffer, int buffer_len,
+                     bool flip_vertically, bool gen_mips)
+{
+    R_Texture_StreamBegin(texture, 1, gen_mips);
+    TextureStream_SubmitMemory(&_r_texture_stream, texture->id, 0, buffer, buffer_len,
+                               flip_vertically);
 }
 
-void R_Texture::loadCubemap(GraphicsContext* gctx, R_Texture* texture,
-                            const char* right_face_path, const char* left_face_path,
-                            const char* top_face_path, const char* bottom_face_path,
-                            const char* back_face_path, const char* front_face_path,
-                            bool flip_y)
+void R_Texture::loadCubemap(R_Texture* texture, const char* right_face_path,
+                            const char* left_face_path, const char* top_face_path,
+                            const char* bottom_face_path, const char* back_face_path,
+                            const char* front_face_path, bool flip_y)
 {
     // cubemap validation
     ASSERT(texture->desc.depth == 6);
@@ -812,26 +874,10 @@ void R_Texture::loadCubemap(GraphicsContext* gctx, R_Texture* texture,
     const char* faces[6] = { right_face_path,  left_face_path, top_face_path,
                              bottom_face_path, back_face_path, front_face_path };
 
-    LoadImageParams params = {};
-    params.type            = LoadImageType_File;
-    params.format          = texture->desc.format;
-    params.flip_y          = flip_y;
-    for (int i = 0; i < 6; i++) {
-        params.filepath        = faces[i];
-        LoadImageResult result = R_Texture_LoadImage(params);
-        // free pixel data
-        defer(if (result.pixel_data_OWNED) stbi_image_free(result.pixel_data_OWNED););
-
-        // validate size
-        ASSERT(texture->desc.width == result.width);
-        ASSERT(texture->desc.height == result.height);
-
-        SG_TextureWriteDesc write_desc = {};
-        write_desc.offset_z            = i; // write to ith cubemap face
-        write_desc.width               = result.width;
-        write_desc.height              = result.height;
-        R_Texture::write(gctx, texture, &write_desc, result.pixel_data_OWNED,
-                         result.pixel_data_size);
+    R_Texture_StreamBegin(texture, 6, false);
+    for (u32 i = 0; i < 6; i++) {
+        // write to ith cubemap face
+        TextureStream_SubmitFile(&_r_texture_stream, texture->id, i, faces[i], flip_y);
     }
 }
 
@@ -847,16 +893,14 @@ void MaterialTextureView::init(MaterialTextureView* view)
     view->scale[1] = 1.0f;
 }
 
+// uniform blocks of every material, packed into a few large GPU buffers
+static G_UniformPool material_uniform_pool = {};
+
 void R_Material::createBindGroupEntries(R_Material* mat, int group, G_Graph* graph,
-                                        G_DrawCall* drawcall, GraphicsContext* gctx)
+                                        G_DrawCall* drawcall, GraphicsContext* gctx,
+                                        G_DrawRecorder* recorder)
 {
-    // update gpu uniform buffer if stale
-    if (mat->_uniform_buffer_stale) {
-        mat->_uniform_buffer_stale = false;
-        wgpuQueueWriteBuffer(gctx->queue, mat->_uniform_buffer, 0,
-                             mat->_cpu_uniform_buffer_MALLOC,
-                             wgpuBufferGetSize(mat->_uniform_buffer));
-    }
+    G_DrawRecorder* rec = recorder ? recorder : graph;
 
     // create bindgroups for all bindings
 
@@ -869,25 +913,24 @@ void R_Material::createBindGroupEntries(R_Material* mat, int group, G_Graph* gra
 
         switch (binding->type) {
             case R_BIND_UNIFORM: {
-                const int UNIFORM_OFFSET
-                  = MAX(gctx->limits.minUniformBufferOffsetAlignment,
-                        sizeof(SG_MaterialUniformData));
-                drawcall ? graph->bindBuffer(drawcall, group, i, mat->_uniform_buffer,
-                                             UNIFORM_OFFSET * i,
-                                             sizeof(SG_MaterialUniformData)) :
-                           graph->computePassBindBuffer(i, mat->_uniform_buffer,
-                                                        UNIFORM_OFFSET * i,
-                                                        sizeof(SG_MaterialUniformData));
+                G_UniformPool* pool = &material_uniform_pool;
+                u32 block           = binding->as.uniform_block;
+                WGPUBuffer buffer   = G_UniformPool::buffer(pool, block);
+                u32 offset          = G_UniformPool::offset(pool, block);
+                drawcall ? rec->bindBuffer(drawcall, group, i, buffer, offset,
+                                           sizeof(SG_MaterialUniformData)) :
+                           graph->computePassBindBuffer(
+                             i, buffer, offset, sizeof(SG_MaterialUniformData));
             } break;
             case R_BIND_STORAGE: {
                 drawcall ?
-                  graph->bindBuffer(drawcall, group, i, binding->as.storage_buffer.buf,
-                                    0, binding->size) :
+                  rec->bindBuffer(drawcall, group, i, binding->as.storage_buffer.buf, 0,
+                                  binding->size) :
                   graph->computePassBindBuffer(i, binding->as.storage_buffer.buf, 0,
                                                binding->size);
             } break;
             case R_BIND_SAMPLER: {
-                drawcall ? graph->bindSampler(
+                drawcall ? rec->bindSampler(
                              drawcall, group, i,
                              Graphics_GetSampler(gctx, binding->as.samplerConfig)) :
                            graph->computePassBindSampler(
@@ -911,22 +954,36 @@ void R_Material::createBindGroupEntries(R_Material* mat, int group, G_Graph* gra
                       0,
                       1 };
 
-                drawcall ? graph->bindTexture(drawcall, group, i, view_desc) :
+                // still loading. Rebound when done, which bumps g_gpu_resource_epoch
+                if (r_texture->stream_pending) {
+                    view_desc.texture         = is_cubemap ?
+                                                  _r_texture_placeholders.cubemap :
+                                                  _r_texture_placeholders.texture_2d;
+                    view_desc.base_mip_level  = 0;
+                    view_desc.mip_level_count = 1;
+                }
+
+                drawcall ? rec->bindTexture(drawcall, group, i, view_desc) :
                            graph->computePassBindTexture(i, view_desc);
 
                 ASSERT(r_texture->gpu_texture);
                 ASSERT(binding->size == sizeof(R_TextureBinding));
             } break;
             case R_BIND_STORAGE_EXTERNAL: {
-                drawcall ? graph->bindBuffer(drawcall, group, i,
-                                             binding->as.storage_external->buf, 0,
-                                             binding->size) :
+                drawcall ? rec->bindBuffer(drawcall, group, i,
+                                           binding->as.storage_external->buf, 0,
+                                           binding->size) :
                            graph->computePassBindBuffer(
                              i, binding->as.storage_external->buf, 0, binding->size);
             } break;
             default: ASSERT(false);
         }
     }
+
+    if (drawcall) {
+        rec->persistentBindGroup(drawcall, group, &mat->bg_slots,
+                                 mat->bindgroup_version);
+    }
 }
 
 static SamplerConfig samplerConfigFromSGSampler(SG_Sampler sg_sampler)
@@ -969,25 +1026,40 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
                             R_BindType type, void* data, size_t bytes)
 {
     R_Binding* binding = &mat->bindings[location];
-    binding->type      = type;
-    binding->size      = bytes;
+
+    // uniform data lives in the material's uniform buffer, so only changing the
+    // binding type or resource invalidates the material's bindgroups. Storage
+    // buffers that get recreated on write bump g_gpu_resource_epoch instead
+    bool bindgroup_stale = (binding->type != type || binding->size != bytes);
+
+    // give up or claim a uniform block on type change. Blocks never move, so
+    // rewriting a uniform keeps the same block (and bindgroup)
+    bool was_uniform = (binding->type == R_BIND_UNIFORM);
+    if (was_uniform && type != R_BIND_UNIFORM)
+        G_UniformPool::free(&material_uniform_pool, binding->as.uniform_block);
+
+    binding->type = type;
+    binding->size = bytes;
+    ++mat->bindings_version;
 
     // create new binding
     switch (type) {
         case R_BIND_UNIFORM: {
-            size_t offset = MAX(gctx->limits.minUniformBufferOffsetAlignment,
-                                sizeof(SG_MaterialUniformData))
-                            * location;
-
-            mat->_uniform_buffer_stale = true;
-            memcpy(((char*)mat->_cpu_uniform_buffer_MALLOC) + offset, data, bytes);
+            if (!was_uniform) {
+                binding->as.uniform_block
+                  = G_UniformPool::alloc(&material_uniform_pool, gctx);
+            }
+            G_UniformPool::write(&material_uniform_pool, binding->as.uniform_block,
+                                 data, bytes);
         } break;
         case R_BIND_TEXTURE: {
             ASSERT(bytes == sizeof(R_TextureBinding));
+            bindgroup_stale |= (memcmp(&binding->as.texture, data, bytes) != 0);
             binding->as.texture = *(R_TextureBinding*)data;
         } break;
         case R_BIND_SAMPLER: {
             ASSERT(bytes == sizeof(SamplerConfig));
+            bindgroup_stale |= (memcmp(&binding->as.samplerConfig, data, bytes) != 0);
             binding->as.samplerConfig = *(SamplerConfig*)data;
         } break;
         case R_BIND_STORAGE: {
@@ -996,6 +1068,7 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
         } break;
         case R_BIND_STORAGE_EXTERNAL: {
             // external storage buffer
+            bindgroup_stale |= (binding->as.storage_external != (GPU_Buffer*)data);
             binding->as.storage_external = (GPU_Buffer*)data;
         } break;
         default:
@@ -1005,6 +1078,81 @@ void R_Material::setBinding(GraphicsContext* gctx, R_Material* mat, u32 location
             ASSERT(false);
             break;
     }
+
+    if (bindgroup_stale) ++mat->bindgroup_version;
+}
+
+void R_Material::removeBinding(R_Material* mat, u32 location)
+{
+    R_Binding* binding = &mat->bindings[location];
+    if (binding->type == R_BIND_EMPTY) return;
+
+    if (binding->type == R_BIND_UNIFORM)
+        G_UniformPool::free(&material_uniform_pool, binding->as.uniform_block);
+
+    binding->type = R_BIND_EMPTY;
+    binding->size = 0;
+    ++mat->bindings_version;
+    ++mat->bindgroup_version;
+}
+
+void R_Material::validateBinding(R_Material* mat, u32 location,
+                                 SG_MaterialUniformType type)
+{
+    R_Shader* shader = Component_GetShader(mat->pso.sg_shader_id);
+    if (!shader || !shader->reflection.ok || location >= 32) return;
+    if (mat->binding_warned & (1u << location)) return;
+
+    ShaderBindingKind kind = SHADER_BINDING_UNIFORM_BUFFER;
+    ShaderValueType value  = {};
+    switch (type) {
+        case SG_MATERIAL_UNIFORM_FLOAT: value = { SHADER_SCALAR_F32, 1, 1 }; break;
+        case SG_MATERIAL_UNIFORM_VEC2F: value = { SHADER_SCALAR_F32, 2, 1 }; break;
+        case SG_MATERIAL_UNIFORM_VEC3F: value = { SHADER_SCALAR_F32, 3, 1 }; break;
+        case SG_MATERIAL_UNIFORM_VEC4F: value = { SHADER_SCALAR_F32, 4, 1 }; break;
+        case SG_MATERIAL_UNIFORM_INT: value = { SHADER_SCALAR_I32, 1, 1 }; break;
+        case SG_MATERIAL_UNIFORM_IVEC2: value = { SHADER_SCALAR_I32, 2, 1 }; break;
+        case SG_MATERIAL_UNIFORM_IVEC3: value = { SHADER_SCALAR_I32, 3, 1 }; break;
+        case SG_MATERIAL_UNIFORM_IVEC4: value = { SHADER_SCALAR_I32, 4, 1 }; break;
+        case SG_MATERIAL_UNIFORM_TEXTURE: kind = SHADER_BINDING_TEXTURE; break;
+        case SG_MATERIAL_UNIFORM_SAMPLER: kind = SHADER_BINDING_SAMPLER; break;
+        case SG_MATERIAL_UNIFORM_STORAGE_BUFFER:
+        case SG_MATERIAL_UNIFORM_STORAGE_BUFFER_EXTERNAL:
+            kind = SHADER_BINDING_STORAGE_BUFFER;
+            break;
+        case SG_MATERIAL_STORAGE_TEXTURE: kind = SHADER_BINDING_STORAGE_TEXTURE; break;
+        default: return;
+    }
+
+    // unused by the shader is fine, the binding is dropped from the bindgroup
+    ShaderBinding* binding
+      = ShaderReflect_FindBinding(&shader->reflection, PER_MATERIAL_GROUP, location);
+    if (!binding || ShaderReflect_Compatible(binding, kind, value)) return;
+
+    mat->binding_warned |= (1u << location);
+    char value_name[16] = {};
+    ShaderReflect_ValueTypeName(value, value_name, sizeof(value_name));
+    const char* kind_names[]
+      = { "?",       "uniform", "storage buffer", "storage buffer", "sampler",
+          "sampler", "texture", "storage texture" };
+    bool is_uniform = (kind == SHADER_BINDING_UNIFORM_BUFFER);
+    log_warn(
+      "Material[%d:%s] @binding(%d): shader %s declares \"%s : %s\", but was given a "
+      "%s%s%s",
+      mat->id, mat->name, location, kind_names[binding->kind], binding->name,
+      binding->type_name, kind_names[kind], is_uniform ? " " : "",
+      is_uniform ? value_name : "");
+}
+
+void R_Material::flushUniforms(GraphicsContext* gctx)
+{
+    G_UniformPool::flush(&material_uniform_pool, gctx->queue);
+}
+
+void R_Material::uniformStats(G_UniformPoolStats* frame, G_UniformPoolStats* lifetime)
+{
+    *frame    = material_uniform_pool.frame_stats;
+    *lifetime = material_uniform_pool.lifetime_stats;
 }
 
 // ============================================================================
@@ -1023,6 +1171,29 @@ struct GeometryToXforms {
     Arena draw_uniform_list; // array of DrawUniforms
     size_t push_size;        // size in bytes per element of draw_uniform_list
     b8 buffer_stale;         // if true, need to update storage buffer
+    G_BindGroupSlots draw_bg_slots; // @group(2) bindgroups for instanced draws
+
+    // shader and geometry generation last checked by R_Shader::validateGeometry,
+    // so a mismatch is logged once instead of every frame
+    SG_ID validated_shader_id;
+    u32 validated_geo_generation;
+    b8 geo_mismatch_logged;
+
+    // instances per LOD level (see mesh_lod.h). draw_uniform_list holds them
+    // grouped by level, so each level is one instanced draw. Culled instances are
+    // left out. Without a LOD chain everything is level 0
+    int lod_instance_counts[CHUGL_GEOMETRY_MAX_LODS + 1];
+    b8 lod_active; // draw_uniform_list was last built with LOD selection
+    u64 lod_fc;    // frame the levels were last picked in
+    Arena lod_levels; // scratch, level of each xform in xform_id_set order
+
+    // GScene.gpuCulling(): kernel uniforms, the instances it leaves visible and the
+    // indirect draw arguments it writes (see instance_cull.h)
+    GPU_Buffer cull_params_buffer;
+    GPU_Buffer cull_instance_buffer;
+    GPU_Buffer cull_args_buffer;
+    InstanceCullParams cull_params; // last written to cull_params_buffer
+    G_BindGroupSlots cull_bg_slots; // @group(2) bindgroups for culled draws
 
     static int count(GeometryToXforms* g2x)
     {
@@ -1065,12 +1236,37 @@ struct GeometryToXforms {
     {
         GeometryToXforms* g2x = (GeometryToXforms*)item;
         GPU_Buffer::destroy(&g2x->xform_storage_buffer);
+        G_BindGroupSlots::release(&g2x->draw_bg_slots);
+        GPU_Buffer::destroy(&g2x->cull_params_buffer);
+        GPU_Buffer::destroy(&g2x->cull_instance_buffer);
+        GPU_Buffer::destroy(&g2x->cull_args_buffer);
+        G_BindGroupSlots::release(&g2x->cull_bg_slots);
         hashmap_free(g2x->xform_id_set);
         Arena::free(&g2x->draw_uniform_list);
+        Arena::free(&g2x->lod_levels);
+    }
+
+    // LOD level of one instance for this camera, -1 if culled
+    static int lodLevel(R_Geometry* geo, R_Transform* xform, R_Camera* camera)
+    {
+        // world space bounding sphere, scaled by the largest axis
+        glm::vec4 sphere = InstanceCull_WorldSphere(
+          xform->world, InstanceCull_LocalSphere(geo->bounds_min, geo->bounds_max));
+
+        ASSERT(camera->_stale == R_Transform_STALE_NONE);
+        f32 dist = glm::distance(glm::vec3(camera->world[3]), glm::vec3(sphere));
+        f32 screen_size
+          = MeshLOD_ScreenSize(sphere.w, dist,
+                               camera->params.camera_type == SG_CameraType_PERPSECTIVE,
+                               camera->params.fov_radians, camera->params.size);
+        return MeshLOD_Select(screen_size, geo->lod_screen_sizes, geo->lod_count,
+                              geo->lod_cull_size);
     }
 
+    // camera picks the LOD levels, if the geometry has a LOD chain
     static void updateStorageBuffer(GraphicsContext* gctx, R_Scene* scene,
-                                    GeometryToXforms* g2x, WGPULimits* limits)
+                                    GeometryToXforms* g2x, WGPULimits* limits,
+                                    R_Camera* camera)
     {
         // should be nonempty (if empty, should have already been deleted)
         ASSERT(hashmap_count(g2x->xform_id_set) > 0);
@@ -1082,9 +1278,21 @@ struct GeometryToXforms {
 
         bool draw_uniform_padding_unchanged = (push_size == g2x->push_size);
 
-        if (draw_uniform_padding_unchanged && !g2x->buffer_stale) return;
+        // levels depend on the camera, so they are picked again every frame. Only
+        // once per frame though: buffer writes land before any pass is drawn, so
+        // every pass of a frame draws the same levels
+        R_Geometry* geo = Component_GetGeometry(g2x->key.geo_id);
+        bool lod_active = geo && (geo->lod_count > 0 || geo->lod_cull_size > 0.0f)
+                          && geo->has_bounds && !R_Geometry::usesVertexPulling(geo);
+        bool lod_due    = lod_active && g2x->lod_fc != scene->last_fc_updated;
+
+        if (draw_uniform_padding_unchanged && !g2x->buffer_stale && !lod_due
+            && lod_active == g2x->lod_active)
+            return;
         defer(g2x->buffer_stale = false);
         defer(g2x->push_size = push_size);
+        g2x->lod_active = lod_active;
+        g2x->lod_fc     = scene->last_fc_updated;
 
         // if material is flipped from transparent --> not transparent,
         // we actually need to mark this as stale and rebuild the buffer because
@@ -1103,13 +1311,38 @@ struct GeometryToXforms {
         transparency. simplest for now.
         */
 
-        // build new array of matrices on CPU
-        Arena::clear(&g2x->draw_uniform_list);
+        // pick levels, then build new array of matrices on CPU grouped by level
+        Arena::clear(&g2x->lod_levels);
+        memset(g2x->lod_instance_counts, 0, sizeof(g2x->lod_instance_counts));
+        int level_starts[CHUGL_GEOMETRY_MAX_LODS + 1] = {};
 
         size_t hashmap_idx_DONT_USE = 0;
         SG_ID* xform_id             = NULL;
         while (
           hashmap_iter(g2x->xform_id_set, &hashmap_idx_DONT_USE, (void**)&xform_id)) {
+            int level = lod_active ?
+                          lodLevel(geo, Component_GetXform(*xform_id), camera) :
+                          0;
+            *ARENA_PUSH_TYPE(&g2x->lod_levels, i8) = (i8)level;
+            if (level >= 0) g2x->lod_instance_counts[level]++;
+        }
+
+        int instance_count = 0;
+        for (int i = 0; i < ARRAY_LENGTH(level_starts); i++) {
+            level_starts[i] = instance_count;
+            instance_count += g2x->lod_instance_counts[i];
+        }
+
+        Arena::clear(&g2x->draw_uniform_list);
+        Arena::pushZero(&g2x->draw_uniform_list, instance_count * push_size);
+
+        hashmap_idx_DONT_USE = 0;
+        int xform_idx        = 0;
+        while (
+          hashmap_iter(g2x->xform_id_set, &hashmap_idx_DONT_USE, (void**)&xform_id)) {
+            int level = *ARENA_GET_TYPE(&g2x->lod_levels, i8, xform_idx++);
+            if (level < 0) continue; // culled
+
             R_Transform* xform = Component_GetXform(*xform_id);
 
             // all xforms should be valid here (can't delete xforms while
@@ -1125,13 +1358,15 @@ struct GeometryToXforms {
             ASSERT(xform->_stale == R_Transform_STALE_NONE);
 
             // add xform matrix to arena
-            DrawUniforms* draw_uniforms
-              = (DrawUniforms*)Arena::push(&g2x->draw_uniform_list, push_size);
+            DrawUniforms* draw_uniforms = (DrawUniforms*)Arena::get(
+              &g2x->draw_uniform_list, level_starts[level]++ * push_size);
             *draw_uniforms
               = { xform->world, xform->normal, xform->id, xform->receives_shadows, {} };
         }
 
+        // nothing to write if every instance is culled, nothing is drawn either
         u64 write_size = g2x->draw_uniform_list.curr;
+        if (write_size == 0) return;
         GPU_Buffer::write(gctx, &g2x->xform_storage_buffer, WGPUBufferUsage_Storage,
                           g2x->draw_uniform_list.base, write_size);
 
@@ -1150,6 +1385,33 @@ struct GeometryToXforms {
         ASSERT(i < GeometryToXforms::count(g2x));
         return (DrawUniforms*)Arena::get(&g2x->draw_uniform_list, i * g2x->push_size);
     }
+
+    // sizes the culling pass buffers for every instance, and writes the kernel
+    // uniforms if they changed. xform_storage_buffer must hold every instance,
+    // i.e. an opaque material and no LOD selection
+    static void updateCullBuffers(GraphicsContext* gctx, GeometryToXforms* g2x,
+                                  R_Geometry* geo, u32 element_count)
+    {
+        ASSERT(!g2x->lod_active && g2x->push_size == sizeof(DrawUniforms));
+
+        InstanceCullParams params = {};
+        params.sphere = InstanceCull_LocalSphere(geo->bounds_min, geo->bounds_max);
+        params.instance_count = count(g2x);
+        params.element_count  = element_count;
+        if (!g2x->cull_params_buffer.buf
+            || memcmp(&params, &g2x->cull_params, sizeof(params)) != 0) {
+            GPU_Buffer::write(gctx, &g2x->cull_params_buffer, WGPUBufferUsage_Uniform,
+                              &params, sizeof(params));
+            g2x->cull_params = params;
+        }
+
+        GPU_Buffer::resizeNoCopy(gctx, &g2x->cull_instance_buffer,
+                                 params.instance_count * sizeof(DrawUniforms),
+                                 WGPUBufferUsage_Storage);
+        GPU_Buffer::resizeNoCopy(gctx, &g2x->cull_args_buffer,
+                                 INSTANCE_CULL_ARGS_COUNT * sizeof(u32),
+                                 WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect);
+    }
 };
 
 static GeometryToXforms* R_Scene_getPrimitive(R_Scene* scene, SG_ID mat_id,
@@ -1197,9 +1459,11 @@ void R_Scene::removeSubgraphFromRenderState(R_Scene* scene, R_Transform* root)
         R_Transform* xform = Component_GetXform(xformID);
 
         // add children to queue
-        for (u32 i = 0; i < ARENA_LENGTH(&xform->children, SG_ID); ++i) {
-            *ARENA_PUSH_ZERO_TYPE(&arena, SG_ID)
-              = *ARENA_GET_TYPE(&xform->children, SG_ID, i);
+        SG_ID child_id = xform->first_child_id;
+        while (child_id) {
+            *ARENA_PUSH_TYPE(&arena, SG_ID) = child_id;
+
+            child_id = Component_GetXform(child_id)->next_sibling_id;
         }
 
         // remove scene from xform
@@ -1234,9 +1498,11 @@ void R_Scene::addSubgraphToRenderState(R_Scene* scene, R_Transform* root)
         ARENA_POP_TYPE(&arena, SG_ID);
 
         // add children to queue
-        for (u32 i = 0; i < ARENA_LENGTH(&xform->children, SG_ID); ++i) {
-            *ARENA_PUSH_ZERO_TYPE(&arena, SG_ID)
-              = *ARENA_GET_TYPE(&xform->children, SG_ID, i);
+        SG_ID child_id = xform->first_child_id;
+        while (child_id) {
+            *ARENA_PUSH_TYPE(&arena, SG_ID) = child_id;
+
+            child_id = Component_GetXform(child_id)->next_sibling_id;
         }
 
         // add scene to transform state
@@ -1257,6 +1523,112 @@ void R_Scene::addSubgraphToRenderState(R_Scene* scene, R_Transform* root)
     }
 }
 
+// extracts the 6 world space clip planes (normals pointing inwards) from a
+// projection * view matrix. Assumes [0,1] clip space depth
+static void _R_FrustumPlanes(const glm::mat4& proj_view, glm::vec4 planes[6])
+{
+    glm::mat4 m = glm::transpose(proj_view); // m[i] is now row i
+    planes[0]   = m[3] + m[0];               // left
+    planes[1]   = m[3] - m[0];               // right
+    planes[2]   = m[3] + m[1];               // bottom
+    planes[3]   = m[3] - m[1];               // top
+    planes[4]   = m[2];                      // near
+    planes[5]   = m[3] - m[2];               // far
+}
+
+// true if the mesh's world space bounds are entirely outside the frustum
+static bool _R_ShadowCasterCulled(glm::vec4 planes[6], R_Transform* mesh,
+                                  R_Geometry* geo)
+{
+    if (!geo->has_bounds || R_Geometry::usesVertexPulling(geo)) return false;
+
+    // transform local AABB to a world space AABB
+    glm::vec3 local_center = (geo->bounds_min + geo->bounds_max) * 0.5f;
+    glm::vec3 local_extent = (geo->bounds_max - geo->bounds_min) * 0.5f;
+    glm::vec3 center       = glm::vec3(mesh->world * glm::vec4(local_center, 1.0f));
+    glm::mat3 abs_world    = glm::mat3(mesh->world);
+    for (int i = 0; i < 3; i++) abs_world[i] = glm::abs(abs_world[i]);
+    glm::vec3 extent = abs_world * local_extent;
+
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 n = glm::vec3(planes[i]);
+        f32 r       = glm::dot(extent, glm::abs(n));
+        if (glm::dot(n, center) + planes[i].w + r < 0.0f) return true;
+    }
+    return false;
+}
+
+// folds everything a shadow caster's depth output depends on into hash.
+// Sets cacheable to false if the caster reads data that can change without
+// the renderer knowing (render targets, storage textures, external buffers)
+static u64 _R_ShadowCasterHash(u64 hash, R_Transform* mesh, R_Material* material,
+                               R_Geometry* geo, bool* cacheable)
+{
+    struct {
+        SG_ID mesh_id;
+        u32 world_version;
+        SG_ID geo_id;
+        u32 geo_generation;
+        int vertex_count;
+        int indices_count;
+        SG_ID material_id;
+        u32 bindings_version;
+        SG_ID shader_id;
+        WGPUCullMode cull_mode;
+        WGPUPrimitiveTopology primitive_topology;
+    } key = {};
+    key.mesh_id            = mesh->id;
+    key.world_version      = mesh->world_version;
+    key.geo_id             = geo->id;
+    key.geo_generation     = geo->generation;
+    key.vertex_count       = geo->vertex_count;
+    key.indices_count      = geo->indices_count;
+    key.material_id        = material->id;
+    key.bindings_version   = material->bindings_version;
+    key.shader_id          = material->pso.sg_shader_id;
+    key.cull_mode          = material->pso.cull_mode;
+    key.primitive_topology = material->pso.primitive_topology;
+    hash                   = hashmap_xxhash3(&key, sizeof(key), hash, 0);
+
+    // texture contents matter for alpha-tested materials
+    for (int i = 0; i < ARRAY_LENGTH(material->bindings); i++) {
+        R_Binding* binding = &material->bindings[i];
+        if (binding->type == R_BIND_STORAGE_EXTERNAL) {
+            *cacheable = false;
+        } else if (binding->type == R_BIND_TEXTURE) {
+            R_Texture* tex = Component_GetTexture(binding->as.texture.texture_id);
+            if (!tex) continue;
+            if (tex->desc.usage
+                & (WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_StorageBinding))
+                *cacheable = false;
+            u32 tex_key[2] = { (u32)tex->id, tex->generation };
+            hash           = hashmap_xxhash3(tex_key, sizeof(tex_key), hash, 0);
+        }
+    }
+
+    return hash;
+}
+
+// shadow draws are skipped while their pipeline compiles, so a layer rendered
+// before every caster's pipeline is ready is missing casters
+static bool _R_ShadowCasterPipelineReady(G_Cache* cache, R_Material* material,
+                                         WGPUTexture color_target,
+                                         WGPUTexture depth_target)
+{
+    // same desc the shadow pass draw sets below
+    G_DrawCall d = {};
+    d.pipelineDesc(material->pso.sg_shader_id, material->pso.cull_mode,
+                   material->pso.primitive_topology, &material->pso.blend_state,
+                   false, true);
+
+    G_CacheRenderPipelineKey key  = {};
+    key.drawcall_pipeline_desc    = d._pipeline_desc;
+    key.color_target_format       = wgpuTextureGetFormat(color_target);
+    key.depth_target_format       = wgpuTextureGetFormat(depth_target);
+    key.color_target_sample_count = wgpuTextureGetSampleCount(color_target);
+    return cache->renderPipelineReady(&key);
+}
+
 void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
                                      G_Graph* graph, FrameUniforms* frame_uniforms)
 {
@@ -1264,6 +1636,12 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
     ASSERT(light_info_arena.curr == 0);
     defer(Arena::clear(&light_info_arena));
 
+    // visible shadow casters of the current light
+    static Arena shadow_caster_arena{};
+    defer(Arena::clear(&shadow_caster_arena));
+
+    scene->shadow_frame_stats = {};
+
     int shadow_generators_count                 = 0;
     int shadow_generators_total_renderlist_size = 0;
 
@@ -1355,6 +1733,11 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
         u32 min_layers = shadow_map_counts_by_type[light_type] + 1;
         if (curr_layers >= min_layers) continue;
 
+        // previous shadow map contents are lost, and bindgroups that sample them
+        // must be rebuilt
+        ++scene->shadow_map_generation;
+        ++g_gpu_resource_epoch;
+
         WGPUTextureDescriptor shadowmap_desc = {};
         shadowmap_desc.usage
           = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding;
@@ -1430,6 +1813,80 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
             && light->desc.type != SG_LightType_Directional)
             continue; // others not impl
 
+        // cull shadow casters against the light frustum, and hash everything
+        // this light's shadow map depends on
+        glm::mat4 light_proj_view
+          = light->projection(false) * R_Transform::viewMatrix(light);
+        glm::vec4 frustum_planes[6];
+        _R_FrustumPlanes(light_proj_view, frustum_planes);
+
+        u64 signature = hashmap_xxhash3(&light_proj_view, sizeof(light_proj_view),
+                                        scene->shadow_map_generation, layer);
+        bool cacheable = true;
+        Arena::clear(&shadow_caster_arena);
+
+        WGPUTexture shadow_color_target = light->desc.type == SG_LightType_Spot ?
+                                            scene->spot_shadow_color_map_array :
+                                            scene->dir_shadow_color_map_array;
+        WGPUTexture shadow_depth_target = light->desc.type == SG_LightType_Spot ?
+                                            scene->spot_shadow_map_array :
+                                            scene->dir_shadow_map_array;
+
+        size_t shadowmap_renderlist_idx_DONT_USE = 0;
+        SG_ID* mesh_id                           = NULL;
+        // iterate over light's shadowcaster renderlist
+        while (hashmap_iter(light->shadow_render_id_set,
+                            &shadowmap_renderlist_idx_DONT_USE, (void**)&mesh_id)) {
+            R_Transform* mesh = Component_GetMesh(*mesh_id);
+            ASSERT(mesh->_stale == R_Transform_STALE_NONE);
+
+            // skip over the meshes that no longer belong to this scene
+            // ==optimize== remove these meshes from the ID set
+            bool mesh_belongs_to_scene = (mesh->scene_id == scene->id);
+            if (!mesh_belongs_to_scene) continue;
+
+            R_Material* material = Component_GetMaterial(mesh->_matID);
+            R_Geometry* geo      = Component_GetGeometry(mesh->_geoID);
+            R_Shader* shader
+              = material ? Component_GetShader(material->pso.sg_shader_id) : NULL;
+            if (!material || !geo || !shader) continue; // incomplete mesh
+
+            ++scene->shadow_frame_stats.casters;
+
+            // custom vertex shaders may move vertices anywhere, and change every
+            // frame. Never cull or cache them
+            if (shader->includes.static_vertices) {
+                if (_R_ShadowCasterCulled(frustum_planes, mesh, geo)) {
+                    ++scene->shadow_frame_stats.casters_culled;
+                    continue;
+                }
+                signature = _R_ShadowCasterHash(signature, mesh, material, geo,
+                                                &cacheable);
+                if (cacheable
+                    && !_R_ShadowCasterPipelineReady(&graph->cache, material,
+                                                     shadow_color_target,
+                                                     shadow_depth_target))
+                    cacheable = false;
+            } else {
+                cacheable = false;
+            }
+
+            *ARENA_PUSH_TYPE(&shadow_caster_arena, R_Transform*) = mesh;
+        }
+
+        // reuse last frame's layer if nothing it depends on has changed. The
+        // layer must have been written by this light in the previous update,
+        // otherwise another light may have drawn over it
+        bool reuse_layer = cacheable && light->shadow_signature == signature
+                           && light->shadow_signature_fc == scene->prev_fc_updated;
+        light->shadow_signature    = cacheable ? signature : 0;
+        light->shadow_signature_fc = scene->last_fc_updated;
+        if (reuse_layer) {
+            ++scene->shadow_frame_stats.layers_skipped;
+            continue;
+        }
+        ++scene->shadow_frame_stats.layers_rendered;
+
         // update frame uniform buffer
         light_frame_uniforms.projection = light->projection(false);
         light_frame_uniforms.view       = R_Transform::viewMatrix(light);
@@ -1447,9 +1904,11 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
                              &light_frame_uniforms, sizeof(light_frame_uniforms));
 
         // resize the per-draw storage buffer
-        size_t shadow_renderlist_count = hashmap_count(light->shadow_render_id_set);
-        int draw_uniform_size          = NEXT_MULT(sizeof(DrawUniforms),
-                                                   gctx->limits.minStorageBufferOffsetAlignment);
+        R_Transform** shadow_casters = (R_Transform**)shadow_caster_arena.base;
+        size_t shadow_renderlist_count
+          = ARENA_LENGTH(&shadow_caster_arena, R_Transform*);
+        int draw_uniform_size = NEXT_MULT(sizeof(DrawUniforms),
+                                          gctx->limits.minStorageBufferOffsetAlignment);
         if (light->draw_storage_buffer == NULL
             || wgpuBufferGetSize(light->draw_storage_buffer)
                  < shadow_renderlist_count * draw_uniform_size) {
@@ -1502,25 +1961,15 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
 
         G_DrawCallListID dc_list = graph->renderPassAddDrawCallList();
 
-        size_t shadowmap_renderlist_idx_DONT_USE = 0;
-        SG_ID* mesh_id                           = NULL;
-        int draw_uniform_idx                     = 0;
-        // iterate over light's shadowcaster renderlist
-        while (hashmap_iter(light->shadow_render_id_set,
-                            &shadowmap_renderlist_idx_DONT_USE, (void**)&mesh_id)) {
-            R_Transform* mesh = Component_GetMesh(*mesh_id);
-            ASSERT(mesh->_stale == R_Transform_STALE_NONE);
-
-            // skip over the meshes that no longer belong to this scene
-            // ==optimize== remove these meshes from the ID set
-            bool mesh_belongs_to_scene = (mesh->scene_id == scene->id);
-            if (!mesh_belongs_to_scene) continue;
+        int draw_uniform_idx = 0;
+        // iterate over the visible shadow casters
+        for (size_t i = 0; i < shadow_renderlist_count; i++) {
+            R_Transform* mesh = shadow_casters[i];
 
             // below is mostly copied from _R_RenderScene(...)
             R_Material* material = Component_GetMaterial(mesh->_matID);
             R_Geometry* geo      = Component_GetGeometry(mesh->_geoID);
             R_Shader* shader     = Component_GetShader(material->pso.sg_shader_id);
-            if (!material || !geo || !shader) continue; // incomplete mesh
 
             // add to draw call list
             G_DrawCall* d = graph->addDraw(dc_list);
@@ -1531,8 +1980,9 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
 
             { // set bindgroup state
                 // @group(0)
-                R_BindFrameUniforms(light->frame_uniform_buffer, gctx, d, graph, shader,
-                                    scene, true);
+                R_BindFrameUniforms(light->frame_uniform_buffer,
+                                    &light->frame_bg_slots, gctx, d, graph, shader,
+                                    scene, NULL, true);
 
                 // @group(1)
                 // ==optimize== only run fragment shader if alpha-test discard on
@@ -1609,6 +2059,65 @@ void R_Scene::rebuildLightInfoBuffer(GraphicsContext* gctx, R_Scene* scene,
     for (int i = 0; i < ARRAY_LENGTH(shadow_map_write_indices); ++i) {
         ASSERT(shadow_map_counts_by_type[i] == shadow_map_write_indices[i]);
     }
+
+    // update stats
+    R_ShadowStats* lifetime = &scene->shadow_lifetime_stats;
+    lifetime->casters += scene->shadow_frame_stats.casters;
+    lifetime->casters_culled += scene->shadow_frame_stats.casters_culled;
+    lifetime->layers_rendered += scene->shadow_frame_stats.layers_rendered;
+    lifetime->layers_skipped += scene->shadow_frame_stats.layers_skipped;
+}
+
+void R_Pass::updateLightClusters(R_Pass* pass, GraphicsContext* gctx, R_Scene* scene,
+                                 R_Camera* camera, glm::mat4 projection,
+                                 glm::vec4 viewport, FrameUniforms* frame_uniforms)
+{
+    static LightClusterGrid grid{}; // ~80KB, rebuilt per pass
+    static Arena light_cluster_arena{};
+    ASSERT(light_cluster_arena.curr == 0);
+    defer(Arena::clear(&light_cluster_arena));
+
+    LightCluster_BuildGrid(&grid, projection, camera->params.near_plane,
+                           camera->params.far_plane,
+                           camera->params.camera_type == SG_CameraType_PERPSECTIVE);
+
+    // view-space bounding spheres, in the same order as the LightUniforms array
+    // built by R_Scene::rebuildLightInfoBuffer() so indices match
+    int num_lights = R_Scene::numLights(scene);
+    LightClusterSphere* spheres
+      = ARENA_PUSH_COUNT(&light_cluster_arena, LightClusterSphere, num_lights);
+    glm::mat4 view = R_Camera::viewMatrix(camera);
+
+    size_t hashmap_idx_DONT_USE = 0;
+    SG_ID* light_id             = NULL;
+    int light_idx               = 0;
+    while (
+      hashmap_iter(scene->light_id_set, &hashmap_idx_DONT_USE, (void**)&light_id)) {
+        R_Light* light             = Component_GetLight(*light_id);
+        LightClusterSphere* sphere = &spheres[light_idx++];
+        sphere->center             = glm::vec3(view * light->world[3]);
+
+        switch (light->desc.type) {
+            case SG_LightType_Directional: sphere->radius = -1.0f; break;
+            case SG_LightType_Point:
+            case SG_LightType_Spot: sphere->radius = MAX(light->desc.radius, 0.0f); break;
+            default: sphere->radius = 0.0f; // contributes nothing
+        }
+    }
+
+    // cluster lists go after the spheres in the arena
+    u64 cluster_offset = light_cluster_arena.curr;
+    int cluster_count
+      = LightCluster_Bin(&grid, spheres, num_lights, &light_cluster_arena);
+
+    GPU_Buffer::write(gctx, &pass->light_cluster_buffer, WGPUBufferUsage_Storage,
+                      Arena::get(&light_cluster_arena, cluster_offset),
+                      cluster_count * sizeof(u32));
+
+    frame_uniforms->cluster_viewport    = viewport;
+    frame_uniforms->cluster_z_near      = grid.z_near;
+    frame_uniforms->cluster_slice_scale = LightCluster_SliceScale(&grid);
+    frame_uniforms->cluster_log_slicing = grid.log_slicing ? 1 : 0;
 }
 
 void R_Scene::registerMesh(R_Scene* scene, R_Transform* mesh)
@@ -1691,8 +2200,7 @@ void R_Scene::initFromSG(GraphicsContext* gctx, R_Scene* r_scene, SG_ID scene_id
     GPU_Buffer::init(gctx, &r_scene->light_info_buffer, WGPUBufferUsage_Storage,
                      sizeof(LightUniforms) * 16);
 
-    // initialize children array for 8 children
-    Arena::init(&r_scene->children, sizeof(SG_ID) * 8);
+    r_scene->scene_id = scene_id; // a scene always belongs to itself
 }
 
 // ============================================================================
@@ -1713,10 +2221,14 @@ static Arena textArena;
 static Arena lightArena;
 static Arena videoArena;
 static Arena webcamArena;
+static Arena audioTapArena;
 
 // maps from id --> offset
 static hashmap* r_locator = NULL;
 
+// components freed in chuck, destroyed within a per-frame budget
+static DestroyQueue _r_destroy_queue;
+
 // fonts
 // each font is 600bytes, 128 fonts is 76.8KB
 static R_Font component_fonts[128];
@@ -1784,12 +2296,31 @@ void Component_Init(GraphicsContext* gctx)
     Arena::init(&lightArena, sizeof(R_Light) * 16);
     Arena::init(&videoArena, sizeof(R_Video) * 16);
     Arena::init(&webcamArena, sizeof(R_Webcam) * 8);
+    Arena::init(&audioTapArena, sizeof(R_AudioTap) * 8);
+
+    G_UniformPool::init(&material_uniform_pool, &gctx->limits,
+                        sizeof(SG_MaterialUniformData));
 
     // init locator
     int seed = time(NULL);
     srand(seed);
     r_locator = hashmap_new(sizeof(R_Location), 0, seed, seed, R_HashLocation,
                             R_CompareLocation, NULL, NULL);
+
+    DestroyQueue_Init(&_r_destroy_queue, true);
+
+#ifdef __EMSCRIPTEN__
+    int stream_workers = 0; // decoded on submit
+#else
+    int stream_workers = CHUGL_TEXTURE_STREAM_THREADS;
+#endif
+    _r_texture_compression = gctx->texture_compression;
+    TextureStream_Init(&_r_texture_stream, stream_workers, R_Texture_StreamDecode,
+                       R_Texture_StreamFreePixels);
+    _r_texture_placeholders.texture_2d
+      = R_Texture_CreatePlaceholder(gctx, 1, "Loading Texture Placeholder");
+    _r_texture_placeholders.cubemap
+      = R_Texture_CreatePlaceholder(gctx, 6, "Loading Cubemap Placeholder");
 }
 
 void Component_Free()
@@ -1808,10 +2339,18 @@ void Component_Free()
     Arena::free(&passArena);
     // Arena::free(&bufferArena);
 
+    G_UniformPool::release(&material_uniform_pool);
+
     // free locator
     hashmap_free(r_locator);
     r_locator = NULL;
 
+    DestroyQueue_Free(&_r_destroy_queue);
+
+    TextureStream_Free(&_r_texture_stream);
+    WGPU_RELEASE_RESOURCE(Texture, _r_texture_placeholders.texture_2d);
+    WGPU_RELEASE_RESOURCE(Texture, _r_texture_placeholders.cubemap);
+
     // free webcam (doesn't crash)
     for (int i = 0; i < ARRAY_LENGTH(_r_webcam_data); i++) {
         if (_r_webcam_data[i].webcam) {
@@ -1862,9 +2401,17 @@ static void _Component_FreeComponent(SG_ID id, int component_size)
 
 // component garbage collection
 void Component_FreeComponent(SG_ID id)
+{
+    if (!Component_GetComponent(id)) return; // already freed
+
+    // tombstoned until destroyed, pushing again is a no-op
+    DestroyQueue_Push(&_r_destroy_queue, id, 0);
+}
+
+static void _Component_Destroy(u32 id, void* udata)
 {
     R_Component* comp = Component_GetComponent(id);
-    if (!comp) return; // already freed
+    if (!comp) return;
 
     switch (comp->type) {
         case SG_COMPONENT_SHADER: {
@@ -1872,12 +2419,154 @@ void Component_FreeComponent(SG_ID id)
             R_Shader::free((R_Shader*)comp);
             _Component_FreeComponent(id, sizeof(R_Shader));
         } break;
+        case SG_COMPONENT_AUDIO_TAP: {
+            // handed over by SG_ComponentFree, the audio thread no longer ticks it
+            R_AudioTap* tap = (R_AudioTap*)comp;
+            FREE_TYPE(SG_AudioTapRing, tap->ring);
+            _Component_FreeComponent(id, sizeof(R_AudioTap));
+        } break;
         default: {
             // other types not yet supported
         }
     }
 }
 
+static f64 _Component_ClockMs(void* udata)
+{
+    return stm_ms(stm_now());
+}
+
+int Component_ProcessDestroyQueue(f64 budget_ms)
+{
+    DestroyQueueBudget budget = { budget_ms, 0 };
+    DestroyQueue_Process(&_r_destroy_queue, budget, _Component_Destroy, NULL,
+                         _Component_ClockMs, NULL);
+    return DestroyQueue_Depth(&_r_destroy_queue);
+}
+
+// a KTX2 file decides the format and mip chain of its texture, which is recreated
+// to match before the first rows are uploaded
+static void _Component_TextureStreamMatchJob(GraphicsContext* gctx, R_Texture* texture,
+                                             TextureStreamJob* job)
+{
+    WGPUTextureFormat format = (WGPUTextureFormat)job->format;
+    if (format == WGPUTextureFormat_Undefined) return; // stb_image, RGBA8 as created
+
+    // the file's own mip chain is uploaded as is. Mips can't be generated for a
+    // compressed format, the GPU can't render to it
+    bool compressed = G_isCompressedFormat(format);
+    bool gen_mips   = texture->stream_gen_mips && (job->level_count > 1 || !compressed);
+    if (job->level_count > 1 || compressed) texture->stream_gen_mips = false;
+
+    WGPUTextureUsageFlags usage = texture->desc.usage;
+    if (compressed) {
+        usage &= WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst
+                 | WGPUTextureUsage_CopySrc;
+    }
+    // not allowed on srgb textures, see ulib_texture_load
+    if (format == WGPUTextureFormat_RGBA8UnormSrgb) {
+        usage &= ~WGPUTextureUsage_StorageBinding;
+    }
+
+    if (format != texture->desc.format || gen_mips != texture->desc.gen_mips
+        || usage != texture->desc.usage) {
+        texture->desc.format   = format;
+        texture->desc.gen_mips = gen_mips;
+        texture->desc.usage    = usage;
+        WGPU_RELEASE_RESOURCE(Texture, texture->gpu_texture);
+        R_Texture::resize(texture, texture->desc.width, texture->desc.height,
+                          gctx->device);
+    }
+
+    u32 mips        = wgpuTextureGetMipLevelCount(texture->gpu_texture);
+    u64 gpu_bytes   = TextureTranscode_ChainBytes(G_textureBlockFormat(format),
+                                                  job->width, job->height, mips);
+    u64 rgba8_bytes = TextureTranscode_ChainBytes(TextureBlockFormat_RGBA8, job->width,
+                                                  job->height, mips);
+    log_info("Texture[%d|%s] %dx%d %s: %.2f MB on the GPU, %.2f MB as RGBA8 (%.0f%% "
+             "saved)",
+             texture->id, texture->name, job->width, job->height,
+             G_Util::textureFormatToString(format), gpu_bytes / (1024.0 * 1024.0),
+             rgba8_bytes / (1024.0 * 1024.0),
+             100.0 * (1.0 - (double)gpu_bytes / rgba8_bytes));
+}
+
+static void _Component_TextureStreamUpload(TextureStreamJob* job, int row,
+                                           int row_count, void* udata)
+{
+    GraphicsContext* gctx = (GraphicsContext*)udata;
+    R_Texture* texture    = Component_GetTexture(job->id);
+    // freed while loading, or the image changed size since chuck read its header
+    if (!texture || job->width != texture->desc.width
+        || job->height != texture->desc.height)
+        return;
+
+    if (job->level == 0 && row == 0) {
+        _Component_TextureStreamMatchJob(gctx, texture, job);
+    }
+    // e.g. a file's mip chain when the texture wasn't asked to have mips
+    if (job->level >= (int)wgpuTextureGetMipLevelCount(texture->gpu_texture)) return;
+
+    // rows of a compressed format are rows of blocks, written whole even where they
+    // hang over the edge of a small mip
+    TextureStreamLevel* level = &job->levels[job->level];
+    const TextureBlockInfo* block
+      = TextureTranscode_Info(G_textureBlockFormat(texture->desc.format));
+    u32 block_w = block->block_width, block_h = block->block_height;
+
+    SG_TextureWriteDesc write_desc = {};
+    write_desc.offset_y            = row * block_h;
+    write_desc.offset_z            = job->layer;
+    write_desc.mip                 = job->level;
+    write_desc.width               = (level->width + block_w - 1) / block_w * block_w;
+    write_desc.height              = row_count * block_h;
+    R_Texture::write(gctx, texture, &write_desc,
+                     job->pixels + level->offset + (size_t)row * level->bytes_per_row,
+                     (size_t)row_count * level->bytes_per_row);
+}
+
+static void _Component_TextureStreamDone(TextureStreamJob* job, void* udata)
+{
+    GraphicsContext* gctx = (GraphicsContext*)udata;
+    R_Texture* texture    = Component_GetTexture(job->id);
+    if (!texture) return;
+
+    bool size_ok = job->width == texture->desc.width
+                   && job->height == texture->desc.height;
+    if (!job->ok || !size_ok) {
+        log_warn("could not load texture[%d|%s] layer %d", texture->id, texture->name,
+                 job->layer);
+        if (!job->ok) {
+            log_warn(" |- Reason: %s", job->error ? job->error : "unknown");
+        } else {
+            log_warn(" |- Reason: decoded %dx%d, expected %dx%d", job->width,
+                     job->height, texture->desc.width, texture->desc.height);
+        }
+        texture->stream_failed = true;
+    }
+
+    ASSERT(texture->stream_pending > 0);
+    if (--texture->stream_pending > 0) return;
+
+    bool ok = !texture->stream_failed;
+    if (ok && texture->stream_gen_mips) {
+        MipMapGenerator_generate(gctx, texture->gpu_texture, texture->name);
+    }
+    texture->stream_failed = false;
+    ++g_gpu_resource_epoch; // swap the placeholder for the texture
+
+    CQ_PushCommand_G2A_TextureLoaded(texture->id, ok, texture->desc.format,
+                                     texture->desc.gen_mips);
+}
+
+int Component_UploadStreamedTextures(GraphicsContext* gctx, u64 budget_bytes)
+{
+    TextureStream_Upload(&_r_texture_stream, budget_bytes,
+                         _Component_TextureStreamUpload, _Component_TextureStreamDone,
+                         gctx);
+    return TextureStream_Pending(&_r_texture_stream);
+}
+
 R_Transform* Component_CreateTransform()
 {
     R_Transform* xform = ARENA_PUSH_ZERO_TYPE(&xformArena, R_Transform);
@@ -2110,23 +2799,8 @@ R_Material* Component_CreateMaterial(GraphicsContext* gctx,
         mat->id   = cmd->sg_id;
         mat->type = SG_COMPONENT_MATERIAL;
 
-        const int UNIFORM_OFFSET = MAX(gctx->limits.minUniformBufferOffsetAlignment,
-                                       sizeof(SG_MaterialUniformData));
-
-        // init CPU-side batch uniform buffer
-        mat->_cpu_uniform_buffer_MALLOC
-          = calloc(UNIFORM_OFFSET, ARRAY_LENGTH(mat->bindings));
-
-        // init uniform buffer
-        char label[128] = {};
-        snprintf(label, sizeof(label), "UniformBuffer for Material[%d:%s]", mat->id,
-                 mat->name);
-
-        WGPUBufferDescriptor desc = {};
-        desc.size                 = UNIFORM_OFFSET * ARRAY_LENGTH(mat->bindings);
-        desc.usage                = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-        mat->_uniform_buffer      = wgpuDeviceCreateBuffer(gctx->device, &desc);
-
+        // uniform storage is allocated from material_uniform_pool on first
+        // setBinding()
         mat->pso = cmd->pso;
     }
 
@@ -2484,6 +3158,136 @@ R_Webcam* Component_CreateWebcam(SG_Command_WebcamCreate* cmd)
     return webcam;
 }
 
+// =============================================================================
+// R_AudioTap
+// =============================================================================
+
+// in-place iterative radix-2 FFT. n must be a power of 2
+static void _R_AudioTap_FFT(f32* re, f32* im, int n)
+{
+    // bit reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            f32 tmp = re[i];
+            re[i]   = re[j];
+            re[j]   = tmp;
+            tmp     = im[i];
+            im[i]   = im[j];
+            im[j]   = tmp;
+        }
+    }
+
+    // butterflies
+    for (int len = 2; len <= n; len <<= 1) {
+        f32 angle = -PI2 / len;
+        f32 w_re  = cosf(angle);
+        f32 w_im  = sinf(angle);
+        for (int i = 0; i < n; i += len) {
+            f32 cur_re = 1.0f, cur_im = 0.0f;
+            for (int k = 0; k < len / 2; k++) {
+                int a = i + k, b = i + k + len / 2;
+                f32 t_re = re[b] * cur_re - im[b] * cur_im;
+                f32 t_im = re[b] * cur_im + im[b] * cur_re;
+                re[b]    = re[a] - t_re;
+                im[b]    = im[a] - t_im;
+                re[a] += t_re;
+                im[a] += t_im;
+
+                f32 next_re = cur_re * w_re - cur_im * w_im;
+                cur_im      = cur_re * w_im + cur_im * w_re;
+                cur_re      = next_re;
+            }
+        }
+    }
+}
+
+void R_AudioTap::upload(GraphicsContext* gctx, R_AudioTap* tap)
+{
+    if (!tap->texture_id && !tap->buffer_id) return;
+
+    // scratch space, graphics thread only
+    static f32 re[SG_AUDIO_TAP_MAX_WINDOW];
+    static f32 im[SG_AUDIO_TAP_MAX_WINDOW];
+
+    // no new audio since last frame (e.g. tap disconnected from dac)
+    if (tap->ring->write_head.load(std::memory_order_acquire) == tap->last_write_head)
+        return;
+    tap->last_write_head = tap->ring->latest(re, tap->window);
+
+    int value_count = tap->window;
+    if (tap->mode == SG_AudioTap_Mode_Spectrum) {
+        // hann window
+        for (int i = 0; i < tap->window; i++) {
+            re[i] *= .5f * (1.0f - cosf(PI2 * i / (tap->window - 1)));
+            im[i] = 0;
+        }
+        _R_AudioTap_FFT(re, im, tap->window);
+
+        // magnitudes, normalized so a full-scale sinusoid peaks near 1.0
+        // (2/N for the one-sided spectrum, 2x again for the hann window gain)
+        value_count   = tap->window / 2;
+        f32 normalize = 4.0f / tap->window;
+        for (int i = 0; i < value_count; i++) {
+            re[i] = sqrtf(re[i] * re[i] + im[i] * im[i]) * normalize;
+        }
+    }
+
+    R_Texture* texture = Component_GetTexture(tap->texture_id);
+    if (texture && texture->desc.format == WGPUTextureFormat_R32Float
+        && texture->desc.width >= value_count) {
+        SG_TextureWriteDesc write_desc = {};
+        write_desc.width               = value_count;
+        write_desc.height              = 1;
+        write_desc.depth               = 1;
+        R_Texture::write(gctx, texture, &write_desc, re, value_count * sizeof(f32));
+    }
+
+    R_Buffer* buffer = Component_GetBuffer(tap->buffer_id);
+    if (buffer) {
+        GPU_Buffer::write(gctx, &buffer->gpu_buffer,
+                          GPU_Buffer::usage(buffer->gpu_buffer), 0, re,
+                          value_count * sizeof(f32));
+    }
+}
+
+void R_AudioTap::update(SG_Command_AudioTapUpdate* cmd)
+{
+    R_AudioTap* tap = Component_GetAudioTap(cmd->tap_id);
+    if (!tap) tap = Component_CreateAudioTap(cmd);
+
+    ASSERT(tap->ring == cmd->ring);
+    tap->window     = cmd->window;
+    tap->mode       = cmd->mode;
+    tap->texture_id = cmd->texture_id;
+    tap->buffer_id  = cmd->buffer_id;
+
+    // force re-upload with new settings
+    tap->last_write_head = 0;
+}
+
+R_AudioTap* Component_CreateAudioTap(SG_Command_AudioTapUpdate* cmd)
+{
+    Arena* arena    = &audioTapArena;
+    R_AudioTap* tap = ARENA_PUSH_TYPE(arena, R_AudioTap);
+    *tap            = {};
+
+    // component init
+    tap->id   = cmd->tap_id;
+    tap->type = SG_COMPONENT_AUDIO_TAP;
+    tap->ring = cmd->ring;
+
+    // store offset
+    R_Location loc     = { tap->id, Arena::offsetOf(arena, tap), arena };
+    const void* result = hashmap_set(r_locator, &loc);
+    ASSERT(result == NULL); // ensure id is unique
+    UNUSED_VAR(result);
+
+    return tap;
+}
+
 // linear search by font path, lazily creates if not found
 R_Font* Component_GetFont(GraphicsContext* gctx, FT_Library library,
                           const char* font_path)
@@ -2616,6 +3420,13 @@ R_Video* Component_GetVideo(SG_ID id)
     return (R_Video*)comp;
 }
 
+R_AudioTap* Component_GetAudioTap(SG_ID id)
+{
+    R_Component* comp = Component_GetComponent(id);
+    ASSERT(comp == NULL || comp->type == SG_COMPONENT_AUDIO_TAP);
+    return (R_AudioTap*)comp;
+}
+
 R_Webcam* Component_GetWebcam(SG_ID id)
 {
     R_Component* comp = Component_GetComponent(id);
@@ -2635,6 +3446,18 @@ bool Component_MaterialIter(size_t* i, R_Material** material)
     return true;
 }
 
+bool Component_SceneIter(size_t* i, R_Scene** scene)
+{
+    if (*i >= ARENA_LENGTH(&sceneArena, R_Scene)) {
+        *scene = NULL;
+        return false;
+    }
+
+    *scene = ARENA_GET_TYPE(&sceneArena, R_Scene, *i);
+    ++(*i);
+    return true;
+}
+
 bool Component_VideoIter(size_t* i, R_Video** video)
 {
     if (*i >= ARENA_LENGTH(&videoArena, R_Video)) {
@@ -2647,6 +3470,18 @@ bool Component_VideoIter(size_t* i, R_Video** video)
     return true;
 }
 
+bool Component_AudioTapIter(size_t* i, R_AudioTap** tap)
+{
+    if (*i >= ARENA_LENGTH(&audioTapArena, R_AudioTap)) {
+        *tap = NULL;
+        return false;
+    }
+
+    *tap = ARENA_GET_TYPE(&audioTapArena, R_AudioTap, *i);
+    ++(*i);
+    return true;
+}
+
 bool Component_WebcamIter(size_t* i, R_Webcam** webcam)
 {
     if (*i >= ARENA_LENGTH(&webcamArena, R_Webcam)) {
@@ -2663,6 +3498,140 @@ bool Component_WebcamIter(size_t* i, R_Webcam** webcam)
 // R_Shader
 // =============================================================================
 
+// reflects one entry point of the (not yet preprocessed) shader module source
+static void R_Shader_reflect(R_Shader* shader, const char* code, ShaderStage stage,
+                             const char* entry_point)
+{
+    std::string source = Shaders_genSource(code);
+    ShaderReflect_AddEntryPoint(&shader->reflection, source.c_str(), stage,
+                                entry_point);
+}
+
+static ShaderScalar R_Shader_vertexFormatScalar(WGPUVertexFormat format)
+{
+    switch (format) {
+        case WGPUVertexFormat_Uint8x2:
+        case WGPUVertexFormat_Uint8x4:
+        case WGPUVertexFormat_Uint16x2:
+        case WGPUVertexFormat_Uint16x4:
+        case WGPUVertexFormat_Uint32:
+        case WGPUVertexFormat_Uint32x2:
+        case WGPUVertexFormat_Uint32x3:
+        case WGPUVertexFormat_Uint32x4: return SHADER_SCALAR_U32;
+        case WGPUVertexFormat_Sint8x2:
+        case WGPUVertexFormat_Sint8x4:
+        case WGPUVertexFormat_Sint16x2:
+        case WGPUVertexFormat_Sint16x4:
+        case WGPUVertexFormat_Sint32:
+        case WGPUVertexFormat_Sint32x2:
+        case WGPUVertexFormat_Sint32x3:
+        case WGPUVertexFormat_Sint32x4: return SHADER_SCALAR_I32;
+        case WGPUVertexFormat_Undefined: return SHADER_SCALAR_NONE;
+        default: return SHADER_SCALAR_F32; // float, unorm, snorm
+    }
+}
+
+// checks the reflected vertex inputs and workgroup size against what the pipeline
+// will be created with, so mismatches are reported with names instead of as a
+// pipeline validation error
+static void R_Shader_validate(GraphicsContext* gctx, R_Shader* shader)
+{
+    ShaderReflection* refl = &shader->reflection;
+    if (!refl->ok) {
+        log_debug("Shader[%d] not reflected (%s), using layout: auto", shader->id,
+                  refl->error);
+        return;
+    }
+
+    for (int i = 0; i < refl->vertex_input_count; i++) {
+        ShaderVertexInput* input = refl->vertex_inputs + i;
+        WGPUVertexFormat format  = input->location < R_GEOMETRY_MAX_VERTEX_ATTRIBUTES ?
+                                     shader->vertex_layout[input->location] :
+                                     WGPUVertexFormat_Undefined;
+        ShaderScalar format_scalar = R_Shader_vertexFormatScalar(format);
+        ShaderScalar input_scalar  = input->type.scalar == SHADER_SCALAR_F16 ?
+                                       SHADER_SCALAR_F32 :
+                                       input->type.scalar;
+        if (format == WGPUVertexFormat_Undefined) {
+            log_warn(
+              "Shader[%d] vertex input \"%s\" @location(%d) has no vertex layout",
+              shader->id, input->name, input->location);
+        } else if (format_scalar != input_scalar) {
+            char type_name[16] = {};
+            ShaderReflect_ValueTypeName(input->type, type_name, sizeof(type_name));
+            log_warn(
+              "Shader[%d] vertex input \"%s\" @location(%d) is %s but its vertex "
+              "layout is %s",
+              shader->id, input->name, input->location, type_name,
+              format_scalar == SHADER_SCALAR_F32 ? "float" :
+              format_scalar == SHADER_SCALAR_I32 ? "int" :
+                                                   "uint");
+        }
+    }
+
+    if (refl->stages & SHADER_STAGE_COMPUTE) {
+        u32* size          = refl->workgroup_size;
+        WGPULimits* limits = &gctx->limits;
+        u32 invocations    = size[0] * size[1] * size[2];
+        if (size[0] > limits->maxComputeWorkgroupSizeX
+            || size[1] > limits->maxComputeWorkgroupSizeY
+            || size[2] > limits->maxComputeWorkgroupSizeZ
+            || invocations > limits->maxComputeInvocationsPerWorkgroup) {
+            log_warn(
+              "Compute Shader[%d] @workgroup_size(%d, %d, %d) exceeds device limits",
+              shader->id, size[0], size[1], size[2]);
+        }
+    }
+}
+
+static int R_Shader_vertexFormatFloatComponents(WGPUVertexFormat format)
+{
+    switch (format) {
+        case WGPUVertexFormat_Float32: return 1;
+        case WGPUVertexFormat_Float32x2: return 2;
+        case WGPUVertexFormat_Float32x3: return 3;
+        case WGPUVertexFormat_Float32x4: return 4;
+        default: return 0;
+    }
+}
+
+bool R_Shader::validateGeometry(R_Shader* shader, R_Geometry* geo, bool log)
+{
+    ShaderReflection* refl = &shader->reflection;
+    if (!refl->ok) return true;
+
+    bool ok = true;
+    for (int i = 0; i < refl->vertex_input_count; i++) {
+        ShaderVertexInput* input = refl->vertex_inputs + i;
+        u32 loc                  = input->location;
+        if (loc >= R_GEOMETRY_MAX_VERTEX_ATTRIBUTES) continue;
+
+        if (geo->gpu_vertex_buffers[loc].buf == NULL
+            || geo->gpu_vertex_buffers[loc].size == 0) {
+            if (log)
+                log_warn("Geometry[%d:%s] has no vertex attribute %d, but Shader[%d] "
+                         "reads \"%s\" from @location(%d)",
+                         geo->id, geo->name, loc, shader->id, input->name, loc);
+            ok = false;
+            continue;
+        }
+
+        // geometry attributes are always f32, so the stride comes from the layout
+        int layout_components
+          = R_Shader_vertexFormatFloatComponents(shader->vertex_layout[loc]);
+        int geo_components = geo->vertex_attribute_num_components[loc];
+        if (layout_components && layout_components != geo_components) {
+            if (log)
+                log_warn("Geometry[%d:%s] vertex attribute %d has %d components, but "
+                         "Shader[%d] vertex layout expects %d for \"%s\"",
+                         geo->id, geo->name, loc, geo_components, shader->id,
+                         layout_components, input->name);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_string,
                     const char* vertex_filepath, const char* fragment_string,
                     const char* fragment_filepath, WGPUVertexFormat* vertex_layout,
@@ -2670,6 +3639,7 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
                     const char* compute_filepath, SG_ShaderIncludes* includes)
 {
     shader->includes = *includes;
+    ShaderReflect_Init(&shader->reflection);
 
     char vertex_shader_label[32] = {};
     snprintf(vertex_shader_label, sizeof(vertex_shader_label), "vertex shader %d",
@@ -2681,12 +3651,15 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (vertex_string && strlen(vertex_string) > 0) {
         shader->vertex_shader_module
           = G_createShaderModule(gctx, vertex_string, vertex_shader_label);
+        R_Shader_reflect(shader, vertex_string, SHADER_STAGE_VERTEX, VS_ENTRY_POINT);
     } else if (vertex_filepath && strlen(vertex_filepath) > 0) {
         // read entire file contents
         FileReadResult vertex_file = File_read(vertex_filepath, true);
         if (vertex_file.data_owned) {
             shader->vertex_shader_module = G_createShaderModule(
               gctx, (const char*)vertex_file.data_owned, vertex_shader_label);
+            R_Shader_reflect(shader, (const char*)vertex_file.data_owned,
+                             SHADER_STAGE_VERTEX, VS_ENTRY_POINT);
             FREE(vertex_file.data_owned);
         } else {
             log_error("failed to read vertex shader file %s", vertex_filepath);
@@ -2696,12 +3669,16 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (fragment_string && strlen(fragment_string) > 0) {
         shader->fragment_shader_module
           = G_createShaderModule(gctx, fragment_string, fragment_shader_label);
+        R_Shader_reflect(shader, fragment_string, SHADER_STAGE_FRAGMENT,
+                         FS_ENTRY_POINT);
     } else if (fragment_filepath && strlen(fragment_filepath) > 0) {
         // read entire file contents
         FileReadResult fragment_file = File_read(fragment_filepath, true);
         if (fragment_file.data_owned) {
             shader->fragment_shader_module = G_createShaderModule(
               gctx, (const char*)fragment_file.data_owned, fragment_shader_label);
+            R_Shader_reflect(shader, (const char*)fragment_file.data_owned,
+                             SHADER_STAGE_FRAGMENT, FS_ENTRY_POINT);
             FREE(fragment_file.data_owned);
         } else {
             log_error("failed to read fragment shader file %s", fragment_filepath);
@@ -2720,17 +3697,23 @@ void R_Shader::init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_
     if (compute_string && strlen(compute_string) > 0) {
         shader->compute_shader_module
           = G_createShaderModule(gctx, compute_string, compute_shader_label);
+        R_Shader_reflect(shader, compute_string, SHADER_STAGE_COMPUTE,
+                         CHUGL_COMPUTE_ENTRY_POINT);
     } else if (compute_filepath && strlen(compute_filepath) > 0) {
         // read entire file contents
         FileReadResult compute_file = File_read(compute_filepath, true);
         if (compute_file.data_owned) {
             shader->compute_shader_module = G_createShaderModule(
               gctx, (const char*)compute_file.data_owned, compute_shader_label);
+            R_Shader_reflect(shader, (const char*)compute_file.data_owned,
+                             SHADER_STAGE_COMPUTE, CHUGL_COMPUTE_ENTRY_POINT);
             FREE(compute_file.data_owned);
         } else {
             log_error("failed to read compute shader file %s", compute_filepath);
         }
     }
+
+    R_Shader_validate(gctx, shader);
 }
 
 void R_Shader::free(R_Shader* shader)
@@ -2740,6 +3723,108 @@ void R_Shader::free(R_Shader* shader)
     WGPU_RELEASE_RESOURCE(ShaderModule, shader->compute_shader_module);
 }
 
+// =============================================================================
+// G_PipelineCompiler
+// =============================================================================
+
+static struct {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    WGPUDevice device;
+    bool quit;
+
+    G_PipelineJob* queue_head; // FIFO, submitted jobs
+    G_PipelineJob* queue_tail;
+    G_PipelineJob* completed; // finished jobs, not yet taken by the render thread
+} pipeline_compiler;
+
+static void G_PipelineCompiler_Run()
+{
+    while (true) {
+        G_PipelineJob* job = NULL;
+        {
+            std::unique_lock<std::mutex> lock(pipeline_compiler.mutex);
+            pipeline_compiler.cv.wait(lock, [] {
+                return pipeline_compiler.quit || pipeline_compiler.queue_head;
+            });
+            if (pipeline_compiler.quit) return;
+
+            job                          = pipeline_compiler.queue_head;
+            pipeline_compiler.queue_head = job->next;
+            if (!pipeline_compiler.queue_head) pipeline_compiler.queue_tail = NULL;
+        }
+
+        u64 start = stm_now();
+        job->pipeline
+          = wgpuDeviceCreateRenderPipeline(pipeline_compiler.device, &job->desc);
+        log_debug("%s compiled in %.2fms", job->label, stm_ms(stm_since(start)));
+
+        std::lock_guard<std::mutex> lock(pipeline_compiler.mutex);
+        job->next                   = pipeline_compiler.completed;
+        pipeline_compiler.completed = job;
+    }
+}
+
+void G_PipelineCompiler_Submit(WGPUDevice device, G_PipelineJob* job)
+{
+    job->next = NULL;
+    {
+        std::lock_guard<std::mutex> lock(pipeline_compiler.mutex);
+        if (!pipeline_compiler.thread.joinable()) {
+            pipeline_compiler.device = device;
+            pipeline_compiler.quit   = false;
+            pipeline_compiler.thread = std::thread(G_PipelineCompiler_Run);
+        }
+        ASSERT(pipeline_compiler.device == device);
+
+        if (pipeline_compiler.queue_tail) {
+            pipeline_compiler.queue_tail->next = job;
+        } else {
+            pipeline_compiler.queue_head = job;
+        }
+        pipeline_compiler.queue_tail = job;
+    }
+    pipeline_compiler.cv.notify_one();
+}
+
+G_PipelineJob* G_PipelineCompiler_Completed()
+{
+    std::lock_guard<std::mutex> lock(pipeline_compiler.mutex);
+    G_PipelineJob* completed    = pipeline_compiler.completed;
+    pipeline_compiler.completed = NULL;
+    return completed;
+}
+
+void G_PipelineCompiler_Shutdown()
+{
+    if (!pipeline_compiler.thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(pipeline_compiler.mutex);
+        pipeline_compiler.quit = true;
+    }
+    pipeline_compiler.cv.notify_one();
+    pipeline_compiler.thread.join(); // waits for the job being compiled, if any
+
+    // the render thread is done with these, release both lists
+    G_PipelineJob* lists[] = { pipeline_compiler.queue_head,
+                               pipeline_compiler.completed };
+    for (int i = 0; i < ARRAY_LENGTH(lists); i++) {
+        G_PipelineJob* job = lists[i];
+        while (job) {
+            WGPU_RELEASE_RESOURCE(RenderPipeline, job->pipeline);
+            WGPU_RELEASE_RESOURCE(ShaderModule, job->desc.vertex.module);
+            WGPU_RELEASE_RESOURCE(ShaderModule, job->fragment.module);
+            G_PipelineJob* next = job->next;
+            FREE_TYPE(G_PipelineJob, job);
+            job = next;
+        }
+    }
+    pipeline_compiler.queue_head = NULL;
+    pipeline_compiler.queue_tail = NULL;
+    pipeline_compiler.completed  = NULL;
+}
+
 // =============================================================================
 // R_Font
 // =============================================================================
@@ -3435,7 +4520,7 @@ void R_Font::updateText(GraphicsContext* gctx, R_Font* font, R_Text* text)
     R_Geometry::setVertexAttribute(gctx, geo, 1, 2, uvs.base, uvs.curr);
     R_Geometry::setVertexAttribute(gctx, geo, 2, 1, glyph_indices.base,
                                    glyph_indices.curr);
-    R_Geometry::setIndices(gctx, geo, (u32*)indices.base, ARENA_LENGTH(&indices, u32));
+    R_Geometry::setIndices(gctx, geo, SG_GeometryBlock::fromArena(&indices));
 
     // set internal uniforms
     // recompute bb adjusted by control points
@@ -3481,9 +4566,11 @@ void R_Font::prepareGlyphsForText(GraphicsContext* gctx, R_Font* font, const cha
     }
 }
 
-void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
-                         G_DrawCall* d, G_Graph* graph, R_Shader* shader,
-                         R_Scene* scene, bool is_shadow_pass)
+void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer,
+                         G_BindGroupSlots* frame_bg_slots, GraphicsContext* gctx,
+                         G_DrawCall* d, G_DrawRecorder* graph, R_Shader* shader,
+                         R_Scene* scene, GPU_Buffer* light_cluster_buffer,
+                         bool is_shadow_pass)
 {
     // group(0) must be bound if group(1) is (no holes in bindgroups allowed)
     // so for now we always bind the per-frame uniforms
@@ -3492,15 +4579,28 @@ void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
 
     if (scene) {
         if (shader->includes.lit)
-            graph->bindBuffer(d, PER_FRAME_GROUP, 1, scene->light_info_buffer.buf, 0,
-                              MAX(scene->light_info_buffer.size, 1));
+            graph->bindBuffer(
+              d, PER_FRAME_GROUP, 1, scene->light_info_buffer.buf, 0,
+              MAX(GPU_Buffer::capacity(scene->light_info_buffer), 1));
+
+        if (shader->includes.clustered_lights) {
+            // shadow passes have no cluster lists. num_lights is 0 there, so the
+            // shader never reads this binding and any storage buffer will do
+            GPU_Buffer* clusters
+              = light_cluster_buffer ? light_cluster_buffer : &scene->light_info_buffer;
+            graph->bindBuffer(d, PER_FRAME_GROUP, 6, clusters->buf, 0,
+                              MAX(GPU_Buffer::capacity(*clusters), 4));
+        }
 
         if (shader->includes.uses_env_map) {
             R_Texture* envmap = Component_GetTexture(scene->sg_scene_desc.env_map_id);
             ASSERT(envmap && envmap->gpu_texture)
+            WGPUTexture envmap_texture = envmap->stream_pending ?
+                                           _r_texture_placeholders.cubemap :
+                                           envmap->gpu_texture;
             graph->bindTexture(
               d, PER_FRAME_GROUP, 2,
-              { envmap->gpu_texture, WGPUTextureViewDimension_Cube, 0, 1, 0, 6 });
+              { envmap_texture, WGPUTextureViewDimension_Cube, 0, 1, 0, 6 });
         }
 
         if (shader->includes.shadows) {
@@ -3525,6 +4625,12 @@ void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
                 (int)wgpuTextureGetDepthOrArrayLayers(dir_shadow_map_array) });
         }
     }
+
+    // buffers above are bound at full capacity, so per-frame size changes (e.g.
+    // light count) don't invalidate the bindgroup; only switching scene or env map
+    // does. Recreated buffers and shadow maps bump g_gpu_resource_epoch
+    u64 version = scene ? ((u64)(u32)scene->id << 32) | scene->bindgroup_version : 0;
+    graph->persistentBindGroup(d, PER_FRAME_GROUP, frame_bg_slots, version);
 }
 
 void R_Light::shadowAddMesh(SG_ID* mesh_list, int mesh_count, bool add)
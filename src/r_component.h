@@ -28,9 +28,18 @@
 #pragma once
 
 #include "chugl_defines.h"
+#include "draw_jobs.h"
 #include "graphics.h"
+#include "instance_cull.h"
+#include "light_cluster.h"
+#include "mesh_lod.h"
+#include "profiler.h"
+#include "render_graph.h"
 #include "sg_command.h"
 #include "sg_component.h"
+#include "shader_reflect.h"
+#include "shaders.h"
+#include "texture_stream.h"
 
 #include "core/macros.h"
 #include "core/memory.h"
@@ -47,6 +56,82 @@
 
 #include <pl/pl_mpeg.h>
 
+// =============================================================================
+// Persistent bindgroups
+// =============================================================================
+
+/*
+Materials, passes and geometry own their bindgroups across frames, so steady-state
+draws bind them without hashing their entries through G_Cache::bindGroup().
+
+A slot is valid while
+- its layout matches the pipeline's. Auto layouts are per pipeline, so an owner
+  drawn with several pipelines keeps one slot per layout
+- its version matches the owner's, which the owner bumps whenever the entries it
+  binds change
+- its epoch matches g_gpu_resource_epoch, i.e. no bindable buffer or texture has
+  been recreated since
+otherwise the bindgroup is fetched from the G_Cache and stored back in the slot.
+*/
+struct G_BindGroupSlot {
+    WGPUBindGroupLayout layout;
+    WGPUBindGroup bg; // holds a reference
+    u64 version;
+    u64 epoch;
+};
+
+struct G_BindGroupSlots {
+    G_BindGroupSlot ways[CHUGL_BINDGROUP_SLOT_WAYS];
+    u32 next_way; // round-robin eviction when all ways are taken
+
+    // returns NULL if there is no valid bindgroup for this layout + version
+    static WGPUBindGroup get(G_BindGroupSlots* slots, WGPUBindGroupLayout layout,
+                             u64 version)
+    {
+        for (int i = 0; i < CHUGL_BINDGROUP_SLOT_WAYS; i++) {
+            G_BindGroupSlot* slot = slots->ways + i;
+            if (slot->layout != layout) continue;
+            bool valid
+              = (slot->version == version && slot->epoch == g_gpu_resource_epoch);
+            return valid ? slot->bg : NULL;
+        }
+        return NULL;
+    }
+
+    static void set(G_BindGroupSlots* slots, WGPUBindGroupLayout layout, u64 version,
+                    WGPUBindGroup bg)
+    {
+        ASSERT(layout && bg);
+        G_BindGroupSlot* slot = NULL;
+        for (int i = 0; i < CHUGL_BINDGROUP_SLOT_WAYS; i++) {
+            if (slots->ways[i].layout == layout) {
+                slot = slots->ways + i;
+                break;
+            }
+        }
+        if (!slot) {
+            slot            = slots->ways + slots->next_way;
+            slots->next_way = (slots->next_way + 1) % CHUGL_BINDGROUP_SLOT_WAYS;
+        }
+
+        // reference first in case bg is the one already in the slot
+        WGPU_REFERENCE_RESOURCE(BindGroup, bg);
+        WGPU_RELEASE_RESOURCE(BindGroup, slot->bg);
+        slot->layout  = layout;
+        slot->bg      = bg;
+        slot->version = version;
+        slot->epoch   = g_gpu_resource_epoch;
+    }
+
+    static void release(G_BindGroupSlots* slots)
+    {
+        for (int i = 0; i < CHUGL_BINDGROUP_SLOT_WAYS; i++) {
+            WGPU_RELEASE_RESOURCE(BindGroup, slots->ways[i].bg);
+        }
+        *slots = {};
+    }
+};
+
 // =============================================================================
 // scenegraph data structures
 // =============================================================================
@@ -56,6 +141,7 @@ struct R_Scene;
 struct R_Font;
 struct hashmap;
 struct G_DrawCall;
+struct G_DrawRecorder;
 struct G_Graph;
 
 typedef SG_ID R_ID; // negative for R_Components NOT mapped to SG_Components
@@ -106,9 +192,15 @@ struct R_Transform : public R_Component {
     glm::mat4 world;
     glm::mat4 normal; // aka inverse transpose M^(-1T)
     glm::mat4 local;
+    u32 world_version; // incremented every time the world matrix is rebuilt
 
+    // intrusive doubly linked list of children, mirrors SG_Transform
     SG_ID parentID;
-    Arena children; // stores list of SG_IDs
+    SG_ID first_child_id;
+    SG_ID last_child_id;
+    SG_ID prev_sibling_id;
+    SG_ID next_sibling_id;
+    u32 child_count;
 
     // don't modify directly; use R_Material::addPrimitve() instead
     // Possibly separate this into R_Mesh / R_Camera / R_Light
@@ -166,7 +258,6 @@ struct R_Transform : public R_Component {
     static void removeAllChildren(R_Transform* parent);
     static void addChild(R_Transform* parent, R_Transform* child);
     static u32 numChildren(R_Transform* xform);
-    static R_Transform* getChild(R_Transform* xform, u32 index);
 
     // Transform modification ------------------------------------------------
     static void rotateOnLocalAxis(R_Transform* xform, glm::vec3 axis, f32 deg);
@@ -185,7 +276,7 @@ struct R_Geometry : public R_Component {
     GPU_Buffer gpu_vertex_buffers[R_GEOMETRY_MAX_VERTEX_ATTRIBUTES]; // non-interleaved
     GPU_Buffer gpu_index_buffer;
     u8 vertex_attribute_num_components[R_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
-    u32* index_buffer_MALLOC; // keep around for wireframe, remember to free in cleanup
+    SG_GeometryBlock* indices_block; // keep around for wireframe
 
     // storage buffers for vertex pulling
     GPU_Buffer pull_buffers[CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS];
@@ -195,6 +286,22 @@ struct R_Geometry : public R_Component {
     b32 gpu_wireframe_index_buffer_stale;
     GPU_Buffer gpu_wireframe_index_buffer;
 
+    // local space bounds of the position attribute, used for culling.
+    // false if unknown (e.g. vertex pulling), in which case never culled
+    b32 has_bounds;
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+
+    u32 generation; // incremented on every vertex/index data change
+
+    // LOD chain, mirrors SG_Geometry. Level i + 1 draws lod_geo_ids[i]
+    SG_ID lod_geo_ids[CHUGL_GEOMETRY_MAX_LODS];
+    f32 lod_screen_sizes[CHUGL_GEOMETRY_MAX_LODS];
+    int lod_count;
+    f32 lod_cull_size;
+
+    G_BindGroupSlots pull_bg_slots; // vertex pulling bindgroups, keyed on generation
+
     static void init(R_Geometry* geo);
 
     static u32 indexCount(R_Geometry* geo);
@@ -209,13 +316,15 @@ struct R_Geometry : public R_Component {
     // TODO move vertexPulling reflection check into state of ck ShaderDesc
     static bool usesVertexPulling(R_Geometry* geo);
 
-    static void addPullBindGroupEntries(R_Geometry* geo, G_Graph* graph, G_DrawCall* d);
+    static void addPullBindGroupEntries(R_Geometry* geo, G_DrawRecorder* graph,
+                                        G_DrawCall* d);
 
     static void setPulledVertexAttribute(GraphicsContext* gctx, R_Geometry* geo,
                                          u32 location, void* data, size_t size_bytes);
 
-    static void setIndices(GraphicsContext* gctx, R_Geometry* geo, u32* indices,
-                           u32 indices_count);
+    // takes over the caller's ref on indices
+    static void setIndices(GraphicsContext* gctx, R_Geometry* geo,
+                           SG_GeometryBlock* indices);
 
     static u32 wireframeIndicesCount(R_Geometry* geo);
     static void rebuildWireframe(R_Geometry* geo, GraphicsContext* gctx);
@@ -228,6 +337,13 @@ struct R_Geometry : public R_Component {
 struct R_Texture : public R_Component {
     WGPUTexture gpu_texture;
     SG_TextureDesc desc; // TODO redundant with R_Texture.gpu_texture
+    u32 generation;      // incremented on every cpu write or resize
+
+    // layers still being decoded / uploaded by the texture stream. While nonzero
+    // a placeholder is bound in its place, see texture_stream.h
+    u32 stream_pending;
+    bool stream_gen_mips; // once all layers are uploaded
+    bool stream_failed;
 
     static int sizeBytes(R_Texture* texture);
 
@@ -303,6 +419,8 @@ struct R_Texture : public R_Component {
             WGPU_RELEASE_RESOURCE(Texture, r_tex->gpu_texture);
             r_tex->gpu_texture = wgpuDeviceCreateTexture(device, &wgpu_texture_desc);
             ASSERT(r_tex->gpu_texture);
+            ++r_tex->generation;
+            ++g_gpu_resource_epoch;
 
             // update sg_desc
             r_tex->desc.width  = width;
@@ -340,10 +458,13 @@ struct R_Texture : public R_Component {
 
             WGPUTextureDataLayout source = {};
             source.offset = 0; // where to start reading from the cpu buffer
-            source.bytesPerRow
-              = write_desc->width * G_bytesPerTexel(texture->desc.format);
+            // a row of 4x4 blocks for compressed formats
+            source.bytesPerRow = (u32)G_textureLevelBytes(texture->desc.format,
+                                                          write_desc->width, 1);
             // source.rowsPerImage = write_desc->height * write_desc->depth;
-            source.rowsPerImage = write_desc->height;
+            source.rowsPerImage = G_isCompressedFormat(texture->desc.format) ?
+                                    (write_desc->height + 3) / 4 :
+                                    write_desc->height;
 
             WGPUExtent3D size = { (u32)write_desc->width, (u32)write_desc->height,
                                   (u32)write_desc->depth };
@@ -351,19 +472,22 @@ struct R_Texture : public R_Component {
                                   &source, &size);
             // wgpuQueueSubmit(gctx->queue, 0, NULL); // schedule transfer immediately
         }
+
+        ++texture->generation;
     }
 
-    static void load(GraphicsContext* gctx, R_Texture* texture, const char* filepath,
-                     bool flip_vertically, bool gen_mips);
+    // queue the image for decoding on the texture stream. A placeholder is bound
+    // in its place until every layer is uploaded
+    static void load(R_Texture* texture, const char* filepath, bool flip_vertically,
+                     bool gen_mips);
 
-    static void load(GraphicsContext* gctx, R_Texture* texture, u8* buffer,
-                     int buffer_len, bool flip_vertically, bool gen_mips);
+    static void load(R_Texture* texture, u8* buffer, int buffer_len,
+                     bool flip_vertically, bool gen_mips);
 
-    static void loadCubemap(GraphicsContext* gctx, R_Texture* texture,
-                            const char* right_face_path, const char* left_face_path,
-                            const char* top_face_path, const char* bottom_face_path,
-                            const char* back_face_path, const char* front_face_path,
-                            bool flip_y);
+    static void loadCubemap(R_Texture* texture, const char* right_face_path,
+                            const char* left_face_path, const char* top_face_path,
+                            const char* bottom_face_path, const char* back_face_path,
+                            const char* front_face_path, bool flip_y);
 
     // creates and returns the mapped GPU buffer for holding the readback texture data
     static WGPUBuffer read(GraphicsContext* gctx, R_Texture* tex)
@@ -429,12 +553,26 @@ struct R_Shader : public R_Component {
     WGPUShaderModule compute_shader_module;
     SG_ShaderIncludes includes;
 
+    // bindings, vertex inputs and workgroup size parsed from the WGSL source.
+    // Render pipelines get an explicit (shared) layout built from this if
+    // reflection.ok, otherwise fall back to layout: auto
+    ShaderReflection reflection;
+
+    // render pipelines of this shader on the compiler thread / created so far.
+    // See G_Cache::renderPipeline()
+    int pipelines_pending;
+    int pipelines_compiled;
+
     static void init(GraphicsContext* gctx, R_Shader* shader, const char* vertex_string,
                      const char* vertex_filepath, const char* fragment_string,
                      const char* fragment_filepath, WGPUVertexFormat* vertex_layout,
                      int vertex_layout_count, const char* compute_string,
                      const char* compute_filepath, SG_ShaderIncludes* includes);
 
+    // true if geo provides every vertex input the shader reads, with the component
+    // counts of the shader's vertex layout. Logs the mismatches if `log`
+    static bool validateGeometry(R_Shader* shader, R_Geometry* geo, bool log);
+
     static void free(R_Shader* shader);
 };
 
@@ -469,6 +607,7 @@ struct R_Binding {
         SamplerConfig samplerConfig;
         GPU_Buffer storage_buffer;
         GPU_Buffer* storage_external; // ptr here might be dangerous...
+        u32 uniform_block;            // block in the material uniform pool
     } as;
 };
 
@@ -491,18 +630,18 @@ struct R_Material : public R_Component {
     // bindgroup state (uniforms, storage buffers, textures, samplers)
     R_Binding bindings[CHUGL_MATERIAL_MAX_BINDINGS];
 
-    void* _cpu_uniform_buffer_MALLOC; // used for batch writing
-    WGPUBuffer _uniform_buffer;
-    bool _uniform_buffer_stale; // used to batch write all uniform data in
-                                // R_Material::createBindGroupEntries
-    // ==optimize== after implementing wgsl reflection layout generator, can cache
-    // bindgroup on material? can then get rid of cpu-side uniform buffer per material
+    u32 bindings_version;      // incremented on every setBinding()
+    u32 bindgroup_version;     // incremented when bindgroup entries change
+    G_BindGroupSlots bg_slots; // persistent material bindgroups
+    u32 binding_warned;        // bit per location, shader mismatch already logged
 
     // bind group fns --------------------------------------------
 
-    // pushes bind group entries to bind_group arena
+    // pushes bind group entries to bind_group arena. A drawcall's entries go to
+    // `recorder` if given, otherwise to graph
     static void createBindGroupEntries(R_Material* mat, int group, G_Graph* graph,
-                                       G_DrawCall* drawcall, GraphicsContext* gctx);
+                                       G_DrawCall* drawcall, GraphicsContext* gctx,
+                                       G_DrawRecorder* recorder = NULL);
 
     static void setBinding(GraphicsContext* gctx, R_Material* mat, u32 location,
                            R_BindType type, void* data, size_t bytes);
@@ -520,11 +659,19 @@ struct R_Material : public R_Component {
     static void bindTexture(GraphicsContext* gctx, R_Material* mat, u32 location,
                             R_TextureBinding bind_desc);
 
-    static void removeBinding(R_Material* mat, u32 location)
-    {
-        ASSERT(false);
-        // TODO
-    }
+    static void removeBinding(R_Material* mat, u32 location);
+
+    // warns (once per location) if `type` does not match the declaration of
+    // @group(1) @binding(location) in the material's shader
+    static void validateBinding(R_Material* mat, u32 location,
+                                SG_MaterialUniformType type);
+
+    // uniform bindings of all materials live in a shared G_UniformPool.
+    // Uploads every uniform written since the last flush, call once per frame
+    // before executing the rendergraph
+    static void flushUniforms(GraphicsContext* gctx);
+    // the last flush, and since startup
+    static void uniformStats(G_UniformPoolStats* frame, G_UniformPoolStats* lifetime);
 };
 
 // =============================================================================
@@ -563,6 +710,13 @@ struct R_Light : public R_Transform {
     hashmap* shadow_render_id_set;   // set of all Mesh SGIDs that cast a shadow
     WGPUBuffer draw_storage_buffer;  // @group(2) draw params
     WGPUBuffer frame_uniform_buffer; // @group(0) frame uniforms
+    G_BindGroupSlots frame_bg_slots; // @group(0) bindgroups for this light's shadows
+
+    // shadow map caching
+    // hash of everything that went into this light's last rendered shadow map
+    // layer. Reused next frame if unchanged, see R_Scene::rebuildLightInfoBuffer
+    u64 shadow_signature;
+    u64 shadow_signature_fc; // scene frame count the signature was last valid for
 
     void shadowAddMesh(SG_ID* mesh_list, int mesh_count, bool add);
 
@@ -595,12 +749,31 @@ struct R_Light : public R_Transform {
 // R_Scene
 // =============================================================================
 
+struct R_ShadowStats {
+    int casters;         // shadow casters considered across all lights
+    int casters_culled;  // casters outside their light's frustum
+    int layers_rendered; // shadow map layers re-rendered
+    int layers_skipped;  // shadow map layers reused from a previous frame
+
+    void log()
+    {
+        log_trace(
+          "\n"
+          "Shadow Casters: %d\n"
+          "Shadow Casters Culled: %d\n"
+          "Shadow Layers Rendered: %d\n"
+          "Shadow Layers Skipped: %d\n",
+          casters, casters_culled, layers_rendered, layers_skipped);
+    }
+};
+
 struct R_Scene : R_Transform {
     SG_SceneDesc sg_scene_desc;
     hashmap* geo_to_xform;        // map from (Material, Geometry) to list of xforms
     hashmap* light_id_set;        // set of SG_IDs
     GPU_Buffer light_info_buffer; // lighting storage buffer
     u64 last_fc_updated;          // frame count of last light update
+    u64 prev_fc_updated;          // frame count of the update before that
 
     // shadows
     WGPUTexture spot_shadow_map_array;       // depth
@@ -609,15 +782,25 @@ struct R_Scene : R_Transform {
     WGPUTexture dir_shadow_map_array;       // depth
     WGPUTexture dir_shadow_color_map_array; // color
 
+    u32 shadow_map_generation; // incremented when the shadow map arrays are rebuilt
+    u32 bindgroup_version;     // incremented when the env map changes
+
+    R_ShadowStats shadow_frame_stats;
+    R_ShadowStats shadow_lifetime_stats;
+
     static void update(R_Scene* scene, GraphicsContext* gctx, u64 frame_count,
                        Arena* frame_arena, G_Graph* graph,
                        FrameUniforms* frame_uniforms)
     {
         if (frame_count == scene->last_fc_updated) return;
+        PROFILE_ZONE(ProfileZone_SceneUpdate);
+        scene->prev_fc_updated = scene->last_fc_updated;
         scene->last_fc_updated = frame_count;
 
-        // Update all transforms
-        R_Transform::rebuildMatrices(scene, frame_arena);
+        { // Update all transforms
+            PROFILE_ZONE(ProfileZone_MatrixRebuild);
+            R_Transform::rebuildMatrices(scene, frame_arena);
+        }
 
         // update lights
         R_Scene::rebuildLightInfoBuffer(gctx, scene, graph, frame_uniforms);
@@ -648,20 +831,33 @@ struct R_Scene : R_Transform {
 // R_Pass
 // =============================================================================
 
-void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer, GraphicsContext* gctx,
-                         G_DrawCall* d, G_Graph* graph, R_Shader* shader,
-                         R_Scene* scene, bool is_shadow_pass = false);
+// frame_bg_slots belong to the pass (or light) that owns frame_uniform_buffer
+void R_BindFrameUniforms(WGPUBuffer frame_uniform_buffer,
+                         G_BindGroupSlots* frame_bg_slots, GraphicsContext* gctx,
+                         G_DrawCall* d, G_DrawRecorder* graph, R_Shader* shader,
+                         R_Scene* scene, GPU_Buffer* light_cluster_buffer,
+                         bool is_shadow_pass = false);
 
 struct R_Pass : public R_Component {
     SG_Pass sg_pass;
     WGPUBuffer frame_uniform_buffer; // RELEASE on destroy
+    G_BindGroupSlots frame_bg_slots;
 
     // ScenePass --------------------
-    WGPUTexture depth_texture;
-    WGPUTexture msaa_color_target;
-
-    // updates the scenepass depth texture to match the color target
-    // also rebuilds the msaa color target if msaa is enabled
+    WGPUTexture msaa_color_target; // only if msaa and not cleared on load
+    GPU_Buffer light_cluster_buffer; // per-cluster light lists, see light_cluster.h
+
+    // bins the scene's lights into view-space clusters for this pass's camera and
+    // viewport, uploads the cluster lists, and sets the cluster frame uniforms.
+    // Must be called after R_Scene::update() and before any draws bind the buffer
+    static void updateLightClusters(R_Pass* pass, GraphicsContext* gctx,
+                                    R_Scene* scene, R_Camera* camera,
+                                    glm::mat4 projection, glm::vec4 viewport,
+                                    FrameUniforms* frame_uniforms);
+
+    // depth and (when cleared every frame) msaa targets are rendergraph transients.
+    // An msaa target that loads its previous contents must persist across frames,
+    // so is kept here and rebuilt to match the color target
     static void updateScenePass(R_Pass* pass, WGPUTexture color_target,
                                 WGPUDevice device)
     {
@@ -674,55 +870,25 @@ struct R_Pass : public R_Component {
 
         u32 height               = wgpuTextureGetHeight(color_target);
         u32 width                = wgpuTextureGetWidth(color_target);
-        u32 samps                = pass->sg_pass.scene_pass_msaa ? 4 : 1;
+        u32 samps                = 4;
         WGPUTextureFormat format = wgpuTextureGetFormat(color_target);
 
-        // check if we need to rebuild depth texture
+        bool persistent_msaa = pass->sg_pass.scene_pass_msaa
+                               && !pass->sg_pass.color_target_clear_on_load;
+        if (!persistent_msaa) {
+            WGPU_RELEASE_RESOURCE(Texture, pass->msaa_color_target);
+            return;
+        }
+
         // clang-format off
-        bool rebuild_depth_texture = 
-            (
-                pass->depth_texture == NULL ||
-                wgpuTextureGetHeight(pass->depth_texture) != height ||
-                wgpuTextureGetWidth(pass->depth_texture) != width ||
-                wgpuTextureGetSampleCount(pass->depth_texture) != samps
-            );
-        
         bool rebuild_msaa_texture = 
             (
-                pass->sg_pass.scene_pass_msaa &&
-                (pass->msaa_color_target == NULL ||
+                pass->msaa_color_target == NULL ||
                 wgpuTextureGetHeight(pass->msaa_color_target) != height ||
                 wgpuTextureGetWidth(pass->msaa_color_target) != width ||
-                wgpuTextureGetSampleCount(pass->msaa_color_target) != samps)
+                wgpuTextureGetFormat(pass->msaa_color_target) != format
             );
-
         // clang-format on
-        snprintf(label, sizeof(label), "Depth Texture for ScenePass[%d:%s]", pass->id,
-                 pass->sg_pass.name);
-
-        // Create the texture
-        WGPUTextureDescriptor texture_desc = {};
-        texture_desc.label                 = label;
-        texture_desc.size                  = { width, height, 1 };
-        texture_desc.mipLevelCount         = 1;
-        texture_desc.sampleCount           = samps;
-        texture_desc.dimension             = WGPUTextureDimension_2D;
-        texture_desc.format                = WGPUTextureFormat_Depth32Float;
-        texture_desc.usage                 = WGPUTextureUsage_RenderAttachment;
-
-        if (rebuild_depth_texture) {
-            WGPUTexture new_depth_texture
-              = wgpuDeviceCreateTexture(device, &texture_desc);
-            ASSERT(new_depth_texture != pass->depth_texture);
-            WGPU_RELEASE_RESOURCE(Texture, pass->depth_texture);
-            pass->depth_texture = new_depth_texture;
-            ASSERT(pass->depth_texture);
-
-            log_trace(
-              "Rebuilding ScenePass[%d:%s] depth texture, dims: %dx%d, address: %p",
-              pass->id, pass->sg_pass.name, wgpuTextureGetWidth(pass->depth_texture),
-              wgpuTextureGetHeight(pass->depth_texture), (void*)pass->depth_texture);
-        }
 
         if (rebuild_msaa_texture) {
             snprintf(label, sizeof(label),
@@ -730,8 +896,14 @@ struct R_Pass : public R_Component {
                      pass->sg_pass.name);
 
             // Create the texture
-            texture_desc.label  = label;
-            texture_desc.format = format;
+            WGPUTextureDescriptor texture_desc = {};
+            texture_desc.label                 = label;
+            texture_desc.size                  = { width, height, 1 };
+            texture_desc.mipLevelCount         = 1;
+            texture_desc.sampleCount           = samps;
+            texture_desc.dimension             = WGPUTextureDimension_2D;
+            texture_desc.format                = format;
+            texture_desc.usage                 = WGPUTextureUsage_RenderAttachment;
 
             WGPUTexture new_msaa_texture
               = wgpuDeviceCreateTexture(device, &texture_desc);
@@ -881,6 +1053,25 @@ struct R_Webcam : public R_Component {
     static void update(SG_Command_WebcamUpdate* cmd);
 };
 
+// =============================================================================
+// R_AudioTap
+// =============================================================================
+
+struct R_AudioTap : public R_Component {
+    // shared with audio thread, owned once the SG_AudioTap is freed
+    SG_AudioTapRing* ring;
+    int window;
+    SG_AudioTap_Mode mode;
+    SG_ID texture_id;
+    SG_ID buffer_id;
+    u64 last_write_head; // skip upload if no new samples since last frame
+
+    // copies the newest window out of the ring, optionally runs the FFT, and
+    // writes the result to the texture and/or storage buffer targets
+    static void upload(GraphicsContext* gctx, R_AudioTap* tap);
+    static void update(SG_Command_AudioTapUpdate* cmd);
+};
+
 // =============================================================================
 // Component Manager API
 // =============================================================================
@@ -916,6 +1107,7 @@ R_Light* Component_CreateLight(SG_ID id, SG_LightDesc* desc, WGPUDevice device,
 R_Video* Component_CreateVideo(GraphicsContext* gctx, SG_ID id, const char* filename,
                                SG_Command_VideoUpdate* cmd);
 R_Webcam* Component_CreateWebcam(SG_Command_WebcamCreate* cmd);
+R_AudioTap* Component_CreateAudioTap(SG_Command_AudioTapUpdate* cmd);
 
 R_Component* Component_GetComponent(SG_ID id);
 WGPUSampler Component_GetSampler(GraphicsContext* gctx, SG_Sampler sampler);
@@ -935,12 +1127,15 @@ R_Buffer* Component_GetBuffer(SG_ID id);
 R_Light* Component_GetLight(SG_ID id);
 R_Video* Component_GetVideo(SG_ID id);
 R_Webcam* Component_GetWebcam(SG_ID id);
+R_AudioTap* Component_GetAudioTap(SG_ID id);
 
 // be careful to not delete components while iterating
 // returns false upon reachign end of material arena
 bool Component_MaterialIter(size_t* i, R_Material** material);
+bool Component_SceneIter(size_t* i, R_Scene** scene);
 bool Component_VideoIter(size_t* i, R_Video** video);
 bool Component_WebcamIter(size_t* i, R_Webcam** webcam);
+bool Component_AudioTapIter(size_t* i, R_AudioTap** tap);
 
 // component manager initialization
 void Component_Init(GraphicsContext* gctx);
@@ -949,6 +1144,15 @@ void Component_Free();
 // component garbage collection
 void Component_FreeComponent(SG_ID id);
 
+// destroys freed components for up to budget_ms (at least one), returns the number
+// still queued
+int Component_ProcessDestroyQueue(f64 budget_ms);
+
+// uploads decoded texture rows for up to budget_bytes (at least one row, 0 means
+// unlimited), and tells chuck about textures that finished loading. Returns the
+// number of layers still loading
+int Component_UploadStreamedTextures(GraphicsContext* gctx, u64 budget_bytes);
+
 // TODO: add destroy functions. Remember to change offsets after swapping!
 // should these live in the components?
 // TODO: on xform destroy, set material/geo primitive to stale
@@ -1037,10 +1241,17 @@ struct G_CacheRenderPipelineKey {
 };
 
 struct G_CacheRenderPipelineVal {
-    WGPURenderPipeline pipeline;
+    WGPURenderPipeline pipeline; // NULL while pending
+    b32 pending; // on the compiler thread, set by G_Cache::update() when done
     WGPUBindGroupLayout
       bind_group_layout_list[CHUGL_MAX_BINDGROUPS]; // TODO free on delete
 
+    // explicit layouts only. group_count is -1 for layout: auto, in which case
+    // the number of groups is unknown and guessed from the drawcall
+    int group_count;
+    u64 group_binding_mask[CHUGL_MAX_BINDGROUPS]; // bit i: @binding(i) in layout
+    u64 group_dynamic_mask[CHUGL_MAX_BINDGROUPS]; // bit i: @binding(i) is dynamic
+
     // lazy evaluate bindGroups because getting bindGroupLayout of
     // a group that doesn't exist throughs a WGPU validation error
     WGPUBindGroupLayout bindGroupLayout(int index)
@@ -1215,6 +1426,210 @@ struct G_CacheBindGroup {
     }
 };
 
+static WGPUTextureSampleType G_textureSampleType(ShaderSampleType type)
+{
+    switch (type) {
+        case SHADER_SAMPLE_FLOAT: return WGPUTextureSampleType_Float;
+        case SHADER_SAMPLE_UNFILTERABLE_FLOAT:
+            return WGPUTextureSampleType_UnfilterableFloat;
+        case SHADER_SAMPLE_DEPTH: return WGPUTextureSampleType_Depth;
+        case SHADER_SAMPLE_SINT: return WGPUTextureSampleType_Sint;
+        case SHADER_SAMPLE_UINT: return WGPUTextureSampleType_Uint;
+        default: return WGPUTextureSampleType_Undefined;
+    }
+}
+
+static WGPUTextureViewDimension G_textureViewDimension(ShaderTextureDim dim)
+{
+    switch (dim) {
+        case SHADER_TEXTURE_DIM_1D: return WGPUTextureViewDimension_1D;
+        case SHADER_TEXTURE_DIM_2D: return WGPUTextureViewDimension_2D;
+        case SHADER_TEXTURE_DIM_2D_ARRAY: return WGPUTextureViewDimension_2DArray;
+        case SHADER_TEXTURE_DIM_CUBE: return WGPUTextureViewDimension_Cube;
+        case SHADER_TEXTURE_DIM_CUBE_ARRAY: return WGPUTextureViewDimension_CubeArray;
+        case SHADER_TEXTURE_DIM_3D: return WGPUTextureViewDimension_3D;
+        default: return WGPUTextureViewDimension_Undefined;
+    }
+}
+
+// @binding mask of the uniform buffers in an explicit layout's group that take
+// dynamic offsets: the material group, so every material of a shader whose uniform
+// blocks share a G_UniformPool page also shares one bindgroup
+static u64 G_dynamicOffsetMask(ShaderReflection* refl, int group)
+{
+    if (group != PER_MATERIAL_GROUP) return 0;
+
+    u64 mask          = 0;
+    int uniform_count = 0;
+    int first         = 0;
+    int count         = ShaderReflect_GroupBindings(refl, group, &first);
+    for (int i = 0; i < count; i++) {
+        ShaderBinding* b = refl->bindings + first + i;
+        if (b->kind != SHADER_BINDING_UNIFORM_BUFFER || b->binding >= 64) continue;
+        mask |= (1ULL << b->binding);
+        ++uniform_count;
+    }
+    return uniform_count <= CHUGL_MAX_DYNAMIC_UNIFORM_BUFFERS ? mask : 0;
+}
+
+// explicit bindgroup layouts are deduplicated by their entries, so every shader
+// that declares the same bindings in a group shares one WGPUBindGroupLayout,
+// and with it bindgroups (both hashed and G_BindGroupSlots are keyed by layout)
+struct G_CacheBindGroupLayoutKey {
+    int entry_count;
+    WGPUBindGroupLayoutEntry entries[CHUGL_MATERIAL_MAX_BINDINGS];
+};
+
+struct G_CacheBindGroupLayout {
+    G_CacheBindGroupLayoutKey key; // zeroed, including padding
+    WGPUBindGroupLayout val;       // never released, owned by the cache
+
+    static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        G_CacheBindGroupLayoutKey* key = (G_CacheBindGroupLayoutKey*)item;
+        return hashmap_xxhash3(key, sizeof(*key), seed0, seed1);
+    }
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        return memcmp(a, b, sizeof(G_CacheBindGroupLayoutKey));
+    }
+};
+
+struct G_CachePipelineLayoutKey {
+    int group_count;
+    WGPUBindGroupLayout groups[CHUGL_MAX_BINDGROUPS];
+};
+
+struct G_CachePipelineLayout {
+    G_CachePipelineLayoutKey key;
+    WGPUPipelineLayout val; // never released, owned by the cache
+
+    static u64 hash(const void* item, uint64_t seed0, uint64_t seed1)
+    {
+        G_CachePipelineLayoutKey* key = (G_CachePipelineLayoutKey*)item;
+        return hashmap_xxhash3(key, sizeof(*key), seed0, seed1);
+    }
+
+    static int compare(const void* a, const void* b, void* udata)
+    {
+        return memcmp(a, b, sizeof(G_CachePipelineLayoutKey));
+    }
+};
+
+// =============================================================================
+// Pipeline compiler thread
+// =============================================================================
+
+/*
+Creating a render pipeline compiles its shaders for the backend, which can take
+tens of milliseconds. Doing that inline on the first frame a material is drawn
+stalls the render thread, so by default G_Cache::renderPipeline() builds the
+descriptor and hands it to a compiler thread, returning a pending pipeline.
+Draws that need a pending pipeline are skipped (or drawn with the fallback
+material, see _R_RenderScene), and G_Cache::update() picks up finished
+pipelines once per frame.
+
+wgpu devices are thread-safe, so the compiler thread just calls the blocking
+wgpuDeviceCreateRenderPipeline (wgpu-native doesn't implement
+wgpuDeviceCreateRenderPipelineAsync). Layouts are still created on the render
+thread, only the pipeline itself is compiled off-thread.
+*/
+
+// owns everything the descriptor points to, so it can outlive renderPipeline()
+struct G_PipelineJob {
+    G_CacheRenderPipelineKey key;
+    WGPURenderPipelineDescriptor desc; // points into the fields below
+
+    VertexBufferLayout vertex_layout;
+    WGPUBlendState blend_state;
+    WGPUColorTargetState color_target;
+    WGPUFragmentState fragment;
+    WGPUDepthStencilState depth_stencil;
+    char label[64];
+
+    WGPURenderPipeline pipeline; // result
+    G_PipelineJob* next;
+
+    static void init(G_PipelineJob* job, G_CacheRenderPipelineKey* key,
+                     R_Shader* shader, WGPUPipelineLayout layout)
+    {
+        *job = {};
+        COPY_STRUCT(&job->key, key); // hashed bytewise, copy the padding too
+
+        G_DrawCallPipelineDesc* dc_desc    = &key->drawcall_pipeline_desc;
+        WGPURenderPipelineDescriptor* desc = &job->desc;
+        desc->layout                       = layout;
+        desc->primitive.cullMode           = dc_desc->cull_mode;
+        desc->primitive.topology           = dc_desc->primitive_topology;
+        desc->primitive.stripIndexFormat
+          = G_Util::isStripTopology(dc_desc->primitive_topology) ?
+              WGPUIndexFormat_Uint32 :
+              WGPUIndexFormat_Undefined;
+
+        VertexBufferLayout::init(&job->vertex_layout,
+                                 ARRAY_LENGTH(shader->vertex_layout),
+                                 shader->vertex_layout);
+        desc->vertex.bufferCount = job->vertex_layout.attribute_count;
+        desc->vertex.buffers     = job->vertex_layout.layouts;
+        desc->vertex.module      = shader->vertex_shader_module;
+        desc->vertex.entryPoint  = VS_ENTRY_POINT;
+
+        // TODO what happens if fragment shader is not defined?
+        // for backwards compat, we always enable alpha blending, even if pipeline
+        // is not transparent
+        job->blend_state = dc_desc->blend_state;
+        if (key->color_target_format != WGPUTextureFormat_Undefined) {
+            job->color_target.format    = key->color_target_format;
+            job->color_target.blend     = &job->blend_state;
+            job->color_target.writeMask = WGPUColorWriteMask_All;
+
+            job->fragment.module      = shader->fragment_shader_module;
+            job->fragment.entryPoint  = FS_ENTRY_POINT;
+            job->fragment.targetCount = 1; // fix 1 color target for now
+            job->fragment.targets     = &job->color_target;
+
+            desc->fragment = &job->fragment;
+        }
+
+        job->depth_stencil = G_createDepthStencilState(key->depth_target_format,
+                                                       !dc_desc->is_transparent);
+
+        bool is_triangle_topology
+          = (dc_desc->primitive_topology == WGPUPrimitiveTopology_TriangleList
+             || dc_desc->primitive_topology == WGPUPrimitiveTopology_TriangleStrip);
+        // from WebGPU spec:
+        // depthBias, depthBiasSlopeScale, and depthBiasClamp have no effect on
+        // "point-list", "line-list", and "line-strip" primitives, and must be 0.
+        if (dc_desc->is_shadow_pass && is_triangle_topology) {
+            // from E.Lengyel Vol2 Rendering pg 193-4
+            // polygon offset to remove shadow acne
+            job->depth_stencil.depthBiasSlopeScale = 3;
+            job->depth_stencil.depthBiasClamp      = (1.0f / 128.0f);
+        }
+
+        desc->depthStencil = key->depth_target_format ? &job->depth_stencil : NULL;
+
+        desc->multisample = G_createMultisampleState(
+          key->color_target_sample_count ? key->color_target_sample_count : 1);
+
+        snprintf(job->label, sizeof(job->label), "RenderPipeline: Shader[%d] %s",
+                 shader->id, shader->name);
+        desc->label = job->label;
+    }
+};
+
+// job must be heap allocated (ALLOCATE_TYPE), and references its shader modules.
+// Starts the compiler thread on first use
+void G_PipelineCompiler_Submit(WGPUDevice device, G_PipelineJob* job);
+
+// takes the list of finished jobs, linked through job->next. Never blocks
+G_PipelineJob* G_PipelineCompiler_Completed();
+
+// joins the compiler thread, releasing unfinished jobs. Call before the device is
+// released
+void G_PipelineCompiler_Shutdown();
+
 // eventually this will become more like WGPUTextureDesc
 struct G_CacheRenderTargetDesc {
     WGPUTextureFormat view_format;
@@ -1226,7 +1641,13 @@ struct G_CacheStats {
     int render_pipeline_misses;
     int compute_pipeline_misses;
     int bindgroup_misses;
+    int bindgroup_hits;            // found by hashing the bindgroup entries
+    int bindgroup_persistent_hits; // reused from a G_BindGroupSlots, no hashing
     int texture_view_misses;
+    int bindgroup_layout_misses;
+    int pipeline_layout_misses;
+    int render_pipelines_compiled; // finished on the compiler thread
+    int render_pipelines_pending;  // still compiling at the end of the frame
 
     void log()
     {
@@ -1235,9 +1656,17 @@ struct G_CacheStats {
           "Render Pipeline Misses: %d\n"
           "Compute Pipeline Misses: %d\n"
           "Bindgroup Misses: %d\n"
-          "TextureView Misses: %d\n",
+          "Bindgroup Hits: %d\n"
+          "Bindgroup Persistent Hits: %d\n"
+          "TextureView Misses: %d\n"
+          "Bindgroup Layout Misses: %d\n"
+          "Pipeline Layout Misses: %d\n"
+          "Render Pipelines Compiled: %d\n"
+          "Render Pipelines Pending: %d\n",
           render_pipeline_misses, compute_pipeline_misses, bindgroup_misses,
-          texture_view_misses);
+          bindgroup_hits, bindgroup_persistent_hits, texture_view_misses,
+          bindgroup_layout_misses, pipeline_layout_misses, render_pipelines_compiled,
+          render_pipelines_pending);
     }
 };
 
@@ -1248,16 +1677,24 @@ struct G_Cache {
     hashmap* compute_pipeline_map;
     hashmap* bindgroup_map;
     hashmap* texture_view_map;
+    hashmap* bindgroup_layout_map;
+    hashmap* pipeline_layout_map;
 
     Arena deletion_queue;
 
+    // if false, render pipelines are created inline on a cache miss
+    b32 async_pipelines;
+    int pipelines_in_flight;
+
     // per-frame stats
     G_CacheStats frame_stats;
+    G_CacheStats last_frame_stats; // frame_stats of the previous update()
     G_CacheStats lifetime_stats;
 
     void init()
     {
         initialized         = 0xDEADBEEF;
+        async_pipelines     = true;
         render_pipeline_map = hashmap_new_simple(sizeof(G_CacheRenderPipeline),
                                                  G_CacheRenderPipeline::hash,
                                                  G_CacheRenderPipeline::compare);
@@ -1272,6 +1709,14 @@ struct G_Cache {
         texture_view_map
           = hashmap_new_simple(sizeof(G_CacheTextureView), G_CacheTextureView::hash,
                                G_CacheTextureView::compare);
+
+        bindgroup_layout_map = hashmap_new_simple(sizeof(G_CacheBindGroupLayout),
+                                                  G_CacheBindGroupLayout::hash,
+                                                  G_CacheBindGroupLayout::compare);
+
+        pipeline_layout_map = hashmap_new_simple(sizeof(G_CachePipelineLayout),
+                                                 G_CachePipelineLayout::hash,
+                                                 G_CachePipelineLayout::compare);
     }
 
     G_CacheComputePipeline computePipeline(WGPUShaderModule module, WGPUDevice device,
@@ -1310,6 +1755,134 @@ struct G_Cache {
         return *result;
     }
 
+    // layout of @group(group) of a render pipeline, NULL if it can't be expressed
+    // (e.g. unknown storage texture format)
+    WGPUBindGroupLayout bindGroupLayout(WGPUDevice device, ShaderReflection* refl,
+                                        int group)
+    {
+        int first = 0;
+        int count = ShaderReflect_GroupBindings(refl, group, &first);
+        if (count > CHUGL_MATERIAL_MAX_BINDINGS) return NULL;
+
+        // MSVC can't value-initialize this (see bindGroup()), and the key is
+        // hashed bytewise so the padding must be zero
+        u8 item_buff[sizeof(G_CacheBindGroupLayout)] = {};
+        G_CacheBindGroupLayout* item = (G_CacheBindGroupLayout*)item_buff;
+        item->key.entry_count        = count;
+        u64 dynamic_mask             = G_dynamicOffsetMask(refl, group);
+
+        for (int i = 0; i < count; i++) {
+            ShaderBinding* b            = refl->bindings + first + i;
+            WGPUBindGroupLayoutEntry* e = item->key.entries + i;
+            e->binding                  = b->binding;
+            if (b->binding >= 64) return NULL; // see group_binding_mask
+
+            // widen read-only bindings to both raster stages so shaders that use
+            // the same bindings from different stages still share a layout.
+            // Writable storage is not allowed in the vertex stage
+            bool writable = b->kind == SHADER_BINDING_STORAGE_BUFFER
+                            || (b->kind == SHADER_BINDING_STORAGE_TEXTURE
+                                && b->access != SHADER_ACCESS_READ);
+            e->visibility = writable ?
+                              b->visibility :
+                              (WGPUShaderStage_Vertex | WGPUShaderStage_Fragment);
+
+            switch (b->kind) {
+                case SHADER_BINDING_UNIFORM_BUFFER:
+                    e->buffer.type = WGPUBufferBindingType_Uniform;
+                    e->buffer.hasDynamicOffset
+                      = (dynamic_mask & (1ULL << b->binding)) != 0;
+                    break;
+                case SHADER_BINDING_STORAGE_BUFFER:
+                    e->buffer.type = WGPUBufferBindingType_Storage;
+                    break;
+                case SHADER_BINDING_READ_ONLY_STORAGE_BUFFER:
+                    e->buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+                    break;
+                case SHADER_BINDING_SAMPLER:
+                    e->sampler.type = WGPUSamplerBindingType_Filtering;
+                    break;
+                case SHADER_BINDING_COMPARISON_SAMPLER:
+                    e->sampler.type = WGPUSamplerBindingType_Comparison;
+                    break;
+                case SHADER_BINDING_TEXTURE: {
+                    e->texture.sampleType    = G_textureSampleType(b->sample_type);
+                    e->texture.viewDimension = G_textureViewDimension(b->view_dim);
+                    e->texture.multisampled  = b->multisampled;
+                } break;
+                case SHADER_BINDING_STORAGE_TEXTURE: {
+                    e->storageTexture.access
+                      = b->access == SHADER_ACCESS_READ ?
+                          WGPUStorageTextureAccess_ReadOnly :
+                        b->access == SHADER_ACCESS_READ_WRITE ?
+                          WGPUStorageTextureAccess_ReadWrite :
+                          WGPUStorageTextureAccess_WriteOnly;
+                    e->storageTexture.format
+                      = G_Util::textureFormatFromWGSL(b->storage_format);
+                    e->storageTexture.viewDimension
+                      = G_textureViewDimension(b->view_dim);
+                    if (e->storageTexture.format == WGPUTextureFormat_Undefined)
+                        return NULL;
+                } break;
+                default: return NULL;
+            }
+        }
+
+        G_CacheBindGroupLayout* result
+          = (G_CacheBindGroupLayout*)hashmap_get(bindgroup_layout_map, &item->key);
+        if (result) return result->val;
+
+        ++frame_stats.bindgroup_layout_misses;
+        WGPUBindGroupLayoutDescriptor desc = {};
+        desc.label                         = "shared bindgroup layout";
+        desc.entryCount                    = count;
+        desc.entries                       = item->key.entries;
+        item->val = wgpuDeviceCreateBindGroupLayout(device, &desc);
+        log_trace(
+          "Cache miss [BindGroupLayout] @group(%d) with %d bindings, created %p",
+          group, count, (void*)item->val);
+
+        const void* replaced = hashmap_set(bindgroup_layout_map, item);
+        UNUSED_VAR(replaced);
+        ASSERT(!replaced);
+        return item->val;
+    }
+
+    // explicit pipeline layout for a reflected render shader. Returns NULL if the
+    // reflection can't be expressed as a layout, in which case use layout: auto.
+    // group_layouts receives the layout of each of the refl->group_count groups
+    WGPUPipelineLayout pipelineLayout(WGPUDevice device, ShaderReflection* refl,
+                                      WGPUBindGroupLayout* group_layouts)
+    {
+        if (!refl->ok || refl->group_count > CHUGL_MAX_BINDGROUPS) return NULL;
+
+        G_CachePipelineLayout item = {};
+        item.key.group_count       = refl->group_count;
+        for (int g = 0; g < refl->group_count; g++) {
+            item.key.groups[g] = bindGroupLayout(device, refl, g);
+            if (item.key.groups[g] == NULL) return NULL;
+            group_layouts[g] = item.key.groups[g];
+        }
+
+        G_CachePipelineLayout* result
+          = (G_CachePipelineLayout*)hashmap_get(pipeline_layout_map, &item.key);
+        if (result) return result->val;
+
+        ++frame_stats.pipeline_layout_misses;
+        WGPUPipelineLayoutDescriptor desc = {};
+        desc.label                        = "shared pipeline layout";
+        desc.bindGroupLayoutCount         = refl->group_count;
+        desc.bindGroupLayouts             = item.key.groups;
+        item.val = wgpuDeviceCreatePipelineLayout(device, &desc);
+
+        const void* replaced = hashmap_set(pipeline_layout_map, &item);
+        UNUSED_VAR(replaced);
+        ASSERT(!replaced);
+        return item.val;
+    }
+
+    // on a miss with async_pipelines, submits the pipeline to the compiler thread
+    // and returns an entry whose val.pipeline is NULL until a later update()
     G_CacheRenderPipeline* renderPipeline(G_CacheRenderPipelineKey key,
                                           WGPUDevice device)
     {
@@ -1381,89 +1954,49 @@ struct G_Cache {
             UNUSED_VAR(is_render_pipeline);
             ASSERT(is_render_pipeline);
 
-            // build pipeline desc
-            WGPURenderPipelineDescriptor pipeline_desc = {};
-            pipeline_desc.layout                       = NULL; // Using layout: auto
-            pipeline_desc.primitive.cullMode = key.drawcall_pipeline_desc.cull_mode;
-            pipeline_desc.primitive.topology
-              = key.drawcall_pipeline_desc.primitive_topology;
-            pipeline_desc.primitive.stripIndexFormat
-              = G_Util::isStripTopology(key.drawcall_pipeline_desc.primitive_topology) ?
-                  WGPUIndexFormat_Uint32 :
-                  WGPUIndexFormat_Undefined;
-
-            VertexBufferLayout vertex_layout = {};
-            VertexBufferLayout::init(&vertex_layout,
-                                     ARRAY_LENGTH(shader->vertex_layout),
-                                     shader->vertex_layout);
-            pipeline_desc.vertex.bufferCount = vertex_layout.attribute_count;
-            pipeline_desc.vertex.buffers     = vertex_layout.layouts;
-            pipeline_desc.vertex.module      = shader->vertex_shader_module;
-            pipeline_desc.vertex.entryPoint  = VS_ENTRY_POINT;
-
-            // TODO what happens if fragment shader is not defined?
-            // for backwards compat, we always enable alpha blending, even if pipeline
-            // is not transparent
-
-            if (key.color_target_sample_count == 0) {
-                int i = 0;
-                UNUSED_VAR(i);
-            }
-
-            WGPUBlendState blend_state = key.drawcall_pipeline_desc.blend_state;
-            WGPUColorTargetState colorTargetState = {};
-            WGPUFragmentState fragmentState       = {};
-            bool has_color_target
-              = (key.color_target_format != WGPUTextureFormat_Undefined);
-            if (has_color_target) {
-                colorTargetState.format    = key.color_target_format;
-                colorTargetState.blend     = &blend_state;
-                colorTargetState.writeMask = WGPUColorWriteMask_All;
-
-                fragmentState.module      = shader->fragment_shader_module;
-                fragmentState.entryPoint  = FS_ENTRY_POINT;
-                fragmentState.targetCount = 1; // fix 1 color target for now
-                fragmentState.targets     = &colorTargetState;
-
-                pipeline_desc.fragment = &fragmentState;
-            }
-
-            WGPUDepthStencilState depth_stencil_state = G_createDepthStencilState(
-              key.depth_target_format, !key.drawcall_pipeline_desc.is_transparent);
-
-            bool is_triangle_topology
-              = (key.drawcall_pipeline_desc.primitive_topology
-                   == WGPUPrimitiveTopology_TriangleList
-                 || key.drawcall_pipeline_desc.primitive_topology
-                      == WGPUPrimitiveTopology_TriangleStrip);
-            // from WebGPU spec:
-            // depthBias, depthBiasSlopeScale, and depthBiasClamp have no effect on
-            // "point-list", "line-list", and "line-strip" primitives, and must be 0.
-            if (key.drawcall_pipeline_desc.is_shadow_pass && is_triangle_topology) {
-                // from E.Lengyel Vol2 Rendering pg 193-4
-                // polygon offset to remove shadow acne
-                depth_stencil_state.depthBiasSlopeScale = 3;
-                depth_stencil_state.depthBiasClamp      = (1.0f / 128.0f);
-            }
-
-            pipeline_desc.depthStencil
-              = key.depth_target_format ? &depth_stencil_state : NULL;
-
-            pipeline_desc.multisample = G_createMultisampleState(
-              key.color_target_sample_count ? key.color_target_sample_count : 1);
-
-            char pipeline_label[64] = {};
-            snprintf(pipeline_label, sizeof(pipeline_label),
-                     "RenderPipeline: Shader[%d] %s", shader->id, shader->name);
-            pipeline_desc.label = pipeline_label;
-
-            WGPURenderPipeline pipeline
-              = wgpuDeviceCreateRenderPipeline(device, &pipeline_desc);
+            // falls back to layout: auto (NULL) if the shader failed to reflect
+            WGPUBindGroupLayout group_layouts[CHUGL_MAX_BINDGROUPS] = {};
+            WGPUPipelineLayout layout
+              = pipelineLayout(device, &shader->reflection, group_layouts);
 
             // add to cache
             G_CacheRenderPipeline pipeline_item = {};
             pipeline_item.key                   = key;
-            pipeline_item.val.pipeline          = pipeline;
+            pipeline_item.val.group_count       = -1;
+            if (layout) {
+                ShaderReflection* refl        = &shader->reflection;
+                pipeline_item.val.group_count = refl->group_count;
+                memcpy(pipeline_item.val.bind_group_layout_list, group_layouts,
+                       sizeof(group_layouts));
+                for (int i = 0; i < refl->binding_count; i++) {
+                    ShaderBinding* b = refl->bindings + i;
+                    pipeline_item.val.group_binding_mask[b->group]
+                      |= (1ULL << b->binding);
+                }
+                for (int g = 0; g < refl->group_count; g++) {
+                    pipeline_item.val.group_dynamic_mask[g]
+                      = G_dynamicOffsetMask(refl, g);
+                }
+            }
+
+            if (async_pipelines) {
+                G_PipelineJob* job = ALLOCATE_TYPE(G_PipelineJob);
+                G_PipelineJob::init(job, &key, shader, layout);
+                // modules must outlive the job even if the shader is freed
+                WGPU_REFERENCE_RESOURCE(ShaderModule, job->desc.vertex.module);
+                WGPU_REFERENCE_RESOURCE(ShaderModule, job->fragment.module);
+                G_PipelineCompiler_Submit(device, job);
+
+                pipeline_item.val.pending = true;
+                ++shader->pipelines_pending;
+                ++pipelines_in_flight;
+            } else {
+                G_PipelineJob job = {};
+                G_PipelineJob::init(&job, &key, shader, layout);
+                pipeline_item.val.pipeline
+                  = wgpuDeviceCreateRenderPipeline(device, &job.desc);
+                ++shader->pipelines_compiled;
+            }
 
             const void* replaced = hashmap_set(render_pipeline_map, &pipeline_item);
             ASSERT(!replaced);
@@ -1476,6 +2009,15 @@ struct G_Cache {
         return result;
     }
 
+    // true if a pipeline for key has been compiled and draws would not be skipped.
+    // Lookup only, never creates or submits a pipeline
+    bool renderPipelineReady(G_CacheRenderPipelineKey* key)
+    {
+        G_CacheRenderPipeline* result
+          = (G_CacheRenderPipeline*)hashmap_get(render_pipeline_map, key);
+        return result && result->val.pipeline != NULL;
+    }
+
     WGPUTextureView textureView(G_CacheTextureViewDesc desc)
     {
         // check if present in cache
@@ -1639,12 +2181,61 @@ struct G_Cache {
         }
 
         // reset lifetime counter
+        ++frame_stats.bindgroup_hits;
         result->val.frames_till_expired = CHUGL_CACHE_BINDGROUP_FRAMES_TILL_EXPIRED;
         return result->val.bg;
     }
 
+    // reuses the bindgroup in `slots` if still valid, otherwise falls back to the
+    // hashed lookup above and stores the result back in `slots`
+    WGPUBindGroup bindGroup(WGPUDevice device, G_BindGroupSlots* slots, u64 version,
+                            G_CacheBindGroupEntry* bg_entry_list, int bg_entry_count,
+                            WGPUBindGroupLayout layout, int group, const char* label)
+    {
+        WGPUBindGroup bg = G_BindGroupSlots::get(slots, layout, version);
+        if (bg) {
+            ++frame_stats.bindgroup_persistent_hits;
+            return bg;
+        }
+
+        bg = bindGroup(device, bg_entry_list, bg_entry_count, layout, group, label);
+        G_BindGroupSlots::set(slots, layout, version, bg);
+        return bg;
+    }
+
+    // moves pipelines finished on the compiler thread into the cache
+    void pollPipelines()
+    {
+        G_PipelineJob* job = G_PipelineCompiler_Completed();
+        while (job) {
+            G_CacheRenderPipeline* entry
+              = (G_CacheRenderPipeline*)hashmap_get(render_pipeline_map, &job->key);
+            ASSERT(entry && entry->val.pending);
+            entry->val.pipeline = job->pipeline;
+            entry->val.pending  = false;
+            log_trace("Compiled [RenderPipeline] %s", job->label);
+
+            R_Shader* shader
+              = Component_GetShader(job->key.drawcall_pipeline_desc.sg_shader_id);
+            if (shader) {
+                --shader->pipelines_pending;
+                ++shader->pipelines_compiled;
+            }
+            --pipelines_in_flight;
+            ++frame_stats.render_pipelines_compiled;
+
+            WGPU_RELEASE_RESOURCE(ShaderModule, job->desc.vertex.module);
+            WGPU_RELEASE_RESOURCE(ShaderModule, job->fragment.module);
+            G_PipelineJob* next = job->next;
+            FREE_TYPE(G_PipelineJob, job);
+            job = next;
+        }
+    }
+
     void update()
     {
+        pollPipelines();
+
         // TODO: loop over all pipelines, and if associated R_Shader is destroyed,
         // free the pipeline and WGPU_RELEASE the cached bindgroup layouts
 
@@ -1750,10 +2341,20 @@ struct G_Cache {
         // log_trace("--Cache Frame Stats--");
         // frame_stats.log();
         lifetime_stats.bindgroup_misses += frame_stats.bindgroup_misses;
+        lifetime_stats.bindgroup_hits += frame_stats.bindgroup_hits;
+        lifetime_stats.bindgroup_persistent_hits
+          += frame_stats.bindgroup_persistent_hits;
         lifetime_stats.compute_pipeline_misses += frame_stats.compute_pipeline_misses;
         lifetime_stats.render_pipeline_misses += frame_stats.render_pipeline_misses;
         lifetime_stats.texture_view_misses += frame_stats.texture_view_misses;
-        frame_stats = {};
+        lifetime_stats.bindgroup_layout_misses += frame_stats.bindgroup_layout_misses;
+        lifetime_stats.pipeline_layout_misses += frame_stats.pipeline_layout_misses;
+        lifetime_stats.render_pipelines_compiled
+          += frame_stats.render_pipelines_compiled;
+        frame_stats.render_pipelines_pending    = pipelines_in_flight;
+        lifetime_stats.render_pipelines_pending = pipelines_in_flight;
+        last_frame_stats                        = frame_stats;
+        frame_stats                             = {};
     }
 };
 
@@ -1840,14 +2441,20 @@ struct G_DrawCall {
     u64 index_buffer_size;
 
     u32 instance_count;
+    u32 first_instance; // e.g. where a LOD level starts in the per-draw storage buffer
+
+    // if set, counts and instances are read from this buffer instead, e.g. written
+    // by a culling compute pass (see instance_cull.h)
+    WGPUBuffer indirect_buffer;
+    u64 indirect_offset;
 
     struct {
         u32 start, count;
     } bg_list[CHUGL_MAX_BINDGROUPS];
 
-    // no dynamic offsets for now (until we make C port of webgpu-utils shader
-    // parser)
-    // dynamic_offsets = new Array<Array<number>>(4);
+    // optional persistent bindgroup per group, set via G_Graph::persistentBindGroup
+    G_BindGroupSlots* bg_slots[CHUGL_MAX_BINDGROUPS];
+    u64 bg_slot_version[CHUGL_MAX_BINDGROUPS];
 
     G_DrawCallPipelineDesc _pipeline_desc;
 
@@ -1878,6 +2485,56 @@ struct G_DrawCallList {
     int drawcall_count;
     bool sorted;
 
+    // entries whose @binding is in layout_mask. Returns `entries` itself if none
+    // are dropped, otherwise a scratch copy valid until the next call
+    static G_CacheBindGroupEntry* filterBindGroupEntries(G_CacheBindGroupEntry* entries,
+                                                         int* count, u64 layout_mask)
+    {
+        static G_CacheBindGroupEntry filtered[CHUGL_MATERIAL_MAX_BINDINGS];
+
+        int kept = 0;
+        for (int i = 0; i < *count; i++) {
+            if (entries[i].binding < 64 && (layout_mask & (1ULL << entries[i].binding)))
+                ++kept;
+        }
+        if (kept == *count) return entries;
+
+        kept = 0;
+        for (int i = 0; i < *count; i++) {
+            if (entries[i].binding < 64 && (layout_mask & (1ULL << entries[i].binding)))
+                memcpy(filtered + kept++, entries + i, sizeof(*entries));
+        }
+        *count = kept;
+        return filtered;
+    }
+
+    // moves the offsets of the buffer entries in dynamic_mask into dynamic_offsets,
+    // in @binding order, and binds those buffers at offset 0. Entries that only
+    // differ in those offsets then share a bindgroup. Returns a scratch copy valid
+    // until the next call
+    static G_CacheBindGroupEntry* splitDynamicOffsets(G_CacheBindGroupEntry* entries,
+                                                      int count, u64 dynamic_mask,
+                                                      u32* dynamic_offsets,
+                                                      int* dynamic_offset_count)
+    {
+        static G_CacheBindGroupEntry split[CHUGL_MATERIAL_MAX_BINDINGS];
+        ASSERT(count <= ARRAY_LENGTH(split));
+        memcpy(split, entries, count * sizeof(*entries));
+
+        // entries are recorded in @binding order, which is also the order WebGPU
+        // expects dynamic offsets in
+        *dynamic_offset_count = 0;
+        for (int i = 0; i < count; i++) {
+            G_CacheBindGroupEntry* e = split + i;
+            if (e->binding >= 64 || (dynamic_mask & (1ULL << e->binding)) == 0)
+                continue;
+            ASSERT(e->type == G_CacheBindGroupEntryType_Buffer);
+            dynamic_offsets[(*dynamic_offset_count)++] = e->as.buffer.offset;
+            e->as.buffer.offset                        = 0;
+        }
+        return split;
+    }
+
     // ==optimize== only rebind pipeline if it's actually changed
     // see R_RenderSceneOld for how
     void execute(WGPUDevice device,
@@ -1947,44 +2604,71 @@ struct G_DrawCallList {
             //       d->_pipeline_desc.sg_shader_id, d->_pipeline_desc.is_transparent);
             // }
 
+            // still compiling, skip the draw
+            if (cached_pipeline->val.pipeline == NULL) continue;
+
             // set pipeline
             wgpuRenderPassEncoderSetPipeline(pass_encoder,
                                              cached_pipeline->val.pipeline);
 
             /* Pipeline Layout / Bindgroup situation
-            wgpuRenderPipelineGetLayout() can only be called for group index up to the
-            max defined. e.g. if a shader defines @group(0) and @group(2), you can get
-            the layout for @group(1) but NOT @group(3). Doing so crashes.
-
-            If @group(0) and @group(2) are defined, you still must set an empty
-            wgpuBindGroup in the slot of @group(1). But you *cannot* set a bindgroup in
-            @group(3).
-
-            Solution until I make a shader parser / wgpuPipelineLayout library:
-                - guess the max defined @group of the pipeline by seeing the highest
-            @group that has nonzero num_bindings
-                - if less than that, always set the bindgroup, even if num_bindings = 0
+            Shaders that reflect successfully have an explicit pipeline layout with
+            exactly group_count groups, and we know which bindings each group has.
+            Set every group (empty ones included, no holes allowed), and drop
+            drawcall entries the shader doesn't use, e.g. frame uniforms for a
+            shader that never reads them. Material uniforms are bound with dynamic
+            offsets (see G_dynamicOffsetMask), so the bindgroup is shared by every
+            material whose uniform blocks live in the same G_UniformPool pages.
+
+            Otherwise the pipeline uses layout: auto, whose groups we can only get
+            up to the max defined @group (asking for a higher one crashes). Guess it
+            from the highest group with nonzero num_bindings, and bind every group up
+            to that, even if num_bindings = 0.
             */
-            int max_group_number = 0;
-            for (int bg_idx = ARRAY_LENGTH(d->bg_list) - 1; bg_idx >= 0; --bg_idx) {
-                if (d->bg_list[bg_idx].count > 0) {
-                    max_group_number = bg_idx;
-                    break;
+            int group_count = cached_pipeline->val.group_count;
+            if (group_count < 0) {
+                group_count = 1;
+                for (int bg_idx = ARRAY_LENGTH(d->bg_list) - 1; bg_idx >= 0; --bg_idx) {
+                    if (d->bg_list[bg_idx].count > 0) {
+                        group_count = bg_idx + 1;
+                        break;
+                    }
                 }
             }
 
             // set frame, material, and draw bindgroups
-            for (int bg_idx = 0; bg_idx <= max_group_number; bg_idx++) {
+            for (int bg_idx = 0; bg_idx < group_count; bg_idx++) {
                 int num_bindings = d->bg_list[bg_idx].count;
                 int start        = d->bg_list[bg_idx].start;
-                WGPUBindGroup bg = cache->bindGroup(
-                  device,
-                  ARENA_GET_TYPE(bind_group_list + bg_idx, G_CacheBindGroupEntry,
-                                 start),
-                  num_bindings, cached_pipeline->val.bindGroupLayout(bg_idx), bg_idx,
-                  pass_name);
+                WGPUBindGroupLayout layout
+                  = cached_pipeline->val.bindGroupLayout(bg_idx);
+                G_CacheBindGroupEntry* entries = ARENA_GET_TYPE(
+                  bind_group_list + bg_idx, G_CacheBindGroupEntry, start);
+
+                u32 dynamic_offsets[CHUGL_MATERIAL_MAX_BINDINGS];
+                int dynamic_offset_count = 0;
+                if (cached_pipeline->val.group_count >= 0) {
+                    entries = filterBindGroupEntries(
+                      entries, &num_bindings,
+                      cached_pipeline->val.group_binding_mask[bg_idx]);
+                    u64 dynamic_mask = cached_pipeline->val.group_dynamic_mask[bg_idx];
+                    if (dynamic_mask) {
+                        entries = splitDynamicOffsets(entries, num_bindings,
+                                                      dynamic_mask, dynamic_offsets,
+                                                      &dynamic_offset_count);
+                    }
+                }
+
+                WGPUBindGroup bg
+                  = d->bg_slots[bg_idx] ?
+                      cache->bindGroup(device, d->bg_slots[bg_idx],
+                                       d->bg_slot_version[bg_idx], entries,
+                                       num_bindings, layout, bg_idx, pass_name) :
+                      cache->bindGroup(device, entries, num_bindings, layout, bg_idx,
+                                       pass_name);
                 ASSERT(bg);
-                wgpuRenderPassEncoderSetBindGroup(pass_encoder, bg_idx, bg, 0, NULL);
+                wgpuRenderPassEncoderSetBindGroup(
+                  pass_encoder, bg_idx, bg, dynamic_offset_count, dynamic_offsets);
             }
 
             // set vertex buffer
@@ -2001,16 +2685,25 @@ struct G_DrawCallList {
             }
 
             // set index buffer
-            if (draw_indexed) {
+            if (draw_indexed && d->indirect_buffer) {
+                wgpuRenderPassEncoderSetIndexBuffer(
+                  pass_encoder, d->index_buffer, WGPUIndexFormat_Uint32,
+                  d->index_buffer_offset, d->index_buffer_size);
+                wgpuRenderPassEncoderDrawIndexedIndirect(
+                  pass_encoder, d->indirect_buffer, d->indirect_offset);
+            } else if (draw_indexed) {
                 wgpuRenderPassEncoderSetIndexBuffer(
                   pass_encoder, d->index_buffer, WGPUIndexFormat_Uint32,
                   d->index_buffer_offset, d->index_buffer_size);
                 wgpuRenderPassEncoderDrawIndexed(
                   pass_encoder, MIN(d->index_count, d->index_buffer_size / 4),
-                  d->instance_count, 0, 0, 0);
+                  d->instance_count, 0, 0, d->first_instance);
+            } else if (d->indirect_buffer) {
+                wgpuRenderPassEncoderDrawIndirect(pass_encoder, d->indirect_buffer,
+                                                  d->indirect_offset);
             } else if (d->vertex_count > 0) {
                 wgpuRenderPassEncoderDraw(pass_encoder, d->vertex_count,
-                                          d->instance_count, 0, 0);
+                                          d->instance_count, 0, d->first_instance);
             }
         }
     }
@@ -2043,6 +2736,17 @@ struct G_RenderTarget {
 typedef int G_DrawCallListID;
 typedef int G_DrawCallID;
 
+// frame-local texture declared with G_Graph::transientTexture(). 0 is invalid
+typedef int G_TransientTextureID;
+
+// physical texture backing one or more (aliased) transient textures
+struct G_TransientTexture {
+    G_GraphTransientDesc desc;
+    WGPUTexture texture;
+    int frames_till_expired;
+    b32 in_use; // claimed this frame
+};
+
 struct G_RenderPassParams {
 
     // union { (just dont wanna type it)
@@ -2063,6 +2767,10 @@ struct G_RenderPassParams {
 
     G_CacheTextureViewDesc _depth_target;
 
+    // if nonzero, used instead of color_target / _depth_target
+    G_TransientTextureID color_target_transient;
+    G_TransientTextureID depth_target_transient;
+
     float viewport_x;
     float viewport_y;
     float viewport_w;
@@ -2078,10 +2786,20 @@ struct G_RenderPassParams {
     G_DrawCallListID drawcall_list_id;
 };
 
+struct G_ComputeDispatch {
+    u32 x, y, z;            // workgroup count
+    u32 bg_start, bg_count; // bindgroup entries
+};
+
 struct G_ComputePassParams {
     WGPUShaderModule module;
-    u32 x, y, z;            // workgroup size
-    u32 bg_start, bg_count; // bindgroup entries
+    u32 dispatch_start, dispatch_count; // G_ComputeDispatch in G_Graph::dispatch_list
+};
+
+// a pipeline to compile against the targets of the pass that owns dc_list
+struct G_PipelinePrewarm {
+    G_DrawCallListID dc_list;
+    G_DrawCallPipelineDesc desc;
 };
 
 struct G_Pass {
@@ -2093,9 +2811,10 @@ struct G_Pass {
     };
 };
 
-struct G_Graph {
-    G_Cache cache;
-
+// draws and the bindgroup entries they bind. G_Graph records into its own, scene
+// pass workers record into private ones that are appended to the graph's in order
+// (see draw_jobs.h)
+struct G_DrawRecorder {
     Arena bind_group_entry_list[CHUGL_MAX_BINDGROUPS]; // type G_CacheBindGroupEntry
 
     // drawcall pool
@@ -2103,18 +2822,190 @@ struct G_Graph {
     G_DrawCall* current_draw;
     G_DrawCall template_draw;
 
+    // adds a draw without counting it towards a drawcall list
+    G_DrawCall* pushDraw()
+    {
+        G_DrawCall* draw = ARENA_PUSH_ZERO_TYPE(&drawcall_pool, G_DrawCall);
+
+        for (int i = 0; i < CHUGL_MAX_BINDGROUPS; i++) {
+            draw->bg_list[i].start
+              = ARENA_LENGTH(bind_group_entry_list + i, G_CacheBindGroupEntry);
+        }
+
+        current_draw = draw;
+        return draw;
+    }
+
+    // adds a draw, copying everything from template_draw
+    G_DrawCall* pushTemplatedDraw()
+    {
+        G_DrawCall* d = pushDraw();
+        *d            = template_draw;
+        return d;
+    }
+
+    G_DrawCall* templateDraw()
+    {
+        template_draw = {};
+
+        // init bindgroup starts
+        for (int i = 0; i < CHUGL_MAX_BINDGROUPS; i++) {
+            template_draw.bg_list[i].start
+              = ARENA_LENGTH(bind_group_entry_list + i, G_CacheBindGroupEntry);
+        }
+
+        current_draw = &template_draw;
+        return &template_draw;
+    }
+
+    void vertexBuffer(G_DrawCall* d, int slot, WGPUBuffer buffer, u64 offset, u64 size)
+    {
+        ASSERT(d == current_draw);
+        d->vertex_buffer_list[slot] = { buffer, offset, size };
+    }
+
+    void bindBuffer(G_DrawCall* d, int group, int binding, WGPUBuffer buffer,
+                    u32 offset, u32 size)
+    {
+        ASSERT(d == current_draw);
+        G_CacheBindGroupEntry* entry
+          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
+        entry->type      = G_CacheBindGroupEntryType_Buffer;
+        entry->binding   = binding;
+        entry->as.buffer = { buffer, offset, size };
+
+        ++d->bg_list[group].count;
+    }
+
+    void bindSampler(G_DrawCall* d, int group, int binding, WGPUSampler sampler)
+    {
+        ASSERT(d == current_draw);
+        G_CacheBindGroupEntry* entry
+          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
+        entry->type       = G_CacheBindGroupEntryType_Sampler;
+        entry->binding    = binding;
+        entry->as.sampler = sampler;
+
+        ++d->bg_list[group].count;
+    }
+
+    void bindTexture(G_DrawCall* d, int group, int binding, G_CacheTextureViewDesc desc)
+    {
+        ASSERT(d == current_draw);
+        G_CacheBindGroupEntry* entry
+          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
+        entry->type                 = G_CacheBindGroupEntryType_TextureView;
+        entry->binding              = binding;
+        entry->as.texture_view_desc = desc;
+
+        ++d->bg_list[group].count;
+    }
+
+    // marks @group(group) of d as owned by `slots`. Entries must still be bound as
+    // usual, they are used on a slot miss and for rendergraph dependencies
+    void persistentBindGroup(G_DrawCall* d, int group, G_BindGroupSlots* slots,
+                             u64 version)
+    {
+        ASSERT(d == current_draw);
+        d->bg_slots[group]        = slots;
+        d->bg_slot_version[group] = version;
+    }
+
+    // appends src's draws and their entries, leaving src untouched
+    void append(G_DrawRecorder* src)
+    {
+        DrawListLayout layout  = {};
+        layout.draw_size       = sizeof(G_DrawCall);
+        layout.entry_size      = sizeof(G_CacheBindGroupEntry);
+        layout.group_count     = CHUGL_MAX_BINDGROUPS;
+        layout.bg_start_offset = offsetof(G_DrawCall, bg_list);
+        layout.bg_stride       = sizeof(((G_DrawCall*)0)->bg_list[0]);
+        DrawList_Append(&layout, &drawcall_pool, bind_group_entry_list,
+                        &src->drawcall_pool, src->bind_group_entry_list);
+        current_draw = NULL;
+    }
+
+    void clear()
+    {
+        current_draw = NULL;
+        Arena::clear(&drawcall_pool);
+        for (int i = 0; i < ARRAY_LENGTH(bind_group_entry_list); i++) {
+            Arena::clear(bind_group_entry_list + i);
+        }
+    }
+};
+
+// per pass GPU timestamps for GG.profile(), see R_GpuTimer in app.cpp
+struct G_GraphTimestamps {
+    WGPUQuerySet query_set; // 2 per pass, beginning and end
+    int pass_count;         // passes timed this frame
+    char pass_names[CHUGL_RENDERGRAPH_MAX_PASSES][PROFILER_NAME_SIZE];
+};
+
+struct G_Graph : public G_DrawRecorder {
+    G_Cache cache;
+
     G_DrawCallList drawcall_list_pool[CHUGL_RENDERGRAPH_MAX_PASSES];
     int drawcall_list_count;
 
+    Arena prewarm_list; // G_PipelinePrewarm
+
     // pass pool
     G_Pass pass_list[CHUGL_RENDERGRAPH_MAX_PASSES];
     int pass_count;
 
+    Arena dispatch_list;  // G_ComputeDispatch
+    int compute_pass_idx; // pass that computePassBind*() and dispatches go to
+
+    // transient textures declared this frame, indexed by G_TransientTextureID - 1
+    G_GraphTransientDesc transient_list[CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES];
+    int transient_count;
+
+    // physical textures, assigned to transients after graph compilation
+    G_TransientTexture transient_pool[CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES];
+    WGPUTexture transient_textures[CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES];
+
+    G_GraphCompiler compiler;
+    G_GraphStats frame_stats; // stats of the last executed frame
+
     void init()
     {
+        static_assert(CHUGL_RENDERGRAPH_MAX_PASSES <= G_GRAPH_MAX_PASSES,
+                      "rendergraph passes exceed graph compiler capacity");
         cache.init();
     }
 
+    // transient textures ======================================
+    // Declares a texture that only lives for this frame. Its memory is aliased
+    // with other transients whose lifetimes don't overlap, and it is never
+    // allocated if every pass that uses it is culled. Contents are undefined at
+    // the start of the frame, so it must be cleared before it is read.
+    // Currently can only be used as a render pass attachment
+    G_TransientTextureID transientTexture(WGPUTextureFormat format, u32 width,
+                                          u32 height, u32 sample_count,
+                                          WGPUTextureUsageFlags usage)
+    {
+        if (transient_count == CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES) {
+            log_error("Reached max transient texture count %d", transient_count);
+            return 0;
+        }
+        G_GraphTransientDesc* desc = &transient_list[transient_count++];
+        *desc                      = {};
+        desc->width                = width;
+        desc->height               = height;
+        desc->format               = format;
+        desc->sample_count         = sample_count;
+        desc->usage                = usage;
+        desc->bytes_per_sample     = G_bytesPerTexel(format);
+        return transient_count;
+    }
+
+    G_GraphTransientDesc* transientDesc(G_TransientTextureID id)
+    {
+        ASSERT(id > 0 && id <= transient_count);
+        return &transient_list[id - 1];
+    }
+
     // renderpass methods ======================================
     void addRenderPass(const char* pass_name)
     {
@@ -2179,6 +3070,18 @@ struct G_Graph {
         pass->rp.color_target_sample_count = wgpuTextureGetSampleCount(tex);
     }
 
+    void renderPassColorTargetTransient(G_TransientTextureID id)
+    {
+        G_Pass* pass = pass_list + (pass_count - 1);
+        ASSERT(pass->type == G_PassType_Render);
+
+        WGPU_RELEASE_RESOURCE(TextureView, pass->rp.color_target.texture_view);
+
+        pass->rp.color_target_is_external_view = false;
+        pass->rp.color_target_transient        = id;
+        pass->rp.color_target_sample_count     = transientDesc(id)->sample_count;
+    }
+
     void renderPassResolveTarget(WGPUTexture tex, int mip_level)
     {
         G_Pass* pass = pass_list + (pass_count - 1);
@@ -2219,6 +3122,15 @@ struct G_Graph {
         renderPassDepthTarget(tex, 0, 1);
     }
 
+    void renderPassDepthTargetTransient(G_TransientTextureID id)
+    {
+        G_Pass* pass = pass_list + (pass_count - 1);
+        ASSERT(pass->type == G_PassType_Render);
+        ASSERT(G_Util::isDepthTextureFormat(
+          (WGPUTextureFormat)transientDesc(id)->format));
+        pass->rp.depth_target_transient = id;
+    }
+
     // returns aspect of viewport
     float viewport(float x, float y, float w, float h, WGPUTexture target)
     {
@@ -2238,6 +3150,15 @@ struct G_Graph {
         return pass->rp.viewport_w / pass->rp.viewport_h;
     }
 
+    // viewport (x, y, w, h) in pixels of the current render pass
+    glm::vec4 currentViewport()
+    {
+        G_Pass* pass = pass_list + (pass_count - 1);
+        ASSERT(pass->type == G_PassType_Render && pass->rp.viewport_custom);
+        return glm::vec4(pass->rp.viewport_x, pass->rp.viewport_y, pass->rp.viewport_w,
+                         pass->rp.viewport_h);
+    }
+
     void scissor(float x, float y, float w, float h, WGPUTexture target)
     {
         G_Pass* pass = pass_list + (pass_count - 1);
@@ -2268,108 +3189,99 @@ struct G_Graph {
         ASSERT(dc_list == drawcall_list_count - 1);
 
         ++drawcall_list_pool[dc_list].drawcall_count;
-        G_DrawCall* draw = ARENA_PUSH_ZERO_TYPE(&drawcall_pool, G_DrawCall);
-
-        for (int i = 0; i < CHUGL_MAX_BINDGROUPS; i++) {
-            draw->bg_list[i].start
-              = ARENA_LENGTH(bind_group_entry_list + i, G_CacheBindGroupEntry);
-        }
-
-        current_draw = draw;
-        return draw;
+        return pushDraw();
     }
 
-    G_DrawCall* templateDraw()
+    // counts draws recorded with pushDraw() or append() since dc_list was added
+    void countRecordedDraws(G_DrawCallListID dc_list)
     {
-        template_draw = {};
-
-        // init bindgroup starts
-        for (int i = 0; i < CHUGL_MAX_BINDGROUPS; i++) {
-            template_draw.bg_list[i].start
-              = ARENA_LENGTH(bind_group_entry_list + i, G_CacheBindGroupEntry);
-        }
-
-        current_draw = &template_draw;
-        return &template_draw;
-    }
-
-    void vertexBuffer(G_DrawCall* d, int slot, WGPUBuffer buffer, u64 offset, u64 size)
-    {
-        ASSERT(d == current_draw);
-        d->vertex_buffer_list[slot] = { buffer, offset, size };
+        ASSERT(dc_list == drawcall_list_count - 1);
+        G_DrawCallList* list = drawcall_list_pool + dc_list;
+        list->drawcall_count
+          = ARENA_LENGTH(&drawcall_pool, G_DrawCall) - list->drawcall_start_idx;
     }
 
-    void bindBuffer(G_DrawCall* d, int group, int binding, WGPUBuffer buffer,
-                    u32 offset, u32 size)
+    // compiles the pipeline a draw with this pso would use in the pass that owns
+    // dc_list, without drawing anything
+    void prewarmPipeline(G_DrawCallListID dc_list, SG_ID sg_shader_id,
+                         WGPUCullMode cull_mode,
+                         WGPUPrimitiveTopology primitive_topology,
+                         WGPUBlendState* blend_state, bool is_transparent)
     {
-        ASSERT(d == current_draw);
-        G_CacheBindGroupEntry* entry
-          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
-        entry->type      = G_CacheBindGroupEntryType_Buffer;
-        entry->binding   = binding;
-        entry->as.buffer = { buffer, offset, size };
-
-        ++d->bg_list[group].count;
+        G_DrawCall d = {};
+        d.pipelineDesc(sg_shader_id, cull_mode, primitive_topology, blend_state,
+                       is_transparent);
+
+        G_PipelinePrewarm* prewarm
+          = ARENA_PUSH_ZERO_TYPE(&prewarm_list, G_PipelinePrewarm);
+        prewarm->dc_list = dc_list;
+        COPY_STRUCT(&prewarm->desc, &d._pipeline_desc);
     }
 
-    void bindSampler(G_DrawCall* d, int group, int binding, WGPUSampler sampler)
+    // the dispatch that computePassBind*() add entries to
+    G_ComputeDispatch* currentDispatch()
     {
-        ASSERT(d == current_draw);
-        G_CacheBindGroupEntry* entry
-          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
-        entry->type       = G_CacheBindGroupEntryType_Sampler;
-        entry->binding    = binding;
-        entry->as.sampler = sampler;
-
-        ++d->bg_list[group].count;
-    }
-
-    void bindTexture(G_DrawCall* d, int group, int binding, G_CacheTextureViewDesc desc)
-    {
-        ASSERT(d == current_draw);
-        G_CacheBindGroupEntry* entry
-          = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list + group, G_CacheBindGroupEntry);
-        entry->type                 = G_CacheBindGroupEntryType_TextureView;
-        entry->binding              = binding;
-        entry->as.texture_view_desc = desc;
-
-        ++d->bg_list[group].count;
+        G_ComputePassParams* cp = &pass_list[compute_pass_idx].cp;
+        ASSERT(pass_list[compute_pass_idx].type == G_PassType_Compute);
+        ASSERT(cp->dispatch_count > 0
+               && cp->dispatch_start + cp->dispatch_count
+                    == ARENA_LENGTH(&dispatch_list, G_ComputeDispatch));
+        return ARENA_GET_TYPE(&dispatch_list, G_ComputeDispatch,
+                              cp->dispatch_start + cp->dispatch_count - 1);
     }
 
     void computePassBindBuffer(int binding, WGPUBuffer buffer, u32 offset, u32 size)
     {
-        ASSERT(pass_list[pass_count - 1].type == G_PassType_Compute);
+        G_ComputeDispatch* dispatch = currentDispatch();
         G_CacheBindGroupEntry* entry
           = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list, G_CacheBindGroupEntry);
         entry->type      = G_CacheBindGroupEntryType_Buffer;
         entry->binding   = binding;
         entry->as.buffer = { buffer, offset, size };
 
-        ++pass_list[pass_count - 1].cp.bg_count;
+        ++dispatch->bg_count;
     }
 
     void computePassBindSampler(int binding, WGPUSampler sampler)
     {
-        ASSERT(pass_list[pass_count - 1].type == G_PassType_Compute);
+        G_ComputeDispatch* dispatch = currentDispatch();
         G_CacheBindGroupEntry* entry
           = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list, G_CacheBindGroupEntry);
         entry->type       = G_CacheBindGroupEntryType_Sampler;
         entry->binding    = binding;
         entry->as.sampler = sampler;
 
-        ++pass_list[pass_count - 1].cp.bg_count;
+        ++dispatch->bg_count;
     }
 
     void computePassBindTexture(int binding, G_CacheTextureViewDesc view)
     {
-        ASSERT(pass_list[pass_count - 1].type == G_PassType_Compute);
+        G_ComputeDispatch* dispatch = currentDispatch();
         G_CacheBindGroupEntry* entry
           = ARENA_PUSH_ZERO_TYPE(bind_group_entry_list, G_CacheBindGroupEntry);
         entry->type                 = G_CacheBindGroupEntryType_TextureView;
         entry->binding              = binding;
         entry->as.texture_view_desc = view;
 
-        ++pass_list[pass_count - 1].cp.bg_count;
+        ++dispatch->bg_count;
+    }
+
+    // adds another dispatch of the current compute pass, with its own bindgroup.
+    // Bindings added after this go to it
+    void computePassDispatch(u32 x, u32 y, u32 z)
+    {
+        G_ComputePassParams* cp = &pass_list[compute_pass_idx].cp;
+        ASSERT(pass_list[compute_pass_idx].type == G_PassType_Compute);
+        ASSERT(cp->dispatch_start + cp->dispatch_count
+               == ARENA_LENGTH(&dispatch_list, G_ComputeDispatch));
+
+        G_ComputeDispatch* dispatch
+          = ARENA_PUSH_ZERO_TYPE(&dispatch_list, G_ComputeDispatch);
+        *dispatch
+          = { x, y, z,
+              (u32)ARENA_LENGTH(&bind_group_entry_list[0], G_CacheBindGroupEntry),
+              0 };
+        ++cp->dispatch_count;
     }
 
     void addComputePass(const char* name, WGPUShaderModule module, u32 x, u32 y, u32 z)
@@ -2382,20 +3294,242 @@ struct G_Graph {
         COPY_STRING(compute_pass->name, name);
         compute_pass->type = G_PassType_Compute;
         compute_pass->cp
-          = { module,
-              x,
-              y,
-              z,
-              (u32)ARENA_LENGTH(&bind_group_entry_list[0], G_CacheBindGroupEntry),
-              0 };
+          = { module, (u32)ARENA_LENGTH(&dispatch_list, G_ComputeDispatch), 0 };
+        compute_pass_idx = pass_count - 1;
+        computePassDispatch(x, y, z);
+    }
+
+    // adds a compute pass with no dispatches that runs right before the render pass
+    // being recorded, e.g. to cull its instances. The render pass stays the current
+    // one, so it can still be recorded into. Returns false if there's no room
+    bool insertComputePass(const char* name, WGPUShaderModule module)
+    {
+        if (pass_count == CHUGL_RENDERGRAPH_MAX_PASSES) {
+            log_error("Reached max pass count %d", pass_count);
+            return false;
+        }
+        ASSERT(pass_count > 0 && pass_list[pass_count - 1].type == G_PassType_Render);
+        pass_list[pass_count] = pass_list[pass_count - 1];
+
+        G_Pass* compute_pass = &pass_list[pass_count - 1];
+        *compute_pass        = {};
+        COPY_STRING(compute_pass->name, name);
+        compute_pass->type = G_PassType_Compute;
+        compute_pass->cp
+          = { module, (u32)ARENA_LENGTH(&dispatch_list, G_ComputeDispatch), 0 };
+        compute_pass_idx = pass_count - 1;
+        ++pass_count;
+        return true;
     }
 
-    void executeAndReset(WGPUDevice device, WGPUCommandEncoder command_encoder)
+    // describes every recorded pass to the graph compiler by the resources it
+    // reads and writes, then compiles to find culled passes and transient aliasing
+    void compile()
     {
+        compiler.reset();
+
+        // transients are keyed by id and registered first, so resource index is
+        // always id - 1. Persistent resources are keyed by their WGPUTexture or
+        // WGPUTextureView address, which can't collide with the small ids
+        for (int i = 0; i < transient_count; i++) {
+            int idx = compiler.transientResource(i + 1, &transient_list[i]);
+            ASSERT(idx == i);
+        }
+
+        for (int i = 0; i < pass_count; i++) {
+            G_Pass* pass = &pass_list[i];
+
+            // compute passes write storage buffers/textures we don't track
+            int node = compiler.addPass(pass->type != G_PassType_Render);
+            ASSERT(node == i);
+
+            if (pass->type == G_PassType_Render) {
+                G_RenderPassParams* rp = &pass->rp;
+
+                int color = -1;
+                if (rp->color_target_transient) {
+                    color = rp->color_target_transient - 1;
+                } else if (rp->color_target_is_external_view) {
+                    if (rp->color_target.texture_view)
+                        color = compiler.persistentResource(
+                          (u64)rp->color_target.texture_view);
+                } else if (rp->color_target_view_desc.texture) {
+                    color = compiler.persistentResource(
+                      (u64)rp->color_target_view_desc.texture);
+                }
+                if (color >= 0) {
+                    compiler.write(node, color);
+                    // loading the previous contents is a read
+                    if (rp->color_load_op == WGPULoadOp_Load) {
+                        compiler.read(node, color);
+                    }
+                }
+
+                if (rp->resolve_target_is_external_view) {
+                    if (rp->resolve_target.texture_view)
+                        compiler.write(node, compiler.persistentResource(
+                                               (u64)rp->resolve_target.texture_view));
+                } else if (rp->resolve_target_view_desc.texture) {
+                    compiler.write(node, compiler.persistentResource(
+                                           (u64)rp->resolve_target_view_desc.texture));
+                }
+
+                // depth is always cleared on load, so only a write
+                if (rp->depth_target_transient) {
+                    compiler.write(node, rp->depth_target_transient - 1);
+                } else if (rp->_depth_target.texture) {
+                    compiler.write(node,
+                                   compiler.persistentResource(
+                                     (u64)rp->_depth_target.texture));
+                }
+            }
+
+            // textures sampled by this pass. Only textures written by an earlier
+            // pass this frame can create a dependency, so only look those up
+            if (pass->type == G_PassType_Render) {
+                G_DrawCallList* list = &drawcall_list_pool[pass->rp.drawcall_list_id];
+                for (int d = 0; d < list->drawcall_count; d++) {
+                    G_DrawCall* draw = ARENA_GET_TYPE(&drawcall_pool, G_DrawCall,
+                                                      list->drawcall_start_idx + d);
+                    for (int g = 0; g < CHUGL_MAX_BINDGROUPS; g++) {
+                        _compileReads(node, bind_group_entry_list + g,
+                                      draw->bg_list[g].start, draw->bg_list[g].count);
+                    }
+                }
+            } else if (pass->type == G_PassType_Compute) {
+                for (u32 d = 0; d < pass->cp.dispatch_count; d++) {
+                    G_ComputeDispatch* dispatch = ARENA_GET_TYPE(
+                      &dispatch_list, G_ComputeDispatch, pass->cp.dispatch_start + d);
+                    _compileReads(node, bind_group_entry_list, dispatch->bg_start,
+                                  dispatch->bg_count);
+                }
+            }
+        }
+
+        compiler.compile();
+
+        // report transient memory whenever it changes
+        if (memcmp(&frame_stats, &compiler.stats, sizeof(frame_stats)) != 0) {
+            frame_stats = compiler.stats;
+            frame_stats.log();
+        }
+    }
+
+    void _compileReads(int node, Arena* entries, int start, int count)
+    {
+        for (int e = 0; e < count; e++) {
+            G_CacheBindGroupEntry* entry
+              = ARENA_GET_TYPE(entries, G_CacheBindGroupEntry, start + e);
+            if (entry->type != G_CacheBindGroupEntryType_TextureView) continue;
+
+            int resource
+              = compiler.findResource((u64)entry->as.texture_view_desc.texture);
+            if (resource >= 0) compiler.read(node, resource);
+        }
+    }
+
+    // backs each of the compiled graph's physical textures with a pooled texture
+    void assignTransientTextures(WGPUDevice device)
+    {
+        static char label[128] = {};
+
+        WGPUTexture physical_textures[CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES] = {};
+        ASSERT(compiler.physical_count <= CHUGL_RENDERGRAPH_MAX_TRANSIENT_TEXTURES);
+
+        for (int s = 0; s < compiler.physical_count; s++) {
+            G_GraphTransientDesc* desc = &compiler.physical[s];
+
+            G_TransientTexture* match = NULL;
+            G_TransientTexture* empty = NULL;
+            for (int p = 0; p < ARRAY_LENGTH(transient_pool); p++) {
+                G_TransientTexture* pooled = &transient_pool[p];
+                if (pooled->texture == NULL) {
+                    if (!empty) empty = pooled;
+                } else if (!pooled->in_use
+                           && memcmp(&pooled->desc, desc, sizeof(*desc)) == 0) {
+                    match = pooled;
+                    break;
+                }
+            }
+
+            if (!match) {
+                if (!empty) {
+                    // pool is full, evict any texture not used this frame. There is
+                    // always one because pool size == max transients per frame
+                    for (int p = 0; p < ARRAY_LENGTH(transient_pool); p++) {
+                        if (!transient_pool[p].in_use) {
+                            empty = &transient_pool[p];
+                            WGPU_RELEASE_RESOURCE(Texture, empty->texture);
+                            break;
+                        }
+                    }
+                }
+                ASSERT(empty);
+
+                WGPUTextureFormat format = (WGPUTextureFormat)desc->format;
+                snprintf(label, sizeof(label), "Transient Texture %ux%u %ux %s",
+                         desc->width, desc->height, desc->sample_count,
+                         G_Util::textureFormatToString(format));
+
+                WGPUTextureDescriptor texture_desc = {};
+                texture_desc.label                 = label;
+                texture_desc.size                  = { desc->width, desc->height, 1 };
+                texture_desc.mipLevelCount         = 1;
+                texture_desc.sampleCount           = desc->sample_count;
+                texture_desc.dimension             = WGPUTextureDimension_2D;
+                texture_desc.format                = format;
+                texture_desc.usage                 = desc->usage;
+
+                empty->desc    = *desc;
+                empty->texture = wgpuDeviceCreateTexture(device, &texture_desc);
+                ASSERT(empty->texture);
+                match = empty;
+
+                log_trace("Creating %s, address: %p", label, (void*)match->texture);
+            }
+
+            match->in_use = true;
+            match->frames_till_expired
+              = CHUGL_RENDERGRAPH_TRANSIENT_FRAMES_TILL_EXPIRED;
+            physical_textures[s] = match->texture;
+        }
+
+        for (int i = 0; i < transient_count; i++) {
+            int physical_idx = compiler.resources[i].physical_idx;
+            transient_textures[i]
+              = physical_idx >= 0 ? physical_textures[physical_idx] : NULL;
+        }
+    }
+
+    WGPUTexture transientTextureGPU(G_TransientTextureID id)
+    {
+        ASSERT(id > 0 && id <= transient_count);
+        ASSERT(transient_textures[id - 1]);
+        return transient_textures[id - 1];
+    }
+
+    // first of the pass's 2 timestamp queries
+    static u32 beginTimestamps(G_GraphTimestamps* timestamps, G_Pass* pass)
+    {
+        static_assert(sizeof(pass->name) == PROFILER_NAME_SIZE, "pass name size");
+        int query = timestamps->pass_count++;
+        memcpy(timestamps->pass_names[query], pass->name, PROFILER_NAME_SIZE);
+        return 2 * query;
+    }
+
+    // `timestamps`, if not NULL, records the GPU time of every pass
+    void executeAndReset(WGPUDevice device, WGPUCommandEncoder command_encoder,
+                         G_GraphTimestamps* timestamps = NULL)
+    {
+        compile();
+        assignTransientTextures(device);
+        if (timestamps) timestamps->pass_count = 0;
+
         // TODO add debug labels
-        // TODO add profiling/timing
         for (int i = 0; i < pass_count; i++) {
             G_Pass* pass = &this->pass_list[i];
+            if (compiler.passes[i].culled) continue;
+
             switch (pass->type) {
                 case G_PassType_None: break;
                 case G_PassType_Render: {
@@ -2408,6 +3542,15 @@ struct G_Graph {
                     WGPUTextureFormat color_format = WGPUTextureFormat_Undefined;
                     WGPUTextureFormat depth_format = WGPUTextureFormat_Undefined;
 
+                    if (pass->rp.color_target_transient) {
+                        pass->rp.color_target_view_desc
+                          = { transientTextureGPU(pass->rp.color_target_transient) };
+                    }
+                    if (pass->rp.depth_target_transient) {
+                        pass->rp._depth_target
+                          = { transientTextureGPU(pass->rp.depth_target_transient) };
+                    }
+
                     bool has_color_target
                       = (pass->rp.color_target_is_external_view ?
                            pass->rp.color_target.texture_view != NULL :
@@ -2466,6 +3609,13 @@ struct G_Graph {
 
                     // render_pass_desc.label = pass->sg_pass.name; // TODO
 
+                    WGPURenderPassTimestampWrites timestamp_writes = {};
+                    if (timestamps) {
+                        u32 query = beginTimestamps(timestamps, pass);
+                        timestamp_writes = { timestamps->query_set, query, query + 1 };
+                        render_pass_desc.timestampWrites = &timestamp_writes;
+                    }
+
                     WGPURenderPassEncoder render_pass_encoder
                       = wgpuCommandEncoderBeginRenderPass(command_encoder,
                                                           &render_pass_desc);
@@ -2487,36 +3637,57 @@ struct G_Graph {
                       device, render_pass_encoder, color_format, depth_format,
                       pass->rp.color_target_sample_count, &cache, &drawcall_pool,
                       bind_group_entry_list, pass->name);
+
+                    for (int p = 0; p < ARENA_LENGTH(&prewarm_list, G_PipelinePrewarm);
+                         p++) {
+                        G_PipelinePrewarm* prewarm
+                          = ARENA_GET_TYPE(&prewarm_list, G_PipelinePrewarm, p);
+                        if (prewarm->dc_list != pass->rp.drawcall_list_id) continue;
+                        cache.renderPipeline(
+                          {
+                            prewarm->desc,
+                            color_format,
+                            depth_format,
+                            pass->rp.color_target_sample_count,
+                          },
+                          device);
+                    }
                     wgpuRenderPassEncoderEnd(render_pass_encoder);
                     WGPU_RELEASE_RESOURCE(RenderPassEncoder, render_pass_encoder);
-
-                    WGPU_RELEASE_RESOURCE(TextureView,
-                                          pass->rp.color_target.texture_view);
-                    WGPU_RELEASE_RESOURCE(TextureView,
-                                          pass->rp.resolve_target.texture_view);
                 } break;
                 case G_PassType_Compute: {
                     G_CacheComputePipeline cp
                       = cache.computePipeline(pass->cp.module, device, NULL);
                     WGPUComputePassDescriptor cp_desc = {};
                     cp_desc.label                     = pass->name;
+                    WGPUComputePassTimestampWrites timestamp_writes = {};
+                    if (timestamps) {
+                        u32 query = beginTimestamps(timestamps, pass);
+                        timestamp_writes = { timestamps->query_set, query, query + 1 };
+                        cp_desc.timestampWrites = &timestamp_writes;
+                    }
                     WGPUComputePassEncoder compute_pass
-                      = wgpuCommandEncoderBeginComputePass(command_encoder, NULL);
+                      = wgpuCommandEncoderBeginComputePass(command_encoder, &cp_desc);
                     wgpuComputePassEncoderSetPipeline(compute_pass, cp.val.pipeline);
 
                     const int compute_pass_binding_location = 0;
-                    WGPUBindGroup bg                        = cache.bindGroup(
-                      device,
-                      ARENA_GET_TYPE(bind_group_entry_list, G_CacheBindGroupEntry,
-                                                            pass->cp.bg_start),
-                      pass->cp.bg_count, cp.val.bind_group_layout,
-                      compute_pass_binding_location, pass->name);
-                    wgpuComputePassEncoderSetBindGroup(
-                      compute_pass, compute_pass_binding_location, bg, 0, NULL);
-
-                    // dispatch
-                    wgpuComputePassEncoderDispatchWorkgroups(compute_pass, pass->cp.x,
-                                                             pass->cp.y, pass->cp.z);
+                    for (u32 d = 0; d < pass->cp.dispatch_count; d++) {
+                        G_ComputeDispatch* dispatch
+                          = ARENA_GET_TYPE(&dispatch_list, G_ComputeDispatch,
+                                           pass->cp.dispatch_start + d);
+                        WGPUBindGroup bg = cache.bindGroup(
+                          device,
+                          ARENA_GET_TYPE(bind_group_entry_list, G_CacheBindGroupEntry,
+                                         dispatch->bg_start),
+                          dispatch->bg_count, cp.val.bind_group_layout,
+                          compute_pass_binding_location, pass->name);
+                        wgpuComputePassEncoderSetBindGroup(
+                          compute_pass, compute_pass_binding_location, bg, 0, NULL);
+
+                        // dispatch
+                        wgpuComputePassEncoderDispatchWorkgroups(
+                          compute_pass, dispatch->x, dispatch->y, dispatch->z);
+                    }
 
                     // cleanup
                     wgpuComputePassEncoderEnd(compute_pass);
@@ -2533,14 +3704,39 @@ struct G_Graph {
             Arena::clear(bind_group_entry_list + i);
         }
 
+        // includes culled passes
+        for (int i = 0; i < pass_count; i++) {
+            if (pass_list[i].type != G_PassType_Render) continue;
+            G_RenderPassParams* rp = &pass_list[i].rp;
+            WGPU_RELEASE_RESOURCE(TextureView, rp->color_target.texture_view);
+            WGPU_RELEASE_RESOURCE(TextureView, rp->resolve_target.texture_view);
+        }
+
         ZERO_ARRAY(pass_list);
         pass_count = 0;
 
+        ZERO_ARRAY(transient_textures);
+        transient_count = 0;
+
+        // release pooled transient textures that have gone unused
+        for (int i = 0; i < ARRAY_LENGTH(transient_pool); i++) {
+            G_TransientTexture* pooled = &transient_pool[i];
+            if (pooled->texture && !pooled->in_use
+                && --pooled->frames_till_expired <= 0) {
+                log_trace("Releasing expired transient texture %p",
+                          (void*)pooled->texture);
+                WGPU_RELEASE_RESOURCE(Texture, pooled->texture);
+            }
+            pooled->in_use = false;
+        }
+
         ZERO_ARRAY(drawcall_list_pool);
         drawcall_list_count = 0;
 
         // TODO ==optimize== add bindgroup pool
         Arena::clear(&drawcall_pool);
+        Arena::clear(&prewarm_list);
+        Arena::clear(&dispatch_list);
 
         cache.update();
     }
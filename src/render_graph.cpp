@@ -0,0 +1,225 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "render_graph.h"
+#include "core/log.h"
+
+#include <string.h>
+
+void G_GraphStats::log()
+{
+    log_trace("\n"
+              "Render Graph Passes: %d (%d culled)\n"
+              "Transient Textures: %d (%llu bytes)\n"
+              "Physical Textures: %d (%llu bytes)\n",
+              passes, passes_culled, transient_textures,
+              (unsigned long long)transient_bytes, physical_textures,
+              (unsigned long long)physical_bytes);
+}
+
+void G_GraphCompiler::reset()
+{
+    pass_count     = 0;
+    resource_count = 0;
+    physical_count = 0;
+    stats          = {};
+}
+
+int G_GraphCompiler::addPass(bool side_effect)
+{
+    if (pass_count >= G_GRAPH_MAX_PASSES) return -1;
+    G_GraphPassNode* pass = &passes[pass_count];
+    *pass                 = {};
+    pass->side_effect     = side_effect;
+    return pass_count++;
+}
+
+static int _G_GraphCompiler_AddResource(G_GraphCompiler* graph, u64 key)
+{
+    if (graph->resource_count >= G_GRAPH_MAX_RESOURCES) return -1;
+    G_GraphResource* resource = &graph->resources[graph->resource_count];
+    *resource                 = {};
+    resource->key             = key;
+    return graph->resource_count++;
+}
+
+int G_GraphCompiler::findResource(u64 key)
+{
+    for (int i = 0; i < resource_count; i++) {
+        if (resources[i].key == key) return i;
+    }
+    return -1;
+}
+
+int G_GraphCompiler::persistentResource(u64 key)
+{
+    int idx = findResource(key);
+    if (idx < 0) idx = _G_GraphCompiler_AddResource(this, key);
+    return idx;
+}
+
+int G_GraphCompiler::transientResource(u64 key, G_GraphTransientDesc* desc)
+{
+    int idx = findResource(key);
+    if (idx >= 0) return idx;
+
+    idx = _G_GraphCompiler_AddResource(this, key);
+    if (idx < 0) return -1;
+    resources[idx].transient = true;
+    resources[idx].desc      = *desc;
+    return idx;
+}
+
+void G_GraphCompiler::read(int pass, int resource)
+{
+    if (pass < 0 || pass >= pass_count) return;
+    G_GraphPassNode* node = &passes[pass];
+    if (resource < 0 || node->read_count >= G_GRAPH_MAX_PASS_READS) {
+        // can't track the dependency, so never cull this pass
+        node->side_effect = true;
+        return;
+    }
+    for (int i = 0; i < node->read_count; i++) {
+        if (node->reads[i] == resource) return;
+    }
+    node->reads[node->read_count++] = resource;
+}
+
+void G_GraphCompiler::write(int pass, int resource)
+{
+    if (pass < 0 || pass >= pass_count) return;
+    G_GraphPassNode* node = &passes[pass];
+    if (resource < 0 || node->write_count >= G_GRAPH_MAX_PASS_WRITES) {
+        node->side_effect = true;
+        return;
+    }
+    for (int i = 0; i < node->write_count; i++) {
+        if (node->writes[i] == resource) return;
+    }
+    node->writes[node->write_count++] = resource;
+}
+
+void G_GraphCompiler::compile()
+{
+    stats = {};
+
+    int last_writer[G_GRAPH_MAX_RESOURCES];
+    for (int i = 0; i < resource_count; i++) last_writer[i] = -1;
+
+    // build the DAG. passes are recorded in execution order, so every
+    // dependency points to an earlier pass
+    for (int p = 0; p < pass_count; p++) {
+        G_GraphPassNode* node = &passes[p];
+        node->dep_count       = 0;
+        for (int r = 0; r < node->read_count; r++) {
+            int writer = last_writer[node->reads[r]];
+            if (writer < 0) continue; // written last frame or by the user
+
+            bool found = false;
+            for (int d = 0; d < node->dep_count; d++) {
+                if (node->deps[d] == writer) found = true;
+            }
+            if (!found) node->deps[node->dep_count++] = writer;
+        }
+        for (int w = 0; w < node->write_count; w++) {
+            last_writer[node->writes[w]] = p;
+        }
+    }
+
+    // cull. walk backwards from the roots so each pass is visited after every
+    // pass that could depend on it
+    bool needed[G_GRAPH_MAX_PASSES] = {};
+    for (int p = pass_count - 1; p >= 0; p--) {
+        G_GraphPassNode* node = &passes[p];
+
+        bool root = node->side_effect;
+        for (int w = 0; w < node->write_count && !root; w++) {
+            if (!resources[node->writes[w]].transient) root = true;
+        }
+
+        node->culled = !(root || needed[p]);
+        if (node->culled) continue;
+        for (int d = 0; d < node->dep_count; d++) needed[node->deps[d]] = true;
+    }
+
+    // resource lifetimes over surviving passes
+    for (int i = 0; i < resource_count; i++) {
+        resources[i].first_pass   = -1;
+        resources[i].last_pass    = -1;
+        resources[i].physical_idx = -1;
+    }
+    for (int p = 0; p < pass_count; p++) {
+        G_GraphPassNode* node = &passes[p];
+        if (node->culled) continue;
+        for (int i = 0; i < node->read_count + node->write_count; i++) {
+            G_GraphResource* resource
+              = &resources[i < node->read_count ? node->reads[i] :
+                                                  node->writes[i - node->read_count]];
+            if (resource->first_pass < 0) resource->first_pass = p;
+            resource->last_pass = p;
+        }
+    }
+
+    // alias transients. Resources are visited in order of first use, and take
+    // the first compatible physical texture that is free by then
+    int physical_last_pass[G_GRAPH_MAX_RESOURCES];
+    physical_count = 0;
+    for (int p = 0; p < pass_count; p++) {
+        for (int i = 0; i < resource_count; i++) {
+            G_GraphResource* resource = &resources[i];
+            if (!resource->transient || resource->first_pass != p) continue;
+
+            int slot = -1;
+            for (int s = 0; s < physical_count; s++) {
+                if (physical_last_pass[s] < p
+                    && memcmp(&physical[s], &resource->desc, sizeof(resource->desc))
+                         == 0) {
+                    slot = s;
+                    break;
+                }
+            }
+            if (slot < 0) {
+                slot           = physical_count++;
+                physical[slot] = resource->desc;
+            }
+            physical_last_pass[slot] = resource->last_pass;
+            resource->physical_idx   = slot;
+
+            ++stats.transient_textures;
+            stats.transient_bytes += G_GraphTransientDesc::sizeBytes(&resource->desc);
+        }
+    }
+
+    stats.passes            = pass_count;
+    stats.physical_textures = physical_count;
+    for (int p = 0; p < pass_count; p++) {
+        if (passes[p].culled) ++stats.passes_culled;
+    }
+    for (int s = 0; s < physical_count; s++) {
+        stats.physical_bytes += G_GraphTransientDesc::sizeBytes(&physical[s]);
+    }
+}
@@ -0,0 +1,140 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+/*
+Render graph compilation
+
+Every frame G_Graph records a linear list of passes. Before executing them, it
+describes each pass to a G_GraphCompiler as a set of resource reads and writes,
+and compiles the frame:
+
+1. dependency DAG: each pass depends on the last earlier pass that wrote each
+   resource it reads
+2. pass culling: passes with side effects (compute passes, writes to persistent
+   resources like the swapchain or user textures) are roots. Any pass not
+   reachable from a root through the DAG produces nothing that is consumed,
+   and is culled
+3. transient aliasing: transient resources are frame-local (e.g. scene pass
+   depth buffers, msaa targets). Their lifetime is the span of surviving passes
+   that use them. Transients with identical descriptions and non-overlapping
+   lifetimes are assigned the same physical texture
+
+Resources are identified by an opaque u64 key. The compiler knows nothing about
+WebGPU so it can be tested on the CPU with synthetic passes.
+*/
+
+#define G_GRAPH_MAX_PASSES 64
+#define G_GRAPH_MAX_RESOURCES 256
+#define G_GRAPH_MAX_PASS_READS 32
+#define G_GRAPH_MAX_PASS_WRITES 4
+
+// physical textures can only be shared between transients with identical
+// descriptions. Compared bitwise, so must be zero-initialized
+struct G_GraphTransientDesc {
+    u32 width;
+    u32 height;
+    u32 format; // WGPUTextureFormat
+    u32 sample_count;
+    u32 usage; // WGPUTextureUsageFlags
+    u32 bytes_per_sample;
+
+    static u64 sizeBytes(G_GraphTransientDesc* desc)
+    {
+        return (u64)desc->width * desc->height * desc->sample_count
+               * desc->bytes_per_sample;
+    }
+};
+
+struct G_GraphResource {
+    u64 key;
+    b32 transient;
+    G_GraphTransientDesc desc; // transient only
+
+    // compile output
+    int first_pass; // -1 if not used by any surviving pass
+    int last_pass;
+    int physical_idx; // transient only, index into G_GraphCompiler::physical
+};
+
+struct G_GraphPassNode {
+    b32 side_effect;
+    int reads[G_GRAPH_MAX_PASS_READS]; // resource indices
+    int read_count;
+    int writes[G_GRAPH_MAX_PASS_WRITES];
+    int write_count;
+
+    // compile output
+    int deps[G_GRAPH_MAX_PASS_READS]; // indices of passes this pass depends on
+    int dep_count;
+    b32 culled;
+};
+
+struct G_GraphStats {
+    int passes;
+    int passes_culled;
+    int transient_textures; // transients used by surviving passes
+    int physical_textures;  // after aliasing
+    u64 transient_bytes;    // memory needed without aliasing
+    u64 physical_bytes;     // memory actually used after aliasing
+
+    void log();
+};
+
+struct G_GraphCompiler {
+    G_GraphPassNode passes[G_GRAPH_MAX_PASSES];
+    int pass_count;
+
+    G_GraphResource resources[G_GRAPH_MAX_RESOURCES];
+    int resource_count;
+
+    G_GraphTransientDesc physical[G_GRAPH_MAX_RESOURCES];
+    int physical_count;
+
+    G_GraphStats stats;
+
+    void reset();
+
+    // returns -1 if out of passes
+    int addPass(bool side_effect);
+
+    // find-or-add a resource by key. desc is required for transients.
+    // returns -1 if out of resources
+    int persistentResource(u64 key);
+    int findResource(u64 key); // -1 if not found
+    int transientResource(u64 key, G_GraphTransientDesc* desc);
+
+    // if either the pass or resource is invalid, or the pass has too many
+    // reads/writes, the pass is conservatively marked as having side effects
+    void read(int pass, int resource);
+    void write(int pass, int resource);
+
+    void compile();
+};
@@ -26,7 +26,9 @@
  SOFTWARE.
 -----------------------------------------------------------------------------*/
 #include "sg_command.h"
+#include "profiler.h"
 
+#include "core/convert.h"
 #include "core/macros.h"
 #include "core/spinlock.h"
 
@@ -39,6 +41,12 @@ struct CQ {
     // only held when 1: adding new command and 2:
     // swapping the read/write queues
     spinlock write_q_lock;
+
+    // number of commands reserved (space pushed onto write_q) but not yet
+    // committed (payload not yet written). Swapping must wait for this to reach 0
+    // so the reader never sees a half-written command. See RESERVE_COMMAND
+    std::atomic<int> pending_reservations = { 0 };
+
     Arena* read_q;
     Arena* write_q;
 
@@ -95,6 +103,11 @@ static void _CQ_SwapQueuesImpl(CQ& cq)
     cq.read_q   = cq.write_q;
 
     spinlock::lock(&cq.write_q_lock);
+    // holding the lock prevents new reservations; wait for in-flight ones
+    // (they commit without touching the lock)
+    while (cq.pending_reservations.load(std::memory_order_acquire) > 0) {
+        spinlock::fast_yield();
+    }
     cq.write_q = temp;
     spinlock::unlock(&cq.write_q_lock);
 }
@@ -171,6 +184,24 @@ void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which = false)
         return _CQ_ReadCommandGetOffsetImpl(audio_to_graphics_cq, byte_offset);
 }
 
+// the audio to graphics read queue as bytes, for GG.capture()
+void* CQ_ReadCommandQueueData(u64* size_bytes)
+{
+    *size_bytes = audio_to_graphics_cq.read_q->curr;
+    return audio_to_graphics_cq.read_q->base;
+}
+
+// GG.replay(): a captured frame in place of the one chuck would have written.
+// Only while the read queue is empty, i.e. instead of CQ_SwapQueues()
+void* CQ_ReadCommandQueueLoad(const void* data, u64 size_bytes)
+{
+    Arena* read_q = audio_to_graphics_cq.read_q;
+    ASSERT(read_q->curr == 0);
+    if (size_bytes == 0) return read_q->base;
+    memcpy(Arena::push(read_q, size_bytes), data, size_bytes);
+    return read_q->base;
+}
+
 // ============================================================================
 // Command API
 // ============================================================================
@@ -178,7 +209,12 @@ void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which = false)
 // hack to avoid having to pass the command queue around
 #define cq audio_to_graphics_cq
 
+// GG.profile() times every push from the chuck VM thread, until the end of the
+// pushing function
+#define CQ_PROFILE_ZONE() PROFILE_ZONE(ProfileZone_CommandPush)
+
 #define BEGIN_COMMAND(cmd_type, cmd_enum)                                              \
+    CQ_PROFILE_ZONE();                                                                 \
     spinlock::lock(&cq.write_q_lock);                                                  \
     int __pad = NEXT_MULT8(cq.write_q->curr) - cq.write_q->curr;                       \
     cmd_type* command                                                                  \
@@ -186,6 +222,7 @@ void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which = false)
     command->type = cmd_enum;
 
 #define BEGIN_COMMAND_ADDITIONAL_MEMORY(cmd_type, cmd_enum, additional_bytes)          \
+    CQ_PROFILE_ZONE();                                                                 \
     spinlock::lock(&cq.write_q_lock);                                                  \
     int __pad = NEXT_MULT8(cq.write_q->curr) - cq.write_q->curr;                       \
     cmd_type* command                                                                  \
@@ -196,6 +233,7 @@ void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which = false)
     command->type = cmd_enum;
 
 #define BEGIN_COMMAND_ADDITIONAL_MEMORY_ZERO(cmd_type, cmd_enum, additional_bytes)     \
+    CQ_PROFILE_ZONE();                                                                 \
     spinlock::lock(&cq.write_q_lock);                                                  \
     int __pad = NEXT_MULT8(cq.write_q->curr) - cq.write_q->curr;                       \
     cmd_type* command                                                                  \
@@ -209,6 +247,47 @@ void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which = false)
     command->nextCommandOffset = NEXT_MULT8(cq.write_q->curr);                         \
     spinlock::unlock(&cq.write_q_lock);
 
+/*
+Reserve/commit variant for commands with large payloads that need conversion
+(e.g. chuck f64 array --> f32 / unorm8 texels).
+
+RESERVE_COMMAND pushes the command + payload and releases the lock immediately,
+so the (slow) payload fill happens outside the critical section and the render
+thread is never stuck spinning on write_q_lock while we convert. The swap waits
+for all outstanding reservations to be committed before handing write_q over.
+
+Only valid because all audio_to_graphics commands are pushed from the single
+chuck VM thread: between RESERVE_COMMAND and COMMIT_COMMAND the caller must NOT
+push any other command, which could realloc write_q and invalidate `command` and
+`memory`. Set every command field *before* COMMIT_COMMAND.
+*/
+#define RESERVE_COMMAND_ADDITIONAL_MEMORY(cmd_type, cmd_enum, additional_bytes)        \
+    BEGIN_COMMAND_ADDITIONAL_MEMORY(cmd_type, cmd_enum, additional_bytes)              \
+    u64 memory_offset          = Arena::offsetOf(cq.write_q, memory);                  \
+    command->nextCommandOffset = NEXT_MULT8(cq.write_q->curr);                         \
+    cq.pending_reservations.fetch_add(1, std::memory_order_relaxed);                   \
+    spinlock::unlock(&cq.write_q_lock);
+
+#define COMMIT_COMMAND() cq.pending_reservations.fetch_sub(1, std::memory_order_release);
+
+// scratch space for gathering chuck arrays before bulk conversion.
+// only touched by the chuck VM thread
+static Arena cq_staging_arena = {};
+
+// gathers `count` elements of a chuck float array into contiguous f64 staging
+// memory. Chugin API has no bulk array access, so this is still per-element, but
+// it happens outside the write_q_lock
+static f64* _CQ_GatherCkFloatArray(Chuck_ArrayFloat* ck_array, int count,
+                                   CK_DL_API API)
+{
+    Arena::clear(&cq_staging_arena);
+    f64* staging = ARENA_PUSH_COUNT(&cq_staging_arena, f64, count);
+    for (int i = 0; i < count; i++) {
+        staging[i] = API->object->array_float_get_idx(ck_array, i);
+    }
+    return staging;
+}
+
 void CQ_PushCommand_SetFixedTimestep(int fps)
 {
     BEGIN_COMMAND(SG_Command_SetFixedTimestep, SG_COMMAND_SET_FIXED_TIMESTEP);
@@ -231,6 +310,68 @@ void CQ_PushCommand_SetChuckVMInfo(int srate)
     END_COMMAND();
 }
 
+void CQ_PushCommand_SetFallbackMaterial(SG_Material* material)
+{
+    BEGIN_COMMAND(SG_Command_SetFallbackMaterial, SG_COMMAND_SET_FALLBACK_MATERIAL);
+    command->material_id = material ? material->id : 0;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_SetDestroyBudget(f64 budget_ms)
+{
+    BEGIN_COMMAND(SG_Command_SetDestroyBudget, SG_COMMAND_SET_DESTROY_BUDGET);
+    command->budget_ms = budget_ms;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_SetTextureUploadBudget(u64 budget_bytes)
+{
+    BEGIN_COMMAND(SG_Command_SetTextureUploadBudget,
+                  SG_COMMAND_SET_TEXTURE_UPLOAD_BUDGET);
+    command->budget_bytes = budget_bytes;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_SetPipelined(bool pipelined)
+{
+    BEGIN_COMMAND(SG_Command_SetPipelined, SG_COMMAND_SET_PIPELINED);
+    command->pipelined = pipelined;
+    END_COMMAND();
+}
+
+void CQ_PushCommand_RecordStart(const char* path, SG_ID texture_id)
+{
+    int size_bytes = strlen(path);
+    BEGIN_COMMAND_ADDITIONAL_MEMORY_ZERO(SG_Command_RecordStart, SG_COMMAND_RECORD_START,
+                                         size_bytes + 1);
+    memcpy(memory, path, size_bytes);
+    command->texture_id  = texture_id;
+    command->path_offset = Arena::offsetOf(cq.write_q, memory);
+    END_COMMAND();
+}
+
+void CQ_PushCommand_RecordStop()
+{
+    BEGIN_COMMAND(SG_Command_RecordStop, SG_COMMAND_RECORD_STOP);
+    END_COMMAND();
+}
+
+void CQ_PushCommand_TraceStart(const char* path)
+{
+    int size_bytes = strlen(path);
+    BEGIN_COMMAND_ADDITIONAL_MEMORY_ZERO(SG_Command_TraceStart, SG_COMMAND_TRACE_START,
+                                         size_bytes + 1);
+    memcpy(memory, path, size_bytes);
+    command->path_offset = Arena::offsetOf(cq.write_q, memory);
+    END_COMMAND();
+}
+
+void CQ_PushCommand_TraceStop()
+{
+    BEGIN_COMMAND(SG_Command_TraceStop, SG_COMMAND_TRACE_STOP);
+    END_COMMAND();
+}
+
 void CQ_PushCommand_WindowClose()
 {
     BEGIN_COMMAND(SG_Command_WindowClose, SG_COMMAND_WINDOW_CLOSE);
@@ -458,48 +599,36 @@ void CQ_PushCommand_GeometryCreate(SG_Geometry* geo)
     END_COMMAND();
 }
 
-// copies data pointer into command arena. does NOT take ownership
-// assumes data is 4bytes (i32 or f32)
-// data_len is the number of elements in data array, NOT size in bytes
+// the command takes a ref on the published block, released by the renderer after
+// upload. attribute data is 4bytes per component (i32 or f32)
 void CQ_PushCommand_GeometrySetVertexAttribute(SG_Geometry* geo, int location,
-                                               int num_components, void* data,
-                                               int data_size_bytes)
+                                               int num_components)
 {
-    if (data == NULL || data_size_bytes == 0 || num_components == 0) return;
-
-    BEGIN_COMMAND_ADDITIONAL_MEMORY(SG_Command_GeoSetVertexAttribute,
-                                    SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE,
-                                    data_size_bytes);
-
-    // get cq memory for vertex data
-    f32* attribute_data = (f32*)memory;
-    memcpy(attribute_data, data, data_size_bytes);
-
-    command->sg_id           = geo->id;
-    command->num_components  = num_components;
-    command->location        = location;
-    command->data_size_bytes = data_size_bytes;
-    command->data_offset     = Arena::offsetOf(cq.write_q, attribute_data);
+    SG_GeometryBlock* block = SG_Geometry::publishAttribute(geo, location);
+    if (block == NULL || num_components == 0) {
+        SG_GeometryBlock::release(block);
+        return;
+    }
 
-    ASSERT((data_size_bytes % 4) == 0);
-    ASSERT((data_size_bytes / 4) % num_components == 0);
+    ASSERT((block->size % 4) == 0);
+    ASSERT((block->size / 4) % num_components == 0);
 
+    BEGIN_COMMAND(SG_Command_GeoSetVertexAttribute,
+                  SG_COMMAND_GEO_SET_VERTEX_ATTRIBUTE);
+    command->sg_id          = geo->id;
+    command->num_components = num_components;
+    command->location       = location;
+    command->data           = block;
     END_COMMAND();
 }
 
-void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo, u32* indices, int index_count)
+void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo)
 {
-    BEGIN_COMMAND_ADDITIONAL_MEMORY(SG_Command_GeoSetIndices,
-                                    SG_COMMAND_GEO_SET_INDICES,
-                                    index_count * sizeof(*indices));
-
-    u32* index_data = (u32*)memory;
-    memcpy(index_data, indices, index_count * sizeof(*indices));
-
-    command->sg_id          = geo->id;
-    command->index_count    = index_count;
-    command->indices_offset = Arena::offsetOf(cq.write_q, index_data);
+    SG_GeometryBlock* block = SG_Geometry::publishIndices(geo);
 
+    BEGIN_COMMAND(SG_Command_GeoSetIndices, SG_COMMAND_GEO_SET_INDICES);
+    command->sg_id   = geo->id;
+    command->indices = block;
     END_COMMAND();
 }
 
@@ -537,6 +666,18 @@ void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count)
     END_COMMAND();
 }
 
+void CQ_PushCommand_GeometrySetLODs(SG_Geometry* geo)
+{
+    BEGIN_COMMAND(SG_Command_GeoSetLODs, SG_COMMAND_GEO_SET_LODS);
+    command->sg_id         = geo->id;
+    command->lod_count     = geo->lod_count;
+    command->lod_cull_size = geo->lod_cull_size;
+    memcpy(command->lod_geo_ids, geo->lod_geo_ids, sizeof(geo->lod_geo_ids));
+    memcpy(command->lod_screen_sizes, geo->lod_screen_sizes,
+           sizeof(geo->lod_screen_sizes));
+    END_COMMAND();
+}
+
 // Textures ====================================================================
 
 // maybe change to TextureUpdate + lazy creation to support mutable texture
@@ -562,39 +703,35 @@ void CQ_PushCommand_TextureWrite(SG_Texture* texture, SG_TextureWriteDesc* desc,
         * SG_Texture_numComponentsPerTexel(texture->desc.format);
     int write_size_bytes = write_region_num_texels * bytes_per_texel;
 
-    BEGIN_COMMAND_ADDITIONAL_MEMORY(SG_Command_TextureWrite, SG_COMMAND_TEXTURE_WRITE,
-                                    write_size_bytes);
+    ASSERT(write_region_num_components <= API->object->array_float_size(ck_array));
+
+    // gather before reserving so the staging arena is the only allocation
+    f64* ck_data = _CQ_GatherCkFloatArray(ck_array, write_region_num_components, API);
+
+    RESERVE_COMMAND_ADDITIONAL_MEMORY(SG_Command_TextureWrite, SG_COMMAND_TEXTURE_WRITE,
+                                      write_size_bytes);
 
     command->sg_id           = texture->id;
     command->write_desc      = *desc;
     command->data_size_bytes = write_size_bytes;
-    command->data_offset     = Arena::offsetOf(cq.write_q, memory);
-
-    // copy texture data to write_q
-#define CQ_TEXTURE_WRITE(type, type_max)                                               \
-    ASSERT(write_region_num_components <= API->object->array_float_size(ck_array));    \
-    type* pixel_data = (type*)memory;                                                  \
-    for (int i = 0; i < write_region_num_components; i++) {                            \
-        pixel_data[i]                                                                  \
-          = (type)(type_max * API->object->array_float_get_idx(ck_array, i));          \
-    }
+    command->data_offset     = memory_offset;
 
+    // convert texture data directly into write_q (lock not held)
     switch (texture->desc.format) {
         case WGPUTextureFormat_RGBA8Unorm: {
-            CQ_TEXTURE_WRITE(u8, UINT8_MAX);
+            CV_F64ToUnorm8(ck_data, (u8*)memory, write_region_num_components);
         } break;
         case WGPUTextureFormat_RGBA16Float: {
             ASSERT(false); // not impl
         } break;
         case WGPUTextureFormat_R32Float:
         case WGPUTextureFormat_RGBA32Float: {
-            CQ_TEXTURE_WRITE(f32, 1.0f);
+            CV_F64ToF32(ck_data, (f32*)memory, write_region_num_components);
         } break;
         default: ASSERT(false);
     }
 
-    END_COMMAND();
-#undef CQ_TEXTURE_WRITE
+    COMMIT_COMMAND();
 }
 
 void CQ_PushCommand_TextureWriteExternalPtr(SG_Texture* texture,
@@ -818,6 +955,13 @@ void CQ_PushCommand_MaterialSetUniform(SG_Material* material, int location)
     END_COMMAND();
 }
 
+void CQ_PushCommand_MaterialPrewarm(SG_Material* material)
+{
+    BEGIN_COMMAND(SG_Command_MaterialPrewarm, SG_COMMAND_MATERIAL_PREWARM);
+    command->sg_id = material->id;
+    END_COMMAND();
+}
+
 void CQ_PushCommand_MaterialSetStorageBuffer(SG_Material* material, int location,
                                              Chuck_Object* ck_arr,
                                              SG_MaterialUniformType storage_buffer_type)
@@ -1020,27 +1164,32 @@ void CQ_PushCommand_ShadowAddMesh(SG_Light* light, SG_Transform* xform,
     if (light == NULL || xform == NULL) return;
 
     BEGIN_COMMAND(SG_Command_ShadowAddMesh, SG_COMMAND_SHADOW_ADD_MESH);
-    command->add                        = add;
-    command->light_id                   = light->id;
-    command->mesh_id_list_offset        = cq.write_q->curr;
+    command->add                 = add;
+    command->light_id            = light->id;
+    command->mesh_id_list_offset = cq.write_q->curr;
+
+    // pushing ids may grow the queue, invalidating `command`
+    u64 command_offset = (u8*)command - cq.write_q->base;
+
     *ARENA_PUSH_TYPE(cq.write_q, SG_ID) = xform->id;
 
-    // ==optimize== when refactoring scenegraph to use linked list to connect children,
-    // only add the XForms which are actually GMeshs
+    // ==optimize== only add the XForms which are actually GMeshs
     if (add_children) { // BFS add all children
-        u64 curr = cq.write_q->curr;
-        memcpy(Arena::push(cq.write_q, xform->childrenIDs.curr),
-               xform->childrenIDs.base, xform->childrenIDs.curr);
-
+        u64 curr = cq.write_q->curr - sizeof(SG_ID);
         while (curr != cq.write_q->curr) {
             xform = SG_GetTransform(*(SG_ID*)Arena::get(cq.write_q, curr));
             ASSERT(xform);
             curr += sizeof(SG_ID);
 
-            memcpy(Arena::push(cq.write_q, xform->childrenIDs.curr),
-                   xform->childrenIDs.base, xform->childrenIDs.curr);
+            SG_ID child_id = xform->first_child_id;
+            while (child_id) {
+                *ARENA_PUSH_TYPE(cq.write_q, SG_ID) = child_id;
+
+                child_id = SG_GetTransform(child_id)->next_sibling_id;
+            }
         }
     }
+    command = (SG_Command_ShadowAddMesh*)Arena::get(cq.write_q, command_offset);
     command->mesh_id_list_len
       = (cq.write_q->curr - command->mesh_id_list_offset) / sizeof(SG_ID);
 
@@ -1120,13 +1269,27 @@ void CQ_PushCommand_WebcamUpdate(SG_Webcam* webcam)
     END_COMMAND();
 }
 
+void CQ_PushCommand_AudioTapUpdate(SG_AudioTap* tap)
+{
+    BEGIN_COMMAND(SG_Command_AudioTapUpdate, SG_COMMAND_AUDIO_TAP_UPDATE);
+    command->tap_id     = tap->id;
+    command->ring       = tap->ring;
+    command->window     = tap->window;
+    command->mode       = tap->mode;
+    command->texture_id = tap->texture_id;
+    command->buffer_id  = tap->buffer_id;
+    END_COMMAND();
+}
+
 #undef cq
+#undef CQ_PROFILE_ZONE
 
 // ============================================================================
 // Graphics to Audio Commands
 // ============================================================================
 
 #define cq graphics_to_audio_cq
+#define CQ_PROFILE_ZONE() // render thread, not timed
 
 void CQ_PushCommand_G2A_TextureRead(SG_ID id, void* data, int size_bytes,
                                     WGPUBufferMapAsyncStatus status)
@@ -1194,4 +1357,16 @@ void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state)
     END_COMMAND();
 }
 
+void CQ_PushCommand_G2A_TextureLoaded(SG_ID texture_id, bool ok,
+                                      WGPUTextureFormat format, bool gen_mips)
+{
+    BEGIN_COMMAND(SG_Command_G2A_TextureLoaded, SG_COMMAND_G2A_TEXTURE_LOADED);
+    command->texture_id = texture_id;
+    command->ok         = ok;
+    command->format     = format;
+    command->gen_mips   = gen_mips;
+    END_COMMAND();
+}
+
 #undef cq
+#undef CQ_PROFILE_ZONE
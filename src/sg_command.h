@@ -76,6 +76,14 @@ enum SG_CommandType : u32 {
     SG_COMMAND_SET_FIXED_TIMESTEP,
     SG_COMMAND_SET_WAIT_EVENTS_TIMEOUT,
     SG_COMMAND_SET_CHUCK_VM_INFO,
+    SG_COMMAND_SET_FALLBACK_MATERIAL,
+    SG_COMMAND_SET_DESTROY_BUDGET,
+    SG_COMMAND_SET_TEXTURE_UPLOAD_BUDGET,
+    SG_COMMAND_SET_PIPELINED,
+    SG_COMMAND_RECORD_START,
+    SG_COMMAND_RECORD_STOP,
+    SG_COMMAND_TRACE_START,
+    SG_COMMAND_TRACE_STOP,
 
     // window
     SG_COMMAND_WINDOW_CLOSE,
@@ -121,6 +129,7 @@ enum SG_CommandType : u32 {
     SG_COMMAND_MATERIAL_UPDATE_PSO,
     SG_COMMAND_MATERIAL_SET_UNIFORM,
     SG_COMMAND_MATERIAL_SET_STORAGE_BUFFER,
+    SG_COMMAND_MATERIAL_PREWARM,
 
     // mesh
     SG_COMMAND_MESH_UPDATE,
@@ -147,6 +156,7 @@ enum SG_CommandType : u32 {
     SG_COMMAND_GEO_SET_VERTEX_COUNT,
     SG_COMMAND_GEO_SET_INDICES_COUNT,
     SG_COMMAND_GEO_SET_INDICES,
+    SG_COMMAND_GEO_SET_LODS,
 
     // texture
     SG_COMMAND_TEXTURE_CREATE,
@@ -179,6 +189,9 @@ enum SG_CommandType : u32 {
     SG_COMMAND_WEBCAM_CREATE,
     SG_COMMAND_WEBCAM_UPDATE,
 
+    // audio tap
+    SG_COMMAND_AUDIO_TAP_UPDATE,
+
     // ================================
     // graphics2audio commands
     // ================================
@@ -189,6 +202,7 @@ enum SG_CommandType : u32 {
     SG_COMMAND_G2A_TEXTURE_SAVE,
     SG_COMMAND_G2A_GAMEPAD_STATE,
     SG_COMMAND_G2A_GAMEPAD_CONNECT,
+    SG_COMMAND_G2A_TEXTURE_LOADED,
 
     SG_COMMAND_COUNT
 };
@@ -213,6 +227,35 @@ struct SG_Command_SetChuckVMInfo : public SG_Command {
     int srate;
 };
 
+struct SG_Command_SetFallbackMaterial : public SG_Command {
+    SG_ID material_id; // 0 to disable
+};
+
+struct SG_Command_SetDestroyBudget : public SG_Command {
+    f64 budget_ms; // 0 for unlimited
+};
+
+struct SG_Command_SetTextureUploadBudget : public SG_Command {
+    u64 budget_bytes; // 0 for unlimited
+};
+
+struct SG_Command_SetPipelined : public SG_Command {
+    bool pipelined;
+};
+
+struct SG_Command_RecordStart : public SG_Command {
+    SG_ID texture_id; // 0 records the window
+    ptrdiff_t path_offset;
+};
+
+struct SG_Command_RecordStop : public SG_Command {};
+
+struct SG_Command_TraceStart : public SG_Command {
+    ptrdiff_t path_offset;
+};
+
+struct SG_Command_TraceStop : public SG_Command {};
+
 // Window Commands --------------------------------------------------------
 
 struct SG_Command_WindowClose : public SG_Command {
@@ -356,8 +399,7 @@ struct SG_Command_GeoSetVertexAttribute : public SG_Command {
     SG_ID sg_id;
     int location;
     int num_components;
-    int data_size_bytes;
-    ptrdiff_t data_offset; // byte offset into command queue arena for attribute data
+    SG_GeometryBlock* data; // ref owned by the command, NULL if empty
 };
 
 struct SG_Command_GeometrySetPulledVertexAttribute : public SG_Command {
@@ -379,8 +421,15 @@ struct SG_Command_GeometrySetIndicesCount : public SG_Command {
 
 struct SG_Command_GeoSetIndices : public SG_Command {
     SG_ID sg_id;
-    int index_count;
-    ptrdiff_t indices_offset;
+    SG_GeometryBlock* indices; // ref owned by the command, NULL if empty
+};
+
+struct SG_Command_GeoSetLODs : public SG_Command {
+    SG_ID sg_id;
+    SG_ID lod_geo_ids[CHUGL_GEOMETRY_MAX_LODS];
+    f32 lod_screen_sizes[CHUGL_GEOMETRY_MAX_LODS];
+    int lod_count;
+    f32 lod_cull_size;
 };
 
 struct SG_Command_TextureCreate : public SG_Command {
@@ -484,6 +533,10 @@ struct SG_Command_MaterialSetStorageBuffer : public SG_Command {
     int data_size_bytes;
 };
 
+struct SG_Command_MaterialPrewarm : public SG_Command {
+    SG_ID sg_id;
+};
+
 struct SG_Command_MeshUpdate : public SG_Command {
     SG_ID mesh_id;
     SG_ID geo_id;
@@ -626,6 +679,18 @@ struct SG_Command_WebcamUpdate : public SG_Command {
     bool capture;
 };
 
+// audio tap commands -----------------------------------------------------
+
+// creates the R_AudioTap if it doesn't exist yet
+struct SG_Command_AudioTapUpdate : public SG_Command {
+    SG_ID tap_id;
+    SG_AudioTapRing* ring; // shared with audio thread, NOT owned
+    int window;
+    SG_AudioTap_Mode mode;
+    SG_ID texture_id;
+    SG_ID buffer_id;
+};
+
 // ============================================================================
 // Graphics to Audio Commands
 // ============================================================================
@@ -661,6 +726,15 @@ struct SG_Command_G2A_GamepadConnect : public SG_Command {
     char name[128];
 };
 
+// every layer of a streamed texture load is uploaded (or failed)
+struct SG_Command_G2A_TextureLoaded : public SG_Command {
+    SG_ID texture_id;
+    b32 ok;
+    // may differ from what it was created with, e.g. a compressed KTX2 file
+    WGPUTextureFormat format;
+    b32 gen_mips;
+};
+
 // ============================================================================
 // Command Queue API
 // ============================================================================
@@ -681,12 +755,27 @@ void CQ_ReadCommandQueueClear(bool which);
 // caused by Arena resizing)
 void* CQ_ReadCommandGetOffset(u64 byte_offset, bool which);
 
+// the commands about to be drained by the render thread, in place (GG.capture())
+void* CQ_ReadCommandQueueData(u64* size_bytes);
+
+// fills the empty read queue with captured commands instead of swapping, and
+// returns where they start (GG.replay())
+void* CQ_ReadCommandQueueLoad(const void* data, u64 size_bytes);
+
 // ============================================================================
 // Commands
 // ============================================================================
 
 // config ---------------------------------------------------------------
 void CQ_PushCommand_SetFixedTimestep(int fps);
+void CQ_PushCommand_SetFallbackMaterial(SG_Material* material);
+void CQ_PushCommand_SetDestroyBudget(f64 budget_ms);
+void CQ_PushCommand_SetTextureUploadBudget(u64 budget_bytes);
+void CQ_PushCommand_SetPipelined(bool pipelined);
+void CQ_PushCommand_RecordStart(const char* path, SG_ID texture_id);
+void CQ_PushCommand_RecordStop();
+void CQ_PushCommand_TraceStart(const char* path);
+void CQ_PushCommand_TraceStop();
 
 // window ---------------------------------------------------------------
 
@@ -728,14 +817,17 @@ void CQ_PushCommand_SceneUpdate(SG_Scene* scene);
 
 // geometry
 void CQ_PushCommand_GeometryCreate(SG_Geometry* geo);
+// publish geo's staging data and hand it to the renderer by reference, see
+// SG_GeometryBlock
 void CQ_PushCommand_GeometrySetVertexAttribute(SG_Geometry* geo, int location,
-                                               int num_components, void* data,
-                                               int data_size_bytes);
-void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo, u32* indices, int index_count);
+                                               int num_components);
+void CQ_PushCommand_GeometrySetIndices(SG_Geometry* geo);
 void CQ_PushCommand_GeometrySetPulledVertexAttribute(SG_Geometry* geo, int location,
                                                      void* data, size_t bytes);
 void CQ_PushCommand_GeometrySetVertexCount(SG_Geometry* geo, int count);
 void CQ_PushCommand_GeometrySetIndicesCount(SG_Geometry* geo, int count);
+// sends geo's whole LOD chain
+void CQ_PushCommand_GeometrySetLODs(SG_Geometry* geo);
 
 // texture
 void CQ_PushCommand_TextureCreate(SG_Texture* texture);
@@ -771,6 +863,7 @@ void CQ_PushCommand_MaterialSetUniform(SG_Material* material, int location);
 void CQ_PushCommand_MaterialSetStorageBuffer(
   SG_Material* material, int location, Chuck_Object* ck_arr,
   SG_MaterialUniformType storage_buffer_type);
+void CQ_PushCommand_MaterialPrewarm(SG_Material* material);
 
 // mesh
 void CQ_PushCommand_MeshUpdate(SG_Mesh* mesh);
@@ -815,6 +908,9 @@ void CQ_PushCommand_VideoTextureMode(SG_Video* video, int mode);
 void CQ_PushCommand_WebcamCreate(SG_Webcam* webcam, sr_webcam_device* device);
 void CQ_PushCommand_WebcamUpdate(SG_Webcam* webcam);
 
+// audio tap
+void CQ_PushCommand_AudioTapUpdate(SG_AudioTap* tap);
+
 // ============================================================================
 // Commands from Graphics Thread --> Audio Thread
 // ============================================================================
@@ -825,4 +921,6 @@ void CQ_PushCommand_G2A_TextureRead(SG_ID id, void* data, int size_bytes,
 void CQ_PushCommand_G2A_TextureSave(Chuck_Event* texture_save_event, int status);
 
 void CQ_PushCommand_G2A_GamepadConnect(int gp_id, int connected, const char* name);
-void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state);
\ No newline at end of file
+void CQ_PushCommand_G2A_GamepadState(int id, GLFWgamepadstate* state);
+void CQ_PushCommand_G2A_TextureLoaded(SG_ID texture_id, bool ok,
+                                      WGPUTextureFormat format, bool gen_mips);
\ No newline at end of file
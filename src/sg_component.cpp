@@ -26,14 +26,18 @@
  SOFTWARE.
 -----------------------------------------------------------------------------*/
 #include "sg_component.h"
+#include "core/convert.h"
 #include "core/hashmap.h"
+#include "destroy_queue.h"
 #include "geometry.h"
+#include "mesh_lod.h"
 #include "sg_command.h"
 
 #include "core/log.h"
 #include "ulib_helper.h"
 
 #include <glm/gtx/quaternion.hpp>
+#include <sokol/sokol_time.h>
 #include <sr_webcam/include/sr_webcam.h>
 
 // ============================================================================
@@ -49,8 +53,6 @@ void SG_Transform::_init(SG_Transform* t, Chuck_Object* ckobj)
     t->rot      = QUAT_IDENTITY;
     t->sca      = glm::vec3(1.0f);
     t->parentID = 0;
-    // initialize children array for 8 children
-    Arena::init(&t->childrenIDs, sizeof(SG_ID) * 8);
 }
 
 void SG_Transform::translate(SG_Transform* t, glm::vec3 delta)
@@ -242,6 +244,84 @@ void SG_Transform::lookAt(SG_Transform* t, glm::vec3 pos, glm::vec3 up = VEC_UP)
     t->rot = local_rotation;
 }
 
+// moves the subgraph rooted at `root` from scene `from` to scene `to`,
+// updating scene ids and light registration. Either scene may be 0
+static void SG_Transform_moveSubgraphScene(SG_Transform* root, SG_ID from, SG_ID to)
+{
+    if (from == to) return;
+
+    SG_Scene* from_scene = SG_GetScene(from);
+    SG_Scene* to_scene   = SG_GetScene(to);
+
+    static Arena sg_id_arena{};
+    ASSERT(sg_id_arena.curr == 0);
+    defer(Arena::clear(&sg_id_arena));
+
+    *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID) = root->id;
+    while (sg_id_arena.curr > 0) {
+        SG_Transform* sg = SG_GetTransform(*ARENA_GET_LAST_TYPE(&sg_id_arena, SG_ID));
+        ARENA_POP_TYPE(&sg_id_arena, SG_ID);
+
+        ASSERT(sg->scene_id == from);
+        sg->scene_id = to;
+
+        if (sg->type == SG_COMPONENT_LIGHT) {
+            if (from_scene) SG_Scene::removeLight(from_scene, sg->id);
+            if (to_scene) SG_Scene::addLight(to_scene, sg->id);
+        }
+
+        // add children to queue
+        for (SG_ID c = sg->first_child_id; c; c = SG_GetTransform(c)->next_sibling_id) {
+            *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID) = c;
+        }
+    }
+}
+
+// O(1) unlink from parent's children list. Does not touch refcounts or scene
+static void SG_Transform_unlink(SG_Transform* parent, SG_Transform* child)
+{
+    ASSERT(child->parentID == parent->id);
+
+    SG_Transform* prev = SG_GetTransform(child->prev_sibling_id);
+    SG_Transform* next = SG_GetTransform(child->next_sibling_id);
+    if (prev) {
+        prev->next_sibling_id = child->next_sibling_id;
+    } else {
+        parent->first_child_id = child->next_sibling_id;
+    }
+    if (next) {
+        next->prev_sibling_id = child->prev_sibling_id;
+    } else {
+        parent->last_child_id = child->prev_sibling_id;
+    }
+
+    child->parentID        = 0;
+    child->prev_sibling_id = 0;
+    child->next_sibling_id = 0;
+    --parent->child_count;
+    parent->_child_cursor_id = 0;
+}
+
+// O(1) append to parent's children list
+static void SG_Transform_link(SG_Transform* parent, SG_Transform* child)
+{
+    ASSERT(child->parentID == 0);
+
+    SG_Transform* last = SG_GetTransform(parent->last_child_id);
+    if (last) {
+        last->next_sibling_id = child->id;
+    } else {
+        parent->first_child_id = child->id;
+    }
+
+    child->parentID        = parent->id;
+    child->prev_sibling_id = parent->last_child_id;
+    child->next_sibling_id = 0;
+    parent->last_child_id  = child->id;
+    ++parent->child_count;
+    parent->_child_cursor_id = 0;
+}
+
 void SG_Transform::addChild(SG_Transform* parent, SG_Transform* child)
 {
     // Object cannot be added as child of itself
@@ -271,136 +351,52 @@ void SG_Transform::addChild(SG_Transform* parent, SG_Transform* child)
     // we are already the parent, do nothing
     if (child->parentID == parent->id) return;
 
-    // remove child from old parent
-    if (child->parentID) {
-        SG_Transform* prevParent = SG_GetTransform(child->parentID);
-        SG_Transform::removeChild(prevParent, child);
-    }
+    // remove child from old parent. Scene membership is only updated once at the
+    // end, so reparenting within the same scene never walks the subgraph
+    SG_ID prev_scene_id      = child->scene_id;
+    SG_Transform* prevParent = SG_GetTransform(child->parentID);
+    if (prevParent) SG_Transform_unlink(prevParent, child);
 
     // assign to new parent
-    child->parentID = parent->id;
+    SG_Transform_link(parent, child);
 
     // reference count
     SG_AddRef(parent);
 
-    // add to list of children
-    SG_ID* xformID = ARENA_PUSH_TYPE(&parent->childrenIDs, SG_ID);
-    *xformID       = child->id;
-
     // add ref to kid
     SG_AddRef(child);
 
-    // loop over child subgraph, add any lights to scene
-    static Arena sg_id_arena{};
-    ASSERT(sg_id_arena.curr == 0);
-    defer(Arena::clear(&sg_id_arena));
-    if (parent->scene_id != 0) {
-        SG_Scene* scene                       = SG_GetScene(parent->scene_id);
-        *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID) = child->id;
-        while (ARENA_LENGTH(&sg_id_arena, SG_ID) > 0) {
-            SG_ID* sg_id = ARENA_GET_LAST_TYPE(&sg_id_arena, SG_ID);
-            ARENA_POP_TYPE(&sg_id_arena, SG_ID);
-            SG_Transform* sg = SG_GetTransform(*sg_id);
-
-            sg->scene_id = parent->scene_id;
-            if (sg->type == SG_COMPONENT_LIGHT) {
-                SG_Scene::addLight(scene, sg->id);
-            }
-
-            // add children to queue
-            size_t num_children = SG_Transform::numChildren(sg);
-            for (size_t i = 0; i < num_children; ++i) {
-                *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID)
-                  = *ARENA_GET_TYPE(&sg->childrenIDs, SG_ID, i);
-            }
-        }
+    // release refs between child and old parent
+    if (prevParent) {
+        SG_DecrementRef(child->id);
+        SG_DecrementRef(prevParent->id);
     }
-}
-
-static void SG_Transform_removeChildSubgraph(SG_Transform* parent, SG_Transform* child)
-{
-    static Arena sg_id_arena{};
-    ASSERT(sg_id_arena.curr == 0);
-    defer(Arena::clear(&sg_id_arena));
-    if (parent->scene_id != 0) {
-        SG_Scene* scene                       = SG_GetScene(parent->scene_id);
-        *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID) = child->id;
-        while (sg_id_arena.curr > 0) {
-            SG_ID* sg_id = ARENA_GET_LAST_TYPE(&sg_id_arena, SG_ID);
-            ARENA_POP_TYPE(&sg_id_arena, SG_ID);
-            SG_Transform* sg = SG_GetTransform(*sg_id);
-
-            // unset scene id
-            ASSERT(sg->scene_id == parent->scene_id);
-            sg->scene_id = 0;
-
-            // remove from light list
-            if (sg->type == SG_COMPONENT_LIGHT) {
-                SG_Scene::removeLight(scene, sg->id);
-            }
 
-            // add children to queue
-            size_t num_children = SG_Transform::numChildren(sg);
-            for (size_t i = 0; i < num_children; ++i) {
-                *ARENA_PUSH_TYPE(&sg_id_arena, SG_ID)
-                  = *ARENA_GET_TYPE(&sg->childrenIDs, SG_ID, i);
-            }
-        }
-    }
+    // move child subgraph (and its lights) into the parent's scene
+    SG_Transform_moveSubgraphScene(child, prev_scene_id, parent->scene_id);
 }
 
 void SG_Transform::removeChild(SG_Transform* parent, SG_Transform* child)
 {
     if (child->parentID != parent->id) return;
 
-    size_t numChildren = ARENA_LENGTH(&parent->childrenIDs, SG_ID);
-    SG_ID* children    = (SG_ID*)parent->childrenIDs.base;
+    SG_Transform_unlink(parent, child);
+    SG_Transform_moveSubgraphScene(child, child->scene_id, 0);
 
-    child->parentID = 0;
+    // release ref count on child's chuck object; one less reference to
+    // it from us (parent)
+    SG_DecrementRef(child->id);
 
-    // ==optimize== flat_map instead of linear search
-    for (size_t i = 0; i < numChildren; ++i) {
-        if (children[i] == child->id) {
-            // swap with last element
-            children[i] = children[numChildren - 1];
-            // pop last element
-            Arena::pop(&parent->childrenIDs, sizeof(SG_ID));
-
-            // release ref count on child's chuck object; one less reference to
-            // it from us (parent)
-            SG_DecrementRef(child->id);
-
-            // release ref count on our (parent's) chuck object; one less
-            // reference to it from child
-            SG_DecrementRef(parent->id);
-
-            break;
-        }
-    }
-
-    SG_Transform_removeChildSubgraph(parent, child);
+    // release ref count on our (parent's) chuck object; one less
+    // reference to it from child
+    SG_DecrementRef(parent->id);
 }
 
 void SG_Transform::removeAllChildren(SG_Transform* parent)
 {
-    size_t numChildren = ARENA_LENGTH(&parent->childrenIDs, SG_ID);
-    SG_ID* children    = (SG_ID*)parent->childrenIDs.base;
-
-    for (size_t i = 0; i < numChildren; ++i) {
-        // release ref count on child's chuck object; one less reference to
-        // it from us (parent)
-        SG_DecrementRef(children[i]);
-
-        // release ref count on our (parent's) chuck object; one less
-        // reference to it from child
-        SG_DecrementRef(parent->id);
-
-        // remove child from parent
-        SG_Transform* child = SG_GetTransform(children[i]);
-        child->parentID     = 0;
-        SG_Transform_removeChildSubgraph(parent, child);
+    while (parent->first_child_id) {
+        SG_Transform::removeChild(parent, SG_GetTransform(parent->first_child_id));
     }
-    Arena::clear(&parent->childrenIDs);
 }
 
 bool SG_Transform::isAncestor(SG_Transform* ancestor, SG_Transform* descendent)
@@ -414,13 +410,25 @@ bool SG_Transform::isAncestor(SG_Transform* ancestor, SG_Transform* descendent)
 
 size_t SG_Transform::numChildren(SG_Transform* t)
 {
-    return ARENA_LENGTH(&t->childrenIDs, SG_ID);
+    return t->child_count;
 }
 
 SG_Transform* SG_Transform::child(SG_Transform* t, size_t index)
 {
     if (index >= numChildren(t)) return NULL;
-    return SG_GetTransform(*ARENA_GET_TYPE(&t->childrenIDs, SG_ID, index));
+
+    // resume from the previous lookup if it's not past index
+    SG_ID id = t->first_child_id;
+    size_t i = 0;
+    if (t->_child_cursor_id && t->_child_cursor_idx <= index) {
+        id = t->_child_cursor_id;
+        i  = t->_child_cursor_idx;
+    }
+    for (; i < index; ++i) id = SG_GetTransform(id)->next_sibling_id;
+
+    t->_child_cursor_id  = id;
+    t->_child_cursor_idx = (u32)index;
+    return SG_GetTransform(id);
 }
 
 // ============================================================================
@@ -446,6 +454,50 @@ SG_Sampler SG_Sampler::fromCkObj(Chuck_Object* ckobj)
     return sampler;
 }
 
+// ============================================================================
+// SG_GeometryBlock
+// ============================================================================
+
+static std::atomic<i64> _geometry_block_live_bytes = { 0 };
+
+SG_GeometryBlock* SG_GeometryBlock::fromArena(Arena* arena)
+{
+    if (arena->curr == 0) return NULL;
+
+    SG_GeometryBlock* block = ALLOCATE_TYPE(SG_GeometryBlock);
+    block->refcount.store(1);
+    block->size = arena->curr;
+    block->data = arena->base;
+    _geometry_block_live_bytes += block->size;
+
+    // arena reallocates on the next write
+    arena->base = NULL;
+    arena->curr = 0;
+    arena->cap  = 0;
+
+    return block;
+}
+
+void SG_GeometryBlock::addRef(SG_GeometryBlock* block)
+{
+    if (block) block->refcount.fetch_add(1);
+}
+
+void SG_GeometryBlock::release(SG_GeometryBlock* block)
+{
+    if (block == NULL) return;
+    if (block->refcount.fetch_sub(1) > 1) return;
+
+    _geometry_block_live_bytes -= block->size;
+    FREE(block->data);
+    FREE_TYPE(SG_GeometryBlock, block);
+}
+
+i64 SG_GeometryBlock::liveBytes()
+{
+    return _geometry_block_live_bytes.load();
+}
+
 // ============================================================================
 // SG_Geometry Definitions
 // ============================================================================
@@ -595,13 +647,70 @@ void SG_Geometry::buildCylinder(SG_Geometry* g, CylinderParams* p)
 u32 SG_Geometry::vertexCount(SG_Geometry* geo)
 {
     if (geo->vertex_attribute_num_components[0] == 0) return 0;
-    return ARENA_LENGTH(&geo->vertex_attribute_data[0], f32)
-           / geo->vertex_attribute_num_components[0];
+    return geo->vertex_attribute_bytes[0]
+           / (sizeof(f32) * geo->vertex_attribute_num_components[0]);
 }
 
 u32 SG_Geometry::indexCount(SG_Geometry* geo)
 {
-    return ARENA_LENGTH(&geo->indices, u32);
+    return geo->indices_bytes / sizeof(u32);
+}
+
+#define SG_ATTRIBUTE_CONVERT_CHUNK 1024 // f64s gathered per CV_F64ToF32 call
+
+static int _SG_AttributeArraySize(CK_DL_API api, Chuck_Object* ck_array,
+                                  int num_components)
+{
+    switch (num_components) {
+        case 1: return api->object->array_float_size((Chuck_ArrayFloat*)ck_array);
+        case 2: return api->object->array_vec2_size((Chuck_ArrayVec2*)ck_array);
+        case 3: return api->object->array_vec3_size((Chuck_ArrayVec3*)ck_array);
+        case 4: return api->object->array_vec4_size((Chuck_ArrayVec4*)ck_array);
+        default: ASSERT(false);
+    }
+    return 0;
+}
+
+// copies `count` elements of a chuck float or vec array, from `begin`, to dst as
+// contiguous f64s. The chugin API has no bulk array access
+static void _SG_GatherAttribute(CK_DL_API api, Chuck_Object* ck_array,
+                                int num_components, int begin, int count, f64* dst)
+{
+    switch (num_components) {
+        case 1: {
+            for (int i = 0; i < count; i++)
+                dst[i] = api->object->array_float_get_idx((Chuck_ArrayFloat*)ck_array,
+                                                          begin + i);
+        } break;
+        case 2: {
+            for (int i = 0; i < count; i++, dst += 2) {
+                t_CKVEC2 v = api->object->array_vec2_get_idx((Chuck_ArrayVec2*)ck_array,
+                                                             begin + i);
+                dst[0]     = v.x;
+                dst[1]     = v.y;
+            }
+        } break;
+        case 3: {
+            for (int i = 0; i < count; i++, dst += 3) {
+                t_CKVEC3 v = api->object->array_vec3_get_idx((Chuck_ArrayVec3*)ck_array,
+                                                             begin + i);
+                dst[0]     = v.x;
+                dst[1]     = v.y;
+                dst[2]     = v.z;
+            }
+        } break;
+        case 4: {
+            for (int i = 0; i < count; i++, dst += 4) {
+                t_CKVEC4 v = api->object->array_vec4_get_idx((Chuck_ArrayVec4*)ck_array,
+                                                             begin + i);
+                dst[0]     = v.x;
+                dst[1]     = v.y;
+                dst[2]     = v.z;
+                dst[3]     = v.w;
+            }
+        } break;
+        default: ASSERT(false);
+    }
 }
 
 Arena* SG_Geometry::setAttribute(SG_Geometry* geo, int location, int num_components,
@@ -625,53 +734,19 @@ Arena* SG_Geometry::setAttribute(SG_Geometry* geo, int location, int num_compone
               = (i32)api->object->array_int_get_idx((Chuck_ArrayInt*)ck_array, i);
         ASSERT(ARENA_LENGTH(arena, i32) == ck_arr_len);
     } else {
-        switch (ck_array_num_components) {
-            case 1: {
-                int ck_arr_len
-                  = api->object->array_float_size((Chuck_ArrayFloat*)ck_array);
-                f32* arena_data = ARENA_PUSH_COUNT(arena, f32, ck_arr_len);
-                for (int i = 0; i < ck_arr_len; i++)
-                    arena_data[i] = (f32)api->object->array_float_get_idx(
-                      (Chuck_ArrayFloat*)ck_array, i);
-                ASSERT(ARENA_LENGTH(arena, f32) == ck_arr_len);
-            } break;
-            case 2: {
-                int ck_arr_len
-                  = api->object->array_vec2_size((Chuck_ArrayVec2*)ck_array);
-                glm::vec2* arena_data = ARENA_PUSH_COUNT(arena, glm::vec2, ck_arr_len);
-                for (int i = 0; i < ck_arr_len; i++) {
-                    t_CKVEC2 v
-                      = api->object->array_vec2_get_idx((Chuck_ArrayVec2*)ck_array, i);
-                    arena_data[i] = { v.x, v.y };
-                }
-                ASSERT(ARENA_LENGTH(arena, glm::vec2) == ck_arr_len);
-            } break;
-            case 3: {
-                int ck_arr_len
-                  = api->object->array_vec3_size((Chuck_ArrayVec3*)ck_array);
-                glm::vec3* arena_data = ARENA_PUSH_COUNT(arena, glm::vec3, ck_arr_len);
-                for (int i = 0; i < ck_arr_len; i++) {
-                    t_CKVEC3 v
-                      = api->object->array_vec3_get_idx((Chuck_ArrayVec3*)ck_array, i);
-                    arena_data[i] = { v.x, v.y, v.z };
-                }
-                ASSERT(ARENA_LENGTH(arena, glm::vec3) == ck_arr_len);
-            } break;
-            case 4: {
-                int ck_arr_len
-                  = api->object->array_vec4_size((Chuck_ArrayVec4*)ck_array);
-                glm::vec4* arena_data = ARENA_PUSH_COUNT(arena, glm::vec4, ck_arr_len);
-                for (int i = 0; i < ck_arr_len; i++) {
-                    t_CKVEC4 v
-                      = api->object->array_vec4_get_idx((Chuck_ArrayVec4*)ck_array, i);
-                    arena_data[i] = { v.x, v.y, v.z, v.w };
-                }
-                ASSERT(ARENA_LENGTH(arena, glm::vec4) == ck_arr_len);
-            } break;
-            default: {
-                ASSERT(false);
-            }
+        // gather a chunk of the chuck array onto the stack, then convert it to
+        // f32 in bulk
+        int components  = ck_array_num_components;
+        int ck_arr_len  = _SG_AttributeArraySize(api, ck_array, components);
+        f32* arena_data = ARENA_PUSH_COUNT(arena, f32, ck_arr_len * components);
+        f64 staging[SG_ATTRIBUTE_CONVERT_CHUNK];
+        int chunk = SG_ATTRIBUTE_CONVERT_CHUNK / MAX(components, 1);
+        for (int i = 0; i < ck_arr_len; i += chunk) {
+            int n = MIN(chunk, ck_arr_len - i);
+            _SG_GatherAttribute(api, ck_array, components, i, n, staging);
+            CV_F64ToF32(staging, arena_data + i * components, n * components);
         }
+        ASSERT(ARENA_LENGTH(arena, f32) == ck_arr_len * components);
     }
     return arena;
 }
@@ -691,12 +766,171 @@ u32* SG_Geometry::setIndices(SG_Geometry* geo, CK_DL_API API, Chuck_ArrayInt* in
 
 u32* SG_Geometry::getIndices(SG_Geometry* geo)
 {
-    return (u32*)geo->indices.base;
+    return geo->indices_block ? (u32*)geo->indices_block->data : NULL;
 }
 
 f32* SG_Geometry::getAttributeData(SG_Geometry* geo, int location)
 {
-    return (f32*)geo->vertex_attribute_data[location].base;
+    SG_GeometryBlock* block = geo->vertex_attribute_blocks[location];
+    return block ? (f32*)block->data : NULL;
+}
+
+u64 SG_Geometry::attributeBytes(SG_Geometry* geo, int location)
+{
+    SG_GeometryBlock* block = geo->vertex_attribute_blocks[location];
+    return block ? block->size : 0;
+}
+
+SG_GeometryBlock* SG_Geometry::publishAttribute(SG_Geometry* geo, int location)
+{
+    ASSERT(location < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES && location >= 0);
+
+    SG_GeometryBlock* block = SG_GeometryBlock::fromArena(
+      &geo->vertex_attribute_data[location]);
+    geo->vertex_attribute_bytes[location] = block ? block->size : 0;
+
+    // the caller's ref
+    SG_GeometryBlock::addRef(block);
+
+    SG_GeometryBlock::release(geo->vertex_attribute_blocks[location]);
+    geo->vertex_attribute_blocks[location] = NULL;
+    if (geo->is_static) {
+        SG_GeometryBlock::release(block);
+    } else {
+        geo->vertex_attribute_blocks[location] = block;
+    }
+
+    return block;
+}
+
+SG_GeometryBlock* SG_Geometry::publishIndices(SG_Geometry* geo)
+{
+    SG_GeometryBlock* block = SG_GeometryBlock::fromArena(&geo->indices);
+    geo->indices_bytes      = block ? block->size : 0;
+
+    // the caller's ref
+    SG_GeometryBlock::addRef(block);
+
+    SG_GeometryBlock::release(geo->indices_block);
+    geo->indices_block = NULL;
+    if (geo->is_static) {
+        SG_GeometryBlock::release(block);
+    } else {
+        geo->indices_block = block;
+    }
+
+    return block;
+}
+
+void SG_Geometry::markStatic(SG_Geometry* geo)
+{
+    geo->is_static = true;
+
+    // commands in flight hold their own refs, so this only drops the CPU copy
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        SG_GeometryBlock::release(geo->vertex_attribute_blocks[i]);
+        geo->vertex_attribute_blocks[i] = NULL;
+    }
+    SG_GeometryBlock::release(geo->indices_block);
+    geo->indices_block = NULL;
+}
+
+bool SG_Geometry::addLOD(SG_Geometry* geo, SG_Geometry* lod, f32 screen_size)
+{
+    if (!lod || lod == geo || geo->lod_count >= CHUGL_GEOMETRY_MAX_LODS) return false;
+
+    // insert, keeping screen sizes decreasing
+    int i = geo->lod_count;
+    while (i > 0 && geo->lod_screen_sizes[i - 1] < screen_size) {
+        geo->lod_geo_ids[i]      = geo->lod_geo_ids[i - 1];
+        geo->lod_screen_sizes[i] = geo->lod_screen_sizes[i - 1];
+        --i;
+    }
+
+    SG_AddRef(lod);
+    geo->lod_geo_ids[i]      = lod->id;
+    geo->lod_screen_sizes[i] = screen_size;
+    geo->lod_count++;
+    return true;
+}
+
+void SG_Geometry::clearLODs(SG_Geometry* geo)
+{
+    for (int i = 0; i < geo->lod_count; i++) SG_DecrementRef(geo->lod_geo_ids[i]);
+    memset(geo->lod_geo_ids, 0, sizeof(geo->lod_geo_ids));
+    geo->lod_count = 0;
+}
+
+bool SG_Geometry::simplify(SG_Geometry* dst, SG_Geometry* src, f32 ratio,
+                           f32 max_error, bool points)
+{
+    int loc          = SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION;
+    f32* positions   = SG_Geometry::getAttributeData(src, loc);
+    u32 stride       = src->vertex_attribute_num_components[loc];
+    u32 vertex_count = SG_Geometry::vertexCount(src);
+    u32* src_indices = SG_Geometry::getIndices(src);
+    u32 index_count  = src_indices ? SG_Geometry::indexCount(src) : 0;
+    if (!positions || stride < 3 || vertex_count == 0) return false;
+    if (!points && index_count < 3) return false;
+
+    ratio = CLAMP(ratio, 0.0f, 1.0f);
+
+    // simplify, then renumber the vertices that are left
+    u32 count  = 0;
+    u32* kept  = ALLOCATE_COUNT(u32, points ? vertex_count : index_count);
+    u32* remap = ALLOCATE_COUNT(u32, vertex_count);
+    defer(FREE(kept));
+    defer(FREE(remap));
+    if (points) {
+        count = MeshLOD_SimplifyPoints(kept, positions, vertex_count, stride,
+                                       MAX(1u, (u32)(vertex_count * ratio)));
+    } else {
+        // indices come straight from the user, drop any that would read past
+        // the vertex attributes
+        u32 valid = MeshLOD_SanitizeTriangles(kept, src_indices, index_count,
+                                              vertex_count);
+        if (valid != index_count) {
+            log_warn("Geometry.simplify(): ignoring %u indices that are out of "
+                     "range or don't form a whole triangle",
+                     index_count - valid);
+        }
+        if (valid < 3) return false;
+
+        u32 target = (u32)(valid / 3 * ratio) * 3;
+        count = MeshLOD_SimplifyTriangles(kept, kept, valid, positions, vertex_count,
+                                          stride, target, max_error, NULL);
+    }
+    u32 kept_vertex_count = MeshLOD_Compact(remap, kept, count, vertex_count);
+
+    // copy every attribute of the kept vertices into dst's staging buffers
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        int num_components = src->vertex_attribute_num_components[i];
+        dst->vertex_attribute_num_components[i] = num_components;
+        Arena::clear(&dst->vertex_attribute_data[i]);
+
+        f32* data = SG_Geometry::getAttributeData(src, i);
+        if (!data || num_components == 0) continue;
+
+        // attributes can be shorter than positions, missing values are 0
+        u32 data_count = SG_Geometry::attributeBytes(src, i)
+                         / (sizeof(f32) * num_components);
+        f32* out       = ARENA_PUSH_ZERO_COUNT(&dst->vertex_attribute_data[i], f32,
+                                               kept_vertex_count * num_components);
+        for (u32 v = 0; v < MIN(vertex_count, data_count); v++) {
+            if (remap[v] == UINT32_MAX) continue;
+            memcpy(out + remap[v] * num_components, data + v * num_components,
+                   sizeof(f32) * num_components);
+        }
+    }
+
+    // points are drawn in order, no indices
+    Arena::clear(&dst->indices);
+    if (!points) {
+        u32* indices = ARENA_PUSH_COUNT(&dst->indices, u32, count);
+        memcpy(indices, kept, sizeof(u32) * count);
+    }
+
+    return true;
 }
 
 // ============================================================================
@@ -738,11 +972,10 @@ void SG_Mesh::setMaterial(SG_Mesh* mesh, SG_Material* mat)
 // chugin API pointers
 static const Chuck_DL_Api* _ck_api = NULL;
 
-// GC arenas (TODO move into struct)
-static Arena _gc_queue_a;
-static Arena _gc_queue_b;
-static Arena* _gc_queue_read  = &_gc_queue_a;
-static Arena* _gc_queue_write = &_gc_queue_b;
+// GC state (TODO move into struct)
+static Arena _gc_queue; // SG_IDs decremented since the last SG_GC
+static DestroyQueue _gc_release_queue; // decrements waiting to be released
+static DestroyQueueBudget _gc_budget = { CHUGL_GC_BUDGET_MS, 0 };
 
 // storage arenas
 static Arena SG_XformArena;
@@ -759,6 +992,7 @@ static Arena SG_BufferArena;
 static Arena SG_LightArena;
 static Arena SG_VideoArena;
 static Arena SG_WebcamArena;
+static Arena SG_AudioTapArena;
 
 // locators (TODO switch to table)
 static hashmap* locator = NULL;
@@ -844,10 +1078,11 @@ void SG_Init(const Chuck_DL_Api* api)
     Arena::init(&SG_LightArena, sizeof(SG_Light) * 32);
     Arena::init(&SG_VideoArena, sizeof(SG_Video) * 16);
     Arena::init(&SG_WebcamArena, sizeof(SG_Webcam) * 8);
+    Arena::init(&SG_AudioTapArena, sizeof(SG_AudioTap) * 8);
 
     // init gc state
-    Arena::init(&_gc_queue_a, sizeof(SG_ID) * 64);
-    Arena::init(&_gc_queue_b, sizeof(SG_ID) * 64);
+    Arena::init(&_gc_queue, sizeof(SG_ID) * 64);
+    DestroyQueue_Init(&_gc_release_queue, false);
 }
 
 void SG_Free()
@@ -868,8 +1103,8 @@ void SG_Free()
     locator = NULL;
 
     // free gc state
-    Arena::free(&_gc_queue_a);
-    Arena::free(&_gc_queue_b);
+    Arena::free(&_gc_queue);
+    DestroyQueue_Free(&_gc_release_queue);
 }
 
 SG_Transform* SG_CreateTransform(Chuck_Object* ckobj)
@@ -1234,6 +1469,44 @@ SG_Video* SG_CreateVideo(Chuck_Object* ckobj, t_CKUINT id_offset)
     return video;
 }
 
+SG_AudioTap* SG_CreateAudioTap(Chuck_Object* ckobj, t_CKUINT id_offset)
+{
+    CK_DL_API API = g_chuglAPI;
+
+    Arena* arena     = &SG_AudioTapArena;
+    size_t offset    = arena->curr;
+    SG_AudioTap* tap = ARENA_PUSH_ZERO_TYPE(arena, SG_AudioTap);
+    *tap             = {};
+
+    // init base component
+    tap->ckobj = ckobj;
+    tap->id    = SG_GetNewComponentID();
+    tap->type  = SG_COMPONENT_AUDIO_TAP;
+
+    // AudioTap extends UGen, same special case as SG_Video
+    OBJ_MEMBER_UINT(ckobj, id_offset) = tap->id;
+
+    // ring is zeroed so the first uploads are silence
+    tap->ring       = ALLOCATE_TYPE(SG_AudioTapRing);
+    tap->rms_window = ALLOCATE_COUNT(f32, SG_AUDIO_TAP_MAX_WINDOW);
+
+    // store in map
+    SG_Location loc = { tap->id, offset, arena };
+    hashmap_set(locator, &loc);
+
+    return tap;
+}
+
+f32 SG_AudioTap::rms(SG_AudioTap* tap)
+{
+    f32* window = tap->rms_window;
+    tap->ring->latest(window, tap->window);
+
+    f32 sum = 0;
+    for (int i = 0; i < tap->window; i++) sum += window[i] * window[i];
+    return sqrtf(sum / tap->window);
+}
+
 SG_Webcam* SG_CreateWebcam(Chuck_Object* ckobj, Chuck_VM_Shred* shred, int device_id,
                            int width, int height, int fps)
 {
@@ -1424,6 +1697,13 @@ SG_Video* SG_GetVideo(SG_ID id)
     return (SG_Video*)component;
 }
 
+SG_AudioTap* SG_GetAudioTap(SG_ID id)
+{
+    SG_Component* component = SG_GetComponent(id);
+    ASSERT(component == NULL || component->type == SG_COMPONENT_AUDIO_TAP);
+    return (SG_AudioTap*)component;
+}
+
 SG_Webcam* SG_GetWebcam(SG_ID id)
 {
     SG_Component* component = SG_GetComponent(id);
@@ -1435,17 +1715,10 @@ SG_Webcam* SG_GetWebcam(SG_ID id)
 // SG Garbage Collector
 // ============================================================================
 
-static void _SG_SwapGCQueues()
-{
-    Arena* temp     = _gc_queue_read;
-    _gc_queue_read  = _gc_queue_write;
-    _gc_queue_write = temp;
-}
-
 void SG_DecrementRef(SG_ID id)
 {
     if (id == 0) return; // NULL component
-    *ARENA_PUSH_TYPE(_gc_queue_write, SG_ID) = id;
+    *ARENA_PUSH_TYPE(&_gc_queue, SG_ID) = id;
 }
 
 void SG_AddRef(SG_Component* comp)
@@ -1455,22 +1728,49 @@ void SG_AddRef(SG_Component* comp)
     _ck_api->object->add_ref(comp->ckobj);
 }
 
-void SG_GC()
+static void _SG_Release(u32 comp_id, void* udata)
+{
+    SG_Component* comp = SG_GetComponent(comp_id);
+    if (!comp) return; // already deleted
+    _ck_api->object->release(comp->ckobj);
+}
+
+static f64 _SG_ClockMs(void* udata)
 {
-    // swap queues
-    _SG_SwapGCQueues();
+    return stm_ms(stm_now());
+}
 
-    // release all objects in read queue
-    size_t count = ARENA_LENGTH(_gc_queue_read, SG_ID);
+void SG_GC()
+{
+    // queue this frame's decrements behind the ones still waiting. Releasing can
+    // decrement more refs (e.g. a material's textures), those go to _gc_queue and
+    // are queued next frame
+    size_t count = ARENA_LENGTH(&_gc_queue, SG_ID);
     for (size_t i = 0; i < count; i++) {
-        SG_ID comp_id      = *ARENA_GET_TYPE(_gc_queue_read, SG_ID, i);
-        SG_Component* comp = SG_GetComponent(comp_id);
-        if (!comp) continue; // already deleted
-        _ck_api->object->release(comp->ckobj);
+        SG_ID comp_id = *ARENA_GET_TYPE(&_gc_queue, SG_ID, i);
+        DestroyQueue_Push(&_gc_release_queue, comp_id, 0);
     }
+    Arena::clear(&_gc_queue);
+
+    // release as many as fit in the budget, the rest wait for the next frame so
+    // dropping a large scene doesn't stall a single frame
+    DestroyQueue_Process(&_gc_release_queue, _gc_budget, _SG_Release, NULL,
+                         _SG_ClockMs, NULL);
+}
+
+void SG_GCBudget(f64 ms)
+{
+    _gc_budget.max_ms = MAX(ms, 0.0);
+}
+
+f64 SG_GCBudget()
+{
+    return _gc_budget.max_ms;
+}
 
-    // clear read queue
-    Arena::clear(_gc_queue_read);
+int SG_GCQueueDepth()
+{
+    return ARENA_LENGTH(&_gc_queue, SG_ID) + DestroyQueue_Depth(&_gc_release_queue);
 }
 
 // frees resources within the locator hashmap and SG_Component arenas
@@ -1524,6 +1824,18 @@ void SG_ComponentFree(SG_Component* comp)
             SG_Shader::free((SG_Shader*)comp);
             _SG_ComponentManagerFree(comp->id, sizeof(SG_Shader));
         } break;
+        case SG_COMPONENT_AUDIO_TAP: {
+            SG_AudioTap* tap = (SG_AudioTap*)comp;
+
+            // the graphics thread may still be uploading from the ring, it frees
+            // the ring along with its R_AudioTap
+            CQ_PushCommand_ComponentFree(comp);
+
+            SG_DecrementRef(tap->texture_id);
+            SG_DecrementRef(tap->buffer_id);
+            FREE_ARRAY(f32, tap->rms_window, SG_AUDIO_TAP_MAX_WINDOW);
+            _SG_ComponentManagerFree(comp->id, sizeof(SG_AudioTap));
+        } break;
         default: break; // TODO impl other types
     }
 }
@@ -38,6 +38,8 @@
 
 #include <pl/pl_mpeg.h>
 
+#include <atomic>
+
 // forward decls
 struct SG_Light;
 struct SG_Camera;
@@ -78,7 +80,8 @@ typedef i32 SG_ID;
     X(SG_COMPONENT_LIGHT, "GLight")                                                    \
     X(SG_COMPONENT_MODEL, "GModel")                                                    \
     X(SG_COMPONENT_VIDEO, "Video")                                                     \
-    X(SG_COMPONENT_WEBCAM, "Webcam")
+    X(SG_COMPONENT_WEBCAM, "Webcam")                                                   \
+    X(SG_COMPONENT_AUDIO_TAP, "AudioTap")
 
 enum SG_ComponentType {
 #define X(name, str) name,
@@ -224,6 +227,10 @@ struct SG_Texture : SG_Component {
     Chuck_ArrayFloat* texture_data;
     Chuck_Event* texture_read_event;
 
+    // decoding / uploading an image file, cleared by SG_COMMAND_G2A_TEXTURE_LOADED
+    b32 loading;
+    Chuck_Event* load_event; // created on first Texture.loadEvent()
+
     static void updateTextureData(SG_Texture* texture, void* data, int data_size_bytes);
 };
 
@@ -237,10 +244,21 @@ struct SG_Transform : public SG_Component {
     glm::vec3 sca;
 
     // relationships
+    // children are an intrusive doubly linked list through the sibling ids, so
+    // attaching and detaching never scans the parent's children
     SG_ID parentID;
-    Arena childrenIDs;
+    SG_ID first_child_id;
+    SG_ID last_child_id;
+    SG_ID prev_sibling_id;
+    SG_ID next_sibling_id;
+    u32 child_count;
     SG_ID scene_id; // the scene this transform belongs to
 
+    // last child() lookup, so iterating children by index is O(1) per child.
+    // reset whenever the children list changes
+    SG_ID _child_cursor_id;
+    u32 _child_cursor_idx;
+
     // TODO: come up with staleness scheme that makes sense for scenegraph
 
     // don't init directly. Use SG Component Manager instead
@@ -296,6 +314,9 @@ struct SG_SceneDesc {
     SG_ID env_map_id;
     SG_Sampler env_map_sampler;
     SG_ID skybox_material_id;
+
+    // cull large opaque instanced meshes on the GPU, see instance_cull.h
+    b32 gpu_culling;
 };
 
 struct SG_Scene : public SG_Transform {
@@ -368,21 +389,59 @@ union SG_GeometryParams {
 
 #define CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS 4
 
+// Immutable, refcounted vertex or index data.
+// Geometry commands hand the block to the render thread by pointer instead of
+// copying its bytes into the command queue. The SG_Geometry, every command in
+// flight and the R_Geometry each own a ref, and the last release frees it.
+// Refcounting is atomic, the data never changes after the block is created
+struct SG_GeometryBlock {
+    std::atomic<i32> refcount;
+    u64 size; // bytes
+    u8* data;
+
+    // takes the arena's buffer (no copy) and leaves the arena empty. refcount
+    // starts at 1. NULL if the arena is empty
+    static SG_GeometryBlock* fromArena(Arena* arena);
+    static void addRef(SG_GeometryBlock* block);   // NULL ok
+    static void release(SG_GeometryBlock* block);  // NULL ok
+
+    // total bytes held by live blocks, across both threads
+    static i64 liveBytes();
+};
+
 struct SG_Geometry : SG_Component {
     SG_GeometryType geo_type;
     SG_GeometryParams params;
 
-    // buffers to hold vertex data
+    // staging buffers, written by setAttribute(), setIndices() and the builders,
+    // then moved into blocks by publishAttribute() / publishIndices()
     Arena vertex_attribute_data[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
     int vertex_attribute_num_components[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
     Arena indices;
 
+    // published data, i.e. the CPU copy, shared with the render thread
+    SG_GeometryBlock* vertex_attribute_blocks[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
+    SG_GeometryBlock* indices_block;
+    // sizes in bytes of the published data, kept after a static geometry drops it
+    u64 vertex_attribute_bytes[SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES];
+    u64 indices_bytes;
+
+    // if true, published data is not kept on the CPU, only uploaded
+    b32 is_static;
+
     // buffers to hold pull data
     Arena vertex_pull_buffers[CHUGL_GEOMETRY_MAX_PULLED_VERTEX_BUFFERS];
 
     int vertex_count = -1;
     int index_count  = -1;
 
+    // LOD chain (see mesh_lod.h). lod_geo_ids[i] replaces this geometry below
+    // lod_screen_sizes[i], which are kept decreasing. Holds a ref on each
+    SG_ID lod_geo_ids[CHUGL_GEOMETRY_MAX_LODS];
+    f32 lod_screen_sizes[CHUGL_GEOMETRY_MAX_LODS];
+    int lod_count;
+    f32 lod_cull_size; // instances smaller than this aren't drawn, 0 to never cull
+
     static u32 vertexCount(SG_Geometry* geo);
     static u32 indexCount(SG_Geometry* geo);
 
@@ -394,7 +453,28 @@ struct SG_Geometry : SG_Component {
                            int index_count);
     static u32* getIndices(SG_Geometry* geo);
 
+    // CPU copy of the attribute, NULL and 0 bytes if empty or static
     static f32* getAttributeData(SG_Geometry* geo, int location);
+    static u64 attributeBytes(SG_Geometry* geo, int location);
+
+    // moves the staging arena into a block that replaces the published data.
+    // Returns the block with a ref added for the caller (NULL if empty)
+    static SG_GeometryBlock* publishAttribute(SG_Geometry* geo, int location);
+    static SG_GeometryBlock* publishIndices(SG_Geometry* geo);
+
+    // drops the CPU copy, now and on every later publish
+    static void markStatic(SG_Geometry* geo);
+
+    // false if lod is NULL, geo itself, or the chain is full
+    static bool addLOD(SG_Geometry* geo, SG_Geometry* lod, f32 screen_size);
+    static void clearLODs(SG_Geometry* geo);
+
+    // writes a copy of src reduced to about `ratio` of its triangles (or points, if
+    // `points`) into dst's staging buffers, see mesh_lod.h. Only vertices still in
+    // use are kept. False if src has no CPU data (e.g. static) or, for triangles,
+    // no indices
+    static bool simplify(SG_Geometry* dst, SG_Geometry* src, f32 ratio,
+                         f32 max_error, bool points);
 
     // builder functions
     static void initGABandNumComponents(GeometryArenaBuilder* b, SG_Geometry* g,
@@ -416,9 +496,12 @@ struct SG_Geometry : SG_Component {
 // ============================================================================
 
 struct SG_ShaderIncludes {
-    bool lit;          // if true, renderer will pass lighting storage buffer
-    bool uses_env_map; // if true, renderer will pass env map texture
-    bool shadows;      // if true, renderer will pass shadow params
+    bool lit;              // if true, renderer will pass lighting storage buffer
+    bool uses_env_map;     // if true, renderer will pass env map texture
+    bool shadows;          // if true, renderer will pass shadow params
+    bool clustered_lights; // if true, renderer will pass per-cluster light lists
+    bool static_vertices;  // if true, vertex positions depend only on geometry and
+                           // model matrix, so renderer may cull/cache shadow casters
 };
 
 struct SG_Shader : SG_Component {
@@ -1001,6 +1084,78 @@ struct SG_Webcam : public SG_Component {
     char device_name[64];
 };
 
+// ============================================================================
+// SG AudioTap
+// ============================================================================
+
+#define SG_AUDIO_TAP_MIN_WINDOW 16
+#define SG_AUDIO_TAP_MAX_WINDOW 8192
+#define SG_AUDIO_TAP_DEFAULT_WINDOW 1024
+// must be a power of 2. 4x headroom so the graphics thread can copy out the latest
+// window while the audio thread keeps writing without overtaking the reader
+#define SG_AUDIO_TAP_RING_CAPACITY (4 * SG_AUDIO_TAP_MAX_WINDOW)
+
+enum SG_AudioTap_Mode : u8 {
+    SG_AudioTap_Mode_Waveform = 0, // raw samples, `window` values
+    SG_AudioTap_Mode_Spectrum,     // hann-windowed FFT magnitudes, `window / 2` values
+    SG_AudioTap_Mode_Count,
+};
+
+// Lock-free single-producer single-consumer sample ring.
+// The audio thread (tick) is the only writer, the graphics thread only ever reads
+// the most recent window. There is no read head: stale samples are simply
+// overwritten.
+struct SG_AudioTapRing {
+    f32 samples[SG_AUDIO_TAP_RING_CAPACITY];
+    std::atomic<u64> write_head; // total number of samples ever written
+
+    // audio thread only
+    void push(f32 sample)
+    {
+        u64 head = write_head.load(std::memory_order_relaxed);
+        samples[head & (SG_AUDIO_TAP_RING_CAPACITY - 1)] = sample;
+        write_head.store(head + 1, std::memory_order_release);
+    }
+
+    // copies the most recent `count` samples into `dst`, oldest first.
+    // returns the write head the copy ends at. Safe to call from either thread
+    u64 latest(f32* dst, int count)
+    {
+        ASSERT(count <= SG_AUDIO_TAP_RING_CAPACITY);
+        u64 head  = write_head.load(std::memory_order_acquire);
+        u64 start = head - MIN((u64)count, head);
+        int pad   = count - (int)(head - start); // not enough samples written yet
+        for (int i = 0; i < pad; i++) dst[i] = 0;
+        for (u64 i = start; i < head; i++) {
+            dst[pad + (i - start)] = samples[i & (SG_AUDIO_TAP_RING_CAPACITY - 1)];
+        }
+        return head;
+    }
+};
+
+struct SG_AudioTap : public SG_Component {
+    // malloc'd on audio thread, shared with the graphics thread. When the tap is
+    // freed the graphics thread takes it over, see SG_ComponentFree
+    SG_AudioTapRing* ring;
+    f32* rms_window; // SG_AUDIO_TAP_MAX_WINDOW samples, audio thread scratch for rms()
+
+    int window = SG_AUDIO_TAP_DEFAULT_WINDOW; // power of 2
+    SG_AudioTap_Mode mode;
+
+    // upload targets, uploaded by the graphics thread once per frame
+    SG_ID texture_id;
+    SG_ID buffer_id;
+
+    // number of f32 values uploaded per frame
+    static int valueCount(SG_AudioTap* tap)
+    {
+        return tap->mode == SG_AudioTap_Mode_Spectrum ? tap->window / 2 : tap->window;
+    }
+
+    // RMS over the most recent window. audio thread only
+    static f32 rms(SG_AudioTap* tap);
+};
+
 // ============================================================================
 // SG Component Manager
 // ============================================================================
@@ -1032,6 +1187,7 @@ SG_Light* SG_CreateLight(Chuck_Object* ckobj);
 SG_Video* SG_CreateVideo(Chuck_Object* ckobj, t_CKUINT id_offset);
 SG_Webcam* SG_CreateWebcam(Chuck_Object* ckobj, Chuck_VM_Shred* shred, int device_id,
                            int width, int height, int fps);
+SG_AudioTap* SG_CreateAudioTap(Chuck_Object* ckobj, t_CKUINT id_offset);
 
 SG_Component* SG_GetComponent(SG_ID id);
 SG_Transform* SG_GetTransform(SG_ID id);
@@ -1048,6 +1204,7 @@ SG_Buffer* SG_GetBuffer(SG_ID id);
 SG_Light* SG_GetLight(SG_ID id);
 SG_Video* SG_GetVideo(SG_ID id);
 SG_Webcam* SG_GetWebcam(SG_ID id);
+SG_AudioTap* SG_GetAudioTap(SG_ID id);
 
 // ============================================================================
 // SG Garbage Collection
@@ -1056,4 +1213,11 @@ SG_Webcam* SG_GetWebcam(SG_ID id);
 void SG_DecrementRef(SG_ID id);
 void SG_AddRef(SG_Component* comp);
 void SG_GC();
+
+// max time SG_GC spends releasing per frame, 0 for no limit
+void SG_GCBudget(f64 ms);
+f64 SG_GCBudget();
+
+// decrements not yet released
+int SG_GCQueueDepth();
 void SG_ComponentFree(SG_Component* comp);
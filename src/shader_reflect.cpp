@@ -0,0 +1,1050 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "shader_reflect.h"
+
+#include "core/memory.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// Module parsing
+// =============================================================================
+
+enum SR_TokenType : u8 {
+    SR_TOKEN_IDENT,
+    SR_TOKEN_NUMBER,
+    SR_TOKEN_PUNCT, // single character, e.g. '<' or '@'
+};
+
+struct SR_Token {
+    SR_TokenType type;
+    u32 start;
+    u32 len;
+};
+
+// token ranges are [begin, end)
+struct SR_Function {
+    int name;
+    int params_begin, params_end;
+    int body_begin, body_end;
+    u32 stage;                    // from @vertex, @fragment, @compute
+    int wg_begin, wg_end;         // @workgroup_size args, -1 if none
+    u64 sampled_params;           // bit i: param i is sampled with a sampler
+    b32 reachable;                // from the entry point being reflected
+};
+
+// module-scope var with @group and @binding
+struct SR_Resource {
+    int name;
+    int group, binding;
+    int addr_begin, addr_end; // inside var<...>, -1 if none
+    int type_begin, type_end;
+    b32 used;
+    b32 sampled;
+};
+
+struct SR_Struct {
+    int name;
+    int body_begin, body_end;
+};
+
+// module-scope const/override with an integer literal value, and aliases
+struct SR_Decl {
+    int name;
+    int begin, end; // value or aliased type
+};
+
+struct SR_Module {
+    const char* src;
+    ShaderReflection* refl;
+    Arena tokens;    // SR_Token
+    Arena functions; // SR_Function
+    Arena resources; // SR_Resource
+    Arena structs;   // SR_Struct
+    Arena consts;    // SR_Decl
+    Arena aliases;   // SR_Decl
+};
+
+static bool SR_Error(ShaderReflection* refl, const char* fmt, ...)
+{
+    if (refl->ok) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(refl->error, sizeof(refl->error), fmt, args);
+        va_end(args);
+    }
+    refl->ok = false;
+    return false;
+}
+
+static SR_Token* SR_Tok(SR_Module* m, int i)
+{
+    return ARENA_GET_TYPE(&m->tokens, SR_Token, i);
+}
+
+static int SR_TokenCount(SR_Module* m)
+{
+    return (int)ARENA_LENGTH(&m->tokens, SR_Token);
+}
+
+static bool SR_IsPunct(SR_Module* m, int i, char c)
+{
+    if (i < 0 || i >= SR_TokenCount(m)) return false;
+    SR_Token* t = SR_Tok(m, i);
+    return t->type == SR_TOKEN_PUNCT && m->src[t->start] == c;
+}
+
+static bool SR_IsIdent(SR_Module* m, int i, const char* ident)
+{
+    if (i < 0 || i >= SR_TokenCount(m)) return false;
+    SR_Token* t = SR_Tok(m, i);
+    return t->type == SR_TOKEN_IDENT && strlen(ident) == t->len
+           && strncmp(m->src + t->start, ident, t->len) == 0;
+}
+
+static bool SR_SameText(SR_Module* m, int a, int b)
+{
+    SR_Token* ta = SR_Tok(m, a);
+    SR_Token* tb = SR_Tok(m, b);
+    return ta->len == tb->len
+           && strncmp(m->src + ta->start, m->src + tb->start, ta->len) == 0;
+}
+
+// copies the text of tokens [begin, end) without whitespace
+static void SR_CopyText(SR_Module* m, int begin, int end, char* buf, int buf_len)
+{
+    int len = 0;
+    for (int i = begin; i < end && len < buf_len - 1; i++) {
+        SR_Token* t = SR_Tok(m, i);
+        int n       = MIN((int)t->len, buf_len - 1 - len);
+        memcpy(buf + len, m->src + t->start, n);
+        len += n;
+    }
+    buf[len] = '\0';
+}
+
+static bool SR_Tokenize(SR_Module* m)
+{
+    const char* s = m->src;
+    u32 i         = 0;
+    while (s[i]) {
+        char c = s[i];
+        if (isspace((unsigned char)c)) {
+            ++i;
+        } else if (c == '/' && s[i + 1] == '/') {
+            while (s[i] && s[i] != '\n') ++i;
+        } else if (c == '/' && s[i + 1] == '*') { // block comments nest in WGSL
+            int depth = 0;
+            do {
+                if (s[i] == '/' && s[i + 1] == '*') {
+                    ++depth;
+                    i += 2;
+                } else if (s[i] == '*' && s[i + 1] == '/') {
+                    --depth;
+                    i += 2;
+                } else {
+                    ++i;
+                }
+            } while (depth > 0 && s[i]);
+            if (depth > 0) return SR_Error(m->refl, "unterminated block comment");
+        } else if (c == '#') { // unresolved #include
+            while (s[i] && s[i] != '\n') ++i;
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            u32 start = i;
+            while (isalnum((unsigned char)s[i]) || s[i] == '_') ++i;
+            SR_Token* t = ARENA_PUSH_TYPE(&m->tokens, SR_Token);
+            *t          = { SR_TOKEN_IDENT, start, i - start };
+        } else if (isdigit((unsigned char)c)
+                   || (c == '.' && isdigit((unsigned char)s[i + 1]))) {
+            u32 start = i;
+            bool hex  = (c == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X'));
+            while (isalnum((unsigned char)s[i]) || s[i] == '.') {
+                ++i;
+                char e = s[i - 1];
+                bool exponent
+                  = hex ? (e == 'p' || e == 'P') : (e == 'e' || e == 'E');
+                if (exponent && (s[i] == '+' || s[i] == '-')) ++i;
+            }
+            SR_Token* t = ARENA_PUSH_TYPE(&m->tokens, SR_Token);
+            *t          = { SR_TOKEN_NUMBER, start, i - start };
+        } else {
+            *ARENA_PUSH_TYPE(&m->tokens, SR_Token) = { SR_TOKEN_PUNCT, i, 1 };
+            ++i;
+        }
+    }
+    return true;
+}
+
+// index of the token closing the bracket at `open`, or -1
+static int SR_MatchClose(SR_Module* m, int open)
+{
+    char open_c  = m->src[SR_Tok(m, open)->start];
+    char close_c = open_c == '(' ? ')' :
+                   open_c == '{' ? '}' :
+                   open_c == '[' ? ']' :
+                                   '>';
+    int depth    = 0;
+    for (int i = open; i < SR_TokenCount(m); i++) {
+        if (SR_IsPunct(m, i, open_c)) ++depth;
+        if (SR_IsPunct(m, i, close_c) && --depth == 0) return i;
+    }
+    return -1;
+}
+
+// index of the next `c` at bracket depth 0, or -1. Template brackets are only
+// counted if `angles` (i.e. when scanning a type, where '<' is never less-than)
+static int SR_Find(SR_Module* m, int begin, int end, char c, bool angles = false)
+{
+    int depth = 0;
+    for (int i = begin; i < end; i++) {
+        if (depth == 0 && SR_IsPunct(m, i, c)) return i;
+        if (SR_IsPunct(m, i, '(') || SR_IsPunct(m, i, '[') || SR_IsPunct(m, i, '{')
+            || (angles && SR_IsPunct(m, i, '<')))
+            ++depth;
+        if (SR_IsPunct(m, i, ')') || SR_IsPunct(m, i, ']') || SR_IsPunct(m, i, '}')
+            || (angles && SR_IsPunct(m, i, '>')))
+            --depth;
+    }
+    return -1;
+}
+
+static SR_Decl* SR_FindDecl(SR_Module* m, Arena* decls, int name_tok)
+{
+    for (int i = 0; i < (int)ARENA_LENGTH(decls, SR_Decl); i++) {
+        SR_Decl* d = ARENA_GET_TYPE(decls, SR_Decl, i);
+        if (SR_SameText(m, d->name, name_tok)) return d;
+    }
+    return NULL;
+}
+
+static SR_Function* SR_FindFunction(SR_Module* m, int name_tok)
+{
+    for (int i = 0; i < (int)ARENA_LENGTH(&m->functions, SR_Function); i++) {
+        SR_Function* f = ARENA_GET_TYPE(&m->functions, SR_Function, i);
+        if (SR_SameText(m, f->name, name_tok)) return f;
+    }
+    return NULL;
+}
+
+static SR_Resource* SR_FindResource(SR_Module* m, int name_tok)
+{
+    for (int i = 0; i < (int)ARENA_LENGTH(&m->resources, SR_Resource); i++) {
+        SR_Resource* r = ARENA_GET_TYPE(&m->resources, SR_Resource, i);
+        if (SR_SameText(m, r->name, name_tok)) return r;
+    }
+    return NULL;
+}
+
+static SR_Struct* SR_FindStruct(SR_Module* m, int name_tok)
+{
+    for (int i = 0; i < (int)ARENA_LENGTH(&m->structs, SR_Struct); i++) {
+        SR_Struct* s = ARENA_GET_TYPE(&m->structs, SR_Struct, i);
+        if (SR_SameText(m, s->name, name_tok)) return s;
+    }
+    return NULL;
+}
+
+// integer literal or module-scope const, e.g. the args of @binding(2) or
+// @workgroup_size(WORKGROUP_X, 8)
+static bool SR_EvalInt(SR_Module* m, int begin, int end, i64* out)
+{
+    if (end - begin != 1) return false;
+    SR_Token* t = SR_Tok(m, begin);
+    if (t->type == SR_TOKEN_NUMBER) {
+        char buf[32] = {};
+        SR_CopyText(m, begin, end, buf, sizeof(buf));
+        char* num_end = NULL;
+        *out          = strtoll(buf, &num_end, 0);
+        return num_end != buf
+               && (*num_end == '\0' || *num_end == 'u' || *num_end == 'i');
+    }
+    if (t->type == SR_TOKEN_IDENT) {
+        SR_Decl* c = SR_FindDecl(m, &m->consts, begin);
+        return c && SR_EvalInt(m, c->begin, c->end, out);
+    }
+    return false;
+}
+
+struct SR_Attributes {
+    int group, binding, location;
+    b32 builtin;
+    u32 stage;
+    int wg_begin, wg_end;
+};
+
+// parses consecutive @attributes starting at *i, advancing past them
+static bool SR_ParseAttributes(SR_Module* m, int* i, SR_Attributes* attrs)
+{
+    *attrs = { -1, -1, -1, false, 0, -1, -1 };
+    while (SR_IsPunct(m, *i, '@')) {
+        int name = *i + 1;
+        if (name >= SR_TokenCount(m) || SR_Tok(m, name)->type != SR_TOKEN_IDENT)
+            return SR_Error(m->refl, "expected attribute name");
+        *i             = name + 1;
+        int args_begin = -1, args_end = -1;
+        if (SR_IsPunct(m, *i, '(')) {
+            int close = SR_MatchClose(m, *i);
+            if (close < 0) return SR_Error(m->refl, "unbalanced attribute arguments");
+            args_begin = *i + 1;
+            args_end   = close;
+            // trailing commas are allowed
+            if (SR_IsPunct(m, args_end - 1, ',')) --args_end;
+            *i = close + 1;
+        }
+
+        i64 value = 0;
+        if (SR_IsIdent(m, name, "group") || SR_IsIdent(m, name, "binding")
+            || SR_IsIdent(m, name, "location")) {
+            if (!SR_EvalInt(m, args_begin, args_end, &value) || value < 0) {
+                char attr[16] = {};
+                SR_CopyText(m, name, name + 1, attr, sizeof(attr));
+                return SR_Error(m->refl, "unsupported @%s argument", attr);
+            }
+            if (SR_IsIdent(m, name, "group")) attrs->group = (int)value;
+            if (SR_IsIdent(m, name, "binding")) attrs->binding = (int)value;
+            if (SR_IsIdent(m, name, "location")) attrs->location = (int)value;
+        } else if (SR_IsIdent(m, name, "builtin")) {
+            attrs->builtin = true;
+        } else if (SR_IsIdent(m, name, "vertex")) {
+            attrs->stage = SHADER_STAGE_VERTEX;
+        } else if (SR_IsIdent(m, name, "fragment")) {
+            attrs->stage = SHADER_STAGE_FRAGMENT;
+        } else if (SR_IsIdent(m, name, "compute")) {
+            attrs->stage = SHADER_STAGE_COMPUTE;
+        } else if (SR_IsIdent(m, name, "workgroup_size")) {
+            attrs->wg_begin = args_begin;
+            attrs->wg_end   = args_end;
+        }
+    }
+    return true;
+}
+
+static bool SR_ParseModule(SR_Module* m)
+{
+    if (!SR_Tokenize(m)) return false;
+
+    int n = SR_TokenCount(m);
+    int i = 0;
+    while (i < n) {
+        SR_Attributes attrs = {};
+        if (!SR_ParseAttributes(m, &i, &attrs)) return false;
+        if (i >= n) return SR_Error(m->refl, "unexpected end of module");
+
+        if (SR_IsIdent(m, i, "struct")) {
+            if (!SR_IsPunct(m, i + 2, '{'))
+                return SR_Error(m->refl, "malformed struct");
+            int close = SR_MatchClose(m, i + 2);
+            if (close < 0) return SR_Error(m->refl, "unbalanced struct braces");
+            *ARENA_PUSH_TYPE(&m->structs, SR_Struct) = { i + 1, i + 3, close };
+            i = close + 1;
+        } else if (SR_IsIdent(m, i, "fn")) {
+            if (!SR_IsPunct(m, i + 2, '(')) return SR_Error(m->refl, "malformed fn");
+            int params_close = SR_MatchClose(m, i + 2);
+            int body_open
+              = params_close < 0 ? -1 : SR_Find(m, params_close + 1, n, '{');
+            int body_close   = body_open < 0 ? -1 : SR_MatchClose(m, body_open);
+            if (body_close < 0) return SR_Error(m->refl, "unbalanced fn");
+
+            SR_Function* f    = ARENA_PUSH_ZERO_TYPE(&m->functions, SR_Function);
+            f->name           = i + 1;
+            f->params_begin   = i + 3;
+            f->params_end     = params_close;
+            f->body_begin     = body_open + 1;
+            f->body_end       = body_close;
+            f->stage          = attrs.stage;
+            f->wg_begin       = attrs.wg_begin;
+            f->wg_end         = attrs.wg_end;
+            i                 = body_close + 1;
+        } else if (SR_IsIdent(m, i, "var")) {
+            int j          = i + 1;
+            int addr_begin = -1, addr_end = -1;
+            if (SR_IsPunct(m, j, '<')) {
+                int close = SR_MatchClose(m, j);
+                if (close < 0) return SR_Error(m->refl, "malformed var");
+                addr_begin = j + 1;
+                addr_end   = close;
+                j          = close + 1;
+            }
+            int name = j;
+            int semi = SR_Find(m, name, n, ';');
+            if (semi < 0) return SR_Error(m->refl, "missing ';' after var");
+            if (attrs.group >= 0 && attrs.binding >= 0) {
+                if (!SR_IsPunct(m, name + 1, ':'))
+                    return SR_Error(m->refl, "resource var without a type");
+                int type_end = SR_Find(m, name + 2, semi, '=', true);
+                SR_Resource* r = ARENA_PUSH_ZERO_TYPE(&m->resources, SR_Resource);
+                r->name        = name;
+                r->group       = attrs.group;
+                r->binding     = attrs.binding;
+                r->addr_begin  = addr_begin;
+                r->addr_end    = addr_end;
+                r->type_begin  = name + 2;
+                r->type_end    = type_end < 0 ? semi : type_end;
+            }
+            i = semi + 1;
+        } else if (SR_IsIdent(m, i, "const") || SR_IsIdent(m, i, "override")
+                   || SR_IsIdent(m, i, "alias")) {
+            int semi = SR_Find(m, i, n, ';');
+            int eq   = semi < 0 ? -1 : SR_Find(m, i, semi, '=', true);
+            if (eq < 0) {
+                // overrides may omit the initializer
+                if (semi < 0 || !SR_IsIdent(m, i, "override"))
+                    return SR_Error(m->refl, "malformed module-scope declaration");
+            } else {
+                Arena* decls = SR_IsIdent(m, i, "alias") ? &m->aliases : &m->consts;
+                *ARENA_PUSH_TYPE(decls, SR_Decl) = { i + 1, eq + 1, semi };
+            }
+            i = semi + 1;
+        } else if (SR_IsIdent(m, i, "enable") || SR_IsIdent(m, i, "requires")
+                   || SR_IsIdent(m, i, "diagnostic")
+                   || SR_IsIdent(m, i, "const_assert")) {
+            int semi = SR_Find(m, i, n, ';');
+            if (semi < 0) return SR_Error(m->refl, "missing ';'");
+            i = semi + 1;
+        } else if (SR_IsPunct(m, i, ';')) {
+            ++i;
+        } else {
+            char tok[24] = {};
+            SR_CopyText(m, i, i + 1, tok, sizeof(tok));
+            return SR_Error(m->refl, "unexpected '%s' at module scope", tok);
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// Types
+// =============================================================================
+
+struct SR_Type {
+    ShaderBindingKind kind; // NONE for plain values
+    ShaderValueType value;
+    ShaderSampleType sample_type;
+    ShaderTextureDim view_dim;
+    b8 multisampled;
+    ShaderStorageAccess access;
+    char storage_format[16];
+};
+
+static ShaderScalar SR_ScalarFromSuffix(char c)
+{
+    switch (c) {
+        case 'f': return SHADER_SCALAR_F32;
+        case 'h': return SHADER_SCALAR_F16;
+        case 'i': return SHADER_SCALAR_I32;
+        case 'u': return SHADER_SCALAR_U32;
+        default: return SHADER_SCALAR_NONE;
+    }
+}
+
+static ShaderScalar SR_ScalarFromName(SR_Module* m, int tok)
+{
+    if (SR_IsIdent(m, tok, "f32")) return SHADER_SCALAR_F32;
+    if (SR_IsIdent(m, tok, "f16")) return SHADER_SCALAR_F16;
+    if (SR_IsIdent(m, tok, "i32")) return SHADER_SCALAR_I32;
+    if (SR_IsIdent(m, tok, "u32")) return SHADER_SCALAR_U32;
+    if (SR_IsIdent(m, tok, "bool")) return SHADER_SCALAR_BOOL;
+    return SHADER_SCALAR_NONE;
+}
+
+static ShaderTextureDim SR_TextureDim(const char* suffix, b8* multisampled)
+{
+    *multisampled = false;
+    if (strcmp(suffix, "1d") == 0) return SHADER_TEXTURE_DIM_1D;
+    if (strcmp(suffix, "2d") == 0) return SHADER_TEXTURE_DIM_2D;
+    if (strcmp(suffix, "2d_array") == 0) return SHADER_TEXTURE_DIM_2D_ARRAY;
+    if (strcmp(suffix, "3d") == 0) return SHADER_TEXTURE_DIM_3D;
+    if (strcmp(suffix, "cube") == 0) return SHADER_TEXTURE_DIM_CUBE;
+    if (strcmp(suffix, "cube_array") == 0) return SHADER_TEXTURE_DIM_CUBE_ARRAY;
+    if (strcmp(suffix, "multisampled_2d") == 0) {
+        *multisampled = true;
+        return SHADER_TEXTURE_DIM_2D;
+    }
+    return SHADER_TEXTURE_DIM_NONE;
+}
+
+static bool SR_ParseType(SR_Module* m, int begin, int end, SR_Type* type, int depth = 0)
+{
+    *type = {};
+    if (begin >= end || SR_Tok(m, begin)->type != SR_TOKEN_IDENT || depth > 8)
+        return SR_Error(m->refl, "malformed type");
+
+    char name[SHADER_REFLECT_NAME_LEN] = {};
+    SR_CopyText(m, begin, begin + 1, name, sizeof(name));
+    int name_len = (int)strlen(name);
+
+    // template args, e.g. the f32 in vec3<f32> or texture_2d<f32>
+    int args_begin = -1, args_end = -1;
+    if (SR_IsPunct(m, begin + 1, '<')) {
+        args_begin = begin + 2;
+        args_end   = SR_MatchClose(m, begin + 1);
+        if (args_end < 0 || args_end >= end) return SR_Error(m->refl, "malformed type");
+    }
+
+    SR_Decl* alias = SR_FindDecl(m, &m->aliases, begin);
+    if (alias) return SR_ParseType(m, alias->begin, alias->end, type, depth + 1);
+
+    // scalars
+    type->value.scalar = SR_ScalarFromName(m, begin);
+    if (type->value.scalar) {
+        type->value.rows = type->value.cols = 1;
+        return true;
+    }
+
+    // vecN<T>, vecNf, vecNh, vecNi, vecNu
+    if (strncmp(name, "vec", 3) == 0 && name_len >= 4 && name_len <= 5
+        && name[3] >= '2' && name[3] <= '4') {
+        type->value.scalar = name_len == 5 ? SR_ScalarFromSuffix(name[4]) :
+                             args_begin >= 0 ? SR_ScalarFromName(m, args_begin) :
+                                               SHADER_SCALAR_NONE;
+        type->value.rows   = name[3] - '0';
+        type->value.cols   = 1;
+        return true;
+    }
+
+    // matCxR<T>, matCxRf, matCxRh
+    if (strncmp(name, "mat", 3) == 0 && name_len >= 6 && name_len <= 7
+        && name[4] == 'x') {
+        type->value.scalar = name_len == 7 ? SR_ScalarFromSuffix(name[6]) :
+                             args_begin >= 0 ? SR_ScalarFromName(m, args_begin) :
+                                               SHADER_SCALAR_NONE;
+        type->value.cols   = name[3] - '0';
+        type->value.rows   = name[5] - '0';
+        return true;
+    }
+
+    if (strcmp(name, "sampler") == 0) {
+        type->kind = SHADER_BINDING_SAMPLER;
+        return true;
+    }
+    if (strcmp(name, "sampler_comparison") == 0) {
+        type->kind = SHADER_BINDING_COMPARISON_SAMPLER;
+        return true;
+    }
+
+    if (strncmp(name, "texture_", 8) == 0) {
+        if (strcmp(name, "texture_external") == 0) {
+            return SR_Error(m->refl, "texture_external is not supported");
+        }
+
+        if (strncmp(name, "texture_depth_", 14) == 0) {
+            type->kind        = SHADER_BINDING_TEXTURE;
+            type->sample_type = SHADER_SAMPLE_DEPTH;
+            type->view_dim    = SR_TextureDim(name + 14, &type->multisampled);
+        } else if (strncmp(name, "texture_storage_", 16) == 0) {
+            type->kind     = SHADER_BINDING_STORAGE_TEXTURE;
+            type->view_dim = SR_TextureDim(name + 16, &type->multisampled);
+            int comma
+              = args_begin < 0 ? -1 : SR_Find(m, args_begin, args_end, ',');
+            if (comma != args_begin + 1 || args_end != comma + 2)
+                return SR_Error(m->refl, "malformed %s", name);
+            SR_CopyText(m, args_begin, comma, type->storage_format,
+                        sizeof(type->storage_format));
+            int access = comma + 1;
+            type->access
+              = SR_IsIdent(m, access, "write")      ? SHADER_ACCESS_WRITE :
+                SR_IsIdent(m, access, "read")       ? SHADER_ACCESS_READ :
+                SR_IsIdent(m, access, "read_write") ? SHADER_ACCESS_READ_WRITE :
+                                                      SHADER_ACCESS_NONE;
+            if (!type->access)
+                return SR_Error(m->refl, "unknown storage texture access");
+        } else {
+            type->kind          = SHADER_BINDING_TEXTURE;
+            type->view_dim      = SR_TextureDim(name + 8, &type->multisampled);
+            ShaderScalar scalar = args_begin >= 0 ? SR_ScalarFromName(m, args_begin) :
+                                                    SHADER_SCALAR_NONE;
+            // f32 is resolved to float or unfilterable-float by usage
+            type->sample_type
+              = scalar == SHADER_SCALAR_F32 ? SHADER_SAMPLE_UNFILTERABLE_FLOAT :
+                scalar == SHADER_SCALAR_I32 ? SHADER_SAMPLE_SINT :
+                scalar == SHADER_SCALAR_U32 ? SHADER_SAMPLE_UINT :
+                                              SHADER_SAMPLE_NONE;
+            if (!type->sample_type) return SR_Error(m->refl, "malformed %s", name);
+        }
+        if (!type->view_dim) return SR_Error(m->refl, "unknown texture type %s", name);
+        return true;
+    }
+
+    // structs, arrays, atomics: valid buffer contents, but nothing to check against
+    return true;
+}
+
+// =============================================================================
+// Static use
+// =============================================================================
+
+// splits [begin, end) on top-level commas. Returns the number of items, writing
+// up to max_items ranges
+static int SR_Split(SR_Module* m, int begin, int end, int (*ranges)[2], int max_items)
+{
+    int count = 0;
+    while (begin < end) {
+        int comma = SR_Find(m, begin, end, ',', false);
+        int item_end = comma < 0 ? end : comma;
+        if (count < max_items) {
+            ranges[count][0] = begin;
+            ranges[count][1] = item_end;
+        }
+        ++count;
+        begin = item_end + 1;
+    }
+    return count;
+}
+
+// name token of each param of f, skipping attributes
+static int SR_ParamNames(SR_Module* m, SR_Function* f, int* names, int max_names)
+{
+    int ranges[64][2];
+    int count = SR_Split(m, f->params_begin, f->params_end, ranges, 64);
+    count     = MIN(count, MIN(max_names, 64));
+    for (int p = 0; p < count; p++) {
+        int i               = ranges[p][0];
+        SR_Attributes attrs = {};
+        SR_ParseAttributes(m, &i, &attrs);
+        names[p] = i;
+    }
+    return count;
+}
+
+static int SR_ParamIndex(SR_Module* m, SR_Function* f, int name_tok)
+{
+    int names[64];
+    int count = SR_ParamNames(m, f, names, 64);
+    for (int p = 0; p < count; p++) {
+        if (SR_SameText(m, names[p], name_tok)) return p;
+    }
+    return -1;
+}
+
+static bool SR_IsSampleBuiltin(SR_Module* m, int i)
+{
+    return SR_IsIdent(m, i, "textureSample") || SR_IsIdent(m, i, "textureSampleBias")
+           || SR_IsIdent(m, i, "textureSampleGrad")
+           || SR_IsIdent(m, i, "textureSampleLevel")
+           || SR_IsIdent(m, i, "textureSampleBaseClampToEdge")
+           || SR_IsIdent(m, i, "textureGather");
+}
+
+// `arg` is a texture passed to a sampling call inside f. Marks it sampled if it
+// is a resource, or marks the param of f it names. Returns true if changed
+static bool SR_MarkSampled(SR_Module* m, SR_Function* f, int arg_begin, int arg_end)
+{
+    if (arg_end - arg_begin != 1 || SR_Tok(m, arg_begin)->type != SR_TOKEN_IDENT)
+        return false;
+
+    int param = SR_ParamIndex(m, f, arg_begin);
+    if (param >= 0) {
+        u64 bit = 1ULL << param;
+        if (f->sampled_params & bit) return false;
+        f->sampled_params |= bit;
+        return true;
+    }
+
+    SR_Resource* r = SR_FindResource(m, arg_begin);
+    if (r && !r->sampled) {
+        r->sampled = true;
+        return true;
+    }
+    return false;
+}
+
+// marks the functions reachable from entry and the resources they use
+static void SR_StaticUse(SR_Module* m, SR_Function* entry)
+{
+    int fn_count = (int)ARENA_LENGTH(&m->functions, SR_Function);
+    for (int i = 0; i < fn_count; i++) {
+        ARENA_GET_TYPE(&m->functions, SR_Function, i)->reachable = false;
+    }
+    for (int i = 0; i < (int)ARENA_LENGTH(&m->resources, SR_Resource); i++) {
+        SR_Resource* r = ARENA_GET_TYPE(&m->resources, SR_Resource, i);
+        r->used = r->sampled = false;
+    }
+
+    // worklist of function indices. Each function is pushed at most once
+    int* worklist     = ALLOCATE_COUNT(int, fn_count);
+    int worklist_len  = 0;
+    entry->reachable  = true;
+    worklist[worklist_len++] = (int)(entry - (SR_Function*)m->functions.base);
+
+    while (worklist_len > 0) {
+        int fi         = worklist[--worklist_len];
+        SR_Function* f = ARENA_GET_TYPE(&m->functions, SR_Function, fi);
+        for (int i = f->body_begin; i < f->body_end; i++) {
+            if (SR_Tok(m, i)->type != SR_TOKEN_IDENT || SR_IsPunct(m, i - 1, '.'))
+                continue; // skip member accesses
+
+            SR_Function* callee = SR_FindFunction(m, i);
+            if (callee && !callee->reachable) {
+                callee->reachable        = true;
+                worklist[worklist_len++]
+                  = (int)(callee - (SR_Function*)m->functions.base);
+            }
+
+            // conservatively ignores locals that shadow a resource name
+            SR_Resource* r = SR_FindResource(m, i);
+            if (r) r->used = true;
+        }
+    }
+    FREE_ARRAY(int, worklist, fn_count);
+
+    // textures sampled directly, or passed to a function that samples its param
+    bool changed = true;
+    for (int iter = 0; changed && iter <= fn_count; iter++) {
+        changed = false;
+        for (int fi = 0; fi < fn_count; fi++) {
+            SR_Function* f = ARENA_GET_TYPE(&m->functions, SR_Function, fi);
+            if (!f->reachable) continue;
+
+            for (int i = f->body_begin; i < f->body_end; i++) {
+                if (!SR_IsPunct(m, i + 1, '(') || SR_IsPunct(m, i - 1, '.')) continue;
+                int close = SR_MatchClose(m, i + 1);
+                if (close < 0) continue;
+
+                int args[16][2];
+                int arg_count = MIN(SR_Split(m, i + 2, close, args, 16), 16);
+                if (SR_IsSampleBuiltin(m, i)) {
+                    // textureGather's optional first arg is the component
+                    bool gather = SR_IsIdent(m, i, "textureGather");
+                    int tex     = (gather && arg_count == 4) ? 1 : 0;
+                    if (arg_count > tex)
+                        changed |= SR_MarkSampled(m, f, args[tex][0], args[tex][1]);
+                    continue;
+                }
+
+                SR_Function* callee = SR_FindFunction(m, i);
+                if (!callee || callee->sampled_params == 0) continue;
+                for (int a = 0; a < arg_count; a++) {
+                    if (callee->sampled_params & (1ULL << a))
+                        changed |= SR_MarkSampled(m, f, args[a][0], args[a][1]);
+                }
+            }
+        }
+    }
+}
+
+// =============================================================================
+// Reflection
+// =============================================================================
+
+static void SR_CopyName(SR_Module* m, int tok, char* buf, int buf_len)
+{
+    SR_CopyText(m, tok, tok + 1, buf, buf_len);
+}
+
+static bool SR_AddBinding(SR_Module* m, SR_Resource* r, ShaderStage stage)
+{
+    ShaderReflection* refl = m->refl;
+
+    SR_Type type = {};
+    if (!SR_ParseType(m, r->type_begin, r->type_end, &type)) return false;
+
+    ShaderBinding b = {};
+    b.group         = (u32)r->group;
+    b.binding       = (u32)r->binding;
+    b.visibility    = stage;
+    b.kind          = type.kind;
+    b.type          = type.value;
+    b.sample_type   = type.sample_type;
+    b.view_dim      = type.view_dim;
+    b.multisampled  = type.multisampled;
+    b.access        = type.access;
+    memcpy(b.storage_format, type.storage_format, sizeof(b.storage_format));
+    SR_CopyName(m, r->name, b.name, sizeof(b.name));
+    SR_CopyText(m, r->type_begin, r->type_end, b.type_name, sizeof(b.type_name));
+
+    if (b.kind == SHADER_BINDING_NONE) { // var<uniform> or var<storage, ...>
+        if (r->addr_begin >= 0 && SR_IsIdent(m, r->addr_begin, "uniform")) {
+            b.kind = SHADER_BINDING_UNIFORM_BUFFER;
+        } else if (r->addr_begin >= 0 && SR_IsIdent(m, r->addr_begin, "storage")) {
+            b.kind = SR_IsIdent(m, r->addr_end - 1, "read_write") ?
+                       SHADER_BINDING_STORAGE_BUFFER :
+                       SHADER_BINDING_READ_ONLY_STORAGE_BUFFER;
+        } else {
+            return SR_Error(refl, "%s has no address space", b.name);
+        }
+    }
+
+    if (b.group >= SHADER_REFLECT_MAX_GROUPS)
+        return SR_Error(refl, "%s: @group(%d) out of range", b.name, b.group);
+
+    if (b.kind == SHADER_BINDING_TEXTURE && r->sampled
+        && b.sample_type == SHADER_SAMPLE_UNFILTERABLE_FLOAT)
+        b.sample_type = SHADER_SAMPLE_FLOAT;
+
+    // merge with the same binding from another stage
+    ShaderBinding* existing = ShaderReflect_FindBinding(refl, b.group, b.binding);
+    if (existing) {
+        if (existing->visibility & stage)
+            return SR_Error(refl, "@group(%d) @binding(%d) declared twice", b.group,
+                            b.binding);
+        if (existing->kind != b.kind || existing->view_dim != b.view_dim)
+            return SR_Error(refl, "@group(%d) @binding(%d) differs between stages",
+                            b.group, b.binding);
+        existing->visibility |= stage;
+        if (b.sample_type == SHADER_SAMPLE_FLOAT) existing->sample_type = b.sample_type;
+        return true;
+    }
+
+    if (refl->binding_count >= SHADER_REFLECT_MAX_BINDINGS)
+        return SR_Error(refl, "too many bindings");
+
+    // insert sorted by group, then binding
+    int idx = refl->binding_count++;
+    while (idx > 0
+           && (refl->bindings[idx - 1].group > b.group
+               || (refl->bindings[idx - 1].group == b.group
+                   && refl->bindings[idx - 1].binding > b.binding))) {
+        refl->bindings[idx] = refl->bindings[idx - 1];
+        --idx;
+    }
+    refl->bindings[idx] = b;
+    refl->group_count   = MAX(refl->group_count, (int)b.group + 1);
+    return true;
+}
+
+static bool SR_AddVertexInput(SR_Module* m, int location, int name, int type_begin,
+                              int type_end)
+{
+    ShaderReflection* refl = m->refl;
+    if (refl->vertex_input_count >= SHADER_REFLECT_MAX_VERTEX_INPUTS)
+        return SR_Error(refl, "too many vertex inputs");
+
+    SR_Type type = {};
+    if (!SR_ParseType(m, type_begin, type_end, &type)) return false;
+
+    ShaderVertexInput input = {};
+    input.location          = (u32)location;
+    input.type              = type.value;
+    SR_CopyName(m, name, input.name, sizeof(input.name));
+
+    int idx = refl->vertex_input_count++;
+    while (idx > 0 && refl->vertex_inputs[idx - 1].location > input.location) {
+        refl->vertex_inputs[idx] = refl->vertex_inputs[idx - 1];
+        --idx;
+    }
+    refl->vertex_inputs[idx] = input;
+    return true;
+}
+
+// `@location(n) name : type` params, or struct params with @location members
+static bool SR_ReflectVertexInputs(SR_Module* m, SR_Function* entry)
+{
+    m->refl->vertex_input_count = 0;
+
+    int params[32][2];
+    int param_count
+      = MIN(SR_Split(m, entry->params_begin, entry->params_end, params, 32), 32);
+    for (int p = 0; p < param_count; p++) {
+        int i               = params[p][0];
+        SR_Attributes attrs = {};
+        if (!SR_ParseAttributes(m, &i, &attrs)) return false;
+        if (attrs.builtin) continue;
+        if (!SR_IsPunct(m, i + 1, ':')) return SR_Error(m->refl, "malformed param");
+
+        if (attrs.location >= 0) {
+            if (!SR_AddVertexInput(m, attrs.location, i, i + 2, params[p][1]))
+                return false;
+            continue;
+        }
+
+        SR_Struct* s = SR_FindStruct(m, i + 2);
+        if (!s) return SR_Error(m->refl, "vertex input without @location");
+
+        int members[32][2];
+        int member_count
+          = MIN(SR_Split(m, s->body_begin, s->body_end, members, 32), 32);
+        for (int mi = 0; mi < member_count; mi++) {
+            int j                      = members[mi][0];
+            SR_Attributes member_attrs = {};
+            if (!SR_ParseAttributes(m, &j, &member_attrs)) return false;
+            if (member_attrs.location < 0) continue;
+            if (!SR_AddVertexInput(m, member_attrs.location, j, j + 2, members[mi][1]))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void SR_ReflectWorkgroupSize(SR_Module* m, SR_Function* entry)
+{
+    u32* size = m->refl->workgroup_size;
+    size[0] = size[1] = size[2] = 0;
+    if (entry->wg_begin < 0) return;
+
+    int args[3][2];
+    int count = SR_Split(m, entry->wg_begin, entry->wg_end, args, 3);
+    if (count < 1 || count > 3) return;
+
+    u32 result[3] = { 1, 1, 1 };
+    for (int i = 0; i < count; i++) {
+        i64 value = 0;
+        // e.g. override-sized workgroups can't be known until pipeline creation
+        if (!SR_EvalInt(m, args[i][0], args[i][1], &value) || value <= 0) return;
+        result[i] = (u32)value;
+    }
+    memcpy(size, result, sizeof(result));
+}
+
+void ShaderReflect_Init(ShaderReflection* refl)
+{
+    *refl    = {};
+    refl->ok = true;
+}
+
+bool ShaderReflect_AddEntryPoint(ShaderReflection* refl, const char* wgsl,
+                                 ShaderStage stage, const char* entry_point)
+{
+    if (!refl->ok) return false;
+    if (!wgsl) return SR_Error(refl, "no source for entry point %s", entry_point);
+
+    static SR_Module m = {};
+    if (m.tokens.base == NULL) {
+        Arena::init(&m.tokens, 1024 * sizeof(SR_Token));
+        Arena::init(&m.functions, 32 * sizeof(SR_Function));
+        Arena::init(&m.resources, 32 * sizeof(SR_Resource));
+        Arena::init(&m.structs, 16 * sizeof(SR_Struct));
+        Arena::init(&m.consts, 32 * sizeof(SR_Decl));
+        Arena::init(&m.aliases, 8 * sizeof(SR_Decl));
+    }
+    Arena::clear(&m.tokens);
+    Arena::clear(&m.functions);
+    Arena::clear(&m.resources);
+    Arena::clear(&m.structs);
+    Arena::clear(&m.consts);
+    Arena::clear(&m.aliases);
+    m.src  = wgsl;
+    m.refl = refl;
+
+    if (!SR_ParseModule(&m)) return false;
+
+    SR_Function* entry = NULL;
+    for (int i = 0; i < (int)ARENA_LENGTH(&m.functions, SR_Function); i++) {
+        SR_Function* f = ARENA_GET_TYPE(&m.functions, SR_Function, i);
+        if (SR_IsIdent(&m, f->name, entry_point)) entry = f;
+    }
+    if (!entry) return SR_Error(refl, "entry point %s not found", entry_point);
+    if (entry->stage != stage)
+        return SR_Error(refl, "%s is not a %s entry point", entry_point,
+                        stage == SHADER_STAGE_VERTEX   ? "@vertex" :
+                        stage == SHADER_STAGE_FRAGMENT ? "@fragment" :
+                                                         "@compute");
+
+    SR_StaticUse(&m, entry);
+    for (int i = 0; i < (int)ARENA_LENGTH(&m.resources, SR_Resource); i++) {
+        SR_Resource* r = ARENA_GET_TYPE(&m.resources, SR_Resource, i);
+        if (r->used && !SR_AddBinding(&m, r, stage)) return false;
+    }
+
+    if (stage == SHADER_STAGE_VERTEX && !SR_ReflectVertexInputs(&m, entry))
+        return false;
+    if (stage == SHADER_STAGE_COMPUTE) SR_ReflectWorkgroupSize(&m, entry);
+
+    refl->stages |= stage;
+    return refl->ok;
+}
+
+ShaderBinding* ShaderReflect_FindBinding(ShaderReflection* refl, u32 group,
+                                         u32 binding)
+{
+    for (int i = 0; i < refl->binding_count; i++) {
+        ShaderBinding* b = refl->bindings + i;
+        if (b->group == group && b->binding == binding) return b;
+    }
+    return NULL;
+}
+
+int ShaderReflect_GroupBindings(ShaderReflection* refl, u32 group, int* first)
+{
+    int count = 0;
+    *first    = refl->binding_count;
+    for (int i = 0; i < refl->binding_count; i++) {
+        if (refl->bindings[i].group != group) continue;
+        if (count++ == 0) *first = i;
+    }
+    return count;
+}
+
+ShaderVertexInput* ShaderReflect_FindVertexInput(ShaderReflection* refl,
+                                                 u32 location)
+{
+    for (int i = 0; i < refl->vertex_input_count; i++) {
+        if (refl->vertex_inputs[i].location == location) return refl->vertex_inputs + i;
+    }
+    return NULL;
+}
+
+bool ShaderReflect_Compatible(ShaderBinding* binding, ShaderBindingKind kind,
+                              ShaderValueType type)
+{
+    switch (kind) {
+        case SHADER_BINDING_UNIFORM_BUFFER: {
+            if (binding->kind != SHADER_BINDING_UNIFORM_BUFFER) return false;
+            if (binding->type.scalar == SHADER_SCALAR_NONE) return true; // structs
+            // ints are uploaded as raw 32 bits, so also fill u32 uniforms
+            bool same_scalar
+              = binding->type.scalar == type.scalar
+                || (binding->type.scalar == SHADER_SCALAR_U32
+                    && type.scalar == SHADER_SCALAR_I32);
+            return same_scalar && binding->type.rows == type.rows
+                   && binding->type.cols == type.cols;
+        }
+        case SHADER_BINDING_STORAGE_BUFFER:
+        case SHADER_BINDING_READ_ONLY_STORAGE_BUFFER:
+            return binding->kind == SHADER_BINDING_STORAGE_BUFFER
+                   || binding->kind == SHADER_BINDING_READ_ONLY_STORAGE_BUFFER;
+        case SHADER_BINDING_SAMPLER:
+        case SHADER_BINDING_COMPARISON_SAMPLER:
+            return binding->kind == SHADER_BINDING_SAMPLER
+                   || binding->kind == SHADER_BINDING_COMPARISON_SAMPLER;
+        default: return binding->kind == kind;
+    }
+}
+
+void ShaderReflect_ValueTypeName(ShaderValueType type, char* buf, int buf_len)
+{
+    const char* scalar_names[] = { "?", "f32", "f16", "i32", "u32", "bool" };
+    const char suffixes[]      = { '?', 'f', 'h', 'i', 'u', '?' };
+    int s = type.scalar < ARRAY_LENGTH(scalar_names) ? type.scalar : 0;
+
+    if (type.scalar == SHADER_SCALAR_NONE) {
+        snprintf(buf, buf_len, "?");
+    } else if (type.cols > 1) {
+        snprintf(buf, buf_len, "mat%dx%d%c", type.cols, type.rows, suffixes[s]);
+    } else if (type.rows > 1) {
+        if (type.scalar == SHADER_SCALAR_BOOL)
+            snprintf(buf, buf_len, "vec%d<bool>", type.rows);
+        else
+            snprintf(buf, buf_len, "vec%d%c", type.rows, suffixes[s]);
+    } else {
+        snprintf(buf, buf_len, "%s", scalar_names[s]);
+    }
+}
@@ -0,0 +1,198 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+/*
+WGSL reflection
+
+Extracts from preprocessed WGSL source (after Shaders_genSource resolves the
+#includes) what the renderer needs to build explicit pipeline layouts instead
+of relying on layout: "auto":
+
+- resource bindings (@group @binding module-scope vars), and which stages use them
+- vertex inputs (@location params of the vertex entry point, directly or
+  through a struct)
+- @workgroup_size of a compute entry point
+
+Follows the WebGPU default ("auto") pipeline layout rules, so the explicit
+layouts built from a reflection accept exactly the bindgroups the auto layouts
+did:
+- a binding belongs to a stage only if it is statically used, i.e. named in the
+  entry point or any function the entry point (transitively) calls
+- f32 textures are "float" if a stage samples them with a sampler
+  (textureSample*, textureGather), including through function parameters, and
+  "unfilterable-float" otherwise
+
+This is a reflection pass, not a validator. Malformed or unsupported source
+(e.g. texture_external) fails the reflection, and the renderer falls back to
+auto layouts for that shader.
+
+Knows nothing about WebGPU so it can be tested on the CPU against a WGSL corpus.
+Not thread-safe: uses static scratch memory.
+*/
+
+#define SHADER_REFLECT_MAX_BINDINGS 64
+#define SHADER_REFLECT_MAX_GROUPS 4
+#define SHADER_REFLECT_MAX_VERTEX_INPUTS 8
+#define SHADER_REFLECT_NAME_LEN 32
+
+// same bits as WGPUShaderStage
+enum ShaderStage : u32 {
+    SHADER_STAGE_NONE     = 0,
+    SHADER_STAGE_VERTEX   = 0x1,
+    SHADER_STAGE_FRAGMENT = 0x2,
+    SHADER_STAGE_COMPUTE  = 0x4,
+};
+
+enum ShaderBindingKind : u8 {
+    SHADER_BINDING_NONE = 0,
+    SHADER_BINDING_UNIFORM_BUFFER,
+    SHADER_BINDING_STORAGE_BUFFER,           // var<storage, read_write>
+    SHADER_BINDING_READ_ONLY_STORAGE_BUFFER, // var<storage> or var<storage, read>
+    SHADER_BINDING_SAMPLER,
+    SHADER_BINDING_COMPARISON_SAMPLER,
+    SHADER_BINDING_TEXTURE,
+    SHADER_BINDING_STORAGE_TEXTURE,
+};
+
+enum ShaderScalar : u8 {
+    SHADER_SCALAR_NONE = 0, // structs, arrays, atomics, opaque types
+    SHADER_SCALAR_F32,
+    SHADER_SCALAR_F16,
+    SHADER_SCALAR_I32,
+    SHADER_SCALAR_U32,
+    SHADER_SCALAR_BOOL,
+};
+
+enum ShaderSampleType : u8 {
+    SHADER_SAMPLE_NONE = 0,
+    SHADER_SAMPLE_FLOAT,
+    SHADER_SAMPLE_UNFILTERABLE_FLOAT,
+    SHADER_SAMPLE_DEPTH,
+    SHADER_SAMPLE_SINT,
+    SHADER_SAMPLE_UINT,
+};
+
+enum ShaderTextureDim : u8 {
+    SHADER_TEXTURE_DIM_NONE = 0,
+    SHADER_TEXTURE_DIM_1D,
+    SHADER_TEXTURE_DIM_2D,
+    SHADER_TEXTURE_DIM_2D_ARRAY,
+    SHADER_TEXTURE_DIM_CUBE,
+    SHADER_TEXTURE_DIM_CUBE_ARRAY,
+    SHADER_TEXTURE_DIM_3D,
+};
+
+enum ShaderStorageAccess : u8 {
+    SHADER_ACCESS_NONE = 0,
+    SHADER_ACCESS_WRITE,
+    SHADER_ACCESS_READ,
+    SHADER_ACCESS_READ_WRITE,
+};
+
+// scalar, vector or matrix type. scalar is NONE for anything else
+struct ShaderValueType {
+    ShaderScalar scalar;
+    u8 rows; // vector components, 1 for scalars
+    u8 cols; // matrix columns, 1 for scalars and vectors
+};
+
+struct ShaderBinding {
+    u32 group;
+    u32 binding;
+    u32 visibility; // ShaderStage bits of the stages that statically use it
+    ShaderBindingKind kind;
+
+    ShaderValueType type; // buffers only, the type of the var (e.g. vec4f)
+
+    // textures
+    ShaderSampleType sample_type;
+    ShaderTextureDim view_dim;
+    b8 multisampled;
+
+    // storage textures
+    ShaderStorageAccess access;
+    char storage_format[16]; // WGSL texel format name, e.g. "rgba16float"
+
+    char name[SHADER_REFLECT_NAME_LEN];
+    char type_name[SHADER_REFLECT_NAME_LEN]; // as written, for error messages
+};
+
+struct ShaderVertexInput {
+    u32 location;
+    ShaderValueType type;
+    char name[SHADER_REFLECT_NAME_LEN];
+};
+
+struct ShaderReflection {
+    b32 ok;         // false if any entry point failed to reflect
+    char error[96]; // first error
+
+    u32 stages; // ShaderStage bits of the entry points added so far
+
+    ShaderBinding bindings[SHADER_REFLECT_MAX_BINDINGS]; // sorted by group, binding
+    int binding_count;
+
+    ShaderVertexInput vertex_inputs[SHADER_REFLECT_MAX_VERTEX_INPUTS];
+    int vertex_input_count;
+
+    u32 workgroup_size[3]; // 0 if no compute entry point or not a literal/const
+
+    int group_count; // 1 + highest @group used by any stage, 0 if none
+};
+
+// call once per shader before adding entry points
+void ShaderReflect_Init(ShaderReflection* refl);
+
+// reflects `entry_point` of `stage` in the module `wgsl` and merges it into refl.
+// The vertex and fragment stages of a render pipeline may come from the same or
+// from different modules. Returns refl->ok
+bool ShaderReflect_AddEntryPoint(ShaderReflection* refl, const char* wgsl,
+                                 ShaderStage stage, const char* entry_point);
+
+// NULL if not used by any stage
+ShaderBinding* ShaderReflect_FindBinding(ShaderReflection* refl, u32 group,
+                                         u32 binding);
+
+// number of bindings in @group(group), and their index range in refl->bindings
+int ShaderReflect_GroupBindings(ShaderReflection* refl, u32 group, int* first);
+
+// ShaderVertexInput at @location(location), NULL if none
+ShaderVertexInput* ShaderReflect_FindVertexInput(ShaderReflection* refl,
+                                                 u32 location);
+
+// true if a value of `kind` (and for uniform buffers, of `type`) can be bound to
+// `binding`. Storage buffers match either access mode, samplers match either
+// sampler kind
+bool ShaderReflect_Compatible(ShaderBinding* binding, ShaderBindingKind kind,
+                              ShaderValueType type);
+
+// writes e.g. "vec4f", "i32", "mat4x4f" into buf
+void ShaderReflect_ValueTypeName(ShaderValueType type, char* buf, int buf_len);
@@ -74,6 +74,13 @@ struct FrameUniforms {
     glm::ivec2 mouse_click; // at byte offset 272
     float sample_rate;      // at byte offset 280
     float _pad1;
+
+    // clustered lighting (see light_cluster.h)
+    glm::vec4 cluster_viewport;  // at byte offset 288, viewport x, y, w, h in pixels
+    float cluster_z_near;        // at byte offset 304
+    float cluster_slice_scale;   // at byte offset 308
+    int32_t cluster_log_slicing; // at byte offset 312
+    float _pad2;
 };
 
 void FrameUniforms_ZeroCameraFields(FrameUniforms* f)
@@ -86,9 +93,13 @@ void FrameUniforms_ZeroCameraFields(FrameUniforms* f)
 
 void FrameUniforms_ZeroLightingFields(FrameUniforms* f)
 {
-    f->ambient_light    = {};
-    f->num_lights       = 0;
-    f->background_color = {};
+    f->ambient_light       = {};
+    f->num_lights          = 0;
+    f->background_color    = {};
+    f->cluster_viewport    = {};
+    f->cluster_z_near      = 0;
+    f->cluster_slice_scale = 0;
+    f->cluster_log_slicing = 0;
 }
 
 struct LightUniforms {
@@ -155,7 +166,13 @@ static std::unordered_map<std::string, std::string> shader_table = {
             frame_count: i32,       // frames since window was opened
             mouse: vec2f,           // normalized mouse coords (range 0-1, (0,0) is bottom left)
             mouse_click: vec2i,     // mouse click state
-            sample_rate: f32        // chuck VM sound sample rate (e.g. 44100)
+            sample_rate: f32,       // chuck VM sound sample rate (e.g. 44100)
+
+            // clustered lighting (only set in ScenePass)
+            cluster_viewport: vec4f,
+            cluster_z_near: f32,
+            cluster_slice_scale: f32,
+            cluster_log_slicing: i32,
         };
                 
 
@@ -199,6 +216,44 @@ static std::unordered_map<std::string, std::string> shader_table = {
 
         )glsl"
     },
+    { // per-cluster light lists, must match light_cluster.h
+        "LIGHT_CLUSTER_UNIFORMS",
+        R"glsl(
+
+        const LIGHT_CLUSTER_X = 16u;
+        const LIGHT_CLUSTER_Y = 9u;
+        const LIGHT_CLUSTER_Z = 24u;
+
+        // [offset, count] per cluster, followed by light indices
+        @group(0) @binding(6) var<storage, read> u_light_clusters: array<u32>;
+
+        // returns (offset, count) into u_light_clusters of the lights that can
+        // affect a fragment at frag_coord (@builtin(position)) and worldpos
+        fn lightClusterRange(frag_coord: vec4f, worldpos: vec3f) -> vec2u {
+            if (u_frame.num_lights == 0) {
+                return vec2u(0u); // e.g. shadow pass
+            }
+
+            let vp = u_frame.cluster_viewport;
+            let uv = (frag_coord.xy - vp.xy) / vp.zw;
+            let x = u32(clamp(floor(uv.x * f32(LIGHT_CLUSTER_X)), 0.0, f32(LIGHT_CLUSTER_X - 1u)));
+            let y = u32(clamp(floor(uv.y * f32(LIGHT_CLUSTER_Y)), 0.0, f32(LIGHT_CLUSTER_Y - 1u)));
+
+            let depth = -(u_frame.view * vec4f(worldpos, 1.0)).z;
+            var slice = 0.0;
+            if (bool(u_frame.cluster_log_slicing)) {
+                slice = log(max(depth, u_frame.cluster_z_near) / u_frame.cluster_z_near) * u_frame.cluster_slice_scale;
+            } else {
+                slice = (depth - u_frame.cluster_z_near) * u_frame.cluster_slice_scale;
+            }
+            let z = u32(clamp(floor(slice), 0.0, f32(LIGHT_CLUSTER_Z - 1u)));
+
+            let cluster = x + y * LIGHT_CLUSTER_X + z * LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+            return vec2u(u_light_clusters[2u * cluster], u_light_clusters[2u * cluster + 1u]);
+        }
+
+        )glsl"
+    },
     { // for environment mapping
         "ENVIRONMENT_MAP_UNIFORMS",
         R"glsl(
@@ -531,6 +586,7 @@ static const char* phong_shader_string = R"glsl(
 
     #include FRAME_UNIFORMS
     #include LIGHTING_UNIFORMS
+    #include LIGHT_CLUSTER_UNIFORMS
     #include ENVIRONMENT_MAP_UNIFORMS
     #include DRAW_UNIFORMS
     #include STANDARD_VERTEX_INPUT
@@ -684,8 +740,9 @@ static const char* phong_shader_string = R"glsl(
         let specular_color : vec3f = (specularTex.rgb * u_specular_color);
 
         var lighting = vec3f(0.0); // accumulate lighting
-        for (var i = 0; i < u_frame.num_lights; i++) {
-            let light = u_lights[i];
+        let cluster = lightClusterRange(in.position, in.v_worldpos);
+        for (var i = 0u; i < cluster.y; i++) {
+            let light = u_lights[u_light_clusters[cluster.x + i]];
 
             // these need to be computed based on light type
             var attenuation = 1.0;
@@ -1013,6 +1070,7 @@ static const char* pbr_shader_string = R"glsl(
     #include FRAME_UNIFORMS
     #include DRAW_UNIFORMS
     #include LIGHTING_UNIFORMS
+    #include LIGHT_CLUSTER_UNIFORMS
     #include STANDARD_VERTEX_INPUT
     #include STANDARD_VERTEX_OUTPUT
     #include STANDARD_VERTEX_SHADER
@@ -1092,9 +1150,10 @@ static const char* pbr_shader_string = R"glsl(
         F0 = mix(F0, albedo.rgb, metallic); // reflectivity for metals
 
         var Lo : vec3f = vec3(0.0);
-        // loop over all lights
-        for (var i = 0; i < u_frame.num_lights; i++) {
-            let light = u_lights[i];
+        // loop over the lights in this fragment's cluster
+        let cluster = lightClusterRange(in.position, in.v_worldpos);
+        for (var i = 0u; i < cluster.y; i++) {
+            let light = u_lights[u_light_clusters[cluster.x + i]];
             var L : vec3f = vec3(0.0);
             var radiance : vec3f = vec3(0.0);
             switch (light.light_type) {
@@ -1796,6 +1855,112 @@ const char* skybox_shader_string = R"glsl(
     }
 )glsl";
 
+// Instance culling -------------------------
+
+// see instance_cull.h. Must match InstanceCull_Run(), and the workgroup size
+// INSTANCE_CULL_WORKGROUP_SIZE
+const char* instance_cull_shader_string = R"glsl(
+    // leading fields of FrameUniforms
+    struct FrameCamera {
+        projection: mat4x4f,
+        view: mat4x4f,
+    };
+
+    struct DrawUniforms {
+        model: mat4x4f,
+        normal: mat4x4f,
+        id: i32,
+        receives_shadow: i32,
+    };
+
+    struct CullParams {
+        sphere: vec4f, // local space bounding sphere
+        instance_count: u32,
+        element_count: u32,
+    };
+
+    @group(0) @binding(0) var<uniform> u_frame: FrameCamera;
+    @group(0) @binding(1) var<uniform> u_params: CullParams;
+    @group(0) @binding(2) var<storage> u_instances: array<DrawUniforms>;
+    @group(0) @binding(3) var<storage, read_write> u_visible: array<DrawUniforms>;
+    @group(0) @binding(4) var<storage, read_write> u_args: array<u32, 5>;
+
+    const WORKGROUP_SIZE = 256u;
+
+    // 2 halves, the prefix sum reads one and writes the other
+    var<workgroup> wg_scan: array<u32, 512>;
+
+    // frustum planes, left, right, bottom, top, near, far. 0..1 clip depth
+    var<private> planes: array<vec4f, 6>;
+
+    fn visible(model: mat4x4f) -> bool {
+        let center = (model * vec4f(u_params.sphere.xyz, 1.0)).xyz;
+        let m = mat3x3f(model[0].xyz, model[1].xyz, model[2].xyz);
+        let scale2 = max(dot(m[0], m[0]), max(dot(m[1], m[1]), dot(m[2], m[2])));
+        let radius = u_params.sphere.w * sqrt(scale2);
+        for (var i = 0; i < 6; i++) {
+            if (dot(planes[i].xyz, center) + planes[i].w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    @compute @workgroup_size(256)
+    fn main(@builtin(local_invocation_index) lid: u32) {
+        let m = u_frame.projection * u_frame.view;
+        let r0 = vec4f(m[0][0], m[1][0], m[2][0], m[3][0]);
+        let r1 = vec4f(m[0][1], m[1][1], m[2][1], m[3][1]);
+        let r2 = vec4f(m[0][2], m[1][2], m[2][2], m[3][2]);
+        let r3 = vec4f(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes = array<vec4f, 6>(r3 + r0, r3 - r0, r3 + r1, r3 - r1, r2, r3 - r2);
+        for (var i = 0; i < 6; i++) {
+            planes[i] = planes[i] / length(planes[i].xyz);
+        }
+
+        let count = u_params.instance_count;
+        var total = 0u;
+        for (var base = 0u; base < count; base += WORKGROUP_SIZE) {
+            let idx = base + lid;
+            var flag = 0u;
+            if (idx < count && visible(u_instances[idx].model)) {
+                flag = 1u;
+            }
+
+            // inclusive prefix sum of flag over the workgroup (Hillis & Steele)
+            wg_scan[lid] = flag;
+            workgroupBarrier();
+            var src = 0u;
+            for (var offset = 1u; offset < WORKGROUP_SIZE; offset *= 2u) {
+                var sum = wg_scan[src + lid];
+                if (lid >= offset) {
+                    sum += wg_scan[src + lid - offset];
+                }
+                let dst = WORKGROUP_SIZE - src;
+                wg_scan[dst + lid] = sum;
+                src = dst;
+                workgroupBarrier();
+            }
+
+            if (flag == 1u) {
+                u_visible[total + wg_scan[src + lid] - 1u] = u_instances[idx];
+            }
+            total += wg_scan[src + WORKGROUP_SIZE - 1u];
+
+            // everyone has read the sums before the next step overwrites them
+            workgroupBarrier();
+        }
+
+        if (lid == 0u) {
+            u_args[0] = u_params.element_count;
+            u_args[1] = total;
+            u_args[2] = 0u;
+            u_args[3] = 0u;
+            u_args[4] = 0u;
+        }
+    }
+)glsl";
+
 // ======================================
 // box2d debug shaders
 // ======================================
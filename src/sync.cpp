@@ -30,10 +30,14 @@
 #include <chuck/chugin.h>
 
 #include <condition_variable>
+#include <string>
 #include <unordered_map>
 
 #include "core/memory.h"
+#include "core/seqlock.h"
 #include "core/spinlock.h"
+#include "frame_capture.h"
+#include "input_stream.h"
 
 #include <glfw/include/GLFW/glfw3.h>
 
@@ -49,11 +53,114 @@ static std::mutex gameLoopLock; // lock for condition variable
 static std::condition_variable gameLoopConditionVar;
 static bool shouldRender = false;
 
+// GG.offline(): chuck waits at the frame boundary until the renderer has swapped
+static std::condition_variable swapConditionVar; // guarded by gameLoopLock
+static u64 updatesSignaled   = 0;
+static u64 swapsDone         = 0;
+static bool swapWaitReleased = false; // the render thread has exited
+
 // ============================================================================
 // Shared Audio/Graphics Thread State
 // ============================================================================
 
-// Window State (Don't modify directly, use API functions)
+// Frame State
+// Everything chuck polls about the window and input, published by the render
+// thread through a seqlock so that chuck's reads never take a lock or contend
+// with the writers. The render thread changes a staging copy that only it
+// touches, and publishes it at the frame boundary (and when window state changes
+// mid-frame), so chuck always reads a consistent snapshot. (Don't modify
+// directly, use API functions)
+struct CHUGL_MouseState {
+    double xpos = 0.0, ypos = 0.0;
+    double dx = 0.0, dy = 0.0;
+
+    bool left_button           = false;
+    bool right_button          = false;
+    bool left_button_click     = false;
+    bool right_button_click    = false;
+    bool left_button_released  = false;
+    bool right_button_released = false;
+
+    double scroll_dx = 0.0, scroll_dy = 0.0;
+};
+
+struct CHUGL_KbKey {
+    unsigned char pressed : 1;
+    unsigned char released : 1;
+};
+
+struct CHUGL_KbKeyState {
+    bool down;
+    bool pressed;
+    bool released;
+};
+
+struct CHUGL_KbState {
+    // 3 fields per key
+    // down (1 if pressed, 0 if not)
+    // click (1 on the frame the key is pressed, 0 otherwise)
+    // release (1 on the frame the key is released, 0 otherwise)
+    CHUGL_KbKey keys[GLFW_KEY_LAST + 1]; // separate for quick memzero on each frame
+    bool keys_down[GLFW_KEY_LAST + 1];
+};
+
+struct CHUGL_FrameState {
+    f64 dt  = 0;
+    f64 fps = 0; // updated every second by the graphics thread
+
+    // window size (in screen coordinates)
+    int window_width = 1280, window_height = 960;
+
+    // framebuffer size (in pixels)
+    int framebuffer_width = 0, framebuffer_height = 0;
+
+    // content scale
+    float content_scale_x = 0, content_scale_y = 0;
+
+    // window iconified / minimized
+    b32 iconified = false;
+
+    CHUGL_MouseState mouse;
+    CHUGL_KbState kb;
+};
+
+static CHUGL_FrameState chugl_frame_state; // staging, render thread only
+static seqlock<CHUGL_FrameState> chugl_frame_state_published(chugl_frame_state);
+
+// In pipelined mode (GG.pipelined) the render thread polls window events while
+// chuck runs the next frame. Chuck then reads a snapshot of the mouse and keyboard
+// taken at the frame boundary, so input can't change in the middle of a frame and
+// per-frame clicks/presses aren't lost. Render thread only
+static bool input_snapshot_enabled = false;
+static CHUGL_MouseState chugl_mouse_frame;
+static CHUGL_KbState chugl_kb_frame;
+
+// render thread. Makes the staging state visible to chuck, with the mouse and
+// keyboard snapshot in pipelined mode
+void CHUGL_FrameState_Publish()
+{
+    if (!input_snapshot_enabled) {
+        seqlock<CHUGL_FrameState>::write(&chugl_frame_state_published,
+                                         &chugl_frame_state);
+        return;
+    }
+    CHUGL_FrameState state = chugl_frame_state;
+    state.mouse            = chugl_mouse_frame;
+    state.kb               = chugl_kb_frame;
+    seqlock<CHUGL_FrameState>::write(&chugl_frame_state_published, &state);
+}
+
+// number of times the frame state has been published
+u64 CHUGL_FrameState_Version()
+{
+    return seqlock<CHUGL_FrameState>::current_version(&chugl_frame_state_published);
+}
+
+#define CHUGL_FRAME_STATE_READ(field, out)                                            \
+    seqlock_read_field(&chugl_frame_state_published, CHUGL_FrameState, field, out)
+
+// Window attributes, set by chuck and read by the render thread when it creates
+// or updates the window (Don't modify directly, use API functions)
 struct CHUGL_Window {
     bool closeable   = true;
     bool transparent = false;
@@ -61,80 +168,57 @@ struct CHUGL_Window {
     bool resizable   = true;
     bool decorated   = true;
 
-    // window size (in screen coordinates)
-    int window_width = 1280, window_height = 960;
-
     // last window params before going fullscreen
     int last_window_width  = 1280,
         last_window_height = 960; // last window size before going fullscreen
     int last_window_x = 0, last_window_y = 0;
 
-    // framebuffer size (in pixels)
-    int framebuffer_width, framebuffer_height;
-
-    // content scale
-    float content_scale_x, content_scale_y;
-
     // window frame size
     int window_frame_left, window_frame_top, window_frame_right, window_frame_bottom;
 
-    // window iconified / minimized
-    b32 iconified;
-
     float window_opacity;
 
-    f64 fps; // updated every second by the graphics thread
-
     // locks
     spinlock window_lock;
 };
 CHUGL_Window chugl_window;
 
-static f64 window_dt_sec = 0;
-static spinlock window_dt_lock;
-
 void CHUGL_Window_Iconified(b32 iconified)
 {
-    spinlock::lock(&window_dt_lock);
-    chugl_window.iconified = iconified;
-    spinlock::unlock(&window_dt_lock);
+    chugl_frame_state.iconified = iconified;
+    CHUGL_FrameState_Publish();
 }
 
 b32 CHUGL_Window_Iconified()
 {
-    spinlock::lock(&window_dt_lock);
-    b32 iconified = chugl_window.iconified;
-    spinlock::unlock(&window_dt_lock);
+    b32 iconified;
+    CHUGL_FRAME_STATE_READ(iconified, &iconified);
     return iconified;
 }
 
+// published with the rest of the frame state at the frame boundary
 void CHUGL_Window_dt(f64 dt)
 {
-    spinlock::lock(&window_dt_lock);
-    window_dt_sec = dt;
-    spinlock::unlock(&window_dt_lock);
+    chugl_frame_state.dt = dt;
 }
 
 f64 CHUGL_Window_dt()
 {
-    spinlock::lock(&window_dt_lock);
-    f64 dt = window_dt_sec;
-    spinlock::unlock(&window_dt_lock);
+    f64 dt;
+    CHUGL_FRAME_STATE_READ(dt, &dt);
     return dt;
 }
 
 void CHUGL_Window_fps(f64 fps)
 {
-    spinlock::lock(&chugl_window.window_lock);
-    chugl_window.fps = fps;
-    spinlock::unlock(&chugl_window.window_lock);
+    chugl_frame_state.fps = fps;
+    CHUGL_FrameState_Publish();
 }
 
 f64 CHUGL_Window_fps()
 {
-    spinlock::lock(&chugl_window.window_lock);
-    f64 fps = chugl_window.fps;
-    spinlock::unlock(&chugl_window.window_lock);
+    f64 fps;
+    CHUGL_FRAME_STATE_READ(fps, &fps);
     return fps;
 }
 
@@ -216,12 +300,11 @@ bool CHUGL_Window_Decorated()
 void CHUGL_Window_Size(int window_width, int window_height, int framebuffer_width,
                        int framebuffer_height)
 {
-    spinlock::lock(&chugl_window.window_lock);
-    chugl_window.window_width       = window_width;
-    chugl_window.window_height      = window_height;
-    chugl_window.framebuffer_width  = framebuffer_width;
-    chugl_window.framebuffer_height = framebuffer_height;
-    spinlock::unlock(&chugl_window.window_lock);
+    chugl_frame_state.window_width       = window_width;
+    chugl_frame_state.window_height      = window_height;
+    chugl_frame_state.framebuffer_width  = framebuffer_width;
+    chugl_frame_state.framebuffer_height = framebuffer_height;
+    CHUGL_FrameState_Publish();
 }
 
 void CHUGL_Window_LastWindowParamsBeforeFullscreen(int window_width, int window_height,
@@ -249,216 +332,242 @@ t_CKVEC4 CHUGL_Window_LastWindowParamsBeforeFullscreen()
 
 t_CKVEC2 CHUGL_Window_WindowSize()
 {
-    t_CKVEC2 size = {};
-    spinlock::lock(&chugl_window.window_lock);
-    size.x = chugl_window.window_width;
-    size.y = chugl_window.window_height;
-    spinlock::unlock(&chugl_window.window_lock);
-    return size;
+    int size[2];
+    static_assert(offsetof(CHUGL_FrameState, window_height)
+                    == offsetof(CHUGL_FrameState, window_width) + sizeof(int),
+                  "window size read as a pair");
+    seqlock<CHUGL_FrameState>::read_bytes<sizeof(size)>(
+      &chugl_frame_state_published, offsetof(CHUGL_FrameState, window_width), size);
+    return { (t_CKFLOAT)size[0], (t_CKFLOAT)size[1] };
 }
 
 t_CKVEC2 CHUGL_Window_FramebufferSize()
 {
-    t_CKVEC2 size{};
-    spinlock::lock(&chugl_window.window_lock);
-    size.x = chugl_window.framebuffer_width;
-    size.y = chugl_window.framebuffer_height;
-    spinlock::unlock(&chugl_window.window_lock);
-    return size;
+    int size[2];
+    static_assert(offsetof(CHUGL_FrameState, framebuffer_height)
+                    == offsetof(CHUGL_FrameState, framebuffer_width) + sizeof(int),
+                  "framebuffer size read as a pair");
+    seqlock<CHUGL_FrameState>::read_bytes<sizeof(size)>(
+      &chugl_frame_state_published, offsetof(CHUGL_FrameState, framebuffer_width),
+      size);
+    return { (t_CKFLOAT)size[0], (t_CKFLOAT)size[1] };
 }
 
 void CHUGL_Window_ContentScale(float x, float y)
 {
-    spinlock::lock(&chugl_window.window_lock);
-    chugl_window.content_scale_x = x;
-    chugl_window.content_scale_y = y;
-    spinlock::unlock(&chugl_window.window_lock);
+    chugl_frame_state.content_scale_x = x;
+    chugl_frame_state.content_scale_y = y;
+    CHUGL_FrameState_Publish();
 }
 
 t_CKVEC2 CHUGL_Window_ContentScale()
 {
-    t_CKVEC2 scale{};
-    spinlock::lock(&chugl_window.window_lock);
-    scale.x = chugl_window.content_scale_x;
-    scale.y = chugl_window.content_scale_y;
-    spinlock::unlock(&chugl_window.window_lock);
-    return scale;
+    float scale[2];
+    static_assert(offsetof(CHUGL_FrameState, content_scale_y)
+                    == offsetof(CHUGL_FrameState, content_scale_x) + sizeof(float),
+                  "content scale read as a pair");
+    seqlock<CHUGL_FrameState>::read_bytes<sizeof(scale)>(
+      &chugl_frame_state_published, offsetof(CHUGL_FrameState, content_scale_x),
+      scale);
+    return { scale[0], scale[1] };
 }
 
-// Mouse State (Don't modify directly, use API functions)
-struct CHUGL_Mouse {
-    double xpos = 0.0, ypos = 0.0;
-    double dx = 0.0, dy = 0.0;
+// number of components the render thread has yet to destroy
+static int render_destroy_queue_depth = 0;
+static spinlock render_destroy_queue_lock;
 
-    bool left_button           = false;
-    bool right_button          = false;
-    bool left_button_click     = false;
-    bool right_button_click    = false;
-    bool left_button_released  = false;
-    bool right_button_released = false;
+void CHUGL_RenderDestroyQueueDepth(int depth)
+{
+    spinlock::lock(&render_destroy_queue_lock);
+    render_destroy_queue_depth = depth;
+    spinlock::unlock(&render_destroy_queue_lock);
+}
 
-    double scroll_dx = 0.0, scroll_dy = 0.0;
+int CHUGL_RenderDestroyQueueDepth()
+{
+    spinlock::lock(&render_destroy_queue_lock);
+    int depth = render_destroy_queue_depth;
+    spinlock::unlock(&render_destroy_queue_lock);
+    return depth;
+}
+
+// GG.record() progress, written by the render thread every recorded frame
+static FrameCaptureStats render_record_stats = {};
+static bool render_recording                 = false;
+static spinlock render_record_lock;
+
+void CHUGL_RenderRecordStats(bool recording, FrameCaptureStats* stats)
+{
+    spinlock::lock(&render_record_lock);
+    render_recording    = recording;
+    render_record_stats = *stats;
+    spinlock::unlock(&render_record_lock);
+}
+
+bool CHUGL_RenderRecordStats(FrameCaptureStats* stats)
+{
+    spinlock::lock(&render_record_lock);
+    bool recording = render_recording;
+    *stats         = render_record_stats;
+    spinlock::unlock(&render_record_lock);
+    return recording;
+}
 
-    spinlock mouse_lock;
+// GG.offline() settings, read by the render thread once when it starts
+struct CHUGL_Offline {
+    f64 fps; // 0 renders to the window in realtime
+    int width, height;
 };
-CHUGL_Mouse chugl_mouse;
+static CHUGL_Offline chugl_offline = {};
+static spinlock chugl_offline_lock;
+
+void CHUGL_Offline_Set(f64 fps, int width, int height)
+{
+    spinlock::lock(&chugl_offline_lock);
+    chugl_offline.fps    = fps;
+    chugl_offline.width  = width;
+    chugl_offline.height = height;
+    spinlock::unlock(&chugl_offline_lock);
+}
+
+CHUGL_Offline CHUGL_Offline_Get()
+{
+    spinlock::lock(&chugl_offline_lock);
+    CHUGL_Offline offline = chugl_offline;
+    spinlock::unlock(&chugl_offline_lock);
+    return offline;
+}
+
+// GG.capture() and GG.replay() paths, also read once when the render thread
+// starts. Empty if not set
+static std::string chugl_capture_path;
+static std::string chugl_replay_path;
+static spinlock chugl_command_stream_lock;
+
+void CHUGL_CommandStream_Set(const char* capture_path, const char* replay_path)
+{
+    spinlock::lock(&chugl_command_stream_lock);
+    if (capture_path) chugl_capture_path = capture_path;
+    if (replay_path) chugl_replay_path = replay_path;
+    spinlock::unlock(&chugl_command_stream_lock);
+}
+
+void CHUGL_CommandStream_Get(std::string* capture_path, std::string* replay_path)
+{
+    spinlock::lock(&chugl_command_stream_lock);
+    *capture_path = chugl_capture_path;
+    *replay_path  = chugl_replay_path;
+    spinlock::unlock(&chugl_command_stream_lock);
+}
+
+// Mouse and keyboard state. Setters are called from the glfw callbacks on the
+// render thread and change the staging copy, getters read the published one
+
+// chuck reads a whole CHUGL_MouseState at a time, it's small
+static CHUGL_MouseState _CHUGL_MouseRead()
+{
+    CHUGL_MouseState mouse;
+    CHUGL_FRAME_STATE_READ(mouse, &mouse);
+    return mouse;
+}
 
 void CHUGL_Mouse_Position(double xpos, double ypos)
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
+    CHUGL_MouseState* mouse = &chugl_frame_state.mouse;
     // update deltas
-    chugl_mouse.dx   = xpos - chugl_mouse.xpos;
-    chugl_mouse.dy   = ypos - chugl_mouse.ypos;
-    chugl_mouse.xpos = xpos;
-    chugl_mouse.ypos = ypos;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
+    mouse->dx   = xpos - mouse->xpos;
+    mouse->dy   = ypos - mouse->ypos;
+    mouse->xpos = xpos;
+    mouse->ypos = ypos;
 }
 
 t_CKVEC2 CHUGL_Mouse_Position()
 {
-    t_CKVEC2 pos = {};
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    pos.x = chugl_mouse.xpos;
-    pos.y = chugl_mouse.ypos;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return pos;
+    CHUGL_MouseState mouse = _CHUGL_MouseRead();
+    return { mouse.xpos, mouse.ypos };
 }
 
 t_CKVEC2 CHUGL_Mouse_Delta()
 {
-    t_CKVEC2 delta = {};
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    delta.x = chugl_mouse.dx;
-    delta.y = chugl_mouse.dy;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return delta;
+    CHUGL_MouseState mouse = _CHUGL_MouseRead();
+    return { mouse.dx, mouse.dy };
 }
 
 void CHUGL_Zero_MouseDeltasAndClickState()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    chugl_mouse.dx                    = 0.0;
-    chugl_mouse.dy                    = 0.0;
-    chugl_mouse.left_button_click     = false;
-    chugl_mouse.right_button_click    = false;
-    chugl_mouse.left_button_released  = false;
-    chugl_mouse.right_button_released = false;
-    chugl_mouse.scroll_dx             = 0.0;
-    chugl_mouse.scroll_dy             = 0.0;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
+    CHUGL_MouseState* mouse      = &chugl_frame_state.mouse;
+    mouse->dx                    = 0.0;
+    mouse->dy                    = 0.0;
+    mouse->left_button_click     = false;
+    mouse->right_button_click    = false;
+    mouse->left_button_released  = false;
+    mouse->right_button_released = false;
+    mouse->scroll_dx             = 0.0;
+    mouse->scroll_dy             = 0.0;
 }
 
 bool CHUGL_Mouse_LeftButton()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool left_button = chugl_mouse.left_button;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return left_button;
+    return _CHUGL_MouseRead().left_button;
 }
 
 void CHUGL_Mouse_LeftButton(bool left_button)
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    chugl_mouse.left_button          = left_button;
-    chugl_mouse.left_button_click    = left_button;
-    chugl_mouse.left_button_released = !left_button;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
+    CHUGL_MouseState* mouse     = &chugl_frame_state.mouse;
+    mouse->left_button          = left_button;
+    mouse->left_button_click    = left_button;
+    mouse->left_button_released = !left_button;
 }
 
 bool CHUGL_Mouse_RightButton()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool right_button = chugl_mouse.right_button;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return right_button;
+    return _CHUGL_MouseRead().right_button;
 }
 
 void CHUGL_Mouse_RightButton(bool right_button)
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    chugl_mouse.right_button          = right_button;
-    chugl_mouse.right_button_click    = right_button;
-    chugl_mouse.right_button_released = !right_button;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
+    CHUGL_MouseState* mouse      = &chugl_frame_state.mouse;
+    mouse->right_button          = right_button;
+    mouse->right_button_click    = right_button;
+    mouse->right_button_released = !right_button;
 }
 
 bool CHUGL_Mouse_LeftButtonClick()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool left_button_click = chugl_mouse.left_button_click;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return left_button_click;
+    return _CHUGL_MouseRead().left_button_click;
 }
 
 bool CHUGL_Mouse_RightButtonClick()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool right_button_click = chugl_mouse.right_button_click;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return right_button_click;
+    return _CHUGL_MouseRead().right_button_click;
 }
 
 bool CHUGL_Mouse_LeftButtonReleased()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool left_button_released = chugl_mouse.left_button_released;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return left_button_released;
+    return _CHUGL_MouseRead().left_button_released;
 }
 
 bool CHUGL_Mouse_RightButtonReleased()
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    bool right_button_released = chugl_mouse.right_button_released;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return right_button_released;
+    return _CHUGL_MouseRead().right_button_released;
 }
 
 void CHUGL_scroll_delta(double xoffset, double yoffset)
 {
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    chugl_mouse.scroll_dx = xoffset;
-    chugl_mouse.scroll_dy = yoffset;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
+    chugl_frame_state.mouse.scroll_dx = xoffset;
+    chugl_frame_state.mouse.scroll_dy = yoffset;
 }
 
 t_CKVEC2 CHUGL_scroll_delta()
 {
-    t_CKVEC2 delta = {};
-    spinlock::lock(&chugl_mouse.mouse_lock);
-    delta.x = chugl_mouse.scroll_dx;
-    delta.y = chugl_mouse.scroll_dy;
-    spinlock::unlock(&chugl_mouse.mouse_lock);
-    return delta;
+    CHUGL_MouseState mouse = _CHUGL_MouseRead();
+    return { mouse.scroll_dx, mouse.scroll_dy };
 }
 
-struct CHUGL_KbKey {
-    unsigned char pressed : 1;
-    unsigned char released : 1;
-};
-
-struct CHUGL_KbKeyState {
-    bool down;
-    bool pressed;
-    bool released;
-};
-
-struct {
-    // 3 fields per key
-    // down (1 if pressed, 0 if not)
-    // click (1 on the frame the key is pressed, 0 otherwise)
-    // release (1 on the frame the key is released, 0 otherwise)
-    spinlock lock;
-    CHUGL_KbKey keys[GLFW_KEY_LAST + 1]; // separate for quick memzero on each frame
-    bool keys_down[GLFW_KEY_LAST + 1];
-} CHUGL_Kb;
-
 // resets the per-frame pressed and released states of all keys
 void CHUGL_Kb_ZeroPressedReleased()
 {
-    spinlock::lock(&CHUGL_Kb.lock);
-    memset(CHUGL_Kb.keys, 0, sizeof(CHUGL_Kb.keys));
-    spinlock::unlock(&CHUGL_Kb.lock);
+    memset(chugl_frame_state.kb.keys, 0, sizeof(chugl_frame_state.kb.keys));
 }
 
 // called on the frame the key is pressed or released
@@ -466,38 +575,54 @@ void CHUGL_Kb_ZeroPressedReleased()
 // if released, down = false
 void CHUGL_Kb_action(int key, bool down)
 {
-    spinlock::lock(&CHUGL_Kb.lock);
-    CHUGL_Kb.keys_down[key]     = down;
-    CHUGL_Kb.keys[key].pressed  = down;
-    CHUGL_Kb.keys[key].released = !down;
-    spinlock::unlock(&CHUGL_Kb.lock);
+    CHUGL_KbState* kb      = &chugl_frame_state.kb;
+    kb->keys_down[key]     = down;
+    kb->keys[key].pressed  = down;
+    kb->keys[key].released = !down;
 }
 
 CHUGL_KbKeyState CHUGL_Kb_key(int key)
 {
-    spinlock::lock(&CHUGL_Kb.lock);
-    CHUGL_KbKeyState k = { CHUGL_Kb.keys_down[key], (bool)CHUGL_Kb.keys[key].pressed,
-                           (bool)CHUGL_Kb.keys[key].released };
-    spinlock::unlock(&CHUGL_Kb.lock);
-    return k;
+    CHUGL_KbKey k;
+    bool down;
+    seqlock<CHUGL_FrameState>::read_bytes<sizeof(k)>(
+      &chugl_frame_state_published,
+      offsetof(CHUGL_FrameState, kb.keys) + key * sizeof(CHUGL_KbKey), &k);
+    seqlock<CHUGL_FrameState>::read_bytes<sizeof(down)>(
+      &chugl_frame_state_published,
+      offsetof(CHUGL_FrameState, kb.keys_down) + key * sizeof(bool), &down);
+    return { down, (bool)k.pressed, (bool)k.released };
 }
 
 // copy all the keys pressed and released
 // size_bytes is the size in bytes of the given `keys` array
 void CHUGL_Kb_copyAllKeysPressedReleased(CHUGL_KbKey* keys, u64 size_bytes)
 {
-    ASSERT(size_bytes == sizeof(CHUGL_Kb.keys));
-    spinlock::lock(&CHUGL_Kb.lock);
-    memcpy(keys, CHUGL_Kb.keys, sizeof(CHUGL_Kb.keys));
-    spinlock::unlock(&CHUGL_Kb.lock);
+    ASSERT(size_bytes == sizeof(chugl_frame_state.kb.keys));
+    CHUGL_FRAME_STATE_READ(kb.keys, keys);
 }
 
 void CHUGL_Kb_copyAllKeysHeldDown(bool* keys, u64 size_bytes)
 {
-    ASSERT(size_bytes == sizeof(CHUGL_Kb.keys_down));
-    spinlock::lock(&CHUGL_Kb.lock);
-    memcpy(keys, CHUGL_Kb.keys_down, sizeof(CHUGL_Kb.keys_down));
-    spinlock::unlock(&CHUGL_Kb.lock);
+    ASSERT(size_bytes == sizeof(chugl_frame_state.kb.keys_down));
+    CHUGL_FRAME_STATE_READ(kb.keys_down, keys);
+}
+
+// called by the render thread at the frame boundary, while chuck is waiting on
+// GG.nextFrame(). If enabled, copies the live mouse and keyboard state into the
+// snapshot chuck reads and starts accumulating the next frame's clicks/presses.
+// Otherwise the per-frame state is just reset and chuck reads the live state, as
+// of the next CHUGL_FrameState_Publish
+void CHUGL_Input_BeginFrame(bool snapshot)
+{
+    input_snapshot_enabled = snapshot;
+    if (snapshot) {
+        chugl_mouse_frame = chugl_frame_state.mouse;
+        chugl_kb_frame    = chugl_frame_state.kb;
+    }
+
+    CHUGL_Zero_MouseDeltasAndClickState();
+    CHUGL_Kb_ZeroPressedReleased();
 }
 
 // ============================================================================
@@ -538,7 +663,11 @@ void Sync_RegisterShred(Chuck_VM_Shred* shred);
 void Sync_UnregisterShred(Chuck_VM_Shred* shred);
 int Sync_NumShredsRegistered();
 void Sync_WaitOnUpdateDone();
+bool Sync_WaitOnUpdateDoneFor(f64 ms);
 void Sync_SignalUpdateDone();
+void Sync_WaitOnSwapDone();
+void Sync_SignalSwapDone();
+void Sync_ReleaseSwapWait();
 
 // ============================================================================
 // ChuGL Events Definitions
@@ -592,6 +721,65 @@ const char* Event_GetName(CHUGL_EventType type)
     return CHUGL_EventTypeNames[type];
 }
 
+// ============================================================================
+// Input Event Stream (GG.input())
+// ============================================================================
+
+// every input event, pushed by the glfw callbacks on the render thread and
+// drained by chuck. see input_stream.h
+static InputQueue chugl_input_queue;
+
+// GG.input(), created by chuck on first use. Until then nothing is pushed, so the
+// stream costs nothing unless a shred listens
+static std::atomic<Chuck_Event*> chugl_input_event = { NULL };
+static bool chugl_input_pending                    = false; // render thread only
+
+void CHUGL_Input_Listen(Chuck_Event* event)
+{
+    chugl_input_event.store(event, std::memory_order_release);
+}
+
+bool CHUGL_Input_Listening()
+{
+    return chugl_input_event.load(std::memory_order_acquire) != NULL;
+}
+
+// render thread, from the glfw callbacks. Timestamped now
+void CHUGL_Input_Push(InputEventType type, i32 code, i32 mods, i32 device, f64 x,
+                      f64 y)
+{
+    if (!CHUGL_Input_Listening()) return;
+    InputEvent event = {};
+    event.time_ns    = InputStream_Now();
+    event.type       = type;
+    event.code       = code;
+    event.mods       = mods;
+    event.device     = device;
+    event.x          = x;
+    event.y          = y;
+    chugl_input_pending |= InputQueue_Push(&chugl_input_queue, &event);
+}
+
+// render thread, after polling. Wakes the shreds waiting on GG.input() once for
+// everything pushed since the last call
+void CHUGL_Input_Broadcast()
+{
+    if (!chugl_input_pending) return;
+    chugl_input_pending = false;
+    Event_Broadcast(chugl_input_event.load(std::memory_order_acquire));
+}
+
+// audio thread
+int CHUGL_Input_Drain(InputHistory* history)
+{
+    return InputHistory_Drain(history, &chugl_input_queue);
+}
+
+u64 CHUGL_Input_Dropped()
+{
+    return chugl_input_queue.dropped.load(std::memory_order_relaxed);
+}
+
 // ============================================================================
 // Thread Synchronization Definitions
 // ============================================================================
@@ -638,10 +826,48 @@ void Sync_WaitOnUpdateDone()
     shouldRender = false;
 }
 
+// Sync_WaitOnUpdateDone, giving up after `ms`. false on timeout
+bool Sync_WaitOnUpdateDoneFor(f64 ms)
+{
+    std::unique_lock<std::mutex> lock(gameLoopLock);
+    if (!gameLoopConditionVar.wait_for(lock, std::chrono::duration<f64, std::milli>(ms),
+                                       []() { return shouldRender; }))
+        return false;
+    shouldRender = false;
+    return true;
+}
+
 void Sync_SignalUpdateDone()
 {
     std::unique_lock<std::mutex> lock(gameLoopLock);
     shouldRender = true;
+    ++updatesSignaled;
     lock.unlock();
     gameLoopConditionVar.notify_all();
 }
+
+// blocks the audio thread until the renderer has swapped the command queues of the
+// last update, i.e. finished the frame before it
+void Sync_WaitOnSwapDone()
+{
+    std::unique_lock<std::mutex> lock(gameLoopLock);
+    swapConditionVar.wait(
+      lock, []() { return swapWaitReleased || swapsDone >= updatesSignaled; });
+}
+
+void Sync_SignalSwapDone()
+{
+    std::unique_lock<std::mutex> lock(gameLoopLock);
+    ++swapsDone;
+    lock.unlock();
+    swapConditionVar.notify_all();
+}
+
+// no more swaps are coming, never block the audio thread again
+void Sync_ReleaseSwapWait()
+{
+    std::unique_lock<std::mutex> lock(gameLoopLock);
+    swapWaitReleased = true;
+    lock.unlock();
+    swapConditionVar.notify_all();
+}
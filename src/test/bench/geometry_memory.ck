@@ -0,0 +1,65 @@
+//-----------------------------------------------------------------------------
+// name: geometry_memory.ck
+// desc: host memory benchmark for large meshes.
+//       Builds one Geometry with NUM_VERTICES vertices (positions, normals,
+//       uvs) and as many indices, draws it for a few frames, and reports
+//       GG.geometryBytes() before and after the upload. On Linux it also
+//       prints the process's peak and current resident set (VmHWM / VmRSS
+//       from /proc/self/status). Elsewhere, run it under a tool that reports
+//       peak RSS, e.g. `/usr/bin/time -l` on macOS.
+//       Pass 1 to call markStatic(), which frees the CPU copy once uploaded.
+//
+// usage: chuck --chugin:ChuGL.chug geometry_memory.ck
+//        chuck --chugin:ChuGL.chug geometry_memory.ck:1
+//-----------------------------------------------------------------------------
+
+5000000 => int NUM_VERTICES;
+
+// prints the VmHWM (peak) and VmRSS (current) lines of /proc/self/status
+fun void printRSS(string when)
+{
+    FileIO status;
+    if (!status.open("/proc/self/status", FileIO.READ)) return;
+    while (status.more()) {
+        status.readLine() => string line;
+        if (line.find("VmHWM") == 0 || line.find("VmRSS") == 0) <<< when, line >>>;
+    }
+    status.close();
+}
+
+(me.arg(0) == "1") => int mark_static;
+
+vec3 positions[NUM_VERTICES];
+vec3 normals[NUM_VERTICES];
+vec2 uvs[NUM_VERTICES];
+int indices[NUM_VERTICES];
+for (int i; i < NUM_VERTICES; i++) {
+    @(Math.random2f(-1, 1), Math.random2f(-1, 1), Math.random2f(-1, 1)) => positions[i];
+    @(0, 0, 1) => normals[i];
+    @(Math.randomf(), Math.randomf()) => uvs[i];
+    i => indices[i];
+}
+
+Geometry geo;
+if (mark_static) geo.markStatic();
+geo.positions(positions);
+geo.normals(normals);
+geo.uvs(uvs);
+geo.indices(indices);
+
+// drop the ChucK arrays, only the geometry's copies remain
+null @=> positions;
+null @=> normals;
+null @=> uvs;
+null @=> indices;
+
+FlatMaterial mat;
+GMesh mesh(geo, mat) --> GG.scene();
+@(0, 0, 4) => GG.scene().camera().pos;
+
+<<< "geometry bytes before upload:", GG.geometryBytes() >>>;
+printRSS("before upload:");
+repeat (10) GG.nextFrame() => now;
+<<< "geometry bytes after upload:", GG.geometryBytes() >>>;
+printRSS("after upload:");
+<<< "markStatic:", mark_static >>>;
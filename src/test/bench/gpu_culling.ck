@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// name: gpu_culling.ck
+// desc: benchmark for GScene.gpuCulling().
+//       Scatters NUM_INSTANCES cubes sharing one geometry and material around
+//       the camera, which turns so only a slice of them is in view at a time.
+//       Reports the frame rate, the time spent building draws on the CPU
+//       ("draw_build") and the GPU time. Without culling every instance is
+//       drawn; with it a compute pass before the ScenePass leaves out the ones
+//       outside the frustum, and the CPU never touches the instances after the
+//       first frame. Pass 1 to turn culling on.
+//
+// usage: chuck --chugin:ChuGL.chug gpu_culling.ck
+//        chuck --chugin:ChuGL.chug gpu_culling.ck:1
+//-----------------------------------------------------------------------------
+
+50000 => int NUM_INSTANCES;
+600 => int NUM_FRAMES;
+
+(me.arg(0) == "1") => int culling;
+GG.scene().gpuCulling(culling);
+
+GCube geo;
+PhongMaterial material;
+GMesh meshes[NUM_INSTANCES];
+for (int i; i < NUM_INSTANCES; i++) {
+    meshes[i].mesh(geo, material);
+    meshes[i] --> GG.scene();
+    Math.random2f(0, 2 * Math.PI) => float angle;
+    Math.random2f(20, 200) => float dist;
+    @(dist * Math.cos(angle), Math.random2f(-30, 30), dist * Math.sin(angle)) => meshes[i].pos;
+}
+GG.scene().camera().pos(@(0, 0, 0));
+GG.scene().camera().clip(.1, 250);
+
+// warmup
+repeat (30) GG.nextFrame() => now;
+GG.profile(true);
+
+0::second => dur frame_total;
+for (0 => int frame; frame < NUM_FRAMES; frame++) {
+    GG.scene().camera().rotateY(.01);
+    GG.nextFrame() => now;
+    GG.dt()::second +=> frame_total;
+}
+
+<<< "gpu_culling:", NUM_INSTANCES, "instances", culling ? "(culled on the GPU)" : "" >>>;
+<<< "avg fps:", NUM_FRAMES / (frame_total / 1::second) >>>;
+<<< "draw build ms:", GG.statsMs("draw_build") >>>;
+<<< "gpu ms:", GG.statsMs("gpu") >>>;
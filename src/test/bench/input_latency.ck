@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// name: input_latency.ck
+// desc: benchmark for GG.input().
+//       Press keys NUM_PRESSES times. Every press is caught twice: by a shred
+//       listening on GG.input(), and by a render loop checking
+//       GWindow.keysDown() once per GG.nextFrame(). Each notes the ChucK time
+//       at which it could have started a sound, measured from the sample ChucK
+//       had computed when the key went down (msg.when with no input latency).
+//       Reports the average and worst delay of both, and the wall-clock time
+//       from the key callback to recv(). Run with and without pipelined mode
+//       (the stream is also polled while the graphics thread waits on ChucK).
+//
+// usage: chuck --chugin:ChuGL.chug input_latency.ck
+//        chuck --chugin:ChuGL.chug input_latency.ck:pipelined
+//-----------------------------------------------------------------------------
+
+20 => int NUM_PRESSES;
+me.arg(0) == "pipelined" => int pipelined;
+
+GG.pipelined(pipelined);
+UI.disabled(true);
+0::samp => GG.inputLatency;
+
+time pressed_at[512]; // when each key last went down, from the stream
+int pending[512];     // pressed and not yet seen by the render loop
+
+0 => int stream_count;
+0::samp => dur stream_total;
+0::samp => dur stream_worst;
+0::samp => dur wall_total;
+0 => int frame_count;
+0::samp => dur frame_total;
+0::samp => dur frame_worst;
+
+fun void listen()
+{
+    InputMsg msg;
+    while (true) {
+        GG.input() => now;
+        while (GG.input().recv(msg)) {
+            if (msg.type != InputMsg.KEY_DOWN || msg.code >= 512) continue;
+            msg.when => pressed_at[msg.code];
+            1 => pending[msg.code];
+            now - msg.when => dur delay;
+            stream_count++;
+            delay +=> stream_total;
+            Math.max(stream_worst / samp, delay / samp)::samp => stream_worst;
+            msg.latency +=> wall_total;
+        }
+    }
+}
+spork ~ listen();
+
+<<< "press any key", NUM_PRESSES, "times" >>>;
+while (frame_count < NUM_PRESSES) {
+    GG.nextFrame() => now;
+    for (auto key : GWindow.keysDown()) {
+        if (key >= 512 || !pending[key]) continue;
+        0 => pending[key];
+        now - pressed_at[key] => dur delay;
+        frame_count++;
+        delay +=> frame_total;
+        Math.max(frame_worst / samp, delay / samp)::samp => frame_worst;
+    }
+}
+// the stream has seen every press the render loop did
+GG.nextFrame() => now;
+
+<<< "input_latency:", frame_count, "presses, pipelined", pipelined >>>;
+<<< "GG.input()     avg ms:", stream_total / Math.max(stream_count, 1) / ms,
+    "worst ms:", stream_worst / ms >>>;
+<<< "GG.nextFrame() avg ms:", frame_total / Math.max(frame_count, 1) / ms,
+    "worst ms:", frame_worst / ms >>>;
+<<< "callback to recv() avg ms (wall clock):",
+    wall_total / Math.max(stream_count, 1) / ms >>>;
+<<< "dropped:", GG.inputDropped() >>>;
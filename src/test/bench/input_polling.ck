@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+// name: input_polling.ck
+// desc: benchmark for polling window and input state from many shreds.
+//       NUM_SHREDS shreds each read the mouse, keyboard and window size
+//       POLLS_PER_FRAME times per frame while the graphics thread keeps
+//       updating them. Reports the frame rate, the time the graphics thread
+//       spent waiting on chuck, and chuck's own update time (GG.statsMs()).
+//       The state is published once per frame through a seqlock, so reads
+//       never lock or stall the graphics thread and both times should stay
+//       flat as shreds are added. Move the mouse and hold keys while it runs.
+//       Pass 1 to run pipelined (GG.pipelined()), which polls input while
+//       chuck runs.
+//
+// usage: chuck --chugin:ChuGL.chug input_polling.ck
+//        chuck --chugin:ChuGL.chug input_polling.ck:1
+//-----------------------------------------------------------------------------
+
+64 => int NUM_SHREDS;
+200 => int POLLS_PER_FRAME;
+600 => int NUM_FRAMES;
+
+if (me.arg(0) == "1") {
+    UI.disabled(true);
+    GG.pipelined(true);
+}
+
+// warmup
+repeat (30) GG.nextFrame() => now;
+GG.profile(true);
+
+0 => int reads;
+fun void poller()
+{
+    while (true) {
+        GG.nextFrame() => now;
+        repeat (POLLS_PER_FRAME) {
+            GWindow.mousePos() => vec2 pos;
+            GWindow.mouseDeltaPos() => vec2 delta;
+            GWindow.mouseLeft() => int left;
+            GWindow.key(GWindow.Key_Space) => int space;
+            GWindow.windowSize() => vec2 size;
+            GWindow.contentScale() => vec2 scale;
+            GG.dt() => float dt;
+        }
+        7 * POLLS_PER_FRAME +=> reads;
+    }
+}
+for (int i; i < NUM_SHREDS; i++) spork ~ poller();
+
+1000 => float min_fps;
+repeat (NUM_FRAMES) {
+    GG.nextFrame() => now;
+    if (GG.fps() > 0) Math.min(min_fps, GG.fps()) => min_fps;
+}
+
+<<< "input_polling:", NUM_SHREDS, "shreds x", POLLS_PER_FRAME, "polls per frame",
+    GG.pipelined() ? "(pipelined)" : "" >>>;
+<<< "reads:", reads, "per frame:", reads / NUM_FRAMES >>>;
+<<< "fps:", GG.fps(), "min:", min_fps >>>;
+<<< "graphics waiting on chuck ms:", GG.statsMs("wait_audio") >>>;
+<<< "chuck update ms:", GG.statsMs("audio_update") >>>;
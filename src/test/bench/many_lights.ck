@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+// name: many_lights.ck
+// desc: benchmark for scenes with many small point lights.
+//       Scatters NUM_LIGHTS short-range point lights over a large ground plane
+//       covered in spheres, and reports the average frame time. With
+//       clustered lighting each fragment only shades the handful of lights
+//       that reach it, so frame time should stay roughly flat as NUM_LIGHTS
+//       grows, instead of scaling with lights * pixels.
+//
+// usage: chuck --chugin:ChuGL.chug many_lights.ck
+//-----------------------------------------------------------------------------
+
+256 => int NUM_LIGHTS;
+300 => int NUM_FRAMES;
+40.0 => float EXTENT;
+
+// no global lights, only the point lights below
+GG.scene().light().intensity(0);
+@(0, 25, 30) => GG.scene().camera().pos;
+GG.scene().camera().lookAt(@(0, 0, 0));
+
+GPlane ground --> GG.scene();
+@(2 * EXTENT, 2 * EXTENT, 1) => ground.sca;
+ground.rotateX(Math.PI/2);
+
+for (int i; i < 400; i++) {
+    GSphere s --> GG.scene();
+    @(Math.random2f(-EXTENT, EXTENT), .5, Math.random2f(-EXTENT, EXTENT)) => s.pos;
+}
+
+GPointLight lights[NUM_LIGHTS];
+for (int i; i < NUM_LIGHTS; i++) {
+    lights[i] --> GG.scene();
+    @(Math.random2f(-EXTENT, EXTENT), 1, Math.random2f(-EXTENT, EXTENT)) => lights[i].pos;
+    lights[i].color(@(Math.randomf(), Math.randomf(), Math.randomf()));
+    lights[i].radius(3);
+}
+
+0::second => dur frame_total;
+
+// warmup
+repeat (10) GG.nextFrame() => now;
+
+for (0 => int frame; frame < NUM_FRAMES; frame++) {
+    // keep the lights moving so binning can't be cached
+    for (int i; i < NUM_LIGHTS; i++) {
+        lights[i].translateX(.05 * Math.sin(frame * .05 + i));
+    }
+
+    GG.nextFrame() => now;
+    GG.dt()::second +=> frame_total;
+}
+
+<<< "many_lights:", NUM_LIGHTS, "point lights x", NUM_FRAMES, "frames" >>>;
+<<< "avg frame time (ms):", (frame_total / NUM_FRAMES) / 1::ms >>>;
+<<< "avg fps:", NUM_FRAMES / (frame_total / 1::second) >>>;
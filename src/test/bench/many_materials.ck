@@ -0,0 +1,50 @@
+//-----------------------------------------------------------------------------
+// name: many_materials.ck
+// desc: benchmark for scenes with many distinct materials.
+//       Creates NUM_MATERIALS small cubes, each with its own FlatMaterial, and
+//       animates the color of a tenth of them every frame. Material uniforms
+//       are packed into a shared pool, so this should need only a handful of
+//       GPU buffers and upload just the colors that changed each frame.
+//       Prints the pool's GPU buffer count and upload bytes from GG.stats().
+//
+// usage: chuck --chugin:ChuGL.chug many_materials.ck
+//-----------------------------------------------------------------------------
+
+10000 => int NUM_MATERIALS;
+300 => int NUM_FRAMES;
+
+@(0, 0, 120) => GG.scene().camera().pos;
+
+GCube geo;
+FlatMaterial materials[NUM_MATERIALS];
+GMesh meshes[NUM_MATERIALS];
+for (int i; i < NUM_MATERIALS; i++) {
+    meshes[i].mesh(geo, materials[i]);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-80, 80), Math.random2f(-45, 45), Math.random2f(-20, 20)) => meshes[i].pos;
+    materials[i].color(@(Math.randomf(), Math.randomf(), Math.randomf()));
+}
+
+0::second => dur frame_total;
+
+// material uniform pool counters
+GG.profile(true);
+
+// warmup
+repeat (10) GG.nextFrame() => now;
+
+for (0 => int frame; frame < NUM_FRAMES; frame++) {
+    for (frame % 10 => int i; i < NUM_MATERIALS; 10 +=> i) {
+        materials[i].color(@(.5 + .5 * Math.sin(frame * .1 + i), .5, .5));
+    }
+
+    GG.nextFrame() => now;
+    GG.dt()::second +=> frame_total;
+}
+
+<<< "many_materials:", NUM_MATERIALS, "materials x", NUM_FRAMES, "frames" >>>;
+<<< "avg frame time (ms):", (frame_total / NUM_FRAMES) / 1::ms >>>;
+<<< "avg fps:", NUM_FRAMES / (frame_total / 1::second) >>>;
+<<< "uniform gpu buffers:", GG.statsCount("uniform_buffers") >>>;
+<<< "uniform upload bytes last frame:", GG.statsCount("uniform_upload_bytes") >>>;
+<<< "uniform upload bytes since startup:", GG.statsCount("uniform_upload_bytes_total") >>>;
@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// name: offline.ck
+// desc: benchmark for GG.offline().
+//       Renders NUM_FRAMES frames of NUM_MESHES moving meshes offline at FPS
+//       frames per ChucK second, recording every frame, and reports how far
+//       ChucK time moved, the wall-clock render rate (GG.fps()), and the frames
+//       written and dropped. Every frame must be written and none dropped, and
+//       ChucK time must have moved exactly NUM_FRAMES / FPS seconds, however
+//       fast or slow the machine is. Runs without a display, e.g. over ssh
+//       with a software WebGPU adapter.
+//
+// usage: chuck --silent --chugin:ChuGL.chug offline.ck
+//        chuck --silent --chugin:ChuGL.chug offline.ck:out.gif
+//-----------------------------------------------------------------------------
+
+2000 => int NUM_MESHES;
+300 => int NUM_FRAMES;
+60 => float FPS;
+me.arg(0) => string path;
+if (path == "") "offline_bench_%05d.qoi" => path;
+
+GG.offline(FPS, 1920, 1080);
+@(0, 0, 60) => GG.scene().camera().pos;
+
+SphereGeometry geo;
+NormalMaterial material;
+GMesh meshes[NUM_MESHES];
+for (int i; i < NUM_MESHES; i++) {
+    meshes[i].mesh(geo, material);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-50, 50), Math.random2f(-30, 30), Math.random2f(-10, 10))
+      => meshes[i].pos;
+}
+
+GG.record(path);
+now => time start;
+
+0 => float max_fps;
+repeat (NUM_FRAMES) {
+    for (int i; i < NUM_MESHES; i++) meshes[i].rotateY(.02);
+    GG.nextFrame() => now;
+    GG.dt()::second => now;
+    Math.max(max_fps, GG.fps()) => max_fps;
+}
+
+(now - start) / 1::second => float elapsed;
+GG.recordStop();
+// the frame after the stop has finished writing
+repeat (2) {
+    GG.nextFrame() => now;
+    GG.dt()::second => now;
+}
+
+<<< "offline:", NUM_MESHES, "meshes x", NUM_FRAMES, "frames at", FPS, "fps" >>>;
+<<< "chuck seconds:", elapsed, "expected:", NUM_FRAMES / FPS >>>;
+<<< "render fps (wall clock):", max_fps >>>;
+<<< "frames written to", path, ":", GG.recordWritten(),
+    "dropped:", GG.recordDropped() >>>;
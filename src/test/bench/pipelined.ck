@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+// name: pipelined.ck
+// desc: benchmark for GG.pipelined().
+//       Loads both threads at once: every frame ChucK moves NUM_MESHES meshes
+//       (heavy update), while the renderer draws them with lit materials and
+//       NUM_LIGHTS point lights (heavy render). Measures sustained FPS with
+//       pipelined mode off, then on. Input polling leaves the frame boundary
+//       in pipelined mode, so the second run should be at least as fast.
+//       The UI is disabled, pipelined mode has no effect while it is on.
+//
+// usage: chuck --chugin:ChuGL.chug pipelined.ck
+//-----------------------------------------------------------------------------
+
+20000 => int NUM_MESHES;
+64 => int NUM_LIGHTS;
+300 => int NUM_FRAMES;
+
+UI.disabled(true);
+@(0, 0, 120) => GG.scene().camera().pos;
+
+SphereGeometry geo;
+PhongMaterial material;
+GMesh meshes[NUM_MESHES];
+vec3 origins[NUM_MESHES];
+for (int i; i < NUM_MESHES; i++) {
+    meshes[i].mesh(geo, material);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-80, 80), Math.random2f(-45, 45), Math.random2f(-20, 20))
+      => origins[i];
+}
+
+GPointLight lights[NUM_LIGHTS];
+for (int i; i < NUM_LIGHTS; i++) {
+    lights[i] --> GG.scene();
+    @(Math.random2f(-80, 80), Math.random2f(-45, 45), 10) => lights[i].pos;
+    lights[i].color(@(Math.randomf(), Math.randomf(), Math.randomf()));
+}
+
+0 => int frame;
+
+fun float run(int pipelined)
+{
+    GG.pipelined(pipelined);
+
+    // warmup
+    repeat (10) GG.nextFrame() => now;
+
+    0::second => dur frame_total;
+    repeat (NUM_FRAMES) {
+        frame++;
+        for (int i; i < NUM_MESHES; i++) {
+            origins[i] + @(Math.sin(frame * .05 + i), Math.cos(frame * .03 + i), 0)
+              => meshes[i].pos;
+            meshes[i].rotateY(.01);
+        }
+
+        GG.nextFrame() => now;
+        GG.dt()::second +=> frame_total;
+    }
+    return NUM_FRAMES / (frame_total / 1::second);
+}
+
+run(false) => float lockstep_fps;
+run(true) => float pipelined_fps;
+
+<<< "pipelined:", NUM_MESHES, "meshes x", NUM_LIGHTS, "lights x", NUM_FRAMES, "frames" >>>;
+<<< "avg fps, lockstep: ", lockstep_fps >>>;
+<<< "avg fps, pipelined:", pipelined_fps >>>;
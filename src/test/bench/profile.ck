@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+// name: profile.ck
+// desc: benchmark for the GG.profile() overhead, and a GG.trace() example.
+//       Renders NUM_MESHES moving meshes for NUM_FRAMES frames with the
+//       profiler off, then on while tracing, and reports the average frame
+//       time of each run, which should match within noise. Prints the
+//       profiler report and writes the trace to the given path, to open in
+//       chrome://tracing or https://ui.perfetto.dev.
+//
+// usage: chuck --chugin:ChuGL.chug profile.ck
+//        chuck --chugin:ChuGL.chug profile.ck:trace.json
+//-----------------------------------------------------------------------------
+
+2000 => int NUM_MESHES;
+300 => int NUM_FRAMES;
+me.arg(0) => string path;
+if (path == "") "profile_bench.json" => path;
+
+UI.disabled(true);
+@(0, 0, 60) => GG.scene().camera().pos;
+
+SphereGeometry geo;
+NormalMaterial material;
+GMesh meshes[NUM_MESHES];
+for (int i; i < NUM_MESHES; i++) {
+    meshes[i].mesh(geo, material);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-50, 50), Math.random2f(-30, 30), Math.random2f(-10, 10))
+      => meshes[i].pos;
+}
+
+fun float run()
+{
+    0 => float total_dt;
+    repeat (NUM_FRAMES) {
+        for (int i; i < NUM_MESHES; i++) meshes[i].rotateY(.02);
+        GG.nextFrame() => now;
+        GG.dt() +=> total_dt;
+    }
+    return total_dt / NUM_FRAMES * 1000;
+}
+
+// warmup
+repeat (30) GG.nextFrame() => now;
+
+run() => float off_ms;
+GG.trace(path);
+run() => float on_ms;
+GG.traceStop();
+GG.nextFrame() => now;
+
+<<< "profile:", NUM_MESHES, "meshes x", NUM_FRAMES, "frames" >>>;
+<<< "avg frame ms, profiler off:", off_ms >>>;
+<<< "avg frame ms, profiler on: ", on_ms >>>;
+<<< "trace written to", path >>>;
+chout <= GG.stats() <= IO.nl();
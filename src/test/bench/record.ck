@@ -0,0 +1,68 @@
+//-----------------------------------------------------------------------------
+// name: record.ck
+// desc: benchmark for GG.record().
+//       Draws NUM_MESHES moving meshes for NUM_FRAMES frames without
+//       recording, then while recording QOI frames, and reports the average and
+//       worst frame time of each run along with the frames written and dropped.
+//       Readback and encoding happen off the render thread, so recording should
+//       barely change frame times, and at 1080p60 should drop no frames.
+//       Pass a path to record something else, e.g. "out.gif" or
+//       "|ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r 60 -i - out.mp4"
+//       (W and H being the window's framebuffer size).
+//
+// usage: chuck --chugin:ChuGL.chug record.ck
+//        chuck --chugin:ChuGL.chug record.ck:out.gif
+//-----------------------------------------------------------------------------
+
+2000 => int NUM_MESHES;
+300 => int NUM_FRAMES;
+me.arg(0) => string path;
+if (path == "") "record_bench_%05d.qoi" => path;
+
+UI.disabled(true);
+GWindow.windowed(1920, 1080);
+@(0, 0, 60) => GG.scene().camera().pos;
+
+SphereGeometry geo;
+NormalMaterial material;
+GMesh meshes[NUM_MESHES];
+for (int i; i < NUM_MESHES; i++) {
+    meshes[i].mesh(geo, material);
+    meshes[i] --> GG.scene();
+    @(Math.random2f(-50, 50), Math.random2f(-30, 30), Math.random2f(-10, 10))
+      => meshes[i].pos;
+}
+
+0 => int frame;
+0 => float worst_dt;
+
+fun float run()
+{
+    0 => worst_dt;
+    0::second => dur frame_total;
+    repeat (NUM_FRAMES) {
+        frame++;
+        for (int i; i < NUM_MESHES; i++) meshes[i].rotateY(.02);
+        GG.nextFrame() => now;
+        GG.dt()::second +=> frame_total;
+        Math.max(worst_dt, GG.dt()) => worst_dt;
+    }
+    return (frame_total / 1::second) / NUM_FRAMES * 1000;
+}
+
+// warmup
+repeat (30) GG.nextFrame() => now;
+
+run() => float base_ms;
+worst_dt => float base_worst;
+
+GG.record(path);
+run() => float record_ms;
+worst_dt => float record_worst;
+GG.recordStop();
+GG.nextFrame() => now;
+
+<<< "record:", NUM_MESHES, "meshes x", NUM_FRAMES, "frames to", path >>>;
+<<< "avg / worst frame ms, not recording:", base_ms, base_worst * 1000 >>>;
+<<< "avg / worst frame ms, recording:    ", record_ms, record_worst * 1000 >>>;
+<<< "frames written:", GG.recordWritten(), "dropped:", GG.recordDropped() >>>;
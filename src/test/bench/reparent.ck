@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// name: reparent.ck
+// desc: benchmark for scenegraph attach/detach.
+//       Builds NUM_SUBTREES subtrees of 100 GGens each (root -> 9 children ->
+//       10 grandchildren), split between two parents in the same scene, and
+//       moves every subtree to the other parent every frame.
+//       Reparenting within a scene should cost O(1) per subtree on both the
+//       audio and render threads, independent of subtree size and of how
+//       many siblings each parent has.
+//
+// usage: chuck --chugin:ChuGL.chug reparent.ck
+//-----------------------------------------------------------------------------
+
+10000 => int NUM_SUBTREES;
+100 => int NUM_FRAMES;
+
+GGen parent_a --> GG.scene();
+GGen parent_b --> GG.scene();
+
+GGen roots[NUM_SUBTREES];
+for (int i; i < NUM_SUBTREES; i++) {
+    for (int j; j < 9; j++) {
+        GGen child --> roots[i];
+        for (int k; k < 10; k++) {
+            GGen grandchild --> child;
+        }
+    }
+    roots[i] --> ((i % 2) ? parent_a : parent_b);
+}
+
+<<< "reparent: built", NUM_SUBTREES, "subtrees of", 1 + roots[0].numChildren() * 11, "GGens" >>>;
+
+0::second => dur frame_total;
+
+// warmup
+repeat (10) GG.nextFrame() => now;
+
+for (0 => int frame; frame < NUM_FRAMES; frame++) {
+    for (int i; i < NUM_SUBTREES; i++) {
+        roots[i] --> ((roots[i].parent() == parent_a) ? parent_b : parent_a);
+    }
+
+    GG.nextFrame() => now;
+    GG.dt()::second +=> frame_total;
+}
+
+<<< "reparent:", NUM_SUBTREES, "subtrees x", NUM_FRAMES, "frames" >>>;
+<<< "avg frame time (ms):", (frame_total / NUM_FRAMES) / 1::ms >>>;
+<<< "avg fps:", NUM_FRAMES / (frame_total / 1::second) >>>;
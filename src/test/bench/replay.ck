@@ -0,0 +1,30 @@
+//-----------------------------------------------------------------------------
+// name: replay.ck
+// desc: benchmark any piece from a capture of its graphics commands.
+//       In capture mode, put this first on the command line so GG.capture()
+//       runs before the piece's first GG.nextFrame(); the piece is recorded
+//       as it plays, until it exits or the window is closed.
+//       In replay mode the capture is rendered offline at its original size
+//       as fast as the machine allows, without running the piece, and the
+//       frame rate and per-zone GG.profile() times are printed at the end.
+//       Run from the piece's directory, files it loads are loaded again.
+//
+// usage: chuck --chugin:ChuGL.chug replay.ck:capture:piece.cglc piece.ck
+//        chuck --chugin:ChuGL.chug replay.ck:piece.cglc
+//-----------------------------------------------------------------------------
+
+if (me.args() == 2 && me.arg(0) == "capture") {
+    GG.capture(me.arg(1));
+    me.exit();
+}
+
+if (me.args() != 1) {
+    <<< "usage: replay.ck:capture:<file> <piece.ck>, or replay.ck:<file>" >>>;
+    me.exit();
+}
+
+GG.profile(true);
+GG.replay(me.arg(0));
+// starts the graphics thread. It never wakes this shred, chuck exits after the
+// last frame
+GG.nextFrame() => now;
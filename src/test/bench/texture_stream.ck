@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+// name: texture_stream.ck
+// desc: benchmark for streamed texture loading.
+//       Loads NUM_TEXTURES images with mips in a single frame, each drawn on
+//       its own plane, and reports the worst frame time until every texture
+//       has finished loading. Decoding happens on worker threads and uploads
+//       are capped at GG.textureUploadBudget() bytes per frame, so the worst
+//       frame should stay close to the average instead of stalling on load.
+//       Try different budgets to trade load time for frame time.
+//
+// usage: chuck --chugin:ChuGL.chug texture_stream.ck
+//-----------------------------------------------------------------------------
+
+100 => int NUM_TEXTURES;
+me.dir() + "../../../examples/data/textures/" => string DIR;
+[
+    "chuck-logo.png", "awesomeface.png", "brush-texture.png", "snowflake1.png",
+    "Cat-1/Cat-1-Idle.png", "Cat-1/Cat-1-Run.png", "Cat-1/Cat-1-Walk.png",
+    "Cat-1/Cat-1-Sitting.png", "artful-design/flare-tng-1.png"
+] @=> string files[];
+
+UI.disabled(true);
+@(0, 0, 12) => GG.scene().camera().pos;
+
+// warmup
+repeat (30) GG.nextFrame() => now;
+
+TextureLoadDesc load_desc;
+true => load_desc.gen_mips;
+
+PlaneGeometry plane_geo;
+Texture @ textures[NUM_TEXTURES];
+FlatMaterial materials[NUM_TEXTURES];
+GMesh planes[NUM_TEXTURES];
+for (int i; i < NUM_TEXTURES; i++) {
+    Texture.load(DIR + files[i % files.size()], load_desc) @=> textures[i];
+    materials[i].colorMap(textures[i]);
+    planes[i].mesh(plane_geo, materials[i]);
+    planes[i] --> GG.scene();
+    @(i % 10 - 4.5, i / 10 - 4.5, 0) => planes[i].pos;
+}
+
+fun int loading()
+{
+    0 => int count;
+    for (auto tex : textures) if (!tex.loaded()) count++;
+    return count;
+}
+
+0 => int frames;
+0 => float worst_dt;
+0 => float total_dt;
+while (loading() > 0) {
+    GG.nextFrame() => now;
+    frames++;
+    GG.dt() +=> total_dt;
+    Math.max(worst_dt, GG.dt()) => worst_dt;
+}
+
+<<< "texture_stream:", NUM_TEXTURES, "textures, budget",
+    GG.textureUploadBudget(), "bytes/frame" >>>;
+<<< "frames to load:", frames >>>;
+<<< "avg frame ms:  ", total_dt / Math.max(frames, 1) * 1000 >>>;
+<<< "worst frame ms:", worst_dt * 1000 >>>;
@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// name: texture_write.ck
+// desc: benchmark for Texture.write(float[]) throughput.
+//       Writes a full 1024x1024 RGBA8 texture every frame and reports the
+//       average frame time. The chuck-side gather + conversion and the render
+//       thread's command queue drain both land on the critical path, so this
+//       is a good end-to-end measure of the upload path.
+//       Use to compare command queue conversion paths (e.g. scalar vs SIMD,
+//       conversion inside vs outside the command queue lock).
+//
+// usage: chuck --chugin:ChuGL.chug texture_write.ck
+//-----------------------------------------------------------------------------
+
+1024 => int SIZE;
+300 => int NUM_FRAMES;
+
+TextureDesc desc;
+SIZE => desc.width;
+SIZE => desc.height;
+Texture.Format_RGBA8Unorm => desc.format;
+false => desc.mips;
+Texture tex(desc);
+
+// display the texture so the upload is actually used by the renderer
+PlaneGeometry plane_geo;
+FlatMaterial mat;
+mat.colorMap(tex);
+GMesh plane(plane_geo, mat) --> GG.scene();
+
+float pixels[SIZE * SIZE * 4];
+
+// fill with a pattern that changes every frame
+fun void fill(int frame)
+{
+    (frame % 256) / 255.0 => float t;
+    for (0 => int i; i < pixels.size(); 4 +=> i) {
+        (i % 1024) / 1024.0 => pixels[i + 0];
+        t => pixels[i + 1];
+        1.0 - t => pixels[i + 2];
+        1.0 => pixels[i + 3];
+    }
+}
+
+0::second => dur frame_total;
+
+// warmup
+repeat (10) GG.nextFrame() => now;
+
+for (0 => int frame; frame < NUM_FRAMES; frame++) {
+    fill(frame);
+    tex.write(pixels);
+
+    GG.nextFrame() => now;
+    GG.dt()::second +=> frame_total;
+}
+
+<<< "texture_write:", SIZE + "x" + SIZE, "RGBA8 x", NUM_FRAMES, "frames" >>>;
+<<< "avg frame time (ms):", (frame_total / NUM_FRAMES) / 1::ms >>>;
+<<< "avg fps:", NUM_FRAMES / (frame_total / 1::second) >>>;
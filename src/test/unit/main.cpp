@@ -0,0 +1,77 @@
+/*
+ChuGL cpu-only unit tests
+
+usage: ChuGL-Unit-Tests [test_name]
+    runs every test if no name is given
+*/
+#include "unit_test.h"
+
+#include <string.h>
+
+int ut_failures = 0;
+
+typedef void (*UT_Func)();
+
+void UT_CommandStream();
+void UT_Convert();
+void UT_DestroyQueue();
+void UT_DrawJobs();
+void UT_FrameCapture();
+void UT_InputStream();
+void UT_InstanceCull();
+void UT_LightCluster();
+void UT_Log();
+void UT_MeshLOD();
+void UT_Profiler();
+void UT_RenderGraph();
+void UT_Seqlock();
+void UT_ShaderReflect();
+void UT_TextureStream();
+void UT_TextureTranscode();
+
+struct UT_Entry {
+    const char* name;
+    UT_Func func;
+};
+
+static UT_Entry ut_table[] = {
+    { "command_stream", UT_CommandStream },
+    { "convert", UT_Convert },
+    { "destroy_queue", UT_DestroyQueue },
+    { "draw_jobs", UT_DrawJobs },
+    { "frame_capture", UT_FrameCapture },
+    { "input_stream", UT_InputStream },
+    { "instance_cull", UT_InstanceCull },
+    { "light_cluster", UT_LightCluster },
+    { "log", UT_Log },
+    { "mesh_lod", UT_MeshLOD },
+    { "profiler", UT_Profiler },
+    { "render_graph", UT_RenderGraph },
+    { "seqlock", UT_Seqlock },
+    { "shader_reflect", UT_ShaderReflect },
+    { "texture_stream", UT_TextureStream },
+    { "texture_transcode", UT_TextureTranscode },
+};
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : NULL;
+    int ran            = 0;
+
+    for (size_t i = 0; i < sizeof(ut_table) / sizeof(ut_table[0]); i++) {
+        if (filter && strcmp(filter, ut_table[i].name) != 0) continue;
+
+        int failures_before = ut_failures;
+        ut_table[i].func();
+        printf("[%s] %s\n", ut_failures == failures_before ? "PASS" : "FAIL",
+               ut_table[i].name);
+        ++ran;
+    }
+
+    if (ran == 0) {
+        fprintf(stderr, "no test named \"%s\"\n", filter);
+        return 1;
+    }
+
+    return ut_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include "unit_test.h"
+
+#include "command_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define UT_STREAM_FRAMES 4
+
+// stands in for an SG_Command with a payload passed by pointer
+struct UT_Command {
+    u32 type;
+    u64 next_offset;
+    const u8* block;
+    u64 block_size;
+};
+
+static const char* ut_stream_path = "ut_command_stream.bin";
+
+static std::vector<u8> _UT_ReadAll(const char* path)
+{
+    std::vector<u8> data;
+    FILE* file = fopen(path, "rb");
+    if (!file) return data;
+    fseek(file, 0, SEEK_END);
+    data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    data.resize(fread(data.data(), 1, data.size(), file));
+    fclose(file);
+    return data;
+}
+
+static void _UT_WriteAll(const char* path, const u8* data, size_t size)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) return;
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+// frame i has i commands, each pointing at a block of 3 + 5 * i + j bytes
+static void _UT_Roundtrip()
+{
+    UT_Rng rng = { 7 };
+    std::vector<std::vector<u8>> blocks;
+    std::vector<std::vector<u8>> frames(UT_STREAM_FRAMES);
+
+    CommandStreamWriter writer;
+    UT_CHECK(CommandStream_Open(&writer, ut_stream_path, 42, 640, 480));
+    for (int f = 0; f < UT_STREAM_FRAMES; f++) {
+        std::vector<CommandStreamAttachment> attachments;
+        frames[f].resize(f * sizeof(UT_Command));
+        for (int j = 0; j < f; j++) {
+            blocks.emplace_back(3 + 5 * f + j);
+            for (u8& b : blocks.back()) b = (u8)rng.range(0, 255);
+
+            UT_Command cmd  = {};
+            cmd.type        = 100 + j;
+            cmd.next_offset = (j + 1) * sizeof(UT_Command);
+            cmd.block       = blocks.back().data();
+            cmd.block_size  = blocks.back().size();
+            memcpy(frames[f].data() + j * sizeof(UT_Command), &cmd, sizeof(cmd));
+
+            CommandStreamAttachment att = {};
+            att.patch_offset = j * sizeof(UT_Command) + offsetof(UT_Command, block);
+            att.size         = cmd.block_size;
+            att.data         = cmd.block;
+            attachments.push_back(att);
+        }
+        UT_CHECK(CommandStream_WriteFrame(&writer, f * 0.5, frames[f].data(),
+                                          frames[f].size(), attachments.data(),
+                                          (u32)attachments.size()));
+    }
+    UT_CHECK(writer.frame_count == UT_STREAM_FRAMES && !writer.failed);
+    u64 written = writer.bytes_written;
+    CommandStream_Close(&writer);
+    UT_CHECK_MSG(_UT_ReadAll(ut_stream_path).size() == written, "%llu bytes",
+                 (unsigned long long)written);
+
+    CommandStreamReader reader;
+    UT_CHECK(CommandStream_Load(&reader, ut_stream_path));
+    UT_CHECK(reader.header.tag == 42 && reader.header.width == 640
+             && reader.header.height == 480);
+
+    CommandStreamFrame frame;
+    size_t block_idx = 0;
+    for (int f = 0; f < UT_STREAM_FRAMES; f++) {
+        UT_CHECK_MSG(CommandStream_NextFrame(&reader, &frame), "frame %d", f);
+        UT_CHECK(frame.time == f * 0.5);
+        UT_CHECK(((uintptr_t)frame.commands & 7) == 0);
+        UT_CHECK(frame.command_bytes == frames[f].size());
+        UT_CHECK(f == 0
+                 || memcmp(frame.commands, frames[f].data(), frame.command_bytes) == 0);
+        UT_CHECK(frame.attachment_count == (u32)f);
+
+        // patched like the replayer does, every pointer finds its block again
+        CommandStreamAttachment att;
+        int count = 0;
+        while (CommandStream_NextAttachment(&frame, &att)) {
+            UT_Command* cmd = (UT_Command*)(frame.commands + att.patch_offset
+                                            - offsetof(UT_Command, block));
+            cmd->block      = (const u8*)att.data;
+            UT_CHECK(att.size == cmd->block_size);
+            UT_CHECK(att.size == blocks[block_idx].size());
+            UT_CHECK(memcmp(cmd->block, blocks[block_idx].data(), att.size) == 0);
+            UT_CHECK(((uintptr_t)att.data & 7) == 0);
+            ++block_idx;
+            ++count;
+        }
+        UT_CHECK(count == f);
+    }
+    UT_CHECK(!CommandStream_NextFrame(&reader, &frame) && !reader.corrupt);
+    UT_CHECK(reader.frame_count == UT_STREAM_FRAMES);
+    CommandStream_Free(&reader);
+    UT_CHECK(reader.data == NULL);
+}
+
+// the roundtrip's file, cut off or damaged
+static void _UT_Corrupt()
+{
+    std::vector<u8> file = _UT_ReadAll(ut_stream_path);
+    UT_CHECK(file.size() > 200);
+    CommandStreamReader reader;
+    CommandStreamFrame frame;
+
+    // cut inside the last frame, the ones before it still read
+    _UT_WriteAll(ut_stream_path, file.data(), file.size() - 5);
+    UT_CHECK(CommandStream_Load(&reader, ut_stream_path));
+    int frames = 0;
+    while (CommandStream_NextFrame(&reader, &frame)) ++frames;
+    UT_CHECK_MSG(frames == UT_STREAM_FRAMES - 1, "%d frames", frames);
+    UT_CHECK(reader.corrupt);
+    CommandStream_Free(&reader);
+
+    // an attachment patching past the commands of frame 1 (1 command, 1 block)
+    std::vector<u8> bad = file;
+    u64 offset          = sizeof(CommandStreamHeader);
+    offset += sizeof(CommandStreamFrameHeader); // frame 0 is empty
+    CommandStreamFrameHeader header;
+    memcpy(&header, bad.data() + offset, sizeof(header));
+    UT_CHECK(header.attachment_count == 1);
+    u64 patch_offset = header.command_bytes;
+    memcpy(bad.data() + offset + sizeof(header) + header.command_bytes, &patch_offset,
+           sizeof(patch_offset));
+    _UT_WriteAll(ut_stream_path, bad.data(), bad.size());
+    UT_CHECK(CommandStream_Load(&reader, ut_stream_path));
+    UT_CHECK(CommandStream_NextFrame(&reader, &frame));
+    UT_CHECK(!CommandStream_NextFrame(&reader, &frame) && reader.corrupt);
+    CommandStream_Free(&reader);
+
+    // not a command stream, or another version
+    bad    = file;
+    bad[0] = 'X';
+    _UT_WriteAll(ut_stream_path, bad.data(), bad.size());
+    UT_CHECK(!CommandStream_Load(&reader, ut_stream_path));
+    bad = file;
+    bad[offsetof(CommandStreamHeader, version)] += 1;
+    _UT_WriteAll(ut_stream_path, bad.data(), bad.size());
+    UT_CHECK(!CommandStream_Load(&reader, ut_stream_path));
+    _UT_WriteAll(ut_stream_path, file.data(), 4);
+    UT_CHECK(!CommandStream_Load(&reader, ut_stream_path));
+
+    remove(ut_stream_path);
+    UT_CHECK(!CommandStream_Load(&reader, ut_stream_path));
+    UT_CHECK(reader.data == NULL);
+}
+
+void UT_CommandStream()
+{
+    _UT_Roundtrip();
+    _UT_Corrupt();
+}
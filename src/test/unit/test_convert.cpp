@@ -0,0 +1,67 @@
+#include "unit_test.h"
+
+#include "core/convert.h"
+
+#include <string.h>
+
+#define UT_CONVERT_MAX 67 // a few SIMD blocks of 16 plus every tail length
+
+// every length up to a few SIMD blocks, so each remainder path runs, from an
+// unaligned source. Nothing is written past count
+static void _UT_F64ToF32()
+{
+    UT_Rng rng = { 11 };
+    f64 src[UT_CONVERT_MAX + 1];
+    for (int i = 0; i <= UT_CONVERT_MAX; i++) src[i] = rng.range(-1e6f, 1e6f) / 3.0;
+
+    for (int count = 0; count < UT_CONVERT_MAX; count++) {
+        f32 dst[UT_CONVERT_MAX + 1];
+        memset(dst, 0xff, sizeof(dst));
+        CV_F64ToF32(src + 1, dst, count);
+        for (int i = 0; i < count; i++) {
+            UT_CHECK_MSG(dst[i] == (f32)src[i + 1], "count %d, [%d]", count, i);
+        }
+        u32 sentinel;
+        memcpy(&sentinel, dst + count, sizeof(sentinel));
+        UT_CHECK_MSG(sentinel == 0xffffffff, "count %d", count);
+    }
+}
+
+static void _UT_F64ToUnorm8()
+{
+    UT_Rng rng = { 17 };
+    f64 src[UT_CONVERT_MAX + 1];
+    for (int i = 0; i <= UT_CONVERT_MAX; i++) src[i] = rng.range(-0.5f, 1.5f);
+
+    for (int count = 0; count < UT_CONVERT_MAX; count++) {
+        u8 dst[UT_CONVERT_MAX + 1];
+        memset(dst, 0xab, sizeof(dst));
+        CV_F64ToUnorm8(src + 1, dst, count);
+        for (int i = 0; i < count; i++) {
+            u8 expected = (u8)(UINT8_MAX * CLAMP(src[i + 1], 0.0, 1.0));
+            UT_CHECK_MSG(dst[i] == expected, "count %d, [%d]: %f -> %d, expected %d",
+                         count, i, src[i + 1], dst[i], expected);
+        }
+        UT_CHECK_MSG(dst[count] == 0xab, "count %d", count);
+    }
+
+    // clamped, and truncated rather than rounded. Repeated so the values go
+    // through both the SIMD blocks and the remainder
+    f64 values[]  = { -1.0, -0.001, 0.0, 0.5, 0.999, 1.0, 1.001, 100.0 };
+    u8 expected[] = { 0, 0, 0, 127, 254, 255, 255, 255 };
+    int n         = ARRAY_LENGTH(values);
+    f64 many[24];
+    for (int i = 0; i < 24; i++) many[i] = values[i % n];
+    u8 dst[24];
+    CV_F64ToUnorm8(many, dst, 24);
+    for (int i = 0; i < 24; i++) {
+        UT_CHECK_MSG(dst[i] == expected[i % n], "%f -> %d, expected %d", many[i],
+                     dst[i], expected[i % n]);
+    }
+}
+
+void UT_Convert()
+{
+    _UT_F64ToF32();
+    _UT_F64ToUnorm8();
+}
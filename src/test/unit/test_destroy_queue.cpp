@@ -0,0 +1,199 @@
+#include "unit_test.h"
+
+#include "destroy_queue.h"
+
+#define UT_COMPONENT_COUNT 1000000
+
+// fake clock, advanced by the destroy callback
+struct UT_DestroyState {
+    f64 now_ms;
+    f64 destroy_ms; // cost of each destroy
+    UT_Rng rng;
+    f64 jitter_ms; // destroy_ms +- jitter_ms if nonzero
+
+    u32 next_expected_id; // destroys must be in push order
+    int out_of_order;
+    DestroyQueue* requeue; // if set, each destroy pushes id + 1 onto it
+};
+
+static f64 _UT_Clock(void* udata)
+{
+    return ((UT_DestroyState*)udata)->now_ms;
+}
+
+static void _UT_Destroy(u32 id, void* udata)
+{
+    UT_DestroyState* state = (UT_DestroyState*)udata;
+    if (id != state->next_expected_id) ++state->out_of_order;
+    state->next_expected_id = id + 1;
+
+    state->now_ms += state->destroy_ms;
+    if (state->jitter_ms > 0)
+        state->now_ms += state->rng.range(-state->jitter_ms, state->jitter_ms);
+
+    if (state->requeue) DestroyQueue_Push(state->requeue, id + 1, 0);
+}
+
+// frees 1M components with a time budget, no frame may overrun it
+static void _UT_TimeBudget()
+{
+    DestroyQueue queue = {};
+    DestroyQueue_Init(&queue, true);
+    for (u32 id = 1; id <= UT_COMPONENT_COUNT; id++) DestroyQueue_Push(&queue, id, 0);
+    UT_CHECK(DestroyQueue_Depth(&queue) == UT_COMPONENT_COUNT);
+    UT_CHECK(DestroyQueue_Tombstoned(&queue, 1));
+    UT_CHECK(DestroyQueue_Tombstoned(&queue, UT_COMPONENT_COUNT));
+
+    UT_DestroyState state  = {};
+    state.destroy_ms       = 0.0007;
+    state.next_expected_id = 1;
+
+    DestroyQueueBudget budget = { 2.0, 0 };
+    int frames = 0, total = 0, max_frame = 0;
+    f64 worst_ms = 0;
+    while (DestroyQueue_Depth(&queue) > 0 && frames < UT_COMPONENT_COUNT) {
+        int destroyed = DestroyQueue_Process(&queue, budget, _UT_Destroy, &state,
+                                             _UT_Clock, &state);
+        UT_CHECK(destroyed > 0);
+        worst_ms  = MAX(worst_ms, queue.frame_stats.ms);
+        max_frame = MAX(max_frame, destroyed);
+        total += destroyed;
+        ++frames;
+        UT_CHECK(queue.frame_stats.depth == UT_COMPONENT_COUNT - total);
+    }
+
+    UT_CHECK_MSG(worst_ms <= budget.max_ms + 1e-6, "worst frame %fms", worst_ms);
+    UT_CHECK(total == UT_COMPONENT_COUNT);
+    UT_CHECK(queue.lifetime_destroyed == UT_COMPONENT_COUNT);
+    UT_CHECK(state.out_of_order == 0);
+    // spread out, but not much more than needed: 2ms / .0007ms ~= 2857 per frame
+    UT_CHECK_MSG(max_frame >= 2800 && max_frame <= 2858, "max %d per frame",
+                 max_frame);
+    UT_CHECK(frames <= UT_COMPONENT_COUNT / 2800 + 1);
+
+    // tombstones are cleared once destroyed, and the id can be queued again
+    UT_CHECK(!DestroyQueue_Tombstoned(&queue, 1));
+    UT_CHECK(!DestroyQueue_Tombstoned(&queue, UT_COMPONENT_COUNT));
+    UT_CHECK(DestroyQueue_Push(&queue, 1, 0));
+    UT_CHECK(DestroyQueue_Depth(&queue) == 1);
+
+    DestroyQueue_Free(&queue);
+}
+
+// with noisy destroy times a frame can only overrun by the noise of one destroy
+static void _UT_TimeBudgetJitter()
+{
+    DestroyQueue queue = {};
+    DestroyQueue_Init(&queue, false);
+    for (u32 id = 1; id <= 100000; id++) DestroyQueue_Push(&queue, id, 0);
+
+    UT_DestroyState state  = {};
+    state.destroy_ms       = 0.01;
+    state.jitter_ms        = 0.005;
+    state.rng.state        = 7;
+    state.next_expected_id = 1;
+
+    DestroyQueueBudget budget = { 1.0, 0 };
+    f64 worst_ms              = 0;
+    while (DestroyQueue_Depth(&queue) > 0) {
+        DestroyQueue_Process(&queue, budget, _UT_Destroy, &state, _UT_Clock, &state);
+        worst_ms = MAX(worst_ms, queue.frame_stats.ms);
+    }
+    UT_CHECK_MSG(worst_ms <= budget.max_ms + 2 * state.jitter_ms, "worst frame %fms",
+                 worst_ms);
+    UT_CHECK(state.out_of_order == 0);
+    DestroyQueue_Free(&queue);
+}
+
+static void _UT_UnitBudget()
+{
+    DestroyQueue queue = {};
+    DestroyQueue_Init(&queue, true);
+
+    UT_Rng rng    = { 3 };
+    u64 remaining = 0;
+    for (u32 id = 1; id <= 10000; id++) {
+        u32 cost = (u32)rng.range(1, 4096);
+        DestroyQueue_Push(&queue, id, cost);
+        remaining += cost;
+    }
+
+    UT_DestroyState state  = {};
+    state.next_expected_id = 1;
+
+    DestroyQueueBudget budget = { 0, 64 * 1024 };
+    while (DestroyQueue_Depth(&queue) > 0) {
+        DestroyQueue_Process(&queue, budget, _UT_Destroy, &state, _UT_Clock, &state);
+        UT_CHECK(queue.frame_stats.units <= budget.max_units);
+        // stopped only because the next item wouldn't fit
+        if (DestroyQueue_Depth(&queue) > 0)
+            UT_CHECK(queue.frame_stats.units > budget.max_units - 4096);
+        remaining -= queue.frame_stats.units;
+    }
+    UT_CHECK(remaining == 0);
+    UT_CHECK(state.out_of_order == 0);
+
+    // an item over budget still goes through, alone
+    DestroyQueue_Push(&queue, 1, 100000);
+    DestroyQueue_Push(&queue, 2, 1);
+    state.next_expected_id = 1;
+    UT_CHECK(DestroyQueue_Process(&queue, budget, _UT_Destroy, &state, _UT_Clock,
+                                  &state)
+             == 1);
+    UT_CHECK(DestroyQueue_Process(&queue, budget, _UT_Destroy, &state, _UT_Clock,
+                                  &state)
+             == 1);
+
+    DestroyQueue_Free(&queue);
+}
+
+static void _UT_Tombstones()
+{
+    DestroyQueue queue = {};
+    DestroyQueue_Init(&queue, true);
+    UT_CHECK(DestroyQueue_Push(&queue, 5, 0));
+    UT_CHECK(!DestroyQueue_Push(&queue, 5, 0)); // double free
+    UT_CHECK(DestroyQueue_Depth(&queue) == 1);
+    UT_CHECK(!DestroyQueue_Tombstoned(&queue, 6));
+    DestroyQueue_Free(&queue);
+
+    // refcount queues take the same id more than once
+    DestroyQueue_Init(&queue, false);
+    UT_CHECK(DestroyQueue_Push(&queue, 5, 0));
+    UT_CHECK(DestroyQueue_Push(&queue, 5, 0));
+    UT_CHECK(DestroyQueue_Depth(&queue) == 2);
+    UT_CHECK(!DestroyQueue_Tombstoned(&queue, 5));
+    DestroyQueue_Free(&queue);
+}
+
+// items pushed while destroying wait for the next frame
+static void _UT_PushWhileDestroying()
+{
+    DestroyQueue queue = {};
+    DestroyQueue_Init(&queue, false);
+    DestroyQueue_Push(&queue, 1, 0);
+
+    UT_DestroyState state  = {};
+    state.next_expected_id = 1;
+    state.requeue          = &queue;
+
+    DestroyQueueBudget unlimited = {};
+    for (int frame = 0; frame < 100; frame++) {
+        UT_CHECK(DestroyQueue_Process(&queue, unlimited, _UT_Destroy, &state,
+                                      _UT_Clock, &state)
+                 == 1);
+        UT_CHECK(DestroyQueue_Depth(&queue) == 1);
+    }
+    UT_CHECK(state.out_of_order == 0);
+    UT_CHECK(state.next_expected_id == 101);
+    DestroyQueue_Free(&queue);
+}
+
+void UT_DestroyQueue()
+{
+    _UT_TimeBudget();
+    _UT_TimeBudgetJitter();
+    _UT_UnitBudget();
+    _UT_Tombstones();
+    _UT_PushWhileDestroying();
+}
@@ -0,0 +1,207 @@
+#include "unit_test.h"
+
+#include "draw_jobs.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define UT_GROUPS 4
+
+// same shape as G_DrawCall: bindgroup ranges in the middle of the draw
+struct UT_Draw {
+    u64 sort_key;
+    u32 instance_count;
+    struct {
+        u32 start, count;
+    } bg_list[UT_GROUPS];
+    u64 payload;
+};
+
+struct UT_Entry {
+    u32 binding;
+    u32 item;
+    u64 value;
+};
+
+struct UT_Recorder {
+    Arena draws;
+    Arena entries[UT_GROUPS];
+};
+
+static DrawListLayout _UT_Layout()
+{
+    DrawListLayout layout  = {};
+    layout.draw_size       = sizeof(UT_Draw);
+    layout.entry_size      = sizeof(UT_Entry);
+    layout.group_count     = UT_GROUPS;
+    layout.bg_start_offset = offsetof(UT_Draw, bg_list);
+    layout.bg_stride       = sizeof(((UT_Draw*)0)->bg_list[0]);
+    return layout;
+}
+
+static void _UT_Free(UT_Recorder* rec)
+{
+    Arena::free(&rec->draws);
+    for (int g = 0; g < UT_GROUPS; g++) Arena::free(rec->entries + g);
+}
+
+static bool _UT_EqualBytes(Arena* a, Arena* b)
+{
+    if (a->curr != b->curr) return false;
+    return a->curr == 0 || memcmp(a->base, b->base, a->curr) == 0;
+}
+
+static bool _UT_Equal(UT_Recorder* a, UT_Recorder* b)
+{
+    if (!_UT_EqualBytes(&a->draws, &b->draws)) return false;
+    for (int g = 0; g < UT_GROUPS; g++) {
+        if (!_UT_EqualBytes(a->entries + g, b->entries + g)) return false;
+    }
+    return true;
+}
+
+// records item's draws like _R_RenderScene: skipped primitives have none,
+// transparent ones one per instance, opaque ones a single instanced draw
+static void _UT_RecordItem(UT_Recorder* rec, int item)
+{
+    UT_Rng rng     = { (unsigned int)item * 2654435761u + 1 };
+    int kind       = (int)(rng.next01() * 4);
+    int draw_count = kind == 0 ? 0 : kind == 1 ? 1 + (int)(rng.next01() * 5) : 1;
+
+    for (int d = 0; d < draw_count; d++) {
+        UT_Draw* draw        = ARENA_PUSH_ZERO_TYPE(&rec->draws, UT_Draw);
+        draw->sort_key       = ((u64)item << 32) | d;
+        draw->instance_count = kind == 1 ? 1 : 1 + item % 7;
+        draw->payload        = rng.state;
+
+        for (int g = 0; g < UT_GROUPS; g++) {
+            draw->bg_list[g].start = ARENA_LENGTH(rec->entries + g, UT_Entry);
+            int entry_count        = (int)(rng.next01() * 4);
+            for (int e = 0; e < entry_count; e++) {
+                UT_Entry* entry = ARENA_PUSH_ZERO_TYPE(rec->entries + g, UT_Entry);
+                entry->binding  = e;
+                entry->item     = item;
+                entry->value    = rng.state;
+                ++draw->bg_list[g].count;
+            }
+        }
+    }
+}
+
+struct UT_ParallelRecord {
+    UT_Recorder* dst;
+    UT_Recorder* chunks;
+};
+
+static void _UT_RecordChunk(int chunk, int begin, int end, void* udata)
+{
+    UT_ParallelRecord* record = (UT_ParallelRecord*)udata;
+    UT_Recorder* rec          = chunk == 0 ? record->dst : record->chunks + chunk;
+    for (int i = begin; i < end; i++) _UT_RecordItem(rec, i);
+}
+
+// merged parallel recording is bytewise identical to serial recording
+static void _UT_MatchesSerial(JobPool* pool, int item_count, int chunk_count)
+{
+    ASSERT(chunk_count <= 8);
+
+    // both start with draws from an earlier pass, so chunk 0 doesn't start at 0
+    UT_Recorder serial   = {};
+    UT_Recorder parallel = {};
+    _UT_RecordItem(&serial, 1000003);
+    _UT_RecordItem(&parallel, 1000003);
+
+    for (int i = 0; i < item_count; i++) _UT_RecordItem(&serial, i);
+
+    UT_Recorder chunks[8]    = {};
+    UT_ParallelRecord record = { &parallel, chunks };
+    JobPool_ParallelFor(pool, item_count, chunk_count, _UT_RecordChunk, &record);
+
+    DrawListLayout layout = _UT_Layout();
+    for (int c = 1; c < chunk_count; c++) {
+        DrawList_Append(&layout, &parallel.draws, parallel.entries, &chunks[c].draws,
+                        chunks[c].entries);
+    }
+
+    UT_CHECK_MSG(_UT_Equal(&serial, &parallel), "%d items, %d chunks", item_count,
+                 chunk_count);
+
+    for (int c = 0; c < 8; c++) _UT_Free(chunks + c);
+    _UT_Free(&serial);
+    _UT_Free(&parallel);
+}
+
+// chunks cover [0, count) in order, without gaps or overlap
+static void _UT_ChunkRanges(JobPool* pool)
+{
+    UT_CHECK(JobPool_ChunkCount(pool, 0, 64) == 1);
+    UT_CHECK(JobPool_ChunkCount(pool, 100, 64) == 1);
+    UT_CHECK(JobPool_ChunkCount(pool, 128, 64) == MIN(2, pool->worker_count + 1));
+    UT_CHECK(JobPool_ChunkCount(pool, 100000, 64) == pool->worker_count + 1);
+
+    int counts[] = { 0, 1, 7, 100, 1023 };
+    for (int count : counts) {
+        for (int chunks = 1; chunks <= 8; chunks++) {
+            UT_CHECK(JobPool_ChunkBegin(count, chunks, 0) == 0);
+            UT_CHECK(JobPool_ChunkBegin(count, chunks, chunks) == count);
+            for (int c = 0; c < chunks; c++) {
+                UT_CHECK(JobPool_ChunkBegin(count, chunks, c)
+                         <= JobPool_ChunkBegin(count, chunks, c + 1));
+            }
+        }
+    }
+}
+
+struct UT_Visits {
+    int visits[4096];
+};
+
+static void _UT_Visit(int chunk, int begin, int end, void* udata)
+{
+    UT_Visits* v = (UT_Visits*)udata;
+    for (int i = begin; i < end; i++) v->visits[i] += chunk + 1;
+}
+
+// back to back jobs each visit every item exactly once, from the right chunk
+static void _UT_BackToBack(JobPool* pool)
+{
+    static UT_Visits v;
+    int chunk_count = pool->worker_count + 1;
+    for (int job = 0; job < 500; job++) {
+        int count = 1 + (job * 37) % 4096;
+        memset(&v, 0, sizeof(v));
+        JobPool_ParallelFor(pool, count, chunk_count, _UT_Visit, &v);
+
+        int wrong = 0;
+        for (int c = 0; c < chunk_count; c++) {
+            for (int i = JobPool_ChunkBegin(count, chunk_count, c);
+                 i < JobPool_ChunkBegin(count, chunk_count, c + 1); i++) {
+                if (v.visits[i] != c + 1) ++wrong;
+            }
+        }
+        UT_CHECK_MSG(wrong == 0, "job %d: %d items visited wrongly", job, wrong);
+        if (wrong) break;
+    }
+}
+
+void UT_DrawJobs()
+{
+    JobPool serial = {};
+    JobPool_Init(&serial, 0);
+    _UT_ChunkRanges(&serial);
+    _UT_MatchesSerial(&serial, 1000, 4);
+
+    JobPool pool = {};
+    JobPool_Init(&pool, 3);
+    _UT_ChunkRanges(&pool);
+    _UT_BackToBack(&pool);
+
+    int item_counts[] = { 0, 1, 3, 64, 1000, 5000 };
+    for (int items : item_counts) {
+        for (int chunks = 1; chunks <= 8; chunks++)
+            _UT_MatchesSerial(&pool, items, chunks);
+    }
+
+    JobPool_Free(&pool);
+    JobPool_Free(&serial);
+}
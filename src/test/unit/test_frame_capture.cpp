@@ -0,0 +1,386 @@
+#include "unit_test.h"
+
+#include "core/memory.h"
+#include "frame_capture.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+// gradients, flat runs, noise and translucent texels, so every QOI op and long
+// and short LZW strings show up
+static u8* _UT_Image(int width, int height, u32 seed)
+{
+    UT_Rng rng = { seed };
+    u8* rgba   = (u8*)malloc((size_t)width * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            u8* px = rgba + ((size_t)y * width + x) * 4;
+            if (y < height / 4) { // run
+                px[0] = 10, px[1] = 20, px[2] = 30, px[3] = 255;
+            } else if (y < height / 2) { // gradient
+                px[0] = (u8)(x * 2), px[1] = (u8)(y * 3), px[2] = (u8)(x + y);
+                px[3] = 255;
+            } else { // noise, some translucent
+                for (int c = 0; c < 4; c++) px[c] = (u8)rng.range(0, 256);
+                if (x % 3) px[3] = 255;
+            }
+        }
+    }
+    return rgba;
+}
+
+// reference decoder, https://qoiformat.org/qoi-specification.pdf
+static u8* _UT_DecodeQOI(const u8* data, u64 len, int* width, int* height)
+{
+    if (len < 22 || memcmp(data, "qoif", 4) != 0) return NULL;
+    *width     = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+    *height    = (data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11];
+    u64 count  = (u64)*width * *height;
+    u8* rgba   = (u8*)malloc(count * 4);
+    u8 index[64][4] = {};
+    u8 px[4]        = { 0, 0, 0, 255 };
+    u64 p = 14, run = 0;
+    for (u64 i = 0; i < count; i++) {
+        if (run > 0) {
+            --run;
+        } else if (p < len - 8) {
+            u8 op = data[p++];
+            if (op == 0xFE) {
+                memcpy(px, data + p, 3);
+                p += 3;
+            } else if (op == 0xFF) {
+                memcpy(px, data + p, 4);
+                p += 4;
+            } else if ((op & 0xC0) == 0x00) {
+                memcpy(px, index[op], 4);
+            } else if ((op & 0xC0) == 0x40) {
+                px[0] += ((op >> 4) & 3) - 2;
+                px[1] += ((op >> 2) & 3) - 2;
+                px[2] += (op & 3) - 2;
+            } else if ((op & 0xC0) == 0x80) {
+                int dg = (op & 0x3F) - 32;
+                u8 b2  = data[p++];
+                px[0] += dg - 8 + (b2 >> 4);
+                px[1] += dg;
+                px[2] += dg - 8 + (b2 & 0xF);
+            } else {
+                run = op & 0x3F;
+            }
+            memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        }
+        memcpy(rgba + i * 4, px, 4);
+    }
+    return rgba;
+}
+
+static void _UT_QOI()
+{
+    int width = 97, height = 61;
+    u8* rgba  = _UT_Image(width, height, 3);
+
+    Arena out = {};
+    UT_CHECK(FrameCapture_EncodeQOI(&out, rgba, width, height));
+    // compresses the runs and gradients
+    UT_CHECK(out.curr < (u64)width * height * 4);
+    UT_CHECK(memcmp(out.base + out.curr - 8, "\0\0\0\0\0\0\0\1", 8) == 0);
+
+    int w = 0, h = 0;
+    u8* decoded = _UT_DecodeQOI(out.base, out.curr, &w, &h);
+    UT_CHECK(decoded && w == width && h == height);
+    if (decoded) UT_CHECK(memcmp(decoded, rgba, (size_t)width * height * 4) == 0);
+
+    free(decoded);
+    free(rgba);
+    Arena::free(&out);
+}
+
+static void _UT_PNG()
+{
+    int width = 64, height = 33;
+    u8* rgba  = _UT_Image(width, height, 5);
+
+    Arena out = {};
+    UT_CHECK(FrameCapture_EncodePNG(&out, rgba, width, height));
+    int w = 0, h = 0, comp = 0;
+    u8* decoded = stbi_load_from_memory(out.base, (int)out.curr, &w, &h, &comp, 4);
+    UT_CHECK(decoded && w == width && h == height);
+    if (decoded) UT_CHECK(memcmp(decoded, rgba, (size_t)width * height * 4) == 0);
+
+    stbi_image_free(decoded);
+    free(rgba);
+    Arena::free(&out);
+}
+
+// decodes with stb_image: frames match the dithered palette colors, and noise
+// large enough to fill the LZW table (and clear it) several times round trips
+static void _UT_GIF()
+{
+    const int frame_count = 4;
+    int width = 211, height = 157;
+    f64 fps   = 30;
+
+    Arena out = {};
+    FrameCapture_GIFHeader(&out, width, height);
+    u8* frames[frame_count];
+    for (int i = 0; i < frame_count; i++) {
+        frames[i] = _UT_Image(width, height, 11 + i);
+        UT_CHECK(FrameCapture_EncodeGIFFrame(&out, frames[i], width, height,
+                                             FrameCapture_GIFDelay(i, fps)));
+    }
+    FrameCapture_GIFTrailer(&out);
+
+    int* delays = NULL;
+    int w = 0, h = 0, z = 0, comp = 0;
+    u8* decoded = stbi_load_gif_from_memory(out.base, (int)out.curr, &delays, &w, &h,
+                                            &z, &comp, 4);
+    UT_CHECK(decoded && w == width && h == height && z == frame_count);
+
+    int wrong_texels = 0;
+    for (int i = 0; decoded && i < MIN(z, frame_count); i++) {
+        UT_CHECK(delays[i] == FrameCapture_GIFDelay(i, fps) * 10);
+        const u8* frame = decoded + (size_t)i * width * height * 4;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                size_t t = ((size_t)y * width + x) * 4;
+                u8 rgb[3];
+                FrameCapture_GIFPaletteColor(FrameCapture_GIFIndex(frames[i] + t, x, y),
+                                             rgb);
+                if (memcmp(frame + t, rgb, 3) != 0 || frame[t + 3] != 255)
+                    ++wrong_texels;
+            }
+        }
+    }
+    UT_CHECK_MSG(wrong_texels == 0, "%d texels wrong", wrong_texels);
+
+    // dithering keeps flat colors between palette entries on average
+    u8 gray[4] = { 100, 100, 100, 255 };
+    int sum    = 0;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            u8 rgb[3];
+            FrameCapture_GIFPaletteColor(FrameCapture_GIFIndex(gray, x, y), rgb);
+            sum += rgb[0];
+        }
+    }
+    UT_CHECK(abs(sum / 16 - 100) <= 8);
+
+    // delays add up to the exact time
+    int total_cs = 0;
+    for (int i = 0; i < 30; i++) total_cs += FrameCapture_GIFDelay(i, fps);
+    UT_CHECK(total_cs == 100);
+
+    stbi_image_free(decoded);
+    free(delays);
+    for (int i = 0; i < frame_count; i++) free(frames[i]);
+    Arena::free(&out);
+}
+
+static bool _UT_FileExists(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file) fclose(file);
+    return file != NULL;
+}
+
+static void _UT_Sequence()
+{
+    FrameCaptureDesc desc = {};
+    FrameCapture_DescFromPath(&desc, "|ffmpeg -i -");
+    UT_CHECK(desc.output == FrameCaptureOutput_Pipe);
+    UT_CHECK(desc.format == FrameCaptureFormat_RAW);
+    UT_CHECK(strcmp(desc.path, "ffmpeg -i -") == 0);
+    FrameCapture_DescFromPath(&desc, "out/Loop.GIF");
+    UT_CHECK(desc.output == FrameCaptureOutput_File);
+    UT_CHECK(desc.format == FrameCaptureFormat_GIF);
+    FrameCapture_DescFromPath(&desc, "frame.qoi");
+    UT_CHECK(desc.output == FrameCaptureOutput_Sequence);
+    UT_CHECK(desc.format == FrameCaptureFormat_QOI);
+    FrameCapture_DescFromPath(&desc, "frame");
+    UT_CHECK(desc.format == FrameCaptureFormat_PNG);
+
+    // a %d pattern, and a plain path numbered before its extension
+    const char* paths[]    = { "ut_fc_%03d.qoi", "ut_fc.png", "ut_fc_%s.png" };
+    const char* expected[] = {
+        "ut_fc_002.qoi",
+        "ut_fc_00002.png",
+        "ut_fc_%s_00002.png",
+    };
+    int width = 8, height = 4;
+    u8* rgba  = _UT_Image(width, height, 1);
+    for (int i = 0; i < 3; i++) {
+        FrameCaptureDesc desc = {};
+        FrameCapture_DescFromPath(&desc, paths[i]);
+        desc.width        = width;
+        desc.height       = height;
+        desc.worker_count = 2;
+
+        FrameCapture capture = {};
+        UT_CHECK(FrameCapture_Begin(&capture, &desc));
+        for (int f = 0; f < 3; f++) FrameCapture_Submit(&capture, rgba, width * 4, f);
+        FrameCaptureStats stats = FrameCapture_End(&capture);
+        UT_CHECK(!FrameCapture_Active(&capture));
+        UT_CHECK(stats.submitted == 3 && stats.written == 3);
+
+        UT_CHECK_MSG(_UT_FileExists(expected[i]), "missing %s", expected[i]);
+        char path[64];
+        for (int f = 0; f < 3; f++) {
+            strcpy(path, expected[i]);
+            path[strlen(path) - 5] = (char)('0' + f);
+            remove(path);
+        }
+    }
+    free(rgba);
+}
+
+// the render thread's side: a ring of padded BGRA slots, never waiting on the
+// encoders. Frames must come out in order and complete
+static void _UT_Record(const char* output, bool pipe, int frame_count)
+{
+    const int slot_count = 4;
+    int width = 320, height = 180, stride = 320 * 4 + 64;
+    u8* slots[slot_count];
+    bool busy[slot_count] = {};
+    for (int i = 0; i < slot_count; i++) {
+        slots[i] = (u8*)malloc((size_t)stride * height);
+    }
+
+    FrameCaptureDesc desc = {};
+    desc.format           = FrameCaptureFormat_RAW;
+    desc.output           = pipe ? FrameCaptureOutput_Pipe : FrameCaptureOutput_File;
+    desc.path             = output;
+    desc.width            = width;
+    desc.height           = height;
+    desc.bgra             = true;
+    desc.opaque           = true;
+    desc.worker_count     = 3;
+    desc.max_queue_depth  = 6;
+
+    FrameCapture capture = {};
+    UT_CHECK(FrameCapture_Begin(&capture, &desc));
+
+    f64 worst_ms  = 0;
+    u64 submitted = 0;
+    for (int f = 0; f < frame_count; f++) {
+        // time spent in the capture calls, not filling the slot
+        auto begin = std::chrono::steady_clock::now();
+        f64 ms     = 0;
+        int released[slot_count];
+        int count = FrameCapture_Released(&capture, released, slot_count);
+        for (int i = 0; i < count; i++) {
+            UT_CHECK(busy[released[i]]);
+            busy[released[i]] = false;
+        }
+
+        int slot = -1;
+        for (int i = 0; i < slot_count && slot < 0; i++)
+            if (!busy[i]) slot = i;
+        if (slot < 0 || FrameCapture_Full(&capture)) {
+            FrameCapture_Drop(&capture);
+        } else {
+            auto fill = std::chrono::steady_clock::now();
+            ms += std::chrono::duration<f64, std::milli>(fill - begin).count();
+            // BGRA, blue is the submitted frame
+            for (int y = 0; y < height; y++) {
+                u8* row = slots[slot] + (size_t)y * stride;
+                for (int x = 0; x < width; x++) {
+                    u8 bgra[4] = { (u8)submitted, (u8)x, (u8)y, 7 };
+                    memcpy(row + x * 4, bgra, 4);
+                }
+            }
+            busy[slot] = true;
+            begin      = std::chrono::steady_clock::now();
+            FrameCapture_Submit(&capture, slots[slot], stride, slot);
+            ++submitted;
+        }
+        auto end = std::chrono::steady_clock::now();
+        ms += std::chrono::duration<f64, std::milli>(end - begin).count();
+        worst_ms = MAX(worst_ms, ms);
+
+        // the rest of the frame, while workers encode
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    FrameCaptureStats stats = FrameCapture_End(&capture);
+
+    UT_CHECK(stats.submitted == submitted);
+    UT_CHECK(stats.written == submitted && stats.failed == 0);
+    UT_CHECK(stats.queue_depth == 0);
+    UT_CHECK(stats.submitted + stats.dropped == (u64)frame_count);
+    UT_CHECK(stats.max_queue_depth <= desc.max_queue_depth);
+    UT_CHECK_MSG(worst_ms < 1000.0 / 60.0, "worst frame %fms", worst_ms);
+
+    FILE* file = fopen(pipe ? "ut_fc_pipe.rgba" : output, "rb");
+    UT_CHECK(file != NULL);
+    u64 frame_bytes = (u64)width * height * 4;
+    u8* frame       = (u8*)malloc(frame_bytes);
+    u64 read = 0, wrong_frames = 0;
+    while (file && fread(frame, 1, frame_bytes, file) == frame_bytes) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const u8* px = frame + ((size_t)y * width + x) * 4;
+                if (px[0] != (u8)y || px[1] != (u8)x || px[2] != (u8)read
+                    || px[3] != 255) {
+                    ++wrong_frames;
+                    y = height;
+                    break;
+                }
+            }
+        }
+        ++read;
+    }
+    UT_CHECK_MSG(read == submitted, "read %llu of %llu frames",
+                 (unsigned long long)read, (unsigned long long)submitted);
+    UT_CHECK(wrong_frames == 0);
+    if (file) fclose(file);
+    remove(pipe ? "ut_fc_pipe.rgba" : output);
+
+    free(frame);
+    for (int i = 0; i < slot_count; i++) free(slots[i]);
+}
+
+// the reading process exits early: writes fail, the capture keeps going
+static void _UT_BrokenPipe()
+{
+#ifndef _WIN32
+    FrameCaptureDesc desc = {};
+    FrameCapture_DescFromPath(&desc, "|exit 0");
+    desc.width  = 256;
+    desc.height = 256;
+
+    u8* rgba             = (u8*)calloc(256 * 256, 4);
+    FrameCapture capture = {};
+    UT_CHECK(FrameCapture_Begin(&capture, &desc));
+    // more than a pipe buffer, so a write must fail
+    for (int f = 0; f < 16; f++) {
+        int slot;
+        while (FrameCapture_Full(&capture)) FrameCapture_Released(&capture, &slot, 1);
+        FrameCapture_Submit(&capture, rgba, 256 * 4, 0);
+    }
+    FrameCaptureStats stats = FrameCapture_End(&capture);
+    UT_CHECK(stats.submitted == 16);
+    UT_CHECK(stats.failed > 0 && stats.written + stats.failed == 16);
+    UT_CHECK(stats.error != NULL);
+    free(rgba);
+#endif
+}
+
+void UT_FrameCapture()
+{
+    _UT_QOI();
+    _UT_PNG();
+    _UT_GIF();
+    _UT_Sequence();
+    _UT_Record("ut_fc_record.rgba", false, 300);
+#ifndef _WIN32
+    _UT_Record("cat > ut_fc_pipe.rgba", true, 120);
+#endif
+    _UT_BrokenPipe();
+}
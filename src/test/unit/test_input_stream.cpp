@@ -0,0 +1,182 @@
+#include "unit_test.h"
+
+#include "input_stream.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <thread>
+
+#define UT_SRATE 48000.0
+#define UT_MS 1000000ull // ns
+
+static InputEvent _UT_Event(InputEventType type, i32 code, u64 time_ns)
+{
+    InputEvent event = {};
+    event.type       = type;
+    event.code       = code;
+    event.time_ns    = time_ns;
+    return event;
+}
+
+static void _UT_Queue()
+{
+    InputQueue* q = new InputQueue();
+    InputEvent event;
+    UT_CHECK(!InputQueue_Pop(q, &event));
+
+    // nothing merged: two presses of the same key are two events
+    InputEvent press = _UT_Event(InputEvent_MouseDown, 0, 10);
+    UT_CHECK(InputQueue_Push(q, &press));
+    press.time_ns = 20;
+    UT_CHECK(InputQueue_Push(q, &press));
+    UT_CHECK(InputQueue_Pop(q, &event) && event.time_ns == 10);
+    UT_CHECK(InputQueue_Pop(q, &event) && event.time_ns == 20);
+    UT_CHECK(!InputQueue_Pop(q, &event));
+
+    // full: drops and counts instead of blocking the render thread
+    for (int i = 0; i < INPUT_QUEUE_CAPACITY + 5; i++) {
+        InputEvent e = _UT_Event(InputEvent_KeyDown, i, i);
+        InputQueue_Push(q, &e);
+    }
+    UT_CHECK(q->dropped.load() == 5);
+    int popped = 0;
+    while (InputQueue_Pop(q, &event)) {
+        UT_CHECK_MSG(event.code == popped, "%d != %d", event.code, popped);
+        popped++;
+    }
+    UT_CHECK(popped == INPUT_QUEUE_CAPACITY);
+
+    for (int t = InputEvent_None; t < InputEvent_Count; t++) {
+        UT_CHECK(strcmp(InputStream_TypeName((InputEventType)t), "unknown") != 0);
+    }
+    delete q;
+}
+
+// render thread pushing while the audio thread drains, in order and without loss
+static void _UT_QueueThreads()
+{
+    InputQueue* q         = new InputQueue();
+    InputHistory* history = new InputHistory();
+    const int count       = 100000;
+
+    std::thread producer([q] {
+        for (int i = 0; i < count; i++) {
+            InputEvent e = _UT_Event(InputEvent_MouseMove, i, InputStream_Now());
+            while (!InputQueue_Push(q, &e)) std::this_thread::yield();
+        }
+    });
+
+    u64 cursor = 0, missed = 0;
+    int received = 0;
+    u64 last_time = 0;
+    while (received < count) {
+        InputHistory_Drain(history, q);
+        InputEvent event;
+        while (InputHistory_Next(history, &cursor, &event, &missed)) {
+            UT_CHECK(event.code == received);
+            UT_CHECK(event.seq == (u64)received + 1);
+            UT_CHECK(event.time_ns >= last_time);
+            last_time = event.time_ns;
+            received++;
+        }
+    }
+    producer.join();
+    UT_CHECK(missed == 0);
+    delete q;
+    delete history;
+}
+
+// readers walk the history independently, and slow ones skip ahead
+static void _UT_History()
+{
+    InputHistory* history = new InputHistory();
+    InputEvent event;
+    u64 a = 0, b = 0, missed = 0;
+    UT_CHECK(!InputHistory_Next(history, &a, &event, &missed));
+
+    for (int i = 0; i < 3; i++) {
+        InputHistory_Append(history, _UT_Event(InputEvent_KeyDown, i, 0));
+    }
+    UT_CHECK(InputHistory_Next(history, &a, &event, &missed) && event.code == 0);
+    UT_CHECK(InputHistory_Next(history, &a, &event, &missed) && event.code == 1);
+    UT_CHECK(InputHistory_Next(history, &b, &event, &missed) && event.code == 0);
+
+    // a reader created now only sees what comes next
+    u64 c = history->count;
+    UT_CHECK(!InputHistory_Next(history, &c, &event, NULL));
+    InputHistory_Append(history, _UT_Event(InputEvent_KeyUp, 3, 0));
+    UT_CHECK(InputHistory_Next(history, &c, &event, NULL) && event.code == 3);
+    UT_CHECK(event.type == InputEvent_KeyUp && event.seq == 4);
+
+    // b fell behind by more than the history holds
+    for (int i = 4; i < INPUT_HISTORY_CAPACITY + 10; i++) {
+        InputHistory_Append(history, _UT_Event(InputEvent_KeyDown, i, 0));
+    }
+    UT_CHECK(InputHistory_Next(history, &b, &event, &missed));
+    UT_CHECK_MSG(missed == 9, "%llu", (unsigned long long)missed);
+    UT_CHECK(event.code == 10);
+    int rest = 1;
+    while (InputHistory_Next(history, &b, &event, &missed)) rest++;
+    UT_CHECK(rest == INPUT_HISTORY_CAPACITY);
+    UT_CHECK(event.code == INPUT_HISTORY_CAPACITY + 9);
+    delete history;
+}
+
+// chuck computing 256 sample blocks ahead of the wall clock, observed at random
+// points of each block
+static void _UT_Clock()
+{
+    InputClock clock = {};
+    UT_CHECK(InputClock_SampleAt(&clock, 123, UT_SRATE, 77.0) == 77.0);
+
+    const f64 block    = 256;
+    const u64 start_ns = 5000 * UT_MS;
+    const u64 block_ns = (u64)(block / UT_SRATE * 1e9);
+    // sample s plays at start_ns + s / srate. block k (samples [k*256, k*256+256))
+    // is computed in a burst 3 blocks before it plays
+    u32 rng = 1;
+    for (int k = 0; k < 400; k++) {
+        u64 burst_ns = start_ns + (k - 3) * block_ns;
+        for (int obs = 0; obs < 3; obs++) {
+            rng        = rng * 1664525u + 1013904223u;
+            f64 sample = k * block + (rng >> 8) % (u32)block;
+            u64 jitter = (rng >> 4) % 200000; // the VM runs up to .2ms late
+            InputClock_Observe(&clock, sample, UT_SRATE, burst_ns + jitter);
+        }
+    }
+    UT_CHECK(clock.valid);
+
+    // an event at wall time t maps onto the last sample computed by then, give or
+    // take the observation jitter: the same distance after the sample playing at
+    // t for every event, wherever in a block it lands
+    const f64 expect    = 4 * block - 1;              // furthest ahead chuck got
+    const f64 tolerance = 0.2e-3 * UT_SRATE + 2;      // observation jitter
+    for (int i = 0; i < 50; i++) {
+        u64 t       = start_ns + 300 * block_ns + i * 977 * 1000;
+        f64 playing = (f64)(t - start_ns) * UT_SRATE / 1e9;
+        f64 lead    = InputClock_SampleAt(&clock, t, UT_SRATE, 0) - playing;
+        UT_CHECK_MSG(fabs(lead - expect) <= tolerance, "lead %f", lead);
+    }
+
+    // chuck stalls and falls behind for good: the estimate follows within two
+    // windows
+    const u64 stall_ns = 100 * UT_MS;
+    u64 end_ns         = start_ns + 397 * block_ns;
+    for (int k = 400; k < 400 + 3000; k++) {
+        u64 burst_ns = start_ns + (k - 3) * block_ns + stall_ns;
+        InputClock_Observe(&clock, k * block, UT_SRATE, burst_ns);
+        end_ns = burst_ns;
+    }
+    f64 playing = (f64)(end_ns - stall_ns - start_ns) * UT_SRATE / 1e9;
+    f64 lead    = InputClock_SampleAt(&clock, end_ns, UT_SRATE, 0) - playing;
+    UT_CHECK_MSG(fabs(lead - 3 * block) < 2, "lead after stall %f", lead);
+}
+
+void UT_InputStream()
+{
+    _UT_Queue();
+    _UT_QueueThreads();
+    _UT_History();
+    _UT_Clock();
+}
@@ -0,0 +1,150 @@
+#include "unit_test.h"
+
+#include "instance_cull.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <string.h>
+#include <vector>
+
+#define UT_CULL_INSTANCES 1000
+
+// same layout as DrawUniforms: model matrix first, then per-instance data
+struct UT_Instance {
+    glm::mat4 model;
+    glm::mat4 normal;
+    i32 id;
+    i32 receives_shadow;
+    f32 _pad[2];
+};
+
+static bool _UT_Near(f32 a, f32 b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+// point is inside the clip volume of projection * view, computed straight from
+// clip coordinates. Independent of the plane extraction
+static bool _UT_PointInClip(glm::mat4 projection, glm::mat4 view, glm::vec3 p)
+{
+    glm::vec4 c = projection * view * glm::vec4(p, 1.0f);
+    return -c.w <= c.x && c.x <= c.w && -c.w <= c.y && c.y <= c.w && 0.0f <= c.z
+           && c.z <= c.w;
+}
+
+static void _UT_Spheres()
+{
+    glm::vec4 local
+      = InstanceCull_LocalSphere(glm::vec3(-1, -2, -2), glm::vec3(1, 2, 2));
+    UT_CHECK(_UT_Near(local.x, 0) && _UT_Near(local.y, 0) && _UT_Near(local.z, 0));
+    UT_CHECK_MSG(_UT_Near(local.w, 3), "radius %f", local.w);
+
+    // translated, the radius follows the largest axis scale
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(5, 0, -1));
+    model           = glm::scale(model, glm::vec3(1, 4, 2));
+    glm::vec4 world = InstanceCull_WorldSphere(model, glm::vec4(0, 1, 0, 0.5f));
+    UT_CHECK(_UT_Near(world.x, 5) && _UT_Near(world.y, 4) && _UT_Near(world.z, -1));
+    UT_CHECK_MSG(_UT_Near(world.w, 2), "radius %f", world.w);
+}
+
+static void _UT_Planes()
+{
+    glm::mat4 projection
+      = glm::perspectiveRH_ZO(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+    glm::mat4 view = glm::mat4(1.0f); // at the origin looking down -z
+    glm::vec4 planes[6];
+    InstanceCull_FrustumPlanes(projection, view, planes);
+
+    for (int i = 0; i < 6; i++) {
+        UT_CHECK_MSG(_UT_Near(glm::length(glm::vec3(planes[i])), 1.0f), "plane %d", i);
+    }
+
+    // near and far planes sit at z = -1 and z = -100, facing inward
+    glm::vec3 p(0, 0, -1);
+    UT_CHECK(_UT_Near(glm::dot(glm::vec3(planes[4]), p) + planes[4].w, 0));
+    // row3 - row2 cancels most of the far plane's precision
+    p = glm::vec3(0, 0, -100);
+    UT_CHECK(fabsf(glm::dot(glm::vec3(planes[5]), p) + planes[5].w) < 1e-2f);
+    p = glm::vec3(0, 0, -50);
+    for (int i = 0; i < 6; i++) {
+        f32 dist = glm::dot(glm::vec3(planes[i]), p) + planes[i].w;
+        UT_CHECK_MSG(dist > 0, "plane %d", i);
+    }
+
+    // a 90 degree fov puts the left plane through x = z
+    UT_CHECK(InstanceCull_SphereVisible(planes, glm::vec4(0, 0, -10, 0)));
+    UT_CHECK(!InstanceCull_SphereVisible(planes, glm::vec4(-12, 0, -10, 1)));
+    UT_CHECK(InstanceCull_SphereVisible(planes, glm::vec4(-12, 0, -10, 2)));
+    UT_CHECK(!InstanceCull_SphereVisible(planes, glm::vec4(0, 0, 5, 1)));    // behind
+    UT_CHECK(InstanceCull_SphereVisible(planes, glm::vec4(0, 0, -.5f, 1)));  // near
+    UT_CHECK(!InstanceCull_SphereVisible(planes, glm::vec4(0, 0, -102, 1))); // far
+    UT_CHECK(!InstanceCull_SphereVisible(planes, glm::vec4(0, 60, -50, 5)));
+}
+
+// instances at random points, drawn with a point sized sphere so visibility can be
+// checked in clip space
+static void _UT_Run(glm::mat4 projection, glm::mat4 view, u32 seed)
+{
+    UT_Rng rng = { seed };
+    std::vector<UT_Instance> instances(UT_CULL_INSTANCES);
+    for (int i = 0; i < UT_CULL_INSTANCES; i++) {
+        glm::vec3 pos(rng.range(-60, 60), rng.range(-60, 60), rng.range(-120, 20));
+        instances[i]       = {};
+        instances[i].model = glm::translate(glm::mat4(1.0f), pos);
+        instances[i].id    = i;
+    }
+
+    InstanceCullParams params = {};
+    params.sphere             = glm::vec4(0.0f);
+    params.instance_count     = UT_CULL_INSTANCES;
+    params.element_count      = 36;
+
+    std::vector<UT_Instance> visible(UT_CULL_INSTANCES);
+    u32 args[INSTANCE_CULL_ARGS_COUNT];
+    memset(args, 0xff, sizeof(args));
+    u32 count = InstanceCull_Run(&params, projection, view, instances.data(),
+                                 sizeof(UT_Instance), visible.data(), args);
+
+    // compacted in instance order, every visible one and nothing else
+    u32 expected  = 0;
+    bool in_order = true;
+    for (int i = 0; i < UT_CULL_INSTANCES; i++) {
+        glm::vec3 pos = glm::vec3(instances[i].model[3]);
+        if (!_UT_PointInClip(projection, view, pos)) continue;
+        if (expected >= count || visible[expected].id != i) in_order = false;
+        ++expected;
+    }
+    UT_CHECK_MSG(count == expected, "%u visible, expected %u", count, expected);
+    UT_CHECK(in_order);
+    UT_CHECK_MSG(count > 0 && count < UT_CULL_INSTANCES, "%u visible", count);
+    if (count > 0) {
+        UT_Instance* first = &instances[visible[0].id];
+        UT_CHECK(memcmp(&visible[0], first, sizeof(*first)) == 0);
+    }
+
+    UT_CHECK(args[0] == 36 && args[1] == count);
+    UT_CHECK(args[2] == 0 && args[3] == 0 && args[4] == 0);
+}
+
+static void _UT_RunEmpty()
+{
+    InstanceCullParams params = {};
+    params.element_count      = 6;
+    u32 args[INSTANCE_CULL_ARGS_COUNT];
+    memset(args, 0xff, sizeof(args));
+    u32 count = InstanceCull_Run(&params, glm::mat4(1.0f), glm::mat4(1.0f), NULL,
+                                 sizeof(UT_Instance), NULL, args);
+    UT_CHECK(count == 0 && args[0] == 6 && args[1] == 0);
+}
+
+void UT_InstanceCull()
+{
+    _UT_Spheres();
+    _UT_Planes();
+
+    glm::mat4 view = glm::lookAt(glm::vec3(3, 2, 10), glm::vec3(0, 0, -20),
+                                 glm::vec3(0, 1, 0));
+    _UT_Run(glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 80.0f),
+            view, 1);
+    _UT_Run(glm::orthoRH_ZO(-30.0f, 30.0f, -20.0f, 20.0f, 0.1f, 100.0f), view, 2);
+    _UT_RunEmpty();
+}
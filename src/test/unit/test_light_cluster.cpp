@@ -0,0 +1,182 @@
+#include "unit_test.h"
+
+#include "light_cluster.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <string.h>
+
+#define UT_LIGHT_COUNT 256
+
+static void _UT_RandomLights(UT_Rng* rng, LightClusterSphere* lights, int count,
+                             f32 z_far)
+{
+    for (int i = 0; i < count; i++) {
+        // mostly inside the view volume, some behind the camera or past far
+        lights[i].center = glm::vec3(rng->range(-z_far * .5f, z_far * .5f),
+                                     rng->range(-z_far * .3f, z_far * .3f),
+                                     rng->range(-z_far * 1.2f, z_far * .1f));
+        lights[i].radius = rng->range(.1f, z_far * .1f);
+    }
+
+    // a couple of directional lights
+    lights[3].radius  = -1.0f;
+    lights[17].radius = -1.0f;
+}
+
+// optimized binning must be identical to the brute force reference
+static void _UT_CompareWithBruteForce(LightClusterGrid* grid,
+                                      LightClusterSphere* lights, int count)
+{
+    Arena binned = {}, reference = {};
+    Arena::init(&binned, KILOBYTE);
+    Arena::init(&reference, KILOBYTE);
+
+    int binned_len    = LightCluster_Bin(grid, lights, count, &binned);
+    int reference_len = LightCluster_BinBruteForce(grid, lights, count, &reference);
+
+    UT_CHECK_MSG(binned_len == reference_len, "%d vs %d", binned_len, reference_len);
+    if (binned_len == reference_len) {
+        UT_CHECK(memcmp(binned.base, reference.base, binned_len * sizeof(u32)) == 0);
+    }
+
+    // header offsets are contiguous and point past the header
+    u32* header = (u32*)binned.base;
+    UT_CHECK(header[0] == LIGHT_CLUSTER_HEADER_COUNT);
+    for (int c = 0; c + 1 < LIGHT_CLUSTER_COUNT; c++) {
+        UT_CHECK(header[2 * (c + 1)] == header[2 * c] + header[2 * c + 1]);
+    }
+    u32 last = LIGHT_CLUSTER_COUNT - 1;
+    UT_CHECK(header[2 * last] + header[2 * last + 1] == (u32)binned_len);
+
+    Arena::free(&binned);
+    Arena::free(&reference);
+}
+
+static bool _UT_ClusterContains(u32* buffer, int cluster, u32 light_idx)
+{
+    u32 offset = buffer[2 * cluster];
+    u32 count  = buffer[2 * cluster + 1];
+    for (u32 i = 0; i < count; i++) {
+        if (buffer[offset + i] == light_idx) return true;
+    }
+    return false;
+}
+
+// every point lit by a light must find that light in its cluster, using the
+// same lookup the shader does
+static void _UT_PointsAreCovered(UT_Rng* rng, LightClusterGrid* grid, glm::mat4 proj,
+                                 LightClusterSphere* lights, int count)
+{
+    Arena binned = {};
+    Arena::init(&binned, KILOBYTE);
+    LightCluster_Bin(grid, lights, count, &binned);
+    u32* buffer = (u32*)binned.base;
+
+    int points_tested = 0;
+    for (int l = 0; l < count; l++) {
+        if (lights[l].radius < 0.0f) continue;
+        for (int s = 0; s < 32; s++) {
+            // random point inside the light sphere (slightly shrunk to stay
+            // clear of float error at the boundary)
+            glm::vec3 dir(rng->range(-1, 1), rng->range(-1, 1), rng->range(-1, 1));
+            if (glm::dot(dir, dir) > 1.0f || glm::dot(dir, dir) < EPSILON) continue;
+            glm::vec3 p = lights[l].center + dir * lights[l].radius * .999f;
+
+            // project to viewport
+            glm::vec4 clip = proj * glm::vec4(p, 1.0f);
+            if (clip.w <= 0.0f) continue;
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            f32 depth     = -p.z;
+            if (ndc.x < -1 || ndc.x > 1 || ndc.y < -1 || ndc.y > 1) continue;
+            if (depth < grid->z_near || depth > grid->z_far) continue;
+
+            f32 vx      = ndc.x * .5f + .5f;
+            f32 vy      = .5f - ndc.y * .5f; // y down
+            int cluster = LightCluster_Index(grid, vx, vy, depth);
+            UT_CHECK_MSG(_UT_ClusterContains(buffer, cluster, l),
+                         "light %d missing from cluster %d", l, cluster);
+            ++points_tested;
+        }
+    }
+    UT_CHECK(points_tested > 1000);
+
+    Arena::free(&binned);
+}
+
+static void _UT_SliceRoundTrip(LightClusterGrid* grid)
+{
+    for (int k = 0; k < LIGHT_CLUSTER_Z; k++) {
+        f32 lo  = LightCluster_SliceDepth(grid, k);
+        f32 hi  = LightCluster_SliceDepth(grid, k + 1);
+        f32 mid = (lo + hi) * .5f;
+        UT_CHECK_MSG(LightCluster_Slice(grid, mid) == k, "slice %d", k);
+        UT_CHECK(hi > lo);
+    }
+    UT_CHECK(LightCluster_Slice(grid, -1.0f) == 0);
+    UT_CHECK(LightCluster_Slice(grid, grid->z_far * 2) == LIGHT_CLUSTER_Z - 1);
+}
+
+void UT_LightCluster()
+{
+    UT_Rng rng = { 1234 };
+    static LightClusterGrid grid;
+    LightClusterSphere lights[UT_LIGHT_COUNT];
+
+    { // perspective, exponential slices
+        f32 z_near = .1f, z_far = 100.0f;
+        glm::mat4 proj = glm::perspective(PI / 4.0f, 16.0f / 9.0f, z_near, z_far);
+        LightCluster_BuildGrid(&grid, proj, z_near, z_far, true);
+        UT_CHECK(grid.log_slicing);
+
+        _UT_SliceRoundTrip(&grid);
+        for (int trial = 0; trial < 4; trial++) {
+            _UT_RandomLights(&rng, lights, UT_LIGHT_COUNT, z_far);
+            _UT_CompareWithBruteForce(&grid, lights, UT_LIGHT_COUNT);
+            _UT_PointsAreCovered(&rng, &grid, proj, lights, UT_LIGHT_COUNT);
+        }
+    }
+
+    { // orthographic, linear slices
+        f32 z_near = .1f, z_far = 50.0f;
+        glm::mat4 proj = glm::ortho(-8.0f, 8.0f, -4.5f, 4.5f, z_near, z_far);
+        LightCluster_BuildGrid(&grid, proj, z_near, z_far, false);
+        UT_CHECK(!grid.log_slicing);
+
+        _UT_SliceRoundTrip(&grid);
+        for (int trial = 0; trial < 4; trial++) {
+            _UT_RandomLights(&rng, lights, UT_LIGHT_COUNT, z_far);
+            for (int i = 0; i < UT_LIGHT_COUNT; i++) {
+                lights[i].center.x *= .3f; // keep inside the narrower ortho volume
+                lights[i].center.y *= .3f;
+            }
+            _UT_CompareWithBruteForce(&grid, lights, UT_LIGHT_COUNT);
+            _UT_PointsAreCovered(&rng, &grid, proj, lights, UT_LIGHT_COUNT);
+        }
+    }
+
+    { // directional lights are in every cluster, zero radius lights in none
+        f32 z_near = .1f, z_far = 100.0f;
+        glm::mat4 proj = glm::perspective(PI / 3.0f, 1.0f, z_near, z_far);
+        LightCluster_BuildGrid(&grid, proj, z_near, z_far, true);
+
+        LightClusterSphere dir_and_empty[2] = {
+            { glm::vec3(0.0f), -1.0f },          // directional
+            { glm::vec3(0.0f, 0.0f, -5.0f), 0 }, // zero radius, never binned
+        };
+        Arena binned = {};
+        Arena::init(&binned, KILOBYTE);
+
+        int len = LightCluster_Bin(&grid, dir_and_empty, 2, &binned);
+        UT_CHECK(len == LIGHT_CLUSTER_HEADER_COUNT + LIGHT_CLUSTER_COUNT);
+        for (int c = 0; c < LIGHT_CLUSTER_COUNT; c++) {
+            UT_CHECK(_UT_ClusterContains((u32*)binned.base, c, 0));
+            UT_CHECK(!_UT_ClusterContains((u32*)binned.base, c, 1));
+        }
+
+        Arena::clear(&binned);
+        len = LightCluster_Bin(&grid, NULL, 0, &binned);
+        UT_CHECK(len == LIGHT_CLUSTER_HEADER_COUNT);
+
+        Arena::free(&binned);
+    }
+}
@@ -0,0 +1,208 @@
+#include "unit_test.h"
+
+// debug calls below compile away, see _UT_CompileLevel
+#define LOG_COMPILE_LEVEL LOG_INFO
+#include "core/log.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::mutex ut_log_mutex;
+static std::vector<std::string> ut_log_messages;
+static std::vector<int> ut_log_levels;
+
+static void _UT_LogCallback(log_Event* ev)
+{
+    char buf[4096];
+    vsnprintf(buf, sizeof(buf), ev->fmt, ev->ap);
+    std::lock_guard<std::mutex> guard(ut_log_mutex);
+    ut_log_messages.push_back(buf);
+    ut_log_levels.push_back(ev->level);
+}
+
+static std::vector<std::string> _UT_TakeMessages()
+{
+    std::lock_guard<std::mutex> guard(ut_log_mutex);
+    std::vector<std::string> messages;
+    messages.swap(ut_log_messages);
+    ut_log_levels.clear();
+    return messages;
+}
+
+static std::string _UT_Expected(const char* fmt, ...)
+{
+    char buf[4096];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    return buf;
+}
+
+// every message written later on the background thread matches what printf
+// would have made of it right away
+#define UT_FORMAT(...)                                                                 \
+    do {                                                                               \
+        expected.push_back(_UT_Expected(__VA_ARGS__));                                 \
+        log_warn(__VA_ARGS__);                                                         \
+    } while (0)
+
+static void _UT_Format()
+{
+    std::vector<std::string> expected;
+    char scratch[64];
+    strcpy(scratch, "stack buffer");
+
+    int i = -42;
+    UT_FORMAT("plain");
+    UT_FORMAT("%d %i %u %x %X %o", i, 7, 3000000000u, 255, 255, 8);
+    UT_FORMAT("%5d|%-5d|%05d|%+d|% d", 12, 12, 12, 12, 12);
+    UT_FORMAT("%ld %lld %llu %zu", -5l, -123456789012ll, 18446744073709551615ull,
+              (size_t)99);
+    UT_FORMAT("%hhd %hu %hhx", (signed char)-3, (unsigned short)65535,
+              (unsigned char)200);
+    UT_FORMAT("%f %.2f %e %g %10.3f|%-8.1f|", 3.14159, 2.0 / 3.0, 1e-9, 0.5, -1.25,
+              6.0);
+    UT_FORMAT("%s %10s|%-4s|%.3s", "one", "two", "x", "truncate");
+    UT_FORMAT("%p %c%c 100%%", (void*)&expected, 'o', 'k');
+    UT_FORMAT("%.*s|%*d", 3, "abcdef", 6, 42); // formatted on the calling thread
+    UT_FORMAT("%s", scratch);
+
+    // strings past what a record holds
+    std::string long_str(3000, 'z');
+    UT_FORMAT("[%s]", long_str.c_str());
+    std::string mid(150, 'm');
+    UT_FORMAT("%s %s %s %s", mid.c_str(), mid.c_str(), mid.c_str(), mid.c_str());
+    // more arguments than a record holds
+    UT_FORMAT("%d %d %d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9,
+              10, 11, 12, 13, 14);
+
+    strcpy(scratch, "overwritten"); // the record has its own copy
+    log_flush();
+
+    std::vector<std::string> messages = _UT_TakeMessages();
+    UT_CHECK_MSG(messages.size() == expected.size(), "%zu != %zu", messages.size(),
+                 expected.size());
+    for (size_t m = 0; m < messages.size() && m < expected.size(); m++) {
+        UT_CHECK_MSG(messages[m] == expected[m], "\"%.200s\" != \"%.200s\"",
+                     messages[m].c_str(), expected[m].c_str());
+    }
+
+    log_warn("%s", (const char*)NULL);
+    log_flush();
+    messages = _UT_TakeMessages();
+    UT_CHECK(messages.size() == 1 && messages[0] == "(null)");
+}
+
+// each thread's messages in order, and nothing lost when the rings keep up
+static void _UT_Threads()
+{
+    const int threads = 4, count = 100;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < count; i++) {
+                log_warn("thread %d message %d", t, i);
+                // well under the ring capacity between two drains
+                if (i % 50 == 49)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    log_flush();
+
+    std::vector<std::string> messages = _UT_TakeMessages();
+    UT_CHECK_MSG(messages.size() == threads * count, "%zu", messages.size());
+    int next[threads] = {};
+    for (const std::string& m : messages) {
+        int t = -1, i = -1;
+        if (sscanf(m.c_str(), "thread %d message %d", &t, &i) != 2 || t < 0
+            || t >= threads) {
+            UT_CHECK_MSG(false, "%s", m.c_str());
+            continue;
+        }
+        UT_CHECK_MSG(i == next[t], "thread %d: %d, expected %d", t, i, next[t]);
+        next[t] = i + 1;
+    }
+}
+
+static std::mutex ut_log_gate;
+static void _UT_Gate(bool lock, void*)
+{
+    if (lock) ut_log_gate.lock();
+    else ut_log_gate.unlock();
+}
+
+// a stalled writer fills the ring: calls drop instead of waiting, and the drops
+// are counted and reported
+static void _UT_Drops()
+{
+    unsigned long long dropped_before = log_dropped();
+    const int extra                   = 10;
+    const int ring_capacity           = 256; // LOG_RING_CAPACITY
+
+    log_set_lock(_UT_Gate, NULL);
+    ut_log_gate.lock(); // the background thread blocks writing the first message
+    for (int i = 0; i < ring_capacity + extra; i++) log_warn("fill %d", i);
+    UT_CHECK_MSG(log_dropped() - dropped_before == extra, "%llu",
+                 log_dropped() - dropped_before);
+    ut_log_gate.unlock();
+    log_flush();
+    log_set_lock(NULL, NULL);
+
+    std::vector<std::string> messages = _UT_TakeMessages();
+    UT_CHECK_MSG(messages.size() == ring_capacity + 1, "%zu", messages.size());
+    if (!messages.empty()) {
+        UT_CHECK(messages.front() == "fill 0");
+        UT_CHECK(strstr(messages.back().c_str(), "10 log messages dropped") != NULL);
+    }
+}
+
+static void _UT_LevelsAndFatal()
+{
+    log_set_level(LOG_WARN);
+    log_info("below the runtime level, but the callback takes it");
+    log_debug("compiled out %d", 1);
+    log_error("error");
+    // fatal is written right away, after everything before it
+    log_fatal("fatal");
+    std::vector<std::string> messages = _UT_TakeMessages();
+    UT_CHECK(messages.size() == 3);
+    if (messages.size() == 3) {
+        UT_CHECK(messages[0] == "below the runtime level, but the callback takes it");
+        UT_CHECK(messages[1] == "error");
+        UT_CHECK(messages[2] == "fatal");
+    }
+    log_set_level(LOG_TRACE);
+}
+
+static void _UT_Sync()
+{
+    log_set_async(false);
+    log_warn("sync %d", 1);
+    std::vector<std::string> messages = _UT_TakeMessages(); // no flush needed
+    UT_CHECK(messages.size() == 1 && messages[0] == "sync 1");
+}
+
+void UT_Log()
+{
+    static bool added = false;
+    if (!added) log_add_callback(_UT_LogCallback, NULL, LOG_TRACE);
+    added = true;
+    log_set_quiet(true);
+    log_set_async(true);
+
+    _UT_Format();
+    _UT_Threads();
+    _UT_Drops();
+    _UT_LevelsAndFatal();
+    _UT_Sync();
+
+    log_set_quiet(false);
+}
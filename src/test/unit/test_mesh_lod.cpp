@@ -0,0 +1,286 @@
+#include "unit_test.h"
+
+#include "mesh_lod.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+struct UT_Mesh {
+    std::vector<f32> positions; // xyz
+    std::vector<u32> indices;
+
+    u32 vertexCount()
+    {
+        return (u32)positions.size() / 3;
+    }
+
+    const f32* pos(u32 v)
+    {
+        return positions.data() + v * 3;
+    }
+};
+
+// n x n quads in the xy plane, facing +z, sharing vertices
+static UT_Mesh _UT_Grid(int n)
+{
+    UT_Mesh mesh;
+    for (int y = 0; y <= n; y++) {
+        for (int x = 0; x <= n; x++) {
+            mesh.positions.push_back((f32)x / n);
+            mesh.positions.push_back((f32)y / n);
+            mesh.positions.push_back(0.0f);
+        }
+    }
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            u32 a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+            u32 quad[] = { a, b, d, a, d, c };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// unit sphere, subdivided octahedron sharing vertices (closed, no seams)
+static UT_Mesh _UT_Sphere(int subdivisions)
+{
+    UT_Mesh mesh;
+    f32 octa[] = { 1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1 };
+    mesh.positions.assign(octa, octa + 18);
+    u32 faces[] = { 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4,
+                    2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+    mesh.indices.assign(faces, faces + 24);
+
+    for (int s = 0; s < subdivisions; s++) {
+        std::vector<u32> next;
+        std::vector<u64> edge_keys;
+        std::vector<u32> edge_mids;
+        auto midpoint = [&](u32 a, u32 b) -> u32 {
+            u64 key = a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
+            for (size_t i = 0; i < edge_keys.size(); i++) {
+                if (edge_keys[i] == key) return edge_mids[i];
+            }
+            f32 m[3];
+            f32 len = 0;
+            for (int c = 0; c < 3; c++) {
+                m[c] = (mesh.positions[a * 3 + c] + mesh.positions[b * 3 + c]) * 0.5f;
+                len += m[c] * m[c];
+            }
+            len = sqrtf(len);
+            for (int c = 0; c < 3; c++) mesh.positions.push_back(m[c] / len);
+            edge_keys.push_back(key);
+            edge_mids.push_back(mesh.vertexCount() - 1);
+            return mesh.vertexCount() - 1;
+        };
+        for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+            u32 a = mesh.indices[t], b = mesh.indices[t + 1], c = mesh.indices[t + 2];
+            u32 ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            u32 tris[] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+            next.insert(next.end(), tris, tris + 12);
+        }
+        mesh.indices = next;
+    }
+    return mesh;
+}
+
+static f32 _UT_NormalZ(UT_Mesh* mesh, const u32* tri)
+{
+    const f32 *a = mesh->pos(tri[0]), *b = mesh->pos(tri[1]), *c = mesh->pos(tri[2]);
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+static void _UT_Select()
+{
+    f32 sizes[] = { 0.5f, 0.2f, 0.05f };
+    UT_CHECK(MeshLOD_Select(0.8f, sizes, 3, 0.01f) == 0);
+    UT_CHECK(MeshLOD_Select(0.3f, sizes, 3, 0.01f) == 1);
+    UT_CHECK(MeshLOD_Select(0.1f, sizes, 3, 0.01f) == 2);
+    UT_CHECK(MeshLOD_Select(0.02f, sizes, 3, 0.01f) == 3);
+    UT_CHECK(MeshLOD_Select(0.005f, sizes, 3, 0.01f) == -1);
+    UT_CHECK(MeshLOD_Select(0.005f, sizes, 3, 0.0f) == 3);
+    UT_CHECK(MeshLOD_Select(0.005f, sizes, 0, 0.0f) == 0);
+
+    // 90 degree fov: a unit sphere 10 away covers a tenth of the viewport height
+    UT_CHECK(fabsf(MeshLOD_ScreenSize(1, 10, true, PI_2, 0) - 0.1f) < 1e-5f);
+    UT_CHECK(MeshLOD_ScreenSize(1, 0.5f, true, PI_2, 0) == 1.0f); // inside
+    UT_CHECK(fabsf(MeshLOD_ScreenSize(1, 10, false, 0, 10) - 0.2f) < 1e-5f);
+}
+
+// a flat grid simplifies to the target with no error, keeping its outline
+static void _UT_FlatGrid()
+{
+    UT_Mesh mesh    = _UT_Grid(16);
+    u32 index_count = (u32)mesh.indices.size();
+    std::vector<u32> dst(index_count);
+
+    f32 error = -1;
+    u32 count = MeshLOD_SimplifyTriangles(dst.data(), mesh.indices.data(), index_count,
+                                          mesh.positions.data(), mesh.vertexCount(), 3,
+                                          index_count / 10, 0.01f, &error);
+    UT_CHECK_MSG(count <= index_count / 10, "%u of %u indices", count, index_count);
+    UT_CHECK(count > 0 && count % 3 == 0);
+    UT_CHECK(error >= 0 && error < 1e-4f);
+
+    // same area (no holes or folds), nothing flipped
+    f32 area = 0;
+    for (u32 i = 0; i < count; i += 3) {
+        f32 z = _UT_NormalZ(&mesh, dst.data() + i);
+        UT_CHECK(z > 0);
+        area += z * 0.5f;
+    }
+    UT_CHECK_MSG(fabsf(area - 1.0f) < 1e-4f, "area %f", area);
+
+    // corners are still there
+    u32 corners[] = { 0, 16, 17 * 16, 17 * 17 - 1 };
+    for (u32 corner : corners) {
+        bool found = false;
+        for (u32 i = 0; i < count; i++) found |= (dst[i] == corner);
+        UT_CHECK(found);
+    }
+}
+
+// curved surfaces stop at the error limit
+static void _UT_SphereErrorLimit()
+{
+    UT_Mesh mesh    = _UT_Sphere(4);
+    u32 index_count = (u32)mesh.indices.size();
+    std::vector<u32> dst(index_count);
+
+    u32 count = MeshLOD_SimplifyTriangles(dst.data(), mesh.indices.data(), index_count,
+                                          mesh.positions.data(), mesh.vertexCount(), 3,
+                                          0, 0.0f, NULL);
+    UT_CHECK(count == index_count);
+
+    f32 error = 0;
+    count     = MeshLOD_SimplifyTriangles(dst.data(), mesh.indices.data(), index_count,
+                                          mesh.positions.data(), mesh.vertexCount(), 3,
+                                          index_count / 4, 0.05f, &error);
+    UT_CHECK_MSG(count <= index_count / 4, "%u of %u indices", count, index_count);
+    UT_CHECK(error > 0 && error <= 0.05f);
+
+    // still closed: every directed edge has its twin
+    int open_edges = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 a = dst[i], b = dst[i - i % 3 + (i + 1) % 3];
+        bool twin = false;
+        for (u32 j = 0; j < count && !twin; j++) {
+            twin = dst[j] == b && dst[j - j % 3 + (j + 1) % 3] == a;
+        }
+        open_edges += !twin;
+    }
+    UT_CHECK_MSG(open_edges == 0, "%d open edges", open_edges);
+
+    // in place
+    std::vector<u32> in_place = mesh.indices;
+    UT_CHECK(MeshLOD_SimplifyTriangles(in_place.data(), in_place.data(), index_count,
+                                       mesh.positions.data(), mesh.vertexCount(), 3,
+                                       index_count / 4, 0.05f, NULL)
+             == count);
+    UT_CHECK(memcmp(in_place.data(), dst.data(), count * sizeof(u32)) == 0);
+}
+
+// vertices on a uv seam (same position, different vertex) never move
+static void _UT_SeamsLocked()
+{
+    UT_Mesh mesh = _UT_Grid(8);
+    u32 seam_vertex = 9 * 4 + 4; // middle of the grid
+    mesh.positions.push_back(mesh.pos(seam_vertex)[0]);
+    mesh.positions.push_back(mesh.pos(seam_vertex)[1]);
+    mesh.positions.push_back(mesh.pos(seam_vertex)[2]);
+    u32 twin = mesh.vertexCount() - 1;
+    // the triangles right of the seam use the twin
+    for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+        bool right = true;
+        for (int c = 0; c < 3; c++) right &= mesh.pos(mesh.indices[t + c])[0] >= 0.5f;
+        for (int c = 0; c < 3 && right; c++) {
+            if (mesh.indices[t + c] == seam_vertex) mesh.indices[t + c] = twin;
+        }
+    }
+
+    u32 index_count = (u32)mesh.indices.size();
+    std::vector<u32> dst(index_count);
+    u32 count = MeshLOD_SimplifyTriangles(dst.data(), mesh.indices.data(), index_count,
+                                          mesh.positions.data(), mesh.vertexCount(), 3,
+                                          12, 0.01f, NULL);
+    UT_CHECK(count < index_count);
+    bool has_seam = false, has_twin = false;
+    for (u32 i = 0; i < count; i++) {
+        has_seam |= dst[i] == seam_vertex;
+        has_twin |= dst[i] == twin;
+    }
+    UT_CHECK(has_seam && has_twin);
+}
+
+static void _UT_Points()
+{
+    UT_Rng rng = { 7 };
+    std::vector<f32> positions;
+    for (int i = 0; i < 3000; i++) positions.push_back(rng.range(-5, 5));
+    std::vector<u32> dst(1000);
+
+    u32 count = MeshLOD_SimplifyPoints(dst.data(), positions.data(), 1000, 3, 100);
+    UT_CHECK_MSG(count <= 100 && count > 25, "%u points", count);
+    for (u32 i = 1; i < count; i++) UT_CHECK(dst[i - 1] < dst[i]);
+
+    // same input, same output
+    std::vector<u32> again(1000);
+    UT_CHECK(MeshLOD_SimplifyPoints(again.data(), positions.data(), 1000, 3, 100)
+             == count);
+    UT_CHECK(memcmp(again.data(), dst.data(), count * sizeof(u32)) == 0);
+
+    UT_CHECK(MeshLOD_SimplifyPoints(dst.data(), positions.data(), 1000, 3, 5000)
+             == 1000);
+    UT_CHECK(MeshLOD_SimplifyPoints(dst.data(), positions.data(), 1000, 3, 1) == 1);
+}
+
+static void _UT_Compact()
+{
+    u32 indices[] = { 5, 2, 7, 7, 2, 9 };
+    u32 remap[10];
+    UT_CHECK(MeshLOD_Compact(remap, indices, 6, 10) == 4);
+    u32 expected[] = { 0, 1, 2, 2, 1, 3 };
+    UT_CHECK(memcmp(indices, expected, sizeof(expected)) == 0);
+    UT_CHECK(remap[5] == 0 && remap[9] == 3 && remap[0] == UINT32_MAX);
+}
+
+// user index lists can reference missing vertices or end mid-triangle
+static void _UT_Sanitize()
+{
+    u32 indices[] = { 0, 1, 2, 3, 9, 4, 4, 5, 6, 7, 8 };
+    u32 dst[11];
+    UT_CHECK(MeshLOD_SanitizeTriangles(dst, indices, 11, 9) == 6);
+    u32 expected[] = { 0, 1, 2, 4, 5, 6 };
+    UT_CHECK(memcmp(dst, expected, sizeof(expected)) == 0);
+
+    // in place
+    UT_CHECK(MeshLOD_SanitizeTriangles(indices, indices, 11, 9) == 6);
+    UT_CHECK(memcmp(indices, expected, sizeof(expected)) == 0);
+
+    UT_CHECK(MeshLOD_SanitizeTriangles(dst, indices, 2, 9) == 0);
+    UT_CHECK(MeshLOD_SanitizeTriangles(dst, indices, 6, 0) == 0);
+
+    // simplify drops the same triangles instead of reading past the vertices
+    UT_Mesh mesh = _UT_Grid(8);
+    u32 vertex_count = mesh.vertexCount();
+    u32 bad[]        = { 0, vertex_count, 1, 2, 3, vertex_count + 1000, 7 };
+    mesh.indices.insert(mesh.indices.end(), bad, bad + 7);
+    u32 index_count = (u32)mesh.indices.size();
+    std::vector<u32> out(index_count);
+    u32 count = MeshLOD_SimplifyTriangles(out.data(), mesh.indices.data(), index_count,
+                                          mesh.positions.data(), vertex_count, 3,
+                                          index_count / 4, 0.01f, NULL);
+    UT_CHECK(count > 0 && count % 3 == 0);
+    for (u32 i = 0; i < count; i++) UT_CHECK(out[i] < vertex_count);
+}
+
+void UT_MeshLOD()
+{
+    _UT_Sanitize();
+    _UT_Select();
+    _UT_FlatGrid();
+    _UT_SphereErrorLimit();
+    _UT_SeamsLocked();
+    _UT_Points();
+    _UT_Compact();
+}
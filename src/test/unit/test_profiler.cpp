@@ -0,0 +1,314 @@
+#include "unit_test.h"
+
+#include "profiler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#define UT_MS 1000000ull // ns
+
+static bool _UT_Near(f64 a, f64 b)
+{
+    return fabs(a - b) < 1e-6;
+}
+
+// off and on again, so every stat starts at zero
+static ProfileStats _UT_Reset()
+{
+    Profiler_Enable(false);
+    Profiler_Enable(true);
+    ProfileStats stats;
+    Profiler_Stats(&stats);
+    return stats;
+}
+
+static void _UT_Zones()
+{
+    ProfileStats stats = _UT_Reset();
+    UT_CHECK(stats.enabled);
+    UT_CHECK(stats.zones[ProfileZone_SceneUpdate].max_ms == 0);
+
+    // 3 calls of 2ms
+    u64 t = Profiler_Now();
+    for (int i = 0; i < 3; i++) {
+        Profiler_Record(ProfileZone_SceneUpdate, t, t + 2 * UT_MS);
+    }
+    Profiler_Record(ProfileZone_CommandPush, t, t + UT_MS);
+    Profiler_EndFrame(ProfileThread_Render);
+    Profiler_Stats(&stats);
+    ProfileTiming* scene = &stats.zones[ProfileZone_SceneUpdate];
+    UT_CHECK(_UT_Near(scene->last_ms, 6.0));
+    UT_CHECK(_UT_Near(scene->avg_ms, 6.0));
+    UT_CHECK(scene->calls == 3);
+    UT_CHECK(stats.frames[ProfileThread_Render] == 1);
+    // audio zones wait for the audio thread's frame
+    UT_CHECK(stats.zones[ProfileZone_CommandPush].calls == 0);
+
+    Profiler_EndFrame(ProfileThread_Audio);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.zones[ProfileZone_CommandPush].calls == 1);
+    UT_CHECK(_UT_Near(stats.zones[ProfileZone_CommandPush].last_ms, 1.0));
+
+    // an idle frame decays the average, keeps the max
+    Profiler_EndFrame(ProfileThread_Render);
+    Profiler_Stats(&stats);
+    UT_CHECK(scene->last_ms == 0 && scene->calls == 0);
+    UT_CHECK(scene->avg_ms > 0 && scene->avg_ms < 6.0);
+    UT_CHECK(_UT_Near(scene->max_ms, 6.0));
+    UT_CHECK(stats.frame[ProfileThread_Render].avg_ms >= 0);
+    UT_CHECK(_UT_Near(Profiler_AvgMs(&stats, "scene_update"), scene->avg_ms));
+    UT_CHECK(Profiler_AvgMs(&stats, "render_frame") >= 0);
+    UT_CHECK(Profiler_AvgMs(&stats, "no_such_zone") == -1);
+
+    for (int i = 0; i < ProfileZone_Count; i++) {
+        UT_CHECK(strcmp(Profiler_ZoneName((ProfileZone)i), "unknown") != 0);
+    }
+    UT_CHECK(Profiler_ZoneThread(ProfileZone_CommandPush) == ProfileThread_Audio);
+    UT_CHECK(Profiler_ZoneThread(ProfileZone_Execute) == ProfileThread_Render);
+}
+
+static void _UT_Scope()
+{
+    ProfileStats stats = _UT_Reset();
+    {
+        PROFILE_ZONE(ProfileZone_Execute);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    Profiler_EndFrame(ProfileThread_Render);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.zones[ProfileZone_Execute].calls == 1);
+    UT_CHECK_MSG(stats.zones[ProfileZone_Execute].last_ms >= 1.9, "%f ms",
+                 stats.zones[ProfileZone_Execute].last_ms);
+
+    // off, zones record nothing
+    Profiler_Enable(false);
+    {
+        PROFILE_ZONE(ProfileZone_Execute);
+    }
+    Profiler_Enable(true);
+    Profiler_EndFrame(ProfileThread_Render);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.zones[ProfileZone_Execute].calls == 0);
+}
+
+// both threads, and a worker, recording at once
+static void _UT_Threads()
+{
+    ProfileStats stats = _UT_Reset();
+    const int frames = 50, calls = 200;
+    auto run         = [&](ProfileThread thread, ProfileZone zone) {
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < calls; i++) {
+                PROFILE_ZONE(zone);
+            }
+            Profiler_EndFrame(thread);
+        }
+    };
+    std::thread audio(run, ProfileThread_Audio, ProfileZone_CommandPush);
+    std::thread render(run, ProfileThread_Render, ProfileZone_QueueDrain);
+    std::thread worker([&] {
+        for (int i = 0; i < calls; i++) {
+            PROFILE_ZONE(ProfileZone_DrawBuild);
+        }
+    });
+    audio.join();
+    render.join();
+    worker.join();
+
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.frames[ProfileThread_Audio] == frames);
+    UT_CHECK(stats.frames[ProfileThread_Render] == frames);
+    UT_CHECK(stats.zones[ProfileZone_CommandPush].calls == calls);
+    UT_CHECK(stats.zones[ProfileZone_QueueDrain].calls == calls);
+}
+
+static void _UT_Gpu()
+{
+    ProfileStats stats = _UT_Reset();
+    char names[3][PROFILER_NAME_SIZE] = { "shadow", "scene", "bloom" };
+    f64 ms[3]                         = { 0.5, 2.0, 0.25 };
+    Profiler_GpuPasses(names, ms, 3);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.gpu_pass_count == 3);
+    UT_CHECK(_UT_Near(stats.gpu_total.last_ms, 2.75));
+    UT_CHECK(_UT_Near(Profiler_AvgMs(&stats, "scene"), 2.0));
+    UT_CHECK(_UT_Near(Profiler_AvgMs(&stats, "gpu"), 2.75));
+
+    // passes are matched by name, new ones appended
+    strcpy(names[0], "scene");
+    strcpy(names[1], "ui");
+    Profiler_GpuPasses(names, ms, 2);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.gpu_pass_count == 4);
+    UT_CHECK(_UT_Near(stats.gpu_passes[1].timing.last_ms, 0.5));
+    UT_CHECK(strcmp(stats.gpu_passes[3].name, "ui") == 0);
+    UT_CHECK(_UT_Near(stats.gpu_passes[3].timing.last_ms, 2.0));
+
+    // more passes than fit are left out, but still count to the total
+    char many[PROFILER_MAX_GPU_PASSES + 4][PROFILER_NAME_SIZE];
+    f64 many_ms[PROFILER_MAX_GPU_PASSES + 4];
+    for (int i = 0; i < PROFILER_MAX_GPU_PASSES + 4; i++) {
+        snprintf(many[i], PROFILER_NAME_SIZE, "pass %d", i);
+        many_ms[i] = 1.0;
+    }
+    Profiler_GpuPasses(many, many_ms, PROFILER_MAX_GPU_PASSES + 4);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.gpu_pass_count == PROFILER_MAX_GPU_PASSES);
+    UT_CHECK(_UT_Near(stats.gpu_total.last_ms, PROFILER_MAX_GPU_PASSES + 4));
+}
+
+static void _UT_Counters()
+{
+    ProfileStats stats = _UT_Reset();
+    ProfileCounter counters[2] = { { "shadow_casters", 12, 340 },
+                                   { "pipelines_pending", 3, 3 } };
+    Profiler_Counters(counters, 2);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.counter_count == 2);
+    UT_CHECK(Profiler_Count(&stats, "shadow_casters") == 12);
+    UT_CHECK(Profiler_Count(&stats, "shadow_casters_total") == 340);
+    UT_CHECK(Profiler_Count(&stats, "pipelines_pending_total") == 3);
+    UT_CHECK(Profiler_Count(&stats, "shadow") == -1);
+    UT_CHECK(Profiler_Count(&stats, "_total") == -1);
+
+    char buf[4096];
+    Profiler_FormatStats(&stats, buf, sizeof(buf));
+    UT_CHECK(strstr(buf, "shadow_casters") && strstr(buf, "340"));
+
+    // each frame replaces the last, more than fit are left out
+    ProfileCounter many[PROFILER_MAX_COUNTERS + 4] = {};
+    for (int i = 0; i < PROFILER_MAX_COUNTERS + 4; i++) {
+        snprintf(many[i].name, PROFILER_NAME_SIZE, "count %d", i);
+        many[i].frame = i;
+    }
+    Profiler_Counters(many, PROFILER_MAX_COUNTERS + 4);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.counter_count == PROFILER_MAX_COUNTERS);
+    UT_CHECK(Profiler_Count(&stats, "shadow_casters") == -1);
+    UT_CHECK(Profiler_Count(&stats, "count 1") == 1);
+
+    // nothing is kept while off, and turning it on clears them
+    Profiler_Enable(false);
+    Profiler_Counters(counters, 2);
+    Profiler_Enable(true);
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.counter_count == 0);
+}
+
+static void _UT_Report()
+{
+    ProfileStats stats = _UT_Reset();
+    u64 t              = Profiler_Now();
+    Profiler_Record(ProfileZone_Physics, t, t + UT_MS);
+    Profiler_EndFrame(ProfileThread_Render);
+    Profiler_Stats(&stats);
+
+    char buf[4096];
+    int len = Profiler_FormatStats(&stats, buf, sizeof(buf));
+    UT_CHECK(len == (int)strlen(buf));
+    for (int i = 0; i < ProfileZone_Count; i++) {
+        UT_CHECK_MSG(strstr(buf, Profiler_ZoneName((ProfileZone)i)), "%s",
+                     Profiler_ZoneName((ProfileZone)i));
+    }
+    UT_CHECK(strstr(buf, "render_frame") && strstr(buf, "audio_frame"));
+
+    // truncated, never past the buffer
+    char small[32];
+    memset(small, 'x', sizeof(small));
+    len = Profiler_FormatStats(&stats, small, 16);
+    UT_CHECK(len == 15 && small[15] == '\0' && small[16] == 'x');
+
+    stats.enabled = false;
+    Profiler_FormatStats(&stats, buf, sizeof(buf));
+    UT_CHECK(strstr(buf, "off") != NULL);
+}
+
+static char* _UT_ReadFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = (char*)calloc(size + 1, 1);
+    fread(data, 1, size, file);
+    fclose(file);
+    return data;
+}
+
+static int _UT_Count(const char* str, const char* sub)
+{
+    int count = 0;
+    for (const char* p = strstr(str, sub); p; p = strstr(p + 1, sub)) ++count;
+    return count;
+}
+
+static void _UT_Trace()
+{
+    const char* path = "ut_profiler_trace.json";
+    ProfileStats stats = _UT_Reset();
+
+    Profiler_TraceBegin(path, 8);
+    u64 t = Profiler_Now();
+    for (int i = 0; i < 10; i++) {
+        Profiler_Record(ProfileZone_DrawBuild, t + i * UT_MS, t + (i + 1) * UT_MS);
+    }
+    Profiler_Stats(&stats);
+    UT_CHECK(stats.tracing);
+    UT_CHECK(stats.trace_events == 8 && stats.trace_dropped == 2);
+    UT_CHECK(Profiler_TraceEnd());
+    UT_CHECK(!Profiler_TraceEnd()); // nothing to end
+
+    char* json = _UT_ReadFile(path);
+    UT_CHECK(json != NULL);
+    if (json) {
+        UT_CHECK(_UT_Count(json, "\"ph\":\"X\"") == 8);
+        UT_CHECK(_UT_Count(json, "\"name\":\"draw_build\"") == 8);
+        UT_CHECK(_UT_Count(json, "thread_name") == ProfileThread_Count + 1);
+        UT_CHECK(_UT_Count(json, "{") == _UT_Count(json, "}"));
+        UT_CHECK(strncmp(json, "{\"displayTimeUnit\"", 18) == 0);
+        free(json);
+    }
+
+    // a second trace reuses the buffer, GPU passes go in as counters, names escaped
+    Profiler_TraceBegin(path, 8);
+    char names[1][PROFILER_NAME_SIZE] = { "say \"hi\"" };
+    f64 ms[1]                         = { 1.5 };
+    Profiler_GpuPasses(names, ms, 1);
+    {
+        PROFILE_ZONE(ProfileZone_Present);
+    }
+    UT_CHECK(Profiler_TraceEnd());
+    json = _UT_ReadFile(path);
+    UT_CHECK(json != NULL);
+    if (json) {
+        UT_CHECK(_UT_Count(json, "\"ph\":\"X\"") == 1);
+        UT_CHECK(_UT_Count(json, "\"ph\":\"C\"") == 1);
+        UT_CHECK(strstr(json, "\"name\":\"say \\\"hi\\\"\"") != NULL);
+        UT_CHECK(strstr(json, "\"ms\":1.5000") != NULL);
+        free(json);
+    }
+    remove(path);
+
+    // unwritable path
+    Profiler_TraceBegin("no_such_dir/trace.json", 8);
+    UT_CHECK(!Profiler_TraceEnd());
+}
+
+void UT_Profiler()
+{
+    _UT_Zones();
+    _UT_Scope();
+    _UT_Threads();
+    _UT_Gpu();
+    _UT_Counters();
+    _UT_Report();
+    _UT_Trace();
+    Profiler_Enable(false);
+    Profiler_Shutdown();
+}
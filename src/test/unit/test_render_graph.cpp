@@ -0,0 +1,254 @@
+#include "unit_test.h"
+
+#include "render_graph.h"
+
+// arbitrary keys for synthetic resources
+#define UT_SWAPCHAIN 1000
+#define UT_USER_TEXTURE 1001
+
+static G_GraphTransientDesc _UT_Desc(u32 width, u32 height, u32 format)
+{
+    G_GraphTransientDesc desc = {};
+    desc.width                = width;
+    desc.height               = height;
+    desc.format               = format;
+    desc.sample_count         = 1;
+    desc.usage                = 0x10;
+    desc.bytes_per_sample     = 4;
+    return desc;
+}
+
+// scene --> tonemap --> swapchain, plus a pass whose output nobody reads
+static void _UT_CullUnreadOutputs(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc desc = _UT_Desc(640, 480, 1);
+
+    int hdr       = graph->transientResource(1, &desc);
+    int depth     = graph->transientResource(2, &desc);
+    int unused    = graph->transientResource(3, &desc);
+    int swapchain = graph->persistentResource(UT_SWAPCHAIN);
+
+    int scene = graph->addPass(false);
+    graph->write(scene, hdr);
+    graph->write(scene, depth);
+
+    int orphan = graph->addPass(false);
+    graph->read(orphan, hdr);
+    graph->write(orphan, unused);
+
+    int tonemap = graph->addPass(false);
+    graph->read(tonemap, hdr);
+    graph->write(tonemap, swapchain);
+
+    graph->compile();
+
+    UT_CHECK(!graph->passes[scene].culled);
+    UT_CHECK(graph->passes[orphan].culled);
+    UT_CHECK(!graph->passes[tonemap].culled);
+    UT_CHECK(graph->passes[tonemap].dep_count == 1);
+    UT_CHECK(graph->passes[tonemap].deps[0] == scene);
+
+    // only used by a culled pass, never allocated
+    UT_CHECK(graph->resources[unused].first_pass == -1);
+    UT_CHECK(graph->resources[unused].physical_idx == -1);
+
+    UT_CHECK(graph->stats.passes == 3);
+    UT_CHECK(graph->stats.passes_culled == 1);
+    UT_CHECK(graph->stats.transient_textures == 2);
+}
+
+// a chain of passes only feeding each other is culled as a whole
+static void _UT_CullChain(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc desc = _UT_Desc(256, 256, 1);
+
+    int a = graph->transientResource(1, &desc);
+    int b = graph->transientResource(2, &desc);
+    int c = graph->transientResource(3, &desc);
+
+    int p0 = graph->addPass(false);
+    graph->write(p0, a);
+    int p1 = graph->addPass(false);
+    graph->read(p1, a);
+    graph->write(p1, b);
+    int p2 = graph->addPass(false);
+    graph->read(p2, b);
+    graph->write(p2, c);
+
+    graph->compile();
+    UT_CHECK(graph->passes[p0].culled);
+    UT_CHECK(graph->passes[p1].culled);
+    UT_CHECK(graph->passes[p2].culled);
+    UT_CHECK(graph->stats.transient_textures == 0);
+    UT_CHECK(graph->stats.physical_bytes == 0);
+
+    // a side effect at the end keeps the whole chain alive
+    int p3 = graph->addPass(true);
+    graph->read(p3, c);
+
+    graph->compile();
+    UT_CHECK(!graph->passes[p0].culled);
+    UT_CHECK(!graph->passes[p1].culled);
+    UT_CHECK(!graph->passes[p2].culled);
+    UT_CHECK(!graph->passes[p3].culled);
+    UT_CHECK(graph->stats.passes_culled == 0);
+}
+
+// a pass that loads (reads) its own target depends on the previous writer,
+// and only the last writer before a read is a dependency
+static void _UT_LoadDependsOnPreviousWriter(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc desc = _UT_Desc(128, 128, 1);
+
+    int target  = graph->transientResource(1, &desc);
+    int texture = graph->persistentResource(UT_USER_TEXTURE);
+
+    int clear = graph->addPass(false);
+    graph->write(clear, target);
+
+    int overwrite = graph->addPass(false);
+    graph->write(overwrite, target);
+
+    int load = graph->addPass(false);
+    graph->read(load, target);
+    graph->write(load, target);
+
+    int copy = graph->addPass(false);
+    graph->read(copy, target);
+    graph->write(copy, texture);
+
+    graph->compile();
+
+    // first clear is overwritten before anyone reads it
+    UT_CHECK(graph->passes[clear].culled);
+    UT_CHECK(!graph->passes[overwrite].culled);
+    UT_CHECK(!graph->passes[load].culled);
+    UT_CHECK(!graph->passes[copy].culled);
+    UT_CHECK(graph->passes[load].dep_count == 1);
+    UT_CHECK(graph->passes[load].deps[0] == overwrite);
+    UT_CHECK(graph->passes[copy].dep_count == 1);
+    UT_CHECK(graph->passes[copy].deps[0] == load);
+    UT_CHECK(graph->resources[target].first_pass == overwrite);
+    UT_CHECK(graph->resources[target].last_pass == copy);
+}
+
+// ping-pong blur: 4 transients with the same desc, each only live for 2 passes
+static void _UT_AliasDisjointLifetimes(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc desc = _UT_Desc(512, 512, 1);
+
+    int swapchain = graph->persistentResource(UT_SWAPCHAIN);
+    int t[4];
+    for (int i = 0; i < 4; i++) t[i] = graph->transientResource(i + 1, &desc);
+
+    int p0 = graph->addPass(false);
+    graph->write(p0, t[0]);
+    for (int i = 1; i < 4; i++) {
+        int p = graph->addPass(false);
+        graph->read(p, t[i - 1]);
+        graph->write(p, t[i]);
+    }
+    int present = graph->addPass(false);
+    graph->read(present, t[3]);
+    graph->write(present, swapchain);
+
+    graph->compile();
+
+    // t0 [0,1], t1 [1,2], t2 [2,3], t3 [3,4]: neighbours overlap, so 2 textures
+    UT_CHECK(graph->stats.transient_textures == 4);
+    UT_CHECK(graph->stats.physical_textures == 2);
+    G_GraphResource* r = graph->resources;
+    UT_CHECK(r[t[0]].physical_idx == r[t[2]].physical_idx);
+    UT_CHECK(r[t[1]].physical_idx == r[t[3]].physical_idx);
+    UT_CHECK(r[t[0]].physical_idx != r[t[1]].physical_idx);
+
+    u64 size = G_GraphTransientDesc::sizeBytes(&desc);
+    UT_CHECK(size == 512 * 512 * 4);
+    UT_CHECK(graph->stats.transient_bytes == 4 * size);
+    UT_CHECK(graph->stats.physical_bytes == 2 * size);
+}
+
+// transients are never aliased if their descs differ, or lifetimes overlap
+static void _UT_NoAliasWhenIncompatible(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc small = _UT_Desc(64, 64, 1);
+    G_GraphTransientDesc large = _UT_Desc(128, 128, 1);
+    G_GraphTransientDesc msaa  = _UT_Desc(64, 64, 1);
+    msaa.sample_count          = 4;
+
+    int a = graph->transientResource(1, &small);
+    int b = graph->transientResource(2, &large);
+    int c = graph->transientResource(3, &msaa);
+    int d = graph->transientResource(4, &small);
+
+    // a, b, c have disjoint lifetimes but different descs
+    int p0 = graph->addPass(true);
+    graph->write(p0, a);
+    int p1 = graph->addPass(true);
+    graph->write(p1, b);
+    int p2 = graph->addPass(true);
+    graph->write(p2, c);
+
+    // d has the same desc as a, but a is still alive
+    int p3 = graph->addPass(true);
+    graph->write(p3, d);
+    graph->read(p3, a);
+
+    graph->compile();
+
+    int pa = graph->resources[a].physical_idx;
+    int pb = graph->resources[b].physical_idx;
+    int pc = graph->resources[c].physical_idx;
+    int pd = graph->resources[d].physical_idx;
+    UT_CHECK(pa != pb && pa != pc && pb != pc);
+    UT_CHECK(pd != pa);
+    UT_CHECK(graph->stats.physical_textures == 4);
+    UT_CHECK(graph->stats.physical_bytes == graph->stats.transient_bytes);
+}
+
+// the same key always maps to the same resource, and running out of space
+// conservatively keeps passes alive
+static void _UT_Limits(G_GraphCompiler* graph)
+{
+    graph->reset();
+    G_GraphTransientDesc desc = _UT_Desc(16, 16, 1);
+
+    int a = graph->transientResource(7, &desc);
+    UT_CHECK(graph->transientResource(7, &desc) == a);
+    UT_CHECK(graph->persistentResource(UT_SWAPCHAIN) != a);
+
+    int p = graph->addPass(false);
+    graph->write(p, -1); // resource allocation failed
+    UT_CHECK(graph->passes[p].side_effect);
+
+    int q = graph->addPass(false);
+    for (int i = 0; i < G_GRAPH_MAX_PASS_READS + 1; i++) {
+        graph->read(q, graph->transientResource(100 + i, &desc));
+    }
+    UT_CHECK(graph->passes[q].side_effect);
+
+    graph->compile();
+    UT_CHECK(!graph->passes[p].culled);
+    UT_CHECK(!graph->passes[q].culled);
+
+    graph->reset();
+    for (int i = 0; i < G_GRAPH_MAX_PASSES; i++) UT_CHECK(graph->addPass(false) == i);
+    UT_CHECK(graph->addPass(false) == -1);
+}
+
+void UT_RenderGraph()
+{
+    static G_GraphCompiler graph;
+
+    _UT_CullUnreadOutputs(&graph);
+    _UT_CullChain(&graph);
+    _UT_LoadDependsOnPreviousWriter(&graph);
+    _UT_AliasDisjointLifetimes(&graph);
+    _UT_NoAliasWhenIncompatible(&graph);
+    _UT_Limits(&graph);
+}
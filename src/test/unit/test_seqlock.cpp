@@ -0,0 +1,118 @@
+#include "unit_test.h"
+
+#include "core/macros.h"
+#include "core/seqlock.h"
+
+#include <atomic>
+#include <thread>
+
+// every field equal to the publish count, so a torn read shows up as a mismatch
+struct UT_SeqlockData {
+    u64 a;
+    float b[5];
+    bool keys[37];
+    i32 c;
+};
+
+static void _UT_SeqlockFill(UT_SeqlockData* data, u64 n)
+{
+    data->a = n;
+    for (int i = 0; i < 5; i++) data->b[i] = (float)(n % 1000000);
+    for (int i = 0; i < 37; i++) data->keys[i] = (n & 1) != 0;
+    data->c = (i32)n;
+}
+
+static bool _UT_SeqlockConsistent(const UT_SeqlockData* data)
+{
+    u64 n = data->a;
+    for (int i = 0; i < 5; i++)
+        if (data->b[i] != (float)(n % 1000000)) return false;
+    for (int i = 0; i < 37; i++)
+        if (data->keys[i] != ((n & 1) != 0)) return false;
+    return data->c == (i32)n;
+}
+
+static void _UT_SeqlockBasic()
+{
+    seqlock<UT_SeqlockData>* lock = new seqlock<UT_SeqlockData>();
+    UT_SeqlockData data;
+    seqlock<UT_SeqlockData>::read(lock, &data);
+    UT_CHECK(data.a == 0 && data.c == 0 && !data.keys[36]);
+
+    u64 version = seqlock<UT_SeqlockData>::current_version(lock);
+    _UT_SeqlockFill(&data, 7);
+    seqlock<UT_SeqlockData>::write(lock, &data);
+    UT_CHECK(seqlock<UT_SeqlockData>::current_version(lock) == version + 1);
+
+    // fields, including ones that straddle a word
+    float b[5];
+    seqlock_read_field(lock, UT_SeqlockData, b, b);
+    UT_CHECK(b[0] == 7.0f && b[4] == 7.0f);
+    bool key = false;
+    seqlock_read_field(lock, UT_SeqlockData, keys[36], &key);
+    UT_CHECK(key);
+    i32 c = 0;
+    seqlock_read_field(lock, UT_SeqlockData, c, &c);
+    UT_CHECK(c == 7);
+
+    // initial value
+    seqlock<UT_SeqlockData>* init = new seqlock<UT_SeqlockData>(data);
+    UT_SeqlockData copy;
+    seqlock<UT_SeqlockData>::read(init, &copy);
+    UT_CHECK(copy.a == 7 && _UT_SeqlockConsistent(&copy));
+
+    delete init;
+    delete lock;
+}
+
+// one writer publishing as fast as it can while readers copy the whole struct and
+// single fields. Every read must see a single publish, and never go back in time
+static void _UT_SeqlockThreads()
+{
+    const u64 PUBLISHES = 200000;
+    const int READERS   = 3;
+
+    seqlock<UT_SeqlockData>* lock = new seqlock<UT_SeqlockData>();
+    std::atomic<bool> done        = { false };
+    std::atomic<int> torn         = { 0 };
+    std::atomic<int> backwards    = { 0 };
+
+    std::thread readers[READERS];
+    for (int r = 0; r < READERS; r++) {
+        readers[r] = std::thread([&]() {
+            u64 last = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                UT_SeqlockData data;
+                seqlock<UT_SeqlockData>::read(lock, &data);
+                if (!_UT_SeqlockConsistent(&data)) torn++;
+                if (data.a < last) backwards++;
+                last = data.a;
+
+                i32 c = 0;
+                seqlock_read_field(lock, UT_SeqlockData, c, &c);
+                if ((u64)c < last) backwards++;
+            }
+        });
+    }
+
+    UT_SeqlockData data;
+    for (u64 n = 1; n <= PUBLISHES; n++) {
+        _UT_SeqlockFill(&data, n);
+        seqlock<UT_SeqlockData>::write(lock, &data);
+    }
+    done = true;
+    for (int r = 0; r < READERS; r++) readers[r].join();
+
+    UT_CHECK_MSG(torn.load() == 0, "%d torn reads", torn.load());
+    UT_CHECK_MSG(backwards.load() == 0, "%d reads went back", backwards.load());
+    seqlock<UT_SeqlockData>::read(lock, &data);
+    UT_CHECK(data.a == PUBLISHES);
+
+    delete lock;
+}
+
+void UT_Seqlock()
+{
+    _UT_SeqlockBasic();
+    _UT_SeqlockThreads();
+}
@@ -0,0 +1,351 @@
+#include "unit_test.h"
+
+#include "shader_reflect.h"
+
+#include <string.h>
+#include <string>
+
+#include "shaders.h"
+
+static ShaderReflection ut_refl;
+
+static ShaderReflection* _UT_Reflect(const char* wgsl, bool vertex = true,
+                                     bool fragment = true)
+{
+    ShaderReflect_Init(&ut_refl);
+    if (vertex)
+        ShaderReflect_AddEntryPoint(&ut_refl, wgsl, SHADER_STAGE_VERTEX, "vs_main");
+    if (fragment)
+        ShaderReflect_AddEntryPoint(&ut_refl, wgsl, SHADER_STAGE_FRAGMENT, "fs_main");
+    return &ut_refl;
+}
+
+static ShaderValueType _UT_Type(ShaderScalar scalar, u8 rows, u8 cols = 1)
+{
+    return { scalar, rows, cols };
+}
+
+// a binding used only in one stage is only visible to that stage, and an unused
+// binding is not part of the layout at all
+static void _UT_Visibility()
+{
+    const char* wgsl = R"(
+        struct FrameUniforms { view : mat4x4f, time : f32 }
+        @group(0) @binding(0) var<uniform> u_frame : FrameUniforms;
+        @group(1) @binding(0) var<uniform> u_color : vec4f;
+        @group(1) @binding(1) var<uniform> u_unused : f32;
+        @group(2) @binding(0) var<storage> u_draw : array<mat4x4f>;
+
+        fn transform(p : vec3f, id : u32) -> vec4f {
+            return u_frame.view * u_draw[id] * vec4f(p, 1.0);
+        }
+
+        @vertex
+        fn vs_main(@location(0) position : vec3f,
+                   @builtin(instance_index) id : u32) -> @builtin(position) vec4f {
+            return transform(position, id);
+        }
+
+        @fragment
+        fn fs_main() -> @location(0) vec4f {
+            return u_color * u_frame.time;
+        }
+    )";
+
+    ShaderReflection* refl = _UT_Reflect(wgsl);
+    UT_CHECK_MSG(refl->ok, "%s", refl->error);
+    UT_CHECK(refl->stages == (SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT));
+    UT_CHECK(refl->binding_count == 3);
+    UT_CHECK(refl->group_count == 3);
+
+    ShaderBinding* frame = ShaderReflect_FindBinding(refl, 0, 0);
+    UT_CHECK(frame && frame->kind == SHADER_BINDING_UNIFORM_BUFFER);
+    UT_CHECK(frame
+             && frame->visibility == (SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT));
+    UT_CHECK(frame && strcmp(frame->name, "u_frame") == 0);
+    UT_CHECK(frame && frame->type.scalar == SHADER_SCALAR_NONE);
+
+    ShaderBinding* color = ShaderReflect_FindBinding(refl, 1, 0);
+    UT_CHECK(color && color->visibility == SHADER_STAGE_FRAGMENT);
+    UT_CHECK(color && color->type.scalar == SHADER_SCALAR_F32 && color->type.rows == 4);
+
+    UT_CHECK(ShaderReflect_FindBinding(refl, 1, 1) == NULL);
+
+    ShaderBinding* draw = ShaderReflect_FindBinding(refl, 2, 0);
+    UT_CHECK(draw && draw->kind == SHADER_BINDING_READ_ONLY_STORAGE_BUFFER);
+    UT_CHECK(draw && draw->visibility == SHADER_STAGE_VERTEX);
+
+    int first = -1;
+    UT_CHECK(ShaderReflect_GroupBindings(refl, 1, &first) == 1);
+    UT_CHECK(first == 1);
+    UT_CHECK(ShaderReflect_GroupBindings(refl, 3, &first) == 0);
+
+    UT_CHECK(refl->vertex_input_count == 1);
+    ShaderVertexInput* pos = ShaderReflect_FindVertexInput(refl, 0);
+    UT_CHECK(pos && pos->type.scalar == SHADER_SCALAR_F32 && pos->type.rows == 3);
+    UT_CHECK(pos && strcmp(pos->name, "position") == 0);
+}
+
+// f32 textures are float only if something samples them with a sampler,
+// directly or through a function parameter
+static void _UT_TextureSampleTypes()
+{
+    const char* wgsl = R"(
+        @group(1) @binding(0) var s : sampler;
+        @group(1) @binding(1) var sampled : texture_2d<f32>;
+        @group(1) @binding(2) var loaded : texture_2d<f32>;
+        @group(1) @binding(3) var via_helper : texture_cube<f32>;
+        @group(1) @binding(4) var ints : texture_2d<u32>;
+        @group(1) @binding(5) var shadow : texture_depth_2d;
+        @group(1) @binding(6) var shadow_sampler : sampler_comparison;
+        @group(1) @binding(7) var msaa : texture_multisampled_2d<f32>;
+
+        fn sample_cube(t : texture_cube<f32>, dir : vec3f) -> vec4f {
+            return textureSampleLevel(t, s, dir, 0.0);
+        }
+        fn helper(dir : vec3f, t : texture_cube<f32>) -> vec4f {
+            return sample_cube(t, dir);
+        }
+
+        @fragment
+        fn fs_main(@builtin(position) p : vec4f) -> @location(0) vec4f {
+            let a = textureSample(sampled, s, p.xy);
+            let b = textureLoad(loaded, vec2i(p.xy), 0);
+            let c = helper(p.xyz, via_helper);
+            let d = vec4f(textureLoad(ints, vec2i(0), 0));
+            let e = textureSampleCompare(shadow, shadow_sampler, p.xy, 0.5);
+            let f = textureLoad(msaa, vec2i(0), 0);
+            return a + b + c + d + f * e;
+        }
+    )";
+
+    ShaderReflection* refl = _UT_Reflect(wgsl, false, true);
+    UT_CHECK_MSG(refl->ok, "%s", refl->error);
+    UT_CHECK(refl->binding_count == 8);
+
+    ShaderBinding* b = refl->bindings;
+    UT_CHECK(b[0].kind == SHADER_BINDING_SAMPLER);
+    UT_CHECK(b[1].sample_type == SHADER_SAMPLE_FLOAT);
+    UT_CHECK(b[2].sample_type == SHADER_SAMPLE_UNFILTERABLE_FLOAT);
+    UT_CHECK(b[3].sample_type == SHADER_SAMPLE_FLOAT);
+    UT_CHECK(b[3].view_dim == SHADER_TEXTURE_DIM_CUBE);
+    UT_CHECK(b[4].sample_type == SHADER_SAMPLE_UINT);
+    UT_CHECK(b[5].sample_type == SHADER_SAMPLE_DEPTH);
+    UT_CHECK(b[6].kind == SHADER_BINDING_COMPARISON_SAMPLER);
+    UT_CHECK(b[7].multisampled && b[7].view_dim == SHADER_TEXTURE_DIM_2D);
+    UT_CHECK(b[7].sample_type == SHADER_SAMPLE_UNFILTERABLE_FLOAT);
+}
+
+static void _UT_Compute()
+{
+    const char* wgsl = R"(
+        const WORKGROUP_X = 16u;
+        /* nested /* block */ comments */
+        @group(0) @binding(0) var src : texture_2d<f32>;
+        @group(0) @binding(1) var dst : texture_storage_2d<rgba16float, write>;
+        @group(0) @binding(2) var<storage, read_write> counters : array<atomic<u32>>;
+        @group(0) @binding(3) var<uniform> params : vec4i;
+
+        @compute @workgroup_size(WORKGROUP_X, 4)
+        fn main(@builtin(global_invocation_id) id : vec3u) {
+            let c = textureLoad(src, id.xy, 0);
+            textureStore(dst, id.xy, c * f32(params.x));
+            atomicAdd(&counters[0], 1u);
+        }
+    )";
+
+    ShaderReflection refl = {};
+    ShaderReflect_Init(&refl);
+    UT_CHECK(ShaderReflect_AddEntryPoint(&refl, wgsl, SHADER_STAGE_COMPUTE, "main"));
+    UT_CHECK_MSG(refl.ok, "%s", refl.error);
+    UT_CHECK(refl.workgroup_size[0] == 16);
+    UT_CHECK(refl.workgroup_size[1] == 4);
+    UT_CHECK(refl.workgroup_size[2] == 1);
+    UT_CHECK(refl.binding_count == 4);
+
+    ShaderBinding* dst = ShaderReflect_FindBinding(&refl, 0, 1);
+    UT_CHECK(dst && dst->kind == SHADER_BINDING_STORAGE_TEXTURE);
+    UT_CHECK(dst && dst->access == SHADER_ACCESS_WRITE);
+    UT_CHECK(dst && strcmp(dst->storage_format, "rgba16float") == 0);
+    UT_CHECK(dst && dst->visibility == SHADER_STAGE_COMPUTE);
+
+    ShaderBinding* counters = ShaderReflect_FindBinding(&refl, 0, 2);
+    UT_CHECK(counters && counters->kind == SHADER_BINDING_STORAGE_BUFFER);
+
+    ShaderBinding* params = ShaderReflect_FindBinding(&refl, 0, 3);
+    UT_CHECK(params
+             && ShaderReflect_Compatible(params, SHADER_BINDING_UNIFORM_BUFFER,
+                                         _UT_Type(SHADER_SCALAR_I32, 4)));
+    UT_CHECK(params
+             && !ShaderReflect_Compatible(params, SHADER_BINDING_UNIFORM_BUFFER,
+                                          _UT_Type(SHADER_SCALAR_F32, 4)));
+    UT_CHECK(params
+             && !ShaderReflect_Compatible(params, SHADER_BINDING_UNIFORM_BUFFER,
+                                          _UT_Type(SHADER_SCALAR_I32, 2)));
+}
+
+// vertex inputs through a struct, and vs/fs from different modules
+static void _UT_SeparateModules()
+{
+    const char* vertex = R"(
+        struct VertexInput {
+            @location(0) position : vec3f,
+            @location(1) normal : vec3<f32>,
+            @location(2) uv : vec2f,
+            @builtin(instance_index) instance : u32,
+        };
+        struct VertexOutput {
+            @builtin(position) position : vec4f,
+            @location(0) uv : vec2f
+        };
+        @group(0) @binding(0) var<uniform> u_proj : mat4x4f;
+
+        @vertex
+        fn vs_main(in : VertexInput) -> VertexOutput {
+            var out : VertexOutput;
+            out.position = u_proj * vec4f(in.position, 1.0);
+            out.uv = in.uv;
+            return out;
+        }
+    )";
+    const char* fragment = R"(
+        @group(0) @binding(0) var<uniform> u_proj : mat4x4f;
+        @group(1) @binding(0) var<uniform> u_tint : vec3f;
+
+        @fragment
+        fn fs_main(@location(0) uv : vec2f) -> @location(0) vec4f {
+            return vec4f(u_tint * uv.x, (u_proj * vec4f(0.0)).x);
+        }
+    )";
+
+    ShaderReflection refl = {};
+    ShaderReflect_Init(&refl);
+    ShaderReflect_AddEntryPoint(&refl, vertex, SHADER_STAGE_VERTEX, "vs_main");
+    ShaderReflect_AddEntryPoint(&refl, fragment, SHADER_STAGE_FRAGMENT, "fs_main");
+    UT_CHECK_MSG(refl.ok, "%s", refl.error);
+    UT_CHECK(refl.vertex_input_count == 3);
+    UT_CHECK(refl.vertex_inputs[2].location == 2);
+    UT_CHECK(refl.vertex_inputs[2].type.rows == 2);
+    UT_CHECK(strcmp(refl.vertex_inputs[1].name, "normal") == 0);
+
+    ShaderBinding* proj = ShaderReflect_FindBinding(&refl, 0, 0);
+    UT_CHECK(proj && proj->visibility == (SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT));
+    UT_CHECK(proj && proj->type.cols == 4 && proj->type.rows == 4);
+
+    char name[32] = {};
+    if (proj) ShaderReflect_ValueTypeName(proj->type, name, sizeof(name));
+    UT_CHECK(strcmp(name, "mat4x4f") == 0);
+    ShaderReflect_ValueTypeName(_UT_Type(SHADER_SCALAR_I32, 1), name, sizeof(name));
+    UT_CHECK(strcmp(name, "i32") == 0);
+}
+
+// unsupported or inconsistent source fails instead of producing a wrong layout
+static void _UT_Failures()
+{
+    ShaderReflection* refl = _UT_Reflect(R"(
+        @group(0) @binding(0) var t : texture_external;
+        @fragment fn fs_main() -> @location(0) vec4f {
+            return textureLoad(t, vec2u(0));
+        }
+    )", false, true);
+    UT_CHECK(!refl->ok);
+    UT_CHECK(strstr(refl->error, "texture_external") != NULL);
+
+    // unbalanced braces
+    refl = _UT_Reflect("@fragment fn fs_main() -> @location(0) vec4f { return vec4f();",
+                       false, true);
+    UT_CHECK(!refl->ok);
+
+    refl = _UT_Reflect("@fragment fn fs_main() -> @location(0) f32 { return 1.0; }");
+    UT_CHECK(!refl->ok); // no vs_main
+    UT_CHECK(strstr(refl->error, "vs_main") != NULL);
+
+    // same binding, different kinds in vs and fs
+    ShaderReflection conflict = {};
+    ShaderReflect_Init(&conflict);
+    ShaderReflect_AddEntryPoint(&conflict, R"(
+        @group(1) @binding(0) var<uniform> u : vec4f;
+        @vertex fn vs_main() -> @builtin(position) vec4f { return u; }
+    )", SHADER_STAGE_VERTEX, "vs_main");
+    ShaderReflect_AddEntryPoint(&conflict, R"(
+        @group(1) @binding(0) var t : texture_2d<f32>;
+        @fragment fn fs_main() -> @location(0) vec4f {
+            return textureLoad(t, vec2i(0), 0);
+        }
+    )", SHADER_STAGE_FRAGMENT, "fs_main");
+    UT_CHECK(!conflict.ok);
+
+    // groups beyond the limit
+    refl = _UT_Reflect(R"(
+        @group(4) @binding(0) var<uniform> u : f32;
+        @fragment fn fs_main() -> @location(0) vec4f { return vec4f(u); }
+    )", false, true);
+    UT_CHECK(!refl->ok);
+}
+
+// every builtin shader must reflect, otherwise it silently falls back to auto
+// layouts
+static void _UT_BuiltinShaders()
+{
+    const char* corpus[] = {
+        uv_shader_string,
+        wireframe_shader_string,
+        normal_shader_string,
+        flat_shader_string,
+        phong_shader_string,
+        lines2d_shader_string,
+        points_shader_string,
+        pbr_shader_string,
+        mipMapShader,
+        gtext_shader_string,
+        default_postprocess_shader_string,
+        output_pass_shader_string,
+        bloom_downsample_screen_shader,
+        bloom_downsample_shader_string,
+        bloom_upsample_screen_shader,
+        bloom_upsample_shader_string,
+        skybox_shader_string,
+        b2_solid_polygon_shader_string,
+        shadow_vertex_string,
+    };
+
+    for (size_t i = 0; i < ARRAY_LENGTH(corpus); i++) {
+        std::string source = Shaders_genSource(corpus[i]);
+        const char* src    = source.c_str();
+
+        ShaderReflection refl = {};
+        ShaderReflect_Init(&refl);
+        if (strstr(src, "fn vs_main"))
+            ShaderReflect_AddEntryPoint(&refl, src, SHADER_STAGE_VERTEX, "vs_main");
+        if (strstr(src, "fn fs_main"))
+            ShaderReflect_AddEntryPoint(&refl, src, SHADER_STAGE_FRAGMENT, "fs_main");
+        if (strstr(src, "@compute"))
+            ShaderReflect_AddEntryPoint(&refl, src, SHADER_STAGE_COMPUTE, "main");
+        if (corpus[i] == shadow_vertex_string)
+            ShaderReflect_AddEntryPoint(&refl, src, SHADER_STAGE_VERTEX, "main");
+
+        char msg[160] = {};
+        snprintf(msg, sizeof(msg), "builtin shader %d: %s", (int)i, refl.error);
+        UT_CHECK_MSG(refl.ok && refl.stages != 0, "%s", msg);
+        UT_CHECK(refl.group_count <= SHADER_REFLECT_MAX_GROUPS);
+        if (refl.stages & SHADER_STAGE_COMPUTE) UT_CHECK(refl.workgroup_size[0] == 8);
+    }
+
+    // material shaders share the frame uniforms at @group(0) @binding(0)
+    std::string phong = Shaders_genSource(phong_shader_string);
+    ShaderReflection* refl = _UT_Reflect(phong.c_str());
+    ShaderBinding* frame   = ShaderReflect_FindBinding(refl, 0, 0);
+    UT_CHECK(frame && strcmp(frame->name, "u_frame") == 0);
+    UT_CHECK(frame
+             && frame->visibility == (SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT));
+}
+
+void UT_ShaderReflect()
+{
+    _UT_Visibility();
+    _UT_TextureSampleTypes();
+    _UT_Compute();
+    _UT_SeparateModules();
+    _UT_Failures();
+    _UT_BuiltinShaders();
+}
@@ -0,0 +1,363 @@
+#include "unit_test.h"
+
+#include "core/memory.h"
+#include "texture_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#define UT_TEXTURE_COUNT 100
+#define UT_BYTES_PER_TEXEL 4
+
+// fake image source: "<width> <height>" as a file path or the same string as
+// memory. Anything else fails to decode
+static u8 _UT_Texel(u32 id, u32 layer, int x, int y)
+{
+    return (u8)(id * 31 + layer * 17 + x * 7 + y * 13);
+}
+
+static bool _UT_Decode(TextureStreamJob* job)
+{
+    char source[64] = {};
+    if (job->filepath) {
+        strncpy(source, job->filepath, sizeof(source) - 1);
+    } else {
+        memcpy(source, job->data, MIN(job->data_len, (int)sizeof(source) - 1));
+    }
+
+    int width = 0, height = 0;
+    if (sscanf(source, "%d %d", &width, &height) != 2 || width <= 0 || height <= 0) {
+        job->error = "bad source";
+        return false;
+    }
+
+    job->width         = width;
+    job->height        = height;
+    job->bytes_per_row = width * UT_BYTES_PER_TEXEL;
+    job->pixels        = (u8*)malloc((size_t)job->bytes_per_row * height);
+    for (int y = 0; y < height; y++) {
+        int src_y = job->flip_y ? height - 1 - y : y;
+        u8* row   = job->pixels + (size_t)y * job->bytes_per_row;
+        for (int x = 0; x < width; x++) {
+            u8 texel = _UT_Texel(job->id, job->layer, x, src_y);
+            memset(row + x * UT_BYTES_PER_TEXEL, texel, UT_BYTES_PER_TEXEL);
+        }
+    }
+    return true;
+}
+
+static void _UT_FreePixels(u8* pixels)
+{
+    free(pixels);
+}
+
+// stands in for the GPU textures
+struct UT_Texture {
+    int width, height;
+    bool flip_y;
+    bool bad;
+    u8* texels;
+    int done;
+    bool ok;
+};
+
+struct UT_Upload {
+    UT_Texture textures[UT_TEXTURE_COUNT];
+    u64 frame_bytes;
+    int wrong_rows;
+    int early_done; // done before every row was uploaded
+};
+
+static void _UT_UploadRows(TextureStreamJob* job, int row, int row_count, void* udata)
+{
+    UT_Upload* up   = (UT_Upload*)udata;
+    UT_Texture* tex = up->textures + job->id;
+    if (job->width != tex->width || row < 0 || row + row_count > tex->height) {
+        ++up->wrong_rows;
+        return;
+    }
+    size_t offset = (size_t)row * job->bytes_per_row;
+    memcpy(tex->texels + offset, job->pixels + offset,
+           (size_t)row_count * job->bytes_per_row);
+    up->frame_bytes += (u64)row_count * job->bytes_per_row;
+}
+
+static void _UT_Done(TextureStreamJob* job, void* udata)
+{
+    UT_Upload* up   = (UT_Upload*)udata;
+    UT_Texture* tex = up->textures + job->id;
+    ++tex->done;
+    tex->ok = job->ok;
+    if (job->ok && job->level != job->level_count) ++up->early_done;
+    if (!job->ok) UT_CHECK(job->error != NULL);
+}
+
+static void _UT_Submit(TextureStream* stream, UT_Upload* up, UT_Rng* rng)
+{
+    for (u32 id = 0; id < UT_TEXTURE_COUNT; id++) {
+        UT_Texture* tex = up->textures + id;
+        tex->width      = 16 + (int)rng->range(0, 496);
+        tex->height     = 16 + (int)rng->range(0, 496);
+        tex->flip_y     = (id % 3) == 0;
+        tex->bad        = (id % 17) == 5;
+        tex->texels = (u8*)calloc((size_t)tex->width * tex->height, UT_BYTES_PER_TEXEL);
+
+        char source[64];
+        if (tex->bad) {
+            snprintf(source, sizeof(source), "not an image");
+        } else {
+            snprintf(source, sizeof(source), "%d %d", tex->width, tex->height);
+        }
+        if (id % 2) {
+            TextureStream_SubmitFile(stream, id, 0, source, tex->flip_y);
+        } else {
+            TextureStream_SubmitMemory(stream, id, 0, (u8*)source, (int)strlen(source),
+                                       tex->flip_y);
+        }
+    }
+    UT_CHECK(TextureStream_Pending(stream) == UT_TEXTURE_COUNT);
+}
+
+static void _UT_CheckTextures(UT_Upload* up)
+{
+    int wrong_texels = 0, wrong_done = 0;
+    for (u32 id = 0; id < UT_TEXTURE_COUNT; id++) {
+        UT_Texture* tex = up->textures + id;
+        if (tex->done != 1 || tex->ok == tex->bad) ++wrong_done;
+        if (tex->bad) continue;
+        for (int y = 0; y < tex->height; y++) {
+            int src_y = tex->flip_y ? tex->height - 1 - y : y;
+            for (int x = 0; x < tex->width; x++) {
+                size_t i = ((size_t)y * tex->width + x) * UT_BYTES_PER_TEXEL;
+                if (tex->texels[i] != _UT_Texel(id, 0, x, src_y)) ++wrong_texels;
+            }
+        }
+    }
+    UT_CHECK_MSG(wrong_done == 0, "%d textures done wrongly", wrong_done);
+    UT_CHECK_MSG(wrong_texels == 0, "%d texels wrong", wrong_texels);
+    UT_CHECK(up->wrong_rows == 0);
+    UT_CHECK(up->early_done == 0);
+}
+
+static void _UT_FreeTextures(UT_Upload* up)
+{
+    for (int i = 0; i < UT_TEXTURE_COUNT; i++) free(up->textures[i].texels);
+}
+
+// loads 100 textures while "rendering": no frame may upload more than the budget
+// (or a single row), or spend longer than a 60fps frame uploading
+static void _UT_Budget(int worker_count)
+{
+    TextureStream stream = {};
+    TextureStream_Init(&stream, worker_count, _UT_Decode, _UT_FreePixels);
+
+    UT_Upload* up = (UT_Upload*)calloc(1, sizeof(UT_Upload));
+    UT_Rng rng    = { 41u + worker_count };
+    _UT_Submit(&stream, up, &rng);
+
+    const u64 budget   = 256 * 1024;
+    const f64 frame_ms = 1000.0 / 60.0;
+    int frames = 0, max_frames = 100000;
+    f64 worst_ms = 0;
+    u64 worst_bytes = 0, total_bytes = 0;
+    while (TextureStream_Pending(&stream) > 0 && frames < max_frames) {
+        up->frame_bytes = 0;
+        auto begin      = std::chrono::steady_clock::now();
+        u64 bytes
+          = TextureStream_Upload(&stream, budget, _UT_UploadRows, _UT_Done, up);
+        auto end = std::chrono::steady_clock::now();
+
+        f64 ms = std::chrono::duration<f64, std::milli>(end - begin).count();
+        worst_ms    = MAX(worst_ms, ms);
+        worst_bytes = MAX(worst_bytes, bytes);
+        total_bytes += bytes;
+        UT_CHECK(bytes == up->frame_bytes);
+        UT_CHECK(stream.frame_stats.bytes == bytes);
+        UT_CHECK(stream.frame_stats.pending == TextureStream_Pending(&stream));
+        ++frames;
+
+        // the rest of the frame, while workers decode
+        if (worker_count > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    u64 expected_bytes = 0;
+    for (int i = 0; i < UT_TEXTURE_COUNT; i++) {
+        UT_Texture* tex = up->textures + i;
+        if (tex->bad) continue;
+        expected_bytes += (u64)tex->width * tex->height * UT_BYTES_PER_TEXEL;
+    }
+
+    UT_CHECK(frames < max_frames);
+    UT_CHECK(TextureStream_Pending(&stream) == 0);
+    UT_CHECK(total_bytes == expected_bytes);
+    // every row is at most 512 * 4 bytes, so the budget is never exceeded
+    UT_CHECK_MSG(worst_bytes <= budget, "worst frame uploaded %llu bytes",
+                 (unsigned long long)worst_bytes);
+    UT_CHECK_MSG(worst_ms < frame_ms, "worst frame %fms", worst_ms);
+    // spread over several frames, but not many more than needed. A frame leaves
+    // less than a row of its budget unused
+    UT_CHECK(frames >= (int)(expected_bytes / budget));
+    if (worker_count == 0)
+        UT_CHECK(frames <= (int)(expected_bytes / (budget - 512 * 4)) + 1);
+    _UT_CheckTextures(up);
+
+    _UT_FreeTextures(up);
+    free(up);
+    TextureStream_Free(&stream);
+}
+
+// a row larger than the budget still uploads, one row per frame
+static void _UT_TinyBudget()
+{
+    TextureStream stream = {};
+    TextureStream_Init(&stream, 0, _UT_Decode, _UT_FreePixels);
+
+    UT_Upload* up   = (UT_Upload*)calloc(1, sizeof(UT_Upload));
+    UT_Texture* tex = up->textures;
+    tex->width      = 64;
+    tex->height     = 8;
+    tex->texels     = (u8*)calloc((size_t)tex->width * tex->height, UT_BYTES_PER_TEXEL);
+    TextureStream_SubmitFile(&stream, 0, 0, "64 8", false);
+
+    int frames = 0;
+    while (TextureStream_Pending(&stream) > 0 && frames < 100) {
+        u64 bytes = TextureStream_Upload(&stream, 1, _UT_UploadRows, _UT_Done, up);
+        UT_CHECK(bytes == 64 * UT_BYTES_PER_TEXEL);
+        ++frames;
+    }
+    UT_CHECK(frames == 8);
+    UT_CHECK(tex->done == 1 && tex->ok);
+    UT_CHECK(up->wrong_rows == 0 && up->early_done == 0);
+
+    // nothing left, uploads nothing
+    UT_CHECK(TextureStream_Upload(&stream, 1, _UT_UploadRows, _UT_Done, up) == 0);
+
+    _UT_FreeTextures(up);
+    free(up);
+    TextureStream_Free(&stream);
+}
+
+// freeing with jobs queued, decoded and half uploaded must not leak or call done
+static void _UT_FreePending()
+{
+    TextureStream stream = {};
+    TextureStream_Init(&stream, 2, _UT_Decode, _UT_FreePixels);
+
+    UT_Upload* up = (UT_Upload*)calloc(1, sizeof(UT_Upload));
+    UT_Rng rng    = { 7u };
+    _UT_Submit(&stream, up, &rng);
+    TextureStream_Upload(&stream, 4096, _UT_UploadRows, _UT_Done, up);
+    int done = stream.frame_stats.done;
+    TextureStream_Free(&stream);
+    UT_CHECK(TextureStream_Pending(&stream) == 0);
+
+    int done_after = 0;
+    for (int i = 0; i < UT_TEXTURE_COUNT; i++) done_after += up->textures[i].done;
+    UT_CHECK(done_after == done);
+
+    _UT_FreeTextures(up);
+    free(up);
+}
+
+// decoder with a mip chain: every level of "<width> <height>" down to 1x1, level
+// i filled with byte i
+static bool _UT_DecodeLevels(TextureStreamJob* job)
+{
+    if (!_UT_Decode(job)) return false;
+    free(job->pixels);
+
+    u64 size = 0;
+    int w = job->width, h = job->height;
+    for (job->level_count = 0; job->level_count < TEXTURE_STREAM_MAX_LEVELS;) {
+        TextureStreamLevel* level = &job->levels[job->level_count++];
+        level->offset             = size;
+        level->width              = w;
+        level->height             = h;
+        level->rows               = h;
+        level->bytes_per_row      = w * UT_BYTES_PER_TEXEL;
+        size += (u64)level->rows * level->bytes_per_row;
+        if (w == 1 && h == 1) break;
+        w = MAX(w / 2, 1);
+        h = MAX(h / 2, 1);
+    }
+    job->pixels = (u8*)malloc(size);
+    for (int i = 0; i < job->level_count; i++) {
+        TextureStreamLevel* level = &job->levels[i];
+        memset(job->pixels + level->offset, i,
+               (size_t)level->rows * level->bytes_per_row);
+    }
+    return true;
+}
+
+struct UT_LevelUpload {
+    int level; // expected next
+    int row;
+    int rows_total;
+    int wrong;
+    int done;
+};
+
+static void _UT_UploadLevelRows(TextureStreamJob* job, int row, int row_count,
+                                void* udata)
+{
+    UT_LevelUpload* up        = (UT_LevelUpload*)udata;
+    TextureStreamLevel* level = &job->levels[job->level];
+    if (job->level != up->level || row != up->row || row + row_count > level->rows)
+        ++up->wrong;
+    const u8* src = job->pixels + level->offset + (size_t)row * level->bytes_per_row;
+    for (int i = 0; i < row_count * level->bytes_per_row; i++) {
+        if (src[i] != job->level) {
+            ++up->wrong;
+            break;
+        }
+    }
+    up->row = row + row_count;
+    up->rows_total += row_count;
+    if (up->row == level->rows) {
+        up->level++;
+        up->row = 0;
+    }
+}
+
+static void _UT_LevelDone(TextureStreamJob* job, void* udata)
+{
+    UT_LevelUpload* up = (UT_LevelUpload*)udata;
+    ++up->done;
+    UT_CHECK(job->ok && up->level == job->level_count);
+}
+
+// mip levels upload in order, a level can be split across frames and a frame can
+// finish one level and start the next
+static void _UT_Levels()
+{
+    TextureStream stream = {};
+    TextureStream_Init(&stream, 0, _UT_DecodeLevels, _UT_FreePixels);
+    TextureStream_SubmitFile(&stream, 0, 0, "64 32", false);
+
+    UT_LevelUpload up = {};
+    int frames        = 0;
+    while (TextureStream_Pending(&stream) > 0 && frames < 100) {
+        TextureStream_Upload(&stream, 3000, _UT_UploadLevelRows, _UT_LevelDone, &up);
+        ++frames;
+    }
+    // 7 levels, 32 + 16 + ... + 1 rows
+    UT_CHECK(up.done == 1 && up.wrong == 0);
+    UT_CHECK_MSG(up.level == 7 && up.rows_total == 32 + 16 + 8 + 4 + 2 + 1 + 1,
+                 "level %d rows %d", up.level, up.rows_total);
+    UT_CHECK(frames > 1);
+
+    TextureStream_Free(&stream);
+}
+
+void UT_TextureStream()
+{
+    _UT_Budget(0);
+    _UT_Budget(3);
+    _UT_TinyBudget();
+    _UT_FreePending();
+    _UT_Levels();
+}
@@ -0,0 +1,454 @@
+#include "unit_test.h"
+
+#include "texture_transcode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// reference outputs are worked out by hand from the BC / ETC2 specs
+
+static void _UT_CheckTexel(const u8* rgba, u32 width, u32 x, u32 y, u8 r, u8 g, u8 b,
+                           u8 a)
+{
+    const u8* t = rgba + (y * width + x) * 4;
+    UT_CHECK_MSG(t[0] == r && t[1] == g && t[2] == b && t[3] == a,
+                 "texel (%d, %d) is (%d %d %d %d), expected (%d %d %d %d)", x, y,
+                 t[0], t[1], t[2], t[3], r, g, b, a);
+}
+
+// LSB first, like BC7
+struct UT_BitWriter {
+    u8 bytes[16];
+    u32 pos;
+
+    static void write(UT_BitWriter* w, u32 value, u32 count)
+    {
+        for (u32 i = 0; i < count; i++, w->pos++) {
+            if ((value >> i) & 1) w->bytes[w->pos >> 3] |= 1 << (w->pos & 7);
+        }
+    }
+};
+
+static void _UT_BigEndian64(u64 v, u8* out)
+{
+    for (int i = 0; i < 8; i++) out[i] = (u8)(v >> (56 - 8 * i));
+}
+
+static void _UT_Formats()
+{
+    UT_CHECK(TextureTranscode_LevelBytes(TextureBlockFormat_BC7, 5, 5) == 2 * 2 * 16);
+    UT_CHECK(TextureTranscode_LevelBytes(TextureBlockFormat_BC1, 1, 1) == 8);
+    UT_CHECK(TextureTranscode_LevelBytes(TextureBlockFormat_RGBA8, 3, 2) == 24);
+    UT_CHECK(TextureTranscode_ChainBytes(TextureBlockFormat_RGBA8, 4, 4, 3)
+             == 64 + 16 + 4);
+    UT_CHECK(TextureTranscode_MipCount(256, 64) == 9);
+    UT_CHECK(TextureTranscode_MipCount(1, 1) == 1);
+
+    // 4x smaller than RGBA8, 8x for the 8 byte block formats
+    u64 rgba8 = TextureTranscode_LevelBytes(TextureBlockFormat_RGBA8, 1024, 1024);
+    u64 bc7   = TextureTranscode_LevelBytes(TextureBlockFormat_BC7, 1024, 1024);
+    u64 etc2  = TextureTranscode_LevelBytes(TextureBlockFormat_ETC2_RGB8, 1024, 1024);
+    UT_CHECK(rgba8 == 4 * bc7 && rgba8 == 8 * etc2);
+
+    // supported as is, else decoded on the CPU, else nothing
+    u32 all = TextureCompression_BC | TextureCompression_ETC2 | TextureCompression_ASTC;
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_BC7, 64, 64, all)
+             == TextureBlockFormat_BC7);
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_BC7, 64, 64,
+                                         TextureCompression_ETC2)
+             == TextureBlockFormat_RGBA8);
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_ETC2_RGBA8, 64, 64,
+                                         TextureCompression_ETC2)
+             == TextureBlockFormat_ETC2_RGBA8);
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_ASTC_4x4, 64, 64,
+                                         TextureCompression_ASTC)
+             == TextureBlockFormat_ASTC_4x4);
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_ASTC_4x4, 64, 64, 0)
+             == TextureBlockFormat_None);
+    // not a whole number of blocks, can't be created on the GPU
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_BC7, 66, 64, all)
+             == TextureBlockFormat_RGBA8);
+    UT_CHECK(TextureTranscode_PickTarget(TextureBlockFormat_RGBA8, 3, 3, 0)
+             == TextureBlockFormat_RGBA8);
+}
+
+static void _UT_BC1()
+{
+    u8 rgba[4 * 4 * 4];
+
+    // 4 colors: red, blue, and 2/3, 1/3 of the way
+    u8 block[8] = { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0, 0, 0 };
+    UT_CHECK(TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC1, block, 4, 4, rgba));
+    _UT_CheckTexel(rgba, 4, 0, 0, 255, 0, 0, 255);
+    _UT_CheckTexel(rgba, 4, 1, 0, 0, 0, 255, 255);
+    _UT_CheckTexel(rgba, 4, 2, 0, 170, 0, 85, 255);
+    _UT_CheckTexel(rgba, 4, 3, 0, 85, 0, 170, 255);
+    _UT_CheckTexel(rgba, 4, 3, 3, 255, 0, 0, 255);
+
+    // c0 <= c1: 3 colors and transparent black
+    u8 block3[8] = { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0, 0, 0 };
+    TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC1, block3, 4, 4, rgba);
+    _UT_CheckTexel(rgba, 4, 2, 0, 128, 0, 128, 255);
+    _UT_CheckTexel(rgba, 4, 3, 0, 0, 0, 0, 0);
+
+    // BC3 always uses 4 colors, alpha from its own block: 255 to 0, all index 1
+    u8 bc3[16] = { 255, 0, 0x49, 0x92, 0x24, 0x49, 0x92, 0x24,
+                   0x1F, 0x00, 0x00, 0xF8, 0xE4, 0, 0, 0 };
+    TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC3, bc3, 4, 4, rgba);
+    _UT_CheckTexel(rgba, 4, 0, 0, 0, 0, 255, 0);
+    _UT_CheckTexel(rgba, 4, 2, 0, 85, 0, 170, 0);
+}
+
+static void _UT_BC4()
+{
+    u8 rgba[4 * 4 * 4];
+
+    // red 200 to 100 in 8 steps, all index 2. green 100 to 200: 6 steps, 0 and 255
+    // texel 0 index 6 (0), texel 1 index 7 (255)
+    u8 bc5[16] = { 200, 100, 0x92, 0x24, 0x49, 0x92, 0x24, 0x49,
+                   100, 200, 0x3E, 0,    0,    0,    0,    0 };
+    UT_CHECK(TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC5, bc5, 4, 4, rgba));
+    _UT_CheckTexel(rgba, 4, 0, 0, 186, 0, 0, 255);
+    _UT_CheckTexel(rgba, 4, 1, 0, 186, 255, 0, 255);
+    _UT_CheckTexel(rgba, 4, 2, 0, 186, 100, 0, 255);
+}
+
+static void _UT_BC7()
+{
+    u8 rgba[4 * 4 * 4];
+
+    { // mode 6: 1 subset, rgba endpoints with a p-bit each, 4 bit indices
+        UT_BitWriter w = {};
+        UT_BitWriter::write(&w, 1 << 6, 7);
+        UT_BitWriter::write(&w, 127, 7), UT_BitWriter::write(&w, 0, 7);   // r
+        UT_BitWriter::write(&w, 0, 7), UT_BitWriter::write(&w, 127, 7);   // g
+        UT_BitWriter::write(&w, 64, 7), UT_BitWriter::write(&w, 64, 7);   // b
+        UT_BitWriter::write(&w, 127, 7), UT_BitWriter::write(&w, 127, 7); // a
+        UT_BitWriter::write(&w, 1, 1), UT_BitWriter::write(&w, 0, 1);     // p-bits
+        UT_BitWriter::write(&w, 0, 3); // texel 0 is the anchor, 3 bits
+        UT_BitWriter::write(&w, 15, 4);
+        UT_BitWriter::write(&w, 8, 4);
+        UT_CHECK(w.pos == 7 + 56 + 2 + 3 + 8);
+
+        UT_CHECK(
+          TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC7, w.bytes, 4, 4, rgba));
+        _UT_CheckTexel(rgba, 4, 0, 0, 255, 1, 129, 255);
+        _UT_CheckTexel(rgba, 4, 1, 0, 0, 254, 128, 254);
+        _UT_CheckTexel(rgba, 4, 2, 0, 120, 135, 128, 254);
+        _UT_CheckTexel(rgba, 4, 3, 3, 255, 1, 129, 255);
+    }
+
+    { // mode 1, partition 0: columns 2 and 3 are subset 1, red and green
+        UT_BitWriter w = {};
+        UT_BitWriter::write(&w, 1 << 1, 2);
+        UT_BitWriter::write(&w, 0, 6); // partition
+        u32 r[4] = { 63, 63, 0, 0 }, g[4] = { 0, 0, 63, 63 };
+        for (int e = 0; e < 4; e++) UT_BitWriter::write(&w, r[e], 6);
+        for (int e = 0; e < 4; e++) UT_BitWriter::write(&w, g[e], 6);
+        for (int e = 0; e < 4; e++) UT_BitWriter::write(&w, 0, 6);
+        UT_BitWriter::write(&w, 0, 2); // shared p-bits
+        // all indices 0
+        UT_CHECK(w.pos + 46 == 128);
+
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC7, w.bytes, 4, 4, rgba);
+        for (u32 y = 0; y < 4; y++) {
+            _UT_CheckTexel(rgba, 4, 1, y, 253, 0, 0, 255);
+            _UT_CheckTexel(rgba, 4, 2, y, 0, 253, 0, 255);
+        }
+    }
+
+    // mode 5: separate color and alpha indices, then rotation swaps red and alpha
+    for (u32 rotation = 0; rotation < 2; rotation++) {
+        UT_BitWriter w = {};
+        UT_BitWriter::write(&w, 1 << 5, 6);
+        UT_BitWriter::write(&w, rotation, 2);
+        UT_BitWriter::write(&w, 127, 7), UT_BitWriter::write(&w, 0, 7); // r
+        UT_BitWriter::write(&w, 0, 14);                                 // g
+        UT_BitWriter::write(&w, 0, 14);                                 // b
+        UT_BitWriter::write(&w, 255, 8), UT_BitWriter::write(&w, 0, 8); // a
+        UT_BitWriter::write(&w, 0, 1);                                  // anchor
+        UT_BitWriter::write(&w, 3, 2);
+        UT_BitWriter::write(&w, 0, 28);
+        UT_BitWriter::write(&w, 1, 1); // alpha indices all 1
+        for (int i = 1; i < 16; i++) UT_BitWriter::write(&w, 1, 2);
+        UT_CHECK(w.pos == 128);
+
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC7, w.bytes, 4, 4, rgba);
+        if (rotation == 0) {
+            _UT_CheckTexel(rgba, 4, 0, 0, 255, 0, 0, 171);
+            _UT_CheckTexel(rgba, 4, 1, 0, 0, 0, 0, 171);
+        } else {
+            _UT_CheckTexel(rgba, 4, 0, 0, 171, 0, 0, 255);
+            _UT_CheckTexel(rgba, 4, 1, 0, 171, 0, 0, 0);
+        }
+    }
+
+    // reserved mode: transparent black
+    u8 reserved[16] = {};
+    TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC7, reserved, 4, 4, rgba);
+    _UT_CheckTexel(rgba, 4, 1, 1, 0, 0, 0, 0);
+}
+
+static void _UT_ETC2()
+{
+    u8 rgba[4 * 4 * 4];
+    u8 block[16];
+
+    { // individual: both sub-blocks 136 gray, table 0 (2, 8)
+        u64 v = 0x8888880000000000ull;
+        v |= (1ull << 22) | (1ull << 6); // texel (1, 2): index 3, -8
+        _UT_BigEndian64(v, block);
+        TextureBlockFormat etc2 = TextureBlockFormat_ETC2_RGB8;
+        UT_CHECK(TextureTranscode_DecodeRGBA8(etc2, block, 4, 4, rgba));
+        _UT_CheckTexel(rgba, 4, 0, 0, 138, 138, 138, 255);
+        _UT_CheckTexel(rgba, 4, 1, 2, 128, 128, 128, 255);
+    }
+
+    { // differential: 16 and 16 + 1 in 5 bits, side by side, table 1 (5, 17)
+        u64 v = (16ull << 59) | (1ull << 56) | (16ull << 51) | (1ull << 48)
+                | (16ull << 43) | (1ull << 40) | (1ull << 37) | (1ull << 34)
+                | (1ull << 33);
+        _UT_BigEndian64(v, block);
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_ETC2_RGB8, block, 4, 4, rgba);
+        _UT_CheckTexel(rgba, 4, 1, 3, 137, 137, 137, 255);
+        _UT_CheckTexel(rgba, 4, 2, 0, 145, 145, 145, 255);
+
+        // flipped: top and bottom
+        _UT_BigEndian64(v | (1ull << 32), block);
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_ETC2_RGB8, block, 4, 4, rgba);
+        _UT_CheckTexel(rgba, 4, 3, 1, 137, 137, 137, 255);
+        _UT_CheckTexel(rgba, 4, 0, 2, 145, 145, 145, 255);
+    }
+
+    { // T mode: red overflows. C1 = (255, 0, 0), C2 = (0, 136, 0), distance 6
+        u64 v = (7ull << 61) | (3ull << 59) | (3ull << 56) | (8ull << 40)
+                | (1ull << 33) | (1ull << 32);
+        v |= (1ull << 5);                  // texel (1, 1): index 1
+        v |= (1ull << 26);                 // texel (2, 2): index 2
+        v |= (1ull << 31) | (1ull << 15);  // texel (3, 3): index 3
+        _UT_BigEndian64(v, block);
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_ETC2_RGB8, block, 4, 4, rgba);
+        _UT_CheckTexel(rgba, 4, 0, 0, 255, 0, 0, 255);
+        _UT_CheckTexel(rgba, 4, 1, 1, 6, 142, 6, 255);
+        _UT_CheckTexel(rgba, 4, 2, 2, 0, 136, 0, 255);
+        _UT_CheckTexel(rgba, 4, 3, 3, 0, 130, 0, 255);
+    }
+
+    { // planar: blue overflows. origin (130, 129, 130), red grows 8 per texel in x
+        u64 v = (32ull << 57) | (1ull << 56) | (1ull << 48) | (1ull << 42)
+                | (20ull << 34) | (1ull << 33) | (64ull << 25) | (32ull << 19)
+                | (32ull << 13) | (64ull << 6) | 32ull;
+        _UT_BigEndian64(v, block);
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_ETC2_RGB8, block, 4, 4, rgba);
+        _UT_CheckTexel(rgba, 4, 0, 0, 130, 129, 130, 255);
+        _UT_CheckTexel(rgba, 4, 1, 3, 138, 129, 130, 255);
+        _UT_CheckTexel(rgba, 4, 3, 0, 154, 129, 130, 255);
+    }
+
+    { // EAC alpha: base 128, multiplier 2, table 0. Texel 0 index 4 (+2), texel
+      // (0, 1) index 3 (-15), the rest index 0 (-3)
+        u64 alpha = (128ull << 56) | (2ull << 52) | (4ull << 45) | (3ull << 42);
+        _UT_BigEndian64(alpha, block);
+        _UT_BigEndian64(0x8888880000000000ull, block + 8);
+        TextureTranscode_DecodeRGBA8(TextureBlockFormat_ETC2_RGBA8, block, 4, 4, rgba);
+        _UT_CheckTexel(rgba, 4, 0, 0, 138, 138, 138, 132);
+        _UT_CheckTexel(rgba, 4, 0, 1, 138, 138, 138, 98);
+        _UT_CheckTexel(rgba, 4, 3, 3, 138, 138, 138, 122);
+    }
+
+    // no CPU decoder for ASTC
+    UT_CHECK(
+      !TextureTranscode_DecodeRGBA8(TextureBlockFormat_ASTC_4x4, block, 4, 4, rgba));
+}
+
+// blocks hanging over the edge of the image are clipped
+static void _UT_Clip()
+{
+    u8 blocks[4 * 8];
+    for (int i = 0; i < 4; i++) {
+        u8 block[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        block[0]    = (u8)(i + 1); // blue, by block
+        memcpy(blocks + i * 8, block, 8);
+    }
+    u8 rgba[5 * 6 * 4];
+    memset(rgba, 0xCD, sizeof(rgba));
+    UT_CHECK(TextureTranscode_DecodeRGBA8(TextureBlockFormat_BC1, blocks, 5, 6, rgba));
+    _UT_CheckTexel(rgba, 5, 3, 3, 0, 0, 8, 255);
+    _UT_CheckTexel(rgba, 5, 4, 3, 0, 0, 16, 255);
+    _UT_CheckTexel(rgba, 5, 0, 5, 0, 0, 24, 255);
+    _UT_CheckTexel(rgba, 5, 4, 5, 0, 0, 33, 255);
+}
+
+static void _UT_Put32(u8* p, u32 v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (u8)(v >> (8 * i));
+}
+
+static void _UT_Put64(u8* p, u64 v)
+{
+    for (int i = 0; i < 8; i++) p[i] = (u8)(v >> (8 * i));
+}
+
+// an in-memory KTX2 file of 16 byte blocks, with level i's blocks filled with
+// `fill`, the DFD color model `model` and no key/values
+static u8* _UT_KTX2(u32 vk_format, u32 width, u32 height, u32 level_count,
+                    u32 supercompression, u32 model, const u8* fill, u64* out_len)
+{
+    static const u8 identifier[12]
+      = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    u32 dfd_offset = 80 + level_count * 24;
+    u32 dfd_length = 4 + 24;
+    u64 data_start = dfd_offset + dfd_length;
+    u64 size       = data_start;
+    for (u32 i = 0; i < level_count; i++) {
+        size += TextureTranscode_LevelBytes(TextureBlockFormat_BC7, MAX(width >> i, 1u),
+                                            MAX(height >> i, 1u));
+    }
+
+    u8* data = (u8*)calloc(1, size);
+    memcpy(data, identifier, 12);
+    _UT_Put32(data + 12, vk_format);
+    _UT_Put32(data + 16, 1);
+    _UT_Put32(data + 20, width);
+    _UT_Put32(data + 24, height);
+    _UT_Put32(data + 36, 1); // faces
+    _UT_Put32(data + 40, level_count);
+    _UT_Put32(data + 44, supercompression);
+    _UT_Put32(data + 48, dfd_offset);
+    _UT_Put32(data + 52, dfd_length);
+
+    _UT_Put32(data + dfd_offset, dfd_length);
+    data[dfd_offset + 4 + 8] = (u8)model;
+
+    u64 offset = data_start;
+    for (u32 i = 0; i < level_count; i++) {
+        u64 bytes = TextureTranscode_LevelBytes(
+          TextureBlockFormat_BC7, MAX(width >> i, 1u), MAX(height >> i, 1u));
+        _UT_Put64(data + 80 + i * 24, offset);
+        _UT_Put64(data + 80 + i * 24 + 8, bytes);
+        for (u64 b = 0; b < bytes; b += 16) memcpy(data + offset + b, fill, 16);
+        offset += bytes;
+    }
+    *out_len = size;
+    return data;
+}
+
+static void _UT_KTX2()
+{
+    // a BC7 mode 6 block, solid (255, 1, 129, 255)
+    UT_BitWriter w = {};
+    UT_BitWriter::write(&w, 1 << 6, 7);
+    UT_BitWriter::write(&w, 127, 7), UT_BitWriter::write(&w, 127, 7);
+    UT_BitWriter::write(&w, 0, 14);
+    UT_BitWriter::write(&w, 64, 7), UT_BitWriter::write(&w, 64, 7);
+    UT_BitWriter::write(&w, 127, 7), UT_BitWriter::write(&w, 127, 7);
+    UT_BitWriter::write(&w, 3, 2);
+
+    const char* error = NULL;
+    KTX2Image image;
+    u64 len;
+    u8* file = _UT_KTX2(146, 8, 8, 4, 0, 0, w.bytes, &len); // BC7 sRGB, full chain
+
+    UT_CHECK(TextureTranscode_IsKTX2(file, len));
+    UT_CHECK(TextureTranscode_ParseKTX2(file, KTX2_HEADER_BYTES, true, &image, &error));
+    UT_CHECK(image.width == 8 && image.height == 8 && image.level_count == 4);
+    UT_CHECK(image.format == TextureBlockFormat_BC7 && image.srgb);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(image.levels[3].width == 1 && image.levels[3].length == 16);
+
+    // uploaded as is, 4x smaller than the RGBA8 fallback
+    TextureTranscodeResult result;
+    UT_CHECK(TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                   &result, &error));
+    UT_CHECK(result.format == TextureBlockFormat_BC7 && result.level_count == 4);
+    UT_CHECK(result.size == 64 + 16 + 16 + 16);
+    UT_CHECK(result.levels[0].rows == 2 && result.levels[0].bytes_per_row == 32);
+    UT_CHECK(result.levels[2].rows == 1 && result.levels[2].offset == 80);
+    UT_CHECK(memcmp(result.pixels + 80, w.bytes, 16) == 0);
+    free(result.pixels);
+
+    // no BC: decoded on the CPU
+    UT_CHECK(TextureTranscode_KTX2(file, len, &image, TextureCompression_ETC2, true,
+                                   &result, &error));
+    UT_CHECK(result.format == TextureBlockFormat_RGBA8 && result.level_count == 4);
+    UT_CHECK(result.size == 256 + 64 + 16 + 4);
+    UT_CHECK(result.levels[0].rows == 8 && result.levels[0].bytes_per_row == 32);
+    _UT_CheckTexel(result.pixels, 8, 7, 7, 255, 1, 129, 255);
+    _UT_CheckTexel(result.pixels + result.levels[3].offset, 1, 0, 0, 255, 1, 129, 255);
+    free(result.pixels);
+
+    // no mips wanted: level 0 only
+    UT_CHECK(TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, false,
+                                   &result, &error));
+    UT_CHECK(result.level_count == 1 && result.size == 64);
+    free(result.pixels);
+
+    // errors
+    UT_CHECK(!TextureTranscode_ParseKTX2(file, 40, true, &image, &error));
+    UT_CHECK(!TextureTranscode_ParseKTX2(file, len - 1, false, &image, &error));
+    file[0] = 0;
+    UT_CHECK(!TextureTranscode_IsKTX2(file, len));
+    UT_CHECK(!TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    free(file);
+
+    // incomplete chain: level 0 only
+    file = _UT_KTX2(145, 8, 8, 2, 0, 0, w.bytes, &len);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                   &result, &error));
+    UT_CHECK(result.level_count == 1 && !result.srgb);
+    free(result.pixels);
+    free(file);
+
+    // cubemap
+    file = _UT_KTX2(145, 8, 8, 1, 0, 0, w.bytes, &len);
+    _UT_Put32(file + 36, 6);
+    UT_CHECK(!TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    free(file);
+
+    // Basis Universal: ETC1S (BasisLZ) and UASTC
+    file = _UT_KTX2(0, 8, 8, 1, KTX2Supercompression_BasisLZ, 163, w.bytes, &len);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(!TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                    &result, &error));
+    UT_CHECK(strstr(error, "Basis") != NULL);
+    free(file);
+    file = _UT_KTX2(0, 8, 8, 1, 0, 166, w.bytes, &len);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(image.uastc);
+    UT_CHECK(!TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                    &result, &error));
+    UT_CHECK(strstr(error, "Basis") != NULL);
+    free(file);
+
+    // zstd supercompressed BC7
+    file = _UT_KTX2(145, 8, 8, 1, KTX2Supercompression_Zstd, 0, w.bytes, &len);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(!TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                    &result, &error));
+    UT_CHECK(strstr(error, "zstd") != NULL);
+    free(file);
+
+    // ASTC without ASTC support
+    file = _UT_KTX2(157, 8, 8, 1, 0, 0, w.bytes, &len);
+    UT_CHECK(TextureTranscode_ParseKTX2(file, len, false, &image, &error));
+    UT_CHECK(!TextureTranscode_KTX2(file, len, &image, TextureCompression_BC, true,
+                                    &result, &error));
+    UT_CHECK(TextureTranscode_KTX2(file, len, &image, TextureCompression_ASTC, true,
+                                   &result, &error));
+    UT_CHECK(result.format == TextureBlockFormat_ASTC_4x4 && result.size == 64);
+    free(result.pixels);
+    free(file);
+}
+
+void UT_TextureTranscode()
+{
+    _UT_Formats();
+    _UT_BC1();
+    _UT_BC4();
+    _UT_BC7();
+    _UT_ETC2();
+    _UT_Clip();
+    _UT_KTX2();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdio.h>
+
+// Minimal harness for the cpu-only unit tests.
+// Each test file defines a `void UT_<Name>()` which reports failures through
+// UT_CHECK, and is registered in the table in main.cpp
+
+extern int ut_failures;
+
+#define UT_CHECK(cond)                                                                 \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            fprintf(stderr, "  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);        \
+            ++ut_failures;                                                             \
+        }                                                                              \
+    } while (0)
+
+#define UT_CHECK_MSG(cond, ...)                                                        \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            fprintf(stderr, "  FAILED %s:%d: %s | ", __FILE__, __LINE__, #cond);       \
+            fprintf(stderr, __VA_ARGS__);                                              \
+            fprintf(stderr, "\n");                                                     \
+            ++ut_failures;                                                             \
+        }                                                                              \
+    } while (0)
+
+// simple deterministic rng so failures are reproducible across platforms
+struct UT_Rng {
+    unsigned int state;
+
+    float next01()
+    {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float range(float lo, float hi)
+    {
+        return lo + (hi - lo) * next01();
+    }
+};
@@ -0,0 +1,306 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "texture_stream.h"
+
+#include "core/memory.h"
+
+#include <string.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// intrusive FIFO of jobs
+struct TextureStreamList {
+    TextureStreamJob* head;
+    TextureStreamJob* tail;
+
+    static void push(TextureStreamList* list, TextureStreamJob* job)
+    {
+        job->next = NULL;
+        if (list->tail) {
+            list->tail->next = job;
+        } else {
+            list->head = job;
+        }
+        list->tail = job;
+    }
+
+    // appends all of `src` and empties it
+    static void splice(TextureStreamList* list, TextureStreamList* src)
+    {
+        if (src->head == NULL) return;
+        if (list->tail) {
+            list->tail->next = src->head;
+        } else {
+            list->head = src->head;
+        }
+        list->tail = src->tail;
+        *src       = {};
+    }
+
+    static TextureStreamJob* pop(TextureStreamList* list)
+    {
+        TextureStreamJob* job = list->head;
+        if (job) {
+            list->head = job->next;
+            if (list->head == NULL) list->tail = NULL;
+            job->next = NULL;
+        }
+        return job;
+    }
+};
+
+struct TextureStreamState {
+    std::thread* threads;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    bool quit;
+
+    // guarded by mutex
+    TextureStreamList queued;  // waiting on a worker
+    TextureStreamList decoded; // waiting on the render thread
+
+    // render thread only
+    TextureStreamList uploading; // decoded, head is the one being uploaded
+    int pending;
+};
+
+static void TextureStream_FreeSource(TextureStreamJob* job)
+{
+    FREE(job->filepath);
+    FREE(job->data);
+    job->data_len = 0;
+}
+
+static void TextureStream_FreeJob(TextureStream* stream, TextureStreamJob* job)
+{
+    TextureStream_FreeSource(job);
+    if (job->pixels) stream->free_pixels(job->pixels);
+    FREE(job);
+}
+
+static void TextureStream_FreeList(TextureStream* stream, TextureStreamList* list)
+{
+    TextureStreamJob* job;
+    while ((job = TextureStreamList::pop(list))) TextureStream_FreeJob(stream, job);
+}
+
+static void TextureStream_Decode(TextureStream* stream, TextureStreamJob* job)
+{
+    job->ok = stream->decode(job);
+    if (job->ok && job->level_count == 0) {
+        TextureStreamLevel* level = &job->levels[0];
+        level->offset             = 0;
+        level->width              = job->width;
+        level->height             = job->height;
+        level->rows               = job->height;
+        level->bytes_per_row      = job->bytes_per_row;
+        job->level_count          = 1;
+    }
+    if (job->ok && (job->pixels == NULL || job->width <= 0 || job->height <= 0)) {
+        job->ok    = false;
+        job->error = "decoder returned no pixels";
+    }
+    for (int i = 0; job->ok && i < job->level_count; i++) {
+        if (job->level_count > TEXTURE_STREAM_MAX_LEVELS || job->levels[i].rows <= 0
+            || job->levels[i].bytes_per_row <= 0) {
+            job->ok    = false;
+            job->error = "decoder returned an empty mip level";
+        }
+    }
+    // rows are only uploaded from a successful decode
+    if (!job->ok && job->pixels) {
+        stream->free_pixels(job->pixels);
+        job->pixels = NULL;
+    }
+    TextureStream_FreeSource(job);
+}
+
+static void TextureStream_WorkerMain(TextureStream* stream)
+{
+    TextureStreamState* state = stream->state;
+    while (true) {
+        TextureStreamJob* job;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->work_cv.wait(
+              lock, [&] { return state->quit || state->queued.head != NULL; });
+            if (state->quit) return;
+            job = TextureStreamList::pop(&state->queued);
+        }
+
+        TextureStream_Decode(stream, job);
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        TextureStreamList::push(&state->decoded, job);
+    }
+}
+
+void TextureStream_Init(TextureStream* stream, int worker_count,
+                        TextureStream_DecodeFunc decode,
+                        TextureStream_FreeFunc free_pixels)
+{
+    ASSERT(stream->state == NULL);
+    ASSERT(decode && free_pixels);
+    *stream              = {};
+    stream->worker_count = MAX(worker_count, 0);
+    stream->decode       = decode;
+    stream->free_pixels  = free_pixels;
+    stream->state        = new TextureStreamState();
+
+    if (stream->worker_count == 0) return;
+    stream->state->threads = new std::thread[stream->worker_count];
+    for (int i = 0; i < stream->worker_count; i++) {
+        stream->state->threads[i] = std::thread(TextureStream_WorkerMain, stream);
+    }
+}
+
+void TextureStream_Free(TextureStream* stream)
+{
+    TextureStreamState* state = stream->state;
+    if (state) {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->quit = true;
+        }
+        state->work_cv.notify_all();
+        for (int i = 0; i < stream->worker_count; i++) state->threads[i].join();
+
+        TextureStream_FreeList(stream, &state->queued);
+        TextureStream_FreeList(stream, &state->decoded);
+        TextureStream_FreeList(stream, &state->uploading);
+
+        delete[] state->threads;
+        delete state;
+    }
+    *stream = {};
+}
+
+static void TextureStream_Submit(TextureStream* stream, TextureStreamJob* job)
+{
+    TextureStreamState* state = stream->state;
+    ++state->pending;
+
+    if (stream->worker_count == 0) {
+        TextureStream_Decode(stream, job);
+        TextureStreamList::push(&state->uploading, job);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        TextureStreamList::push(&state->queued, job);
+    }
+    state->work_cv.notify_one();
+}
+
+static TextureStreamJob* TextureStream_NewJob(u32 id, u32 layer, bool flip_y)
+{
+    TextureStreamJob* job = ALLOCATE_TYPE(TextureStreamJob);
+    *job                  = {};
+    job->id               = id;
+    job->layer            = layer;
+    job->flip_y           = flip_y;
+    return job;
+}
+
+void TextureStream_SubmitFile(TextureStream* stream, u32 id, u32 layer,
+                              const char* filepath, bool flip_y)
+{
+    TextureStreamJob* job = TextureStream_NewJob(id, layer, flip_y);
+    size_t len            = filepath ? strlen(filepath) : 0;
+    job->filepath         = ALLOCATE_COUNT(char, len + 1);
+    memcpy(job->filepath, filepath ? filepath : "", len + 1);
+    TextureStream_Submit(stream, job);
+}
+
+void TextureStream_SubmitMemory(TextureStream* stream, u32 id, u32 layer,
+                                const u8* data, int data_len, bool flip_y)
+{
+    TextureStreamJob* job = TextureStream_NewJob(id, layer, flip_y);
+    job->data_len         = MAX(data_len, 0);
+    job->data             = ALLOCATE_COUNT(u8, MAX(job->data_len, 1));
+    if (job->data_len) memcpy(job->data, data, job->data_len);
+    TextureStream_Submit(stream, job);
+}
+
+int TextureStream_Pending(TextureStream* stream)
+{
+    return stream->state ? stream->state->pending : 0;
+}
+
+u64 TextureStream_Upload(TextureStream* stream, u64 budget_bytes,
+                         TextureStream_UploadFunc upload,
+                         TextureStream_DoneFunc done, void* udata)
+{
+    TextureStreamState* state = stream->state;
+    TextureStreamStats stats  = {};
+
+    if (stream->worker_count > 0) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        TextureStreamList::splice(&state->uploading, &state->decoded);
+    }
+
+    TextureStreamJob* job;
+    while ((job = state->uploading.head)) {
+        while (job->ok && job->level < job->level_count) {
+            TextureStreamLevel* level = &job->levels[job->level];
+            u64 row_bytes             = (u64)level->bytes_per_row;
+            u64 rows                  = level->rows - job->rows_uploaded;
+            if (budget_bytes > 0) {
+                u64 left = budget_bytes > stats.bytes ? budget_bytes - stats.bytes : 0;
+                rows     = MIN(rows, left / row_bytes);
+                // always make progress, even on a row larger than the budget
+                if (rows == 0 && stats.bytes == 0) rows = 1;
+            }
+            if (rows == 0) break;
+
+            upload(job, job->rows_uploaded, (int)rows, udata);
+            job->rows_uploaded += (int)rows;
+            stats.rows += (int)rows;
+            stats.bytes += rows * row_bytes;
+            if (job->rows_uploaded < level->rows) break;
+
+            job->level++;
+            job->rows_uploaded = 0;
+        }
+        // out of budget
+        if (job->ok && job->level < job->level_count) break;
+
+        TextureStreamList::pop(&state->uploading);
+        --state->pending;
+        ++stats.done;
+        done(job, udata);
+        TextureStream_FreeJob(stream, job);
+    }
+
+    stats.pending       = state->pending;
+    stream->frame_stats = stats;
+    return stats.bytes;
+}
@@ -0,0 +1,145 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+/*
+Streamed texture loading
+
+Decoding an image file and uploading it in one go stalls the render thread for
+as long as both take, which for a few 4K images or a cubemap is many frames.
+
+Instead each image (or cubemap face) is submitted as a job:
+- workers decode it off the render thread, via a decode callback
+- once per frame, the render thread uploads decoded jobs row by row, oldest
+  decoded first, until that frame's budget of bytes is spent. A job can be
+  spread across several frames. Every call uploads at least one row (if any
+  is ready), so the stream always drains
+- a decoded job may hold several mip levels (e.g. from a file with a mip
+  chain), uploaded one after the other, largest first
+- when all rows of a job are uploaded, or its decode failed, a done callback
+  fires on the render thread and the job is freed
+Until then the owner is expected to keep a placeholder bound.
+
+With 0 workers (e.g. emscripten) jobs are decoded on submit.
+
+Knows nothing about textures or image formats, so it can be tested on the CPU.
+*/
+
+#define TEXTURE_STREAM_MAX_LEVELS 16
+
+// one mip level of a decoded job: `rows` of `bytes_per_row` at `offset` into its
+// pixels. A row is whatever the decoder uploads at a time, e.g. a row of 4x4
+// blocks of a compressed format
+struct TextureStreamLevel {
+    u64 offset;
+    int width; // in texels
+    int height;
+    int rows;
+    int bytes_per_row;
+};
+
+struct TextureStreamJob {
+    u32 id;    // owner, e.g. the texture being loaded
+    u32 layer; // array layer / cubemap face written to
+    bool flip_y;
+
+    // source, owned by the job and freed once decoded. filepath if not NULL,
+    // otherwise data
+    char* filepath;
+    u8* data;
+    int data_len;
+
+    // set by the decode callback
+    u8* pixels; // freed with the free callback
+    int width;
+    int height;
+    int bytes_per_row;
+    u32 format;        // decoder defined, e.g. the format to upload as
+    const char* error; // static string, if decode failed
+
+    // if the decoder leaves level_count 0, pixels is a single level of `height`
+    // rows of `bytes_per_row`
+    int level_count;
+    TextureStreamLevel levels[TEXTURE_STREAM_MAX_LEVELS];
+
+    int level;         // being uploaded
+    int rows_uploaded; // of that level
+    bool ok;
+    TextureStreamJob* next;
+};
+
+// called on a worker thread. Returns false on failure
+typedef bool (*TextureStream_DecodeFunc)(TextureStreamJob* job);
+typedef void (*TextureStream_FreeFunc)(u8* pixels);
+
+// rows [row, row + row_count) of mip level job->level are ready to upload
+typedef void (*TextureStream_UploadFunc)(TextureStreamJob* job, int row,
+                                         int row_count, void* udata);
+// job->ok is false if its decode failed
+typedef void (*TextureStream_DoneFunc)(TextureStreamJob* job, void* udata);
+
+// of the last TextureStream_Upload
+struct TextureStreamStats {
+    u64 bytes;
+    int rows;
+    int done;
+    int pending; // jobs submitted but not yet done afterwards
+};
+
+struct TextureStream {
+    struct TextureStreamState* state;
+    int worker_count;
+    TextureStream_DecodeFunc decode;
+    TextureStream_FreeFunc free_pixels;
+
+    TextureStreamStats frame_stats;
+};
+
+void TextureStream_Init(TextureStream* stream, int worker_count,
+                        TextureStream_DecodeFunc decode,
+                        TextureStream_FreeFunc free_pixels);
+
+// joins the workers and frees every job without calling done
+void TextureStream_Free(TextureStream* stream);
+
+// the source is copied, so it can be freed once these return
+void TextureStream_SubmitFile(TextureStream* stream, u32 id, u32 layer,
+                              const char* filepath, bool flip_y);
+void TextureStream_SubmitMemory(TextureStream* stream, u32 id, u32 layer,
+                                const u8* data, int data_len, bool flip_y);
+
+// jobs submitted but not yet done
+int TextureStream_Pending(TextureStream* stream);
+
+// uploads decoded rows within `budget_bytes` (0 means unlimited) and calls done
+// for every finished job. Returns the number of bytes uploaded
+u64 TextureStream_Upload(TextureStream* stream, u64 budget_bytes,
+                         TextureStream_UploadFunc upload,
+                         TextureStream_DoneFunc done, void* udata);
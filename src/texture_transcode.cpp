@@ -0,0 +1,851 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#include "texture_transcode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Formats
+// ============================================================================
+
+static const TextureBlockInfo _texture_block_info[TextureBlockFormat_Count] = {
+    { "none", 1, 1, 0, 0, false },
+    { "RGBA8", 1, 1, 4, 0, false },
+    { "BC1", 4, 4, 8, TextureCompression_BC, true },
+    { "BC3", 4, 4, 16, TextureCompression_BC, true },
+    { "BC4", 4, 4, 8, TextureCompression_BC, true },
+    { "BC5", 4, 4, 16, TextureCompression_BC, true },
+    { "BC7", 4, 4, 16, TextureCompression_BC, true },
+    { "ETC2 RGB8", 4, 4, 8, TextureCompression_ETC2, true },
+    { "ETC2 RGBA8", 4, 4, 16, TextureCompression_ETC2, true },
+    { "ASTC 4x4", 4, 4, 16, TextureCompression_ASTC, false },
+};
+
+const TextureBlockInfo* TextureTranscode_Info(TextureBlockFormat format)
+{
+    if (format >= TextureBlockFormat_Count) format = TextureBlockFormat_None;
+    return &_texture_block_info[format];
+}
+
+u64 TextureTranscode_LevelBytes(TextureBlockFormat format, u32 width, u32 height)
+{
+    const TextureBlockInfo* info = TextureTranscode_Info(format);
+    u64 blocks_x = (width + info->block_width - 1) / info->block_width;
+    u64 blocks_y = (height + info->block_height - 1) / info->block_height;
+    return blocks_x * blocks_y * info->block_bytes;
+}
+
+u64 TextureTranscode_ChainBytes(TextureBlockFormat format, u32 width, u32 height,
+                                u32 level_count)
+{
+    u64 bytes = 0;
+    for (u32 i = 0; i < level_count; i++) {
+        bytes += TextureTranscode_LevelBytes(format, MAX(width >> i, 1u),
+                                             MAX(height >> i, 1u));
+    }
+    return bytes;
+}
+
+u32 TextureTranscode_MipCount(u32 width, u32 height)
+{
+    u32 size  = MAX(width, height);
+    u32 count = 1;
+    while (size > 1) {
+        size >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+TextureBlockFormat TextureTranscode_PickTarget(TextureBlockFormat format, u32 width,
+                                               u32 height, u32 compression)
+{
+    const TextureBlockInfo* info = TextureTranscode_Info(format);
+    if (format == TextureBlockFormat_None) return TextureBlockFormat_None;
+    if (format == TextureBlockFormat_RGBA8) return format;
+
+    bool whole_blocks
+      = width % info->block_width == 0 && height % info->block_height == 0;
+    if ((info->compression & compression) && whole_blocks) return format;
+    if (info->cpu_decode) return TextureBlockFormat_RGBA8;
+    return TextureBlockFormat_None;
+}
+
+// ============================================================================
+// KTX2
+// ============================================================================
+
+static const u8 _ktx2_identifier[12]
+  = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// KHR_DF_MODEL_UASTC, of the data format descriptor
+#define KTX2_DF_MODEL_UASTC 166
+
+static u32 _KTX2_U32(const u8* p)
+{
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static u64 _KTX2_U64(const u8* p)
+{
+    return (u64)_KTX2_U32(p) | ((u64)_KTX2_U32(p + 4) << 32);
+}
+
+// VkFormat values
+static const struct {
+    u32 vk_format;
+    TextureBlockFormat format;
+    bool srgb;
+} _ktx2_formats[] = {
+    { 37, TextureBlockFormat_RGBA8, false },       // R8G8B8A8_UNORM
+    { 43, TextureBlockFormat_RGBA8, true },        // R8G8B8A8_SRGB
+    { 131, TextureBlockFormat_BC1, false },        // BC1_RGB_UNORM_BLOCK
+    { 132, TextureBlockFormat_BC1, true },         // BC1_RGB_SRGB_BLOCK
+    { 133, TextureBlockFormat_BC1, false },        // BC1_RGBA_UNORM_BLOCK
+    { 134, TextureBlockFormat_BC1, true },         // BC1_RGBA_SRGB_BLOCK
+    { 137, TextureBlockFormat_BC3, false },        // BC3_UNORM_BLOCK
+    { 138, TextureBlockFormat_BC3, true },         // BC3_SRGB_BLOCK
+    { 139, TextureBlockFormat_BC4, false },        // BC4_UNORM_BLOCK
+    { 141, TextureBlockFormat_BC5, false },        // BC5_UNORM_BLOCK
+    { 145, TextureBlockFormat_BC7, false },        // BC7_UNORM_BLOCK
+    { 146, TextureBlockFormat_BC7, true },         // BC7_SRGB_BLOCK
+    { 147, TextureBlockFormat_ETC2_RGB8, false },  // ETC2_R8G8B8_UNORM_BLOCK
+    { 148, TextureBlockFormat_ETC2_RGB8, true },   // ETC2_R8G8B8_SRGB_BLOCK
+    { 151, TextureBlockFormat_ETC2_RGBA8, false }, // ETC2_R8G8B8A8_UNORM_BLOCK
+    { 152, TextureBlockFormat_ETC2_RGBA8, true },  // ETC2_R8G8B8A8_SRGB_BLOCK
+    { 157, TextureBlockFormat_ASTC_4x4, false },   // ASTC_4x4_UNORM_BLOCK
+    { 158, TextureBlockFormat_ASTC_4x4, true },    // ASTC_4x4_SRGB_BLOCK
+};
+
+static TextureBlockFormat _KTX2_Format(u32 vk_format, bool* srgb)
+{
+    for (u32 i = 0; i < ARRAY_LENGTH(_ktx2_formats); i++) {
+        if (_ktx2_formats[i].vk_format == vk_format) {
+            *srgb = _ktx2_formats[i].srgb;
+            return _ktx2_formats[i].format;
+        }
+    }
+    *srgb = false;
+    return TextureBlockFormat_None;
+}
+
+bool TextureTranscode_IsKTX2(const u8* data, u64 len)
+{
+    return len >= sizeof(_ktx2_identifier)
+           && memcmp(data, _ktx2_identifier, sizeof(_ktx2_identifier)) == 0;
+}
+
+#define KTX2_FAIL(msg)                                                                 \
+    do {                                                                               \
+        *error = msg;                                                                  \
+        return false;                                                                  \
+    } while (0)
+
+bool TextureTranscode_ParseKTX2(const u8* data, u64 len, bool header_only,
+                                KTX2Image* image, const char** error)
+{
+    *image = {};
+    if (!TextureTranscode_IsKTX2(data, len)) KTX2_FAIL("not a KTX2 file");
+    if (len < KTX2_HEADER_BYTES) KTX2_FAIL("truncated KTX2 header");
+
+    image->vk_format        = _KTX2_U32(data + 12);
+    image->width            = _KTX2_U32(data + 20);
+    image->height           = _KTX2_U32(data + 24);
+    image->depth            = _KTX2_U32(data + 28);
+    image->layer_count      = _KTX2_U32(data + 32);
+    image->face_count       = _KTX2_U32(data + 36);
+    image->level_count      = MAX(_KTX2_U32(data + 40), 1u); // 0: generate mips
+    image->supercompression = _KTX2_U32(data + 44);
+    image->format           = _KTX2_Format(image->vk_format, &image->srgb);
+
+    if (image->width == 0 || image->height == 0 || image->depth > 1)
+        KTX2_FAIL("only 2D KTX2 textures are supported");
+    if (image->layer_count > 1 || image->face_count != 1)
+        KTX2_FAIL("KTX2 arrays and cubemaps are not supported");
+    if (image->level_count > KTX2_MAX_LEVELS
+        || image->level_count > TextureTranscode_MipCount(image->width, image->height))
+        KTX2_FAIL("bad KTX2 level count");
+    if (header_only) return true;
+
+    u64 index_end = KTX2_HEADER_BYTES + (u64)image->level_count * 24;
+    if (len < index_end) KTX2_FAIL("truncated KTX2 level index");
+    for (u32 i = 0; i < image->level_count; i++) {
+        const u8* entry  = data + KTX2_HEADER_BYTES + i * 24;
+        KTX2Level* level = &image->levels[i];
+        level->offset    = _KTX2_U64(entry);
+        level->length    = _KTX2_U64(entry + 8);
+        level->width     = MAX(image->width >> i, 1u);
+        level->height    = MAX(image->height >> i, 1u);
+        if (level->offset > len || level->length > len - level->offset)
+            KTX2_FAIL("KTX2 level out of bounds");
+    }
+
+    // Basis Universal payloads have no vkFormat, the data format descriptor
+    // tells ETC1S (always BasisLZ supercompressed) from UASTC
+    u32 dfd_offset = _KTX2_U32(data + 48);
+    u32 dfd_length = _KTX2_U32(data + 52);
+    if (dfd_length >= 4 + 12) {
+        if ((u64)dfd_offset + dfd_length > len) KTX2_FAIL("KTX2 DFD out of bounds");
+        u32 color_model = data[dfd_offset + 4 + 8];
+        image->uastc    = color_model == KTX2_DF_MODEL_UASTC;
+    }
+    return true;
+}
+
+// ============================================================================
+// BC1-5
+// ============================================================================
+
+static void _Texel565(u16 c, u8* out)
+{
+    u8 r   = (c >> 11) & 31;
+    u8 g   = (c >> 5) & 63;
+    u8 b   = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+    out[3] = 255;
+}
+
+// rgba is the 4x4 block, 16 texels row by row. The alpha of 4-color blocks (BC2/3
+// color data, which always uses 4 colors) is left alone
+static void _DecodeBC1(const u8* block, u8* rgba, bool color_only)
+{
+    u16 c0 = block[0] | (block[1] << 8);
+    u16 c1 = block[2] | (block[3] << 8);
+    u8 palette[4][4];
+    _Texel565(c0, palette[0]);
+    _Texel565(c1, palette[1]);
+    if (c0 > c1 || color_only) {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        palette[2][3] = palette[3][3] = 255;
+    } else {
+        for (int c = 0; c < 3; c++)
+            palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+        palette[2][3] = 255;
+        memset(palette[3], 0, 4); // transparent black
+    }
+
+    u32 indices = _KTX2_U32(block + 4);
+    for (int i = 0; i < 16; i++) {
+        const u8* color = palette[(indices >> (2 * i)) & 3];
+        memcpy(rgba + i * 4, color, color_only ? 3 : 4);
+    }
+}
+
+// a BC4 block into channel `channel` of the 4x4 rgba block
+static void _DecodeBC4(const u8* block, u8* rgba, int channel)
+{
+    u32 r0 = block[0], r1 = block[1];
+    u8 palette[8] = { (u8)r0, (u8)r1 };
+    if (r0 > r1) {
+        for (u32 i = 1; i < 7; i++)
+            palette[i + 1] = (u8)(((7 - i) * r0 + i * r1 + 3) / 7);
+    } else {
+        for (u32 i = 1; i < 5; i++)
+            palette[i + 1] = (u8)(((5 - i) * r0 + i * r1 + 2) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    u64 indices = 0;
+    for (int i = 0; i < 6; i++) indices |= (u64)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; i++) {
+        rgba[i * 4 + channel] = palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+// ============================================================================
+// BC7
+// ============================================================================
+
+struct BC7Mode {
+    u8 subsets;
+    u8 partition_bits;
+    u8 rotation_bits;
+    u8 index_selection_bits;
+    u8 color_bits;
+    u8 alpha_bits;
+    u8 endpoint_pbits; // one per endpoint
+    u8 shared_pbits;   // one per subset
+    u8 index_bits;
+    u8 index2_bits;
+};
+
+static const BC7Mode _bc7_modes[8] = {
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 }, { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 }, { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 }, { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 }, { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+// bit i set: texel i is in subset 1
+static const u16 _bc7_partitions2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC,
+    0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE,
+    0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0,
+    0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4,
+    0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718,
+    0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// subset of each texel
+static const u8 _bc7_partitions3[64][16] = {
+    { 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+    { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+    { 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+    { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+    { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+    { 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+    { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+    { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+    { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+    { 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+    { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+    { 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+    { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+    { 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+    { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+    { 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+    { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+    { 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+    { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+    { 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+    { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+    { 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+    { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+    { 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+    { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+    { 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+    { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+    { 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+    { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+    { 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+    { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+    { 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+    { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+    { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+    { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+    { 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+    { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+    { 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+    { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+    { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+    { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+    { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+    { 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+    { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+    { 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+    { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+    { 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+    { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+    { 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+    { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+    { 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+    { 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+    { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+    { 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+    { 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+    { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+    { 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+    { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+};
+
+// texel whose index drops its top bit, for subset 1 of 2 / subsets 1 and 2 of 3.
+// Subset 0's is always texel 0
+static const u8 _bc7_anchors2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 2,  8,  2,  2,  8,  8,  15, 2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,  2,  15, 15, 6,
+    6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15,
+};
+static const u8 _bc7_anchors3a[64] = {
+    3, 3,  15, 15, 8, 3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,
+    3, 3,  8,  15, 3, 3,  6,  10, 5,  8,  8,  6,  8,  5,  15, 15,
+    8, 15, 3,  5,  6, 10, 8,  15, 15, 3,  15, 5,  15, 15, 15, 15,
+    3, 15, 5,  5,  5, 8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3,
+};
+static const u8 _bc7_anchors3b[64] = {
+    15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,
+    15, 8,  15, 3,  15, 8,  15, 8,  3,  15, 6,  10, 15, 15, 10, 8,
+    15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15, 3,  6,  6,  8,
+    15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8,
+};
+
+static const u8 _bc7_weights2[4]  = { 0, 21, 43, 64 };
+static const u8 _bc7_weights3[8]  = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const u8 _bc7_weights4[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                      34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7Bits {
+    const u8* block;
+    u32 pos;
+
+    static u32 read(BC7Bits* bits, u32 count)
+    {
+        u32 value = 0;
+        for (u32 i = 0; i < count; i++, bits->pos++) {
+            u32 bit = (bits->block[bits->pos >> 3] >> (bits->pos & 7)) & 1;
+            value |= bit << i;
+        }
+        return value;
+    }
+};
+
+static u8 _BC7_Interpolate(u8 e0, u8 e1, u32 index, u32 index_bits)
+{
+    const u8* weights = index_bits == 2 ? _bc7_weights2 :
+                        index_bits == 3 ? _bc7_weights3 :
+                                          _bc7_weights4;
+    u32 w             = weights[index];
+    return (u8)(((64 - w) * e0 + w * e1 + 32) >> 6);
+}
+
+// n-bit endpoint to 8 bits, replicating the top bits
+static u8 _BC7_Expand(u32 value, u32 bits)
+{
+    value <<= 8 - bits;
+    return (u8)(value | (value >> bits));
+}
+
+static void _DecodeBC7(const u8* block, u8* rgba)
+{
+    int mode = 0;
+    while (mode < 8 && !(block[0] & (1 << mode))) mode++;
+    if (mode == 8) { // reserved
+        memset(rgba, 0, 16 * 4);
+        return;
+    }
+    const BC7Mode* m = &_bc7_modes[mode];
+    BC7Bits bits     = { block, (u32)mode + 1 };
+
+    u32 partition       = BC7Bits::read(&bits, m->partition_bits);
+    u32 rotation        = BC7Bits::read(&bits, m->rotation_bits);
+    u32 index_selection = BC7Bits::read(&bits, m->index_selection_bits);
+
+    u32 endpoint_count = m->subsets * 2;
+    u32 endpoints[6][4];
+    for (u32 c = 0; c < 3; c++)
+        for (u32 e = 0; e < endpoint_count; e++)
+            endpoints[e][c] = BC7Bits::read(&bits, m->color_bits);
+    for (u32 e = 0; e < endpoint_count; e++)
+        endpoints[e][3] = m->alpha_bits ? BC7Bits::read(&bits, m->alpha_bits) : 255;
+
+    u32 pbits[6] = {};
+    if (m->endpoint_pbits) {
+        for (u32 e = 0; e < endpoint_count; e++) pbits[e] = BC7Bits::read(&bits, 1);
+    } else if (m->shared_pbits) {
+        for (u32 s = 0; s < m->subsets; s++)
+            pbits[2 * s] = pbits[2 * s + 1] = BC7Bits::read(&bits, 1);
+    }
+    bool has_pbits = m->endpoint_pbits || m->shared_pbits;
+
+    u8 colors[6][4];
+    for (u32 e = 0; e < endpoint_count; e++) {
+        for (u32 c = 0; c < 4; c++) {
+            u32 channel_bits = c < 3 ? m->color_bits : m->alpha_bits;
+            if (channel_bits == 0) {
+                colors[e][c] = 255;
+                continue;
+            }
+            u32 value = endpoints[e][c];
+            if (has_pbits) {
+                value = (value << 1) | pbits[e];
+                channel_bits++;
+            }
+            colors[e][c] = _BC7_Expand(value, channel_bits);
+        }
+    }
+
+    u8 subset_of[16];
+    for (u32 i = 0; i < 16; i++) {
+        if (m->subsets == 1) subset_of[i] = 0;
+        if (m->subsets == 2) subset_of[i] = (_bc7_partitions2[partition] >> i) & 1;
+        if (m->subsets == 3) subset_of[i] = _bc7_partitions3[partition][i];
+    }
+    bool anchor[16] = { true };
+    if (m->subsets == 2) anchor[_bc7_anchors2[partition]] = true;
+    if (m->subsets == 3) {
+        anchor[_bc7_anchors3a[partition]] = true;
+        anchor[_bc7_anchors3b[partition]] = true;
+    }
+
+    u32 indices[16], indices2[16] = {};
+    for (u32 i = 0; i < 16; i++)
+        indices[i] = BC7Bits::read(&bits, m->index_bits - (anchor[i] ? 1 : 0));
+    if (m->index2_bits) {
+        for (u32 i = 0; i < 16; i++)
+            indices2[i] = BC7Bits::read(&bits, m->index2_bits - (i == 0 ? 1 : 0));
+    }
+
+    for (u32 i = 0; i < 16; i++) {
+        const u8* e0 = colors[subset_of[i] * 2];
+        const u8* e1 = colors[subset_of[i] * 2 + 1];
+        u8* texel    = rgba + i * 4;
+        if (m->index2_bits == 0) {
+            for (u32 c = 0; c < 4; c++)
+                texel[c] = _BC7_Interpolate(e0[c], e1[c], indices[i], m->index_bits);
+        } else {
+            // modes 4 and 5: separate color and alpha indices, swapped by the index
+            // selection bit
+            u32 color_index = index_selection ? indices2[i] : indices[i];
+            u32 color_bits  = index_selection ? m->index2_bits : m->index_bits;
+            u32 alpha_index = index_selection ? indices[i] : indices2[i];
+            u32 alpha_bits  = index_selection ? m->index_bits : m->index2_bits;
+            for (u32 c = 0; c < 3; c++)
+                texel[c] = _BC7_Interpolate(e0[c], e1[c], color_index, color_bits);
+            texel[3] = _BC7_Interpolate(e0[3], e1[3], alpha_index, alpha_bits);
+        }
+        if (rotation) {
+            u8 swap             = texel[3];
+            texel[3]            = texel[rotation - 1];
+            texel[rotation - 1] = swap;
+        }
+    }
+}
+
+// ============================================================================
+// ETC2
+// ============================================================================
+
+static const int _etc1_modifiers[8][2] = {
+    { 2, 8 },   { 5, 17 },  { 9, 29 },  { 13, 42 },
+    { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+static const int _etc2_distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int _eac_modifiers[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },  { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },  { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },  { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },   { -3, -5, -7, -9, 2, 4, 6, 8 },
+};
+
+static u8 _Clamp255(int v)
+{
+    return (u8)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+static u64 _BigEndian64(const u8* p)
+{
+    u64 v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+// bits [hi - count + 1, hi] of v
+static u32 _Bits(u64 v, u32 hi, u32 count)
+{
+    return (u32)(v >> (hi - count + 1)) & ((1u << count) - 1);
+}
+
+// 2-bit texel index of ETC texel i (texels go column by column)
+static u32 _ETC_Index(u64 v, u32 i)
+{
+    return (_Bits(v, i + 16, 1) << 1) | _Bits(v, i, 1);
+}
+
+// color into rgb of the 4x4 block, leaving alpha alone
+static void _DecodeETC2(const u8* block, u8* rgba)
+{
+    u64 v     = _BigEndian64(block);
+    bool diff = _Bits(v, 33, 1);
+    bool flip = _Bits(v, 32, 1);
+
+    int base[2][3];
+    if (!diff) {
+        for (int c = 0; c < 3; c++) {
+            base[0][c] = _Bits(v, 63 - c * 8, 4) * 17;
+            base[1][c] = _Bits(v, 59 - c * 8, 4) * 17;
+        }
+    } else {
+        int c5[3], d[3];
+        for (int c = 0; c < 3; c++) {
+            c5[c] = _Bits(v, 63 - c * 8, 5);
+            d[c]  = (int)_Bits(v, 58 - c * 8, 3);
+            if (d[c] >= 4) d[c] -= 8;
+        }
+
+        if (c5[0] + d[0] < 0 || c5[0] + d[0] > 31) { // T mode
+            int c1[3], c2[3];
+            c1[0]    = ((_Bits(v, 60, 2) << 2) | _Bits(v, 57, 2)) * 17;
+            c1[1]    = _Bits(v, 55, 4) * 17;
+            c1[2]    = _Bits(v, 51, 4) * 17;
+            c2[0]    = _Bits(v, 47, 4) * 17;
+            c2[1]    = _Bits(v, 43, 4) * 17;
+            c2[2]    = _Bits(v, 39, 4) * 17;
+            int dist = _etc2_distances[(_Bits(v, 35, 2) << 1) | _Bits(v, 32, 1)];
+            u8 paint[4][3];
+            for (int c = 0; c < 3; c++) {
+                paint[0][c] = (u8)c1[c];
+                paint[1][c] = _Clamp255(c2[c] + dist);
+                paint[2][c] = (u8)c2[c];
+                paint[3][c] = _Clamp255(c2[c] - dist);
+            }
+            for (u32 i = 0; i < 16; i++) {
+                u32 x = i / 4, y = i % 4;
+                memcpy(rgba + (y * 4 + x) * 4, paint[_ETC_Index(v, i)], 3);
+            }
+            return;
+        }
+
+        if (c5[1] + d[1] < 0 || c5[1] + d[1] > 31) { // H mode
+            u32 r1 = _Bits(v, 62, 4);
+            u32 g1 = (_Bits(v, 58, 3) << 1) | _Bits(v, 52, 1);
+            u32 b1 = (_Bits(v, 51, 1) << 3) | _Bits(v, 49, 3);
+            u32 r2 = _Bits(v, 46, 4), g2 = _Bits(v, 42, 4), b2 = _Bits(v, 38, 4);
+            u32 index = (_Bits(v, 34, 1) << 2) | (_Bits(v, 32, 1) << 1);
+            // the order of the two colors is the last bit of the distance
+            if (((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2))
+                index |= 1;
+            int dist  = _etc2_distances[index];
+            int c1[3] = { (int)r1 * 17, (int)g1 * 17, (int)b1 * 17 };
+            int c2[3] = { (int)r2 * 17, (int)g2 * 17, (int)b2 * 17 };
+            u8 paint[4][3];
+            for (int c = 0; c < 3; c++) {
+                paint[0][c] = _Clamp255(c1[c] + dist);
+                paint[1][c] = _Clamp255(c1[c] - dist);
+                paint[2][c] = _Clamp255(c2[c] + dist);
+                paint[3][c] = _Clamp255(c2[c] - dist);
+            }
+            for (u32 i = 0; i < 16; i++) {
+                u32 x = i / 4, y = i % 4;
+                memcpy(rgba + (y * 4 + x) * 4, paint[_ETC_Index(v, i)], 3);
+            }
+            return;
+        }
+
+        if (c5[2] + d[2] < 0 || c5[2] + d[2] > 31) { // planar mode
+            int o[3], h[3], vv[3];
+            o[0]  = _Bits(v, 62, 6);
+            o[1]  = (_Bits(v, 56, 1) << 6) | _Bits(v, 54, 6);
+            o[2]  = (_Bits(v, 48, 1) << 5) | (_Bits(v, 44, 2) << 3) | _Bits(v, 41, 3);
+            h[0]  = (_Bits(v, 38, 5) << 1) | _Bits(v, 32, 1);
+            h[1]  = _Bits(v, 31, 7);
+            h[2]  = _Bits(v, 24, 6);
+            vv[0] = _Bits(v, 18, 6);
+            vv[1] = _Bits(v, 12, 7);
+            vv[2] = _Bits(v, 5, 6);
+            for (int c = 0; c < 3; c++) {
+                int bits = c == 1 ? 7 : 6;
+                o[c]     = (o[c] << (8 - bits)) | (o[c] >> (2 * bits - 8));
+                h[c]     = (h[c] << (8 - bits)) | (h[c] >> (2 * bits - 8));
+                vv[c]    = (vv[c] << (8 - bits)) | (vv[c] >> (2 * bits - 8));
+            }
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    u8* texel = rgba + (y * 4 + x) * 4;
+                    for (int c = 0; c < 3; c++) {
+                        int value = x * (h[c] - o[c]) + y * (vv[c] - o[c]) + 4 * o[c];
+                        texel[c]  = _Clamp255((value + 2) >> 2);
+                    }
+                }
+            }
+            return;
+        }
+
+        // differential
+        for (int c = 0; c < 3; c++) {
+            int c2     = c5[c] + d[c];
+            base[0][c] = (c5[c] << 3) | (c5[c] >> 2);
+            base[1][c] = (c2 << 3) | (c2 >> 2);
+        }
+    }
+
+    u32 tables[2] = { _Bits(v, 39, 3), _Bits(v, 36, 3) };
+    for (u32 i = 0; i < 16; i++) {
+        u32 x = i / 4, y = i % 4;
+        // sub-blocks are 2x4 side by side, or 4x2 stacked if flipped
+        u32 sub      = flip ? (y >= 2) : (x >= 2);
+        u32 index    = _ETC_Index(v, i);
+        int modifier = _etc1_modifiers[tables[sub]][index & 1];
+        if (index & 2) modifier = -modifier;
+        u8* texel = rgba + (y * 4 + x) * 4;
+        for (int c = 0; c < 3; c++) texel[c] = _Clamp255(base[sub][c] + modifier);
+    }
+}
+
+// EAC alpha block into the alpha of the 4x4 block
+static void _DecodeEAC(const u8* block, u8* rgba)
+{
+    u64 v          = _BigEndian64(block);
+    int base       = _Bits(v, 63, 8);
+    int multiplier = _Bits(v, 55, 4);
+    const int* mod = _eac_modifiers[_Bits(v, 51, 4)];
+    for (u32 i = 0; i < 16; i++) {
+        u32 x = i / 4, y = i % 4;
+        int alpha                 = base + mod[_Bits(v, 47 - 3 * i, 3)] * multiplier;
+        rgba[(y * 4 + x) * 4 + 3] = _Clamp255(alpha);
+    }
+}
+
+// ============================================================================
+// Decode
+// ============================================================================
+
+bool TextureTranscode_DecodeRGBA8(TextureBlockFormat format, const u8* blocks,
+                                  u32 width, u32 height, u8* rgba)
+{
+    const TextureBlockInfo* info = TextureTranscode_Info(format);
+    if (!info->cpu_decode) return false;
+
+    u32 blocks_x = (width + 3) / 4;
+    u32 blocks_y = (height + 3) / 4;
+    for (u32 by = 0; by < blocks_y; by++) {
+        for (u32 bx = 0; bx < blocks_x; bx++) {
+            const u8* block = blocks + ((u64)by * blocks_x + bx) * info->block_bytes;
+            u8 texels[16 * 4];
+            memset(texels, 0, sizeof(texels));
+            for (int i = 0; i < 16; i++) texels[i * 4 + 3] = 255;
+
+            switch (format) {
+                case TextureBlockFormat_BC1: _DecodeBC1(block, texels, false); break;
+                case TextureBlockFormat_BC3:
+                    _DecodeBC1(block + 8, texels, true);
+                    _DecodeBC4(block, texels, 3);
+                    break;
+                case TextureBlockFormat_BC4: _DecodeBC4(block, texels, 0); break;
+                case TextureBlockFormat_BC5:
+                    _DecodeBC4(block, texels, 0);
+                    _DecodeBC4(block + 8, texels, 1);
+                    break;
+                case TextureBlockFormat_BC7: _DecodeBC7(block, texels); break;
+                case TextureBlockFormat_ETC2_RGB8: _DecodeETC2(block, texels); break;
+                case TextureBlockFormat_ETC2_RGBA8:
+                    _DecodeETC2(block + 8, texels);
+                    _DecodeEAC(block, texels);
+                    break;
+                default: return false;
+            }
+
+            // blocks hanging over the edge are clipped
+            u32 w = MIN(4u, width - bx * 4);
+            u32 h = MIN(4u, height - by * 4);
+            for (u32 y = 0; y < h; y++) {
+                u8* dst = rgba + (((u64)by * 4 + y) * width + bx * 4) * 4;
+                memcpy(dst, texels + y * 16, w * 4);
+            }
+        }
+    }
+    return true;
+}
+
+bool TextureTranscode_KTX2(const u8* data, u64 len, const KTX2Image* image,
+                           u32 compression, bool mips, TextureTranscodeResult* result,
+                           const char** error)
+{
+    *result = {};
+    switch (image->supercompression) {
+        case KTX2Supercompression_None: break;
+        case KTX2Supercompression_BasisLZ:
+            KTX2_FAIL("Basis Universal ETC1S textures need the basisu transcoder, "
+                      "which this build doesn't include");
+        case KTX2Supercompression_Zstd:
+            KTX2_FAIL("zstd supercompressed KTX2 textures are not supported");
+        default: KTX2_FAIL("unsupported KTX2 supercompression");
+    }
+    if (image->uastc) {
+        KTX2_FAIL("Basis Universal UASTC textures need the basisu transcoder, which "
+                  "this build doesn't include");
+    }
+    if (image->format == TextureBlockFormat_None) KTX2_FAIL("unsupported KTX2 format");
+
+    TextureBlockFormat target = TextureTranscode_PickTarget(
+      image->format, image->width, image->height, compression);
+    if (target == TextureBlockFormat_None) {
+        KTX2_FAIL("the GPU can't sample this compressed format and it can't be "
+                  "decoded on the CPU");
+    }
+
+    u32 level_count = 1;
+    if (mips
+        && image->level_count == TextureTranscode_MipCount(image->width, image->height))
+        level_count = image->level_count;
+
+    for (u32 i = 0; i < level_count; i++) {
+        const KTX2Level* level = &image->levels[i];
+        u64 bytes
+          = TextureTranscode_LevelBytes(image->format, level->width, level->height);
+        if (level->length < bytes) KTX2_FAIL("KTX2 level smaller than its size");
+        if (level->offset > len || bytes > len - level->offset)
+            KTX2_FAIL("KTX2 level out of bounds");
+    }
+
+    const TextureBlockInfo* info = TextureTranscode_Info(target);
+    result->format               = target;
+    result->srgb                 = image->srgb;
+    result->width                = image->width;
+    result->height               = image->height;
+    result->level_count          = level_count;
+    result->size = TextureTranscode_ChainBytes(target, image->width, image->height,
+                                               level_count);
+    // freed by the caller with free()
+    result->pixels = (u8*)malloc(result->size);
+    if (!result->pixels) KTX2_FAIL("out of memory");
+
+    u64 offset = 0;
+    for (u32 i = 0; i < level_count; i++) {
+        const KTX2Level* src       = &image->levels[i];
+        TextureTranscodeLevel* dst = &result->levels[i];
+        u32 blocks_x = (src->width + info->block_width - 1) / info->block_width;
+        u32 blocks_y = (src->height + info->block_height - 1) / info->block_height;
+
+        dst->offset        = offset;
+        dst->width         = src->width;
+        dst->height        = src->height;
+        dst->rows          = blocks_y;
+        dst->bytes_per_row = blocks_x * info->block_bytes;
+
+        u8* pixels = result->pixels + offset;
+        if (target == image->format) {
+            memcpy(pixels, data + src->offset, (u64)dst->rows * dst->bytes_per_row);
+        } else {
+            TextureTranscode_DecodeRGBA8(image->format, data + src->offset, src->width,
+                                         src->height, pixels);
+        }
+        offset += (u64)dst->rows * dst->bytes_per_row;
+    }
+    ASSERT(offset == result->size);
+    return true;
+}
@@ -0,0 +1,177 @@
+/*----------------------------------------------------------------------------
+ ChuGL: Unified Audiovisual Programming in ChucK
+
+ Copyright (c) 2023 Andrew Zhu Aday and Ge Wang. All rights reserved.
+   http://chuck.stanford.edu/chugl/
+   http://chuck.cs.princeton.edu/chugl/
+
+ MIT License
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+-----------------------------------------------------------------------------*/
+#pragma once
+
+#include "core/macros.h"
+
+/*
+Compressed textures from KTX2 files
+
+Image files are decoded to RGBA8 and uploaded at 4 bytes per texel. Block
+compressed formats are 4-8x smaller, on the GPU and to upload, and are sampled
+directly by the hardware. Which families a GPU can sample varies: desktop GPUs
+have BC, mobile GPUs ETC2 and ASTC.
+
+A KTX2 file holds a texture already encoded in one such format, mip levels
+included. For each file:
+- TextureTranscode_ParseKTX2() reads the header, level index and data format
+  descriptor
+- TextureTranscode_PickTarget() picks what to upload: the file's own format if
+  the adapter supports it (and the size allows it), otherwise RGBA8
+- TextureTranscode_KTX2() produces the levels to upload, either copied as is or
+  decoded to RGBA8 on the CPU (BC1/3/4/5/7 and ETC2, not ASTC)
+
+Files supercompressed with Basis Universal (ETC1S / UASTC) or zstd need the
+basisu transcoder / zstd, which aren't built in yet (see TODO.txt), and fail to
+load with a reason saying so.
+
+Knows nothing about WebGPU, so it can be tested on the CPU.
+*/
+
+enum TextureBlockFormat : u8 {
+    TextureBlockFormat_None = 0,
+    TextureBlockFormat_RGBA8,
+    TextureBlockFormat_BC1,
+    TextureBlockFormat_BC3,
+    TextureBlockFormat_BC4,
+    TextureBlockFormat_BC5,
+    TextureBlockFormat_BC7,
+    TextureBlockFormat_ETC2_RGB8,
+    TextureBlockFormat_ETC2_RGBA8,
+    TextureBlockFormat_ASTC_4x4,
+    TextureBlockFormat_Count
+};
+
+// compressed format families the adapter can sample, bitmask
+enum TextureCompression : u32 {
+    TextureCompression_BC   = 1 << 0,
+    TextureCompression_ETC2 = 1 << 1,
+    TextureCompression_ASTC = 1 << 2,
+};
+
+struct TextureBlockInfo {
+    const char* name;
+    u8 block_width; // texels, 1 for RGBA8
+    u8 block_height;
+    u8 block_bytes;
+    u32 compression;  // TextureCompression family needed to upload as is, 0 if none
+    bool cpu_decode;  // TextureTranscode_DecodeRGBA8 supports it
+};
+
+const TextureBlockInfo* TextureTranscode_Info(TextureBlockFormat format);
+
+// bytes of a width x height level, in whole blocks
+u64 TextureTranscode_LevelBytes(TextureBlockFormat format, u32 width, u32 height);
+
+// bytes of a mip chain of level_count levels
+u64 TextureTranscode_ChainBytes(TextureBlockFormat format, u32 width, u32 height,
+                                u32 level_count);
+
+#define KTX2_MAX_LEVELS 16
+
+struct KTX2Level {
+    u64 offset; // into the file
+    u64 length;
+    u32 width;
+    u32 height;
+};
+
+enum KTX2Supercompression : u32 {
+    KTX2Supercompression_None    = 0,
+    KTX2Supercompression_BasisLZ = 1,
+    KTX2Supercompression_Zstd    = 2,
+    KTX2Supercompression_ZLIB    = 3,
+};
+
+struct KTX2Image {
+    u32 vk_format;             // VkFormat, 0 for Basis Universal payloads
+    TextureBlockFormat format; // None if unsupported
+    bool srgb;
+    bool uastc; // Basis Universal UASTC payload
+    u32 width;
+    u32 height;
+    u32 depth;
+    u32 layer_count;
+    u32 face_count;
+    u32 level_count;
+    u32 supercompression; // KTX2Supercompression
+    KTX2Level levels[KTX2_MAX_LEVELS];
+};
+
+// true if data starts with the KTX2 identifier
+bool TextureTranscode_IsKTX2(const u8* data, u64 len);
+
+// reads the header, and the level index and data format descriptor if
+// header_only is false. len may cover only the first KTX2_HEADER_BYTES bytes if
+// header_only. Returns false and a static string in *error if the file is
+// malformed or not a 2D texture
+#define KTX2_HEADER_BYTES 80
+bool TextureTranscode_ParseKTX2(const u8* data, u64 len, bool header_only,
+                                KTX2Image* image, const char** error);
+
+// what to upload a `format` texture of width x height as, given the adapter's
+// TextureCompression support: the format itself if supported, else RGBA8 if it
+// can be decoded on the CPU, else None. Block compressed textures must be a whole
+// number of blocks wide and high to be created on the GPU
+TextureBlockFormat TextureTranscode_PickTarget(TextureBlockFormat format, u32 width,
+                                               u32 height, u32 compression);
+
+// decodes a width x height level of `format` blocks to RGBA8 (width * height * 4
+// bytes). Returns false if the format can't be decoded on the CPU
+bool TextureTranscode_DecodeRGBA8(TextureBlockFormat format, const u8* blocks,
+                                  u32 width, u32 height, u8* rgba);
+
+struct TextureTranscodeLevel {
+    u64 offset; // into pixels
+    u32 width;
+    u32 height;
+    u32 rows; // of blocks
+    u32 bytes_per_row;
+};
+
+struct TextureTranscodeResult {
+    TextureBlockFormat format; // uploaded as
+    bool srgb;
+    u32 width;
+    u32 height;
+    u8* pixels; // malloc'd, every level one after the other
+    u64 size;
+    u32 level_count;
+    TextureTranscodeLevel levels[KTX2_MAX_LEVELS];
+};
+
+// produces the levels of a parsed KTX2 file to upload with the adapter's
+// TextureCompression support. If `mips`, keeps the file's mip chain when it is
+// complete (down to 1x1), otherwise only level 0. Returns false and a static
+// string in *error on failure
+bool TextureTranscode_KTX2(const u8* data, u64 len, const KTX2Image* image,
+                           u32 compression, bool mips, TextureTranscodeResult* result,
+                           const char** error);
+
+// levels of a full mip chain down to 1x1
+u32 TextureTranscode_MipCount(u32 width, u32 height);
@@ -0,0 +1,268 @@
+/*
+AudioTap: a pass-through UGen that streams its input into a Texture and/or
+StorageBuffer for visualization.
+
+Threading:
+- audio thread: tick() pushes each sample into a lock-free SPSC ring owned by
+the tap. No locks, no allocation, no command queue traffic per sample.
+- graphics thread: once per frame, R_AudioTap::upload() copies the latest
+`window` samples out of the ring, optionally FFTs them, and writes the result to
+the bound GPU targets. The command queue is only touched when the tap is
+reconfigured (window/mode/targets).
+- the graphics thread may still read the ring after the tap is garbage collected,
+so the destructor hands it over and the graphics thread frees it.
+*/
+
+#include "ulib_helper.h"
+
+#include "sg_command.h"
+#include "sg_component.h"
+
+// AudioTap extends UGen, not SG_Component, same special case as Video.
+static t_CKUINT audio_tap_component_offset_id = 0;
+// cached ring pointer so tick() doesn't need a hashmap lookup per sample
+static t_CKUINT audio_tap_ring_offset_id = 0;
+
+#define GET_AUDIO_TAP(ckobj)                                                           \
+    SG_GetAudioTap(OBJ_MEMBER_UINT(ckobj, audio_tap_component_offset_id))
+
+CK_DLL_CTOR(audio_tap_ctor);
+CK_DLL_DTOR(audio_tap_dtor);
+CK_DLL_TICK(audio_tap_tick);
+
+CK_DLL_MFUN(audio_tap_set_window);
+CK_DLL_MFUN(audio_tap_get_window);
+CK_DLL_MFUN(audio_tap_set_mode);
+CK_DLL_MFUN(audio_tap_get_mode);
+CK_DLL_MFUN(audio_tap_set_texture);
+CK_DLL_MFUN(audio_tap_get_texture);
+CK_DLL_MFUN(audio_tap_set_buffer);
+CK_DLL_MFUN(audio_tap_get_buffer);
+CK_DLL_MFUN(audio_tap_get_size);
+CK_DLL_MFUN(audio_tap_get_rms);
+
+void ulib_audiotap_query(Chuck_DL_Query* QUERY)
+{
+    BEGIN_CLASS(SG_CKNames[SG_COMPONENT_AUDIO_TAP], "UGen");
+    DOC_CLASS(
+      "Pass-through UGen that streams its input into a Texture and/or StorageBuffer "
+      "every frame, for audio visualization without manually copying samples in "
+      "ChucK. In MODE_WAVEFORM the most recent `window` samples are written. In "
+      "MODE_SPECTRUM a Hann-windowed FFT is computed on the graphics thread and "
+      "`window / 2` magnitudes are written. Texture targets must be R32Float with "
+      "width >= size(); values are written to row 0.");
+    ADD_EX("basic/audio-tap.ck");
+
+    audio_tap_component_offset_id = MVAR("int", "@component_ptr", false);
+    audio_tap_ring_offset_id      = MVAR("int", "@ring_ptr", false);
+
+    static t_CKINT MODE_WAVEFORM = SG_AudioTap_Mode_Waveform;
+    static t_CKINT MODE_SPECTRUM = SG_AudioTap_Mode_Spectrum;
+    SVAR("int", "MODE_WAVEFORM", &MODE_WAVEFORM);
+    DOC_VAR("The default mode. Equals 0. Writes the raw waveform.");
+    SVAR("int", "MODE_SPECTRUM", &MODE_SPECTRUM);
+    DOC_VAR("Equals 1. Writes FFT magnitudes, normalized so a full-scale sine is ~1.");
+
+    QUERY->add_ugen_func(QUERY, audio_tap_tick, NULL, 1, 1);
+
+    CTOR(audio_tap_ctor);
+    DTOR(audio_tap_dtor);
+
+    MFUN(audio_tap_set_window, "int", "window");
+    ARG("int", "window");
+    DOC_FUNC(
+      "Set the analysis window size in samples. Rounded up to a power of 2 and clamped "
+      "to [16, 8192]. Default 1024. Returns the actual window size.");
+
+    MFUN(audio_tap_get_window, "int", "window");
+    DOC_FUNC("Get the analysis window size in samples.");
+
+    MFUN(audio_tap_set_mode, "void", "mode");
+    ARG("int", "mode");
+    DOC_FUNC("Set the tap mode. One of AudioTap.MODE_WAVEFORM or AudioTap.MODE_SPECTRUM.");
+
+    MFUN(audio_tap_get_mode, "int", "mode");
+    DOC_FUNC("Get the tap mode.");
+
+    MFUN(audio_tap_set_texture, "void", "texture");
+    ARG("Texture", "texture");
+    DOC_FUNC(
+      "Set the texture target. Must be R32Float with width >= size() and CopyDst "
+      "usage. Pass null to stop writing to a texture.");
+
+    MFUN(audio_tap_get_texture, "Texture", "texture");
+    DOC_FUNC("Get the texture target, or null if none.");
+
+    MFUN(audio_tap_set_buffer, "void", "buffer");
+    ARG("StorageBuffer", "buffer");
+    DOC_FUNC(
+      "Set the storage buffer target. The buffer is grown to hold size() floats if "
+      "needed. Pass null to stop writing to a buffer.");
+
+    MFUN(audio_tap_get_buffer, "StorageBuffer", "buffer");
+    DOC_FUNC("Get the storage buffer target, or null if none.");
+
+    MFUN(audio_tap_get_size, "int", "size");
+    DOC_FUNC(
+      "Number of float values written to the targets each frame. Equals window() in "
+      "MODE_WAVEFORM and window() / 2 in MODE_SPECTRUM.");
+
+    MFUN(audio_tap_get_rms, "float", "rms");
+    DOC_FUNC("RMS amplitude of the most recent window of input samples.");
+
+    END_CLASS();
+}
+
+// warn if the bound texture can't hold the tap output
+static void _audio_tap_validate_texture(SG_AudioTap* tap)
+{
+    SG_Texture* tex = SG_GetTexture(tap->texture_id);
+    if (!tex) return;
+
+    int count = SG_AudioTap::valueCount(tap);
+    if (tex->desc.format != WGPUTextureFormat_R32Float) {
+        log_warn("AudioTap texture must have format Texture.FORMAT_R32FLOAT");
+        log_warn(" |- AudioTap output will not be written to this texture");
+    } else if (tex->desc.width < count) {
+        log_warn("AudioTap texture width %d is smaller than AudioTap.size() %d",
+                 tex->desc.width, count);
+        log_warn(" |- AudioTap output will not be written to this texture");
+    } else if (!(tex->desc.usage & WGPUTextureUsage_CopyDst)) {
+        log_warn("AudioTap texture must have Texture.USAGE_COPY_DST");
+        log_warn(" |- AudioTap output will not be written to this texture");
+    }
+}
+
+// grow the bound buffer to fit the tap output
+static void _audio_tap_fit_buffer(SG_AudioTap* tap)
+{
+    SG_Buffer* buff = SG_GetBuffer(tap->buffer_id);
+    if (!buff) return;
+
+    u64 size_bytes = SG_AudioTap::valueCount(tap) * sizeof(f32);
+    if (buff->desc.size < size_bytes) {
+        buff->desc.size = size_bytes;
+        CQ_PushCommand_BufferUpdate(buff);
+    }
+}
+
+CK_DLL_CTOR(audio_tap_ctor)
+{
+    SG_AudioTap* tap = SG_CreateAudioTap(SELF, audio_tap_component_offset_id);
+    OBJ_MEMBER_UINT(SELF, audio_tap_ring_offset_id) = (t_CKUINT)tap->ring;
+    CQ_PushCommand_AudioTapUpdate(tap);
+}
+
+CK_DLL_DTOR(audio_tap_dtor)
+{
+    SG_AudioTap* tap = GET_AUDIO_TAP(SELF);
+    if (tap) SG_ComponentFree(tap);
+    OBJ_MEMBER_UINT(SELF, audio_tap_component_offset_id) = 0;
+    OBJ_MEMBER_UINT(SELF, audio_tap_ring_offset_id)      = 0;
+}
+
+CK_DLL_TICK(audio_tap_tick)
+{
+    SG_AudioTapRing* ring
+      = (SG_AudioTapRing*)OBJ_MEMBER_UINT(SELF, audio_tap_ring_offset_id);
+    ring->push((f32)in);
+    *out = in;
+    return TRUE;
+}
+
+CK_DLL_MFUN(audio_tap_set_window)
+{
+    SG_AudioTap* tap = GET_AUDIO_TAP(SELF);
+    int window       = CLAMP(GET_NEXT_INT(ARGS), SG_AUDIO_TAP_MIN_WINDOW,
+                             SG_AUDIO_TAP_MAX_WINDOW);
+
+    // round up to power of 2 for the FFT
+    int pow2 = SG_AUDIO_TAP_MIN_WINDOW;
+    while (pow2 < window) pow2 <<= 1;
+
+    tap->window = pow2;
+    _audio_tap_validate_texture(tap);
+    _audio_tap_fit_buffer(tap);
+    CQ_PushCommand_AudioTapUpdate(tap);
+
+    RETURN->v_int = tap->window;
+}
+
+CK_DLL_MFUN(audio_tap_get_window)
+{
+    RETURN->v_int = GET_AUDIO_TAP(SELF)->window;
+}
+
+CK_DLL_MFUN(audio_tap_set_mode)
+{
+    SG_AudioTap* tap = GET_AUDIO_TAP(SELF);
+    t_CKINT mode     = GET_NEXT_INT(ARGS);
+    if (mode < 0 || mode >= SG_AudioTap_Mode_Count) {
+        log_warn("AudioTap.mode(%d) is not a valid mode", (int)mode);
+        log_warn(" |- expected AudioTap.MODE_WAVEFORM or AudioTap.MODE_SPECTRUM");
+        return;
+    }
+
+    tap->mode = (SG_AudioTap_Mode)mode;
+    _audio_tap_validate_texture(tap);
+    _audio_tap_fit_buffer(tap);
+    CQ_PushCommand_AudioTapUpdate(tap);
+}
+
+CK_DLL_MFUN(audio_tap_get_mode)
+{
+    RETURN->v_int = GET_AUDIO_TAP(SELF)->mode;
+}
+
+CK_DLL_MFUN(audio_tap_set_texture)
+{
+    SG_AudioTap* tap    = GET_AUDIO_TAP(SELF);
+    Chuck_Object* ckobj = GET_NEXT_OBJECT(ARGS);
+    SG_Texture* tex     = ckobj ? GET_TEXTURE(ckobj) : NULL;
+
+    SG_ID old_id = tap->texture_id;
+    SG_AddRef(tex);
+    tap->texture_id = tex ? tex->id : 0;
+    SG_DecrementRef(old_id);
+
+    _audio_tap_validate_texture(tap);
+    CQ_PushCommand_AudioTapUpdate(tap);
+}
+
+CK_DLL_MFUN(audio_tap_get_texture)
+{
+    SG_Texture* tex = SG_GetTexture(GET_AUDIO_TAP(SELF)->texture_id);
+    RETURN->v_object = tex ? tex->ckobj : NULL;
+}
+
+CK_DLL_MFUN(audio_tap_set_buffer)
+{
+    SG_AudioTap* tap    = GET_AUDIO_TAP(SELF);
+    Chuck_Object* ckobj = GET_NEXT_OBJECT(ARGS);
+    SG_Buffer* buff
+      = ckobj ? SG_GetBuffer(OBJ_MEMBER_UINT(ckobj, component_offset_id)) : NULL;
+
+    SG_ID old_id = tap->buffer_id;
+    SG_AddRef(buff);
+    tap->buffer_id = buff ? buff->id : 0;
+    SG_DecrementRef(old_id);
+
+    _audio_tap_fit_buffer(tap);
+    CQ_PushCommand_AudioTapUpdate(tap);
+}
+
+CK_DLL_MFUN(audio_tap_get_buffer)
+{
+    SG_Buffer* buff  = SG_GetBuffer(GET_AUDIO_TAP(SELF)->buffer_id);
+    RETURN->v_object = buff ? buff->ckobj : NULL;
+}
+
+CK_DLL_MFUN(audio_tap_get_size)
+{
+    RETURN->v_int = SG_AudioTap::valueCount(GET_AUDIO_TAP(SELF));
+}
+
+CK_DLL_MFUN(audio_tap_get_rms)
+{
+    RETURN->v_float = SG_AudioTap::rms(GET_AUDIO_TAP(SELF));
+}
@@ -1859,14 +1859,14 @@ CK_DLL_MFUN(ggen_set_shadowed_all_children)
     b32 shadowed        = GET_NEXT_INT(ARGS) ? 1 : 0;
     b32 add_children    = GET_NEXT_INT(ARGS) ? 1 : 0;
 
-    if (xform->type == SG_COMPONENT_MESH) {
+    if (!add_children) {
         CQ_PushCommand_MeshSetShadowed(xform, shadowed);
+        return;
     }
 
-    if (add_children) { // BFS add all children
-        u64 curr = audio_frame_arena.curr;
-        memcpy(Arena::push(&audio_frame_arena, xform->childrenIDs.curr),
-               xform->childrenIDs.base, xform->childrenIDs.curr);
+    { // BFS over xform and all children
+        u64 curr                                    = audio_frame_arena.curr;
+        *ARENA_PUSH_TYPE(&audio_frame_arena, SG_ID) = xform->id;
 
         while (curr != audio_frame_arena.curr) {
             xform = SG_GetTransform(*(SG_ID*)Arena::get(&audio_frame_arena, curr));
@@ -1874,8 +1874,12 @@ CK_DLL_MFUN(ggen_set_shadowed_all_children)
             CQ_PushCommand_MeshSetShadowed(xform, shadowed);
             curr += sizeof(SG_ID);
 
-            memcpy(Arena::push(&audio_frame_arena, xform->childrenIDs.curr),
-                   xform->childrenIDs.base, xform->childrenIDs.curr);
+            SG_ID child_id = xform->first_child_id;
+            while (child_id) {
+                *ARENA_PUSH_TYPE(&audio_frame_arena, SG_ID) = child_id;
+
+                child_id = SG_GetTransform(child_id)->next_sibling_id;
+            }
         }
     }
 }
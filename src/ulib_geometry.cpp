@@ -66,6 +66,19 @@ CK_DLL_MFUN(geo_get_vertex_count);
 CK_DLL_MFUN(geo_set_index_count);
 CK_DLL_MFUN(geo_get_index_count);
 
+CK_DLL_MFUN(geo_mark_static);
+CK_DLL_MFUN(geo_get_static);
+
+CK_DLL_MFUN(geo_add_lod);
+CK_DLL_MFUN(geo_clear_lods);
+CK_DLL_MFUN(geo_get_lod_count);
+CK_DLL_MFUN(geo_get_lod);
+CK_DLL_MFUN(geo_get_lod_screen_size);
+CK_DLL_MFUN(geo_set_lod_cull);
+CK_DLL_MFUN(geo_get_lod_cull);
+CK_DLL_MFUN(geo_simplify);
+CK_DLL_MFUN(geo_simplify_points);
+
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute);
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute_vec2);
 CK_DLL_MFUN(geo_set_pulled_vertex_attribute_vec3);
@@ -355,6 +368,73 @@ static void ulib_geometry_query(Chuck_DL_Query* QUERY)
     MFUN(geo_get_index_count, "int", "indexCount");
     DOC_FUNC("Get the number of indices to be drawn. Default is -1, which means all");
 
+    MFUN(geo_mark_static, "void", "markStatic");
+    DOC_FUNC(
+      "Stop keeping a CPU copy of this geometry's vertex attributes and indices. The "
+      "data is uploaded to the GPU and then freed, which saves host memory on "
+      "large meshes. Afterwards positions(), normals(), uvs(), indices() and "
+      "vertexAttributeData() return empty arrays. Setting new data still works, it is "
+      "uploaded and freed the same way. Cannot be undone");
+
+    MFUN(geo_get_static, "int", "isStatic");
+    DOC_FUNC("True if markStatic() was called on this geometry");
+
+    MFUN(geo_add_lod, "void", "lod");
+    ARG("Geometry", "geometry");
+    ARG("float", "screenSize");
+    DOC_FUNC(
+      "Add a lower level of detail. Meshes using this geometry are drawn with "
+      "`geometry` instead once they cover less than `screenSize` of the viewport "
+      "height (e.g. .25 for a quarter). Each mesh picks its level every frame; the "
+      "level with the smallest screenSize still above the mesh's size wins. Up to "
+      "4 levels. Levels are chosen for the camera of the first pass that draws the "
+      "scene each frame, and shadows always use the full detail geometry");
+
+    MFUN(geo_clear_lods, "void", "lodClear");
+    DOC_FUNC("Remove all levels of detail added with lod()");
+
+    MFUN(geo_get_lod_count, "int", "lodCount");
+    DOC_FUNC("Number of levels of detail added with lod(), not counting this one");
+
+    MFUN(geo_get_lod, "Geometry", "lod");
+    ARG("int", "level");
+    DOC_FUNC(
+      "Get the geometry of a level of detail, from 0 (most detailed) to lodCount() "
+      "- 1. null if out of range");
+
+    MFUN(geo_get_lod_screen_size, "float", "lodScreenSize");
+    ARG("int", "level");
+    DOC_FUNC(
+      "Get the screen size below which a level of detail is drawn, 0 if out of "
+      "range");
+
+    MFUN(geo_set_lod_cull, "void", "lodCull");
+    ARG("float", "screenSize");
+    DOC_FUNC(
+      "Meshes using this geometry that cover less than `screenSize` of the viewport "
+      "height are not drawn at all. Default 0 (never culled)");
+
+    MFUN(geo_get_lod_cull, "float", "lodCull");
+    DOC_FUNC("Get the screen size below which meshes are not drawn");
+
+    MFUN(geo_simplify, "Geometry", "simplify");
+    ARG("float", "ratio");
+    ARG("float", "maxError");
+    DOC_FUNC(
+      "Create a simplified copy of this geometry with about `ratio` of its triangles, "
+      "e.g. for use with lod(). Edges are collapsed in order of least change to the "
+      "surface, stopping early if that would move the surface by more than "
+      "`maxError` times the size of the geometry (e.g. .01). UV and normal seams and "
+      "open borders are preserved. Requires indices, and returns null on a static "
+      "geometry");
+
+    MFUN(geo_simplify_points, "Geometry", "simplifyPoints");
+    ARG("float", "ratio");
+    DOC_FUNC(
+      "Create a copy of this point cloud with about `ratio` of its vertices, spread "
+      "evenly over its volume. Indices are ignored and the copy has none. Returns "
+      "null on a static geometry");
+
     END_CLASS();
 
     // Plane -----------------------------------------------------
@@ -886,13 +966,11 @@ CK_DLL_MFUN(geo_set_vertex_attribute)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     // set attribute locally
-    Arena* vertex_attrib_data = SG_Geometry::setAttribute(
-      geo, location, num_components, API, (Chuck_Object*)ck_arr, 1, false);
+    SG_Geometry::setAttribute(geo, location, num_components, API, (Chuck_Object*)ck_arr,
+                              1, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components,
-                                              vertex_attrib_data->base,
-                                              vertex_attrib_data->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components);
 }
 
 CK_DLL_MFUN(geo_set_vertex_attribute_vec2)
@@ -904,13 +982,11 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec2)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     // set attribute locally
-    Arena* vertex_attrib_data = SG_Geometry::setAttribute(
-      geo, location, num_components, API, (Chuck_Object*)ck_arr, num_components, false);
+    SG_Geometry::setAttribute(geo, location, num_components, API, (Chuck_Object*)ck_arr,
+                              num_components, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components,
-                                              vertex_attrib_data->base,
-                                              vertex_attrib_data->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components);
 }
 
 CK_DLL_MFUN(geo_set_vertex_attribute_vec3)
@@ -922,13 +998,11 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec3)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     // set attribute locally
-    Arena* vertex_attrib_data = SG_Geometry::setAttribute(
-      geo, location, num_components, API, (Chuck_Object*)ck_arr, num_components, false);
+    SG_Geometry::setAttribute(geo, location, num_components, API, (Chuck_Object*)ck_arr,
+                              num_components, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components,
-                                              vertex_attrib_data->base,
-                                              vertex_attrib_data->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components);
 }
 
 CK_DLL_MFUN(geo_set_vertex_attribute_vec4)
@@ -940,13 +1014,11 @@ CK_DLL_MFUN(geo_set_vertex_attribute_vec4)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     // set attribute locally
-    Arena* vertex_attrib_data = SG_Geometry::setAttribute(
-      geo, location, num_components, API, (Chuck_Object*)ck_arr, num_components, false);
+    SG_Geometry::setAttribute(geo, location, num_components, API, (Chuck_Object*)ck_arr,
+                              num_components, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components,
-                                              vertex_attrib_data->base,
-                                              vertex_attrib_data->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components);
 }
 
 CK_DLL_MFUN(geo_set_vertex_attribute_int)
@@ -958,64 +1030,58 @@ CK_DLL_MFUN(geo_set_vertex_attribute_int)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     // set attribute locally
-    Arena* vertex_attrib_data = SG_Geometry::setAttribute(
-      geo, location, num_components, API, (Chuck_Object*)ck_arr, 1, true);
+    SG_Geometry::setAttribute(geo, location, num_components, API, (Chuck_Object*)ck_arr,
+                              1, true);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components,
-                                              vertex_attrib_data->base,
-                                              vertex_attrib_data->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(geo, location, num_components);
 }
 
 CK_DLL_MFUN(geo_set_positions)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
-    Arena* attrib_arena
-      = SG_Geometry::setAttribute(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, API,
-                                  (Chuck_Object*)ck_arr, 3, false);
+    SG_Geometry::setAttribute(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, API,
+                              (Chuck_Object*)ck_arr, 3, false);
 
     // push attribute change to command queue
     CQ_PushCommand_GeometrySetVertexAttribute(
-      geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, attrib_arena->base,
-      attrib_arena->curr);
+      geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3);
 }
 
 CK_DLL_MFUN(geo_set_normals)
 {
     Chuck_ArrayVec3* ck_arr = GET_NEXT_VEC3_ARRAY(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
-    Arena* attrib_arena
-      = SG_Geometry::setAttribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3, API,
-                                  (Chuck_Object*)ck_arr, 3, false);
+    SG_Geometry::setAttribute(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3, API,
+                              (Chuck_Object*)ck_arr, 3, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo,
-                                              SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3,
-                                              attrib_arena->base, attrib_arena->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(
+      geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3);
 }
 
 CK_DLL_MFUN(geo_set_uvs)
 {
     Chuck_ArrayVec2* ck_arr = GET_NEXT_VEC2_ARRAY(ARGS);
-    SG_Geometry* geo    = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
-    Arena* attrib_arena = SG_Geometry::setAttribute(
-      geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2, API, (Chuck_Object*)ck_arr, 2, false);
+    SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    SG_Geometry::setAttribute(geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2, API,
+                              (Chuck_Object*)ck_arr, 2, false);
 
     // push attribute change to command queue
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2,
-                                              attrib_arena->base, attrib_arena->curr);
+    CQ_PushCommand_GeometrySetVertexAttribute(
+      geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2);
 }
 
 CK_DLL_MFUN(geo_get_positions)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    glm::vec3* data
-      = (glm::vec3*)geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION]
-          .base;
-    int data_count = ARENA_LENGTH(
-      &geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION], glm::vec3);
+    glm::vec3* data = (glm::vec3*)SG_Geometry::getAttributeData(
+      geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION);
+    int data_count
+      = SG_Geometry::attributeBytes(geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION)
+        / sizeof(glm::vec3);
 
     RETURN->v_object = (Chuck_Object*)chugin_createCkFloat3Array(data, data_count);
 }
@@ -1024,11 +1090,11 @@ CK_DLL_MFUN(geo_get_normals)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    glm::vec3* data
-      = (glm::vec3*)geo->vertex_attribute_data[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION]
-          .base;
-    int data_count = ARENA_LENGTH(
-      &geo->vertex_attribute_data[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION], glm::vec3);
+    glm::vec3* data = (glm::vec3*)SG_Geometry::getAttributeData(
+      geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION);
+    int data_count
+      = SG_Geometry::attributeBytes(geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION)
+        / sizeof(glm::vec3);
 
     RETURN->v_object = (Chuck_Object*)chugin_createCkFloat3Array(data, data_count);
 }
@@ -1037,10 +1103,11 @@ CK_DLL_MFUN(geo_get_uvs)
 {
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    glm::vec2* data
-      = (glm::vec2*)geo->vertex_attribute_data[SG_GEOMETRY_UV_ATTRIBUTE_LOCATION].base;
-    int data_count = ARENA_LENGTH(
-      &geo->vertex_attribute_data[SG_GEOMETRY_UV_ATTRIBUTE_LOCATION], glm::vec2);
+    glm::vec2* data = (glm::vec2*)SG_Geometry::getAttributeData(
+      geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION);
+    int data_count
+      = SG_Geometry::attributeBytes(geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION)
+        / sizeof(glm::vec2);
 
     RETURN->v_object = (Chuck_Object*)chugin_createCkFloat2Array(data, data_count);
 }
@@ -1061,8 +1128,8 @@ CK_DLL_MFUN(geo_get_vertex_attribute_data)
     t_CKINT location = GET_NEXT_INT(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    f32* data      = (f32*)geo->vertex_attribute_data[location].base;
-    int data_count = ARENA_LENGTH(&geo->vertex_attribute_data[location], f32);
+    f32* data      = SG_Geometry::getAttributeData(geo, location);
+    int data_count = SG_Geometry::attributeBytes(geo, location) / sizeof(f32);
 
     RETURN->v_object = (Chuck_Object*)chugin_createCkFloatArray(data, data_count);
 }
@@ -1072,8 +1139,8 @@ CK_DLL_MFUN(geo_get_vertex_attribute_data_int)
     t_CKINT location = GET_NEXT_INT(ARGS);
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    i32* data      = (i32*)geo->vertex_attribute_data[location].base;
-    int data_count = ARENA_LENGTH(&geo->vertex_attribute_data[location], i32);
+    i32* data      = (i32*)SG_Geometry::getAttributeData(geo, location);
+    int data_count = SG_Geometry::attributeBytes(geo, location) / sizeof(i32);
 
     RETURN->v_object = (Chuck_Object*)chugin_createCkIntArray(data, data_count);
 }
@@ -1085,9 +1152,9 @@ CK_DLL_MFUN(geo_set_indices)
 
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
-    u32* indices = SG_Geometry::setIndices(geo, API, ck_arr, ck_arr_len);
+    SG_Geometry::setIndices(geo, API, ck_arr, ck_arr_len);
 
-    CQ_PushCommand_GeometrySetIndices(geo, indices, ck_arr_len);
+    CQ_PushCommand_GeometrySetIndices(geo);
 }
 
 CK_DLL_MFUN(geo_get_indices)
@@ -1095,7 +1162,7 @@ CK_DLL_MFUN(geo_get_indices)
     SG_Geometry* geo = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id));
 
     u32* indices    = SG_Geometry::getIndices(geo);
-    int index_count = SG_Geometry::indexCount(geo);
+    int index_count = indices ? SG_Geometry::indexCount(geo) : 0; // NULL if static
 
     Chuck_ArrayInt* ck_arr = (Chuck_ArrayInt*)chugin_createCkObj("int[]", false, SHRED);
     for (int i = 0; i < index_count; i++)
@@ -1285,32 +1352,135 @@ CK_DLL_MFUN(geo_get_index_count)
       = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id))->index_count;
 }
 
+CK_DLL_MFUN(geo_mark_static)
+{
+    SG_Geometry::markStatic(SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id)));
+}
+
+CK_DLL_MFUN(geo_get_static)
+{
+    RETURN->v_int
+      = SG_GetGeometry(OBJ_MEMBER_UINT(SELF, component_offset_id))->is_static ? 1 : 0;
+}
+
+CK_DLL_MFUN(geo_add_lod)
+{
+    SG_Geometry* geo    = GET_GEOMETRY(SELF);
+    Chuck_Object* ckobj = GET_NEXT_OBJECT(ARGS);
+    t_CKFLOAT size      = GET_NEXT_FLOAT(ARGS);
+
+    SG_Geometry* lod = ckobj ? GET_GEOMETRY(ckobj) : NULL;
+    if (!SG_Geometry::addLOD(geo, lod, size)) {
+        log_warn("Geometry.lod(...) ignored: geometry is null, itself, or already has "
+                 "%d levels of detail",
+                 CHUGL_GEOMETRY_MAX_LODS);
+        return;
+    }
+    CQ_PushCommand_GeometrySetLODs(geo);
+}
+
+CK_DLL_MFUN(geo_clear_lods)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    SG_Geometry::clearLODs(geo);
+    CQ_PushCommand_GeometrySetLODs(geo);
+}
+
+CK_DLL_MFUN(geo_get_lod_count)
+{
+    RETURN->v_int = GET_GEOMETRY(SELF)->lod_count;
+}
+
+CK_DLL_MFUN(geo_get_lod)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    t_CKINT level    = GET_NEXT_INT(ARGS);
+
+    SG_Geometry* lod = (level >= 0 && level < geo->lod_count) ?
+                         SG_GetGeometry(geo->lod_geo_ids[level]) :
+                         NULL;
+    RETURN->v_object = lod ? lod->ckobj : NULL;
+}
+
+CK_DLL_MFUN(geo_get_lod_screen_size)
+{
+    SG_Geometry* geo = GET_GEOMETRY(SELF);
+    t_CKINT level    = GET_NEXT_INT(ARGS);
+    RETURN->v_float
+      = (level >= 0 && level < geo->lod_count) ? geo->lod_screen_sizes[level] : 0.0;
+}
+
+CK_DLL_MFUN(geo_set_lod_cull)
+{
+    SG_Geometry* geo   = GET_GEOMETRY(SELF);
+    t_CKFLOAT size     = GET_NEXT_FLOAT(ARGS);
+    geo->lod_cull_size = MAX(size, 0.0);
+    CQ_PushCommand_GeometrySetLODs(geo);
+}
+
+CK_DLL_MFUN(geo_get_lod_cull)
+{
+    RETURN->v_float = GET_GEOMETRY(SELF)->lod_cull_size;
+}
+
+static SG_Geometry* ulib_geometry_simplify(SG_Geometry* src, f32 ratio, f32 max_error,
+                                           bool points, Chuck_VM_Shred* shred)
+{
+    bool has_data
+      = SG_Geometry::getAttributeData(src, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION)
+        && (points || SG_Geometry::getIndices(src));
+    if (!has_data) {
+        log_warn("Geometry.%s(...) needs %s kept on the CPU (not markStatic()), "
+                 "returning null",
+                 points ? "simplifyPoints" : "simplify",
+                 points ? "positions" : "positions and indices");
+        return NULL;
+    }
+
+    // stays empty if there is too little data, e.g. a single point
+    SG_Geometry* dst = ulib_geometry_create(SG_GEOMETRY, shred);
+    SG_Geometry::simplify(dst, src, ratio, max_error, points);
+
+    for (int i = 0; i < SG_GEOMETRY_MAX_VERTEX_ATTRIBUTES; i++) {
+        if (dst->vertex_attribute_num_components[i] == 0) continue;
+        CQ_PushCommand_GeometrySetVertexAttribute(
+          dst, i, dst->vertex_attribute_num_components[i]);
+    }
+    if (dst->indices.curr > 0) CQ_PushCommand_GeometrySetIndices(dst);
+    return dst;
+}
+
+CK_DLL_MFUN(geo_simplify)
+{
+    t_CKFLOAT ratio     = GET_NEXT_FLOAT(ARGS);
+    t_CKFLOAT max_error = GET_NEXT_FLOAT(ARGS);
+
+    SG_Geometry* dst
+      = ulib_geometry_simplify(GET_GEOMETRY(SELF), ratio, max_error, false, SHRED);
+    RETURN->v_object = dst ? dst->ckobj : NULL;
+}
+
+CK_DLL_MFUN(geo_simplify_points)
+{
+    t_CKFLOAT ratio = GET_NEXT_FLOAT(ARGS);
+
+    SG_Geometry* dst
+      = ulib_geometry_simplify(GET_GEOMETRY(SELF), ratio, 0.0f, true, SHRED);
+    RETURN->v_object = dst ? dst->ckobj : NULL;
+}
+
 // Plane Geometry -----------------------------------------------------
 
 void CQ_UpdateAllVertexAttributes(SG_Geometry* geo)
 { // push attribute changes to command queue
     ASSERT(geo);
-    Arena* positions_arena
-      = &geo->vertex_attribute_data[SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION];
     CQ_PushCommand_GeometrySetVertexAttribute(
-      geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3, positions_arena->base,
-      positions_arena->curr);
-
-    Arena* normals_arena
-      = &geo->vertex_attribute_data[SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION];
-    CQ_PushCommand_GeometrySetVertexAttribute(geo,
-                                              SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3,
-                                              normals_arena->base, normals_arena->curr);
-
-    Arena* uvs_arena = &geo->vertex_attribute_data[SG_GEOMETRY_UV_ATTRIBUTE_LOCATION];
-    CQ_PushCommand_GeometrySetVertexAttribute(geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2,
-                                              uvs_arena->base, uvs_arena->curr);
-
-    Arena* indices_arena = &geo->indices;
-    if (indices_arena->curr > 0) {
-        CQ_PushCommand_GeometrySetIndices(geo, (u32*)indices_arena->base,
-                                          ARENA_LENGTH(indices_arena, u32));
-    }
+      geo, SG_GEOMETRY_POSITION_ATTRIBUTE_LOCATION, 3);
+    CQ_PushCommand_GeometrySetVertexAttribute(
+      geo, SG_GEOMETRY_NORMAL_ATTRIBUTE_LOCATION, 3);
+    CQ_PushCommand_GeometrySetVertexAttribute(
+      geo, SG_GEOMETRY_UV_ATTRIBUTE_LOCATION, 2);
+    if (geo->indices.curr > 0) CQ_PushCommand_GeometrySetIndices(geo);
 }
 
 CK_DLL_CTOR(plane_geo_ctor)
@@ -133,10 +133,13 @@ struct GG_Config {
     SG_ID default_scene_pass_id;
     SG_ID default_output_pass_id;
     SG_ID default_bloom_pass_id;
+    SG_ID fallback_material_id;
 
     // options
-    bool auto_update_scenegraph = true;
-    int fixed_timestep_fps      = 60;
+    bool auto_update_scenegraph   = true;
+    int fixed_timestep_fps        = 60;
+    bool pipelined                = false;
+    t_CKINT texture_upload_budget = CHUGL_TEXTURE_UPLOAD_BUDGET_BYTES;
 };
 GG_Config gg_config = {};
 
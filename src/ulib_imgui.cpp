@@ -245,12 +245,11 @@ static void ui_scenegraph_draw_impl(SG_Transform* node)
         }
 
         // children
-        int numChildren = ARENA_LENGTH(&node->childrenIDs, SG_ID);
         cimgui::ImGui_SeparatorText("Children: ");
-        for (int i = 0; i < numChildren; i++) {
-            SG_Transform* child
-              = SG_GetTransform(*ARENA_GET_TYPE(&node->childrenIDs, SG_ID, i));
+        SG_Transform* child = SG_GetTransform(node->first_child_id);
+        while (child) {
             ui_scenegraph_draw_impl(child);
+            child = SG_GetTransform(child->next_sibling_id);
         }
 
         // pop tree
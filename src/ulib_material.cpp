@@ -74,6 +74,7 @@ CK_DLL_MFUN(material_set_transparent);
 CK_DLL_MFUN(material_get_transparent);
 CK_DLL_MFUN(material_set_wireframe);
 CK_DLL_MFUN(material_get_wireframe);
+CK_DLL_MFUN(material_prewarm);
 
 // blend modes
 CK_DLL_MFUN(material_set_blendmode);
@@ -737,6 +738,15 @@ void ulib_material_query(Chuck_DL_Query* QUERY)
         MFUN(material_get_wireframe, "int", "wireframe");
         DOC_FUNC("Get whether this material will be rendered as a wireframe.");
 
+        MFUN(material_prewarm, "void", "prewarm");
+        DOC_FUNC(
+          "Compile this material's render pipelines ahead of time, against the "
+          "ScenePasses of the next frame. Pipelines are compiled in the background, "
+          "and meshes whose pipelines are still compiling are skipped (or drawn with "
+          "GG.fallbackMaterial()). Prewarming materials before adding their meshes to "
+          "the scene avoids pop-in. Call again after changing the shader, topology, "
+          "cull mode, blending or transparency of the material");
+
         // blend =============================
 
         MFUN(material_get_blend_factor_src, "int", "blendSrc");
@@ -1621,6 +1631,11 @@ CK_DLL_MFUN(material_get_wireframe)
     RETURN->v_int = GET_MATERIAL(SELF)->pso.wireframe;
 }
 
+CK_DLL_MFUN(material_prewarm)
+{
+    CQ_PushCommand_MaterialPrewarm(GET_MATERIAL(SELF));
+}
+
 // ===========================================
 // Material blend
 // ===========================================
@@ -3109,6 +3124,8 @@ void chugl_initDefaultMaterials()
         flat_shader_desc.fragment_string     = flat_shader_string;
         flat_shader_desc.vertex_layout       = standard_vertex_layout;
         flat_shader_desc.vertex_layout_count = ARRAY_LENGTH(standard_vertex_layout);
+
+        flat_shader_desc.includes.static_vertices = true;
         g_material_builtin_shaders.flat_shader_id
           = chugl_createShader(&flat_shader_desc, "FlatMaterial");
     }
@@ -3154,12 +3171,14 @@ void chugl_initDefaultMaterials()
     }
 
     { // pbr material
-        CHUGL_ShaderDesc pbr_shader_desc    = {};
-        pbr_shader_desc.vertex_string       = pbr_shader_string;
-        pbr_shader_desc.fragment_string     = pbr_shader_string;
-        pbr_shader_desc.vertex_layout       = standard_vertex_layout;
-        pbr_shader_desc.vertex_layout_count = ARRAY_LENGTH(standard_vertex_layout);
-        pbr_shader_desc.includes.lit        = true;
+        CHUGL_ShaderDesc pbr_shader_desc          = {};
+        pbr_shader_desc.vertex_string             = pbr_shader_string;
+        pbr_shader_desc.fragment_string           = pbr_shader_string;
+        pbr_shader_desc.vertex_layout             = standard_vertex_layout;
+        pbr_shader_desc.vertex_layout_count       = ARRAY_LENGTH(standard_vertex_layout);
+        pbr_shader_desc.includes.lit              = true;
+        pbr_shader_desc.includes.clustered_lights = true;
+        pbr_shader_desc.includes.static_vertices  = true;
         g_material_builtin_shaders.pbr_shader_id
           = chugl_createShader(&pbr_shader_desc, "PBR");
     }
@@ -3170,6 +3189,8 @@ void chugl_initDefaultMaterials()
         uv_shader_desc.fragment_string     = uv_shader_string;
         uv_shader_desc.vertex_layout       = standard_vertex_layout;
         uv_shader_desc.vertex_layout_count = ARRAY_LENGTH(standard_vertex_layout);
+
+        uv_shader_desc.includes.static_vertices = true;
         g_material_builtin_shaders.uv_shader_id
           = chugl_createShader(&uv_shader_desc, "UV");
     }
@@ -3180,6 +3201,8 @@ void chugl_initDefaultMaterials()
         normal_shader_desc.fragment_string     = normal_shader_string;
         normal_shader_desc.vertex_layout       = standard_vertex_layout;
         normal_shader_desc.vertex_layout_count = ARRAY_LENGTH(standard_vertex_layout);
+
+        normal_shader_desc.includes.static_vertices = true;
         g_material_builtin_shaders.normal_shader_id
           = chugl_createShader(&normal_shader_desc, "Normal");
     }
@@ -3191,19 +3214,22 @@ void chugl_initDefaultMaterials()
         wireframe_shader_desc.vertex_layout    = standard_vertex_layout;
         wireframe_shader_desc.vertex_layout_count
           = ARRAY_LENGTH(standard_vertex_layout);
+        wireframe_shader_desc.includes.static_vertices = true;
         g_material_builtin_shaders.wireframe_shader_id
           = chugl_createShader(&wireframe_shader_desc, "WireFrame");
     }
 
     { // phong material
-        CHUGL_ShaderDesc phong_shader_desc      = {};
-        phong_shader_desc.vertex_string         = phong_shader_string;
-        phong_shader_desc.fragment_string       = phong_shader_string;
-        phong_shader_desc.vertex_layout         = standard_vertex_layout;
-        phong_shader_desc.vertex_layout_count   = ARRAY_LENGTH(standard_vertex_layout);
-        phong_shader_desc.includes.lit          = true;
-        phong_shader_desc.includes.uses_env_map = true;
-        phong_shader_desc.includes.shadows      = true;
+        CHUGL_ShaderDesc phong_shader_desc          = {};
+        phong_shader_desc.vertex_string             = phong_shader_string;
+        phong_shader_desc.fragment_string           = phong_shader_string;
+        phong_shader_desc.vertex_layout             = standard_vertex_layout;
+        phong_shader_desc.vertex_layout_count       = ARRAY_LENGTH(standard_vertex_layout);
+        phong_shader_desc.includes.lit              = true;
+        phong_shader_desc.includes.uses_env_map     = true;
+        phong_shader_desc.includes.shadows          = true;
+        phong_shader_desc.includes.clustered_lights = true;
+        phong_shader_desc.includes.static_vertices  = true;
         g_material_builtin_shaders.phong_shader_id
           = chugl_createShader(&phong_shader_desc, "Phong");
     }
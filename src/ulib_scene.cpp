@@ -54,6 +54,9 @@ CK_DLL_MFUN(gscene_get_environment_map);
 CK_DLL_MFUN(gscene_set_skybox_material);
 CK_DLL_MFUN(gscene_get_skybox_material);
 
+CK_DLL_MFUN(gscene_set_gpu_culling);
+CK_DLL_MFUN(gscene_get_gpu_culling);
+
 SG_Scene* ulib_scene_create(Chuck_Object* ckobj, bool skybox, bool orthographic)
 {
     CK_DL_API API = g_chuglAPI;
@@ -172,6 +175,19 @@ static void ulib_gscene_query(Chuck_DL_Query* QUERY)
     MFUN(gscene_get_skybox_material, SG_CKNames[SG_COMPONENT_MATERIAL], "skybox");
     DOC_FUNC("Get the skybox material of the scene");
 
+    MFUN(gscene_set_gpu_culling, "void", "gpuCulling");
+    ARG("int", "enable");
+    DOC_FUNC(
+      "Cull instanced meshes against the camera frustum on the GPU. Each mesh "
+      "(geometry + material pair) with at least 64 instances, an opaque non-wireframe "
+      "material and a geometry without LODs is tested by a compute pass that runs "
+      "before every ScenePass of this scene, and drawn with an indirect draw of only "
+      "its visible instances. CPU time per frame then no longer depends on how many "
+      "instances are in view. Default false");
+
+    MFUN(gscene_get_gpu_culling, "int", "gpuCulling");
+    DOC_FUNC("Whether instanced meshes are culled on the GPU");
+
     // end class -----------------------------------------------------
     QUERY->end_class(QUERY);
 }
@@ -329,3 +345,16 @@ CK_DLL_MFUN(gscene_get_skybox_material)
     SG_Material* mat = SG_GetMaterial(scene->desc.skybox_material_id);
     RETURN->v_object = mat ? mat->ckobj : NULL;
 }
+
+CK_DLL_MFUN(gscene_set_gpu_culling)
+{
+    SG_Scene* scene         = SG_GetScene(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    scene->desc.gpu_culling = GET_NEXT_INT(ARGS) ? 1 : 0;
+    CQ_PushCommand_SceneUpdate(scene);
+}
+
+CK_DLL_MFUN(gscene_get_gpu_culling)
+{
+    SG_Scene* scene = SG_GetScene(OBJ_MEMBER_UINT(SELF, component_offset_id));
+    RETURN->v_int   = scene->desc.gpu_culling;
+}
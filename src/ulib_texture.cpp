@@ -29,6 +29,7 @@
 
 #include "sg_command.h"
 #include "sg_component.h"
+#include "texture_transcode.h"
 
 #include "ulib_helper.h"
 
@@ -131,6 +132,10 @@ CK_DLL_SFUN(texture_copy_texture_to_texture_with_desc);
 // saving to drive
 CK_DLL_MFUN(texture_save);
 
+// streamed loading
+CK_DLL_MFUN(texture_loaded);
+CK_DLL_MFUN(texture_load_event);
+
 static void ulib_texture_query(Chuck_DL_Query* QUERY)
 {
     { // Sampler (only passed by value)
@@ -422,6 +427,16 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
         static t_CKINT texture_format_r32float    = WGPUTextureFormat_R32Float;
         static t_CKINT texture_format_r32uint     = WGPUTextureFormat_R32Uint;
         static t_CKINT texture_format_r8unorm     = WGPUTextureFormat_R8Unorm;
+
+        // set by loading a compressed KTX2 file
+        static t_CKINT texture_format_bc1        = WGPUTextureFormat_BC1RGBAUnorm;
+        static t_CKINT texture_format_bc3        = WGPUTextureFormat_BC3RGBAUnorm;
+        static t_CKINT texture_format_bc4        = WGPUTextureFormat_BC4RUnorm;
+        static t_CKINT texture_format_bc5        = WGPUTextureFormat_BC5RGUnorm;
+        static t_CKINT texture_format_bc7        = WGPUTextureFormat_BC7RGBAUnorm;
+        static t_CKINT texture_format_etc2_rgb8  = WGPUTextureFormat_ETC2RGB8Unorm;
+        static t_CKINT texture_format_etc2_rgba8 = WGPUTextureFormat_ETC2RGBA8Unorm;
+        static t_CKINT texture_format_astc_4x4   = WGPUTextureFormat_ASTC4x4Unorm;
         SVAR("int", "Format_RGBA8Unorm", &texture_format_rgba8unorm);
         DOC_VAR("(hidden)");
         SVAR("int", "Format_RGBA16Float", &texture_format_rgba16float);
@@ -439,12 +454,35 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
         SVAR("int", "FORMAT_R32FLOAT", &texture_format_r32float);
         SVAR("int", "FORMAT_R32UINT", &texture_format_r32uint);
         SVAR("int", "FORMAT_R8UNORM", &texture_format_r8unorm);
+        SVAR("int", "FORMAT_BC1", &texture_format_bc1);
+        DOC_VAR("BC1 compressed, 4x4 blocks of 8 bytes. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_BC3", &texture_format_bc3);
+        DOC_VAR("BC3 compressed, 4x4 blocks of 16 bytes. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_BC4", &texture_format_bc4);
+        DOC_VAR("BC4 compressed, single channel. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_BC5", &texture_format_bc5);
+        DOC_VAR("BC5 compressed, two channels. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_BC7", &texture_format_bc7);
+        DOC_VAR("BC7 compressed, 4x4 blocks of 16 bytes. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_ETC2_RGB8", &texture_format_etc2_rgb8);
+        DOC_VAR("ETC2 compressed, no alpha. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_ETC2_RGBA8", &texture_format_etc2_rgba8);
+        DOC_VAR("ETC2 compressed with EAC alpha. Set by loading a KTX2 file");
+        SVAR("int", "FORMAT_ASTC_4X4", &texture_format_astc_4x4);
+        DOC_VAR("ASTC 4x4 compressed. Set by loading a KTX2 file");
 
         // sfun ------------------------------------------------------------------
 
         SFUN(texture_load_2d_file, SG_CKNames[SG_COMPONENT_TEXTURE], "load");
         ARG("string", "filepath");
-        DOC_FUNC("Load a 2D texture from a file");
+        DOC_FUNC(
+          "Load a 2D texture from a file. The image is decoded in the background and "
+          "uploaded over the next few frames, until then a white placeholder is drawn "
+          "in its place. See Texture.loaded() and Texture.loadEvent(). KTX2 files "
+          "holding BC, ETC2 or ASTC data stay compressed on the GPU if it supports "
+          "the format, and are decoded to RGBA8 otherwise; their own mip chain is "
+          "used if complete. Basis Universal and zstd compressed KTX2 files are not "
+          "supported");
 
         SFUN(texture_load_2d_raw, SG_CKNames[SG_COMPONENT_TEXTURE], "load");
         ARG("int[]", "binary_data");
@@ -583,6 +621,20 @@ static void ulib_texture_query(Chuck_DL_Query* QUERY)
           "returned by this method, which will be broadcast when the texture data is "
           "finished saving.");
 
+        MFUN(texture_loaded, "int", "loaded");
+        DOC_FUNC(
+          "Returns 0 while the image this texture was loaded from is still being "
+          "decoded or uploaded, 1 otherwise. Until then a placeholder is drawn in its "
+          "place. Loading a large image or cubemap can take several frames, see "
+          "GG.textureUploadBudget()");
+
+        MFUN(texture_load_event, "Event", "loadEvent");
+        DOC_FUNC(
+          "Event broadcast when this texture finishes loading from an image, e.g. "
+          "`while (!tex.loaded()) tex.loadEvent() => now;`. Check Texture.loaded() "
+          "first, the event is not broadcast again for a texture that already "
+          "finished loading");
+
         END_CLASS();
     }
 
@@ -924,6 +976,13 @@ static void ulib_texture_write(SG_Texture* tex, Chuck_ArrayFloat* ck_arr,
 {
     CK_DL_API API = g_chuglAPI;
 
+    if (G_isCompressedFormat(tex->desc.format)) {
+        log_warn("TextureWriteCompressed: Texture %s holds compressed data and can't "
+                 "be written to",
+                 tex->name);
+        return;
+    }
+
     int num_texels   = desc->width * desc->height * desc->depth;
     int expected_len = num_texels * SG_Texture_numComponentsPerTexel(tex->desc.format);
 
@@ -1012,6 +1071,23 @@ CK_DLL_MFUN(texture_write_external_ptr)
     CQ_PushCommand_TextureWriteExternalPtr(tex, &desc, external_ptr);
 }
 
+// KTX2 files are transcoded on the graphics thread, only their size is needed here
+static bool ulib_texture_ktx2Size(const u8* header, u64 header_len, const char* source,
+                                  int* width, int* height)
+{
+    KTX2Image image;
+    const char* error = NULL;
+    if (!TextureTranscode_ParseKTX2(header, header_len, true, &image, &error)) {
+        log_warn("could not load texture %s", source);
+        log_warn(" |- Reason: %s", error);
+        log_warn(" |- Defaulting to magenta texture");
+        return false;
+    }
+    *width  = image.width;
+    *height = image.height;
+    return true;
+}
+
 SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_desc,
                               Chuck_VM_Shred* shred)
 {
@@ -1022,7 +1098,21 @@ SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_des
 
     defer(stbi_image_free(pixel_data_OWNED));
 
-    if (load_desc->read_to_ck_array) {
+    u8 header[KTX2_HEADER_BYTES] = {};
+    u64 header_len               = 0;
+    if (FILE* file = fopen(filepath, "rb")) {
+        header_len = fread(header, 1, sizeof(header), file);
+        fclose(file);
+    }
+
+    if (TextureTranscode_IsKTX2(header, header_len)) {
+        if (!ulib_texture_ktx2Size(header, header_len, filepath, &width, &height))
+            return SG_GetTexture(g_builtin_textures.magenta_pixel_id);
+        if (load_desc->read_to_ck_array) {
+            log_warn("TextureLoadDesc.read is not supported for KTX2 file '%s'",
+                     filepath);
+        }
+    } else if (load_desc->read_to_ck_array) {
         pixel_data_OWNED = stbi_load(filepath,        //
                                      &width,          //
                                      &height,         //
@@ -1060,6 +1150,7 @@ SG_Texture* ulib_texture_load(const char* filepath, SG_TextureLoadDesc* load_des
       = SG_CreateTexture(&desc, NULL, shred, false, File_basename(filepath));
 
     CQ_PushCommand_TextureFromFile(tex, filepath, load_desc);
+    tex->loading = true;
 
     if (pixel_data_OWNED) {
         int size_bytes = width * height * desired_comps;
@@ -1073,7 +1164,12 @@ SG_Texture* ulib_texture_load(unsigned char* buffer, int buffer_len,
                               SG_TextureLoadDesc* load_desc, Chuck_VM_Shred* shred)
 {
     int width, height, num_components;
-    if (!stbi_info_from_memory(buffer, buffer_len, &width, &height, &num_components)) {
+    if (TextureTranscode_IsKTX2(buffer, buffer_len)) {
+        if (!ulib_texture_ktx2Size(buffer, buffer_len, "from raw data", &width,
+                                   &height))
+            return SG_GetTexture(g_builtin_textures.magenta_pixel_id);
+    } else if (!stbi_info_from_memory(buffer, buffer_len, &width, &height,
+                                      &num_components)) {
         log_warn("could not load texture file from raw data");
         log_warn(" |- Reason: %s", stbi_failure_reason());
         log_warn(" |- Defaulting to magenta texture");
@@ -1095,6 +1191,7 @@ SG_Texture* ulib_texture_load(unsigned char* buffer, int buffer_len,
     SG_Texture* tex = SG_CreateTexture(&desc, NULL, shred, false, "Raw Data Texture");
 
     CQ_PushCommand_TextureFromRawData(tex, buffer, buffer_len, load_desc);
+    tex->loading = true;
 
     return tex;
 }
@@ -1139,6 +1236,20 @@ CK_DLL_MFUN(texture_save)
     RETURN->v_object = (Chuck_Object*)e;
 }
 
+CK_DLL_MFUN(texture_loaded)
+{
+    RETURN->v_int = GET_TEXTURE(SELF)->loading ? 0 : 1;
+}
+
+CK_DLL_MFUN(texture_load_event)
+{
+    SG_Texture* tex = GET_TEXTURE(SELF);
+    // lives as long as the texture, like texture_read_event
+    if (!tex->load_event)
+        tex->load_event = (Chuck_Event*)chugin_createCkObj("Event", true, SHRED);
+    RETURN->v_object = (Chuck_Object*)tex->load_event;
+}
+
 CK_DLL_SFUN(texture_load_2d_file)
 {
     SG_TextureLoadDesc load_desc = {};
@@ -1224,6 +1335,7 @@ SG_Texture* ulib_texture_load_cubemap(const char* right_face, const char* left_f
 
     CQ_PushCommand_CubemapTextureFromFile(tex, load_desc, right_face, left_face,
                                           top_face, bottom_face, back_face, front_face);
+    tex->loading = true;
 
     return tex;
 }
@@ -166,6 +166,32 @@ CK_DLL_SFUN(gamepad_get_button_down);
 CK_DLL_SFUN(gamepad_get_button_released);
 CK_DLL_SFUN(gamepad_get_axis);
 
+// input event stream, see input_stream.h
+CK_DLL_CTOR(input_msg_ctor);
+CK_DLL_MFUN(input_msg_type_name);
+static t_CKUINT input_msg_type_offset    = 0;
+static t_CKUINT input_msg_code_offset    = 0;
+static t_CKUINT input_msg_mods_offset    = 0;
+static t_CKUINT input_msg_device_offset  = 0;
+static t_CKUINT input_msg_pos_offset     = 0;
+static t_CKUINT input_msg_scroll_offset  = 0;
+static t_CKUINT input_msg_when_offset    = 0;
+static t_CKUINT input_msg_offset_offset  = 0;
+static t_CKUINT input_msg_latency_offset = 0;
+static t_CKUINT input_msg_seq_offset     = 0;
+static t_CKUINT input_msg_missed_offset  = 0;
+
+CK_DLL_MFUN(input_stream_event_recv);
+CK_DLL_SFUN(gg_input);
+CK_DLL_SFUN(gg_set_input_latency);
+CK_DLL_SFUN(gg_get_input_latency);
+CK_DLL_SFUN(gg_input_dropped);
+
+// audio thread side of the stream: every reader (InputMsg) walks this history
+static InputHistory input_history = {};
+static InputClock input_clock     = {};
+static t_CKDUR input_latency      = 0; // GG.inputLatency()
+
 void ulib_window_query(Chuck_DL_Query* QUERY)
 {
     // BEGIN_CLASS("MonitorInfo", "Object");
@@ -1141,6 +1167,91 @@ void ulib_window_query(Chuck_DL_Query* QUERY)
 
         END_CLASS();
     } // Gamepad
+
+    { // InputMsg
+        BEGIN_CLASS("InputMsg", "Object");
+        DOC_CLASS(
+          "A single keyboard, mouse or gamepad event, received from GG.input(). "
+          "Unlike GWindow and Gamepad state, events are never merged: two clicks "
+          "in one frame are two messages. Each InputMsg remembers the last event it "
+          "received, so any number of shreds can read every event with their own "
+          "InputMsg.");
+        CTOR(input_msg_ctor);
+
+        static t_CKINT input_key_down = InputEvent_KeyDown;
+        SVAR("int", "KEY_DOWN", &input_key_down);
+        static t_CKINT input_key_up = InputEvent_KeyUp;
+        SVAR("int", "KEY_UP", &input_key_up);
+        static t_CKINT input_key_repeat = InputEvent_KeyRepeat;
+        SVAR("int", "KEY_REPEAT", &input_key_repeat);
+        static t_CKINT input_mouse_down = InputEvent_MouseDown;
+        SVAR("int", "MOUSE_DOWN", &input_mouse_down);
+        static t_CKINT input_mouse_up = InputEvent_MouseUp;
+        SVAR("int", "MOUSE_UP", &input_mouse_up);
+        static t_CKINT input_mouse_move = InputEvent_MouseMove;
+        SVAR("int", "MOUSE_MOVE", &input_mouse_move);
+        static t_CKINT input_scroll = InputEvent_Scroll;
+        SVAR("int", "SCROLL", &input_scroll);
+        static t_CKINT input_gamepad_down = InputEvent_GamepadDown;
+        SVAR("int", "GAMEPAD_DOWN", &input_gamepad_down);
+        static t_CKINT input_gamepad_up = InputEvent_GamepadUp;
+        SVAR("int", "GAMEPAD_UP", &input_gamepad_up);
+
+        input_msg_type_offset = MVAR("int", "type", false);
+        DOC_VAR("Kind of event, one of the InputMsg constants, e.g. InputMsg.KEY_DOWN");
+        input_msg_code_offset = MVAR("int", "code", false);
+        DOC_VAR(
+          "The key (e.g. GWindow.Key_Space), mouse button (0 left, 1 right, 2 "
+          "middle) or gamepad button (e.g. Gamepad.BUTTON_A)");
+        input_msg_mods_offset = MVAR("int", "mods", false);
+        DOC_VAR("Bitmask of the modifier keys held, for key and mouse button events");
+        input_msg_device_offset = MVAR("int", "device", false);
+        DOC_VAR("Gamepad id of a gamepad event");
+        input_msg_pos_offset = MVAR("vec2", "pos", false);
+        DOC_VAR("Mouse position in screen coordinates, for mouse events");
+        input_msg_scroll_offset = MVAR("vec2", "scroll", false);
+        DOC_VAR("Scroll offset of a scroll event");
+        input_msg_when_offset = MVAR("time", "when", false);
+        DOC_VAR(
+          "ChucK time the event maps to: the last sample ChucK had computed when "
+          "the event happened, plus GG.inputLatency()");
+        input_msg_offset_offset = MVAR("dur", "offset", false);
+        DOC_VAR(
+          "How long after `now` the event's `when` is, at the time it was "
+          "received, or 0 if it already passed. `msg.offset => now;` before "
+          "making sound keeps the time from input to sound constant instead of "
+          "depending on when the shred woke up (see GG.inputLatency())");
+        input_msg_latency_offset = MVAR("dur", "latency", false);
+        DOC_VAR(
+          "Wall-clock time between the event and its recv(), measured for "
+          "diagnostics");
+        input_msg_seq_offset = MVAR("int", "seq", false);
+        DOC_VAR("Sequence number of the event. Every event gets the next number");
+        input_msg_missed_offset = MVAR("int", "missed", false);
+        DOC_VAR(
+          "Events this InputMsg skipped because it fell too far behind, in total");
+
+        MFUN(input_msg_type_name, "string", "typeName");
+        DOC_FUNC("Name of the event type, e.g. \"key_down\"");
+
+        END_CLASS();
+    } // InputMsg
+
+    { // InputStreamEvent
+        BEGIN_CLASS("InputStreamEvent", "Event");
+        DOC_CLASS(
+          "Broadcast as soon as ChuGL receives input, independent of "
+          "GG.nextFrame(). Don't instantiate directly, use GG.input() instead.");
+        ADD_EX("basic/input-stream.ck");
+
+        MFUN(input_stream_event_recv, "int", "recv");
+        ARG("InputMsg", "msg");
+        DOC_FUNC(
+          "Fills `msg` with the next event it hasn't received. Returns false if "
+          "there is none. Call in a loop after waking on GG.input()");
+
+        END_CLASS();
+    } // InputStreamEvent
 }
 
 CK_DLL_SFUN(gwindow_monitor_info)
@@ -1481,7 +1592,7 @@ CK_DLL_SFUN(gwindow_get_kb_released)
 static void ulib_window_get_kb_all(Chuck_ArrayInt* ck_arr)
 {
     ASSERT(g_chuglAPI->object->array_int_size(ck_arr) == 0);
-    int keys_count = ARRAY_LENGTH(CHUGL_Kb.keys);
+    int keys_count = GLFW_KEY_LAST + 1;
     u64 arena_curr = audio_frame_arena.curr;
     bool* keys     = ARENA_PUSH_COUNT(&audio_frame_arena, bool, keys_count);
     u64 size_bytes = audio_frame_arena.curr - arena_curr;
@@ -1511,7 +1622,7 @@ CK_DLL_SFUN(gwindow_get_kb_all_with_arr)
 static void ulib_window_get_kb_pressed_all(Chuck_ArrayInt* ck_arr)
 {
     ASSERT(g_chuglAPI->object->array_int_size(ck_arr) == 0);
-    int keys_count = ARRAY_LENGTH(CHUGL_Kb.keys);
+    int keys_count = GLFW_KEY_LAST + 1;
 
     u64 arena_curr    = audio_frame_arena.curr;
     CHUGL_KbKey* keys = ARENA_PUSH_COUNT(&audio_frame_arena, CHUGL_KbKey, keys_count);
@@ -1543,7 +1654,7 @@ static void ulib_window_get_kb_released_all(Chuck_ArrayInt* ck_arr)
 {
     ASSERT(g_chuglAPI->object->array_int_size(ck_arr) == 0);
 
-    int keys_count = ARRAY_LENGTH(CHUGL_Kb.keys);
+    int keys_count = GLFW_KEY_LAST + 1;
 
     u64 arena_curr    = audio_frame_arena.curr;
     CHUGL_KbKey* keys = ARENA_PUSH_COUNT(&audio_frame_arena, CHUGL_KbKey, keys_count);
@@ -1712,3 +1823,98 @@ CK_DLL_SFUN(gamepad_get_axis)
 
     RETURN->v_float = CHUGL_Gamepads[gp_id].axes[axis_id];
 }
+
+// ============================================================================
+// Input Event Stream
+// ============================================================================
+
+// takes in everything the render thread pushed, and tells the clock which sample
+// chuck is computing now
+static void ulib_window_input_update(CK_DL_API API, Chuck_VM* VM)
+{
+    InputClock_Observe(&input_clock, API->vm->now(VM), API->vm->srate(VM),
+                       InputStream_Now());
+    CHUGL_Input_Drain(&input_history);
+}
+
+CK_DLL_CTOR(input_msg_ctor)
+{
+    // receives events from now on
+    if (CHUGL_Input_Listening()) ulib_window_input_update(API, VM);
+    OBJ_MEMBER_INT(SELF, input_msg_seq_offset) = input_history.count;
+}
+
+CK_DLL_MFUN(input_msg_type_name)
+{
+    RETURN->v_string = chugin_createCkString(
+      InputStream_TypeName((InputEventType)OBJ_MEMBER_INT(SELF, input_msg_type_offset)),
+      false);
+}
+
+CK_DLL_MFUN(input_stream_event_recv)
+{
+    RETURN->v_int     = false;
+    Chuck_Object* msg = GET_NEXT_OBJECT(ARGS);
+    if (!msg) return;
+
+    ulib_window_input_update(API, VM);
+
+    u64 cursor = OBJ_MEMBER_INT(msg, input_msg_seq_offset);
+    u64 missed = 0;
+    InputEvent event;
+    if (!InputHistory_Next(&input_history, &cursor, &event, &missed)) return;
+
+    bool is_mouse = event.type == InputEvent_MouseDown
+                    || event.type == InputEvent_MouseUp
+                    || event.type == InputEvent_MouseMove;
+    bool is_scroll = event.type == InputEvent_Scroll;
+
+    t_CKTIME now  = API->vm->now(VM);
+    t_CKFLOAT sr  = API->vm->srate(VM);
+    t_CKTIME when = InputClock_SampleAt(&input_clock, event.time_ns, sr, now)
+                    + input_latency;
+
+    OBJ_MEMBER_INT(msg, input_msg_type_offset)   = event.type;
+    OBJ_MEMBER_INT(msg, input_msg_code_offset)   = event.code;
+    OBJ_MEMBER_INT(msg, input_msg_mods_offset)   = event.mods;
+    OBJ_MEMBER_INT(msg, input_msg_device_offset) = event.device;
+    OBJ_MEMBER_VEC2(msg, input_msg_pos_offset)
+      = is_mouse ? t_CKVEC2{ event.x, event.y } : t_CKVEC2{ 0, 0 };
+    OBJ_MEMBER_VEC2(msg, input_msg_scroll_offset)
+      = is_scroll ? t_CKVEC2{ event.x, event.y } : t_CKVEC2{ 0, 0 };
+    OBJ_MEMBER_TIME(msg, input_msg_when_offset)   = when;
+    OBJ_MEMBER_DUR(msg, input_msg_offset_offset)  = MAX(when - now, 0.0);
+    OBJ_MEMBER_DUR(msg, input_msg_latency_offset)
+      = (InputStream_Now() - event.time_ns) * sr / 1e9;
+    OBJ_MEMBER_INT(msg, input_msg_seq_offset) = cursor;
+    OBJ_MEMBER_INT(msg, input_msg_missed_offset) += missed;
+
+    RETURN->v_int = true;
+}
+
+CK_DLL_SFUN(gg_input)
+{
+    static Chuck_Event* input_event = NULL;
+    if (!input_event) {
+        input_event = (Chuck_Event*)chugin_createCkObj("InputStreamEvent", true);
+        // the clock starts from here, events from now on
+        ulib_window_input_update(API, VM);
+        CHUGL_Input_Listen(input_event);
+    }
+    RETURN->v_object = (Chuck_Object*)input_event;
+}
+
+CK_DLL_SFUN(gg_set_input_latency)
+{
+    input_latency = MAX(GET_NEXT_DUR(ARGS), 0.0);
+}
+
+CK_DLL_SFUN(gg_get_input_latency)
+{
+    RETURN->v_dur = input_latency;
+}
+
+CK_DLL_SFUN(gg_input_dropped)
+{
+    RETURN->v_int = CHUGL_Input_Dropped();
+}